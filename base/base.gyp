@@ -389,6 +389,7 @@
         'callback_unittest.nc',
         'cancelable_callback_unittest.cc',
         'command_line_unittest.cc',
+        'compact_value_unittest.cc',
         'containers/adapters_unittest.cc',
         'containers/hash_tables_unittest.cc',
         'containers/linked_list_unittest.cc',
@@ -439,6 +440,7 @@
         'ios/weak_nsobject_unittest.mm',
         'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_sax_parser_unittest.cc',
         'json/json_value_converter_unittest.cc',
         'json/json_value_serializer_unittest.cc',
         'json/json_writer_unittest.cc',
@@ -785,7 +787,12 @@
         '../testing/gtest.gyp:gtest',
       ],
       'sources': [
+        'compact_value_perftest.cc',
+        'json/json_sax_parser_perftest.cc',
         'message_loop/message_pump_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'metrics/persistent_histogram_allocator_perftest.cc',
+        'task_scheduler/scheduler_thread_pool_impl_perftest.cc',
         'test/run_all_unittests.cc',
         'threading/thread_perftest.cc',
         '../testing/perf/perf_test.cc'
@@ -859,6 +866,8 @@
         'test/gtest_xml_unittest_result_printer.h',
         'test/gtest_xml_util.cc',
         'test/gtest_xml_util.h',
+        'test/heap_in_use.cc',
+        'test/heap_in_use.h',
         'test/histogram_tester.cc',
         'test/histogram_tester.h',
         'test/icu_test_util.cc',
@@ -1091,6 +1100,17 @@
             'base',
           ],
         },
+        {
+          # GN: //base:trace_binary_to_json
+          'target_name': 'trace_binary_to_json',
+          'type': 'executable',
+          'sources': [
+            'trace_event/trace_binary_to_json.cc',
+          ],
+          'dependencies': [
+            'base',
+          ],
+        },
         {
           'target_name': 'build_utf8_validator_tables',
           'type': 'executable',
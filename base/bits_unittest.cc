@@ -61,5 +61,14 @@ TEST(BitsTest, Align) {
   EXPECT_EQ(kSizeTMax / 2 + 1, Align(1, kSizeTMax / 2 + 1));
 }
 
+TEST(BitsTest, CountTrailingZeroBits32) {
+  EXPECT_EQ(0, CountTrailingZeroBits32(1));
+  EXPECT_EQ(0, CountTrailingZeroBits32(0xffffffff));
+  EXPECT_EQ(1, CountTrailingZeroBits32(2));
+  EXPECT_EQ(4, CountTrailingZeroBits32(0x30));
+  EXPECT_EQ(15, CountTrailingZeroBits32(0x8000));
+  EXPECT_EQ(31, CountTrailingZeroBits32(0x80000000));
+}
+
 }  // namespace bits
 }  // namespace base
@@ -0,0 +1,436 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/compact_value.h"
+
+#include <algorithm>
+#include <new>
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_util.h"
+
+namespace base {
+
+namespace {
+
+bool KeyLess(const std::pair<std::string, CompactValue>& entry,
+             StringPiece key) {
+  return StringPiece(entry.first) < key;
+}
+
+}  // namespace
+
+CompactValue::CompactValue() : type_(Value::TYPE_NULL) {}
+
+CompactValue::CompactValue(Value::Type type) : type_(type) {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return;
+    case Value::TYPE_BOOLEAN:
+      bool_value_ = false;
+      return;
+    case Value::TYPE_INTEGER:
+      int_value_ = 0;
+      return;
+    case Value::TYPE_DOUBLE:
+      double_value_ = 0.0;
+      return;
+    case Value::TYPE_STRING:
+      new (&string_value_) std::string();
+      return;
+    case Value::TYPE_BINARY:
+      new (&binary_value_) BinaryStorage();
+      return;
+    case Value::TYPE_LIST:
+      new (&list_) ListStorage();
+      return;
+    case Value::TYPE_DICTIONARY:
+      new (&dict_) DictStorage();
+      return;
+  }
+}
+
+CompactValue::CompactValue(bool in_bool)
+    : type_(Value::TYPE_BOOLEAN), bool_value_(in_bool) {}
+
+CompactValue::CompactValue(int in_int)
+    : type_(Value::TYPE_INTEGER), int_value_(in_int) {}
+
+CompactValue::CompactValue(double in_double)
+    : type_(Value::TYPE_DOUBLE), double_value_(in_double) {}
+
+CompactValue::CompactValue(const char* in_string)
+    : CompactValue(StringPiece(in_string)) {}
+
+CompactValue::CompactValue(StringPiece in_string)
+    : type_(Value::TYPE_STRING), string_value_(in_string.as_string()) {
+  DCHECK(IsStringUTF8(string_value_));
+}
+
+CompactValue::CompactValue(std::string&& in_string)
+    : type_(Value::TYPE_STRING), string_value_(std::move(in_string)) {
+  DCHECK(IsStringUTF8(string_value_));
+}
+
+CompactValue::CompactValue(BinaryStorage in_binary)
+    : type_(Value::TYPE_BINARY), binary_value_(std::move(in_binary)) {}
+
+CompactValue::CompactValue(ListStorage in_list)
+    : type_(Value::TYPE_LIST), list_(std::move(in_list)) {}
+
+CompactValue::CompactValue(DictStorage in_dict)
+    : type_(Value::TYPE_DICTIONARY), dict_(std::move(in_dict)) {
+  // Sort stably, so that the last value of each key can be kept.
+  std::stable_sort(dict_.begin(), dict_.end(),
+                   [](const DictStorage::value_type& a,
+                      const DictStorage::value_type& b) {
+                     return a.first < b.first;
+                   });
+
+  // Move the last entry of each run of equal keys to the front of the run,
+  // then drop the rest.
+  DictStorage::iterator out = dict_.begin();
+  for (DictStorage::iterator it = dict_.begin(); it != dict_.end(); ++it) {
+    DictStorage::iterator next = it + 1;
+    if (next != dict_.end() && next->first == it->first)
+      continue;
+    if (out != it)
+      *out = std::move(*it);
+    ++out;
+  }
+  dict_.erase(out, dict_.end());
+}
+
+CompactValue::CompactValue(CompactValue&& that) {
+  InternalMoveFrom(std::move(that));
+}
+
+CompactValue& CompactValue::operator=(CompactValue&& that) {
+  if (this != &that) {
+    InternalCleanup();
+    InternalMoveFrom(std::move(that));
+  }
+  return *this;
+}
+
+CompactValue::~CompactValue() {
+  InternalCleanup();
+}
+
+// static
+CompactValue CompactValue::FromValue(const Value& value) {
+  switch (value.GetType()) {
+    case Value::TYPE_NULL:
+      return CompactValue();
+    case Value::TYPE_BOOLEAN: {
+      bool in_bool = false;
+      value.GetAsBoolean(&in_bool);
+      return CompactValue(in_bool);
+    }
+    case Value::TYPE_INTEGER: {
+      int in_int = 0;
+      value.GetAsInteger(&in_int);
+      return CompactValue(in_int);
+    }
+    case Value::TYPE_DOUBLE: {
+      double in_double = 0.0;
+      value.GetAsDouble(&in_double);
+      return CompactValue(in_double);
+    }
+    case Value::TYPE_STRING: {
+      std::string in_string;
+      value.GetAsString(&in_string);
+      return CompactValue(std::move(in_string));
+    }
+    case Value::TYPE_BINARY: {
+      const BinaryValue* binary = nullptr;
+      value.GetAsBinary(&binary);
+      return CompactValue(BinaryStorage(
+          binary->GetBuffer(), binary->GetBuffer() + binary->GetSize()));
+    }
+    case Value::TYPE_LIST: {
+      const ListValue* list = nullptr;
+      value.GetAsList(&list);
+      ListStorage storage;
+      storage.reserve(list->GetSize());
+      for (const Value* item : *list)
+        storage.push_back(FromValue(*item));
+      return CompactValue(std::move(storage));
+    }
+    case Value::TYPE_DICTIONARY: {
+      const DictionaryValue* dict = nullptr;
+      value.GetAsDictionary(&dict);
+      // DictionaryValue iterates in key order, so the storage comes out
+      // sorted already.
+      DictStorage storage;
+      storage.reserve(dict->size());
+      for (DictionaryValue::Iterator it(*dict); !it.IsAtEnd(); it.Advance())
+        storage.emplace_back(it.key(), FromValue(it.value()));
+      return CompactValue(std::move(storage));
+    }
+  }
+  NOTREACHED();
+  return CompactValue();
+}
+
+std::unique_ptr<Value> CompactValue::ToValue() const {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return WrapUnique(new FundamentalValue(bool_value_));
+    case Value::TYPE_INTEGER:
+      return WrapUnique(new FundamentalValue(int_value_));
+    case Value::TYPE_DOUBLE:
+      return WrapUnique(new FundamentalValue(double_value_));
+    case Value::TYPE_STRING:
+      return WrapUnique(new StringValue(string_value_));
+    case Value::TYPE_BINARY:
+      return WrapUnique(BinaryValue::CreateWithCopiedBuffer(
+          binary_value_.data(), binary_value_.size()));
+    case Value::TYPE_LIST: {
+      std::unique_ptr<ListValue> list(new ListValue);
+      for (const CompactValue& item : list_)
+        list->Append(item.ToValue());
+      return std::move(list);
+    }
+    case Value::TYPE_DICTIONARY: {
+      std::unique_ptr<DictionaryValue> dict(new DictionaryValue);
+      for (const auto& entry : dict_)
+        dict->SetWithoutPathExpansion(entry.first, entry.second.ToValue());
+      return std::move(dict);
+    }
+  }
+  NOTREACHED();
+  return nullptr;
+}
+
+CompactValue CompactValue::Clone() const {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return CompactValue();
+    case Value::TYPE_BOOLEAN:
+      return CompactValue(bool_value_);
+    case Value::TYPE_INTEGER:
+      return CompactValue(int_value_);
+    case Value::TYPE_DOUBLE:
+      return CompactValue(double_value_);
+    case Value::TYPE_STRING:
+      return CompactValue(StringPiece(string_value_));
+    case Value::TYPE_BINARY:
+      return CompactValue(binary_value_);
+    case Value::TYPE_LIST: {
+      ListStorage storage;
+      storage.reserve(list_.size());
+      for (const CompactValue& item : list_)
+        storage.push_back(item.Clone());
+      return CompactValue(std::move(storage));
+    }
+    case Value::TYPE_DICTIONARY: {
+      DictStorage storage;
+      storage.reserve(dict_.size());
+      for (const auto& entry : dict_)
+        storage.emplace_back(entry.first, entry.second.Clone());
+      return CompactValue(std::move(storage));
+    }
+  }
+  NOTREACHED();
+  return CompactValue();
+}
+
+bool CompactValue::GetAsBoolean(bool* out_value) const {
+  if (out_value && IsType(Value::TYPE_BOOLEAN))
+    *out_value = bool_value_;
+  return IsType(Value::TYPE_BOOLEAN);
+}
+
+bool CompactValue::GetAsInteger(int* out_value) const {
+  if (out_value && IsType(Value::TYPE_INTEGER))
+    *out_value = int_value_;
+  return IsType(Value::TYPE_INTEGER);
+}
+
+bool CompactValue::GetAsDouble(double* out_value) const {
+  if (out_value && IsType(Value::TYPE_DOUBLE))
+    *out_value = double_value_;
+  else if (out_value && IsType(Value::TYPE_INTEGER))
+    *out_value = int_value_;
+  return IsType(Value::TYPE_DOUBLE) || IsType(Value::TYPE_INTEGER);
+}
+
+bool CompactValue::GetAsString(std::string* out_value) const {
+  if (out_value && IsType(Value::TYPE_STRING))
+    *out_value = string_value_;
+  return IsType(Value::TYPE_STRING);
+}
+
+bool CompactValue::GetAsString(StringPiece* out_value) const {
+  if (out_value && IsType(Value::TYPE_STRING))
+    *out_value = string_value_;
+  return IsType(Value::TYPE_STRING);
+}
+
+const std::string& CompactValue::GetString() const {
+  CHECK(IsType(Value::TYPE_STRING));
+  return string_value_;
+}
+
+const CompactValue::BinaryStorage& CompactValue::GetBinary() const {
+  CHECK(IsType(Value::TYPE_BINARY));
+  return binary_value_;
+}
+
+const CompactValue::ListStorage& CompactValue::GetList() const {
+  CHECK(IsType(Value::TYPE_LIST));
+  return list_;
+}
+
+CompactValue::ListStorage& CompactValue::GetList() {
+  CHECK(IsType(Value::TYPE_LIST));
+  return list_;
+}
+
+const CompactValue::DictStorage& CompactValue::GetDict() const {
+  CHECK(IsType(Value::TYPE_DICTIONARY));
+  return dict_;
+}
+
+const CompactValue* CompactValue::FindKey(StringPiece key) const {
+  CHECK(IsType(Value::TYPE_DICTIONARY));
+  DictStorage::const_iterator it =
+      std::lower_bound(dict_.begin(), dict_.end(), key, &KeyLess);
+  if (it == dict_.end() || it->first != key)
+    return nullptr;
+  return &it->second;
+}
+
+CompactValue* CompactValue::FindKey(StringPiece key) {
+  return const_cast<CompactValue*>(
+      static_cast<const CompactValue&>(*this).FindKey(key));
+}
+
+const CompactValue* CompactValue::FindPath(StringPiece path) const {
+  const CompactValue* current = this;
+  for (size_t delimiter_position = path.find('.');
+       delimiter_position != StringPiece::npos;
+       delimiter_position = path.find('.')) {
+    current = current->FindKey(path.substr(0, delimiter_position));
+    if (!current || !current->IsType(Value::TYPE_DICTIONARY))
+      return nullptr;
+    path = path.substr(delimiter_position + 1);
+  }
+  return current->FindKey(path);
+}
+
+CompactValue* CompactValue::SetKey(StringPiece key, CompactValue value) {
+  CHECK(IsType(Value::TYPE_DICTIONARY));
+  DCHECK(IsStringUTF8(key));
+  DictStorage::iterator it =
+      std::lower_bound(dict_.begin(), dict_.end(), key, &KeyLess);
+  if (it != dict_.end() && it->first == key)
+    it->second = std::move(value);
+  else
+    it = dict_.emplace(it, key.as_string(), std::move(value));
+  return &it->second;
+}
+
+bool CompactValue::RemoveKey(StringPiece key) {
+  CHECK(IsType(Value::TYPE_DICTIONARY));
+  DictStorage::iterator it =
+      std::lower_bound(dict_.begin(), dict_.end(), key, &KeyLess);
+  if (it == dict_.end() || it->first != key)
+    return false;
+  dict_.erase(it);
+  return true;
+}
+
+bool CompactValue::Equals(const CompactValue& other) const {
+  if (other.type_ != type_)
+    return false;
+
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return true;
+    case Value::TYPE_BOOLEAN:
+      return bool_value_ == other.bool_value_;
+    case Value::TYPE_INTEGER:
+      return int_value_ == other.int_value_;
+    case Value::TYPE_DOUBLE:
+      return double_value_ == other.double_value_;
+    case Value::TYPE_STRING:
+      return string_value_ == other.string_value_;
+    case Value::TYPE_BINARY:
+      return binary_value_ == other.binary_value_;
+    case Value::TYPE_LIST:
+      return list_.size() == other.list_.size() &&
+             std::equal(list_.begin(), list_.end(), other.list_.begin(),
+                        [](const CompactValue& a, const CompactValue& b) {
+                          return a.Equals(b);
+                        });
+    case Value::TYPE_DICTIONARY:
+      return dict_.size() == other.dict_.size() &&
+             std::equal(dict_.begin(), dict_.end(), other.dict_.begin(),
+                        [](const DictStorage::value_type& a,
+                           const DictStorage::value_type& b) {
+                          return a.first == b.first &&
+                                 a.second.Equals(b.second);
+                        });
+  }
+  NOTREACHED();
+  return false;
+}
+
+void CompactValue::InternalMoveFrom(CompactValue&& that) {
+  type_ = that.type_;
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return;
+    case Value::TYPE_BOOLEAN:
+      bool_value_ = that.bool_value_;
+      return;
+    case Value::TYPE_INTEGER:
+      int_value_ = that.int_value_;
+      return;
+    case Value::TYPE_DOUBLE:
+      double_value_ = that.double_value_;
+      return;
+    case Value::TYPE_STRING:
+      new (&string_value_) std::string(std::move(that.string_value_));
+      return;
+    case Value::TYPE_BINARY:
+      new (&binary_value_) BinaryStorage(std::move(that.binary_value_));
+      return;
+    case Value::TYPE_LIST:
+      new (&list_) ListStorage(std::move(that.list_));
+      return;
+    case Value::TYPE_DICTIONARY:
+      new (&dict_) DictStorage(std::move(that.dict_));
+      return;
+  }
+}
+
+void CompactValue::InternalCleanup() {
+  switch (type_) {
+    case Value::TYPE_NULL:
+    case Value::TYPE_BOOLEAN:
+    case Value::TYPE_INTEGER:
+    case Value::TYPE_DOUBLE:
+      return;
+    case Value::TYPE_STRING:
+      string_value_.~basic_string();
+      return;
+    case Value::TYPE_BINARY:
+      binary_value_.~BinaryStorage();
+      return;
+    case Value::TYPE_LIST:
+      list_.~ListStorage();
+      return;
+    case Value::TYPE_DICTIONARY:
+      dict_.~DictStorage();
+      return;
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,142 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// CompactValue holds the same data as a base::Value tree (see values.h), in
+// far fewer allocations.
+//
+// A Value tree is a separate heap object per value, and every member of a
+// DictionaryValue is also a node of a std::map. A CompactValue is a movable
+// tagged union instead:
+//  - Booleans, integers and doubles are held inline.
+//  - Strings are held inline as a std::string, so short strings need no
+//    allocation at all.
+//  - Lists are a std::vector<CompactValue>.
+//  - Dictionaries are a std::vector of (key, CompactValue) pairs sorted by
+//    key, looked up with a binary search.
+// So a list or dictionary of scalars is a single allocation.
+//
+// Dictionaries are meant to be built all at once, from a DictStorage passed to
+// the constructor, and then read: inserting or removing a single key moves the
+// entries after it, which is linear in the size of the dictionary.
+//
+// CompactValue is not a replacement for Value in APIs. FromValue() and
+// ToValue() convert between the two, so that code that reads a lot of data, or
+// keeps it around for long, can hold it as a CompactValue.
+
+#ifndef BASE_COMPACT_VALUE_H_
+#define BASE_COMPACT_VALUE_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+class BASE_EXPORT CompactValue {
+ public:
+  using BinaryStorage = std::vector<char>;
+  using ListStorage = std::vector<CompactValue>;
+  // Sorted by key, without duplicates.
+  using DictStorage = std::vector<std::pair<std::string, CompactValue>>;
+
+  // Creates a null value.
+  CompactValue();
+
+  // Creates an empty value of |type|: false, 0, an empty string, and so on.
+  explicit CompactValue(Value::Type type);
+
+  explicit CompactValue(bool in_bool);
+  explicit CompactValue(int in_int);
+  explicit CompactValue(double in_double);
+  // Strings should be UTF-8. Also takes const char* here, which would
+  // otherwise convert to bool.
+  explicit CompactValue(const char* in_string);
+  explicit CompactValue(StringPiece in_string);
+  explicit CompactValue(std::string&& in_string);
+  explicit CompactValue(BinaryStorage in_binary);
+  explicit CompactValue(ListStorage in_list);
+  // |in_dict| does not need to be sorted. If a key appears more than once, the
+  // last of its values is kept, like repeated Set() calls on a DictionaryValue.
+  explicit CompactValue(DictStorage in_dict);
+
+  CompactValue(CompactValue&& that);
+  CompactValue& operator=(CompactValue&& that);
+
+  ~CompactValue();
+
+  // Converts |value|, which can be any Value tree.
+  static CompactValue FromValue(const Value& value);
+
+  // Converts to a Value tree owned by the caller.
+  std::unique_ptr<Value> ToValue() const;
+
+  // Returns a deep copy. CompactValues are movable, but copies have to be
+  // asked for.
+  CompactValue Clone() const;
+
+  Value::Type type() const { return type_; }
+  bool IsType(Value::Type type) const { return type == type_; }
+
+  // Like the Value methods of the same names: if the value can be converted to
+  // the given type, stores it in |out_value| and returns true. Integers convert
+  // to doubles.
+  bool GetAsBoolean(bool* out_value) const;
+  bool GetAsInteger(int* out_value) const;
+  bool GetAsDouble(double* out_value) const;
+  bool GetAsString(std::string* out_value) const;
+  bool GetAsString(StringPiece* out_value) const;
+
+  // These can only be called on values of the matching type.
+  const std::string& GetString() const;
+  const BinaryStorage& GetBinary() const;
+  const ListStorage& GetList() const;
+  ListStorage& GetList();
+  const DictStorage& GetDict() const;
+
+  // Dictionary access. These can only be called on dictionaries.
+  //
+  // Returns the value of |key|, or null if there is none.
+  const CompactValue* FindKey(StringPiece key) const;
+  CompactValue* FindKey(StringPiece key);
+  // Like DictionaryValue::Get(), treats '.' in |path| as a separator between
+  // the keys of nested dictionaries. Unlike it, does not allocate.
+  const CompactValue* FindPath(StringPiece path) const;
+  // Sets |key| to |value|, and returns the value in the dictionary.
+  CompactValue* SetKey(StringPiece key, CompactValue value);
+  // Returns true if |key| was present.
+  bool RemoveKey(StringPiece key);
+
+  // Compares the types and contents, like Value::Equals().
+  bool Equals(const CompactValue& other) const;
+
+ private:
+  void InternalMoveFrom(CompactValue&& that);
+  void InternalCleanup();
+
+  Value::Type type_;
+
+  union {
+    bool bool_value_;
+    int int_value_;
+    double double_value_;
+    std::string string_value_;
+    BinaryStorage binary_value_;
+    ListStorage list_;
+    DictStorage dict_;
+  };
+
+  DISALLOW_COPY_AND_ASSIGN(CompactValue);
+};
+
+}  // namespace base
+
+#endif  // BASE_COMPACT_VALUE_H_
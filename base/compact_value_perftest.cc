@@ -0,0 +1,165 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares a Value tree with a CompactValue holding the same preferences file:
+// the time and memory it takes to read it from JSON, and the time it takes to
+// look up preferences by path, which is what JsonPrefStore::GetValue() does for
+// every PrefService read.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/compact_value.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/heap_in_use.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kParseIterations = 20;
+const int kLookupIterations = 200;
+
+// Fills |prefs| like a user's Preferences file: a few thousand registered
+// preferences, most of them small scalars a few dictionaries deep, and the
+// per-site content settings that make up most of the file. |paths| receives
+// the paths of the registered preferences.
+void MakePreferences(DictionaryValue* prefs, std::vector<std::string>* paths) {
+  const char* const kGroups[] = {"browser", "profile", "extensions", "sync",
+                                 "net",     "session", "download",   "ntp"};
+  for (int i = 0; i < 2000; i++) {
+    std::string path = StringPrintf("%s.section%d.pref%d",
+                                    kGroups[i % arraysize(kGroups)], i % 17, i);
+    switch (i % 4) {
+      case 0:
+        prefs->SetBoolean(path, i % 3 == 0);
+        break;
+      case 1:
+        prefs->SetInteger(path, i);
+        break;
+      case 2:
+        prefs->SetDouble(path, i * 0.5);
+        break;
+      case 3:
+        prefs->SetString(path, StringPrintf("value %d", i));
+        break;
+    }
+    paths->push_back(path);
+  }
+
+  const char* const kContentTypes[] = {"cookies", "geolocation",
+                                       "notifications", "site_engagement"};
+  for (const char* content_type : kContentTypes) {
+    std::unique_ptr<DictionaryValue> exceptions(new DictionaryValue);
+    for (int site = 0; site < 2000; site++) {
+      std::unique_ptr<DictionaryValue> setting(new DictionaryValue);
+      setting->SetString("last_modified", StringPrintf("1316%09d", site));
+      setting->SetInteger("setting", site % 3);
+      exceptions->SetWithoutPathExpansion(
+          StringPrintf("https://[*.]site%d.example:443,*", site),
+          std::move(setting));
+    }
+    prefs->Set(
+        std::string("profile.content_settings.exceptions.") + content_type,
+        std::move(exceptions));
+  }
+}
+
+TEST(CompactValuePerfTest, ReadPreferences) {
+  DictionaryValue prefs;
+  std::vector<std::string> paths;
+  MakePreferences(&prefs, &paths);
+  std::string json;
+  ASSERT_TRUE(JSONWriter::WriteWithOptions(
+      prefs, JSONWriter::OPTIONS_PRETTY_PRINT, &json));
+  double megabytes = static_cast<double>(json.size()) * kParseIterations / 1e6;
+
+  struct {
+    const char* name;
+    int options;
+  } const kTreeParsers[] = {
+      {"value", JSON_PARSE_RFC},
+      {"value_sax_parser", JSON_USE_SAX_PARSER},
+  };
+  for (const auto& parser : kTreeParsers) {
+    size_t heap_before = HeapInUse();
+    size_t heap_after = 0;
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kParseIterations; i++) {
+      std::unique_ptr<Value> value = JSONReader::Read(json, parser.options);
+      ASSERT_TRUE(value);
+      if (i == 0)
+        heap_after = HeapInUse();
+    }
+    TimeDelta elapsed = TimeTicks::Now() - start;
+    perf_test::PrintResult("read_preferences", "", parser.name,
+                           megabytes / elapsed.InSecondsF(), "MB/s", true);
+    if (heap_before && heap_after >= heap_before) {
+      perf_test::PrintResult("preferences_heap", "", parser.name,
+                             (heap_after - heap_before) / 1024, "KB", true);
+    }
+  }
+
+  size_t heap_before = HeapInUse();
+  size_t heap_after = 0;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kParseIterations; i++) {
+    CompactValue value;
+    ASSERT_TRUE(JSONReader::ReadToCompactValue(json, JSON_PARSE_RFC, &value,
+                                               nullptr, nullptr));
+    if (i == 0)
+      heap_after = HeapInUse();
+  }
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  perf_test::PrintResult("read_preferences", "", "compact_value",
+                         megabytes / elapsed.InSecondsF(), "MB/s", true);
+  if (heap_before && heap_after >= heap_before) {
+    perf_test::PrintResult("preferences_heap", "", "compact_value",
+                           (heap_after - heap_before) / 1024, "KB", true);
+  }
+}
+
+TEST(CompactValuePerfTest, LookUpPreferences) {
+  DictionaryValue prefs;
+  std::vector<std::string> paths;
+  MakePreferences(&prefs, &paths);
+  CompactValue compact_prefs = CompactValue::FromValue(prefs);
+  size_t lookups = paths.size() * kLookupIterations;
+
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kLookupIterations; i++) {
+    for (const std::string& path : paths) {
+      const Value* value = nullptr;
+      ASSERT_TRUE(prefs.Get(path, &value));
+    }
+  }
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  perf_test::PrintResult("pref_lookup", "", "value",
+                         elapsed.InMicroseconds() * 1000.0 / lookups, "ns",
+                         true);
+
+  start = TimeTicks::Now();
+  for (int i = 0; i < kLookupIterations; i++) {
+    for (const std::string& path : paths)
+      ASSERT_TRUE(compact_prefs.FindPath(path));
+  }
+  elapsed = TimeTicks::Now() - start;
+  perf_test::PrintResult("pref_lookup", "", "compact_value",
+                         elapsed.InMicroseconds() * 1000.0 / lookups, "ns",
+                         true);
+}
+
+}  // namespace
+
+}  // namespace base
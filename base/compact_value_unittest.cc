@@ -0,0 +1,193 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/compact_value.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(CompactValueTest, Scalars) {
+  CompactValue null_value;
+  EXPECT_TRUE(null_value.IsType(Value::TYPE_NULL));
+
+  bool bool_value = false;
+  EXPECT_TRUE(CompactValue(true).GetAsBoolean(&bool_value));
+  EXPECT_TRUE(bool_value);
+  EXPECT_FALSE(CompactValue(1).GetAsBoolean(&bool_value));
+
+  int int_value = 0;
+  EXPECT_TRUE(CompactValue(42).GetAsInteger(&int_value));
+  EXPECT_EQ(42, int_value);
+  EXPECT_FALSE(CompactValue(4.2).GetAsInteger(&int_value));
+
+  // Integers convert to doubles, like FundamentalValue.
+  double double_value = 0.0;
+  EXPECT_TRUE(CompactValue(42).GetAsDouble(&double_value));
+  EXPECT_EQ(42.0, double_value);
+  EXPECT_TRUE(CompactValue(4.2).GetAsDouble(&double_value));
+  EXPECT_EQ(4.2, double_value);
+
+  // A string literal is a string, not a boolean.
+  CompactValue string_value("text");
+  EXPECT_TRUE(string_value.IsType(Value::TYPE_STRING));
+  EXPECT_EQ("text", string_value.GetString());
+  StringPiece piece;
+  EXPECT_TRUE(string_value.GetAsString(&piece));
+  EXPECT_EQ("text", piece);
+  EXPECT_FALSE(CompactValue(true).GetAsString(&piece));
+
+  EXPECT_TRUE(CompactValue(Value::TYPE_LIST).GetList().empty());
+  EXPECT_TRUE(CompactValue(Value::TYPE_DICTIONARY).GetDict().empty());
+  EXPECT_TRUE(CompactValue(Value::TYPE_STRING).GetString().empty());
+}
+
+TEST(CompactValueTest, DictionaryIsSorted) {
+  CompactValue::DictStorage storage;
+  storage.emplace_back("b", CompactValue(1));
+  storage.emplace_back("a", CompactValue(2));
+  storage.emplace_back("c", CompactValue(3));
+  storage.emplace_back("a", CompactValue(4));
+  storage.emplace_back("b", CompactValue(5));
+  CompactValue dict(std::move(storage));
+
+  // The last value of each key is kept.
+  const CompactValue::DictStorage& entries = dict.GetDict();
+  ASSERT_EQ(3u, entries.size());
+  EXPECT_EQ("a", entries[0].first);
+  EXPECT_TRUE(entries[0].second.Equals(CompactValue(4)));
+  EXPECT_EQ("b", entries[1].first);
+  EXPECT_TRUE(entries[1].second.Equals(CompactValue(5)));
+  EXPECT_EQ("c", entries[2].first);
+  EXPECT_TRUE(entries[2].second.Equals(CompactValue(3)));
+}
+
+TEST(CompactValueTest, FindSetAndRemoveKeys) {
+  CompactValue dict(Value::TYPE_DICTIONARY);
+  EXPECT_FALSE(dict.FindKey("key"));
+
+  CompactValue* value = dict.SetKey("key", CompactValue(1));
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(value->Equals(CompactValue(1)));
+  dict.SetKey("a.b", CompactValue("not a path"));
+  dict.SetKey("key", CompactValue(2));
+  ASSERT_EQ(2u, dict.GetDict().size());
+  EXPECT_EQ("a.b", dict.GetDict()[0].first);
+  EXPECT_TRUE(dict.FindKey("key")->Equals(CompactValue(2)));
+
+  EXPECT_TRUE(dict.RemoveKey("key"));
+  EXPECT_FALSE(dict.RemoveKey("key"));
+  EXPECT_FALSE(dict.FindKey("key"));
+  EXPECT_TRUE(dict.FindKey("a.b"));
+}
+
+TEST(CompactValueTest, FindPath) {
+  CompactValue::DictStorage inner;
+  inner.emplace_back("leaf", CompactValue(true));
+  CompactValue::DictStorage middle;
+  middle.emplace_back("inner", CompactValue(std::move(inner)));
+  middle.emplace_back("list", CompactValue(Value::TYPE_LIST));
+  CompactValue::DictStorage outer;
+  outer.emplace_back("middle", CompactValue(std::move(middle)));
+  outer.emplace_back("with.dot", CompactValue(1));
+  CompactValue root(std::move(outer));
+
+  const CompactValue* leaf = root.FindPath("middle.inner.leaf");
+  ASSERT_TRUE(leaf);
+  EXPECT_TRUE(leaf->Equals(CompactValue(true)));
+  EXPECT_TRUE(root.FindPath("middle.inner"));
+  EXPECT_TRUE(root.FindPath("middle"));
+
+  EXPECT_FALSE(root.FindPath("middle.missing.leaf"));
+  EXPECT_FALSE(root.FindPath("middle.list.leaf"));
+  EXPECT_FALSE(root.FindPath("middle.inner.leaf.more"));
+  // Like DictionaryValue::Get(), a key containing '.' cannot be found by path.
+  EXPECT_FALSE(root.FindPath("with.dot"));
+  EXPECT_TRUE(root.FindKey("with.dot"));
+}
+
+TEST(CompactValueTest, MoveAndClone) {
+  CompactValue::ListStorage storage;
+  storage.push_back(CompactValue("a string that is too long to be inline"));
+  storage.push_back(CompactValue(Value::TYPE_DICTIONARY));
+  CompactValue list(std::move(storage));
+
+  CompactValue copy = list.Clone();
+  EXPECT_TRUE(copy.Equals(list));
+
+  CompactValue moved(std::move(list));
+  EXPECT_TRUE(moved.Equals(copy));
+
+  CompactValue assigned;
+  assigned = std::move(moved);
+  EXPECT_TRUE(assigned.Equals(copy));
+
+  copy.GetList().push_back(CompactValue());
+  EXPECT_FALSE(assigned.Equals(copy));
+  assigned = CompactValue(1);
+  EXPECT_TRUE(assigned.Equals(CompactValue(1)));
+}
+
+TEST(CompactValueTest, Equals) {
+  EXPECT_TRUE(CompactValue().Equals(CompactValue()));
+  EXPECT_FALSE(CompactValue().Equals(CompactValue(false)));
+  EXPECT_FALSE(CompactValue(1).Equals(CompactValue(1.0)));
+  EXPECT_FALSE(CompactValue("a").Equals(CompactValue("b")));
+
+  CompactValue::ListStorage short_list;
+  short_list.push_back(CompactValue(1));
+  CompactValue::ListStorage long_list;
+  long_list.push_back(CompactValue(1));
+  long_list.push_back(CompactValue(2));
+  EXPECT_FALSE(CompactValue(std::move(short_list))
+                   .Equals(CompactValue(std::move(long_list))));
+
+  CompactValue::DictStorage a;
+  a.emplace_back("key", CompactValue(1));
+  CompactValue::DictStorage b;
+  b.emplace_back("other", CompactValue(1));
+  EXPECT_FALSE(CompactValue(std::move(a)).Equals(CompactValue(std::move(b))));
+}
+
+TEST(CompactValueTest, ConvertsToAndFromValue) {
+  DictionaryValue dict;
+  dict.SetBoolean("bool", true);
+  dict.SetInteger("int", 42);
+  dict.SetDouble("double", 3.5);
+  dict.SetString("string", "text");
+  dict.Set("null", Value::CreateNullValue());
+  dict.SetString("nested.string", "inner");
+  const char kBinary[] = {1, 0, 2};
+  dict.SetWithoutPathExpansion(
+      "binary", WrapUnique(BinaryValue::CreateWithCopiedBuffer(
+                    kBinary, sizeof(kBinary))));
+  std::unique_ptr<ListValue> list(new ListValue);
+  list->AppendInteger(1);
+  list->AppendString("two");
+  list->Append(WrapUnique(new DictionaryValue));
+  dict.Set("list", std::move(list));
+
+  CompactValue compact = CompactValue::FromValue(dict);
+  ASSERT_TRUE(compact.IsType(Value::TYPE_DICTIONARY));
+  EXPECT_EQ(8u, compact.GetDict().size());
+  const CompactValue* nested = compact.FindPath("nested.string");
+  ASSERT_TRUE(nested);
+  EXPECT_EQ("inner", nested->GetString());
+  const CompactValue* binary = compact.FindKey("binary");
+  ASSERT_TRUE(binary);
+  EXPECT_EQ(CompactValue::BinaryStorage(kBinary, kBinary + sizeof(kBinary)),
+            binary->GetBinary());
+
+  std::unique_ptr<Value> round_trip = compact.ToValue();
+  ASSERT_TRUE(round_trip);
+  EXPECT_TRUE(dict.Equals(round_trip.get()));
+}
+
+}  // namespace base
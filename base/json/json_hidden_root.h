@@ -0,0 +1,38 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_HIDDEN_ROOT_H_
+#define BASE_JSON_JSON_HIDDEN_ROOT_H_
+
+#include <memory>
+#include <string>
+
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+class Value;
+
+namespace internal {
+
+// Hidden roots let the JSON parsers build string values that refer to the
+// input instead of copying it: the root of the parsed tree holds a copy of the
+// input, and the strings of its children are StringPieces into that copy.
+// Values that are removed from the tree are deep copied, so that they do not
+// outlive the input they refer to. The parsers do not use them when the
+// JSON_DETACHABLE_CHILDREN option is set.
+
+// Returns a string value for |piece|, which must point into the input that
+// WrapInHiddenRoot() is given for the tree the value is added to.
+std::unique_ptr<Value> CreateJSONStringValue(StringPiece piece);
+
+// Returns |root| in a form that keeps |json| alive as long as the values that
+// refer to it.
+std::unique_ptr<Value> WrapInHiddenRoot(std::unique_ptr<std::string> json,
+                                        std::unique_ptr<Value> root);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_HIDDEN_ROOT_H_
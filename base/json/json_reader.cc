@@ -5,6 +5,7 @@
 #include "base/json/json_reader.h"
 
 #include "base/json/json_parser.h"
+#include "base/json/json_sax_parser.h"
 #include "base/logging.h"
 #include "base/values.h"
 
@@ -35,8 +36,11 @@ JSONReader::JSONReader()
     : JSONReader(JSON_PARSE_RFC) {
 }
 
-JSONReader::JSONReader(int options)
-    : parser_(new internal::JSONParser(options)) {
+JSONReader::JSONReader(int options) {
+  if (options & JSON_USE_SAX_PARSER)
+    sax_parser_.reset(new internal::JSONSAXParser(options));
+  else
+    parser_.reset(new internal::JSONParser(options));
 }
 
 JSONReader::~JSONReader() {
@@ -50,11 +54,14 @@ std::unique_ptr<Value> JSONReader::Read(StringPiece json) {
 
 // static
 std::unique_ptr<Value> JSONReader::Read(StringPiece json, int options) {
+  if (options & JSON_USE_SAX_PARSER) {
+    internal::JSONSAXParser parser(options);
+    return parser.ParseToValue(json);
+  }
   internal::JSONParser parser(options);
   return parser.Parse(json);
 }
 
-
 // static
 std::unique_ptr<Value> JSONReader::ReadAndReturnError(
     const StringPiece& json,
@@ -63,6 +70,22 @@ std::unique_ptr<Value> JSONReader::ReadAndReturnError(
     std::string* error_msg_out,
     int* error_line_out,
     int* error_column_out) {
+  if (options & JSON_USE_SAX_PARSER) {
+    internal::JSONSAXParser parser(options);
+    std::unique_ptr<Value> root(parser.ParseToValue(json));
+    if (!root) {
+      if (error_code_out)
+        *error_code_out = parser.error_code();
+      if (error_msg_out)
+        *error_msg_out = parser.GetErrorMessage();
+      if (error_line_out)
+        *error_line_out = parser.error_line();
+      if (error_column_out)
+        *error_column_out = parser.error_column();
+    }
+    return root;
+  }
+
   internal::JSONParser parser(options);
   std::unique_ptr<Value> root(parser.Parse(json));
   if (!root) {
@@ -79,6 +102,40 @@ std::unique_ptr<Value> JSONReader::ReadAndReturnError(
   return root;
 }
 
+// static
+bool JSONReader::ReadWithHandler(StringPiece json,
+                                 int options,
+                                 JSONSAXHandler* handler,
+                                 int* error_code_out,
+                                 std::string* error_msg_out) {
+  internal::JSONSAXParser parser(options);
+  if (parser.Parse(json, handler))
+    return true;
+
+  if (error_code_out)
+    *error_code_out = parser.error_code();
+  if (error_msg_out)
+    *error_msg_out = parser.GetErrorMessage();
+  return false;
+}
+
+// static
+bool JSONReader::ReadToCompactValue(StringPiece json,
+                                    int options,
+                                    CompactValue* value,
+                                    int* error_code_out,
+                                    std::string* error_msg_out) {
+  internal::JSONSAXParser parser(options);
+  if (parser.ParseToCompactValue(json, value))
+    return true;
+
+  if (error_code_out)
+    *error_code_out = parser.error_code();
+  if (error_msg_out)
+    *error_msg_out = parser.GetErrorMessage();
+  return false;
+}
+
 // static
 std::string JSONReader::ErrorCodeToString(JsonParseError error_code) {
   switch (error_code) {
@@ -107,14 +164,20 @@ std::string JSONReader::ErrorCodeToString(JsonParseError error_code) {
 }
 
 std::unique_ptr<Value> JSONReader::ReadToValue(StringPiece json) {
+  if (sax_parser_)
+    return sax_parser_->ParseToValue(json);
   return parser_->Parse(json);
 }
 
 JSONReader::JsonParseError JSONReader::error_code() const {
+  if (sax_parser_)
+    return sax_parser_->error_code();
   return parser_->error_code();
 }
 
 std::string JSONReader::GetErrorMessage() const {
+  if (sax_parser_)
+    return sax_parser_->GetErrorMessage();
   return parser_->GetErrorMessage();
 }
 
@@ -36,10 +36,13 @@
 
 namespace base {
 
+class CompactValue;
+class JSONSAXHandler;
 class Value;
 
 namespace internal {
 class JSONParser;
+class JSONSAXParser;
 }
 
 enum JSONParserOptions {
@@ -55,6 +58,11 @@ enum JSONParserOptions {
   // if the child is Remove()d from root, it would result in use-after-free
   // unless it is DeepCopy()ed or this option is used.
   JSON_DETACHABLE_CHILDREN = 1 << 1,
+
+  // Parses with the streaming parser (see ReadWithHandler() below) and builds
+  // the Value on top of it, which is faster for large inputs. Error line and
+  // column numbers can differ slightly from the default parser's.
+  JSON_USE_SAX_PARSER = 1 << 2,
 };
 
 class BASE_EXPORT JSONReader {
@@ -112,6 +120,27 @@ class BASE_EXPORT JSONReader {
       int* error_line_out = nullptr,
       int* error_column_out = nullptr);
 
+  // Parses |json| and reports its contents to |handler| as they are read,
+  // without building a Value. Returns true if the whole input was parsed.
+  // Returns false if it is not properly formed, in which case the optional
+  // |error_code_out| and |error_msg_out| are populated, or if |handler| stopped
+  // the parse, in which case |error_code_out| is set to JSON_NO_ERROR.
+  static bool ReadWithHandler(StringPiece json,
+                              int options,  // JSONParserOptions
+                              JSONSAXHandler* handler,
+                              int* error_code_out,
+                              std::string* error_msg_out);
+
+  // Parses |json| with the streaming parser into |value|, without building a
+  // Value tree. Returns false, leaving |value| untouched, if it is not properly
+  // formed, in which case the optional |error_code_out| and |error_msg_out|
+  // are populated.
+  static bool ReadToCompactValue(StringPiece json,
+                                 int options,  // JSONParserOptions
+                                 CompactValue* value,
+                                 int* error_code_out,
+                                 std::string* error_msg_out);
+
   // Converts a JSON parse error code into a human readable message.
   // Returns an empty string if error_code is JSON_NO_ERROR.
   static std::string ErrorCodeToString(JsonParseError error_code);
@@ -128,7 +157,9 @@ class BASE_EXPORT JSONReader {
   std::string GetErrorMessage() const;
 
  private:
+  // Only one of these is set, depending on JSON_USE_SAX_PARSER.
   std::unique_ptr<internal::JSONParser> parser_;
+  std::unique_ptr<internal::JSONSAXParser> sax_parser_;
 };
 
 }  // namespace base
@@ -0,0 +1,824 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_parser.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "base/bits.h"
+#include "base/compact_value.h"
+#include "base/json/json_hidden_root.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/icu/icu_utf.h"
+#include "base/values.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) &&                    \
+    (defined(__SSE2__) || defined(_M_X64) ||           \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JSON_SCAN_WITH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Same limit as JSONParser.
+const int kStackMaxDepth = 100;
+
+const int32_t kExtendedASCIIStart = 0x80;
+
+inline bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+const char* SkipDigits(const char* pos, const char* end) {
+  while (pos < end && IsDigit(*pos))
+    ++pos;
+  return pos;
+}
+
+#if !defined(JSON_SCAN_WITH_SSE2)
+// Helpers to scan 8 bytes at a time in a uint64_t.
+const uint64_t kOnes = 0x0101010101010101ULL;
+const uint64_t kHighBits = 0x8080808080808080ULL;
+
+inline uint64_t LoadWord(const char* pos) {
+  uint64_t word;
+  memcpy(&word, pos, sizeof(word));
+  return word;
+}
+
+// Returns nonzero if one of the bytes of |word| is |c|.
+inline uint64_t HasByte(uint64_t word, char c) {
+  uint64_t x = word ^ (kOnes * static_cast<uint8_t>(c));
+  return (x - kOnes) & ~x & kHighBits;
+}
+#endif
+
+// Builds a Value tree from the contents reported by JSONSAXParser. Containers
+// are added to their parent as soon as they start, so the tree is always
+// complete, and a stack of the open ones is enough to place every value.
+//
+// Strings that are pieces of |hidden_root_input| are not copied; the tree must
+// then be wrapped in a hidden root holding that input.
+class ValueBuilder : public JSONSAXHandler {
+ public:
+  explicit ValueBuilder(StringPiece hidden_root_input)
+      : hidden_root_input_(hidden_root_input) {}
+  ~ValueBuilder() override {}
+
+  std::unique_ptr<Value> TakeRoot() {
+    DCHECK(open_containers_.empty());
+    return std::move(root_);
+  }
+
+  // JSONSAXHandler:
+  bool OnNull() override {
+    Add(Value::CreateNullValue());
+    return true;
+  }
+  bool OnBoolean(bool value) override {
+    Add(WrapUnique(new FundamentalValue(value)));
+    return true;
+  }
+  bool OnInteger(int value) override {
+    Add(WrapUnique(new FundamentalValue(value)));
+    return true;
+  }
+  bool OnDouble(double value) override {
+    Add(WrapUnique(new FundamentalValue(value)));
+    return true;
+  }
+  bool OnString(StringPiece value) override {
+    if (value.data() >= hidden_root_input_.data() &&
+        value.data() < hidden_root_input_.data() + hidden_root_input_.size()) {
+      Add(CreateJSONStringValue(value));
+      return true;
+    }
+    std::unique_ptr<StringValue> string(new StringValue(std::string()));
+    value.CopyToString(string->GetString());
+    Add(std::move(string));
+    return true;
+  }
+  bool OnDictionaryStart() override {
+    DictionaryValue* dictionary = new DictionaryValue;
+    Add(WrapUnique(dictionary));
+    open_containers_.push_back(dictionary);
+    return true;
+  }
+  bool OnDictionaryKey(StringPiece key) override {
+    key.CopyToString(&key_);
+    return true;
+  }
+  bool OnDictionaryEnd() override {
+    open_containers_.pop_back();
+    return true;
+  }
+  bool OnListStart() override {
+    ListValue* list = new ListValue;
+    Add(WrapUnique(list));
+    open_containers_.push_back(list);
+    return true;
+  }
+  bool OnListEnd() override {
+    open_containers_.pop_back();
+    return true;
+  }
+
+ private:
+  void Add(std::unique_ptr<Value> value) {
+    if (open_containers_.empty()) {
+      DCHECK(!root_);
+      root_ = std::move(value);
+      return;
+    }
+
+    Value* parent = open_containers_.back();
+    if (parent->IsType(Value::TYPE_DICTIONARY)) {
+      static_cast<DictionaryValue*>(parent)->SetWithoutPathExpansion(
+          key_, std::move(value));
+    } else {
+      static_cast<ListValue*>(parent)->Append(std::move(value));
+    }
+  }
+
+  const StringPiece hidden_root_input_;
+
+  std::unique_ptr<Value> root_;
+
+  // Owned by |root_|.
+  std::vector<Value*> open_containers_;
+
+  // The key of the next value of the innermost dictionary. Reused, so that
+  // reading a key does not allocate.
+  std::string key_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueBuilder);
+};
+
+// Builds a CompactValue from the contents reported by JSONSAXParser. The
+// members of each open container are collected in a Level, which becomes a
+// CompactValue in its parent once the container ends, so that a dictionary is
+// sorted once rather than on every key.
+class CompactValueBuilder : public JSONSAXHandler {
+ public:
+  CompactValueBuilder() {}
+  ~CompactValueBuilder() override {}
+
+  CompactValue TakeRoot() {
+    DCHECK(levels_.empty());
+    return std::move(root_);
+  }
+
+  // JSONSAXHandler:
+  bool OnNull() override {
+    Add(CompactValue());
+    return true;
+  }
+  bool OnBoolean(bool value) override {
+    Add(CompactValue(value));
+    return true;
+  }
+  bool OnInteger(int value) override {
+    Add(CompactValue(value));
+    return true;
+  }
+  bool OnDouble(double value) override {
+    Add(CompactValue(value));
+    return true;
+  }
+  bool OnString(StringPiece value) override {
+    Add(CompactValue(value));
+    return true;
+  }
+  bool OnDictionaryStart() override {
+    levels_.push_back(Level(true));
+    return true;
+  }
+  bool OnDictionaryKey(StringPiece key) override {
+    levels_.back().dict.emplace_back(key.as_string(), CompactValue());
+    return true;
+  }
+  bool OnDictionaryEnd() override {
+    CompactValue dictionary(std::move(levels_.back().dict));
+    levels_.pop_back();
+    Add(std::move(dictionary));
+    return true;
+  }
+  bool OnListStart() override {
+    levels_.push_back(Level(false));
+    return true;
+  }
+  bool OnListEnd() override {
+    CompactValue list(std::move(levels_.back().list));
+    levels_.pop_back();
+    Add(std::move(list));
+    return true;
+  }
+
+ private:
+  struct Level {
+    explicit Level(bool is_dictionary) : is_dictionary(is_dictionary) {}
+
+    bool is_dictionary;
+    CompactValue::ListStorage list;
+    // The value of the last key is set when it is parsed.
+    CompactValue::DictStorage dict;
+  };
+
+  void Add(CompactValue value) {
+    if (levels_.empty()) {
+      root_ = std::move(value);
+      return;
+    }
+
+    Level& parent = levels_.back();
+    if (parent.is_dictionary)
+      parent.dict.back().second = std::move(value);
+    else
+      parent.list.push_back(std::move(value));
+  }
+
+  CompactValue root_;
+  std::vector<Level> levels_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactValueBuilder);
+};
+
+}  // namespace
+
+JSONSAXParser::JSONSAXParser(int options)
+    : options_(options),
+      start_pos_(nullptr),
+      pos_(nullptr),
+      end_pos_(nullptr),
+      depth_(0),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_column_(0) {}
+
+JSONSAXParser::~JSONSAXParser() {}
+
+bool JSONSAXParser::Parse(StringPiece input, JSONSAXHandler* handler) {
+  start_pos_ = input.data();
+  pos_ = start_pos_;
+  end_pos_ = start_pos_ + input.length();
+  depth_ = 0;
+
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+
+  // Skip a UTF-8 Byte-Order-Mark, like JSONParser.
+  if (input.starts_with("\xEF\xBB\xBF"))
+    pos_ += 3;
+
+  EatWhitespaceAndComments();
+  if (!ParseValue(handler))
+    return false;
+
+  EatWhitespaceAndComments();
+  if (pos_ != end_pos_) {
+    ReportError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, pos_);
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<Value> JSONSAXParser::ParseToValue(StringPiece input) {
+  // Unless the children must be detachable, let the strings refer to a copy of
+  // the input, like JSONParser does.
+  std::unique_ptr<std::string> input_copy;
+  if (!(options_ & JSON_DETACHABLE_CHILDREN)) {
+    input_copy.reset(new std::string(input.as_string()));
+    input = *input_copy;
+  }
+
+  ValueBuilder builder(input_copy ? input : StringPiece());
+  if (!Parse(input, &builder))
+    return nullptr;
+
+  std::unique_ptr<Value> root = builder.TakeRoot();
+  if (input_copy)
+    return WrapInHiddenRoot(std::move(input_copy), std::move(root));
+  return root;
+}
+
+bool JSONSAXParser::ParseToCompactValue(StringPiece input,
+                                        CompactValue* value) {
+  CompactValueBuilder builder;
+  if (!Parse(input, &builder))
+    return false;
+  *value = builder.TakeRoot();
+  return true;
+}
+
+std::string JSONSAXParser::GetErrorMessage() const {
+  std::string description = JSONReader::ErrorCodeToString(error_code_);
+  if (error_line_ || error_column_) {
+    return StringPrintf("Line: %i, column: %i, %s", error_line_, error_column_,
+                        description.c_str());
+  }
+  return description;
+}
+
+// static
+size_t JSONSAXParser::ScanStringBody(const char* pos, const char* end) {
+  const char* p = pos;
+#if defined(JSON_SCAN_WITH_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (end - p >= 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // The bytes outside of ASCII already have their top bit set.
+    __m128i special = _mm_or_si128(
+        bytes, _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                            _mm_cmpeq_epi8(bytes, backslash)));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask)
+      return p - pos + bits::CountTrailingZeroBits32(mask);
+    p += 16;
+  }
+#else
+  while (end - p >= 8) {
+    uint64_t word = LoadWord(p);
+    // Let the loop below find which byte it is.
+    if ((word & kHighBits) | HasByte(word, '"') | HasByte(word, '\\'))
+      break;
+    p += 8;
+  }
+#endif
+  while (p < end && static_cast<uint8_t>(*p) < kExtendedASCIIStart &&
+         *p != '"' && *p != '\\') {
+    ++p;
+  }
+  return p - pos;
+}
+
+// static
+const char* JSONSAXParser::SkipWhitespace(const char* pos, const char* end) {
+  // Most values are separated by no or little whitespace; only scan wide for
+  // the indentation of pretty-printed documents.
+  if (pos == end || !IsWhitespace(*pos))
+    return pos;
+
+#if defined(JSON_SCAN_WITH_SSE2)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i line_feed = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  while (end - pos >= 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    __m128i whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, line_feed),
+                     _mm_cmpeq_epi8(bytes, carriage_return)));
+    uint32_t mask =
+        ~static_cast<uint32_t>(_mm_movemask_epi8(whitespace)) & 0xffff;
+    if (mask)
+      return pos + bits::CountTrailingZeroBits32(mask);
+    pos += 16;
+  }
+#else
+  // Indentation is made of spaces; anything else is left to the loop below.
+  while (end - pos >= 8 && LoadWord(pos) == kOnes * ' ')
+    pos += 8;
+#endif
+  while (pos < end && IsWhitespace(*pos))
+    ++pos;
+  return pos;
+}
+
+void JSONSAXParser::EatWhitespaceAndComments() {
+  for (;;) {
+    pos_ = SkipWhitespace(pos_, end_pos_);
+    if (end_pos_ - pos_ < 2 || pos_[0] != '/')
+      return;
+
+    if (pos_[1] == '/') {
+      // Single line comment, read to the line break.
+      pos_ += 2;
+      while (pos_ < end_pos_ && *pos_ != '\n' && *pos_ != '\r')
+        ++pos_;
+    } else if (pos_[1] == '*') {
+      // Block comment, read past its end marker. An unterminated comment runs
+      // to the end of the input.
+      const char* comment_end = end_pos_;
+      for (const char* p = pos_ + 2; end_pos_ - p >= 2; ++p) {
+        if (p[0] == '*' && p[1] == '/') {
+          comment_end = p + 2;
+          break;
+        }
+      }
+      pos_ = comment_end;
+    } else {
+      return;
+    }
+  }
+}
+
+bool JSONSAXParser::ParseValue(JSONSAXHandler* handler) {
+  if (pos_ == end_pos_) {
+    ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, pos_);
+    return false;
+  }
+
+  switch (*pos_) {
+    case '{':
+      return ParseDictionary(handler);
+    case '[':
+      return ParseList(handler);
+    case '"': {
+      StringPiece value;
+      return ParseString(&value) && handler->OnString(value);
+    }
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      return ParseNumber(handler);
+    case 't':
+    case 'f':
+    case 'n':
+      return ParseLiteral(handler);
+    default:
+      ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, pos_);
+      return false;
+  }
+}
+
+bool JSONSAXParser::ParseDictionary(JSONSAXHandler* handler) {
+  DCHECK_EQ('{', *pos_);
+  if (depth_ + 1 >= kStackMaxDepth) {
+    ReportError(JSONReader::JSON_TOO_MUCH_NESTING, pos_);
+    return false;
+  }
+  ++depth_;
+  ++pos_;
+  if (!handler->OnDictionaryStart())
+    return false;
+
+  for (;;) {
+    EatWhitespaceAndComments();
+    if (pos_ < end_pos_ && *pos_ == '}')
+      break;
+    if (pos_ == end_pos_ || *pos_ != '"') {
+      ReportError(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, pos_);
+      return false;
+    }
+
+    StringPiece key;
+    if (!ParseString(&key))
+      return false;
+    if (!handler->OnDictionaryKey(key))
+      return false;
+
+    EatWhitespaceAndComments();
+    if (pos_ == end_pos_ || *pos_ != ':') {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+    ++pos_;
+
+    EatWhitespaceAndComments();
+    if (!ParseValue(handler))
+      return false;
+
+    EatWhitespaceAndComments();
+    if (pos_ < end_pos_ && *pos_ == ',') {
+      ++pos_;
+      EatWhitespaceAndComments();
+      if (pos_ < end_pos_ && *pos_ == '}' &&
+          !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+        ReportError(JSONReader::JSON_TRAILING_COMMA, pos_);
+        return false;
+      }
+      continue;
+    }
+    if (pos_ == end_pos_ || *pos_ != '}') {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+    break;
+  }
+
+  ++pos_;
+  --depth_;
+  return handler->OnDictionaryEnd();
+}
+
+bool JSONSAXParser::ParseList(JSONSAXHandler* handler) {
+  DCHECK_EQ('[', *pos_);
+  if (depth_ + 1 >= kStackMaxDepth) {
+    ReportError(JSONReader::JSON_TOO_MUCH_NESTING, pos_);
+    return false;
+  }
+  ++depth_;
+  ++pos_;
+  if (!handler->OnListStart())
+    return false;
+
+  for (;;) {
+    EatWhitespaceAndComments();
+    if (pos_ < end_pos_ && *pos_ == ']')
+      break;
+    if (!ParseValue(handler))
+      return false;
+
+    EatWhitespaceAndComments();
+    if (pos_ < end_pos_ && *pos_ == ',') {
+      ++pos_;
+      EatWhitespaceAndComments();
+      if (pos_ < end_pos_ && *pos_ == ']' &&
+          !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+        ReportError(JSONReader::JSON_TRAILING_COMMA, pos_);
+        return false;
+      }
+      continue;
+    }
+    if (pos_ == end_pos_ || *pos_ != ']') {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+    break;
+  }
+
+  ++pos_;
+  --depth_;
+  return handler->OnListEnd();
+}
+
+bool JSONSAXParser::ParseNumber(JSONSAXHandler* handler) {
+  const char* number_start = pos_;
+  bool negative = *pos_ == '-';
+  if (negative)
+    ++pos_;
+
+  // The integer part, without leading zeros.
+  const char* int_start = pos_;
+  pos_ = SkipDigits(pos_, end_pos_);
+  const char* int_end = pos_;
+  if (int_end == int_start || (*int_start == '0' && int_end - int_start > 1)) {
+    ReportError(JSONReader::JSON_SYNTAX_ERROR, int_start);
+    return false;
+  }
+
+  // The optional fraction and exponent parts.
+  bool is_integer = true;
+  if (pos_ < end_pos_ && *pos_ == '.') {
+    is_integer = false;
+    const char* fraction_start = ++pos_;
+    pos_ = SkipDigits(pos_, end_pos_);
+    if (pos_ == fraction_start) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+  }
+  if (pos_ < end_pos_ && (*pos_ == 'e' || *pos_ == 'E')) {
+    is_integer = false;
+    ++pos_;
+    if (pos_ < end_pos_ && (*pos_ == '-' || *pos_ == '+'))
+      ++pos_;
+    const char* exponent_start = pos_;
+    pos_ = SkipDigits(pos_, end_pos_);
+    if (pos_ == exponent_start) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+  }
+  StringPiece number(number_start, pos_ - number_start);
+
+  // Like JSONParser, require the number to be followed by something that can
+  // end a value.
+  EatWhitespaceAndComments();
+  if (pos_ < end_pos_ && *pos_ != ',' && *pos_ != '}' && *pos_ != ']') {
+    ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+    return false;
+  }
+
+  if (is_integer) {
+    // Nine digits always fit in an int.
+    if (int_end - int_start <= 9) {
+      int value = 0;
+      for (const char* p = int_start; p < int_end; ++p)
+        value = value * 10 + (*p - '0');
+      return handler->OnInteger(negative ? -value : value);
+    }
+    int value;
+    if (StringToInt(number, &value))
+      return handler->OnInteger(value);
+  }
+
+  double value;
+  if (!StringToDouble(number.as_string(), &value) || !std::isfinite(value)) {
+    ReportError(JSONReader::JSON_SYNTAX_ERROR, number_start);
+    return false;
+  }
+  return handler->OnDouble(value);
+}
+
+bool JSONSAXParser::ParseLiteral(JSONSAXHandler* handler) {
+  StringPiece rest(pos_, end_pos_ - pos_);
+  if (rest.starts_with("true")) {
+    pos_ += 4;
+    return handler->OnBoolean(true);
+  }
+  if (rest.starts_with("false")) {
+    pos_ += 5;
+    return handler->OnBoolean(false);
+  }
+  if (rest.starts_with("null")) {
+    pos_ += 4;
+    return handler->OnNull();
+  }
+  ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+  return false;
+}
+
+bool JSONSAXParser::ParseString(StringPiece* out) {
+  DCHECK_EQ('"', *pos_);
+  const char* string_start = ++pos_;
+
+  // Whether the string is being decoded into |string_buffer_|, because it has
+  // escape sequences and cannot be a piece of the input.
+  bool buffered = false;
+
+  for (;;) {
+    const char* run_start = pos_;
+    pos_ += ScanStringBody(pos_, end_pos_);
+    if (buffered)
+      string_buffer_.append(run_start, pos_ - run_start);
+
+    if (pos_ == end_pos_) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+
+    if (*pos_ == '"') {
+      *out = buffered ? StringPiece(string_buffer_)
+                      : StringPiece(string_start, pos_ - string_start);
+      ++pos_;
+      return true;
+    }
+
+    if (*pos_ == '\\') {
+      if (!buffered) {
+        string_buffer_.assign(string_start, pos_ - string_start);
+        buffered = true;
+      }
+      if (!DecodeEscape())
+        return false;
+      continue;
+    }
+
+    // A byte outside of ASCII, which must start a valid UTF-8 character.
+    int32_t length =
+        static_cast<int32_t>(std::min<ptrdiff_t>(end_pos_ - pos_, 4));
+    int32_t offset = 0;
+    int32_t code_point;
+    CBU8_NEXT(reinterpret_cast<const uint8_t*>(pos_), offset, length,
+              code_point);
+    if (code_point < 0 || !IsValidCharacter(code_point)) {
+      ReportError(JSONReader::JSON_UNSUPPORTED_ENCODING, pos_);
+      return false;
+    }
+    if (buffered)
+      string_buffer_.append(pos_, offset);
+    pos_ += offset;
+  }
+}
+
+bool JSONSAXParser::DecodeEscape() {
+  DCHECK_EQ('\\', *pos_);
+  const char* escape_start = pos_;
+  if (end_pos_ - pos_ < 2) {
+    ReportError(JSONReader::JSON_INVALID_ESCAPE, escape_start);
+    return false;
+  }
+  pos_ += 2;
+
+  switch (escape_start[1]) {
+    case 'x': {
+      // UTF-8 \x escape sequences are not allowed in the spec, but JSONParser
+      // supports them for backwards-compatibility.
+      int hex_digit = 0;
+      if (end_pos_ - pos_ < 2 ||
+          !HexStringToInt(StringPiece(pos_, 2), &hex_digit) || hex_digit < 0) {
+        ReportError(JSONReader::JSON_INVALID_ESCAPE, escape_start);
+        return false;
+      }
+      pos_ += 2;
+      WriteUnicodeCharacter(hex_digit, &string_buffer_);
+      return true;
+    }
+    case 'u':
+      if (!DecodeUTF16()) {
+        ReportError(JSONReader::JSON_INVALID_ESCAPE, escape_start);
+        return false;
+      }
+      return true;
+    case '"':
+      string_buffer_.push_back('"');
+      return true;
+    case '\\':
+      string_buffer_.push_back('\\');
+      return true;
+    case '/':
+      string_buffer_.push_back('/');
+      return true;
+    case 'b':
+      string_buffer_.push_back('\b');
+      return true;
+    case 'f':
+      string_buffer_.push_back('\f');
+      return true;
+    case 'n':
+      string_buffer_.push_back('\n');
+      return true;
+    case 'r':
+      string_buffer_.push_back('\r');
+      return true;
+    case 't':
+      string_buffer_.push_back('\t');
+      return true;
+    case 'v':  // Not listed as valid escape sequence in the RFC.
+      string_buffer_.push_back('\v');
+      return true;
+    default:
+      ReportError(JSONReader::JSON_INVALID_ESCAPE, escape_start);
+      return false;
+  }
+}
+
+bool JSONSAXParser::DecodeUTF16() {
+  int code_unit16_high = 0;
+  if (end_pos_ - pos_ < 4 ||
+      !HexStringToInt(StringPiece(pos_, 4), &code_unit16_high) ||
+      code_unit16_high < 0) {
+    return false;
+  }
+  pos_ += 4;
+
+  uint32_t code_point = code_unit16_high;
+  if (CBU16_IS_SURROGATE(code_unit16_high)) {
+    // It must be a high surrogate, followed by the \uXXXX of the low one.
+    int code_unit16_low = 0;
+    if (!CBU16_IS_SURROGATE_LEAD(code_unit16_high) || end_pos_ - pos_ < 6 ||
+        pos_[0] != '\\' || pos_[1] != 'u' ||
+        !HexStringToInt(StringPiece(pos_ + 2, 4), &code_unit16_low) ||
+        !CBU16_IS_TRAIL(code_unit16_low)) {
+      return false;
+    }
+    pos_ += 6;
+    code_point = CBU16_GET_SUPPLEMENTARY(code_unit16_high, code_unit16_low);
+  }
+
+  if (!IsValidCharacter(code_point))
+    return false;
+  WriteUnicodeCharacter(code_point, &string_buffer_);
+  return true;
+}
+
+void JSONSAXParser::ReportError(JSONReader::JsonParseError code,
+                                const char* pos) {
+  error_code_ = code;
+
+  // "\r\n" counts as a single line break.
+  error_line_ = 1;
+  const char* line_start = start_pos_;
+  for (const char* p = start_pos_; p < pos; ++p) {
+    if (*p == '\n' || (*p == '\r' && (p + 1 == end_pos_ || p[1] != '\n'))) {
+      ++error_line_;
+      line_start = p + 1;
+    }
+  }
+  error_column_ = static_cast<int>(pos - line_start) + 1;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,163 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_SAX_PARSER_H_
+#define BASE_JSON_JSON_SAX_PARSER_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "base/base_export.h"
+#include "base/gtest_prod_util.h"
+#include "base/json/json_reader.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+class CompactValue;
+class Value;
+
+// Receives the contents of a JSON document from JSONReader::ReadWithHandler()
+// as they are parsed, in document order. Every method returns whether parsing
+// should continue; returning false stops it.
+//
+// The StringPieces passed to the handler are only valid during the call: they
+// point either into the input or into a buffer that the parser reuses.
+class BASE_EXPORT JSONSAXHandler {
+ public:
+  virtual ~JSONSAXHandler() {}
+
+  virtual bool OnNull() = 0;
+  virtual bool OnBoolean(bool value) = 0;
+  virtual bool OnInteger(int value) = 0;
+  virtual bool OnDouble(double value) = 0;
+  virtual bool OnString(StringPiece value) = 0;
+
+  // A dictionary is reported as OnDictionaryStart(), then OnDictionaryKey()
+  // followed by the value for each of its members, then OnDictionaryEnd().
+  virtual bool OnDictionaryStart() = 0;
+  virtual bool OnDictionaryKey(StringPiece key) = 0;
+  virtual bool OnDictionaryEnd() = 0;
+
+  // A list is reported as OnListStart(), its items, then OnListEnd().
+  virtual bool OnListStart() = 0;
+  virtual bool OnListEnd() = 0;
+};
+
+namespace internal {
+
+// A streaming JSON parser: it accepts the same documents and options as
+// JSONParser, but reports their contents to a JSONSAXHandler instead of
+// building a Value tree. ParseToValue() builds a tree on top of it.
+//
+// The parser makes a single pass over the input without copying it. Strings
+// are handed to the handler as StringPieces into the input unless they contain
+// escape sequences, which are decoded into a buffer that is reused for every
+// string. The bodies of strings, and runs of whitespace, are scanned 16 bytes
+// at a time with SSE2 where it is available and 8 bytes at a time otherwise;
+// this skips over ASCII in bulk, and only bytes outside of it go through UTF-8
+// validation one character at a time.
+//
+// Line and column numbers are only computed when an error is reported, by
+// scanning the input up to the error again. The column is the 1-based column
+// of the byte where the error was detected, which can differ from the one
+// JSONParser reports for the same error.
+class BASE_EXPORT JSONSAXParser {
+ public:
+  explicit JSONSAXParser(int options);
+  ~JSONSAXParser();
+
+  // Parses |input| and reports its contents to |handler|. Returns true if the
+  // whole document was parsed. Returns false if it is not properly formed, in
+  // which case error_code() is set, or if |handler| stopped the parse, in
+  // which case error_code() is JSON_NO_ERROR.
+  bool Parse(StringPiece input, JSONSAXHandler* handler);
+
+  // Parses |input| into a Value tree owned by the caller. Returns null if it is
+  // not properly formed. Like JSONParser, the strings of the tree refer to a
+  // copy of |input| held by its root, unless JSON_DETACHABLE_CHILDREN is set.
+  std::unique_ptr<Value> ParseToValue(StringPiece input);
+
+  // Parses |input| into |value|. Returns false, leaving |value| untouched, if
+  // it is not properly formed.
+  bool ParseToCompactValue(StringPiece input, CompactValue* value);
+
+  // Returns the error code.
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Returns the human-friendly error message.
+  std::string GetErrorMessage() const;
+
+  // Returns the line and column of the last error, or 0 if there was none.
+  int error_line() const { return error_line_; }
+  int error_column() const { return error_column_; }
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(JSONSAXParserTest, ScanStringBody);
+  FRIEND_TEST_ALL_PREFIXES(JSONSAXParserTest, SkipWhitespace);
+
+  // Returns the number of bytes at the start of [|pos|, |end|) that can be
+  // part of a string as they are: ASCII other than '"' and '\\'.
+  static size_t ScanStringBody(const char* pos, const char* end);
+
+  // Returns the first byte in [|pos|, |end|) that is not a space, tab, or
+  // line break, or |end|.
+  static const char* SkipWhitespace(const char* pos, const char* end);
+
+  // Skips whitespace and comments. Leaves |pos_| on the next byte that is
+  // neither, or at the end of the input.
+  void EatWhitespaceAndComments();
+
+  // Parses the value at |pos_|, which is past any whitespace, and leaves
+  // |pos_| after it.
+  bool ParseValue(JSONSAXHandler* handler);
+  bool ParseDictionary(JSONSAXHandler* handler);
+  bool ParseList(JSONSAXHandler* handler);
+  bool ParseNumber(JSONSAXHandler* handler);
+  bool ParseLiteral(JSONSAXHandler* handler);
+
+  // Parses the string at |pos_|, which is on its opening quote, and leaves
+  // |pos_| after its closing quote. |out| is set to the decoded string, which
+  // points either into the input or into |string_buffer_|.
+  bool ParseString(StringPiece* out);
+
+  // Decodes the escape sequence at |pos_|, which is on the backslash, into
+  // |string_buffer_|, and leaves |pos_| after it.
+  bool DecodeEscape();
+
+  // Decodes the \uXXXX sequence at |pos_|, which is on the first hexadecimal
+  // digit, and the low surrogate that follows it if needed. Returns false if
+  // they are not a valid character.
+  bool DecodeUTF16();
+
+  // Records |code| as the error at |pos|.
+  void ReportError(JSONReader::JsonParseError code, const char* pos);
+
+  // base::JSONParserOptions that control parsing.
+  const int options_;
+
+  const char* start_pos_;
+  const char* pos_;
+  const char* end_pos_;
+
+  // The number of dictionaries and lists that |pos_| is in.
+  int depth_;
+
+  // Holds the strings that cannot be handed out as a piece of the input.
+  std::string string_buffer_;
+
+  JSONReader::JsonParseError error_code_;
+  int error_line_;
+  int error_column_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONSAXParser);
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_SAX_PARSER_H_
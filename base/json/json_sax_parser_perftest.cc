@@ -0,0 +1,203 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the default JSONParser with the streaming JSONSAXParser, building a
+// Value tree and with a handler that only counts what it is told, on
+// documents shaped like the large files Chrome reads: preferences, extension
+// manifests and policy lists, and the JSON files of the source tree.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_sax_parser.h"
+#include "base/json/json_writer.h"
+#include "base/macros.h"
+#include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/heap_in_use.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+// Each document is parsed until this many bytes were read in total.
+const size_t kBytesPerMeasurement = 200 * 1024 * 1024;
+
+// Counts what it is told, so that the parse itself is measured.
+class CountingHandler : public JSONSAXHandler {
+ public:
+  CountingHandler() : count_(0) {}
+
+  size_t count() const { return count_; }
+
+  bool OnNull() override { return Count(); }
+  bool OnBoolean(bool value) override { return Count(); }
+  bool OnInteger(int value) override { return Count(); }
+  bool OnDouble(double value) override { return Count(); }
+  bool OnString(StringPiece value) override { return Count(); }
+  bool OnDictionaryStart() override { return Count(); }
+  bool OnDictionaryKey(StringPiece key) override { return Count(); }
+  bool OnDictionaryEnd() override { return Count(); }
+  bool OnListStart() override { return Count(); }
+  bool OnListEnd() override { return Count(); }
+
+ private:
+  bool Count() {
+    count_++;
+    return true;
+  }
+
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingHandler);
+};
+
+// A preferences file: a dictionary per site setting, with nesting, many short
+// keys, and a pretty-printed layout.
+std::string MakePreferences(size_t size) {
+  DictionaryValue root;
+  std::string json;
+  int next_check = 1000;
+  for (int site = 0; json.size() < size; site++) {
+    std::unique_ptr<DictionaryValue> settings(new DictionaryValue);
+    settings->SetString("last_modified", StringPrintf("1316%09d", site));
+    settings->SetInteger("setting", site % 3);
+    settings->SetBoolean("is_default", site % 2 == 0);
+    settings->SetDouble("engagement", site * 0.25);
+    std::unique_ptr<ListValue> history(new ListValue);
+    for (int i = 0; i < 4; i++)
+      history->AppendString(StringPrintf("https://site%d.example/%d", site, i));
+    settings->Set("history", std::move(history));
+    root.SetWithoutPathExpansion(
+        StringPrintf("https://[*.]site%d.example:443,*", site),
+        std::move(settings));
+
+    // Only write the document when it should be about large enough.
+    if (site + 1 == next_check) {
+      JSONWriter::WriteWithOptions(root, JSONWriter::OPTIONS_PRETTY_PRINT,
+                                   &json);
+      next_check = std::max<size_t>(next_check + 1,
+                                    size / (json.size() / next_check) + 1);
+    }
+  }
+  return json;
+}
+
+// A list of extension manifests or policies: long strings, some with escape
+// sequences and text outside of ASCII, written without whitespace.
+std::string MakeManifests(size_t size) {
+  ListValue root;
+  std::string json;
+  int next_check = 1000;
+  for (int i = 0; json.size() < size; i++) {
+    std::unique_ptr<DictionaryValue> manifest(new DictionaryValue);
+    manifest->SetString("name", StringPrintf("Extension \"%d\"", i));
+    manifest->SetString(
+        "description",
+        "Une extension tr\xC3\xA8s utile, qui fait beaucoup de choses "
+        "diff\xC3\xA9rentes \xE2\x80\x94 \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E"
+        " \\ path\\to\\file\n\tsecond line");
+    manifest->SetString("version", StringPrintf("%d.%d.%d", i, i % 7, i % 3));
+    std::unique_ptr<ListValue> permissions(new ListValue);
+    permissions->AppendString("tabs");
+    permissions->AppendString("storage");
+    permissions->AppendString(StringPrintf("https://*.example%d.com/*", i));
+    manifest->Set("permissions", std::move(permissions));
+    root.Append(std::move(manifest));
+
+    if (i + 1 == next_check) {
+      JSONWriter::Write(root, &json);
+      next_check = std::max<size_t>(next_check + 1,
+                                    size / (json.size() / next_check) + 1);
+    }
+  }
+  return json;
+}
+
+void MeasureParsers(const std::string& corpus, const std::string& json) {
+  size_t iterations = std::max<size_t>(1, kBytesPerMeasurement / json.size());
+  double megabytes = static_cast<double>(json.size()) * iterations / 1e6;
+
+  struct {
+    const char* name;
+    int options;
+  } const kTreeParsers[] = {
+      {"json_parser", JSON_PARSE_RFC},
+      {"json_sax_parser", JSON_USE_SAX_PARSER},
+  };
+  for (const auto& parser : kTreeParsers) {
+    size_t heap_before = HeapInUse();
+    size_t heap_after = 0;
+    TimeTicks start = TimeTicks::Now();
+    for (size_t i = 0; i < iterations; i++) {
+      std::unique_ptr<Value> value = JSONReader::Read(json, parser.options);
+      ASSERT_TRUE(value) << corpus;
+      if (i == 0)
+        heap_after = HeapInUse();
+    }
+    TimeDelta elapsed = TimeTicks::Now() - start;
+
+    perf_test::PrintResult("json_parse_" + corpus, "", parser.name,
+                           megabytes / elapsed.InSecondsF(), "MB/s", true);
+    if (heap_before && heap_after >= heap_before) {
+      perf_test::PrintResult("json_heap_" + corpus, "", parser.name,
+                             (heap_after - heap_before) / 1024, "KB", true);
+    }
+  }
+
+  TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; i++) {
+    CountingHandler handler;
+    ASSERT_TRUE(JSONReader::ReadWithHandler(json, JSON_PARSE_RFC, &handler,
+                                            nullptr, nullptr));
+  }
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  perf_test::PrintResult("json_parse_" + corpus, "", "json_sax_handler",
+                         megabytes / elapsed.InSecondsF(), "MB/s", true);
+}
+
+TEST(JSONSAXParserPerfTest, Preferences) {
+  MeasureParsers("preferences", MakePreferences(20 * 1024 * 1024));
+}
+
+TEST(JSONSAXParserPerfTest, Manifests) {
+  MeasureParsers("manifests", MakeManifests(20 * 1024 * 1024));
+}
+
+TEST(JSONSAXParserPerfTest, SourceTreeFiles) {
+  FilePath source_root;
+  ASSERT_TRUE(PathService::Get(DIR_SOURCE_ROOT, &source_root));
+
+  const char* const kFiles[] = {
+      "net/http/transport_security_state_static.json",
+      "chrome/common/extensions/api/webview_tag.json",
+  };
+  for (const char* file : kFiles) {
+    std::string json;
+    if (!ReadFileToString(source_root.AppendASCII(file), &json)) {
+      LOG(WARNING) << "Skipping " << file;
+      continue;
+    }
+    MeasureParsers(FilePath::FromUTF8Unsafe(file)
+                       .BaseName()
+                       .RemoveExtension()
+                       .MaybeAsASCII(),
+                   json);
+  }
+}
+
+}  // namespace
+
+}  // namespace base
@@ -0,0 +1,370 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_parser.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "base/compact_value.h"
+#include "base/json/json_reader.h"
+#include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Records what it is told as a compact string, and can stop the parse after a
+// given number of events.
+class RecordingHandler : public JSONSAXHandler {
+ public:
+  RecordingHandler() : events_left_(-1) {}
+
+  const std::string& events() const { return events_; }
+  void set_events_left(int events_left) { events_left_ = events_left; }
+
+  bool OnNull() override { return Record("null"); }
+  bool OnBoolean(bool value) override {
+    return Record(value ? "true" : "false");
+  }
+  bool OnInteger(int value) override { return Record(IntToString(value)); }
+  bool OnDouble(double value) override {
+    return Record(StringPrintf("%gd", value));
+  }
+  bool OnString(StringPiece value) override {
+    return Record("'" + value.as_string() + "'");
+  }
+  bool OnDictionaryStart() override { return Record("{"); }
+  bool OnDictionaryKey(StringPiece key) override {
+    return Record(key.as_string() + ":");
+  }
+  bool OnDictionaryEnd() override { return Record("}"); }
+  bool OnListStart() override { return Record("["); }
+  bool OnListEnd() override { return Record("]"); }
+
+ private:
+  bool Record(const std::string& event) {
+    if (!events_.empty())
+      events_ += " ";
+    events_ += event;
+    return events_left_ < 0 || --events_left_ > 0;
+  }
+
+  std::string events_;
+  int events_left_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingHandler);
+};
+
+std::string Events(StringPiece json) {
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  RecordingHandler handler;
+  EXPECT_TRUE(parser.Parse(json, &handler)) << json;
+  return handler.events();
+}
+
+}  // namespace
+
+TEST(JSONSAXParserTest, ScanStringBody) {
+  // Put a stop byte at every position of strings long enough to be scanned
+  // in wide chunks, followed by bytes that must not be looked at.
+  const char kStops[] = {'"', '\\', '\x80', '\xff'};
+  for (char stop : kStops) {
+    for (size_t length = 0; length < 40; length++) {
+      std::string input(length, 'a');
+      input += stop;
+      input += std::string(20, '"');
+      EXPECT_EQ(length, JSONSAXParser::ScanStringBody(
+                            input.data(), input.data() + input.size()));
+    }
+  }
+
+  // Without a stop byte, the whole input is scanned.
+  for (size_t length = 0; length < 40; length++) {
+    std::string input(length, '\x7f');
+    EXPECT_EQ(length, JSONSAXParser::ScanStringBody(
+                          input.data(), input.data() + input.size()));
+  }
+}
+
+TEST(JSONSAXParserTest, SkipWhitespace) {
+  for (size_t length = 0; length < 40; length++) {
+    std::string input;
+    for (size_t i = 0; i < length; i++)
+      input += " \t\r\n"[i % 4];
+    input += "x   ";
+    EXPECT_EQ(input.data() + length,
+              JSONSAXParser::SkipWhitespace(input.data(),
+                                            input.data() + input.size()));
+    EXPECT_EQ(input.data() + length,
+              JSONSAXParser::SkipWhitespace(input.data(),
+                                            input.data() + length));
+  }
+}
+
+TEST(JSONSAXParserTest, Events) {
+  EXPECT_EQ("null", Events("null"));
+  EXPECT_EQ("true", Events(" true "));
+  EXPECT_EQ("false", Events("false"));
+  EXPECT_EQ("-42", Events("-42"));
+  EXPECT_EQ("2147483647", Events("2147483647"));
+  EXPECT_EQ("2.14748e+09d", Events("2147483648"));
+  EXPECT_EQ("1.5d", Events("1.5"));
+  EXPECT_EQ("100d", Events("1e2"));
+  EXPECT_EQ("'text'", Events("\"text\""));
+  EXPECT_EQ("{ }", Events("{}"));
+  EXPECT_EQ("[ ]", Events("[]"));
+  EXPECT_EQ("{ a: 1 b: [ true { c: null } ] }",
+            Events("{\"a\": 1, \"b\": [true, {\"c\": null}]}"));
+  EXPECT_EQ("[ 1 2 ]", Events("// Comment.\n[1, /* Comment. */ 2]"));
+}
+
+TEST(JSONSAXParserTest, Strings) {
+  // Strings without escape sequences point into the input.
+  std::string input = "[\"plain text long enough for a wide scan\"]";
+  class PointerHandler : public RecordingHandler {
+   public:
+    explicit PointerHandler(const std::string& input) : input_(input) {}
+    bool OnString(StringPiece value) override {
+      EXPECT_GE(value.data(), input_.data());
+      EXPECT_LE(value.data() + value.size(), input_.data() + input_.size());
+      return RecordingHandler::OnString(value);
+    }
+
+   private:
+    const std::string& input_;
+  };
+  PointerHandler handler(input);
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  EXPECT_TRUE(parser.Parse(input, &handler));
+
+  EXPECT_EQ("[ 'a\"b\\c/d\be\ff\ng\rh\ti\vj' ]",
+            Events("[\"a\\\"b\\\\c\\/d\\be\\ff\\ng\\rh\\ti\\vj\"]"));
+  EXPECT_EQ("'\xC3\xA9\xE2\x82\xAC \xF0\x9F\x98\x80 A \xC3\xA9'",
+            Events("\"\\u00e9\\u20ac \\ud83d\\ude00 \\x41 \\xe9\""));
+  EXPECT_EQ("'\xC3\xA9t\xC3\xA9 0123456789abcdef0123456789'",
+            Events("\"\xC3\xA9t\xC3\xA9 0123456789abcdef0123456789\""));
+
+  // A key and the value after it can both need decoding.
+  EXPECT_EQ("{ k\n: 'v\t' }", Events("{\"k\\n\": \"v\\t\"}"));
+}
+
+TEST(JSONSAXParserTest, ParseToValue) {
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  std::unique_ptr<Value> root = parser.ParseToValue(
+      "{\"list\": [1, 2.5, \"three\", null], \"dict\": {\"a\": true},"
+      " \"a.b\": \"not a path\", \"list\": [\"replaced\"]}");
+  ASSERT_TRUE(root);
+
+  DictionaryValue* dict;
+  ASSERT_TRUE(root->GetAsDictionary(&dict));
+  EXPECT_EQ(3u, dict->size());
+  ListValue* list;
+  ASSERT_TRUE(dict->GetList("list", &list));
+  ASSERT_EQ(1u, list->GetSize());
+  std::string string;
+  EXPECT_TRUE(dict->GetStringWithoutPathExpansion("a.b", &string));
+  EXPECT_EQ("not a path", string);
+  bool boolean;
+  EXPECT_TRUE(dict->GetBoolean("dict.a", &boolean));
+  EXPECT_TRUE(boolean);
+
+  // Children removed from the root keep their strings, which otherwise point
+  // into the copy of the input that the root holds.
+  std::unique_ptr<Value> child;
+  ASSERT_TRUE(dict->RemoveWithoutPathExpansion("a.b", &child));
+  std::unique_ptr<Value> list_child;
+  ASSERT_TRUE(dict->Remove("list", &list_child));
+  root.reset();
+  EXPECT_TRUE(child->GetAsString(&string));
+  EXPECT_EQ("not a path", string);
+  ASSERT_TRUE(list_child->GetAsList(&list));
+  EXPECT_TRUE(list->GetString(0, &string));
+  EXPECT_EQ("replaced", string);
+}
+
+TEST(JSONSAXParserTest, ParseToValueDetachableChildren) {
+  std::string input = "[\"a\", [\"b\"]]";
+  JSONSAXParser parser(JSON_DETACHABLE_CHILDREN);
+  std::unique_ptr<Value> root = parser.ParseToValue(input);
+  ASSERT_TRUE(root);
+  input.assign(input.size(), ' ');
+
+  ListValue* list;
+  ASSERT_TRUE(root->GetAsList(&list));
+  std::string string;
+  EXPECT_TRUE(list->GetString(0, &string));
+  EXPECT_EQ("a", string);
+  std::unique_ptr<Value> child;
+  ASSERT_TRUE(list->Remove(1, &child));
+  root.reset();
+  ASSERT_TRUE(child->GetAsList(&list));
+  EXPECT_TRUE(list->GetString(0, &string));
+  EXPECT_EQ("b", string);
+}
+
+// The streaming parser builds the same values as the default one.
+TEST(JSONSAXParserTest, MatchesJSONParser) {
+  const char* const kInputs[] = {
+      "[]",
+      "{}",
+      "0",
+      "-0",
+      "123456789012",
+      "-1.5e-3",
+      "\"\"",
+      "\"\xEF\xBB\xBF\"",
+      "\xEF\xBB\xBF[1]",
+      "[1, [2, [3, {\"4\": [5]}]]]",
+      "{\"a\": 1, \"a\": 2}",
+      "{\"\\u00e9\": \"caf\xC3\xA9\"}",
+      "\"\\ud800\\udc00\"",
+      "[\n  1,\r\n  2\r]",
+      "[1, 2, ]",
+      "{\"a\": 1, }",
+  };
+  for (const char* input : kInputs) {
+    for (int options : {JSON_PARSE_RFC, JSON_ALLOW_TRAILING_COMMAS}) {
+      JSONSAXParser parser(options);
+      std::unique_ptr<Value> value = parser.ParseToValue(input);
+      int error_code = 0;
+      std::unique_ptr<Value> expected =
+          JSONReader::ReadAndReturnError(input, options, &error_code, nullptr);
+      if (expected) {
+        ASSERT_TRUE(value) << input;
+        EXPECT_TRUE(value->Equals(expected.get())) << input;
+      } else {
+        EXPECT_FALSE(value) << input;
+        EXPECT_EQ(error_code, parser.error_code()) << input;
+      }
+    }
+  }
+}
+
+// ParseToCompactValue() builds the same data as ParseToValue().
+TEST(JSONSAXParserTest, ParseToCompactValue) {
+  const char* const kInputs[] = {
+      "null",
+      "\"string\"",
+      "[1, 2.5, true, \"three\", null, [], {}]",
+      "{\"b\": {\"x\": [1, {\"y\": 2}]}, \"a\": 1, \"b\": [\"last\"]}",
+      "{\"\\u00e9\": \"caf\xC3\xA9\", \"a.b\": \"\\n\"}",
+  };
+  for (const char* input : kInputs) {
+    JSONSAXParser parser(JSON_PARSE_RFC);
+    std::unique_ptr<Value> expected = parser.ParseToValue(input);
+    ASSERT_TRUE(expected) << input;
+    CompactValue value;
+    ASSERT_TRUE(parser.ParseToCompactValue(input, &value)) << input;
+    EXPECT_TRUE(value.Equals(CompactValue::FromValue(*expected))) << input;
+  }
+
+  CompactValue value(1);
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  EXPECT_FALSE(parser.ParseToCompactValue("[1, {\"a\": }]", &value));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, parser.error_code());
+  EXPECT_TRUE(value.Equals(CompactValue(1)));
+}
+
+TEST(JSONSAXParserTest, Errors) {
+  struct {
+    const char* input;
+    JSONReader::JsonParseError error;
+  } const kCases[] = {
+      {"", JSONReader::JSON_UNEXPECTED_TOKEN},
+      {"nul", JSONReader::JSON_SYNTAX_ERROR},
+      {"01", JSONReader::JSON_SYNTAX_ERROR},
+      {"1.", JSONReader::JSON_SYNTAX_ERROR},
+      {"1e", JSONReader::JSON_SYNTAX_ERROR},
+      {"[1 2]", JSONReader::JSON_SYNTAX_ERROR},
+      {"1 2", JSONReader::JSON_SYNTAX_ERROR},
+      {"[1]]", JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT},
+      {"[1,]", JSONReader::JSON_TRAILING_COMMA},
+      {"[1,,2]", JSONReader::JSON_UNEXPECTED_TOKEN},
+      {"{a: 1}", JSONReader::JSON_UNQUOTED_DICTIONARY_KEY},
+      {"{\"a\" 1}", JSONReader::JSON_SYNTAX_ERROR},
+      {"\"open", JSONReader::JSON_SYNTAX_ERROR},
+      {"\"\\q\"", JSONReader::JSON_INVALID_ESCAPE},
+      {"\"\\ud800\"", JSONReader::JSON_INVALID_ESCAPE},
+      {"\"\\u12\"", JSONReader::JSON_INVALID_ESCAPE},
+      {"\"\xFF\"", JSONReader::JSON_UNSUPPORTED_ENCODING},
+      {"\"\xC3\"", JSONReader::JSON_UNSUPPORTED_ENCODING},
+      {"\"\xED\xA0\x80\"", JSONReader::JSON_UNSUPPORTED_ENCODING},
+  };
+  for (const auto& test_case : kCases) {
+    JSONSAXParser parser(JSON_PARSE_RFC);
+    RecordingHandler handler;
+    EXPECT_FALSE(parser.Parse(test_case.input, &handler)) << test_case.input;
+    EXPECT_EQ(test_case.error, parser.error_code()) << test_case.input;
+  }
+}
+
+TEST(JSONSAXParserTest, ErrorPosition) {
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  EXPECT_FALSE(parser.ParseToValue("{\n  \"a\": 1,\r\n  \"b\" 2\n}"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, parser.error_code());
+  EXPECT_EQ(3, parser.error_line());
+  EXPECT_EQ(7, parser.error_column());
+  EXPECT_EQ("Line: 3, column: 7, Syntax error.", parser.GetErrorMessage());
+
+  // A successful parse clears the error.
+  EXPECT_TRUE(parser.ParseToValue("1"));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, parser.error_code());
+  EXPECT_EQ(0, parser.error_line());
+  EXPECT_EQ("", parser.GetErrorMessage());
+}
+
+TEST(JSONSAXParserTest, Nesting) {
+  // Same limit as JSONParser.
+  std::string ok = std::string(99, '[') + std::string(99, ']');
+  std::string too_deep = std::string(100, '[') + std::string(100, ']');
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  EXPECT_TRUE(parser.ParseToValue(ok));
+  EXPECT_FALSE(parser.ParseToValue(too_deep));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, parser.error_code());
+}
+
+TEST(JSONSAXParserTest, HandlerStopsParse) {
+  JSONSAXParser parser(JSON_PARSE_RFC);
+  RecordingHandler handler;
+  handler.set_events_left(3);
+  EXPECT_FALSE(parser.Parse("[1, 2, 3, 4]", &handler));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, parser.error_code());
+  EXPECT_EQ("[ 1 2", handler.events());
+}
+
+TEST(JSONSAXParserTest, JSONReaderOptions) {
+  int error_code = 0;
+  std::string error_message;
+  std::unique_ptr<Value> value = JSONReader::ReadAndReturnError(
+      "[1, 2, ]", JSON_USE_SAX_PARSER, &error_code, &error_message);
+  EXPECT_FALSE(value);
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, error_code);
+  EXPECT_EQ("Line: 1, column: 8, Trailing comma not allowed.", error_message);
+
+  value = JSONReader::Read("[1, 2, ]",
+                           JSON_USE_SAX_PARSER | JSON_ALLOW_TRAILING_COMMAS);
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(value->Equals(JSONReader::Read("[1, 2]").get()));
+
+  JSONReader reader(JSON_USE_SAX_PARSER);
+  EXPECT_TRUE(reader.ReadToValue("{\"a\": [true]}"));
+  EXPECT_FALSE(reader.ReadToValue("{\"a\": [true}"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, reader.error_code());
+
+  RecordingHandler handler;
+  EXPECT_TRUE(JSONReader::ReadWithHandler("{\"a\": [true]}", JSON_PARSE_RFC,
+                                          &handler, nullptr, nullptr));
+  EXPECT_EQ("{ a: [ true ] }", handler.events());
+}
+
+}  // namespace internal
+}  // namespace base
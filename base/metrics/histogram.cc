@@ -25,6 +25,7 @@
 #include "base/metrics/persistent_memory_allocator.h"
 #include "base/metrics/sample_vector.h"
 #include "base/metrics/statistics_recorder.h"
+#include "base/metrics/thread_local_sample_buffers.h"
 #include "base/pickle.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
@@ -429,7 +430,13 @@ void Histogram::AddCount(int value, int count) {
     NOTREACHED();
     return;
   }
-  samples_->Accumulate(value, count);
+  if (flags() & kThreadLocalSamples) {
+    ThreadLocalSampleBuffers::Accumulate(&thread_local_samples_id_,
+                                         samples_.get(), bucket_ranges(), value,
+                                         count);
+  } else {
+    samples_->Accumulate(value, count);
+  }
 
   FindAndRunCallback(value);
 }
@@ -531,6 +538,7 @@ Histogram::Histogram(const std::string& name,
 }
 
 Histogram::~Histogram() {
+  ThreadLocalSampleBuffers::Forget(thread_local_samples_id_);
 }
 
 bool Histogram::PrintEmptyBucket(uint32_t index) const {
@@ -584,6 +592,9 @@ HistogramBase* Histogram::DeserializeInfoImpl(PickleIterator* iter) {
 }
 
 std::unique_ptr<SampleVector> Histogram::SnapshotSampleVector() const {
+  // Samples that threads recorded into buffers of their own only count once
+  // they are merged.
+  ThreadLocalSampleBuffers::Merge(thread_local_samples_id_);
   std::unique_ptr<SampleVector> samples(
       new SampleVector(samples_->id(), bucket_ranges()));
   samples->Add(*samples_);
@@ -84,6 +84,7 @@
 // TODO(asvitkine): Migrate callers to to include this directly and remove this.
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/histogram_samples.h"
+#include "base/metrics/thread_local_sample_buffers.h"
 #include "base/time/time.h"
 
 namespace base {
@@ -318,6 +319,10 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // used to DCHECK that a final delta is not created multiple times.
   mutable bool final_delta_created_ = false;
 
+  // Identifies the per-thread buffers that samples are recorded into when the
+  // kThreadLocalSamples flag is set.
+  ThreadLocalSampleBuffers::Id thread_local_samples_id_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
@@ -122,6 +122,14 @@ class BASE_EXPORT HistogramBase {
     // histogram is created.
     kIsPersistent = 0x40,
 
+    // Only for Histogram and its sub classes: each thread records samples
+    // into a buffer of its own, which is merged into the histogram when it is
+    // snapshotted and when the thread exits. This avoids contention on
+    // histograms that many threads record into at once, at the cost of memory
+    // per thread and of samples showing up, including in persistent memory,
+    // only once merged.
+    kThreadLocalSamples = 0x80,
+
     // Only for Histogram and its sub classes: fancy bucket-naming support.
     kHexRangePrintingFlag = 0x8000,
   };
@@ -0,0 +1,134 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures how histogram lookups and samples scale with the number of threads
+// recording them at the same time.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kHistogramCount = 2000;
+const int kLookupsPerThread = 200000;
+const int kSamplesPerThread = 1000000;
+const size_t kThreadCounts[] = {1, 2, 4, 8, 16, 32};
+
+// Runs |operation| on |thread_count| threads started at the same time, and
+// returns the wall time it took all of them to finish.
+class ContendedRun : public DelegateSimpleThread::Delegate {
+ public:
+  explicit ContendedRun(const Closure& operation)
+      : operation_(operation), start_(true, false) {}
+
+  TimeDelta Run(size_t thread_count) {
+    std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+    for (size_t i = 0; i < thread_count; i++) {
+      threads.push_back(
+          WrapUnique(new DelegateSimpleThread(this, "HistogramPerfTest")));
+      threads.back()->Start();
+    }
+    TimeTicks start = TimeTicks::Now();
+    start_.Signal();
+    for (const auto& thread : threads)
+      thread->Join();
+    return TimeTicks::Now() - start;
+  }
+
+  // DelegateSimpleThread::Delegate:
+  void Run() override {
+    start_.Wait();
+    operation_.Run();
+  }
+
+ private:
+  const Closure operation_;
+  WaitableEvent start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContendedRun);
+};
+
+void LookUpHistograms(const std::vector<std::string>* names) {
+  for (int i = 0; i < kLookupsPerThread; i++) {
+    if (!StatisticsRecorder::FindHistogram((*names)[i % names->size()]))
+      ADD_FAILURE();
+  }
+}
+
+void AddSamples(HistogramBase* histogram) {
+  for (int i = 0; i < kSamplesPerThread; i++)
+    histogram->Add(i & 1023);
+}
+
+class HistogramPerfTest : public testing::Test {
+ protected:
+  void SetUp() override { StatisticsRecorder::Initialize(); }
+};
+
+TEST_F(HistogramPerfTest, FindHistogram) {
+  std::vector<std::string> names;
+  for (int i = 0; i < kHistogramCount; i++) {
+    names.push_back(StringPrintf("HistogramPerfTest.Lookup%d", i));
+    Histogram::FactoryGet(names.back(), 1, 1000, 50, HistogramBase::kNoFlags);
+  }
+
+  for (size_t thread_count : kThreadCounts) {
+    TimeDelta elapsed =
+        ContendedRun(Bind(&LookUpHistograms, Unretained(&names)))
+            .Run(thread_count);
+    perf_test::PrintResult(
+        "find_histogram", "", StringPrintf("%zu_threads", thread_count),
+        elapsed.InMicroseconds() * 1000.0 / (kLookupsPerThread * thread_count),
+        "ns", true);
+  }
+}
+
+TEST_F(HistogramPerfTest, AddSamples) {
+  struct {
+    const char* name;
+    int32_t flags;
+  } const kModes[] = {
+      {"shared", HistogramBase::kNoFlags},
+      {"thread_local", HistogramBase::kThreadLocalSamples},
+  };
+  for (const auto& mode : kModes) {
+    for (size_t thread_count : kThreadCounts) {
+      HistogramBase* histogram = Histogram::FactoryGet(
+          StringPrintf("HistogramPerfTest.%s%zu", mode.name, thread_count), 1,
+          1000, 50, mode.flags);
+      TimeDelta elapsed =
+          ContendedRun(Bind(&AddSamples, Unretained(histogram)))
+              .Run(thread_count);
+      EXPECT_EQ(static_cast<int>(kSamplesPerThread * thread_count),
+                histogram->SnapshotSamples()->TotalCount());
+      perf_test::PrintResult(
+          "histogram_add", StringPrintf("_%s", mode.name),
+          StringPrintf("%zu_threads", thread_count),
+          elapsed.InMicroseconds() * 1000.0 /
+              (kSamplesPerThread * thread_count),
+          "ns", true);
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace base
@@ -22,6 +22,8 @@
 #include "base/metrics/statistics_recorder.h"
 #include "base/pickle.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -92,6 +94,43 @@ class HistogramTest : public testing::TestWithParam<bool> {
 // Run all HistogramTest cases with both heap and persistent memory.
 INSTANTIATE_TEST_CASE_P(HeapAndPersistent, HistogramTest, testing::Bool());
 
+// Records |count| samples of |value| into |histogram|, then waits until it is
+// told to exit.
+class RecordingThread : public SimpleThread {
+ public:
+  RecordingThread(HistogramBase* histogram, int value, int count)
+      : SimpleThread("RecordingThread"),
+        histogram_(histogram),
+        value_(value),
+        count_(count),
+        recorded_(true, false),
+        exit_(true, false) {}
+
+  void WaitUntilRecorded() { recorded_.Wait(); }
+
+  void ExitAndJoin() {
+    exit_.Signal();
+    Join();
+  }
+
+  // SimpleThread:
+  void Run() override {
+    for (int i = 0; i < count_; i++)
+      histogram_->Add(value_);
+    recorded_.Signal();
+    exit_.Wait();
+  }
+
+ private:
+  HistogramBase* const histogram_;
+  const int value_;
+  const int count_;
+  WaitableEvent recorded_;
+  WaitableEvent exit_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingThread);
+};
+
 
 // Check for basic syntax and use.
 TEST_P(HistogramTest, BasicTest) {
@@ -202,6 +241,56 @@ TEST_P(HistogramTest, FinalDeltaTest) {
   EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
 }
 
+// Check that samples recorded into thread-local buffers show up in snapshots,
+// both while the threads that recorded them run and after they exit.
+TEST_P(HistogramTest, ThreadLocalSamplesTest) {
+  HistogramBase* histogram =
+      Histogram::FactoryGet("ThreadLocalHistogram", 1, 64, 8,
+                            HistogramBase::kThreadLocalSamples);
+  histogram->Add(1);
+  histogram->Add(10);
+
+  std::unique_ptr<HistogramSamples> samples = histogram->SnapshotDelta();
+  EXPECT_EQ(2, samples->TotalCount());
+  EXPECT_EQ(1, samples->GetCount(1));
+  EXPECT_EQ(1, samples->GetCount(10));
+  EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
+
+  RecordingThread thread1(histogram, 50, 3);
+  RecordingThread thread2(histogram, 1, 2);
+  thread1.Start();
+  thread2.Start();
+  thread1.WaitUntilRecorded();
+  thread2.WaitUntilRecorded();
+  histogram->Add(10);
+
+  samples = histogram->SnapshotDelta();
+  EXPECT_EQ(6, samples->TotalCount());
+  EXPECT_EQ(3, samples->GetCount(50));
+  EXPECT_EQ(2, samples->GetCount(1));
+  EXPECT_EQ(1, samples->GetCount(10));
+  EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
+
+  samples = histogram->SnapshotDelta();
+  EXPECT_EQ(0, samples->TotalCount());
+
+  // What a thread records before exiting is merged when it exits, even though
+  // its buffer goes away.
+  RecordingThread thread3(histogram, 20, 4);
+  thread3.Start();
+  thread3.WaitUntilRecorded();
+  thread3.ExitAndJoin();
+  thread1.ExitAndJoin();
+  thread2.ExitAndJoin();
+
+  samples = histogram->SnapshotSamples();
+  EXPECT_EQ(12, samples->TotalCount());
+  EXPECT_EQ(4, samples->GetCount(20));
+  samples = histogram->SnapshotDelta();
+  EXPECT_EQ(4, samples->TotalCount());
+  EXPECT_EQ(4, samples->GetCount(20));
+}
+
 TEST_P(HistogramTest, ExponentialRangesTest) {
   // Check that we got a nice exponential when there was enough room.
   BucketRanges ranges(9);
@@ -22,7 +22,9 @@ namespace base {
 class PersistentSampleMapRecords;
 class PersistentSparseHistogramDataManager;
 
-// Feature definition for enabling histogram persistence.
+// Feature definition for enabling histogram persistence. Besides keeping the
+// browser's histograms in persistent memory, this has child processes store
+// theirs in memory shared with the browser rather than sending them over IPC.
 BASE_EXPORT extern const Feature kPersistentHistogramsFeature;
 
 
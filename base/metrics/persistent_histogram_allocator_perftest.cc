@@ -0,0 +1,232 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the two ways the histograms of many child processes reach the
+// browser: as pickled deltas sent over IPC, which is what
+// HistogramDeltaSerialization does, and read in place from a memory segment
+// that each child shares with the browser, which is what
+// SubprocessMetricsProvider does. Each simulated child has a segment of its
+// own, and changes every histogram in every cycle; the numbers are per
+// reporting cycle, for all children.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_delta_serialization.h"
+#include "base/metrics/histogram_flattener.h"
+#include "base/metrics/histogram_snapshot_manager.h"
+#include "base/metrics/persistent_histogram_allocator.h"
+#include "base/metrics/persistent_memory_allocator.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/pickle.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kChildren = 60;
+const int kHistogramsPerChild = 250;
+const int kSamplesPerHistogram = 20;
+const int kCycles = 5;
+const size_t kSegmentSize = 1 << 20;  // 1 MiB
+
+// Pickles each delta the way HistogramDeltaSerialization does, or just counts
+// them when |deltas| is null.
+class DeltaFlattener : public HistogramFlattener {
+ public:
+  explicit DeltaFlattener(std::vector<std::string>* deltas)
+      : deltas_(deltas), delta_count_(0) {}
+
+  int delta_count() const { return delta_count_; }
+
+  // HistogramFlattener:
+  void RecordDelta(const HistogramBase& histogram,
+                   const HistogramSamples& snapshot) override {
+    delta_count_++;
+    if (!deltas_)
+      return;
+    Pickle pickle;
+    histogram.SerializeInfo(&pickle);
+    snapshot.Serialize(&pickle);
+    deltas_->push_back(
+        std::string(static_cast<const char*>(pickle.data()), pickle.size()));
+  }
+  void InconsistencyDetected(HistogramBase::Inconsistency problem) override {}
+  void UniqueInconsistencyDetected(
+      HistogramBase::Inconsistency problem) override {}
+  void InconsistencyDetectedInLoggedCount(int amount) override {}
+
+ private:
+  std::vector<std::string>* const deltas_;
+  int delta_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeltaFlattener);
+};
+
+// A child process with its histograms in a segment of its own.
+class ChildProcess {
+ public:
+  ChildProcess(int id, const BucketRanges* ranges)
+      : allocator_(WrapUnique(
+            new LocalPersistentMemoryAllocator(kSegmentSize, id, "Child"))) {
+    for (int i = 0; i < kHistogramsPerChild; i++) {
+      PersistentHistogramAllocator::Reference ref;
+      histograms_.push_back(allocator_.AllocateHistogram(
+          HISTOGRAM, StringPrintf("Child.Histogram%d", i), 1, 10000, ranges,
+          HistogramBase::kUmaTargetedHistogramFlag, &ref));
+      allocator_.FinalizeHistogram(ref, true);
+    }
+  }
+
+  // Records some samples into every histogram.
+  void RecordSamples(int cycle) {
+    for (const auto& histogram : histograms_) {
+      for (int i = 0; i < kSamplesPerHistogram; i++)
+        histogram->Add((cycle * 97 + i * 31) % 10000);
+    }
+  }
+
+  // Serializes what changed since the last call, like the child side of
+  // HistogramSynchronizer does.
+  void SerializeDeltas(std::vector<std::string>* deltas) {
+    DeltaFlattener flattener(deltas);
+    HistogramSnapshotManager snapshot_manager(&flattener);
+    snapshot_manager.StartDeltas();
+    for (const auto& histogram : histograms_)
+      snapshot_manager.PrepareDelta(histogram.get());
+    snapshot_manager.FinishDeltas();
+  }
+
+  // Returns an allocator on the child's segment, like the one the browser
+  // has.
+  std::unique_ptr<PersistentHistogramAllocator> CreateBrowserAllocator() {
+    return WrapUnique(new PersistentHistogramAllocator(
+        WrapUnique(new PersistentMemoryAllocator(
+            const_cast<void*>(allocator_.data()), allocator_.length(), 0,
+            allocator_.Id(), "", false))));
+  }
+
+ private:
+  PersistentHistogramAllocator allocator_;
+  std::vector<std::unique_ptr<HistogramBase>> histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChildProcess);
+};
+
+class ChildHistogramPerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    StatisticsRecorder::Initialize();
+    BucketRanges* ranges = new BucketRanges(51);
+    Histogram::InitializeBucketRanges(1, 10000, ranges);
+    const BucketRanges* registered_ranges =
+        StatisticsRecorder::RegisterOrDeleteDuplicateRanges(ranges);
+    for (int i = 0; i < kChildren; i++)
+      children_.push_back(
+          WrapUnique(new ChildProcess(i + 1, registered_ranges)));
+  }
+
+  std::vector<std::unique_ptr<ChildProcess>> children_;
+};
+
+TEST_F(ChildHistogramPerfTest, Ipc) {
+  TimeDelta child_time;
+  TimeDelta browser_time;
+  size_t bytes = 0;
+  int browser_deltas = 0;
+  for (int cycle = 0; cycle < kCycles; cycle++) {
+    for (const auto& child : children_)
+      child->RecordSamples(cycle);
+
+    std::vector<std::vector<std::string>> deltas(children_.size());
+    TimeTicks start = TimeTicks::Now();
+    for (size_t i = 0; i < children_.size(); i++)
+      children_[i]->SerializeDeltas(&deltas[i]);
+    child_time += TimeTicks::Now() - start;
+    for (const auto& child_deltas : deltas) {
+      for (const std::string& delta : child_deltas)
+        bytes += delta.size();
+    }
+
+    // The browser merges the deltas into histograms of its own, and then
+    // snapshots those for the log.
+    start = TimeTicks::Now();
+    for (const auto& child_deltas : deltas)
+      HistogramDeltaSerialization::DeserializeAndAddSamples(child_deltas);
+    DeltaFlattener flattener(nullptr);
+    HistogramSnapshotManager snapshot_manager(&flattener);
+    snapshot_manager.PrepareDeltas(StatisticsRecorder::begin(false),
+                                   StatisticsRecorder::end(),
+                                   HistogramBase::kNoFlags,
+                                   HistogramBase::kUmaTargetedHistogramFlag);
+    browser_time += TimeTicks::Now() - start;
+    browser_deltas += flattener.delta_count();
+  }
+  // The browser's own histograms may add a few deltas.
+  EXPECT_LE(kCycles * kHistogramsPerChild, browser_deltas);
+
+  perf_test::PrintResult("child_histograms_bytes", "", "ipc", bytes / kCycles,
+                         "bytes", true);
+  perf_test::PrintResult(
+      "child_histograms_child_time", "", "ipc",
+      child_time.InMicroseconds() / static_cast<double>(kCycles), "us", true);
+  perf_test::PrintResult(
+      "child_histograms_browser_time", "", "ipc",
+      browser_time.InMicroseconds() / static_cast<double>(kCycles), "us",
+      true);
+}
+
+TEST_F(ChildHistogramPerfTest, SharedMemory) {
+  std::vector<std::unique_ptr<PersistentHistogramAllocator>> allocators;
+  for (const auto& child : children_)
+    allocators.push_back(child->CreateBrowserAllocator());
+
+  TimeDelta browser_time;
+  int browser_deltas = 0;
+  for (int cycle = 0; cycle < kCycles; cycle++) {
+    for (const auto& child : children_)
+      child->RecordSamples(cycle);
+
+    // The browser snapshots every child's histograms in place.
+    TimeTicks start = TimeTicks::Now();
+    DeltaFlattener flattener(nullptr);
+    HistogramSnapshotManager snapshot_manager(&flattener);
+    snapshot_manager.StartDeltas();
+    for (const auto& allocator : allocators) {
+      PersistentHistogramAllocator::Iterator iter(allocator.get());
+      while (std::unique_ptr<HistogramBase> histogram = iter.GetNext())
+        snapshot_manager.PrepareDeltaTakingOwnership(std::move(histogram));
+    }
+    snapshot_manager.FinishDeltas();
+    browser_time += TimeTicks::Now() - start;
+    browser_deltas += flattener.delta_count();
+  }
+  // Deltas of histograms with the same name are merged, as in the IPC case.
+  EXPECT_EQ(kCycles * kHistogramsPerChild, browser_deltas);
+
+  perf_test::PrintResult("child_histograms_bytes", "", "shared_memory",
+                         static_cast<size_t>(0), "bytes", true);
+  perf_test::PrintResult("child_histograms_child_time", "", "shared_memory",
+                         0.0, "us", true);
+  perf_test::PrintResult(
+      "child_histograms_browser_time", "", "shared_memory",
+      browser_time.InMicroseconds() / static_cast<double>(kCycles), "us",
+      true);
+}
+
+}  // namespace
+
+}  // namespace base
@@ -8,6 +8,7 @@
 
 #include "base/at_exit.h"
 #include "base/debug/leak_annotations.h"
+#include "base/hash.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
@@ -29,10 +30,108 @@ bool HistogramNameLesser(const base::HistogramBase* a,
   return a->histogram_name() < b->histogram_name();
 }
 
+// The number of slots the histogram index starts with. Processes register a
+// few hundred histograms early on.
+const size_t kInitialIndexCapacity = 512;
+
 }  // namespace
 
 namespace base {
 
+// An open-addressed hash table of histograms, keyed by the hash of their
+// names. Adding to it and removing from it happen under |lock_|, but looking
+// it up does not: a slot, once taken, is never emptied or reused, and its hash
+// is stored before its histogram is released, so a reader that sees a
+// histogram in a slot also sees its hash. A removed histogram leaves a marker
+// in its slot. When the table is full, a larger copy replaces it, and the old
+// one is leaked since readers may still be probing it.
+class StatisticsRecorder::HistogramIndex {
+ public:
+  // |capacity| must be a power of two.
+  explicit HistogramIndex(size_t capacity)
+      : slots_(new Slot[capacity]), capacity_(capacity), used_(0) {
+    DCHECK_EQ(0u, capacity & (capacity - 1));
+  }
+
+  // Returns the histogram named |name|, whose hash is |hash|, or NULL. This
+  // method is thread safe.
+  HistogramBase* Find(uint32_t hash, StringPiece name) const {
+    for (size_t i = hash & (capacity_ - 1);; i = (i + 1) & (capacity_ - 1)) {
+      const Slot& slot = slots_[i];
+      HistogramBase* histogram = reinterpret_cast<HistogramBase*>(
+          subtle::Acquire_Load(&slot.histogram));
+      if (!histogram)
+        return NULL;
+      if (histogram != Removed() && slot.hash == hash &&
+          histogram->histogram_name() == name) {
+        return histogram;
+      }
+    }
+  }
+
+  // Adds |histogram|, unless the table is too full to take it, in which case
+  // it returns false.
+  bool Insert(HistogramBase* histogram) {
+    if ((used_ + 1) * 2 > capacity_)
+      return false;
+    uint32_t hash = Hash(histogram->histogram_name());
+    size_t i = hash & (capacity_ - 1);
+    while (subtle::NoBarrier_Load(&slots_[i].histogram))
+      i = (i + 1) & (capacity_ - 1);
+    slots_[i].hash = hash;
+    subtle::Release_Store(&slots_[i].histogram,
+                          reinterpret_cast<subtle::AtomicWord>(histogram));
+    used_++;
+    return true;
+  }
+
+  // Replaces |histogram| with a marker that lookups skip. Its slot stays
+  // taken until the table is grown.
+  void Remove(HistogramBase* histogram) {
+    for (size_t i = 0; i < capacity_; i++) {
+      if (subtle::NoBarrier_Load(&slots_[i].histogram) ==
+          reinterpret_cast<subtle::AtomicWord>(histogram)) {
+        subtle::Release_Store(&slots_[i].histogram,
+                              reinterpret_cast<subtle::AtomicWord>(Removed()));
+        return;
+      }
+    }
+  }
+
+  // Returns a copy of this table with twice the capacity and without the
+  // markers of removed histograms.
+  std::unique_ptr<HistogramIndex> Grow() const {
+    std::unique_ptr<HistogramIndex> index(new HistogramIndex(capacity_ * 2));
+    for (size_t i = 0; i < capacity_; i++) {
+      HistogramBase* histogram = reinterpret_cast<HistogramBase*>(
+          subtle::NoBarrier_Load(&slots_[i].histogram));
+      if (histogram && histogram != Removed())
+        index->Insert(histogram);
+    }
+    return index;
+  }
+
+ private:
+  struct Slot {
+    Slot() : hash(0), histogram(0) {}
+
+    uint32_t hash;
+    subtle::AtomicWord histogram;
+  };
+
+  static HistogramBase* Removed() {
+    return reinterpret_cast<HistogramBase*>(1);
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  const size_t capacity_;
+
+  // The number of taken slots, including those of removed histograms.
+  size_t used_;
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramIndex);
+};
+
 StatisticsRecorder::HistogramIterator::HistogramIterator(
     const HistogramMap::iterator& iter, bool include_persistent)
     : iter_(iter),
@@ -88,6 +187,8 @@ StatisticsRecorder::~StatisticsRecorder() {
   histograms_ = existing_histograms_.release();
   callbacks_ = existing_callbacks_.release();
   ranges_ = existing_ranges_.release();
+  subtle::Release_Store(
+      &index_, reinterpret_cast<subtle::AtomicWord>(existing_index_.release()));
 }
 
 // static
@@ -131,6 +232,7 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
         // making a copy.
         (*histograms_)[name] = histogram;
         ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
+        AddToIndex(histogram);
         // If there are callbacks for this histogram, we set the kCallbackExists
         // flag.
         auto callback_iterator = callbacks_->find(name);
@@ -300,16 +402,14 @@ HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
   // will acquire the lock at that time.
   ImportGlobalPersistentHistograms();
 
-  if (lock_ == NULL)
-    return NULL;
-  base::AutoLock auto_lock(*lock_);
-  if (histograms_ == NULL)
-    return NULL;
-
-  HistogramMap::iterator it = histograms_->find(name);
-  if (histograms_->end() == it)
+  // A histogram that is being registered may not be in the index yet; callers
+  // that create it if it's missing end up in RegisterOrDeleteDuplicate(),
+  // which finds it under the lock.
+  const HistogramIndex* index =
+      reinterpret_cast<const HistogramIndex*>(subtle::Acquire_Load(&index_));
+  if (index == NULL)
     return NULL;
-  return it->second;
+  return index->Find(Hash(name.data(), name.size()), name);
 }
 
 // static
@@ -416,8 +516,15 @@ size_t StatisticsRecorder::GetHistogramCount() {
 
 // static
 void StatisticsRecorder::ForgetHistogramForTesting(base::StringPiece name) {
-  if (histograms_)
-    histograms_->erase(name);
+  if (!histograms_)
+    return;
+
+  HistogramMap::iterator it = histograms_->find(name);
+  if (it == histograms_->end())
+    return;
+  reinterpret_cast<HistogramIndex*>(subtle::NoBarrier_Load(&index_))
+      ->Remove(it->second);
+  histograms_->erase(it);
 }
 
 // static
@@ -451,6 +558,23 @@ void StatisticsRecorder::ImportGlobalPersistentHistograms() {
     allocator->ImportHistogramsToStatisticsRecorder();
 }
 
+// static
+void StatisticsRecorder::AddToIndex(HistogramBase* histogram) {
+  lock_->AssertAcquired();
+  HistogramIndex* index =
+      reinterpret_cast<HistogramIndex*>(subtle::NoBarrier_Load(&index_));
+  if (index->Insert(histogram))
+    return;
+
+  // Other threads may still be looking up the full index, so it is leaked
+  // rather than deleted once the larger one replaces it.
+  std::unique_ptr<HistogramIndex> larger_index = index->Grow();
+  CHECK(larger_index->Insert(histogram));
+  ANNOTATE_LEAKING_OBJECT_PTR(index);
+  subtle::Release_Store(
+      &index_, reinterpret_cast<subtle::AtomicWord>(larger_index.release()));
+}
+
 // This singleton instance should be started during the single threaded portion
 // of main(), and hence it is not thread safe.  It initializes globals to
 // provide support for all future calls.
@@ -470,10 +594,15 @@ StatisticsRecorder::StatisticsRecorder() {
   existing_histograms_.reset(histograms_);
   existing_callbacks_.reset(callbacks_);
   existing_ranges_.reset(ranges_);
+  existing_index_.reset(
+      reinterpret_cast<HistogramIndex*>(subtle::NoBarrier_Load(&index_)));
 
   histograms_ = new HistogramMap;
   callbacks_ = new CallbackMap;
   ranges_ = new RangesMap;
+  subtle::Release_Store(
+      &index_, reinterpret_cast<subtle::AtomicWord>(
+                   new HistogramIndex(kInitialIndexCapacity)));
 
   if (VLOG_IS_ON(1))
     AtExitManager::RegisterCallback(&DumpHistogramsToVlog, this);
@@ -488,6 +617,7 @@ void StatisticsRecorder::Reset() {
   std::unique_ptr<HistogramMap> histograms_deleter;
   std::unique_ptr<CallbackMap> callbacks_deleter;
   std::unique_ptr<RangesMap> ranges_deleter;
+  std::unique_ptr<HistogramIndex> index_deleter;
   // We don't delete lock_ on purpose to avoid having to properly protect
   // against it going away after we checked for NULL in the static methods.
   {
@@ -495,9 +625,12 @@ void StatisticsRecorder::Reset() {
     histograms_deleter.reset(histograms_);
     callbacks_deleter.reset(callbacks_);
     ranges_deleter.reset(ranges_);
+    index_deleter.reset(
+        reinterpret_cast<HistogramIndex*>(subtle::NoBarrier_Load(&index_)));
     histograms_ = NULL;
     callbacks_ = NULL;
     ranges_ = NULL;
+    subtle::NoBarrier_Store(&index_, 0);
   }
   // We are going to leak the histograms and the ranges.
 }
@@ -517,6 +650,8 @@ StatisticsRecorder::CallbackMap* StatisticsRecorder::callbacks_ = NULL;
 // static
 StatisticsRecorder::RangesMap* StatisticsRecorder::ranges_ = NULL;
 // static
+subtle::AtomicWord StatisticsRecorder::index_ = 0;
+// static
 base::Lock* StatisticsRecorder::lock_ = NULL;
 
 }  // namespace base
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/callback.h"
 #include "base/gtest_prod_util.h"
@@ -131,7 +132,9 @@ class BASE_EXPORT StatisticsRecorder {
   static void GetBucketRanges(std::vector<const BucketRanges*>* output);
 
   // Find a histogram by name. It matches the exact name. This method is thread
-  // safe.  It returns NULL if a matching histogram is not found.
+  // safe, and does not take a lock, so that threads looking up histograms
+  // don't contend with each other.  It returns NULL if a matching histogram is
+  // not found.
   static HistogramBase* FindHistogram(base::StringPiece name);
 
   // Support for iterating over known histograms.
@@ -184,6 +187,10 @@ class BASE_EXPORT StatisticsRecorder {
   // |bucket_ranges_|.
   typedef std::map<uint32_t, std::list<const BucketRanges*>*> RangesMap;
 
+  // An index of |histograms_| by the hash of their names, which FindHistogram()
+  // looks up without taking |lock_|.
+  class HistogramIndex;
+
   friend struct DefaultLazyInstanceTraits<StatisticsRecorder>;
   friend class HistogramBaseTest;
   friend class HistogramSnapshotManagerTest;
@@ -199,6 +206,10 @@ class BASE_EXPORT StatisticsRecorder {
   // not be held during this call.
   static void ImportGlobalPersistentHistograms();
 
+  // Adds |histogram| to the index, growing it if it is full. The global lock
+  // must be held during this call.
+  static void AddToIndex(HistogramBase* histogram);
+
   // The constructor just initializes static members. Usually client code should
   // use Initialize to do this. But in test code, you can friend this class and
   // call the constructor to get a clean StatisticsRecorder.
@@ -210,6 +221,7 @@ class BASE_EXPORT StatisticsRecorder {
   std::unique_ptr<HistogramMap> existing_histograms_;
   std::unique_ptr<CallbackMap> existing_callbacks_;
   std::unique_ptr<RangesMap> existing_ranges_;
+  std::unique_ptr<HistogramIndex> existing_index_;
 
   static void Reset();
   static void DumpHistogramsToVlog(void* instance);
@@ -218,6 +230,10 @@ class BASE_EXPORT StatisticsRecorder {
   static CallbackMap* callbacks_;
   static RangesMap* ranges_;
 
+  // The HistogramIndex of |histograms_|. It is only replaced, and only added
+  // to, while holding |lock_|, but is read without it.
+  static subtle::AtomicWord index_;
+
   // Lock protects access to above maps.
   static base::Lock* lock_;
 
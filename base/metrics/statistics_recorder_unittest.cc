@@ -14,6 +14,7 @@
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/sparse_histogram.h"
+#include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -212,6 +213,42 @@ TEST_P(StatisticsRecorderTest, FindHistogram) {
   EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
 }
 
+TEST_P(StatisticsRecorderTest, FindManyHistograms) {
+  // Register enough histograms that the index has to grow a few times.
+  const int kHistogramCount = 5000;
+  std::vector<HistogramBase*> histograms;
+  for (int i = 0; i < kHistogramCount; i++) {
+    histograms.push_back(StatisticsRecorder::RegisterOrDeleteDuplicate(
+        CreateHistogram(StringPrintf("TestHistogram%d", i), 1, 1000, 10)));
+  }
+
+  EXPECT_EQ(static_cast<size_t>(kHistogramCount),
+            StatisticsRecorder::GetHistogramCount());
+  for (int i = 0; i < kHistogramCount; i++) {
+    EXPECT_EQ(histograms[i], StatisticsRecorder::FindHistogram(
+                                 StringPrintf("TestHistogram%d", i)));
+  }
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
+}
+
+TEST_P(StatisticsRecorderTest, ForgetHistogram) {
+  HistogramBase* histogram1 = StatisticsRecorder::RegisterOrDeleteDuplicate(
+      CreateHistogram("TestHistogram1", 1, 1000, 10));
+  HistogramBase* histogram2 = StatisticsRecorder::RegisterOrDeleteDuplicate(
+      CreateHistogram("TestHistogram2", 1, 1000, 10));
+
+  StatisticsRecorder::ForgetHistogramForTesting("TestHistogram1");
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram1"));
+  EXPECT_EQ(histogram2, StatisticsRecorder::FindHistogram("TestHistogram2"));
+
+  // A histogram of the same name can be registered again.
+  HistogramBase* histogram3 = StatisticsRecorder::RegisterOrDeleteDuplicate(
+      CreateHistogram("TestHistogram1", 1, 1000, 10));
+  EXPECT_NE(histogram1, histogram3);
+  EXPECT_EQ(histogram3, StatisticsRecorder::FindHistogram("TestHistogram1"));
+  DeleteHistogram(histogram1);
+}
+
 TEST_P(StatisticsRecorderTest, GetSnapshot) {
   Histogram::FactoryGet("TestHistogram1", 1, 1000, 10, Histogram::kNoFlags);
   Histogram::FactoryGet("TestHistogram2", 1, 1000, 10, Histogram::kNoFlags);
@@ -0,0 +1,182 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/thread_local_sample_buffers.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/metrics/sample_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+
+namespace {
+
+// The samples one thread recorded into one histogram.
+struct Buffer {
+  Buffer(ThreadLocalSampleBuffers::Id id,
+         HistogramSamples* target,
+         const BucketRanges* bucket_ranges)
+      : id(id),
+        target(target),
+        bucket_ranges(bucket_ranges),
+        samples(target->id(), bucket_ranges),
+        merged(target->id(), bucket_ranges) {}
+
+  const ThreadLocalSampleBuffers::Id id;
+
+  // The samples this buffer is merged into, or null once they are gone.
+  HistogramSamples* target;
+  const BucketRanges* const bucket_ranges;
+
+  // Only written by the thread that owns the buffer.
+  SampleVector samples;
+
+  // What has been added to |target| so far.
+  SampleVector merged;
+
+  DISALLOW_COPY_AND_ASSIGN(Buffer);
+};
+
+// The buffers of one thread, indexed by id - 1.
+typedef std::vector<std::unique_ptr<Buffer>> ThreadBuffers;
+
+void DeleteThreadBuffers(void* thread_buffers);
+
+struct Registry {
+  Registry() : thread_buffers(&DeleteThreadBuffers), last_id(0) {}
+
+  // Guards |buffers|, |last_id| and the |target| and |merged| members of every
+  // Buffer.
+  Lock lock;
+
+  // The buffers of every thread, indexed by id - 1.
+  std::vector<std::vector<Buffer*>> buffers;
+
+  // Holds the calling thread's ThreadBuffers.
+  ThreadLocalStorage::Slot thread_buffers;
+
+  ThreadLocalSampleBuffers::Id last_id;
+};
+
+LazyInstance<Registry>::Leaky g_registry = LAZY_INSTANCE_INITIALIZER;
+
+// Adds what |buffer| accumulated since the last call to its target. The
+// registry lock must be held during this call.
+void MergeBuffer(Buffer* buffer) {
+  // The owning thread may be recording into |buffer->samples| meanwhile; what
+  // this misses is picked up by the next merge.
+  if (!buffer->target ||
+      buffer->samples.redundant_count() == buffer->merged.redundant_count()) {
+    return;
+  }
+  SampleVector delta(buffer->target->id(), buffer->bucket_ranges);
+  delta.Add(buffer->samples);
+  delta.Subtract(buffer->merged);
+  buffer->target->Add(delta);
+  buffer->merged.Add(delta);
+}
+
+// Merges the buffers of a thread that is exiting, and deletes them.
+void DeleteThreadBuffers(void* thread_buffers) {
+  std::unique_ptr<ThreadBuffers> buffers(
+      static_cast<ThreadBuffers*>(thread_buffers));
+  Registry* registry = g_registry.Pointer();
+  AutoLock auto_lock(registry->lock);
+  for (const std::unique_ptr<Buffer>& buffer : *buffers) {
+    if (!buffer)
+      continue;
+    MergeBuffer(buffer.get());
+    std::vector<Buffer*>* id_buffers = &registry->buffers[buffer->id - 1];
+    id_buffers->erase(
+        std::remove(id_buffers->begin(), id_buffers->end(), buffer.get()),
+        id_buffers->end());
+  }
+}
+
+// Returns the calling thread's buffer for |id|, creating it and, if this is
+// the first buffer for the histogram, assigning |id|.
+Buffer* CreateBuffer(Registry* registry,
+                     ThreadLocalSampleBuffers::Id* id,
+                     HistogramSamples* samples,
+                     const BucketRanges* bucket_ranges) {
+  AutoLock auto_lock(registry->lock);
+  ThreadLocalSampleBuffers::Id buffer_id = subtle::NoBarrier_Load(id);
+  if (!buffer_id) {
+    buffer_id = ++registry->last_id;
+    registry->buffers.resize(buffer_id);
+    subtle::NoBarrier_Store(id, buffer_id);
+  }
+
+  ThreadBuffers* thread_buffers =
+      static_cast<ThreadBuffers*>(registry->thread_buffers.Get());
+  if (!thread_buffers) {
+    thread_buffers = new ThreadBuffers;
+    registry->thread_buffers.Set(thread_buffers);
+  }
+  size_t index = buffer_id - 1;
+  if (thread_buffers->size() <= index)
+    thread_buffers->resize(index + 1);
+  if (!(*thread_buffers)[index]) {
+    (*thread_buffers)[index].reset(
+        new Buffer(buffer_id, samples, bucket_ranges));
+    registry->buffers[index].push_back((*thread_buffers)[index].get());
+  }
+  return (*thread_buffers)[index].get();
+}
+
+}  // namespace
+
+// static
+void ThreadLocalSampleBuffers::Accumulate(Id* id,
+                                          HistogramSamples* samples,
+                                          const BucketRanges* bucket_ranges,
+                                          HistogramBase::Sample value,
+                                          HistogramBase::Count count) {
+  Registry* registry = g_registry.Pointer();
+  const ThreadBuffers* thread_buffers =
+      static_cast<const ThreadBuffers*>(registry->thread_buffers.Get());
+  // An unassigned |id| wraps around to an index that is never in range.
+  size_t index = static_cast<size_t>(subtle::NoBarrier_Load(id)) - 1;
+  Buffer* buffer = nullptr;
+  if (thread_buffers && index < thread_buffers->size())
+    buffer = (*thread_buffers)[index].get();
+  if (!buffer)
+    buffer = CreateBuffer(registry, id, samples, bucket_ranges);
+  DCHECK_EQ(samples, buffer->target);
+  buffer->samples.Accumulate(value, count);
+}
+
+// static
+void ThreadLocalSampleBuffers::Merge(const Id& id) {
+  Id buffer_id = subtle::NoBarrier_Load(&id);
+  if (!buffer_id)
+    return;
+  Registry* registry = g_registry.Pointer();
+  AutoLock auto_lock(registry->lock);
+  for (Buffer* buffer : registry->buffers[buffer_id - 1])
+    MergeBuffer(buffer);
+}
+
+// static
+void ThreadLocalSampleBuffers::Forget(const Id& id) {
+  Id buffer_id = subtle::NoBarrier_Load(&id);
+  if (!buffer_id)
+    return;
+  Registry* registry = g_registry.Pointer();
+  AutoLock auto_lock(registry->lock);
+  // The threads own the buffers, and delete them when they exit.
+  for (Buffer* buffer : registry->buffers[buffer_id - 1])
+    buffer->target = nullptr;
+  registry->buffers[buffer_id - 1].clear();
+}
+
+}  // namespace base
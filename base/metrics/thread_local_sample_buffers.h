@@ -0,0 +1,55 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ThreadLocalSampleBuffers lets threads record samples into a histogram
+// without all writing to the same counts. Each thread that records into a
+// histogram with the HistogramBase::kThreadLocalSamples flag gets a buffer of
+// its own, which is added to the histogram's samples when the histogram is
+// snapshotted and when the thread exits. Threads that record into the same
+// histogram at the same time then no longer bounce the cache lines holding
+// its counts between them.
+
+#ifndef BASE_METRICS_THREAD_LOCAL_SAMPLE_BUFFERS_H_
+#define BASE_METRICS_THREAD_LOCAL_SAMPLE_BUFFERS_H_
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/metrics/histogram_base.h"
+
+namespace base {
+
+class BucketRanges;
+class HistogramSamples;
+
+class BASE_EXPORT ThreadLocalSampleBuffers {
+ public:
+  // Identifies the buffers of one histogram. It is zero until a thread first
+  // records into the histogram.
+  typedef subtle::Atomic32 Id;
+
+  // Accumulates |count| samples of |value| into the calling thread's buffer
+  // for |id|, creating the buffer if needed. The buffer is added to |samples|,
+  // whose buckets are |bucket_ranges|, when it is merged.
+  static void Accumulate(Id* id,
+                         HistogramSamples* samples,
+                         const BucketRanges* bucket_ranges,
+                         HistogramBase::Sample value,
+                         HistogramBase::Count count);
+
+  // Adds what every thread's buffer for |id| has accumulated since it was
+  // last merged to the samples it was created for.
+  static void Merge(const Id& id);
+
+  // Detaches the buffers for |id| from their samples, which are going away.
+  // Whatever they have not merged yet is dropped.
+  static void Forget(const Id& id);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ThreadLocalSampleBuffers);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_THREAD_LOCAL_SAMPLE_BUFFERS_H_
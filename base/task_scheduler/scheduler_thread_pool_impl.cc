@@ -35,6 +35,11 @@ LazyInstance<ThreadLocalPointer<const SchedulerThreadPool>>::Leaky
 LazyInstance<ThreadLocalPointer<const SchedulerWorkerThread>>::Leaky
     tls_current_worker_thread = LAZY_INSTANCE_INITIALIZER;
 
+// PriorityQueue owned by the current thread, if it is a worker thread of a
+// WORK_STEALING thread pool.
+LazyInstance<ThreadLocalPointer<PriorityQueue>>::Leaky
+    tls_current_local_priority_queue = LAZY_INSTANCE_INITIALIZER;
+
 // A task runner that runs tasks with the PARALLEL ExecutionMode.
 class SchedulerParallelTaskRunner : public TaskRunner {
  public:
@@ -185,7 +190,8 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
   // called with a non-single-threaded Sequence. |shared_priority_queue| is a
   // PriorityQueue whose transactions may overlap with the worker thread's
   // single-threaded PriorityQueue's transactions. |index| will be appended to
-  // this thread's name to uniquely identify it.
+  // this thread's name to uniquely identify it. It is also the index of the
+  // worker thread in |outer->worker_threads_|.
   SchedulerWorkerThreadDelegateImpl(
       SchedulerThreadPoolImpl* outer,
       const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
@@ -197,6 +203,8 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
     return &single_threaded_priority_queue_;
   }
 
+  PriorityQueue* local_priority_queue() { return &local_priority_queue_; }
+
   // SchedulerWorkerThread::Delegate:
   void OnMainEntry(SchedulerWorkerThread* worker_thread) override;
   scoped_refptr<Sequence> GetWork(
@@ -205,12 +213,21 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
   TimeDelta GetSleepTimeout() override;
 
  private:
+  // Pops a Sequence from the local PriorityQueue of another worker thread of
+  // |outer_|. Returns nullptr if all of them are empty.
+  scoped_refptr<Sequence> StealWork();
+
   SchedulerThreadPoolImpl* outer_;
   const ReEnqueueSequenceCallback re_enqueue_sequence_callback_;
 
   // Single-threaded PriorityQueue for the worker thread.
   PriorityQueue single_threaded_priority_queue_;
 
+  // PriorityQueue for the Sequences posted or re-enqueued by the worker thread
+  // when |outer_| is in WORK_STEALING mode. Only the worker thread pushes to
+  // it, but any worker thread of |outer_| can pop from it.
+  PriorityQueue local_priority_queue_;
+
   // True if the last Sequence returned by GetWork() was extracted from
   // |single_threaded_priority_queue_|.
   bool last_sequence_is_single_threaded_ = false;
@@ -232,12 +249,13 @@ std::unique_ptr<SchedulerThreadPoolImpl> SchedulerThreadPoolImpl::Create(
     ThreadPriority thread_priority,
     size_t max_threads,
     IORestriction io_restriction,
+    SchedulingPolicy scheduling_policy,
     const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
     TaskTracker* task_tracker,
     DelayedTaskManager* delayed_task_manager) {
   std::unique_ptr<SchedulerThreadPoolImpl> thread_pool(
-      new SchedulerThreadPoolImpl(name, io_restriction, task_tracker,
-                                  delayed_task_manager));
+      new SchedulerThreadPoolImpl(name, io_restriction, scheduling_policy,
+                                  task_tracker, delayed_task_manager));
   if (thread_pool->Initialize(thread_priority, max_threads,
                               re_enqueue_sequence_callback)) {
     return thread_pool;
@@ -293,6 +311,16 @@ scoped_refptr<TaskRunner> SchedulerThreadPoolImpl::CreateTaskRunnerWithTraits(
 void SchedulerThreadPoolImpl::ReEnqueueSequence(
     scoped_refptr<Sequence> sequence,
     const SequenceSortKey& sequence_sort_key) {
+  // In WORK_STEALING mode, a thread of this pool keeps the Sequence for itself.
+  // Other threads will steal it if they run out of work first.
+  PriorityQueue* const local_priority_queue =
+      GetLocalPriorityQueueForCurrentThread();
+  if (local_priority_queue) {
+    local_priority_queue->BeginTransaction()->Push(std::move(sequence),
+                                                   sequence_sort_key);
+    return;
+  }
+
   shared_priority_queue_.BeginTransaction()->Push(std::move(sequence),
                                                   sequence_sort_key);
 
@@ -344,14 +372,18 @@ void SchedulerThreadPoolImpl::PostTaskWithSequenceNow(
   // in the past).
   DCHECK_LE(task->delayed_run_time, delayed_task_manager_->Now());
 
-  // Because |worker_thread| belongs to this thread pool, we know that the type
-  // of its delegate is SchedulerWorkerThreadDelegateImpl.
-  PriorityQueue* const priority_queue =
-      worker_thread
-          ? static_cast<SchedulerWorkerThreadDelegateImpl*>(
-                worker_thread->delegate())
-                ->single_threaded_priority_queue()
-          : &shared_priority_queue_;
+  PriorityQueue* const local_priority_queue =
+      worker_thread ? nullptr : GetLocalPriorityQueueForCurrentThread();
+  PriorityQueue* priority_queue = &shared_priority_queue_;
+  if (worker_thread) {
+    // Because |worker_thread| belongs to this thread pool, we know that the
+    // type of its delegate is SchedulerWorkerThreadDelegateImpl.
+    priority_queue = static_cast<SchedulerWorkerThreadDelegateImpl*>(
+                         worker_thread->delegate())
+                         ->single_threaded_priority_queue();
+  } else if (local_priority_queue) {
+    priority_queue = local_priority_queue;
+  }
   DCHECK(priority_queue);
 
   const bool sequence_was_empty = sequence->PushTask(std::move(task));
@@ -367,10 +399,19 @@ void SchedulerThreadPoolImpl::PostTaskWithSequenceNow(
                                              sequence_sort_key);
 
     // Wake up a worker thread to process |sequence|.
-    if (worker_thread)
+    if (worker_thread) {
       worker_thread->WakeUp();
-    else
+    } else if (!local_priority_queue) {
+      WakeUpOneThread();
+    } else if (subtle::NoBarrier_Load(&num_idle_worker_threads_) > 0) {
+      // The current thread will get to |sequence| once it is done with its
+      // current Task. Wake up an idle thread so that it can steal |sequence| in
+      // the meantime. There is no need to take the lock of the idle stack when
+      // it is empty: a thread that becomes idle concurrently adds itself to the
+      // stack before trying to steal, so it either sees |sequence| or is seen
+      // here.
       WakeUpOneThread();
+    }
   }
 }
 
@@ -383,6 +424,7 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
     : outer_(outer),
       re_enqueue_sequence_callback_(re_enqueue_sequence_callback),
       single_threaded_priority_queue_(shared_priority_queue),
+      local_priority_queue_(&single_threaded_priority_queue_),
       index_(index) {}
 
 SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
@@ -404,6 +446,8 @@ void SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::OnMainEntry(
   DCHECK(!tls_current_thread_pool.Get().Get());
   tls_current_worker_thread.Get().Set(worker_thread);
   tls_current_thread_pool.Get().Set(outer_);
+  if (outer_->scheduling_policy_ == SchedulingPolicy::WORK_STEALING)
+    tls_current_local_priority_queue.Get().Set(&local_priority_queue_);
 
   ThreadRestrictions::SetIOAllowed(outer_->io_restriction_ ==
                                    IORestriction::ALLOWED);
@@ -414,15 +458,41 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::GetWork(
     SchedulerWorkerThread* worker_thread) {
   DCHECK(ContainsWorkerThread(outer_->worker_threads_, worker_thread));
 
+  const bool work_stealing =
+      outer_->scheduling_policy_ == SchedulingPolicy::WORK_STEALING;
+
   scoped_refptr<Sequence> sequence;
   {
     std::unique_ptr<PriorityQueue::Transaction> shared_transaction(
         outer_->shared_priority_queue_.BeginTransaction());
     std::unique_ptr<PriorityQueue::Transaction> single_threaded_transaction(
         single_threaded_priority_queue_.BeginTransaction());
+    std::unique_ptr<PriorityQueue::Transaction> local_transaction;
+    if (work_stealing)
+      local_transaction = local_priority_queue_.BeginTransaction();
+
+    // Get the most important Sequence among the PriorityQueues this thread
+    // can get work from without stealing. On ties, prefer the single-threaded
+    // PriorityQueue, then the local one.
+    PriorityQueue::Transaction* const transactions[] = {
+        single_threaded_transaction.get(), local_transaction.get(),
+        shared_transaction.get()};
+    PriorityQueue::Transaction* best_transaction = nullptr;
+    for (PriorityQueue::Transaction* transaction : transactions) {
+      if (!transaction || transaction->IsEmpty())
+        continue;
+      if (!best_transaction ||
+          transaction->PeekSortKey() > best_transaction->PeekSortKey()) {
+        best_transaction = transaction;
+      }
+    }
 
-    if (shared_transaction->IsEmpty() &&
-        single_threaded_transaction->IsEmpty()) {
+    if (best_transaction) {
+      sequence = best_transaction->PopSequence();
+      last_sequence_is_single_threaded_ =
+          best_transaction == single_threaded_transaction.get();
+    } else {
+      local_transaction.reset();
       single_threaded_transaction.reset();
 
       // |shared_transaction| is kept alive while |worker_thread| is added to
@@ -438,26 +508,22 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::GetWork(
       // 4. This thread adds itself to |idle_worker_threads_stack_| and goes to
       //    sleep. No thread runs the Sequence inserted in step 2.
       outer_->AddToIdleWorkerThreadsStack(worker_thread);
-      return nullptr;
     }
+  }
 
-    // True if both PriorityQueues have Sequences and the Sequence at the top of
-    // the shared PriorityQueue is more important.
-    const bool shared_sequence_is_more_important =
-        !shared_transaction->IsEmpty() &&
-        !single_threaded_transaction->IsEmpty() &&
-        shared_transaction->PeekSortKey() >
-            single_threaded_transaction->PeekSortKey();
-
-    if (single_threaded_transaction->IsEmpty() ||
-        shared_sequence_is_more_important) {
-      sequence = shared_transaction->PopSequence();
-      last_sequence_is_single_threaded_ = false;
-    } else {
-      DCHECK(!single_threaded_transaction->IsEmpty());
-      sequence = single_threaded_transaction->PopSequence();
-      last_sequence_is_single_threaded_ = true;
-    }
+  if (!sequence) {
+    if (!work_stealing)
+      return nullptr;
+
+    // The local PriorityQueue can't receive Sequences until this thread runs
+    // a Task again, so it is safe to go to sleep if there is nothing to steal.
+    // Stealing happens after this thread is added to
+    // |idle_worker_threads_stack_| so that a thread which pushes a Sequence to
+    // its local PriorityQueue afterwards sees it and wakes it up.
+    sequence = StealWork();
+    if (!sequence)
+      return nullptr;
+    last_sequence_is_single_threaded_ = false;
   }
   DCHECK(sequence);
 
@@ -485,13 +551,33 @@ TimeDelta SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
   return TimeDelta::Max();
 }
 
+scoped_refptr<Sequence>
+SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::StealWork() {
+  // Start with the next worker thread so that threads looking for work don't
+  // all go after the same victim.
+  const size_t num_worker_threads = outer_->worker_threads_.size();
+  for (size_t i = 1; i < num_worker_threads; ++i) {
+    const size_t victim_index = (index_ + i) % num_worker_threads;
+    SchedulerWorkerThreadDelegateImpl* const victim =
+        static_cast<SchedulerWorkerThreadDelegateImpl*>(
+            outer_->worker_threads_[victim_index]->delegate());
+    std::unique_ptr<PriorityQueue::Transaction> transaction(
+        victim->local_priority_queue()->BeginTransaction());
+    if (!transaction->IsEmpty())
+      return transaction->PopSequence();
+  }
+  return nullptr;
+}
+
 SchedulerThreadPoolImpl::SchedulerThreadPoolImpl(
     StringPiece name,
     IORestriction io_restriction,
+    SchedulingPolicy scheduling_policy,
     TaskTracker* task_tracker,
     DelayedTaskManager* delayed_task_manager)
     : name_(name.as_string()),
       io_restriction_(io_restriction),
+      scheduling_policy_(scheduling_policy),
       idle_worker_threads_stack_lock_(shared_priority_queue_.container_lock()),
       idle_worker_threads_stack_cv_for_testing_(
           idle_worker_threads_stack_lock_.CreateConditionVariable()),
@@ -525,6 +611,9 @@ bool SchedulerThreadPoolImpl::Initialize(
     idle_worker_threads_stack_.Push(worker_thread.get());
     worker_threads_.push_back(std::move(worker_thread));
   }
+  subtle::NoBarrier_Store(
+      &num_idle_worker_threads_,
+      static_cast<subtle::Atomic32>(idle_worker_threads_stack_.Size()));
 
 #if DCHECK_IS_ON()
   threads_created_.Signal();
@@ -538,6 +627,9 @@ void SchedulerThreadPoolImpl::WakeUpOneThread() {
   {
     AutoSchedulerLock auto_lock(idle_worker_threads_stack_lock_);
     worker_thread = idle_worker_threads_stack_.Pop();
+    subtle::NoBarrier_Store(
+        &num_idle_worker_threads_,
+        static_cast<subtle::Atomic32>(idle_worker_threads_stack_.Size()));
   }
   if (worker_thread)
     worker_thread->WakeUp();
@@ -548,6 +640,9 @@ void SchedulerThreadPoolImpl::AddToIdleWorkerThreadsStack(
   AutoSchedulerLock auto_lock(idle_worker_threads_stack_lock_);
   idle_worker_threads_stack_.Push(worker_thread);
   DCHECK_LE(idle_worker_threads_stack_.Size(), worker_threads_.size());
+  subtle::NoBarrier_Store(
+      &num_idle_worker_threads_,
+      static_cast<subtle::Atomic32>(idle_worker_threads_stack_.Size()));
 
   if (idle_worker_threads_stack_.Size() == worker_threads_.size())
     idle_worker_threads_stack_cv_for_testing_->Broadcast();
@@ -555,8 +650,25 @@ void SchedulerThreadPoolImpl::AddToIdleWorkerThreadsStack(
 
 void SchedulerThreadPoolImpl::RemoveFromIdleWorkerThreadsStack(
     SchedulerWorkerThread* worker_thread) {
+  // Only |worker_thread| adds itself to the stack, and it is the calling
+  // thread. If it is on the stack, it sees a non-zero count.
+  if (subtle::NoBarrier_Load(&num_idle_worker_threads_) == 0)
+    return;
+
   AutoSchedulerLock auto_lock(idle_worker_threads_stack_lock_);
   idle_worker_threads_stack_.Remove(worker_thread);
+  subtle::NoBarrier_Store(
+      &num_idle_worker_threads_,
+      static_cast<subtle::Atomic32>(idle_worker_threads_stack_.Size()));
+}
+
+PriorityQueue* SchedulerThreadPoolImpl::GetLocalPriorityQueueForCurrentThread()
+    const {
+  if (scheduling_policy_ != SchedulingPolicy::WORK_STEALING ||
+      tls_current_thread_pool.Get().Get() != this) {
+    return nullptr;
+  }
+  return tls_current_local_priority_queue.Get().Get();
 }
 
 }  // namespace internal
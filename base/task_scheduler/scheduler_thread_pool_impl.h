@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/callback.h"
 #include "base/logging.h"
@@ -43,6 +44,18 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
     DISALLOWED,
   };
 
+  // How Sequences that aren't bound to a specific worker thread are
+  // distributed among the threads of the pool.
+  enum class SchedulingPolicy {
+    // All Sequences go through a PriorityQueue shared by all threads.
+    SHARED_QUEUE,
+    // Sequences posted or re-enqueued by a thread of the pool go to a
+    // PriorityQueue owned by that thread. Threads that run out of work steal
+    // Sequences from the PriorityQueues of other threads. Sequences posted
+    // from outside the pool still go through the shared PriorityQueue.
+    WORK_STEALING,
+  };
+
   // Callback invoked when a Sequence isn't empty after a worker thread pops a
   // Task from it.
   using ReEnqueueSequenceCallback = Callback<void(scoped_refptr<Sequence>)>;
@@ -55,6 +68,7 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // Creates a SchedulerThreadPool labeled |name| with up to |max_threads|
   // threads of priority |thread_priority|. |io_restriction| indicates whether
   // Tasks on the constructed thread pool are allowed to make I/O calls.
+  // |scheduling_policy| determines how work is distributed among threads.
   // |re_enqueue_sequence_callback| will be invoked after a thread of this
   // thread pool tries to run a Task. |task_tracker| is used to handle shutdown
   // behavior of Tasks. |delayed_task_manager| handles Tasks posted with a
@@ -65,6 +79,7 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
       ThreadPriority thread_priority,
       size_t max_threads,
       IORestriction io_restriction,
+      SchedulingPolicy scheduling_policy,
       const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
       TaskTracker* task_tracker,
       DelayedTaskManager* delayed_task_manager);
@@ -94,6 +109,7 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
 
   SchedulerThreadPoolImpl(StringPiece name,
                           IORestriction io_restriction,
+                          SchedulingPolicy scheduling_policy,
                           TaskTracker* task_tracker,
                           DelayedTaskManager* delayed_task_manager);
 
@@ -108,9 +124,15 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // Adds |worker_thread| to |idle_worker_threads_stack_|.
   void AddToIdleWorkerThreadsStack(SchedulerWorkerThread* worker_thread);
 
-  // Removes |worker_thread| from |idle_worker_threads_stack_|.
+  // Removes |worker_thread| from |idle_worker_threads_stack_|. Must be called
+  // on |worker_thread|.
   void RemoveFromIdleWorkerThreadsStack(SchedulerWorkerThread* worker_thread);
 
+  // Returns the PriorityQueue owned by the current thread if it is a worker
+  // thread of this pool and the pool is in WORK_STEALING mode. Returns nullptr
+  // otherwise.
+  PriorityQueue* GetLocalPriorityQueueForCurrentThread() const;
+
   // The name of this thread pool, used to label its worker threads.
   const std::string name_;
 
@@ -131,6 +153,8 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // Indicates whether Tasks on this thread pool are allowed to make I/O calls.
   const IORestriction io_restriction_;
 
+  const SchedulingPolicy scheduling_policy_;
+
   // Synchronizes access to |idle_worker_threads_stack_| and
   // |idle_worker_threads_stack_cv_for_testing_|. Has |shared_priority_queue_|'s
   // lock as its predecessor so that a thread can be pushed to
@@ -141,6 +165,11 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // Stack of idle worker threads.
   SchedulerWorkerThreadStack idle_worker_threads_stack_;
 
+  // Size of |idle_worker_threads_stack_|. Only written while holding
+  // |idle_worker_threads_stack_lock_|, but can be read without it to avoid
+  // acquiring the lock when there is obviously no idle thread.
+  subtle::Atomic32 num_idle_worker_threads_ = 0;
+
   // Signaled when all worker threads become idle.
   std::unique_ptr<ConditionVariable> idle_worker_threads_stack_cv_for_testing_;
 
@@ -0,0 +1,200 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/callback.h"
+#include "base/format_macros.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task_runner.h"
+#include "base/task_scheduler/delayed_task_manager.h"
+#include "base/task_scheduler/scheduler_thread_pool_impl.h"
+#include "base/task_scheduler/sequence.h"
+#include "base/task_scheduler/sequence_sort_key.h"
+#include "base/task_scheduler/task_tracker.h"
+#include "base/task_scheduler/task_traits.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace internal {
+namespace {
+
+using SchedulingPolicy = SchedulerThreadPoolImpl::SchedulingPolicy;
+
+const size_t kNumThreads[] = {1, 2, 4, 8, 16, 32, 64};
+
+// Number of Tasks posted from outside the pool in each round of the throughput
+// test. Each of them posts |kNumChildTasks| Tasks from a worker thread.
+const int kNumRootTasks = 64;
+const int kNumChildTasks = 256;
+
+const int kTimeLimitMillis = 1000;
+const int kNumLatencyRuns = 500;
+
+const char* SchedulingPolicyToString(SchedulingPolicy scheduling_policy) {
+  switch (scheduling_policy) {
+    case SchedulingPolicy::SHARED_QUEUE:
+      return "shared_queue";
+    case SchedulingPolicy::WORK_STEALING:
+      return "work_stealing";
+  }
+  NOTREACHED();
+  return "";
+}
+
+class TaskSchedulerThreadPoolPerfTest : public testing::Test {
+ protected:
+  TaskSchedulerThreadPoolPerfTest()
+      : delayed_task_manager_(Bind(&DoNothing)),
+        all_tasks_ran_(false, false) {}
+
+  void TearDown() override { DestroyThreadPool(); }
+
+  void CreateThreadPool(size_t num_threads,
+                        SchedulingPolicy scheduling_policy) {
+    DestroyThreadPool();
+    thread_pool_ = SchedulerThreadPoolImpl::Create(
+        "PerfTestThreadPool", ThreadPriority::NORMAL, num_threads,
+        SchedulerThreadPoolImpl::IORestriction::DISALLOWED, scheduling_policy,
+        Bind(&TaskSchedulerThreadPoolPerfTest::ReEnqueueSequenceCallback,
+             Unretained(this)),
+        &task_tracker_, &delayed_task_manager_);
+    ASSERT_TRUE(thread_pool_);
+    task_runner_ = thread_pool_->CreateTaskRunnerWithTraits(
+        TaskTraits(), ExecutionMode::PARALLEL);
+  }
+
+  void DestroyThreadPool() {
+    if (!thread_pool_)
+      return;
+    task_runner_ = nullptr;
+    thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+    thread_pool_->JoinForTesting();
+    thread_pool_.reset();
+  }
+
+  // Measures how many short Tasks per second the pool runs when most of them
+  // are posted by its own worker threads, as happens with fan-out workloads.
+  void RunThroughputTest(size_t num_threads,
+                         SchedulingPolicy scheduling_policy) {
+    CreateThreadPool(num_threads, scheduling_policy);
+
+    const int kTasksPerRound = kNumRootTasks * (kNumChildTasks + 1);
+    int64_t num_tasks = 0;
+    const TimeTicks start_time = TimeTicks::Now();
+    TimeDelta elapsed;
+    do {
+      subtle::NoBarrier_Store(&num_pending_tasks_, kTasksPerRound);
+      for (int i = 0; i < kNumRootTasks; ++i) {
+        task_runner_->PostTask(
+            FROM_HERE, Bind(&TaskSchedulerThreadPoolPerfTest::RunRootTask,
+                            Unretained(this)));
+      }
+      all_tasks_ran_.Wait();
+      num_tasks += kTasksPerRound;
+      elapsed = TimeTicks::Now() - start_time;
+    } while (elapsed < TimeDelta::FromMilliseconds(kTimeLimitMillis));
+
+    perf_test::PrintResult(
+        "task_throughput", SchedulingPolicyToString(scheduling_policy),
+        StringPrintf("%" PRIuS "_threads", num_threads),
+        num_tasks / elapsed.InSecondsF(), "tasks/s", true);
+  }
+
+  // Measures how long it takes for a Task posted to an idle pool to start
+  // running.
+  void RunLatencyTest(size_t num_threads, SchedulingPolicy scheduling_policy) {
+    CreateThreadPool(num_threads, scheduling_policy);
+
+    TimeDelta total_latency;
+    for (int i = 0; i < kNumLatencyRuns; ++i) {
+      thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+      TimeTicks run_time;
+      const TimeTicks post_time = TimeTicks::Now();
+      task_runner_->PostTask(
+          FROM_HERE, Bind(&TaskSchedulerThreadPoolPerfTest::RecordRunTime,
+                          Unretained(this), Unretained(&run_time)));
+      all_tasks_ran_.Wait();
+      total_latency += run_time - post_time;
+    }
+
+    perf_test::PrintResult(
+        "task_latency", SchedulingPolicyToString(scheduling_policy),
+        StringPrintf("%" PRIuS "_threads", num_threads),
+        total_latency.InMicrosecondsF() / kNumLatencyRuns, "us", true);
+  }
+
+ private:
+  void ReEnqueueSequenceCallback(scoped_refptr<Sequence> sequence) {
+    const SequenceSortKey sort_key(sequence->GetSortKey());
+    thread_pool_->ReEnqueueSequence(std::move(sequence), sort_key);
+  }
+
+  void RunRootTask() {
+    for (int i = 0; i < kNumChildTasks; ++i) {
+      task_runner_->PostTask(
+          FROM_HERE, Bind(&TaskSchedulerThreadPoolPerfTest::RunChildTask,
+                          Unretained(this)));
+    }
+    RunChildTask();
+  }
+
+  void RunChildTask() {
+    if (subtle::Barrier_AtomicIncrement(&num_pending_tasks_, -1) == 0)
+      all_tasks_ran_.Signal();
+  }
+
+  void RecordRunTime(TimeTicks* run_time) {
+    *run_time = TimeTicks::Now();
+    all_tasks_ran_.Signal();
+  }
+
+  TaskTracker task_tracker_;
+  DelayedTaskManager delayed_task_manager_;
+  std::unique_ptr<SchedulerThreadPoolImpl> thread_pool_;
+  scoped_refptr<TaskRunner> task_runner_;
+
+  // Number of Tasks of the current throughput round that haven't run yet.
+  subtle::Atomic32 num_pending_tasks_ = 0;
+
+  // Signaled when the last Task of a throughput round or the Task of a latency
+  // run has run.
+  WaitableEvent all_tasks_ran_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskSchedulerThreadPoolPerfTest);
+};
+
+}  // namespace
+
+TEST_F(TaskSchedulerThreadPoolPerfTest, Throughput) {
+  for (size_t num_threads : kNumThreads) {
+    RunThroughputTest(num_threads, SchedulingPolicy::SHARED_QUEUE);
+    RunThroughputTest(num_threads, SchedulingPolicy::WORK_STEALING);
+  }
+}
+
+TEST_F(TaskSchedulerThreadPoolPerfTest, Latency) {
+  for (size_t num_threads : kNumThreads) {
+    RunLatencyTest(num_threads, SchedulingPolicy::SHARED_QUEUE);
+    RunLatencyTest(num_threads, SchedulingPolicy::WORK_STEALING);
+  }
+}
+
+}  // namespace internal
+}  // namespace base
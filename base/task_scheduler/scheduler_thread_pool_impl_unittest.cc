@@ -10,6 +10,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/callback.h"
@@ -40,6 +41,12 @@ const size_t kNumThreadsPostingTasks = 4;
 const size_t kNumTasksPostedPerThread = 150;
 
 using IORestriction = SchedulerThreadPoolImpl::IORestriction;
+using SchedulingPolicy = SchedulerThreadPoolImpl::SchedulingPolicy;
+
+struct ThreadPoolTestParams {
+  ExecutionMode execution_mode;
+  SchedulingPolicy scheduling_policy;
+};
 
 class TestDelayedTaskManager : public DelayedTaskManager {
  public:
@@ -57,7 +64,7 @@ class TestDelayedTaskManager : public DelayedTaskManager {
 };
 
 class TaskSchedulerThreadPoolImplTest
-    : public testing::TestWithParam<ExecutionMode> {
+    : public testing::TestWithParam<ThreadPoolTestParams> {
  protected:
   TaskSchedulerThreadPoolImplTest() = default;
 
@@ -65,6 +72,7 @@ class TaskSchedulerThreadPoolImplTest
     thread_pool_ = SchedulerThreadPoolImpl::Create(
         "TestThreadPoolWithFileIO", ThreadPriority::NORMAL,
         kNumThreadsInThreadPool, IORestriction::ALLOWED,
+        GetParam().scheduling_policy,
         Bind(&TaskSchedulerThreadPoolImplTest::ReEnqueueSequenceCallback,
              Unretained(this)),
         &task_tracker_, &delayed_task_manager_);
@@ -76,6 +84,8 @@ class TaskSchedulerThreadPoolImplTest
     thread_pool_->JoinForTesting();
   }
 
+  ExecutionMode execution_mode() const { return GetParam().execution_mode; }
+
   std::unique_ptr<SchedulerThreadPoolImpl> thread_pool_;
 
   TaskTracker task_tracker_;
@@ -151,6 +161,31 @@ void ShouldNotRunCallback() {
   ADD_FAILURE() << "Ran a task that shouldn't run.";
 }
 
+// Increments |num_tasks| if the current thread isn't |thread|.
+void CountTaskIfNotOnThread(PlatformThreadRef thread,
+                            subtle::Atomic32* num_tasks) {
+  if (!(PlatformThread::CurrentRef() == thread))
+    subtle::NoBarrier_AtomicIncrement(num_tasks, 1);
+}
+
+// Posts a Task through each factory in |factories|, waits for all of them to
+// run and signals |all_tasks_ran|. Each Task that runs on another thread than
+// the one that posted it increments |num_tasks_on_other_threads|.
+void PostTasksAndWaitForThemToRun(
+    std::vector<std::unique_ptr<test::TestTaskFactory>>* factories,
+    subtle::Atomic32* num_tasks_on_other_threads,
+    WaitableEvent* all_tasks_ran) {
+  const PlatformThreadRef posting_thread = PlatformThread::CurrentRef();
+  for (const auto& factory : *factories) {
+    EXPECT_TRUE(factory->PostTask(
+        PostNestedTask::NO, Bind(&CountTaskIfNotOnThread, posting_thread,
+                                 Unretained(num_tasks_on_other_threads))));
+  }
+  for (const auto& factory : *factories)
+    factory->WaitForAllTasksToRun();
+  all_tasks_ran->Signal();
+}
+
 }  // namespace
 
 TEST_P(TaskSchedulerThreadPoolImplTest, PostTasks) {
@@ -158,7 +193,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasks) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(), WaitBeforePostTask::NO_WAIT,
+        thread_pool_.get(), execution_mode(), WaitBeforePostTask::NO_WAIT,
         PostNestedTask::NO)));
     threads_posting_tasks.back()->Start();
   }
@@ -181,7 +216,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWaitAllThreadsIdle) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(),
+        thread_pool_.get(), execution_mode(),
         WaitBeforePostTask::WAIT_FOR_ALL_THREADS_IDLE, PostNestedTask::NO)));
     threads_posting_tasks.back()->Start();
   }
@@ -203,7 +238,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, NestedPostTasks) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(), WaitBeforePostTask::NO_WAIT,
+        thread_pool_.get(), execution_mode(), WaitBeforePostTask::NO_WAIT,
         PostNestedTask::YES)));
     threads_posting_tasks.back()->Start();
   }
@@ -227,8 +262,9 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWithOneAvailableThread) {
   std::vector<std::unique_ptr<test::TestTaskFactory>> blocked_task_factories;
   for (size_t i = 0; i < (kNumThreadsInThreadPool - 1); ++i) {
     blocked_task_factories.push_back(WrapUnique(new test::TestTaskFactory(
-        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-        GetParam())));
+        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                                 execution_mode()),
+        execution_mode())));
     EXPECT_TRUE(blocked_task_factories.back()->PostTask(
         PostNestedTask::NO, Bind(&WaitableEvent::Wait, Unretained(&event))));
     blocked_task_factories.back()->WaitForAllTasksToRun();
@@ -237,8 +273,8 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWithOneAvailableThread) {
   // Post |kNumTasksPostedPerThread| tasks that should all run despite the fact
   // that only one thread in |thread_pool_| isn't busy.
   test::TestTaskFactory short_task_factory(
-      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-      GetParam());
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), execution_mode()),
+      execution_mode());
   for (size_t i = 0; i < kNumTasksPostedPerThread; ++i)
     EXPECT_TRUE(short_task_factory.PostTask(PostNestedTask::NO, Closure()));
   short_task_factory.WaitForAllTasksToRun();
@@ -260,8 +296,9 @@ TEST_P(TaskSchedulerThreadPoolImplTest, Saturate) {
   std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
   for (size_t i = 0; i < kNumThreadsInThreadPool; ++i) {
     factories.push_back(WrapUnique(new test::TestTaskFactory(
-        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-        GetParam())));
+        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                                 execution_mode()),
+        execution_mode())));
     EXPECT_TRUE(factories.back()->PostTask(
         PostNestedTask::NO, Bind(&WaitableEvent::Wait, Unretained(&event))));
     factories.back()->WaitForAllTasksToRun();
@@ -278,7 +315,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, Saturate) {
 // Verify that a Task can't be posted after shutdown.
 TEST_P(TaskSchedulerThreadPoolImplTest, PostTaskAfterShutdown) {
   auto task_runner =
-      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam());
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), execution_mode());
   task_tracker_.Shutdown();
   EXPECT_FALSE(task_runner->PostTask(FROM_HERE, Bind(&ShouldNotRunCallback)));
 }
@@ -290,10 +327,11 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostDelayedTask) {
 
   // Post a delayed task.
   WaitableEvent task_ran(true, false);
-  EXPECT_TRUE(thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam())
-                  ->PostDelayedTask(FROM_HERE, Bind(&WaitableEvent::Signal,
-                                                    Unretained(&task_ran)),
-                                    TimeDelta::FromSeconds(10)));
+  EXPECT_TRUE(
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), execution_mode())
+          ->PostDelayedTask(
+              FROM_HERE, Bind(&WaitableEvent::Signal, Unretained(&task_ran)),
+              TimeDelta::FromSeconds(10)));
 
   // The task should have been added to the DelayedTaskManager.
   EXPECT_FALSE(delayed_task_manager_.GetDelayedRunTime().is_null());
@@ -310,15 +348,80 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostDelayedTask) {
   task_ran.Wait();
 }
 
-INSTANTIATE_TEST_CASE_P(Parallel,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::PARALLEL));
-INSTANTIATE_TEST_CASE_P(Sequenced,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::SEQUENCED));
-INSTANTIATE_TEST_CASE_P(SingleThreaded,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::SINGLE_THREADED));
+// Verify that Tasks posted from a busy worker thread run on other worker
+// threads of a WORK_STEALING pool while it is busy.
+TEST_P(TaskSchedulerThreadPoolImplTest, IdleThreadsStealWork) {
+  if (GetParam().scheduling_policy != SchedulingPolicy::WORK_STEALING ||
+      execution_mode() == ExecutionMode::SINGLE_THREADED) {
+    return;
+  }
+
+  // Use a different factory for each Task so that the Tasks are in different
+  // Sequences and can run simultaneously when the execution mode is SEQUENCED.
+  WaitableEvent all_tasks_ran(true, false);
+  std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
+  for (size_t i = 0; i < kNumTasksPostedPerThread; ++i) {
+    factories.push_back(WrapUnique(new test::TestTaskFactory(
+        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                                 execution_mode()),
+        execution_mode())));
+  }
+
+  // Post a Task which posts all the other Tasks to the local PriorityQueue of
+  // its worker thread and then blocks until they have all run.
+  subtle::Atomic32 num_tasks_on_other_threads = 0;
+  test::TestTaskFactory blocking_task_factory(
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), execution_mode()),
+      execution_mode());
+  EXPECT_TRUE(blocking_task_factory.PostTask(
+      PostNestedTask::NO,
+      Bind(&PostTasksAndWaitForThemToRun, Unretained(&factories),
+           Unretained(&num_tasks_on_other_threads),
+           Unretained(&all_tasks_ran))));
+  all_tasks_ran.Wait();
+  blocking_task_factory.WaitForAllTasksToRun();
+
+  // Wait until all worker threads are idle to be sure that no task accesses
+  // its TestTaskFactory after it is destroyed, and that all the Tasks have
+  // been counted.
+  thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+
+  // The Tasks were only in the local PriorityQueue of the blocked thread, so
+  // each one that ran elsewhere was stolen.
+  EXPECT_EQ(static_cast<subtle::Atomic32>(kNumTasksPostedPerThread),
+            subtle::NoBarrier_Load(&num_tasks_on_other_threads));
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Parallel,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::PARALLEL,
+                                           SchedulingPolicy::SHARED_QUEUE}));
+INSTANTIATE_TEST_CASE_P(
+    Sequenced,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::SEQUENCED,
+                                           SchedulingPolicy::SHARED_QUEUE}));
+INSTANTIATE_TEST_CASE_P(
+    SingleThreaded,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::SINGLE_THREADED,
+                                           SchedulingPolicy::SHARED_QUEUE}));
+INSTANTIATE_TEST_CASE_P(
+    ParallelWorkStealing,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::PARALLEL,
+                                           SchedulingPolicy::WORK_STEALING}));
+INSTANTIATE_TEST_CASE_P(
+    SequencedWorkStealing,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::SEQUENCED,
+                                           SchedulingPolicy::WORK_STEALING}));
+INSTANTIATE_TEST_CASE_P(
+    SingleThreadedWorkStealing,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Values(ThreadPoolTestParams{ExecutionMode::SINGLE_THREADED,
+                                           SchedulingPolicy::WORK_STEALING}));
 
 namespace {
 
@@ -361,6 +464,7 @@ TEST_P(TaskSchedulerThreadPoolImplIORestrictionTest, IORestriction) {
 
   auto thread_pool = SchedulerThreadPoolImpl::Create(
       "TestThreadPoolWithParam", ThreadPriority::NORMAL, 1U, GetParam(),
+      SchedulingPolicy::SHARED_QUEUE,
       Bind(&NotReachedReEnqueueSequenceCallback), &task_tracker,
       &delayed_task_manager);
   ASSERT_TRUE(thread_pool);
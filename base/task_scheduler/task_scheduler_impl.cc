@@ -79,6 +79,7 @@ TaskSchedulerImpl::TaskSchedulerImpl()
 
 void TaskSchedulerImpl::Initialize() {
   using IORestriction = SchedulerThreadPoolImpl::IORestriction;
+  using SchedulingPolicy = SchedulerThreadPoolImpl::SchedulingPolicy;
 
   const SchedulerThreadPoolImpl::ReEnqueueSequenceCallback
       re_enqueue_sequence_callback =
@@ -92,26 +93,26 @@ void TaskSchedulerImpl::Initialize() {
   // be deleted before all its thread pools have been joined.
   background_thread_pool_ = SchedulerThreadPoolImpl::Create(
       "TaskSchedulerBackground", ThreadPriority::BACKGROUND, 1U,
-      IORestriction::DISALLOWED, re_enqueue_sequence_callback, &task_tracker_,
-      &delayed_task_manager_);
+      IORestriction::DISALLOWED, SchedulingPolicy::SHARED_QUEUE,
+      re_enqueue_sequence_callback, &task_tracker_, &delayed_task_manager_);
   CHECK(background_thread_pool_);
 
   background_file_io_thread_pool_ = SchedulerThreadPoolImpl::Create(
       "TaskSchedulerBackgroundFileIO", ThreadPriority::BACKGROUND, 1U,
-      IORestriction::ALLOWED, re_enqueue_sequence_callback, &task_tracker_,
-      &delayed_task_manager_);
+      IORestriction::ALLOWED, SchedulingPolicy::SHARED_QUEUE,
+      re_enqueue_sequence_callback, &task_tracker_, &delayed_task_manager_);
   CHECK(background_file_io_thread_pool_);
 
   normal_thread_pool_ = SchedulerThreadPoolImpl::Create(
       "TaskSchedulerForeground", ThreadPriority::NORMAL, 4U,
-      IORestriction::DISALLOWED, re_enqueue_sequence_callback, &task_tracker_,
-      &delayed_task_manager_);
+      IORestriction::DISALLOWED, SchedulingPolicy::SHARED_QUEUE,
+      re_enqueue_sequence_callback, &task_tracker_, &delayed_task_manager_);
   CHECK(normal_thread_pool_);
 
   normal_file_io_thread_pool_ = SchedulerThreadPoolImpl::Create(
       "TaskSchedulerForegroundFileIO", ThreadPriority::NORMAL, 12U,
-      IORestriction::ALLOWED, re_enqueue_sequence_callback, &task_tracker_,
-      &delayed_task_manager_);
+      IORestriction::ALLOWED, SchedulingPolicy::SHARED_QUEUE,
+      re_enqueue_sequence_callback, &task_tracker_, &delayed_task_manager_);
   CHECK(normal_file_io_thread_pool_);
 
   service_thread_ = SchedulerServiceThread::Create(&task_tracker_,
@@ -0,0 +1,26 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/heap_in_use.h"
+
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <malloc.h>
+#endif
+
+namespace base {
+
+size_t HeapInUse() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Large blocks, like the copy of the input that a Value tree can keep, are
+  // mapped separately and only show up in |hblkhd|.
+  struct mallinfo info = mallinfo();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace base
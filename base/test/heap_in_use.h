@@ -0,0 +1,19 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_HEAP_IN_USE_H_
+#define BASE_TEST_HEAP_IN_USE_H_
+
+#include <stddef.h>
+
+namespace base {
+
+// Returns the number of bytes allocated from the heap, or 0 if it is unknown
+// on this platform. Perf tests compare it before and after building a data
+// structure to report how much memory the structure takes.
+size_t HeapInUse();
+
+}  // namespace base
+
+#endif  // BASE_TEST_HEAP_IN_USE_H_
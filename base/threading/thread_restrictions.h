@@ -22,6 +22,7 @@ class ScopedAllowWaitForLegacyWebViewApi;
 
 namespace cc {
 class CompletionEvent;
+class MultiThreadTaskGraphRunner;
 class SingleThreadTaskGraphRunner;
 }
 namespace chromeos {
@@ -200,6 +201,7 @@ class BASE_EXPORT ThreadRestrictions {
   friend class ::HistogramSynchronizer;
   friend class ::ScopedAllowWaitForLegacyWebViewApi;
   friend class cc::CompletionEvent;
+  friend class cc::MultiThreadTaskGraphRunner;  // Test-only.
   friend class cc::SingleThreadTaskGraphRunner;
   friend class content::RasterWorkerPool;
   friend class remoting::AutoThread;
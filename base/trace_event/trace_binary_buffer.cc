@@ -0,0 +1,414 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_binary_buffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/logging.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_binary_format.h"
+#include "base/trace_event/trace_event.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+bool WriteString(File* file, const std::string& data) {
+  return file->WriteAtCurrentPos(data.data(), static_cast<int>(data.size())) ==
+         static_cast<int>(data.size());
+}
+
+}  // namespace
+
+struct TraceBinaryThreadBuffer::Chunk {
+  // Even while the chunk is stable and odd while it is being recycled. A
+  // reader that sees the same even value before and after copying the chunk
+  // got a consistent copy.
+  subtle::Atomic32 generation;
+  // Position of the chunk in the recording order of the thread.
+  subtle::Atomic32 sequence_number;
+  // Number of bytes of |data| holding complete events.
+  subtle::Atomic32 size;
+  char data[kChunkSize];
+};
+
+TraceBinaryThreadBuffer::TraceBinaryThreadBuffer(int session_id,
+                                                 int thread_id,
+                                                 size_t max_chunks)
+    : session_id_(session_id),
+      thread_id_(thread_id),
+      max_chunks_(max_chunks),
+      chunks_(new subtle::AtomicWord[max_chunks]),
+      current_chunk_(nullptr),
+      current_chunk_index_(0),
+      next_chunk_sequence_number_(0),
+      last_timestamp_(0),
+      last_thread_timestamp_(0),
+      dropped_event_count_(0) {
+  DCHECK_LT(0u, max_chunks_);
+  for (size_t i = 0; i < max_chunks_; ++i)
+    subtle::NoBarrier_Store(&chunks_[i], 0);
+}
+
+TraceBinaryThreadBuffer::~TraceBinaryThreadBuffer() {
+  for (size_t i = 0; i < max_chunks_; ++i)
+    delete reinterpret_cast<Chunk*>(subtle::NoBarrier_Load(&chunks_[i]));
+}
+
+void TraceBinaryThreadBuffer::AddEvent(
+    char phase,
+    const char* category_group_name,
+    const char* name,
+    const char* scope,
+    unsigned long long id,
+    unsigned long long bind_id,
+    int thread_id,
+    const TimeTicks& timestamp,
+    const ThreadTicks& thread_timestamp,
+    int num_args,
+    const char** arg_names,
+    const unsigned char* arg_types,
+    const unsigned long long* arg_values,
+    std::unique_ptr<ConvertableToTraceFormat>* convertable_values,
+    unsigned int flags) {
+  const int64_t timestamp_us = timestamp.ToInternalValue();
+  const int64_t thread_timestamp_us =
+      thread_timestamp.is_null() ? -1 : thread_timestamp.ToInternalValue();
+
+  if (!current_chunk_)
+    StartNextChunk();
+  EncodeEvent(phase, category_group_name, name, scope, id, bind_id, thread_id,
+              timestamp_us, thread_timestamp_us, num_args, arg_names,
+              arg_types, arg_values, convertable_values, flags,
+              last_timestamp_, last_thread_timestamp_);
+
+  size_t size = subtle::NoBarrier_Load(&current_chunk_->size);
+  if (size + scratch_.size() > kChunkSize) {
+    if (scratch_.size() > kChunkSize) {
+      ++dropped_event_count_;
+      return;
+    }
+    // Deltas restart in every chunk, so the event has to be re-encoded.
+    StartNextChunk();
+    EncodeEvent(phase, category_group_name, name, scope, id, bind_id,
+                thread_id, timestamp_us, thread_timestamp_us, num_args,
+                arg_names, arg_types, arg_values, convertable_values, flags,
+                0, 0);
+    size = 0;
+  }
+
+  memcpy(current_chunk_->data + size, scratch_.data(), scratch_.size());
+  subtle::Release_Store(&current_chunk_->size,
+                        static_cast<subtle::Atomic32>(size + scratch_.size()));
+  last_timestamp_ = timestamp_us;
+  if (thread_timestamp_us != -1)
+    last_thread_timestamp_ = thread_timestamp_us;
+}
+
+void TraceBinaryThreadBuffer::Serialize(const std::string& thread_name,
+                                        std::string* out) const {
+  std::string payload;
+  TraceBinaryFormat::AppendSignedVarint(thread_id_, &payload);
+  TraceBinaryFormat::AppendString(thread_name, &payload);
+  TraceBinaryFormat::AppendBlock(TraceBinaryFormat::BLOCK_THREAD, payload, out);
+
+  // Copy the chunks first: every string they refer to was interned before the
+  // chunk size covering the event was published, so the string table read
+  // afterwards is complete for them.
+  std::vector<std::pair<uint32_t, std::string>> chunks;
+  for (size_t i = 0; i < max_chunks_; ++i) {
+    const Chunk* chunk =
+        reinterpret_cast<const Chunk*>(subtle::Acquire_Load(&chunks_[i]));
+    // Chunks are allocated in order.
+    if (!chunk)
+      break;
+    const subtle::Atomic32 generation =
+        subtle::Acquire_Load(&chunk->generation);
+    if (generation & 1)
+      continue;
+    const uint32_t sequence_number =
+        static_cast<uint32_t>(subtle::NoBarrier_Load(&chunk->sequence_number));
+    const size_t size = subtle::Acquire_Load(&chunk->size);
+    std::string data(chunk->data, size);
+    subtle::MemoryBarrier();
+    if (subtle::NoBarrier_Load(&chunk->generation) != generation || !size)
+      continue;
+    chunks.push_back(std::make_pair(sequence_number, std::move(data)));
+  }
+  std::sort(chunks.begin(), chunks.end());
+
+  payload.clear();
+  {
+    AutoLock lock(strings_lock_);
+    TraceBinaryFormat::AppendVarint(1, &payload);
+    TraceBinaryFormat::AppendVarint(strings_.size(), &payload);
+    for (const std::string& value : strings_)
+      TraceBinaryFormat::AppendString(value, &payload);
+  }
+  TraceBinaryFormat::AppendBlock(TraceBinaryFormat::BLOCK_STRINGS, payload,
+                                 out);
+
+  for (const auto& chunk : chunks) {
+    payload.clear();
+    TraceBinaryFormat::AppendVarint(chunk.first, &payload);
+    payload.append(chunk.second);
+    TraceBinaryFormat::AppendBlock(TraceBinaryFormat::BLOCK_EVENTS, payload,
+                                   out);
+  }
+}
+
+void TraceBinaryThreadBuffer::AppendInternedString(const char* value,
+                                                   std::string* out) {
+  if (!value) {
+    TraceBinaryFormat::AppendNullStringRef(out);
+    return;
+  }
+  auto it = interned_ids_.find(value);
+  if (it == interned_ids_.end()) {
+    AutoLock lock(strings_lock_);
+    strings_.push_back(value);
+    it = interned_ids_
+             .insert(std::make_pair(value,
+                                    static_cast<uint32_t>(strings_.size())))
+             .first;
+  }
+  TraceBinaryFormat::AppendInternedStringRef(it->second, out);
+}
+
+void TraceBinaryThreadBuffer::EncodeEvent(
+    char phase,
+    const char* category_group_name,
+    const char* name,
+    const char* scope,
+    unsigned long long id,
+    unsigned long long bind_id,
+    int thread_id,
+    int64_t timestamp,
+    int64_t thread_timestamp,
+    int num_args,
+    const char** arg_names,
+    const unsigned char* arg_types,
+    const unsigned long long* arg_values,
+    std::unique_ptr<ConvertableToTraceFormat>* convertable_values,
+    unsigned int flags,
+    int64_t previous_timestamp,
+    int64_t previous_thread_timestamp) {
+  // Names flagged as copies are transient and can't be interned by address.
+  const bool copy = (flags & TRACE_EVENT_FLAG_COPY) != 0;
+  const bool explicit_thread_id =
+      thread_id != thread_id_ || (flags & TRACE_EVENT_FLAG_HAS_PROCESS_ID);
+  uint8_t fields = 0;
+  if (thread_timestamp != -1)
+    fields |= TraceBinaryFormat::FIELD_THREAD_TIMESTAMP;
+  if (explicit_thread_id)
+    fields |= TraceBinaryFormat::FIELD_THREAD_ID;
+
+  scratch_.clear();
+  scratch_.push_back(phase);
+  TraceBinaryFormat::AppendVarint(flags, &scratch_);
+  scratch_.push_back(static_cast<char>(fields));
+  TraceBinaryFormat::AppendSignedVarint(timestamp - previous_timestamp,
+                                        &scratch_);
+  if (thread_timestamp != -1) {
+    TraceBinaryFormat::AppendSignedVarint(
+        thread_timestamp - previous_thread_timestamp, &scratch_);
+  }
+  if (explicit_thread_id)
+    TraceBinaryFormat::AppendSignedVarint(thread_id, &scratch_);
+
+  AppendInternedString(category_group_name, &scratch_);
+  if (copy)
+    TraceBinaryFormat::AppendInlineStringRef(name, &scratch_);
+  else
+    AppendInternedString(name, &scratch_);
+
+  if (flags & TRACE_EVENT_FLAG_HAS_ID) {
+    if (!scope)
+      TraceBinaryFormat::AppendNullStringRef(&scratch_);
+    else if (copy)
+      TraceBinaryFormat::AppendInlineStringRef(scope, &scratch_);
+    else
+      AppendInternedString(scope, &scratch_);
+    TraceBinaryFormat::AppendVarint(id, &scratch_);
+  }
+  if (flags & (TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT))
+    TraceBinaryFormat::AppendVarint(bind_id, &scratch_);
+
+  scratch_.push_back(static_cast<char>(num_args));
+  for (int i = 0; i < num_args; ++i) {
+    if (copy)
+      TraceBinaryFormat::AppendInlineStringRef(arg_names[i], &scratch_);
+    else
+      AppendInternedString(arg_names[i], &scratch_);
+    scratch_.push_back(static_cast<char>(arg_types[i]));
+
+    TraceEvent::TraceValue value;
+    value.as_uint = arg_values[i];
+    switch (arg_types[i]) {
+      case TRACE_VALUE_TYPE_BOOL:
+        scratch_.push_back(value.as_bool ? 1 : 0);
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        TraceBinaryFormat::AppendVarint(value.as_uint, &scratch_);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        TraceBinaryFormat::AppendSignedVarint(value.as_int, &scratch_);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        // The union holds the bits of the double.
+        for (size_t byte = 0; byte < sizeof(uint64_t); ++byte)
+          scratch_.push_back(static_cast<char>(arg_values[i] >> (8 * byte)));
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        TraceBinaryFormat::AppendVarint(
+            reinterpret_cast<uintptr_t>(value.as_pointer), &scratch_);
+        break;
+      case TRACE_VALUE_TYPE_STRING:
+      case TRACE_VALUE_TYPE_COPY_STRING:
+        // String values are not guaranteed to outlive the trace.
+        if (value.as_string)
+          TraceBinaryFormat::AppendInlineStringRef(value.as_string, &scratch_);
+        else
+          TraceBinaryFormat::AppendNullStringRef(&scratch_);
+        break;
+      case TRACE_VALUE_TYPE_CONVERTABLE: {
+        std::string json;
+        convertable_values[i]->AppendAsTraceFormat(&json);
+        TraceBinaryFormat::AppendString(json, &scratch_);
+        break;
+      }
+      default:
+        NOTREACHED();
+        TraceBinaryFormat::AppendVarint(0, &scratch_);
+        break;
+    }
+  }
+}
+
+TraceBinaryThreadBuffer::Chunk* TraceBinaryThreadBuffer::StartNextChunk() {
+  if (current_chunk_)
+    current_chunk_index_ = (current_chunk_index_ + 1) % max_chunks_;
+  const subtle::Atomic32 sequence_number =
+      static_cast<subtle::Atomic32>(next_chunk_sequence_number_++);
+
+  Chunk* chunk = reinterpret_cast<Chunk*>(
+      subtle::NoBarrier_Load(&chunks_[current_chunk_index_]));
+  if (!chunk) {
+    chunk = new Chunk;
+    subtle::NoBarrier_Store(&chunk->generation, 0);
+    subtle::NoBarrier_Store(&chunk->sequence_number, sequence_number);
+    subtle::NoBarrier_Store(&chunk->size, 0);
+    subtle::Release_Store(&chunks_[current_chunk_index_],
+                          reinterpret_cast<subtle::AtomicWord>(chunk));
+  } else {
+    // Recycle the oldest chunk.
+    const subtle::Atomic32 generation =
+        subtle::NoBarrier_Load(&chunk->generation);
+    subtle::NoBarrier_Store(&chunk->generation, generation + 1);
+    subtle::MemoryBarrier();
+    subtle::NoBarrier_Store(&chunk->sequence_number, sequence_number);
+    subtle::NoBarrier_Store(&chunk->size, 0);
+    subtle::Release_Store(&chunk->generation, generation + 2);
+  }
+
+  current_chunk_ = chunk;
+  last_timestamp_ = 0;
+  last_thread_timestamp_ = 0;
+  return chunk;
+}
+
+TraceBinaryRecorder::TraceBinaryRecorder()
+    : thread_buffer_slot_(&TraceBinaryRecorder::OnThreadExit),
+      session_id_(0),
+      max_chunks_per_thread_(kDefaultMaxChunksPerThread) {}
+
+TraceBinaryRecorder::~TraceBinaryRecorder() {}
+
+void TraceBinaryRecorder::StartSession(size_t max_chunks_per_thread) {
+  AutoLock lock(lock_);
+  StartSessionWhileLocked(max_chunks_per_thread);
+}
+
+TraceBinaryThreadBuffer* TraceBinaryRecorder::GetBufferForCurrentThread() {
+  TraceBinaryThreadBuffer* buffer =
+      static_cast<TraceBinaryThreadBuffer*>(thread_buffer_slot_.Get());
+  if (buffer && buffer->session_id() == subtle::NoBarrier_Load(&session_id_))
+    return buffer;
+
+  scoped_refptr<TraceBinaryThreadBuffer> new_buffer;
+  {
+    AutoLock lock(lock_);
+    new_buffer = new TraceBinaryThreadBuffer(
+        session_id_, static_cast<int>(PlatformThread::CurrentId()),
+        max_chunks_per_thread_);
+    buffers_.push_back(new_buffer);
+  }
+
+  // The slot owns a reference, released when the thread exits or moves on to
+  // the buffer of a later session.
+  if (buffer)
+    buffer->Release();
+  new_buffer->AddRef();
+  thread_buffer_slot_.Set(new_buffer.get());
+  return new_buffer.get();
+}
+
+bool TraceBinaryRecorder::WriteToFile(
+    File* file,
+    int process_id,
+    const std::string& process_name,
+    const hash_map<int, std::string>& thread_names) const {
+  std::string data(TraceBinaryFormat::kMagic,
+                   sizeof(TraceBinaryFormat::kMagic));
+  TraceBinaryFormat::AppendVarint(TraceBinaryFormat::kVersion, &data);
+  TraceBinaryFormat::AppendSignedVarint(process_id, &data);
+  TraceBinaryFormat::AppendString(process_name, &data);
+  if (!WriteString(file, data))
+    return false;
+
+  std::vector<scoped_refptr<TraceBinaryThreadBuffer>> buffers;
+  {
+    AutoLock lock(lock_);
+    buffers = buffers_;
+  }
+
+  // Stream one thread at a time so at most one thread's worth of data is held
+  // in memory.
+  for (const auto& buffer : buffers) {
+    const auto it = thread_names.find(buffer->thread_id());
+    data.clear();
+    buffer->Serialize(it == thread_names.end() ? std::string() : it->second,
+                      &data);
+    if (!WriteString(file, data))
+      return false;
+  }
+  return true;
+}
+
+void TraceBinaryRecorder::Clear() {
+  AutoLock lock(lock_);
+  StartSessionWhileLocked(max_chunks_per_thread_);
+}
+
+void TraceBinaryRecorder::StartSessionWhileLocked(
+    size_t max_chunks_per_thread) {
+  lock_.AssertAcquired();
+  buffers_.clear();
+  max_chunks_per_thread_ = max_chunks_per_thread;
+  subtle::NoBarrier_Store(&session_id_, session_id_ + 1);
+}
+
+// static
+void TraceBinaryRecorder::OnThreadExit(void* buffer) {
+  static_cast<TraceBinaryThreadBuffer*>(buffer)->Release();
+}
+
+}  // namespace trace_event
+}  // namespace base
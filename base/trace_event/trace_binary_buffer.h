@@ -0,0 +1,188 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_TRACE_BINARY_BUFFER_H_
+#define BASE_TRACE_EVENT_TRACE_BINARY_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/containers/hash_tables.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event_impl.h"
+
+namespace base {
+
+class File;
+
+namespace trace_event {
+
+// A ring of fixed-size chunks holding the events of a single thread in the
+// binary trace format (see trace_binary_format.h). Events are only ever added
+// by the thread that owns the buffer, without taking any lock. Any thread can
+// concurrently serialize the buffer: chunks are published with a sequence
+// counter, so a chunk that is recycled while being read is detected and
+// skipped instead of being returned torn.
+//
+// Strings that outlive the trace (category and event names, argument names)
+// are interned the first time the thread sees them and referred to by id
+// afterwards. The string table is kept outside of the ring so recycling a
+// chunk never invalidates the ids used by the remaining ones.
+class BASE_EXPORT TraceBinaryThreadBuffer
+    : public RefCountedThreadSafe<TraceBinaryThreadBuffer> {
+ public:
+  static const size_t kChunkSize = 32 * 1024;
+
+  TraceBinaryThreadBuffer(int session_id, int thread_id, size_t max_chunks);
+
+  int session_id() const { return session_id_; }
+  int thread_id() const { return thread_id_; }
+
+  // Adds an event. Must be called on the thread that owns the buffer. The
+  // arguments have the meaning of TraceLog::AddTraceEventWithThreadId(), except
+  // that |category_group_name| has already been resolved from the enabled
+  // flag. Events that are larger than a chunk are dropped.
+  void AddEvent(char phase,
+                const char* category_group_name,
+                const char* name,
+                const char* scope,
+                unsigned long long id,
+                unsigned long long bind_id,
+                int thread_id,
+                const TimeTicks& timestamp,
+                const ThreadTicks& thread_timestamp,
+                int num_args,
+                const char** arg_names,
+                const unsigned char* arg_types,
+                const unsigned long long* arg_values,
+                std::unique_ptr<ConvertableToTraceFormat>* convertable_values,
+                unsigned int flags);
+
+  // Appends the THREAD, STRINGS and EVENTS blocks for this buffer to |out|.
+  // Can be called on any thread.
+  void Serialize(const std::string& thread_name, std::string* out) const;
+
+  size_t dropped_event_count() const { return dropped_event_count_; }
+
+ private:
+  friend class RefCountedThreadSafe<TraceBinaryThreadBuffer>;
+
+  struct Chunk;
+
+  ~TraceBinaryThreadBuffer();
+
+  // Appends the string ref for |value| to |out|, interning |value| the first
+  // time it is seen.
+  void AppendInternedString(const char* value, std::string* out);
+
+  // Encodes an event into |scratch_|. Timestamps are relative to the
+  // |previous_*| values.
+  void EncodeEvent(
+      char phase,
+      const char* category_group_name,
+      const char* name,
+      const char* scope,
+      unsigned long long id,
+      unsigned long long bind_id,
+      int thread_id,
+      int64_t timestamp,
+      int64_t thread_timestamp,
+      int num_args,
+      const char** arg_names,
+      const unsigned char* arg_types,
+      const unsigned long long* arg_values,
+      std::unique_ptr<ConvertableToTraceFormat>* convertable_values,
+      unsigned int flags,
+      int64_t previous_timestamp,
+      int64_t previous_thread_timestamp);
+
+  // Moves on to the next chunk of the ring, recycling the oldest one once
+  // |max_chunks_| are in use.
+  Chunk* StartNextChunk();
+
+  const int session_id_;
+  const int thread_id_;
+  const size_t max_chunks_;
+
+  // Chunk pointers, published with release stores as chunks are allocated.
+  std::unique_ptr<subtle::AtomicWord[]> chunks_;
+
+  // State only touched by the owning thread.
+  Chunk* current_chunk_;
+  size_t current_chunk_index_;
+  uint32_t next_chunk_sequence_number_;
+  int64_t last_timestamp_;
+  int64_t last_thread_timestamp_;
+  hash_map<const char*, uint32_t> interned_ids_;
+  std::string scratch_;
+  size_t dropped_event_count_;
+
+  // Interned strings, indexed by id - 1. Only appended to by the owning
+  // thread; the lock is taken when a new string is interned and when the
+  // table is serialized.
+  mutable Lock strings_lock_;
+  std::vector<std::string> strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryThreadBuffer);
+};
+
+// Owns the per-thread buffers of RECORD_BINARY tracing. A thread registers its
+// buffer the first time it records an event in a tracing session and keeps a
+// reference to it in thread local storage, so recording an event never takes
+// a lock shared with other threads.
+class BASE_EXPORT TraceBinaryRecorder {
+ public:
+  // Number of chunks of TraceBinaryThreadBuffer::kChunkSize kept per thread.
+  static const size_t kDefaultMaxChunksPerThread = 64;
+
+  TraceBinaryRecorder();
+  ~TraceBinaryRecorder();
+
+  // Starts a new session. Buffers of the previous session are released, and
+  // threads lazily create new ones.
+  void StartSession(size_t max_chunks_per_thread);
+
+  // Returns the buffer of the calling thread for the current session.
+  TraceBinaryThreadBuffer* GetBufferForCurrentThread();
+
+  // Writes the buffers of the current session to |file| in the binary trace
+  // format. |thread_names| maps thread ids to names. Does blocking IO.
+  // Returns false on failure.
+  bool WriteToFile(File* file,
+                   int process_id,
+                   const std::string& process_name,
+                   const hash_map<int, std::string>& thread_names) const;
+
+  // Releases the buffers of the current session.
+  void Clear();
+
+ private:
+  void StartSessionWhileLocked(size_t max_chunks_per_thread);
+
+  static void OnThreadExit(void* buffer);
+
+  ThreadLocalStorage::Slot thread_buffer_slot_;
+  subtle::Atomic32 session_id_;
+
+  mutable Lock lock_;
+  size_t max_chunks_per_thread_;
+  std::vector<scoped_refptr<TraceBinaryThreadBuffer>> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryRecorder);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_BINARY_BUFFER_H_
@@ -0,0 +1,356 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_binary_buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/location.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/trace_event/trace_binary_format.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const int kTestProcessId = 42;
+const char kTestCategory[] = "test";
+
+std::string SerializeTrace(const TraceBinaryThreadBuffer& buffer) {
+  std::string data(TraceBinaryFormat::kMagic,
+                   sizeof(TraceBinaryFormat::kMagic));
+  TraceBinaryFormat::AppendVarint(TraceBinaryFormat::kVersion, &data);
+  TraceBinaryFormat::AppendSignedVarint(kTestProcessId, &data);
+  TraceBinaryFormat::AppendString("test_process", &data);
+  buffer.Serialize("test_thread", &data);
+  return data;
+}
+
+std::unique_ptr<ListValue> ConvertTrace(const std::string& binary_trace) {
+  std::string json;
+  if (!ConvertBinaryTraceToJSON(binary_trace, &json))
+    return nullptr;
+  std::unique_ptr<Value> value = JSONReader::Read(json);
+  ListValue* list = nullptr;
+  if (!value || !value->GetAsList(&list))
+    return nullptr;
+  value.release();
+  return std::unique_ptr<ListValue>(list);
+}
+
+const DictionaryValue* FindEvent(const ListValue& events,
+                                 const std::string& name,
+                                 const std::string& phase) {
+  for (const auto& value : events) {
+    const DictionaryValue* event = nullptr;
+    std::string event_name;
+    std::string event_phase;
+    if (value->GetAsDictionary(&event) &&
+        event->GetString("name", &event_name) &&
+        event->GetString("ph", &event_phase) && event_name == name &&
+        event_phase == phase) {
+      return event;
+    }
+  }
+  return nullptr;
+}
+
+void AddInstantEvent(TraceBinaryThreadBuffer* buffer,
+                     const char* name,
+                     int64_t timestamp_us) {
+  buffer->AddEvent(TRACE_EVENT_PHASE_INSTANT, kTestCategory, name,
+                   trace_event_internal::kGlobalScope,
+                   trace_event_internal::kNoId, trace_event_internal::kNoId,
+                   buffer->thread_id(),
+                   TimeTicks::FromInternalValue(timestamp_us), ThreadTicks(),
+                   0, nullptr, nullptr, nullptr, nullptr,
+                   TRACE_EVENT_SCOPE_THREAD);
+}
+
+void EmitEventOnThread() {
+  TRACE_EVENT_INSTANT0(kTestCategory, "other thread",
+                       TRACE_EVENT_SCOPE_THREAD);
+}
+
+}  // namespace
+
+TEST(TraceBinaryFormatTest, Varints) {
+  const int64_t kValues[] = {0, 1, -1, 63, -64, 64, 300, -300, INT64_MAX,
+                             INT64_MIN};
+  std::string data;
+  for (int64_t value : kValues) {
+    TraceBinaryFormat::AppendSignedVarint(value, &data);
+    TraceBinaryFormat::AppendVarint(static_cast<uint64_t>(value), &data);
+  }
+  TraceBinaryReader reader(data);
+  for (int64_t value : kValues) {
+    int64_t signed_value;
+    uint64_t unsigned_value;
+    ASSERT_TRUE(reader.ReadSignedVarint(&signed_value));
+    EXPECT_EQ(value, signed_value);
+    ASSERT_TRUE(reader.ReadVarint(&unsigned_value));
+    EXPECT_EQ(static_cast<uint64_t>(value), unsigned_value);
+  }
+  EXPECT_TRUE(reader.IsAtEnd());
+
+  // Small magnitudes take a single byte whatever their sign.
+  std::string one_byte;
+  TraceBinaryFormat::AppendSignedVarint(-64, &one_byte);
+  EXPECT_EQ(1u, one_byte.size());
+
+  // A truncated varint is rejected.
+  TraceBinaryReader truncated(StringPiece("\x80\x80", 2));
+  uint64_t value;
+  EXPECT_FALSE(truncated.ReadVarint(&value));
+}
+
+TEST(TraceBinaryBufferTest, RoundTrip) {
+  scoped_refptr<TraceBinaryThreadBuffer> buffer(
+      new TraceBinaryThreadBuffer(1, 10, 4));
+
+  const char* arg_names[] = {"int", "string"};
+  const unsigned char arg_types[] = {TRACE_VALUE_TYPE_INT,
+                                     TRACE_VALUE_TYPE_COPY_STRING};
+  const char kString[] = "with \"quotes\"";
+  const unsigned long long arg_values[] = {
+      static_cast<unsigned long long>(-5),
+      reinterpret_cast<unsigned long long>(kString)};
+  buffer->AddEvent(TRACE_EVENT_PHASE_BEGIN, kTestCategory, "begin",
+                   trace_event_internal::kGlobalScope,
+                   trace_event_internal::kNoId, trace_event_internal::kNoId, 10,
+                   TimeTicks::FromInternalValue(1000),
+                   ThreadTicks::FromInternalValue(500), 2, arg_names, arg_types,
+                   arg_values, nullptr, TRACE_EVENT_FLAG_NONE);
+
+  std::unique_ptr<TracedValue> traced_value(new TracedValue);
+  traced_value->SetInteger("answer", 42);
+  std::unique_ptr<ConvertableToTraceFormat> convertables[] = {
+      nullptr, std::move(traced_value)};
+  const char* async_arg_names[] = {"double", "value"};
+  const unsigned char async_arg_types[] = {TRACE_VALUE_TYPE_DOUBLE,
+                                           TRACE_VALUE_TYPE_CONVERTABLE};
+  TraceEvent::TraceValue double_value;
+  double_value.as_double = 2.5;
+  const unsigned long long async_arg_values[] = {double_value.as_uint, 0};
+  buffer->AddEvent(TRACE_EVENT_PHASE_ASYNC_BEGIN, kTestCategory, "async",
+                   trace_event_internal::kGlobalScope, 0x1234,
+                   trace_event_internal::kNoId, 10,
+                   TimeTicks::FromInternalValue(1100), ThreadTicks(), 2,
+                   async_arg_names, async_arg_types, async_arg_values,
+                   convertables, TRACE_EVENT_FLAG_HAS_ID);
+
+  buffer->AddEvent(TRACE_EVENT_PHASE_END, kTestCategory, "begin",
+                   trace_event_internal::kGlobalScope,
+                   trace_event_internal::kNoId, trace_event_internal::kNoId, 11,
+                   TimeTicks::FromInternalValue(900),
+                   ThreadTicks::FromInternalValue(700), 0, nullptr, nullptr,
+                   nullptr, nullptr, TRACE_EVENT_FLAG_NONE);
+
+  std::unique_ptr<ListValue> events = ConvertTrace(SerializeTrace(*buffer));
+  ASSERT_TRUE(events);
+
+  const DictionaryValue* begin = FindEvent(*events, "begin", "B");
+  ASSERT_TRUE(begin);
+  int int_value;
+  std::string string_value;
+  EXPECT_TRUE(begin->GetInteger("pid", &int_value));
+  EXPECT_EQ(kTestProcessId, int_value);
+  EXPECT_TRUE(begin->GetInteger("tid", &int_value));
+  EXPECT_EQ(10, int_value);
+  EXPECT_TRUE(begin->GetInteger("ts", &int_value));
+  EXPECT_EQ(1000, int_value);
+  EXPECT_TRUE(begin->GetInteger("tts", &int_value));
+  EXPECT_EQ(500, int_value);
+  EXPECT_TRUE(begin->GetString("cat", &string_value));
+  EXPECT_EQ(kTestCategory, string_value);
+  EXPECT_TRUE(begin->GetInteger("args.int", &int_value));
+  EXPECT_EQ(-5, int_value);
+  EXPECT_TRUE(begin->GetString("args.string", &string_value));
+  EXPECT_EQ(kString, string_value);
+
+  const DictionaryValue* async = FindEvent(*events, "async", "S");
+  ASSERT_TRUE(async);
+  double real_value;
+  EXPECT_TRUE(async->GetDouble("args.double", &real_value));
+  EXPECT_EQ(2.5, real_value);
+  EXPECT_TRUE(async->GetInteger("args.value.answer", &int_value));
+  EXPECT_EQ(42, int_value);
+  EXPECT_TRUE(async->GetString("id", &string_value));
+  EXPECT_EQ("0x1234", string_value);
+  EXPECT_FALSE(async->HasKey("tts"));
+
+  // Timestamps going backwards and events for another thread are preserved.
+  const DictionaryValue* end = FindEvent(*events, "begin", "E");
+  ASSERT_TRUE(end);
+  EXPECT_TRUE(end->GetInteger("ts", &int_value));
+  EXPECT_EQ(900, int_value);
+  EXPECT_TRUE(end->GetInteger("tts", &int_value));
+  EXPECT_EQ(700, int_value);
+  EXPECT_TRUE(end->GetInteger("tid", &int_value));
+  EXPECT_EQ(11, int_value);
+
+  const DictionaryValue* thread_name =
+      FindEvent(*events, "thread_name", "M");
+  ASSERT_TRUE(thread_name);
+  EXPECT_TRUE(thread_name->GetString("args.name", &string_value));
+  EXPECT_EQ("test_thread", string_value);
+  EXPECT_TRUE(FindEvent(*events, "process_name", "M"));
+}
+
+// Once the ring is full the oldest chunks are recycled, and the remaining ones
+// still decode, in order.
+TEST(TraceBinaryBufferTest, RingDropsOldestChunks) {
+  const size_t kMaxChunks = 3;
+  scoped_refptr<TraceBinaryThreadBuffer> buffer(
+      new TraceBinaryThreadBuffer(1, 10, kMaxChunks));
+
+  // Comfortably more than |kMaxChunks| chunks worth of events.
+  const int kNumEvents =
+      static_cast<int>(kMaxChunks * TraceBinaryThreadBuffer::kChunkSize / 4);
+  std::vector<std::string> names;
+  for (int i = 0; i < kNumEvents; ++i)
+    names.push_back(StringPrintf("event%d", i));
+  for (int i = 0; i < kNumEvents; ++i) {
+    // Names are interned by address, so they must outlive the buffer.
+    AddInstantEvent(buffer.get(), names[i].c_str(), 1000 + i);
+  }
+
+  std::unique_ptr<ListValue> events = ConvertTrace(SerializeTrace(*buffer));
+  ASSERT_TRUE(events);
+  // Everything but the two metadata events.
+  const size_t num_events = events->GetSize() - 2;
+  EXPECT_LT(0u, num_events);
+  EXPECT_GT(static_cast<size_t>(kNumEvents), num_events);
+
+  int previous_timestamp = 0;
+  for (size_t i = 0; i < num_events; ++i) {
+    const DictionaryValue* event = nullptr;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    int timestamp;
+    std::string name;
+    ASSERT_TRUE(event->GetInteger("ts", &timestamp));
+    ASSERT_TRUE(event->GetString("name", &name));
+    EXPECT_EQ(names[timestamp - 1000], name);
+    EXPECT_LT(previous_timestamp, timestamp);
+    previous_timestamp = timestamp;
+  }
+  // The newest event is always kept.
+  EXPECT_EQ(1000 + kNumEvents - 1, previous_timestamp);
+}
+
+TEST(TraceBinaryBufferTest, RejectsMalformedTraces) {
+  scoped_refptr<TraceBinaryThreadBuffer> buffer(
+      new TraceBinaryThreadBuffer(1, 10, 1));
+  AddInstantEvent(buffer.get(), "event", 1000);
+  const std::string trace = SerializeTrace(*buffer);
+  std::string json;
+  EXPECT_TRUE(ConvertBinaryTraceToJSON(trace, &json));
+
+  // Truncated in the header and in the middle of the last block.
+  EXPECT_FALSE(ConvertBinaryTraceToJSON(StringPiece(trace.data(), 3), &json));
+  EXPECT_FALSE(ConvertBinaryTraceToJSON(
+      StringPiece(trace.data(), trace.size() - 1), &json));
+
+  std::string bad_magic = trace;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(ConvertBinaryTraceToJSON(bad_magic, &json));
+
+  std::string bad_version = trace;
+  bad_version[sizeof(TraceBinaryFormat::kMagic)] =
+      TraceBinaryFormat::kVersion + 1;
+  EXPECT_FALSE(ConvertBinaryTraceToJSON(bad_version, &json));
+}
+
+TEST(TraceBinaryBufferTest, TraceLogRecordBinary) {
+  TraceLog::DeleteForTesting();
+  TraceLog* trace_log = TraceLog::GetInstance();
+  trace_log->SetEnabled(TraceConfig(kTestCategory, RECORD_BINARY),
+                        TraceLog::RECORDING_MODE);
+
+  {
+    TRACE_EVENT1(kTestCategory, "scoped", "arg", 7);
+    TRACE_EVENT_INSTANT0(kTestCategory, "instant", TRACE_EVENT_SCOPE_THREAD);
+  }
+  TRACE_EVENT_INSTANT0("disabled_category", "ignored",
+                       TRACE_EVENT_SCOPE_THREAD);
+
+  Thread thread("BinaryTraceThread");
+  ASSERT_TRUE(thread.Start());
+  thread.task_runner()->PostTask(FROM_HERE, Bind(&EmitEventOnThread));
+  thread.Stop();
+
+  // Flushing is only possible once tracing is disabled.
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.path().AppendASCII("trace.bin");
+  EXPECT_FALSE(trace_log->FlushBinaryToFile(path));
+  trace_log->SetDisabled();
+  ASSERT_TRUE(trace_log->FlushBinaryToFile(path));
+
+  std::string binary_trace;
+  ASSERT_TRUE(ReadFileToString(path, &binary_trace));
+  std::unique_ptr<ListValue> events = ConvertTrace(binary_trace);
+  ASSERT_TRUE(events);
+
+  const DictionaryValue* begin = FindEvent(*events, "scoped", "B");
+  ASSERT_TRUE(begin);
+  int int_value;
+  EXPECT_TRUE(begin->GetInteger("args.arg", &int_value));
+  EXPECT_EQ(7, int_value);
+  EXPECT_TRUE(FindEvent(*events, "scoped", "E"));
+  EXPECT_TRUE(FindEvent(*events, "instant", "i"));
+  EXPECT_FALSE(FindEvent(*events, "ignored", "i"));
+
+  const DictionaryValue* other = FindEvent(*events, "other thread", "i");
+  ASSERT_TRUE(other);
+  int other_thread_id;
+  EXPECT_TRUE(other->GetInteger("tid", &other_thread_id));
+  EXPECT_NE(static_cast<int>(PlatformThread::CurrentId()), other_thread_id);
+
+  // The buffer of the thread outlives it, and is named after it.
+  bool found_thread_name = false;
+  for (const auto& value : *events) {
+    const DictionaryValue* event = nullptr;
+    std::string name;
+    if (value->GetAsDictionary(&event) && event->GetString("name", &name) &&
+        name == "thread_name" && event->GetInteger("tid", &int_value) &&
+        int_value == other_thread_id) {
+      std::string thread_name;
+      EXPECT_TRUE(event->GetString("args.name", &thread_name));
+      EXPECT_EQ("BinaryTraceThread", thread_name);
+      found_thread_name = true;
+    }
+  }
+  EXPECT_TRUE(found_thread_name);
+
+  // The events were discarded by the flush.
+  ASSERT_TRUE(trace_log->FlushBinaryToFile(path));
+  ASSERT_TRUE(ReadFileToString(path, &binary_trace));
+  events = ConvertTrace(binary_trace);
+  ASSERT_TRUE(events);
+  EXPECT_FALSE(FindEvent(*events, "scoped", "B"));
+
+  TraceLog::DeleteForTesting();
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,512 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_binary_format.h"
+
+#include <vector>
+
+#include "base/bit_cast.h"
+#include "base/format_macros.h"
+#include "base/json/string_escape.h"
+#include "base/process/process_handle.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_impl.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+// Longest LEB128 encoding of a 64-bit value.
+const int kMaxVarintBytes = 10;
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Decoding state of the thread whose blocks are being read.
+struct ThreadContext {
+  int process_id = 0;
+  int thread_id = 0;
+  std::vector<std::string> strings;
+};
+
+bool ReadStringRef(TraceBinaryReader* reader,
+                   const ThreadContext& context,
+                   StringPiece* value,
+                   bool* is_null) {
+  uint64_t ref;
+  if (!reader->ReadVarint(&ref))
+    return false;
+  *is_null = ref == 0;
+  if (*is_null) {
+    *value = StringPiece();
+    return true;
+  }
+  if (ref & 1)
+    return reader->ReadBytes(static_cast<size_t>(ref >> 1), value);
+  const uint64_t id = ref >> 1;
+  if (id > context.strings.size())
+    return false;
+  *value = context.strings[id - 1];
+  return true;
+}
+
+bool ReadStringRef(TraceBinaryReader* reader,
+                   const ThreadContext& context,
+                   StringPiece* value) {
+  bool is_null;
+  return ReadStringRef(reader, context, value, &is_null);
+}
+
+bool AppendArgumentValueAsJSON(TraceBinaryReader* reader,
+                               const ThreadContext& context,
+                               unsigned char type,
+                               std::string* out) {
+  TraceEvent::TraceValue value;
+  switch (type) {
+    case TRACE_VALUE_TYPE_BOOL: {
+      uint8_t byte;
+      if (!reader->ReadByte(&byte))
+        return false;
+      value.as_bool = byte != 0;
+      break;
+    }
+    case TRACE_VALUE_TYPE_UINT: {
+      uint64_t uint_value;
+      if (!reader->ReadVarint(&uint_value))
+        return false;
+      value.as_uint = uint_value;
+      break;
+    }
+    case TRACE_VALUE_TYPE_INT: {
+      int64_t int_value;
+      if (!reader->ReadSignedVarint(&int_value))
+        return false;
+      value.as_int = int_value;
+      break;
+    }
+    case TRACE_VALUE_TYPE_DOUBLE: {
+      StringPiece bytes;
+      if (!reader->ReadBytes(sizeof(uint64_t), &bytes))
+        return false;
+      uint64_t bits = 0;
+      for (size_t i = 0; i < sizeof(bits); ++i) {
+        bits |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i]))
+                << (8 * i);
+      }
+      value.as_double = bit_cast<double>(bits);
+      break;
+    }
+    case TRACE_VALUE_TYPE_POINTER: {
+      uint64_t pointer_value;
+      if (!reader->ReadVarint(&pointer_value))
+        return false;
+      // Only used for printing, so the value does not need to be a valid
+      // pointer in this process.
+      value.as_pointer =
+          reinterpret_cast<const void*>(static_cast<uintptr_t>(pointer_value));
+      break;
+    }
+    case TRACE_VALUE_TYPE_STRING:
+    case TRACE_VALUE_TYPE_COPY_STRING: {
+      StringPiece string_value;
+      bool is_null;
+      if (!ReadStringRef(reader, context, &string_value, &is_null))
+        return false;
+      const std::string terminated = string_value.as_string();
+      value.as_string = is_null ? nullptr : terminated.c_str();
+      TraceEvent::AppendValueAsJSON(type, value, out);
+      return true;
+    }
+    case TRACE_VALUE_TYPE_CONVERTABLE: {
+      StringPiece json;
+      if (!reader->ReadString(&json))
+        return false;
+      json.AppendToString(out);
+      return true;
+    }
+    default:
+      return false;
+  }
+  TraceEvent::AppendValueAsJSON(type, value, out);
+  return true;
+}
+
+// Decodes one event and appends it to |out| in the layout of
+// TraceEvent::AppendAsJSON().
+bool AppendEventAsJSON(TraceBinaryReader* reader,
+                       const ThreadContext& context,
+                       int64_t* timestamp,
+                       int64_t* thread_timestamp,
+                       std::string* out) {
+  uint8_t phase;
+  uint64_t flags;
+  uint8_t fields;
+  int64_t delta;
+  if (!reader->ReadByte(&phase) || !reader->ReadVarint(&flags) ||
+      !reader->ReadByte(&fields) || !reader->ReadSignedVarint(&delta)) {
+    return false;
+  }
+  *timestamp += delta;
+
+  const bool has_thread_timestamp =
+      (fields & TraceBinaryFormat::FIELD_THREAD_TIMESTAMP) != 0;
+  if (has_thread_timestamp) {
+    if (!reader->ReadSignedVarint(&delta))
+      return false;
+    *thread_timestamp += delta;
+  }
+
+  int process_id = context.process_id;
+  int thread_id = context.thread_id;
+  if (fields & TraceBinaryFormat::FIELD_THREAD_ID) {
+    int64_t explicit_id;
+    if (!reader->ReadSignedVarint(&explicit_id))
+      return false;
+    if ((flags & TRACE_EVENT_FLAG_HAS_PROCESS_ID) &&
+        explicit_id != kNullProcessId) {
+      process_id = static_cast<int>(explicit_id);
+      thread_id = -1;
+    } else {
+      thread_id = static_cast<int>(explicit_id);
+    }
+  }
+
+  StringPiece category;
+  StringPiece name;
+  if (!ReadStringRef(reader, context, &category) ||
+      !ReadStringRef(reader, context, &name)) {
+    return false;
+  }
+
+  StringPiece scope;
+  bool scope_is_null = true;
+  uint64_t id = 0;
+  if (flags & TRACE_EVENT_FLAG_HAS_ID) {
+    if (!ReadStringRef(reader, context, &scope, &scope_is_null) ||
+        !reader->ReadVarint(&id)) {
+      return false;
+    }
+  }
+
+  uint64_t bind_id = 0;
+  const bool has_flow =
+      (flags & (TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT)) != 0;
+  if (has_flow && !reader->ReadVarint(&bind_id))
+    return false;
+
+  StringAppendF(out, "{\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64
+                     ",\"ph\":\"%c\",\"cat\":\"",
+                process_id, thread_id, *timestamp, phase);
+  category.AppendToString(out);
+  *out += "\",\"name\":";
+  EscapeJSONString(name, true, out);
+  *out += ",\"args\":{";
+
+  uint8_t num_args;
+  if (!reader->ReadByte(&num_args))
+    return false;
+  for (uint8_t i = 0; i < num_args; ++i) {
+    StringPiece arg_name;
+    uint8_t type;
+    if (!ReadStringRef(reader, context, &arg_name) || !reader->ReadByte(&type))
+      return false;
+    if (i > 0)
+      *out += ",";
+    *out += "\"";
+    arg_name.AppendToString(out);
+    *out += "\":";
+    if (!AppendArgumentValueAsJSON(reader, context, type, out))
+      return false;
+  }
+  *out += "}";
+
+  if (has_thread_timestamp)
+    StringAppendF(out, ",\"tts\":%" PRId64, *thread_timestamp);
+
+  if (flags & TRACE_EVENT_FLAG_ASYNC_TTS)
+    StringAppendF(out, ", \"use_async_tts\":1");
+
+  if (flags & TRACE_EVENT_FLAG_HAS_ID) {
+    if (!scope_is_null) {
+      *out += ",\"scope\":\"";
+      scope.AppendToString(out);
+      *out += "\"";
+    }
+    StringAppendF(out, ",\"id\":\"0x%" PRIx64 "\"", id);
+  }
+
+  if (flags & TRACE_EVENT_FLAG_BIND_TO_ENCLOSING)
+    StringAppendF(out, ",\"bp\":\"e\"");
+
+  if (has_flow)
+    StringAppendF(out, ",\"bind_id\":\"0x%" PRIx64 "\"", bind_id);
+  if (flags & TRACE_EVENT_FLAG_FLOW_IN)
+    StringAppendF(out, ",\"flow_in\":true");
+  if (flags & TRACE_EVENT_FLAG_FLOW_OUT)
+    StringAppendF(out, ",\"flow_out\":true");
+
+  if (phase == TRACE_EVENT_PHASE_INSTANT) {
+    char instant_scope = '?';
+    switch (flags & TRACE_EVENT_FLAG_SCOPE_MASK) {
+      case TRACE_EVENT_SCOPE_GLOBAL:
+        instant_scope = TRACE_EVENT_SCOPE_NAME_GLOBAL;
+        break;
+
+      case TRACE_EVENT_SCOPE_PROCESS:
+        instant_scope = TRACE_EVENT_SCOPE_NAME_PROCESS;
+        break;
+
+      case TRACE_EVENT_SCOPE_THREAD:
+        instant_scope = TRACE_EVENT_SCOPE_NAME_THREAD;
+        break;
+    }
+    StringAppendF(out, ",\"s\":\"%c\"", instant_scope);
+  }
+
+  *out += "}";
+  return true;
+}
+
+void AppendMetadataEventAsJSON(int process_id,
+                               int thread_id,
+                               const char* metadata_name,
+                               StringPiece value,
+                               std::string* out) {
+  StringAppendF(out,
+                "{\"pid\":%i,\"tid\":%i,\"ts\":0,\"ph\":\"M\","
+                "\"cat\":\"__metadata\",\"name\":\"%s\",\"args\":{\"name\":",
+                process_id, thread_id, metadata_name);
+  EscapeJSONString(value, true, out);
+  *out += "}}";
+}
+
+void AppendSeparator(bool* first, std::string* out) {
+  if (!*first)
+    *out += ",\n";
+  *first = false;
+}
+
+}  // namespace
+
+const char TraceBinaryFormat::kMagic[4] = {'C', 'R', 'T', 'B'};
+const uint32_t TraceBinaryFormat::kVersion;
+
+// static
+void TraceBinaryFormat::AppendVarint(uint64_t value, std::string* out) {
+  char buffer[kMaxVarintBytes];
+  int length = 0;
+  while (value >= 0x80) {
+    buffer[length++] = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buffer[length++] = static_cast<char>(value);
+  out->append(buffer, length);
+}
+
+// static
+void TraceBinaryFormat::AppendSignedVarint(int64_t value, std::string* out) {
+  AppendVarint(ZigZagEncode(value), out);
+}
+
+// static
+void TraceBinaryFormat::AppendString(StringPiece value, std::string* out) {
+  AppendVarint(value.size(), out);
+  value.AppendToString(out);
+}
+
+// static
+void TraceBinaryFormat::AppendBlock(BlockType type,
+                                    StringPiece payload,
+                                    std::string* out) {
+  out->push_back(static_cast<char>(type));
+  AppendString(payload, out);
+}
+
+// static
+void TraceBinaryFormat::AppendNullStringRef(std::string* out) {
+  out->push_back(0);
+}
+
+// static
+void TraceBinaryFormat::AppendInternedStringRef(uint32_t id,
+                                                std::string* out) {
+  DCHECK_NE(0u, id);
+  AppendVarint(static_cast<uint64_t>(id) << 1, out);
+}
+
+// static
+void TraceBinaryFormat::AppendInlineStringRef(StringPiece value,
+                                              std::string* out) {
+  AppendVarint((static_cast<uint64_t>(value.size()) << 1) | 1, out);
+  value.AppendToString(out);
+}
+
+TraceBinaryReader::TraceBinaryReader(StringPiece data) : data_(data) {}
+
+bool TraceBinaryReader::ReadByte(uint8_t* value) {
+  if (data_.empty())
+    return false;
+  *value = static_cast<uint8_t>(data_[0]);
+  data_.remove_prefix(1);
+  return true;
+}
+
+bool TraceBinaryReader::ReadVarint(uint64_t* value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < data_.size() && i < kMaxVarintBytes; ++i) {
+    const uint8_t byte = static_cast<uint8_t>(data_[i]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if (!(byte & 0x80)) {
+      data_.remove_prefix(i + 1);
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TraceBinaryReader::ReadSignedVarint(int64_t* value) {
+  uint64_t encoded;
+  if (!ReadVarint(&encoded))
+    return false;
+  *value = ZigZagDecode(encoded);
+  return true;
+}
+
+bool TraceBinaryReader::ReadBytes(size_t length, StringPiece* value) {
+  if (length > data_.size())
+    return false;
+  *value = data_.substr(0, length);
+  data_.remove_prefix(length);
+  return true;
+}
+
+bool TraceBinaryReader::ReadString(StringPiece* value) {
+  StringPiece original = data_;
+  uint64_t length;
+  if (!ReadVarint(&length))
+    return false;
+  if (length > data_.size()) {
+    data_ = original;
+    return false;
+  }
+  return ReadBytes(static_cast<size_t>(length), value);
+}
+
+bool ConvertBinaryTraceToJSON(StringPiece binary_trace, std::string* json) {
+  TraceBinaryReader reader(binary_trace);
+  StringPiece magic;
+  uint64_t version;
+  int64_t process_id;
+  StringPiece process_name;
+  if (!reader.ReadBytes(sizeof(TraceBinaryFormat::kMagic), &magic) ||
+      magic != StringPiece(TraceBinaryFormat::kMagic,
+                           sizeof(TraceBinaryFormat::kMagic)) ||
+      !reader.ReadVarint(&version) ||
+      version != TraceBinaryFormat::kVersion ||
+      !reader.ReadSignedVarint(&process_id) ||
+      !reader.ReadString(&process_name)) {
+    return false;
+  }
+
+  ThreadContext context;
+  context.process_id = static_cast<int>(process_id);
+  bool has_thread = false;
+
+  // Metadata events are collected separately and emitted after the events,
+  // as TraceLog::Flush() does.
+  std::string metadata;
+  bool first_metadata = true;
+  if (!process_name.empty()) {
+    AppendSeparator(&first_metadata, &metadata);
+    AppendMetadataEventAsJSON(context.process_id, 0, "process_name",
+                              process_name, &metadata);
+  }
+
+  std::string events;
+  bool first_event = true;
+  while (!reader.IsAtEnd()) {
+    uint8_t type;
+    StringPiece payload;
+    if (!reader.ReadByte(&type) || !reader.ReadString(&payload))
+      return false;
+    TraceBinaryReader block(payload);
+
+    switch (type) {
+      case TraceBinaryFormat::BLOCK_THREAD: {
+        int64_t thread_id;
+        StringPiece thread_name;
+        if (!block.ReadSignedVarint(&thread_id) ||
+            !block.ReadString(&thread_name)) {
+          return false;
+        }
+        has_thread = true;
+        context.thread_id = static_cast<int>(thread_id);
+        context.strings.clear();
+        if (!thread_name.empty()) {
+          AppendSeparator(&first_metadata, &metadata);
+          AppendMetadataEventAsJSON(context.process_id, context.thread_id,
+                                    "thread_name", thread_name, &metadata);
+        }
+        break;
+      }
+
+      case TraceBinaryFormat::BLOCK_STRINGS: {
+        uint64_t first_id;
+        uint64_t count;
+        if (!has_thread || !block.ReadVarint(&first_id) ||
+            first_id != context.strings.size() + 1 ||
+            !block.ReadVarint(&count)) {
+          return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+          StringPiece value;
+          if (!block.ReadString(&value))
+            return false;
+          context.strings.push_back(value.as_string());
+        }
+        break;
+      }
+
+      case TraceBinaryFormat::BLOCK_EVENTS: {
+        uint64_t sequence_number;
+        if (!has_thread || !block.ReadVarint(&sequence_number))
+          return false;
+        int64_t timestamp = 0;
+        int64_t thread_timestamp = 0;
+        while (!block.IsAtEnd()) {
+          AppendSeparator(&first_event, &events);
+          if (!AppendEventAsJSON(&block, context, &timestamp,
+                                 &thread_timestamp, &events)) {
+            return false;
+          }
+        }
+        break;
+      }
+
+      default:
+        // Blocks added by later versions of the format are skipped.
+        break;
+    }
+  }
+
+  json->append("[");
+  json->append(events);
+  if (!events.empty() && !metadata.empty())
+    json->append(",\n");
+  json->append(metadata);
+  json->append("]");
+  return true;
+}
+
+}  // namespace trace_event
+}  // namespace base
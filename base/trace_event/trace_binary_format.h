@@ -0,0 +1,128 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
+#define BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+// The binary trace format is written by TraceLog::FlushBinaryToFile() when
+// tracing with RECORD_BINARY. It is a compact, append-only encoding of trace
+// events that can be produced without any JSON formatting on the traced
+// process, and converted to the regular JSON trace format offline with
+// ConvertBinaryTraceToJSON() (or the trace_binary_to_json tool).
+//
+// All integers are LEB128 varints; signed integers are zigzag-encoded first.
+// Strings are a varint length followed by the bytes.
+//
+// File:
+//   magic "CRTB", version, process id (signed), process name (string),
+//   followed by blocks. Each block is a type byte, a varint payload length
+//   and the payload. Blocks describe the thread announced by the most recent
+//   THREAD block.
+//
+//   THREAD:  thread id (signed), thread name (string).
+//   STRINGS: id of the first string, number of strings, the strings. Ids are
+//            assigned sequentially per thread starting at 1.
+//   EVENTS:  sequence number of the chunk, then events until the end of the
+//            payload. EVENTS blocks of a thread are written in the order they
+//            were recorded.
+//
+// Event:
+//   phase (byte), flags (varint), field mask (byte),
+//   timestamp delta in microseconds (signed, relative to the previous event
+//   of the block, or to zero for the first one),
+//   [thread timestamp delta]   if FIELD_THREAD_TIMESTAMP, relative likewise,
+//   [thread or process id]     if FIELD_THREAD_ID (signed),
+//   category (string ref), name (string ref),
+//   [scope (string ref), id]   if TRACE_EVENT_FLAG_HAS_ID,
+//   [bind id]                  if TRACE_EVENT_FLAG_FLOW_IN / FLOW_OUT,
+//   argument count (byte), then per argument its name (string ref), its
+//   TRACE_VALUE_TYPE_* (byte) and its value: a byte for bools, a varint for
+//   unsigned ints and pointers, a signed varint for ints, 8 little-endian
+//   bytes for doubles, a string ref for strings and a string with the JSON
+//   representation for convertables.
+//
+// A string ref is a varint: 0 for a null string, (id << 1) for an interned
+// string, or (length << 1) | 1 followed by the bytes for an inline string.
+// Because each EVENTS block restarts its deltas, any block can be decoded on
+// its own once the string table of its thread is known, so a ring buffer can
+// drop whole blocks without corrupting the rest of the trace.
+
+namespace base {
+namespace trace_event {
+
+class BASE_EXPORT TraceBinaryFormat {
+ public:
+  static const char kMagic[4];
+  static const uint32_t kVersion = 1;
+
+  enum BlockType : uint8_t {
+    BLOCK_THREAD = 1,
+    BLOCK_STRINGS = 2,
+    BLOCK_EVENTS = 3,
+  };
+
+  enum EventField : uint8_t {
+    FIELD_THREAD_TIMESTAMP = 1 << 0,
+    FIELD_THREAD_ID = 1 << 1,
+  };
+
+  static void AppendVarint(uint64_t value, std::string* out);
+  static void AppendSignedVarint(int64_t value, std::string* out);
+  static void AppendString(StringPiece value, std::string* out);
+
+  // Appends a block header followed by |payload|.
+  static void AppendBlock(BlockType type,
+                          StringPiece payload,
+                          std::string* out);
+
+  static void AppendNullStringRef(std::string* out);
+  static void AppendInternedStringRef(uint32_t id, std::string* out);
+  static void AppendInlineStringRef(StringPiece value, std::string* out);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(TraceBinaryFormat);
+};
+
+// Bounds-checked reader for the primitives of TraceBinaryFormat. Every Read*()
+// method returns false, without consuming anything, if the input is
+// truncated or malformed.
+class BASE_EXPORT TraceBinaryReader {
+ public:
+  explicit TraceBinaryReader(StringPiece data);
+
+  bool ReadByte(uint8_t* value);
+  bool ReadVarint(uint64_t* value);
+  bool ReadSignedVarint(int64_t* value);
+  bool ReadBytes(size_t length, StringPiece* value);
+  bool ReadString(StringPiece* value);
+
+  bool IsAtEnd() const { return data_.empty(); }
+  StringPiece remaining() const { return data_; }
+
+ private:
+  StringPiece data_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryReader);
+};
+
+// Converts a trace in the binary format to the JSON trace format, i.e. a JSON
+// array of the events in the same layout TraceLog::Flush() produces, followed
+// by process_name and thread_name metadata events. Returns false if
+// |binary_trace| is malformed.
+BASE_EXPORT bool ConvertBinaryTraceToJSON(StringPiece binary_trace,
+                                          std::string* json);
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
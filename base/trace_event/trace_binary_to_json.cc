@@ -0,0 +1,61 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Converts a trace written by TraceLog::FlushBinaryToFile() to the JSON trace
+// format, so it can be loaded in about:tracing or by the trace viewer.
+//
+// Usage: trace_binary_to_json <binary trace> [<output json>]
+// The JSON is written to stdout if no output file is given.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/trace_event/trace_binary_format.h"
+
+int main(int argc, char* argv[]) {
+  base::CommandLine::Init(argc, argv);
+  logging::LoggingSettings settings;
+  settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG;
+  logging::InitLogging(settings);
+
+  const base::CommandLine::StringVector& args =
+      base::CommandLine::ForCurrentProcess()->GetArgs();
+  if (args.empty() || args.size() > 2) {
+    fprintf(stderr, "Usage: %s <binary trace> [<output json>]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const base::FilePath input(args[0]);
+  std::string binary_trace;
+  if (!base::ReadFileToString(input, &binary_trace)) {
+    fprintf(stderr, "Couldn't read '%s'\n", input.AsUTF8Unsafe().c_str());
+    return EXIT_FAILURE;
+  }
+
+  std::string json;
+  if (!base::trace_event::ConvertBinaryTraceToJSON(binary_trace, &json)) {
+    fprintf(stderr, "'%s' is not a valid binary trace\n",
+            input.AsUTF8Unsafe().c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (args.size() == 1) {
+    fwrite(json.data(), 1, json.size(), stdout);
+    return EXIT_SUCCESS;
+  }
+
+  const base::FilePath output(args[1]);
+  if (base::WriteFile(output, json.data(), static_cast<int>(json.size())) !=
+      static_cast<int>(json.size())) {
+    fprintf(stderr, "Couldn't write '%s'\n", output.AsUTF8Unsafe().c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -29,6 +29,7 @@ const char kRecordUntilFull[] = "record-until-full";
 const char kRecordContinuously[] = "record-continuously";
 const char kRecordAsMuchAsPossible[] = "record-as-much-as-possible";
 const char kTraceToConsole[] = "trace-to-console";
+const char kRecordBinary[] = "record-binary";
 const char kEnableSampling[] = "enable-sampling";
 const char kEnableSystrace[] = "enable-systrace";
 const char kEnableArgumentFilter[] = "enable-argument-filter";
@@ -122,6 +123,9 @@ TraceConfig::TraceConfig(const std::string& category_filter_string,
     case ECHO_TO_CONSOLE:
       trace_options_string = kTraceToConsole;
       break;
+    case RECORD_BINARY:
+      trace_options_string = kRecordBinary;
+      break;
     default:
       NOTREACHED();
   }
@@ -327,6 +331,8 @@ void TraceConfig::InitializeFromConfigDict(const DictionaryValue& dict) {
       record_mode_ = ECHO_TO_CONSOLE;
     } else if (record_mode == kRecordAsMuchAsPossible) {
       record_mode_ = RECORD_AS_MUCH_AS_POSSIBLE;
+    } else if (record_mode == kRecordBinary) {
+      record_mode_ = RECORD_BINARY;
     }
   }
 
@@ -437,6 +443,8 @@ void TraceConfig::InitializeFromStrings(
         record_mode_ = ECHO_TO_CONSOLE;
       } else if (*iter == kRecordAsMuchAsPossible) {
         record_mode_ = RECORD_AS_MUCH_AS_POSSIBLE;
+      } else if (*iter == kRecordBinary) {
+        record_mode_ = RECORD_BINARY;
       } else if (*iter == kEnableSampling) {
         enable_sampling_ = true;
       } else if (*iter == kEnableSystrace) {
@@ -575,6 +583,9 @@ void TraceConfig::ToDict(base::DictionaryValue& dict) const {
     case ECHO_TO_CONSOLE:
       dict.SetString(kRecordModeParam, kTraceToConsole);
       break;
+    case RECORD_BINARY:
+      dict.SetString(kRecordModeParam, kRecordBinary);
+      break;
     default:
       NOTREACHED();
   }
@@ -650,6 +661,9 @@ std::string TraceConfig::ToTraceOptionsString() const {
     case ECHO_TO_CONSOLE:
       ret = kTraceToConsole;
       break;
+    case RECORD_BINARY:
+      ret = kRecordBinary;
+      break;
     default:
       NOTREACHED();
   }
@@ -34,6 +34,11 @@ enum TraceRecordMode {
 
   // Echo to console. Events are discarded.
   ECHO_TO_CONSOLE,
+
+  // Record into per-thread ring buffers in the binary trace format, without
+  // taking the trace log lock. The trace is retrieved with
+  // TraceLog::FlushBinaryToFile() rather than TraceLog::Flush().
+  RECORD_BINARY,
 };
 
 class BASE_EXPORT TraceConfig {
@@ -86,9 +91,9 @@ class BASE_EXPORT TraceConfig {
   //
   // |trace_options_string| is a comma-delimited list of trace options.
   // Possible options are: "record-until-full", "record-continuously",
-  // "record-as-much-as-possible", "trace-to-console", "enable-sampling",
-  // "enable-systrace" and "enable-argument-filter".
-  // The first 4 options are trace recoding modes and hence
+  // "record-as-much-as-possible", "trace-to-console", "record-binary",
+  // "enable-sampling", "enable-systrace" and "enable-argument-filter".
+  // The first 5 options are trace recoding modes and hence
   // mutually exclusive. If more than one trace recording modes appear in the
   // options_string, the last one takes precedence. If none of the trace
   // recording mode is specified, recording mode is RECORD_UNTIL_FULL.
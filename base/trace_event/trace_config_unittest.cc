@@ -73,6 +73,13 @@ TEST(TraceConfigTest, TraceConfigFromValidLegacyFormat) {
   EXPECT_FALSE(config.IsArgumentFilterEnabled());
   EXPECT_STREQ("trace-to-console", config.ToTraceOptionsString().c_str());
 
+  config = TraceConfig("", "record-binary");
+  EXPECT_EQ(RECORD_BINARY, config.GetTraceRecordMode());
+  EXPECT_FALSE(config.IsSamplingEnabled());
+  EXPECT_FALSE(config.IsSystraceEnabled());
+  EXPECT_FALSE(config.IsArgumentFilterEnabled());
+  EXPECT_STREQ("record-binary", config.ToTraceOptionsString().c_str());
+
   config = TraceConfig("", "record-as-much-as-possible");
   EXPECT_EQ(RECORD_AS_MUCH_AS_POSSIBLE, config.GetTraceRecordMode());
   EXPECT_FALSE(config.IsSamplingEnabled());
@@ -146,6 +153,10 @@ TEST(TraceConfigTest, TraceConfigFromValidLegacyFormat) {
   EXPECT_FALSE(config.IsArgumentFilterEnabled());
   EXPECT_STREQ("trace-to-console", config.ToTraceOptionsString().c_str());
 
+  config = TraceConfig("", RECORD_BINARY);
+  EXPECT_EQ(RECORD_BINARY, config.GetTraceRecordMode());
+  EXPECT_STREQ("record-binary", config.ToTraceOptionsString().c_str());
+
   config = TraceConfig("", RECORD_AS_MUCH_AS_POSSIBLE);
   EXPECT_EQ(RECORD_AS_MUCH_AS_POSSIBLE, config.GetTraceRecordMode());
   EXPECT_FALSE(config.IsSamplingEnabled());
@@ -13,6 +13,8 @@
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/debug/leak_annotations.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
 #include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/macros.h"
@@ -621,6 +623,11 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
 
     num_traces_recorded_++;
 
+    if (new_options & kInternalRecordBinary) {
+      binary_recorder_.StartSession(
+          TraceBinaryRecorder::kDefaultMaxChunksPerThread);
+    }
+
     trace_config_ = TraceConfig(trace_config);
     UpdateCategoryGroupEnabledFlags();
     UpdateSyntheticDelaysFromTraceConfig();
@@ -684,6 +691,8 @@ TraceLog::InternalTraceOptions TraceLog::GetInternalOptionsFromTraceConfig(
       return ret | kInternalEchoToConsole;
     case RECORD_AS_MUCH_AS_POSSIBLE:
       return ret | kInternalRecordAsMuchAsPossible;
+    case RECORD_BINARY:
+      return ret | kInternalRecordBinary;
   }
   NOTREACHED();
   return kInternalNone;
@@ -862,9 +871,37 @@ void TraceLog::Flush(const TraceLog::OutputCallback& cb,
 
 void TraceLog::CancelTracing(const OutputCallback& cb) {
   SetDisabled();
+  binary_recorder_.Clear();
   FlushInternal(cb, false, true);
 }
 
+bool TraceLog::FlushBinaryToFile(const FilePath& path) {
+  std::string process_name;
+  {
+    AutoLock lock(lock_);
+    if (IsEnabled()) {
+      LOG(WARNING) << "Ignored TraceLog::FlushBinaryToFile called when "
+                   << "tracing is enabled";
+      return false;
+    }
+    process_name = process_name_;
+  }
+
+  hash_map<int, std::string> thread_names;
+  {
+    AutoLock thread_info_lock(thread_info_lock_);
+    thread_names = thread_names_;
+  }
+
+  File file(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE);
+  const bool success =
+      file.IsValid() && binary_recorder_.WriteToFile(&file, process_id_,
+                                                     process_name,
+                                                     thread_names);
+  binary_recorder_.Clear();
+  return success;
+}
+
 void TraceLog::FlushInternal(const TraceLog::OutputCallback& cb,
                              bool use_worker_thread,
                              bool discard_events) {
@@ -1218,10 +1255,16 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
   TimeTicks offset_event_timestamp = OffsetTimestamp(timestamp);
   ThreadTicks thread_now = ThreadNow();
 
+  // Binary recording bypasses |logged_events_| and its buffers entirely.
+  const bool record_binary = (trace_options() & kInternalRecordBinary) != 0;
+
   // |thread_local_event_buffer_| can be null if the current thread doesn't have
   // a message loop or the message loop is blocked.
-  InitializeThreadLocalEventBufferIfSupported();
-  auto thread_local_event_buffer = thread_local_event_buffer_.Get();
+  ThreadLocalEventBuffer* thread_local_event_buffer = nullptr;
+  if (!record_binary) {
+    InitializeThreadLocalEventBufferIfSupported();
+    thread_local_event_buffer = thread_local_event_buffer_.Get();
+  }
 
   // Check and update the current thread name only if the event is for the
   // current thread to avoid locks in most cases.
@@ -1270,7 +1313,15 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
 #endif  // OS_WIN
 
   std::string console_message;
-  if (*category_group_enabled & ENABLED_FOR_RECORDING) {
+  if ((*category_group_enabled & ENABLED_FOR_RECORDING) && record_binary) {
+    // Complete events are recorded as a begin event, and the matching end
+    // event is added by UpdateTraceEventDuration().
+    binary_recorder_.GetBufferForCurrentThread()->AddEvent(
+        phase == TRACE_EVENT_PHASE_COMPLETE ? TRACE_EVENT_PHASE_BEGIN : phase,
+        GetCategoryGroupName(category_group_enabled), name, scope, id, bind_id,
+        thread_id, offset_event_timestamp, thread_now, num_args, arg_names,
+        arg_types, arg_values, convertable_values, flags);
+  } else if (*category_group_enabled & ENABLED_FOR_RECORDING) {
     OptionalAutoLock lock(&lock_);
 
     TraceEvent* trace_event = NULL;
@@ -1462,7 +1513,17 @@ void TraceLog::UpdateTraceEventDuration(
   if (category_group_enabled_local & ENABLED_FOR_RECORDING) {
     OptionalAutoLock lock(&lock_);
 
-    TraceEvent* trace_event = GetEventByHandleInternal(handle, &lock);
+    TraceEvent* trace_event = nullptr;
+    if (trace_options() & kInternalRecordBinary) {
+      binary_recorder_.GetBufferForCurrentThread()->AddEvent(
+          TRACE_EVENT_PHASE_END, GetCategoryGroupName(category_group_enabled),
+          name, trace_event_internal::kGlobalScope, trace_event_internal::kNoId,
+          trace_event_internal::kNoId,
+          static_cast<int>(PlatformThread::CurrentId()), now, thread_now, 0,
+          nullptr, nullptr, nullptr, nullptr, TRACE_EVENT_FLAG_NONE);
+    } else {
+      trace_event = GetEventByHandleInternal(handle, &lock);
+    }
     if (trace_event) {
       DCHECK(trace_event->phase() == TRACE_EVENT_PHASE_COMPLETE);
       trace_event->UpdateDuration(now, thread_now);
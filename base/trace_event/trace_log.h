@@ -18,6 +18,7 @@
 #include "base/macros.h"
 #include "base/memory/scoped_vector.h"
 #include "base/trace_event/memory_dump_provider.h"
+#include "base/trace_event/trace_binary_buffer.h"
 #include "base/trace_event/trace_config.h"
 #include "base/trace_event/trace_event_impl.h"
 #include "build/build_config.h"
@@ -26,6 +27,7 @@ namespace base {
 
 template <typename Type>
 struct DefaultSingletonTraits;
+class FilePath;
 class RefCountedString;
 
 namespace trace_event {
@@ -193,6 +195,14 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   // Cancels tracing and discards collected data.
   void CancelTracing(const OutputCallback& cb);
 
+  // Writes the events recorded in RECORD_BINARY mode to |path| in the binary
+  // trace format (see trace_binary_format.h) and discards them. Like Flush(),
+  // this can only be done when tracing is disabled. Unlike Flush(), no JSON is
+  // produced and the file is written synchronously on the calling thread, so
+  // this must be called on a thread that allows blocking IO. Returns false if
+  // tracing is enabled or the file could not be written.
+  bool FlushBinaryToFile(const FilePath& path);
+
   // Called by TRACE_EVENT* macros, don't call this directly.
   // The name parameter is a category group for example:
   // TRACE_EVENT0("renderer,webkit", "WebViewImpl::HandleInputEvent")
@@ -451,6 +461,7 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   static const InternalTraceOptions kInternalEnableSampling;
   static const InternalTraceOptions kInternalRecordAsMuchAsPossible;
   static const InternalTraceOptions kInternalEnableArgumentFilter;
+  static const InternalTraceOptions kInternalRecordBinary;
 
   // This lock protects TraceLog member accesses (except for members protected
   // by thread_info_lock_) from arbitrary threads.
@@ -515,6 +526,9 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   std::unique_ptr<TraceBufferChunk> thread_shared_chunk_;
   size_t thread_shared_chunk_index_;
 
+  // Per-thread buffers used instead of |logged_events_| in RECORD_BINARY mode.
+  TraceBinaryRecorder binary_recorder_;
+
   // Set when asynchronous Flush is in progress.
   OutputCallback flush_output_callback_;
   scoped_refptr<SingleThreadTaskRunner> flush_task_runner_;
@@ -22,6 +22,8 @@ const TraceLog::InternalTraceOptions
     TraceLog::kInternalRecordAsMuchAsPossible = 1 << 4;
 const TraceLog::InternalTraceOptions
     TraceLog::kInternalEnableArgumentFilter = 1 << 5;
+const TraceLog::InternalTraceOptions
+    TraceLog::kInternalRecordBinary = 1 << 6;
 
 }  // namespace trace_event
 }  // namespace base
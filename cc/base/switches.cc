@@ -44,6 +44,10 @@ const char kSlowDownRasterScaleFactor[] = "slow-down-raster-scale-factor";
 // Compress tile textures for GPUs supporting it.
 const char kEnableTileCompression[] = "enable-tile-compression";
 
+// Updates the property trees and computes the draw properties of the layers
+// on the compositor worker threads as well as on the compositor thread.
+const char kEnableParallelDrawProperties[] = "enable-parallel-draw-properties";
+
 // Use a BeginFrame signal from browser to renderer to schedule rendering.
 const char kEnableBeginFrameScheduling[] = "enable-begin-frame-scheduling";
 
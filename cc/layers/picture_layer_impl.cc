@@ -633,8 +633,10 @@ void PictureLayerImpl::NotifyTileStateChanged(const Tile* tile) {
   if (tile->draw_info().NeedsRaster()) {
     PictureLayerTiling* tiling =
         tilings_->FindTilingWithScale(tile->contents_scale());
-    if (tiling)
+    if (tiling) {
       tiling->set_all_tiles_done(false);
+      tiling->InvalidateRasterOrder();
+    }
   }
 }
 
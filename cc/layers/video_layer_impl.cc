@@ -104,7 +104,8 @@ bool VideoLayerImpl::WillDraw(DrawMode draw_mode,
   if (!updater_) {
     updater_.reset(
         new VideoResourceUpdater(layer_tree_impl()->context_provider(),
-                                 layer_tree_impl()->resource_provider()));
+                                 layer_tree_impl()->resource_provider(),
+                                 layer_tree_impl()->task_graph_runner()));
   }
 
   VideoFrameExternalResources external_resources =
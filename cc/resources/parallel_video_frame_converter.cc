@@ -0,0 +1,215 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/resources/parallel_video_frame_converter.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
+#include "cc/base/completion_event.h"
+#include "cc/raster/task_category.h"
+#include "media/base/video_frame.h"
+#include "media/renderers/skcanvas_video_renderer.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace cc {
+namespace {
+
+// Returns true if the rows of |format| can be converted independently. High
+// bit depth frames are first copied to a temporary 8 bit frame of the size of
+// the whole frame, so they are converted in one go.
+bool CanSliceFormat(media::VideoPixelFormat format) {
+  switch (format) {
+    case media::PIXEL_FORMAT_I420:
+    case media::PIXEL_FORMAT_YV12:
+    case media::PIXEL_FORMAT_YV16:
+    case media::PIXEL_FORMAT_YV12A:
+    case media::PIXEL_FORMAT_YV24:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The slices of one ConvertToRGBPixels() call. Slices are claimed with an
+// atomic counter, so each one is converted exactly once by whichever thread
+// gets to it first.
+class FrameConversionWork
+    : public base::RefCountedThreadSafe<FrameConversionWork> {
+ public:
+  FrameConversionWork() : next_slice_(0), finished_slices_(0) {}
+
+  void AddSlice(scoped_refptr<media::VideoFrame> frame,
+                uint8_t* rgb_pixels,
+                size_t row_bytes) {
+    slices_.push_back(Slice{std::move(frame), rgb_pixels, row_bytes});
+  }
+
+  size_t num_slices() const { return slices_.size(); }
+
+  // Converts slices until there are none left to claim.
+  void RunSlices() {
+    size_t finished_slices = 0;
+    for (;;) {
+      size_t index = static_cast<size_t>(
+          base::subtle::NoBarrier_AtomicIncrement(&next_slice_, 1) - 1);
+      if (index >= slices_.size())
+        break;
+      const Slice& slice = slices_[index];
+      media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+          slice.frame.get(), slice.rgb_pixels, slice.row_bytes);
+      ++finished_slices;
+    }
+    if (!finished_slices)
+      return;
+
+    // Signaling the event also publishes the converted pixels to the thread
+    // waiting in WaitForAllSlices().
+    base::AutoLock lock(lock_);
+    finished_slices_ += finished_slices;
+    if (finished_slices_ == slices_.size())
+      all_slices_finished_.Signal();
+  }
+
+  // Must be called exactly once, by the thread that added the slices.
+  void WaitForAllSlices() { all_slices_finished_.Wait(); }
+
+ private:
+  friend class base::RefCountedThreadSafe<FrameConversionWork>;
+
+  struct Slice {
+    scoped_refptr<media::VideoFrame> frame;
+    uint8_t* rgb_pixels;
+    size_t row_bytes;
+  };
+
+  ~FrameConversionWork() {}
+
+  // Not modified once slices start being claimed.
+  std::vector<Slice> slices_;
+
+  base::subtle::Atomic32 next_slice_;
+
+  base::Lock lock_;
+  size_t finished_slices_;
+  CompletionEvent all_slices_finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameConversionWork);
+};
+
+class FrameConversionTask : public Task {
+ public:
+  explicit FrameConversionTask(scoped_refptr<FrameConversionWork> work)
+      : work_(std::move(work)) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override {
+    TRACE_EVENT0("cc", "FrameConversionTask::RunOnWorkerThread");
+    work_->RunSlices();
+  }
+
+ protected:
+  ~FrameConversionTask() override {}
+
+ private:
+  scoped_refptr<FrameConversionWork> work_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameConversionTask);
+};
+
+}  // namespace
+
+ParallelVideoFrameConverter::ParallelVideoFrameConverter(
+    TaskGraphRunner* task_graph_runner,
+    size_t max_worker_tasks)
+    : task_graph_runner_(task_graph_runner),
+      max_worker_tasks_(task_graph_runner ? max_worker_tasks : 0) {
+  if (task_graph_runner_)
+    namespace_token_ = task_graph_runner_->GetNamespaceToken();
+}
+
+ParallelVideoFrameConverter::~ParallelVideoFrameConverter() {
+  if (!task_graph_runner_)
+    return;
+  // Tasks that found no slice left may still be running.
+  graph_.Reset();
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+  task_graph_runner_->WaitForTasksToFinishRunning(namespace_token_);
+  task_graph_runner_->CollectCompletedTasks(namespace_token_,
+                                            &completed_tasks_);
+}
+
+void ParallelVideoFrameConverter::ConvertToRGBPixels(
+    const scoped_refptr<media::VideoFrame>& video_frame,
+    void* rgb_pixels,
+    size_t row_bytes) {
+  TRACE_EVENT0("cc", "ParallelVideoFrameConverter::ConvertToRGBPixels");
+  const gfx::Rect& visible_rect = video_frame->visible_rect();
+  if (!max_worker_tasks_ || !CanSliceFormat(video_frame->format()) ||
+      visible_rect.height() <= kRowsPerSlice) {
+    media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+        video_frame.get(), rgb_pixels, row_bytes);
+    return;
+  }
+
+  // Wrapping frames share the planes of |video_frame| and only differ by
+  // their visible rect, so each slice starts on its own rows of the planes.
+  std::vector<scoped_refptr<media::VideoFrame>> slice_frames;
+  for (int y = 0; y < visible_rect.height(); y += kRowsPerSlice) {
+    gfx::Rect slice_rect(visible_rect.x(), visible_rect.y() + y,
+                         visible_rect.width(),
+                         std::min(kRowsPerSlice, visible_rect.height() - y));
+    slice_frames.push_back(media::VideoFrame::WrapVideoFrame(
+        video_frame, video_frame->format(), slice_rect, slice_rect.size()));
+    if (!slice_frames.back()) {
+      media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+          video_frame.get(), rgb_pixels, row_bytes);
+      return;
+    }
+  }
+
+  // Only created once it is certain to be waited for.
+  scoped_refptr<FrameConversionWork> work(new FrameConversionWork);
+  for (size_t i = 0; i < slice_frames.size(); ++i) {
+    work->AddSlice(
+        std::move(slice_frames[i]),
+        static_cast<uint8_t*>(rgb_pixels) + i * kRowsPerSlice * row_bytes,
+        row_bytes);
+  }
+
+  // Release the tasks of the previous call that finished since.
+  task_graph_runner_->CollectCompletedTasks(namespace_token_,
+                                            &completed_tasks_);
+  completed_tasks_.clear();
+
+  // The calling thread converts slices too.
+  size_t num_worker_tasks =
+      std::min(max_worker_tasks_, work->num_slices() - 1);
+  graph_.Reset();
+  for (size_t i = 0; i < num_worker_tasks; ++i) {
+    tasks_.push_back(make_scoped_refptr(new FrameConversionTask(work)));
+    graph_.nodes.push_back(TaskGraph::Node(
+        tasks_.back().get(), TASK_CATEGORY_FOREGROUND, 0u /* priority */,
+        0u /* dependencies */));
+  }
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+
+  work->RunSlices();
+  work->WaitForAllSlices();
+
+  // Cancel the tasks that did not start yet instead of waiting for a worker
+  // to run them. From now on, the work queue keeps the tasks alive until they
+  // are collected.
+  graph_.Reset();
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+  tasks_.clear();
+}
+
+}  // namespace cc
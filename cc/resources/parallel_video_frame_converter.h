@@ -0,0 +1,63 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RESOURCES_PARALLEL_VIDEO_FRAME_CONVERTER_H_
+#define CC_RESOURCES_PARALLEL_VIDEO_FRAME_CONVERTER_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "cc/base/cc_export.h"
+#include "cc/raster/task_graph_runner.h"
+
+namespace media {
+class VideoFrame;
+}
+
+namespace cc {
+
+// Converts software YUV video frames to RGB pixels for the software
+// compositor. Frames are split in horizontal slices that are converted both by
+// the calling thread and by tasks on the worker threads of a TaskGraphRunner.
+// The calling thread converts whatever slices the workers did not pick up, so
+// conversion never waits for a worker to be available. Each slice is converted
+// with the SIMD row functions of libyuv.
+class CC_EXPORT ParallelVideoFrameConverter {
+ public:
+  // Number of rows converted together. Even, so that slices of 4:2:0 frames
+  // start on a chroma row.
+  static const int kRowsPerSlice = 64;
+
+  // |task_graph_runner| may be null, in which case frames are converted on the
+  // calling thread only. Otherwise it must outlive this, and at most
+  // |max_worker_tasks| tasks are scheduled at once.
+  ParallelVideoFrameConverter(TaskGraphRunner* task_graph_runner,
+                              size_t max_worker_tasks);
+  ~ParallelVideoFrameConverter();
+
+  // Converts the visible rect of |video_frame| to 32 bit premultiplied N32
+  // pixels, like media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels().
+  // |rgb_pixels| points at the pixel where the top left corner of the visible
+  // rect goes. Returns once the whole frame is converted.
+  void ConvertToRGBPixels(const scoped_refptr<media::VideoFrame>& video_frame,
+                          void* rgb_pixels,
+                          size_t row_bytes);
+
+ private:
+  TaskGraphRunner* task_graph_runner_;
+  NamespaceToken namespace_token_;
+  const size_t max_worker_tasks_;
+
+  // Only used in ConvertToRGBPixels(), kept to reuse their storage.
+  TaskGraph graph_;
+  Task::Vector tasks_;
+  Task::Vector completed_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelVideoFrameConverter);
+};
+
+}  // namespace cc
+
+#endif  // CC_RESOURCES_PARALLEL_VIDEO_FRAME_CONVERTER_H_
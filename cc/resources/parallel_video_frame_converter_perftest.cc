@@ -0,0 +1,95 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "cc/debug/lap_timer.h"
+#include "cc/resources/parallel_video_frame_converter.h"
+#include "cc/test/multi_thread_task_graph_runner.h"
+#include "media/base/video_frame.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace cc {
+namespace {
+
+static const int kTimeLimitMillis = 2000;
+static const int kWarmupRuns = 5;
+static const int kTimeCheckInterval = 1;
+
+class ParallelVideoFrameConverterPerfTest : public testing::Test {
+ public:
+  ParallelVideoFrameConverterPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+  // Converts I420 frames of |size| with |num_worker_threads| worker threads
+  // helping the calling thread, and reports the number of frames per second.
+  void RunConvertTest(const std::string& test_name,
+                      const gfx::Size& size,
+                      int num_worker_threads) {
+    scoped_refptr<media::VideoFrame> frame = media::VideoFrame::CreateFrame(
+        media::PIXEL_FORMAT_I420, size, gfx::Rect(size), size,
+        base::TimeDelta());
+    const media::VideoPixelFormat format = frame->format();
+    for (size_t plane = 0; plane < media::VideoFrame::NumPlanes(format);
+         ++plane) {
+      int rows = media::VideoFrame::Rows(plane, format, size.height());
+      for (int y = 0; y < rows; ++y) {
+        uint8_t* row = frame->data(plane) + y * frame->stride(plane);
+        for (int x = 0; x < frame->stride(plane); ++x)
+          row[x] = static_cast<uint8_t>(x + y);
+      }
+    }
+
+    std::unique_ptr<MultiThreadTaskGraphRunner> task_graph_runner;
+    if (num_worker_threads) {
+      task_graph_runner.reset(
+          new MultiThreadTaskGraphRunner(num_worker_threads));
+    }
+    ParallelVideoFrameConverter converter(task_graph_runner.get(),
+                                          num_worker_threads);
+
+    const size_t row_bytes = size.width() * 4;
+    std::vector<uint8_t> rgb_pixels(row_bytes * size.height());
+    timer_.Reset();
+    do {
+      converter.ConvertToRGBPixels(frame, rgb_pixels.data(), row_bytes);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("video_frame_conversion", "", test_name,
+                           timer_.LapsPerSecond(), "frames/s", true);
+  }
+
+ protected:
+  LapTimer timer_;
+};
+
+TEST_F(ParallelVideoFrameConverterPerfTest, Convert720p) {
+  RunConvertTest("720p_0_workers", gfx::Size(1280, 720), 0);
+  RunConvertTest("720p_3_workers", gfx::Size(1280, 720), 3);
+}
+
+TEST_F(ParallelVideoFrameConverterPerfTest, Convert1080p) {
+  RunConvertTest("1080p_0_workers", gfx::Size(1920, 1080), 0);
+  RunConvertTest("1080p_3_workers", gfx::Size(1920, 1080), 3);
+}
+
+TEST_F(ParallelVideoFrameConverterPerfTest, Convert4K) {
+  RunConvertTest("4k_0_workers", gfx::Size(3840, 2160), 0);
+  RunConvertTest("4k_3_workers", gfx::Size(3840, 2160), 3);
+}
+
+}  // namespace
+}  // namespace cc
@@ -0,0 +1,95 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/resources/parallel_video_frame_converter.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "cc/test/test_task_graph_runner.h"
+#include "media/base/video_frame.h"
+#include "media/renderers/skcanvas_video_renderer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace cc {
+namespace {
+
+scoped_refptr<media::VideoFrame> CreateTestFrame(
+    media::VideoPixelFormat format,
+    const gfx::Size& coded_size,
+    const gfx::Rect& visible_rect) {
+  scoped_refptr<media::VideoFrame> frame = media::VideoFrame::CreateFrame(
+      format, coded_size, visible_rect, visible_rect.size(),
+      base::TimeDelta());
+  for (size_t plane = 0; plane < media::VideoFrame::NumPlanes(format);
+       ++plane) {
+    int rows = media::VideoFrame::Rows(plane, format, coded_size.height());
+    for (int y = 0; y < rows; ++y) {
+      uint8_t* row = frame->data(plane) + y * frame->stride(plane);
+      for (int x = 0; x < frame->stride(plane); ++x)
+        row[x] = static_cast<uint8_t>(x * 7 + y * 13 + plane * 29);
+    }
+  }
+  return frame;
+}
+
+// Converts |frame| on the calling thread only, and with worker tasks, and
+// expects the same pixels.
+void ExpectSameAsSerialConversion(
+    const scoped_refptr<media::VideoFrame>& frame) {
+  const gfx::Rect& visible_rect = frame->visible_rect();
+  const size_t row_bytes = visible_rect.width() * 4;
+  std::vector<uint8_t> expected(row_bytes * visible_rect.height());
+  media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+      frame.get(), expected.data(), row_bytes);
+
+  TestTaskGraphRunner task_graph_runner;
+  ParallelVideoFrameConverter converter(&task_graph_runner, 3);
+  // Convert several times to make sure the converter can be reused while
+  // tasks of the previous conversions may still be completing.
+  for (int run = 0; run < 3; ++run) {
+    std::vector<uint8_t> actual(expected.size(), 0);
+    converter.ConvertToRGBPixels(frame, actual.data(), row_bytes);
+    EXPECT_EQ(expected, actual) << "run " << run;
+  }
+}
+
+TEST(ParallelVideoFrameConverterTest, I420) {
+  ExpectSameAsSerialConversion(CreateTestFrame(
+      media::PIXEL_FORMAT_I420, gfx::Size(320, 240), gfx::Rect(320, 240)));
+}
+
+TEST(ParallelVideoFrameConverterTest, I420PartialLastSlice) {
+  // 230 rows is not a multiple of the slice height, and the visible rect does
+  // not start at the origin of the frame.
+  ExpectSameAsSerialConversion(
+      CreateTestFrame(media::PIXEL_FORMAT_I420, gfx::Size(320, 240),
+                      gfx::Rect(2, 4, 300, 230)));
+}
+
+TEST(ParallelVideoFrameConverterTest, YV24) {
+  ExpectSameAsSerialConversion(CreateTestFrame(
+      media::PIXEL_FORMAT_YV24, gfx::Size(256, 200), gfx::Rect(256, 200)));
+}
+
+TEST(ParallelVideoFrameConverterTest, WithoutTaskGraphRunner) {
+  scoped_refptr<media::VideoFrame> frame = CreateTestFrame(
+      media::PIXEL_FORMAT_I420, gfx::Size(320, 240), gfx::Rect(320, 240));
+  const size_t row_bytes = 320 * 4;
+  std::vector<uint8_t> expected(row_bytes * 240);
+  media::SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+      frame.get(), expected.data(), row_bytes);
+
+  ParallelVideoFrameConverter converter(nullptr, 3);
+  std::vector<uint8_t> actual(expected.size(), 0);
+  converter.ConvertToRGBPixels(frame, actual.data(), row_bytes);
+  EXPECT_EQ(expected, actual);
+}
+
+}  // namespace
+}  // namespace cc
@@ -14,14 +14,14 @@
 #include "base/trace_event/trace_event.h"
 #include "cc/base/math_util.h"
 #include "cc/output/gl_renderer.h"
+#include "cc/resources/parallel_video_frame_converter.h"
 #include "cc/resources/resource_provider.h"
 #include "gpu/GLES2/gl2extchromium.h"
 #include "gpu/command_buffer/client/gles2_interface.h"
 #include "media/base/video_frame.h"
-#include "media/renderers/skcanvas_video_renderer.h"
 #include "third_party/khronos/GLES2/gl2.h"
 #include "third_party/khronos/GLES2/gl2ext.h"
-#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/gfx/geometry/size_conversions.h"
 
 namespace cc {
@@ -30,6 +30,10 @@ namespace {
 
 const ResourceFormat kRGBResourceFormat = RGBA_8888;
 
+// Maximum number of worker tasks converting a software frame at once, in
+// addition to the compositor thread.
+const size_t kMaxFrameConversionTasks = 3;
+
 VideoFrameExternalResources::ResourceType ResourceTypeForVideoFrame(
     media::VideoFrame* video_frame) {
   switch (video_frame->format()) {
@@ -161,9 +165,14 @@ VideoFrameExternalResources::~VideoFrameExternalResources() {}
 
 VideoResourceUpdater::VideoResourceUpdater(ContextProvider* context_provider,
                                            ResourceProvider* resource_provider)
+    : VideoResourceUpdater(context_provider, resource_provider, nullptr) {}
+
+VideoResourceUpdater::VideoResourceUpdater(ContextProvider* context_provider,
+                                           ResourceProvider* resource_provider,
+                                           TaskGraphRunner* task_graph_runner)
     : context_provider_(context_provider),
-      resource_provider_(resource_provider) {
-}
+      resource_provider_(resource_provider),
+      task_graph_runner_(task_graph_runner) {}
 
 VideoResourceUpdater::~VideoResourceUpdater() {
   for (const PlaneResource& plane_resource : all_resources_)
@@ -382,15 +391,21 @@ VideoFrameExternalResources VideoResourceUpdater::CreateForSoftwarePlanes(
 
     if (!plane_resource.Matches(video_frame->unique_id(), 0)) {
       // We need to transfer data from |video_frame| to the plane resource.
-      if (!video_renderer_)
-        video_renderer_.reset(new media::SkCanvasVideoRenderer);
+      if (!frame_converter_) {
+        frame_converter_.reset(new ParallelVideoFrameConverter(
+            task_graph_runner_, kMaxFrameConversionTasks));
+      }
 
       ResourceProvider::ScopedWriteLockSoftware lock(
           resource_provider_, plane_resource.resource_id());
-      SkCanvas canvas(lock.sk_bitmap());
-      // This is software path, so canvas and video_frame are always backed
-      // by software.
-      video_renderer_->Copy(video_frame, &canvas, media::Context3D());
+      // The resource has the coded size of the frame. Convert the visible
+      // rect in place, straight into the bitmap.
+      SkBitmap& bitmap = lock.sk_bitmap();
+      const gfx::Rect& visible_rect = video_frame->visible_rect();
+      frame_converter_->ConvertToRGBPixels(
+          video_frame, bitmap.getAddr32(visible_rect.x(), visible_rect.y()),
+          bitmap.rowBytes());
+      bitmap.notifyPixelsChanged();
       plane_resource.SetUniqueId(video_frame->unique_id(), 0);
     }
 
@@ -23,13 +23,14 @@
 #include "ui/gfx/geometry/size.h"
 
 namespace media {
-class SkCanvasVideoRenderer;
 class VideoFrame;
 }
 
 namespace cc {
 class ContextProvider;
+class ParallelVideoFrameConverter;
 class ResourceProvider;
+class TaskGraphRunner;
 
 class CC_EXPORT VideoFrameExternalResources {
  public:
@@ -80,6 +81,11 @@ class CC_EXPORT VideoResourceUpdater
  public:
   VideoResourceUpdater(ContextProvider* context_provider,
                        ResourceProvider* resource_provider);
+  // With software compositing, frames are converted to RGB on the worker
+  // threads of |task_graph_runner| as well, if it is not null.
+  VideoResourceUpdater(ContextProvider* context_provider,
+                       ResourceProvider* resource_provider,
+                       TaskGraphRunner* task_graph_runner);
   ~VideoResourceUpdater();
 
   VideoFrameExternalResources CreateExternalResourcesFromVideoFrame(
@@ -161,7 +167,8 @@ class CC_EXPORT VideoResourceUpdater
 
   ContextProvider* context_provider_;
   ResourceProvider* resource_provider_;
-  std::unique_ptr<media::SkCanvasVideoRenderer> video_renderer_;
+  TaskGraphRunner* task_graph_runner_;
+  std::unique_ptr<ParallelVideoFrameConverter> frame_converter_;
   std::vector<uint8_t> upload_pixels_;
 
   // Recycle resources so that we can reduce the number of allocations and
@@ -0,0 +1,97 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/test/multi_thread_task_graph_runner.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_restrictions.h"
+
+namespace cc {
+
+MultiThreadTaskGraphRunner::MultiThreadTaskGraphRunner(int num_threads)
+    : has_ready_to_run_tasks_cv_(&lock_),
+      has_namespaces_with_finished_running_tasks_cv_(&lock_),
+      shutdown_(false) {
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.push_back(base::WrapUnique(new base::DelegateSimpleThread(
+        this, base::StringPrintf("MultiThreadTaskGraphRunner%d", i))));
+    threads_.back()->Start();
+  }
+}
+
+MultiThreadTaskGraphRunner::~MultiThreadTaskGraphRunner() {
+  {
+    base::AutoLock lock(lock_);
+    DCHECK(!work_queue_.HasReadyToRunTasks());
+    shutdown_ = true;
+    has_ready_to_run_tasks_cv_.Broadcast();
+  }
+  for (const auto& thread : threads_)
+    thread->Join();
+}
+
+NamespaceToken MultiThreadTaskGraphRunner::GetNamespaceToken() {
+  base::AutoLock lock(lock_);
+  return work_queue_.GetNamespaceToken();
+}
+
+void MultiThreadTaskGraphRunner::ScheduleTasks(NamespaceToken token,
+                                               TaskGraph* graph) {
+  base::AutoLock lock(lock_);
+  work_queue_.ScheduleTasks(token, graph);
+  if (work_queue_.HasReadyToRunTasks())
+    has_ready_to_run_tasks_cv_.Broadcast();
+}
+
+void MultiThreadTaskGraphRunner::WaitForTasksToFinishRunning(
+    NamespaceToken token) {
+  base::AutoLock lock(lock_);
+  base::ThreadRestrictions::ScopedAllowWait allow_wait;
+  auto* task_namespace = work_queue_.GetNamespaceForToken(token);
+  if (!task_namespace)
+    return;
+  while (!work_queue_.HasFinishedRunningTasksInNamespace(task_namespace))
+    has_namespaces_with_finished_running_tasks_cv_.Wait();
+}
+
+void MultiThreadTaskGraphRunner::CollectCompletedTasks(
+    NamespaceToken token,
+    Task::Vector* completed_tasks) {
+  base::AutoLock lock(lock_);
+  work_queue_.CollectCompletedTasks(token, completed_tasks);
+}
+
+void MultiThreadTaskGraphRunner::Run() {
+  base::AutoLock lock(lock_);
+  while (true) {
+    const auto& ready_to_run_namespaces = work_queue_.ready_to_run_namespaces();
+    auto found = std::find_if(
+        ready_to_run_namespaces.cbegin(), ready_to_run_namespaces.cend(),
+        [](const std::pair<uint16_t, TaskGraphWorkQueue::TaskNamespace::Vector>&
+               pair) { return !pair.second.empty(); });
+    if (found == ready_to_run_namespaces.cend()) {
+      if (shutdown_)
+        break;
+      has_ready_to_run_tasks_cv_.Wait();
+      continue;
+    }
+
+    auto prioritized_task = work_queue_.GetNextTaskToRun(found->first);
+    {
+      base::AutoUnlock unlock(lock_);
+      prioritized_task.task->RunOnWorkerThread();
+    }
+    work_queue_.CompleteTask(prioritized_task);
+    if (work_queue_.HasFinishedRunningTasksInNamespace(
+            prioritized_task.task_namespace))
+      has_namespaces_with_finished_running_tasks_cv_.Broadcast();
+  }
+}
+
+}  // namespace cc
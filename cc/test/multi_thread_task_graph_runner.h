@@ -0,0 +1,52 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TEST_MULTI_THREAD_TASK_GRAPH_RUNNER_H_
+#define CC_TEST_MULTI_THREAD_TASK_GRAPH_RUNNER_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "cc/raster/task_graph_runner.h"
+#include "cc/raster/task_graph_work_queue.h"
+
+namespace cc {
+
+// Runs TaskGraphs on several worker threads, like the task graph runner of a
+// renderer does, for tests that measure work spread across workers.
+class MultiThreadTaskGraphRunner : public TaskGraphRunner,
+                                   public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit MultiThreadTaskGraphRunner(int num_threads);
+  ~MultiThreadTaskGraphRunner() override;
+
+  // Overridden from TaskGraphRunner:
+  NamespaceToken GetNamespaceToken() override;
+  void ScheduleTasks(NamespaceToken token, TaskGraph* graph) override;
+  void WaitForTasksToFinishRunning(NamespaceToken token) override;
+  void CollectCompletedTasks(NamespaceToken token,
+                             Task::Vector* completed_tasks) override;
+
+  // Overridden from base::DelegateSimpleThread::Delegate:
+  void Run() override;
+
+ private:
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads_;
+
+  base::Lock lock_;
+  TaskGraphWorkQueue work_queue_;
+  base::ConditionVariable has_ready_to_run_tasks_cv_;
+  base::ConditionVariable has_namespaces_with_finished_running_tasks_cv_;
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiThreadTaskGraphRunner);
+};
+
+}  // namespace cc
+
+#endif  // CC_TEST_MULTI_THREAD_TASK_GRAPH_RUNNER_H_
@@ -15,6 +15,7 @@
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/synchronization/atomic_sequence_num.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_argument.h"
 #include "cc/base/math_util.h"
@@ -30,6 +31,12 @@
 
 namespace cc {
 
+namespace {
+
+base::StaticAtomicSequenceNumber g_next_raster_order_version;
+
+}  // namespace
+
 PictureLayerTiling::PictureLayerTiling(
     WhichTree tree,
     float contents_scale,
@@ -48,8 +55,10 @@ PictureLayerTiling::PictureLayerTiling(
       has_skewport_rect_tiles_(false),
       has_soon_border_rect_tiles_(false),
       has_eventually_rect_tiles_(false),
-      all_tiles_done_(true) {
+      all_tiles_done_(true),
+      raster_order_version_(0) {
   DCHECK(!raster_source->IsSolidColor());
+  InvalidateRasterOrder();
   gfx::Size content_bounds =
       gfx::ScaleToCeiledSize(raster_source_->GetSize(), contents_scale);
   gfx::Size tile_size = client_->CalculateTileSize(content_bounds);
@@ -77,6 +86,7 @@ Tile* PictureLayerTiling::CreateTile(const Tile::CreateInfo& info) {
     return nullptr;
 
   all_tiles_done_ = false;
+  InvalidateRasterOrder();
   ScopedTilePtr tile = client_->CreateTile(info);
   Tile* raw_ptr = tile.get();
   tiles_[key] = std::move(tile);
@@ -156,6 +166,8 @@ void PictureLayerTiling::TakeTilesAndPropertiesFrom(
   }
   DCHECK(pending_twin->tiles_.empty());
   pending_twin->all_tiles_done_ = true;
+  pending_twin->InvalidateRasterOrder();
+  InvalidateRasterOrder();
 
   if (create_missing_tiles)
     CreateMissingTilesInLiveTilesRect();
@@ -173,6 +185,7 @@ void PictureLayerTiling::TakeTilesAndPropertiesFrom(
 void PictureLayerTiling::SetRasterSourceAndResize(
     scoped_refptr<RasterSource> raster_source) {
   DCHECK(!raster_source->IsSolidColor());
+  InvalidateRasterOrder();
   gfx::Size old_layer_bounds = raster_source_->GetSize();
   raster_source_ = std::move(raster_source);
   gfx::Size new_layer_bounds = raster_source_->GetSize();
@@ -518,6 +531,7 @@ ScopedTilePtr PictureLayerTiling::TakeTileAt(int i, int j) {
     return nullptr;
   ScopedTilePtr result = std::move(found->second);
   tiles_.erase(found);
+  InvalidateRasterOrder();
   return result;
 }
 
@@ -526,6 +540,7 @@ bool PictureLayerTiling::RemoveTileAt(int i, int j) {
   if (found == tiles_.end())
     return false;
   tiles_.erase(found);
+  InvalidateRasterOrder();
   return true;
 }
 
@@ -533,6 +548,12 @@ void PictureLayerTiling::Reset() {
   live_tiles_rect_ = gfx::Rect();
   tiles_.clear();
   all_tiles_done_ = true;
+  InvalidateRasterOrder();
+}
+
+void PictureLayerTiling::InvalidateRasterOrder() {
+  // Zero is never used, so it can stand for a missing tiling.
+  raster_order_version_ = g_next_raster_order_version.GetNext() + 1;
 }
 
 void PictureLayerTiling::ComputeTilePriorityRects(
@@ -576,6 +597,15 @@ void PictureLayerTiling::SetTilePriorityRects(
     const gfx::Rect& soon_border_rect,
     const gfx::Rect& eventually_rect,
     const Occlusion& occlusion_in_layer_space) {
+  if (current_visible_rect_ != visible_rect_in_content_space ||
+      current_skewport_rect_ != skewport ||
+      current_soon_border_rect_ != soon_border_rect ||
+      current_eventually_rect_ != eventually_rect ||
+      !current_occlusion_in_layer_space_.IsEqual(occlusion_in_layer_space) ||
+      current_content_to_screen_scale_ != content_to_screen_scale) {
+    InvalidateRasterOrder();
+  }
+
   current_visible_rect_ = visible_rect_in_content_space;
   current_skewport_rect_ = skewport;
   current_soon_border_rect_ = soon_border_rect;
@@ -98,6 +98,8 @@ class CC_EXPORT PictureLayerTiling {
   bool IsTileRequiredForDraw(const Tile* tile) const;
 
   void set_resolution(TileResolution resolution) {
+    if (resolution_ != resolution)
+      InvalidateRasterOrder();
     resolution_ = resolution;
     may_contain_low_resolution_tiles_ |= resolution == LOW_RESOLUTION;
   }
@@ -109,6 +111,8 @@ class CC_EXPORT PictureLayerTiling {
     may_contain_low_resolution_tiles_ = false;
   }
   void set_can_require_tiles_for_activation(bool can_require_tiles) {
+    if (can_require_tiles_for_activation_ != can_require_tiles)
+      InvalidateRasterOrder();
     can_require_tiles_for_activation_ = can_require_tiles;
   }
 
@@ -133,6 +137,13 @@ class CC_EXPORT PictureLayerTiling {
     all_tiles_done_ = all_tiles_done;
   }
 
+  // Changes whenever the set of tiles of the tiling, or anything that the
+  // order or the priorities of the tiles in a raster queue depend on, changes.
+  // Versions are unique across all tilings. See TilingSetRasterOrder.
+  int raster_order_version() const { return raster_order_version_; }
+  // Should be called when a tile that did not need raster needs it again.
+  void InvalidateRasterOrder();
+
   void VerifyNoTileNeedsRaster() const {
 #if DCHECK_IS_ON()
     for (const auto& tile_pair : tiles_) {
@@ -349,6 +360,8 @@ class CC_EXPORT PictureLayerTiling {
   bool has_eventually_rect_tiles_;
   bool all_tiles_done_;
 
+  int raster_order_version_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(PictureLayerTiling);
 };
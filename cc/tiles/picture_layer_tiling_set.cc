@@ -106,6 +106,8 @@ void PictureLayerTilingSet::UpdateTilingsToCurrentRasterSourceForActivation(
     const Region& layer_invalidation,
     float minimum_contents_scale,
     float maximum_contents_scale) {
+  // The recorded raster order holds on to the previous raster source.
+  raster_order_.Clear();
   RemoveTilingsBelowScale(minimum_contents_scale);
   RemoveTilingsAboveScale(maximum_contents_scale);
 
@@ -147,6 +149,7 @@ void PictureLayerTilingSet::UpdateTilingsToCurrentRasterSourceForCommit(
     const Region& layer_invalidation,
     float minimum_contents_scale,
     float maximum_contents_scale) {
+  raster_order_.Clear();
   RemoveTilingsBelowScale(minimum_contents_scale);
   RemoveTilingsAboveScale(maximum_contents_scale);
 
@@ -175,6 +178,7 @@ void PictureLayerTilingSet::UpdateTilingsToCurrentRasterSourceForCommit(
 void PictureLayerTilingSet::UpdateRasterSourceDueToLCDChange(
     scoped_refptr<RasterSource> raster_source,
     const Region& layer_invalidation) {
+  raster_order_.Clear();
   raster_source_ = raster_source;
   for (const auto& tiling : tilings_) {
     tiling->SetRasterSourceAndResize(raster_source);
@@ -327,6 +331,7 @@ void PictureLayerTilingSet::RemoveTilingsAboveScale(float maximum_scale) {
 }
 
 void PictureLayerTilingSet::RemoveAllTilings() {
+  raster_order_.Clear();
   tilings_.clear();
 }
 
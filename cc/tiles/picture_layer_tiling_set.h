@@ -13,6 +13,7 @@
 #include "base/macros.h"
 #include "cc/base/region.h"
 #include "cc/tiles/picture_layer_tiling.h"
+#include "cc/tiles/tiling_set_raster_order.h"
 #include "ui/gfx/geometry/size.h"
 
 namespace base {
@@ -86,6 +87,9 @@ class CC_EXPORT PictureLayerTilingSet {
   }
   WhichTree tree() const { return tree_; }
 
+  // The raster order of the tiles of this set, reused across raster queues.
+  TilingSetRasterOrder* raster_order() { return &raster_order_; }
+
   PictureLayerTiling* FindTilingWithScale(float scale) const;
   PictureLayerTiling* FindTilingWithResolution(TileResolution resolution) const;
 
@@ -247,6 +251,8 @@ class CC_EXPORT PictureLayerTilingSet {
   gfx::Rect soon_border_rect_in_layer_space_;
   gfx::Rect eventually_rect_in_layer_space_;
 
+  TilingSetRasterOrder raster_order_;
+
   friend class Iterator;
 
  private:
@@ -222,6 +222,44 @@ TEST_F(PictureLayerTilingIteratorTest, ResizeDeletesTiles) {
   EXPECT_FALSE(tiling_->TileAt(0, 0));
 }
 
+TEST_F(PictureLayerTilingIteratorTest, RasterOrderVersion) {
+  gfx::Size layer_bounds(250, 250);
+  InitializeActive(gfx::Size(100, 100), 1.f, layer_bounds);
+  int version = tiling_->raster_order_version();
+
+  // Creating tiles changes the version.
+  SetLiveRectAndVerifyTiles(gfx::Rect(layer_bounds));
+  EXPECT_NE(version, tiling_->raster_order_version());
+  version = tiling_->raster_order_version();
+
+  // Setting the priority rects only changes the version if they change.
+  gfx::Rect visible_rect(0, 0, 100, 100);
+  tiling_->SetTilePriorityRectsForTesting(visible_rect, visible_rect,
+                                          visible_rect,
+                                          gfx::Rect(layer_bounds));
+  EXPECT_NE(version, tiling_->raster_order_version());
+  version = tiling_->raster_order_version();
+  tiling_->SetTilePriorityRectsForTesting(visible_rect, visible_rect,
+                                          visible_rect,
+                                          gfx::Rect(layer_bounds));
+  EXPECT_EQ(version, tiling_->raster_order_version());
+
+  // So does setting the resolution.
+  tiling_->set_resolution(HIGH_RESOLUTION);
+  EXPECT_EQ(version, tiling_->raster_order_version());
+  tiling_->set_resolution(LOW_RESOLUTION);
+  EXPECT_NE(version, tiling_->raster_order_version());
+  version = tiling_->raster_order_version();
+
+  // Invalidating recreates tiles.
+  tiling_->Invalidate(Region(gfx::Rect(0, 0, 10, 10)));
+  EXPECT_NE(version, tiling_->raster_order_version());
+  version = tiling_->raster_order_version();
+
+  tiling_->InvalidateRasterOrder();
+  EXPECT_NE(version, tiling_->raster_order_version());
+}
+
 TEST_F(PictureLayerTilingIteratorTest, CreateMissingTilesStaysInsideLiveRect) {
   // The tiling has three rows and columns.
   Initialize(gfx::Size(100, 100), 1.f, gfx::Size(250, 250));
@@ -4,7 +4,6 @@
 
 #include "cc/tiles/raster_tile_priority_queue_all.h"
 
-#include "base/memory/ptr_util.h"
 #include "cc/tiles/tiling_set_raster_queue_all.h"
 
 namespace cc {
@@ -63,8 +62,8 @@ void CreateTilingSetRasterQueues(
     PictureLayerTilingSet* tiling_set = layer->picture_layer_tiling_set();
     bool prioritize_low_res = tree_priority == SMOOTHNESS_TAKES_PRIORITY;
     std::unique_ptr<TilingSetRasterQueueAll> tiling_set_queue =
-        base::WrapUnique(
-            new TilingSetRasterQueueAll(tiling_set, prioritize_low_res));
+        TilingSetRasterQueueAll::CreateIncremental(tiling_set,
+                                                   prioritize_low_res);
     // Queues will only contain non empty tiling sets.
     if (!tiling_set_queue->IsEmpty())
       queues->push_back(std::move(tiling_set_queue));
@@ -294,6 +294,37 @@ class TileManagerPerfTest : public TestLayerTreeHostBase {
                            timer_.LapsPerSecond(), "runs/s", true);
   }
 
+  // Same as RunPrepareTilesTest(), but the raster order of every tiling is
+  // invalidated before each PrepareTiles, so the raster queue iterates over
+  // all the tilings instead of replaying the order recorded in the previous
+  // frame.
+  void RunPrepareTilesWithRasterOrderInvalidatedTest(
+      const std::string& test_name,
+      int layer_count,
+      int approximate_tile_count_per_layer) {
+    std::vector<FakePictureLayerImpl*> layers =
+        CreateLayers(layer_count, approximate_tile_count_per_layer);
+
+    timer_.Reset();
+    do {
+      host_impl()->AdvanceToNextFrame(base::TimeDelta::FromMilliseconds(1));
+      for (const auto& layer : layers) {
+        layer->UpdateTiles();
+        PictureLayerTilingSet* tiling_set = layer->picture_layer_tiling_set();
+        for (size_t i = 0; i < tiling_set->num_tilings(); ++i)
+          tiling_set->tiling_at(i)->InvalidateRasterOrder();
+      }
+
+      GlobalStateThatImpactsTilePriority global_state(GlobalStateForTest());
+      tile_manager()->PrepareTiles(global_state);
+      tile_manager()->Flush();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("prepare_tiles_raster_order_invalidated", "",
+                           test_name, timer_.LapsPerSecond(), "runs/s", true);
+  }
+
   TileManager* tile_manager() { return host_impl()->tile_manager(); }
 
  protected:
@@ -312,6 +343,14 @@ TEST_F(TileManagerPerfTest, PrepareTiles) {
   RunPrepareTilesTest("50_1000", 100, 1000);
 }
 
+// Scenes of 1k, 5k and 10k tiles, to compare with the matching PrepareTiles
+// results.
+TEST_F(TileManagerPerfTest, PrepareTilesWithRasterOrderInvalidated) {
+  RunPrepareTilesWithRasterOrderInvalidatedTest("10_100", 10, 100);
+  RunPrepareTilesWithRasterOrderInvalidatedTest("10_500", 10, 500);
+  RunPrepareTilesWithRasterOrderInvalidatedTest("10_1000", 10, 1000);
+}
+
 TEST_F(TileManagerPerfTest, RasterTileQueueConstruct) {
   RunRasterQueueConstructTest("2", 2);
   RunRasterQueueConstructTest("10", 10);
@@ -1402,6 +1402,90 @@ TEST_F(TileManagerTilePriorityQueueTest, RasterQueueAllUsesCorrectTileBounds) {
   }
 }
 
+TEST_F(TileManagerTilePriorityQueueTest, IncrementalRasterQueueAll) {
+  FakePictureLayerTilingClient client;
+
+  gfx::Rect viewport(50, 50, 500, 500);
+  gfx::Rect moved_viewport(550, 50, 500, 500);
+  gfx::Size layer_bounds(1600, 1600);
+
+  client.SetTileSize(gfx::Size(30, 30));
+  LayerTreeSettings settings;
+
+  std::unique_ptr<PictureLayerTilingSet> tiling_set =
+      PictureLayerTilingSet::Create(
+          ACTIVE_TREE, &client, settings.tiling_interest_area_padding,
+          settings.skewport_target_time_in_seconds,
+          settings.skewport_extrapolation_limit_in_screen_pixels);
+
+  scoped_refptr<FakeRasterSource> raster_source =
+      FakeRasterSource::CreateFilled(layer_bounds);
+  PictureLayerTiling* tiling = tiling_set->AddTiling(1.0f, raster_source);
+  tiling->set_resolution(HIGH_RESOLUTION);
+  tiling_set->UpdateTilePriorities(viewport, 1.0f, 1.0, Occlusion(), true);
+
+  std::vector<Tile*> expected_order;
+  std::unique_ptr<TilingSetRasterQueueAll> queue(
+      new TilingSetRasterQueueAll(tiling_set.get(), false));
+  for (; !queue->IsEmpty(); queue->Pop())
+    expected_order.push_back(queue->Top().tile());
+  ASSERT_GT(expected_order.size(), 2u);
+
+  // The first queue only reads part of the order.
+  TilingSetRasterOrder* raster_order = tiling_set->raster_order();
+  size_t partial_count = expected_order.size() / 2;
+  queue = TilingSetRasterQueueAll::CreateIncremental(tiling_set.get(), false);
+  for (size_t i = 0; i < partial_count; ++i) {
+    ASSERT_FALSE(queue->IsEmpty());
+    EXPECT_EQ(expected_order[i], queue->Top().tile());
+    queue->Pop();
+  }
+  queue.reset();
+  EXPECT_EQ(partial_count + 1, raster_order->recorded_tile_count());
+
+  // Nothing changed, so the next queue replays the recorded part of the order
+  // and records the rest.
+  std::vector<Tile*> order;
+  queue = TilingSetRasterQueueAll::CreateIncremental(tiling_set.get(), false);
+  for (; !queue->IsEmpty(); queue->Pop())
+    order.push_back(queue->Top().tile());
+  queue.reset();
+  EXPECT_EQ(expected_order, order);
+  EXPECT_EQ(expected_order.size(), raster_order->recorded_tile_count());
+
+  // Tiles that don't need raster anymore are skipped.
+  expected_order[0]->draw_info().SetSolidColorForTesting(SK_ColorRED);
+  queue = TilingSetRasterQueueAll::CreateIncremental(tiling_set.get(), false);
+  ASSERT_FALSE(queue->IsEmpty());
+  EXPECT_EQ(expected_order[1], queue->Top().tile());
+
+  // The order can't be read by two queues at once, so the second one iterates
+  // over the tilings.
+  std::unique_ptr<TilingSetRasterQueueAll> other_queue =
+      TilingSetRasterQueueAll::CreateIncremental(tiling_set.get(), false);
+  ASSERT_FALSE(other_queue->IsEmpty());
+  EXPECT_EQ(expected_order[1], other_queue->Top().tile());
+  other_queue.reset();
+  queue.reset();
+  EXPECT_EQ(expected_order.size(), raster_order->recorded_tile_count());
+
+  // Moving the viewport changes the priorities, so the order is recorded
+  // again.
+  tiling_set->UpdateTilePriorities(moved_viewport, 1.0f, 2.0, Occlusion(),
+                                   true);
+  expected_order.clear();
+  queue.reset(new TilingSetRasterQueueAll(tiling_set.get(), false));
+  for (; !queue->IsEmpty(); queue->Pop())
+    expected_order.push_back(queue->Top().tile());
+  order.clear();
+  queue = TilingSetRasterQueueAll::CreateIncremental(tiling_set.get(), false);
+  for (; !queue->IsEmpty(); queue->Pop())
+    order.push_back(queue->Top().tile());
+  queue.reset();
+  EXPECT_EQ(expected_order, order);
+  EXPECT_EQ(expected_order.size(), raster_order->recorded_tile_count());
+}
+
 TEST_F(TileManagerTilePriorityQueueTest, NoRasterTasksforSolidColorTiles) {
   gfx::Size size(10, 10);
   const gfx::Size layer_bounds(1000, 1000);
@@ -0,0 +1,98 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/tiling_set_raster_order.h"
+
+#include "base/logging.h"
+#include "cc/tiles/picture_layer_tiling_set.h"
+#include "cc/tiles/tiling_set_raster_queue_all.h"
+
+namespace cc {
+
+namespace {
+
+int TwinRasterOrderVersion(const PictureLayerTilingSet* tiling_set,
+                           const PictureLayerTiling* tiling) {
+  const PictureLayerTiling* twin =
+      tiling_set->client()->GetPendingOrActiveTwinTiling(tiling);
+  return twin ? twin->raster_order_version() : 0;
+}
+
+}  // namespace
+
+TilingSetRasterOrder::TilingSetRasterOrder()
+    : prioritize_low_res_(false),
+      requires_high_res_to_draw_(false),
+      in_use_(false) {}
+
+TilingSetRasterOrder::~TilingSetRasterOrder() {
+  DCHECK(!in_use_);
+}
+
+bool TilingSetRasterOrder::Acquire(PictureLayerTilingSet* tiling_set,
+                                   bool prioritize_low_res) {
+  if (in_use_)
+    return false;
+  in_use_ = true;
+
+  if (queue_ && IsValidFor(tiling_set, prioritize_low_res))
+    return true;
+
+  // Record a new order. Clearing |tiles_| keeps its capacity, so a scene that
+  // changes every frame does not reallocate it either.
+  Clear();
+  for (size_t i = 0; i < tiling_set->num_tilings(); ++i) {
+    const PictureLayerTiling* tiling = tiling_set->tiling_at(i);
+    versions_.push_back(tiling->raster_order_version());
+    versions_.push_back(TwinRasterOrderVersion(tiling_set, tiling));
+  }
+  prioritize_low_res_ = prioritize_low_res;
+  requires_high_res_to_draw_ = tiling_set->client()->RequiresHighResToDraw();
+  queue_.reset(new TilingSetRasterQueueAll(tiling_set, prioritize_low_res));
+  return true;
+}
+
+void TilingSetRasterOrder::Release() {
+  DCHECK(in_use_);
+  in_use_ = false;
+}
+
+const PrioritizedTile* TilingSetRasterOrder::GetTile(size_t index) {
+  DCHECK(in_use_);
+  DCHECK(queue_);
+  while (index >= tiles_.size()) {
+    if (queue_->IsEmpty())
+      return nullptr;
+    tiles_.push_back(queue_->Top());
+    queue_->Pop();
+  }
+  return &tiles_[index];
+}
+
+void TilingSetRasterOrder::Clear() {
+  versions_.clear();
+  queue_.reset();
+  tiles_.clear();
+}
+
+bool TilingSetRasterOrder::IsValidFor(PictureLayerTilingSet* tiling_set,
+                                      bool prioritize_low_res) const {
+  if (prioritize_low_res != prioritize_low_res_ ||
+      tiling_set->client()->RequiresHighResToDraw() !=
+          requires_high_res_to_draw_) {
+    return false;
+  }
+  if (versions_.size() != 2 * tiling_set->num_tilings())
+    return false;
+  for (size_t i = 0; i < tiling_set->num_tilings(); ++i) {
+    const PictureLayerTiling* tiling = tiling_set->tiling_at(i);
+    if (versions_[2 * i] != tiling->raster_order_version() ||
+        versions_[2 * i + 1] != TwinRasterOrderVersion(tiling_set, tiling)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace cc
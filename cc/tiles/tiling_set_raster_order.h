@@ -0,0 +1,74 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TILES_TILING_SET_RASTER_ORDER_H_
+#define CC_TILES_TILING_SET_RASTER_ORDER_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "cc/base/cc_export.h"
+#include "cc/tiles/prioritized_tile.h"
+
+namespace cc {
+
+class PictureLayerTilingSet;
+class TilingSetRasterQueueAll;
+
+// The raster order of the tiles of a PictureLayerTilingSet, kept by the tiling
+// set across frames. The order is recorded lazily from a
+// TilingSetRasterQueueAll as queues read it, and stays valid for as long as
+// none of the tilings of the set, nor their twins, change in a way that
+// affects which tiles they contain or how those tiles are prioritized (see
+// PictureLayerTiling::raster_order_version()). This lets a scene that did not
+// change between two frames replay the order it already walked instead of
+// iterating over all the tilings again.
+class CC_EXPORT TilingSetRasterOrder {
+ public:
+  TilingSetRasterOrder();
+  ~TilingSetRasterOrder();
+
+  // Starts reading the order for |tiling_set|. The recorded order is dropped
+  // if it is not valid for the current state of the tilings anymore. Returns
+  // false if the order is already being read, in which case Release() must not
+  // be called.
+  bool Acquire(PictureLayerTilingSet* tiling_set, bool prioritize_low_res);
+  void Release();
+
+  // Returns the tile at |index| in the order, extending the recorded order
+  // from the tilings if needed, or nullptr if the order has fewer tiles. Must
+  // be called between Acquire() and Release(). The returned pointer is only
+  // valid until the next call.
+  const PrioritizedTile* GetTile(size_t index);
+
+  // Drops the recorded order.
+  void Clear();
+
+  size_t recorded_tile_count() const { return tiles_.size(); }
+
+ private:
+  bool IsValidFor(PictureLayerTilingSet* tiling_set,
+                  bool prioritize_low_res) const;
+
+  // The raster order versions of the tilings that the order was recorded for,
+  // and of their twins, interleaved.
+  std::vector<int> versions_;
+  bool prioritize_low_res_;
+  bool requires_high_res_to_draw_;
+
+  // Produces the tiles past the end of |tiles_|. Null if nothing is recorded.
+  std::unique_ptr<TilingSetRasterQueueAll> queue_;
+  std::vector<PrioritizedTile> tiles_;
+
+  bool in_use_;
+
+  DISALLOW_COPY_AND_ASSIGN(TilingSetRasterOrder);
+};
+
+}  // namespace cc
+
+#endif  // CC_TILES_TILING_SET_RASTER_ORDER_H_
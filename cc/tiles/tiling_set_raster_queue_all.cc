@@ -8,6 +8,7 @@
 
 #include <utility>
 
+#include "base/memory/ptr_util.h"
 #include "cc/tiles/picture_layer_tiling_set.h"
 #include "cc/tiles/tile.h"
 #include "cc/tiles/tile_priority.h"
@@ -23,7 +24,11 @@ TilingSetRasterQueueAll::IterationStage::IterationStage(
 TilingSetRasterQueueAll::TilingSetRasterQueueAll(
     PictureLayerTilingSet* tiling_set,
     bool prioritize_low_res)
-    : tiling_set_(tiling_set), current_stage_(0) {
+    : tiling_set_(tiling_set),
+      raster_order_(nullptr),
+      raster_order_index_(0),
+      raster_order_tile_(nullptr),
+      current_stage_(0) {
   DCHECK(tiling_set_);
 
   // Early out if the tiling set has no tilings.
@@ -104,7 +109,33 @@ TilingSetRasterQueueAll::TilingSetRasterQueueAll(
     AdvanceToNextStage();
 }
 
+TilingSetRasterQueueAll::TilingSetRasterQueueAll(
+    TilingSetRasterOrder* raster_order)
+    : tiling_set_(nullptr),
+      raster_order_(raster_order),
+      raster_order_index_(0),
+      raster_order_tile_(nullptr),
+      current_stage_(0) {
+  AdvanceRasterOrderToTileThatNeedsRaster();
+}
+
 TilingSetRasterQueueAll::~TilingSetRasterQueueAll() {
+  if (raster_order_)
+    raster_order_->Release();
+}
+
+// static
+std::unique_ptr<TilingSetRasterQueueAll>
+TilingSetRasterQueueAll::CreateIncremental(PictureLayerTilingSet* tiling_set,
+                                           bool prioritize_low_res) {
+  TilingSetRasterOrder* raster_order = tiling_set->raster_order();
+  // Another queue is reading the order of this tiling set, fall back to
+  // iterating over the tilings.
+  if (!raster_order->Acquire(tiling_set, prioritize_low_res)) {
+    return base::WrapUnique(
+        new TilingSetRasterQueueAll(tiling_set, prioritize_low_res));
+  }
+  return base::WrapUnique(new TilingSetRasterQueueAll(raster_order));
 }
 
 void TilingSetRasterQueueAll::MakeTilingIterator(IteratorType type,
@@ -118,10 +149,19 @@ void TilingSetRasterQueueAll::MakeTilingIterator(IteratorType type,
 }
 
 bool TilingSetRasterQueueAll::IsEmpty() const {
+  if (raster_order_)
+    return !raster_order_tile_;
   return current_stage_ >= stages_->size();
 }
 
 void TilingSetRasterQueueAll::Pop() {
+  if (raster_order_) {
+    DCHECK(raster_order_tile_);
+    ++raster_order_index_;
+    AdvanceRasterOrderToTileThatNeedsRaster();
+    return;
+  }
+
   IteratorType index = stages_[current_stage_].iterator_type;
   TilePriority::PriorityBin tile_type = stages_[current_stage_].tile_type;
 
@@ -136,6 +176,8 @@ void TilingSetRasterQueueAll::Pop() {
 
 const PrioritizedTile& TilingSetRasterQueueAll::Top() const {
   DCHECK(!IsEmpty());
+  if (raster_order_)
+    return *raster_order_tile_;
 
   IteratorType index = stages_[current_stage_].iterator_type;
   DCHECK(!iterators_[index].done());
@@ -157,6 +199,19 @@ void TilingSetRasterQueueAll::AdvanceToNextStage() {
   }
 }
 
+void TilingSetRasterQueueAll::AdvanceRasterOrderToTileThatNeedsRaster() {
+  // Tiles are recorded when they need raster, but may have been rastered
+  // since. Nothing else that affects the order changed, or the order would
+  // not be valid anymore.
+  for (;; ++raster_order_index_) {
+    raster_order_tile_ = raster_order_->GetTile(raster_order_index_);
+    if (!raster_order_tile_ ||
+        raster_order_tile_->tile()->draw_info().NeedsRaster()) {
+      return;
+    }
+  }
+}
+
 // OnePriorityRectIterator
 TilingSetRasterQueueAll::OnePriorityRectIterator::OnePriorityRectIterator()
     : tiling_(nullptr), tiling_data_(nullptr) {
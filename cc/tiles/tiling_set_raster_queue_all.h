@@ -7,6 +7,8 @@
 
 #include <stddef.h>
 
+#include <memory>
+
 #include "base/containers/stack_container.h"
 #include "base/macros.h"
 #include "cc/base/cc_export.h"
@@ -14,6 +16,7 @@
 #include "cc/tiles/prioritized_tile.h"
 #include "cc/tiles/tile.h"
 #include "cc/tiles/tile_priority.h"
+#include "cc/tiles/tiling_set_raster_order.h"
 
 namespace cc {
 
@@ -25,6 +28,14 @@ class CC_EXPORT TilingSetRasterQueueAll {
                           bool prioritize_low_res);
   ~TilingSetRasterQueueAll();
 
+  // Returns a queue that reads the raster order kept by |tiling_set| (see
+  // TilingSetRasterOrder), only iterating over the tilings for the tiles past
+  // the part of the order that was already recorded. Tiles of the order that
+  // no longer need raster are skipped.
+  static std::unique_ptr<TilingSetRasterQueueAll> CreateIncremental(
+      PictureLayerTilingSet* tiling_set,
+      bool prioritize_low_res);
+
   const PrioritizedTile& Top() const;
   void Pop();
   bool IsEmpty() const;
@@ -176,11 +187,20 @@ class CC_EXPORT TilingSetRasterQueueAll {
     NUM_ITERATORS
   };
 
+  explicit TilingSetRasterQueueAll(TilingSetRasterOrder* raster_order);
+
   void MakeTilingIterator(IteratorType type, PictureLayerTiling* tiling);
   void AdvanceToNextStage();
+  void AdvanceRasterOrderToTileThatNeedsRaster();
 
   PictureLayerTilingSet* tiling_set_;
 
+  // Only set for queues created with CreateIncremental(), in which case the
+  // iteration stages below are not used.
+  TilingSetRasterOrder* raster_order_;
+  size_t raster_order_index_;
+  const PrioritizedTile* raster_order_tile_;
+
   struct IterationStage {
     IterationStage(IteratorType type, TilePriority::PriorityBin bin);
     IteratorType iterator_type;
@@ -6,14 +6,17 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <vector>
 
+#include "base/bind.h"
 #include "cc/base/math_util.h"
 #include "cc/layers/draw_properties.h"
 #include "cc/layers/layer.h"
 #include "cc/layers/layer_impl.h"
 #include "cc/trees/layer_tree_host.h"
 #include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/parallel_layer_list_runner.h"
 #include "cc/trees/property_tree.h"
 #include "cc/trees/property_tree_builder.h"
 #include "ui/gfx/geometry/rect_conversions.h"
@@ -59,171 +62,180 @@ static void ValidateRenderSurfaceForLayer(LayerImpl* layer) {
 #endif
 
 template <typename LayerType>
-void CalculateVisibleRects(
-    const typename LayerType::LayerListType& visible_layer_list,
-    const ClipTree& clip_tree,
-    const TransformTree& transform_tree,
-    bool non_root_surfaces_enabled) {
-  for (auto& layer : visible_layer_list) {
-    gfx::Size layer_bounds = layer->bounds();
-    const ClipNode* clip_node = clip_tree.Node(layer->clip_tree_index());
-    const bool is_unclipped = clip_node->data.resets_clip &&
-                              !clip_node->data.applies_local_clip &&
-                              non_root_surfaces_enabled;
-    // When both the layer and the target are unclipped, the entire layer
-    // content rect is visible.
-    const bool fully_visible = !clip_node->data.layers_are_clipped &&
-                               !clip_node->data.target_is_clipped &&
-                               non_root_surfaces_enabled;
-    const TransformNode* transform_node =
-        transform_tree.Node(layer->transform_tree_index());
-    if (!is_unclipped && !fully_visible) {
-      // The entire layer is visible if it has copy requests.
-      if (layer->HasCopyRequest()) {
-        layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
-        continue;
-      }
-
-      const TransformNode* target_node =
-          non_root_surfaces_enabled
-              ? transform_tree.Node(transform_node->data.content_target_id)
-              : transform_tree.Node(0);
-
-      // The clip node stores clip rect in its target space. If required,
-      // this clip rect should be mapped to the current layer's target space.
-      gfx::Rect clip_rect_in_target_space;
-      gfx::Rect combined_clip_rect_in_target_space;
-
-      // When we only have a root surface, the clip node and the layer must
-      // necessarily have the same target (the root).
-      if (clip_node->data.target_id != target_node->id &&
-          non_root_surfaces_enabled) {
-        // In this case, layer has a clip parent or scroll parent (or shares the
-        // target with an ancestor layer that has clip parent) and the clip
-        // parent's target is different from the layer's target. As the layer's
-        // target has unclippped descendants, it is unclippped.
-        if (!clip_node->data.layers_are_clipped) {
-          layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
-          continue;
-        }
-        bool success = true;
-        gfx::Transform clip_to_target;
-        if (clip_node->data.target_id > target_node->id) {
-          // In this case, layer has a scroll parent. We need to keep the scale
-          // at the layer's target but remove the scale at the scroll parent's
-          // target.
-          success = transform_tree.ComputeTransformWithDestinationSublayerScale(
-              clip_node->data.target_id, target_node->id, &clip_to_target);
-          const TransformNode* source_node =
-              transform_tree.Node(clip_node->data.target_id);
-          if (source_node->data.sublayer_scale.x() != 0.f &&
-              source_node->data.sublayer_scale.y() != 0.f)
-            clip_to_target.Scale(1.0f / source_node->data.sublayer_scale.x(),
-                                 1.0f / source_node->data.sublayer_scale.y());
-        } else {
-          success = transform_tree.ComputeTransform(
-              clip_node->data.target_id, target_node->id, &clip_to_target);
-        }
-        if (!success) {
-          // An animated singular transform may become non-singular during the
-          // animation, so we still need to compute a visible rect. In this
-          // situation, we treat the entire layer as visible.
-          layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
-          continue;
-        }
-        // We use the clip node's clip_in_target_space (and not
-        // combined_clip_in_target_space) here because we want to clip
-        // with respect to clip parent's local clip and not its combined clip as
-        // the combined clip has even the clip parent's target's clip baked into
-        // it and as our target is different, we don't want to use it in our
-        // visible rect computation.
-        if (clip_node->data.target_id < target_node->id) {
-          combined_clip_rect_in_target_space =
-              gfx::ToEnclosingRect(MathUtil::ProjectClippedRect(
-                  clip_to_target, clip_node->data.clip_in_target_space));
-        } else {
-          combined_clip_rect_in_target_space =
-              gfx::ToEnclosingRect(MathUtil::MapClippedRect(
-                  clip_to_target, clip_node->data.clip_in_target_space));
-        }
-        clip_rect_in_target_space = combined_clip_rect_in_target_space;
-      } else {
-        clip_rect_in_target_space =
-            gfx::ToEnclosingRect(clip_node->data.clip_in_target_space);
-        if (clip_node->data.target_is_clipped || !non_root_surfaces_enabled)
-          combined_clip_rect_in_target_space = gfx::ToEnclosingRect(
-              clip_node->data.combined_clip_in_target_space);
-        else
-          combined_clip_rect_in_target_space = clip_rect_in_target_space;
-      }
+void CalculateVisibleRect(const ClipTree& clip_tree,
+                          const TransformTree& transform_tree,
+                          bool non_root_surfaces_enabled,
+                          LayerType* layer) {
+  gfx::Size layer_bounds = layer->bounds();
+  const ClipNode* clip_node = clip_tree.Node(layer->clip_tree_index());
+  const bool is_unclipped = clip_node->data.resets_clip &&
+                            !clip_node->data.applies_local_clip &&
+                            non_root_surfaces_enabled;
+  // When both the layer and the target are unclipped, the entire layer
+  // content rect is visible.
+  const bool fully_visible = !clip_node->data.layers_are_clipped &&
+                             !clip_node->data.target_is_clipped &&
+                             non_root_surfaces_enabled;
+  const TransformNode* transform_node =
+      transform_tree.Node(layer->transform_tree_index());
+  if (!is_unclipped && !fully_visible) {
+    // The entire layer is visible if it has copy requests.
+    if (layer->HasCopyRequest()) {
+      layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
+      return;
+    }
 
-      if (!clip_rect_in_target_space.IsEmpty()) {
-        layer->set_clip_rect(clip_rect_in_target_space);
-      } else {
-        layer->set_clip_rect(gfx::Rect());
-      }
+    const TransformNode* target_node =
+        non_root_surfaces_enabled
+            ? transform_tree.Node(transform_node->data.content_target_id)
+            : transform_tree.Node(0);
 
-      // The clip rect should be intersected with layer rect in target space.
-      gfx::Transform content_to_target = non_root_surfaces_enabled
-                                             ? transform_node->data.to_target
-                                             : transform_node->data.to_screen;
-
-      content_to_target.Translate(layer->offset_to_transform_parent().x(),
-                                  layer->offset_to_transform_parent().y());
-      gfx::Rect layer_content_rect = gfx::Rect(layer_bounds);
-      gfx::Rect layer_content_bounds_in_target_space =
-          MathUtil::MapEnclosingClippedRect(content_to_target,
-                                            layer_content_rect);
-      combined_clip_rect_in_target_space.Intersect(
-          layer_content_bounds_in_target_space);
-      if (combined_clip_rect_in_target_space.IsEmpty()) {
-        layer->set_visible_layer_rect(gfx::Rect());
-        continue;
-      }
+    // The clip node stores clip rect in its target space. If required,
+    // this clip rect should be mapped to the current layer's target space.
+    gfx::Rect clip_rect_in_target_space;
+    gfx::Rect combined_clip_rect_in_target_space;
 
-      // If the layer is fully contained within the clip, treat it as fully
-      // visible. Since clip_rect_in_target_space has already been intersected
-      // with layer_content_bounds_in_target_space, the layer is fully contained
-      // within the clip iff these rects are equal.
-      if (combined_clip_rect_in_target_space ==
-          layer_content_bounds_in_target_space) {
+    // When we only have a root surface, the clip node and the layer must
+    // necessarily have the same target (the root).
+    if (clip_node->data.target_id != target_node->id &&
+        non_root_surfaces_enabled) {
+      // In this case, layer has a clip parent or scroll parent (or shares the
+      // target with an ancestor layer that has clip parent) and the clip
+      // parent's target is different from the layer's target. As the layer's
+      // target has unclippped descendants, it is unclippped.
+      if (!clip_node->data.layers_are_clipped) {
         layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
-        continue;
+        return;
       }
-
-      gfx::Transform target_to_content;
-      gfx::Transform target_to_layer;
       bool success = true;
-      if (transform_node->data.ancestors_are_invertible) {
-        target_to_layer = non_root_surfaces_enabled
-                              ? transform_node->data.from_target
-                              : transform_node->data.from_screen;
+      gfx::Transform clip_to_target;
+      if (clip_node->data.target_id > target_node->id) {
+        // In this case, layer has a scroll parent. We need to keep the scale
+        // at the layer's target but remove the scale at the scroll parent's
+        // target.
+        success = transform_tree.ComputeTransformWithDestinationSublayerScale(
+            clip_node->data.target_id, target_node->id, &clip_to_target);
+        const TransformNode* source_node =
+            transform_tree.Node(clip_node->data.target_id);
+        if (source_node->data.sublayer_scale.x() != 0.f &&
+            source_node->data.sublayer_scale.y() != 0.f)
+          clip_to_target.Scale(1.0f / source_node->data.sublayer_scale.x(),
+                               1.0f / source_node->data.sublayer_scale.y());
       } else {
-        success = transform_tree.ComputeTransformWithSourceSublayerScale(
-            target_node->id, transform_node->id, &target_to_layer);
+        success = transform_tree.ComputeTransform(
+            clip_node->data.target_id, target_node->id, &clip_to_target);
       }
-
       if (!success) {
         // An animated singular transform may become non-singular during the
         // animation, so we still need to compute a visible rect. In this
         // situation, we treat the entire layer as visible.
         layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
-        continue;
+        return;
       }
+      // We use the clip node's clip_in_target_space (and not
+      // combined_clip_in_target_space) here because we want to clip
+      // with respect to clip parent's local clip and not its combined clip as
+      // the combined clip has even the clip parent's target's clip baked into
+      // it and as our target is different, we don't want to use it in our
+      // visible rect computation.
+      if (clip_node->data.target_id < target_node->id) {
+        combined_clip_rect_in_target_space =
+            gfx::ToEnclosingRect(MathUtil::ProjectClippedRect(
+                clip_to_target, clip_node->data.clip_in_target_space));
+      } else {
+        combined_clip_rect_in_target_space =
+            gfx::ToEnclosingRect(MathUtil::MapClippedRect(
+                clip_to_target, clip_node->data.clip_in_target_space));
+      }
+      clip_rect_in_target_space = combined_clip_rect_in_target_space;
+    } else {
+      clip_rect_in_target_space =
+          gfx::ToEnclosingRect(clip_node->data.clip_in_target_space);
+      if (clip_node->data.target_is_clipped || !non_root_surfaces_enabled)
+        combined_clip_rect_in_target_space = gfx::ToEnclosingRect(
+            clip_node->data.combined_clip_in_target_space);
+      else
+        combined_clip_rect_in_target_space = clip_rect_in_target_space;
+    }
 
-      target_to_content.Translate(-layer->offset_to_transform_parent().x(),
-                                  -layer->offset_to_transform_parent().y());
-      target_to_content.PreconcatTransform(target_to_layer);
+    if (!clip_rect_in_target_space.IsEmpty()) {
+      layer->set_clip_rect(clip_rect_in_target_space);
+    } else {
+      layer->set_clip_rect(gfx::Rect());
+    }
 
-      gfx::Rect visible_rect = MathUtil::ProjectEnclosingClippedRect(
-          target_to_content, combined_clip_rect_in_target_space);
+    // The clip rect should be intersected with layer rect in target space.
+    gfx::Transform content_to_target = non_root_surfaces_enabled
+                                           ? transform_node->data.to_target
+                                           : transform_node->data.to_screen;
+
+    content_to_target.Translate(layer->offset_to_transform_parent().x(),
+                                layer->offset_to_transform_parent().y());
+    gfx::Rect layer_content_rect = gfx::Rect(layer_bounds);
+    gfx::Rect layer_content_bounds_in_target_space =
+        MathUtil::MapEnclosingClippedRect(content_to_target,
+                                          layer_content_rect);
+    combined_clip_rect_in_target_space.Intersect(
+        layer_content_bounds_in_target_space);
+    if (combined_clip_rect_in_target_space.IsEmpty()) {
+      layer->set_visible_layer_rect(gfx::Rect());
+      return;
+    }
 
-      visible_rect.Intersect(gfx::Rect(layer_bounds));
+    // If the layer is fully contained within the clip, treat it as fully
+    // visible. Since clip_rect_in_target_space has already been intersected
+    // with layer_content_bounds_in_target_space, the layer is fully contained
+    // within the clip iff these rects are equal.
+    if (combined_clip_rect_in_target_space ==
+        layer_content_bounds_in_target_space) {
+      layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
+      return;
+    }
 
-      layer->set_visible_layer_rect(visible_rect);
+    gfx::Transform target_to_content;
+    gfx::Transform target_to_layer;
+    bool success = true;
+    if (transform_node->data.ancestors_are_invertible) {
+      target_to_layer = non_root_surfaces_enabled
+                            ? transform_node->data.from_target
+                            : transform_node->data.from_screen;
     } else {
+      success = transform_tree.ComputeTransformWithSourceSublayerScale(
+          target_node->id, transform_node->id, &target_to_layer);
+    }
+
+    if (!success) {
+      // An animated singular transform may become non-singular during the
+      // animation, so we still need to compute a visible rect. In this
+      // situation, we treat the entire layer as visible.
       layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
+      return;
     }
+
+    target_to_content.Translate(-layer->offset_to_transform_parent().x(),
+                                -layer->offset_to_transform_parent().y());
+    target_to_content.PreconcatTransform(target_to_layer);
+
+    gfx::Rect visible_rect = MathUtil::ProjectEnclosingClippedRect(
+        target_to_content, combined_clip_rect_in_target_space);
+
+    visible_rect.Intersect(gfx::Rect(layer_bounds));
+
+    layer->set_visible_layer_rect(visible_rect);
+  } else {
+    layer->set_visible_layer_rect(gfx::Rect(layer_bounds));
+  }
+}
+
+template <typename LayerType>
+void CalculateVisibleRects(
+    const typename LayerType::LayerListType& visible_layer_list,
+    const ClipTree& clip_tree,
+    const TransformTree& transform_tree,
+    bool non_root_surfaces_enabled) {
+  for (auto& layer : visible_layer_list) {
+    CalculateVisibleRect<LayerType>(clip_tree, transform_tree,
+                                    non_root_surfaces_enabled, &*layer);
   }
 }
 
@@ -350,6 +362,130 @@ void UpdateRenderSurfaceForLayer(EffectTree* effect_tree,
   else
     layer->SetHasRenderSurface(false);
 }
+
+// Property trees with fewer nodes are always updated on the calling thread.
+const size_t kMinNodesForParallelUpdate =
+    2 * ParallelLayerListRunner::kLayersPerChunk;
+
+// The order the nodes of a property tree, but its root, are updated in when
+// sibling subtrees are updated concurrently: the nodes of |serial_ids| first,
+// in order, then the nodes of each group of |group_ids|, in order, while other
+// groups are being updated.
+struct PropertyTreeUpdateOrder {
+  std::vector<int> serial_ids;
+  std::vector<std::vector<int>> group_ids;
+};
+
+// Returns the group that the group rooted at |id| was merged into.
+int FindMergedGroup(std::vector<int>* merged_into, int id) {
+  while ((*merged_into)[id] != id) {
+    (*merged_into)[id] = (*merged_into)[(*merged_into)[id]];
+    id = (*merged_into)[id];
+  }
+  return id;
+}
+
+// Splits the nodes of a property tree so that every node is updated after its
+// parent, |parent_ids[id]|, and after |dependency_ids[id]| unless it is -1.
+// Both must be smaller than |id|; |dependency_ids| may be empty. The groups
+// are the largest subtrees of at most |max_group_size| nodes, merged when a
+// node depends on a node of another group. Returns false if a node outside of
+// the groups depends on a node of a group, in which case the tree can only be
+// updated serially.
+bool SplitPropertyTree(const std::vector<int>& parent_ids,
+                       const std::vector<int>& dependency_ids,
+                       size_t max_group_size,
+                       PropertyTreeUpdateOrder* order) {
+  int num_nodes = static_cast<int>(parent_ids.size());
+  std::vector<size_t> subtree_sizes(num_nodes, 1);
+  for (int id = num_nodes - 1; id > 0; --id) {
+    DCHECK_LT(parent_ids[id], id);
+    subtree_sizes[parent_ids[id]] += subtree_sizes[id];
+  }
+
+  // The root of the subtree each node is grouped with, or -1 for the nodes
+  // updated serially, and the group each of these subtrees was merged into.
+  std::vector<int> group_roots(num_nodes, -1);
+  std::vector<int> merged_into(num_nodes, -1);
+  for (int id = 1; id < num_nodes; ++id) {
+    int parent_group_root = group_roots[parent_ids[id]];
+    if (parent_group_root != -1) {
+      group_roots[id] = parent_group_root;
+    } else if (subtree_sizes[id] <= max_group_size) {
+      group_roots[id] = id;
+      merged_into[id] = id;
+    }
+
+    int dependency_id = dependency_ids.empty() ? -1 : dependency_ids[id];
+    if (dependency_id < 0 || group_roots[dependency_id] == -1)
+      continue;
+    if (dependency_id >= id || group_roots[id] == -1)
+      return false;
+    int group = FindMergedGroup(&merged_into, group_roots[id]);
+    int dependency_group =
+        FindMergedGroup(&merged_into, group_roots[dependency_id]);
+    merged_into[std::max(group, dependency_group)] =
+        std::min(group, dependency_group);
+  }
+
+  std::vector<int> group_indices(num_nodes, -1);
+  for (int id = 1; id < num_nodes; ++id) {
+    if (group_roots[id] == -1) {
+      order->serial_ids.push_back(id);
+      continue;
+    }
+    int group = FindMergedGroup(&merged_into, group_roots[id]);
+    if (group_indices[group] == -1) {
+      group_indices[group] = static_cast<int>(order->group_ids.size());
+      order->group_ids.push_back(std::vector<int>());
+    }
+    order->group_ids[group_indices[group]].push_back(id);
+  }
+  return true;
+}
+
+void UpdateNodeGroup(const std::vector<std::vector<int>>* group_ids,
+                     const base::Callback<void(int)>& update_node,
+                     size_t group) {
+  for (int id : (*group_ids)[group])
+    update_node.Run(id);
+}
+
+// Calls |update_node| for every node of |tree| but its root, updating sibling
+// subtrees concurrently on |layer_list_runner|. Every node is updated after its
+// parent and after |dependency_ids[id]|, as in SplitPropertyTree(), so the
+// result is the same as when updating the nodes in order. Returns false,
+// without updating any node, if the tree is too small or cannot be split.
+template <typename TreeType>
+bool UpdatePropertyTreeInParallel(
+    const TreeType& tree,
+    const std::vector<int>& dependency_ids,
+    ParallelLayerListRunner* layer_list_runner,
+    const base::Callback<void(int)>& update_node) {
+  size_t num_nodes = tree.size();
+  if (!layer_list_runner || num_nodes < kMinNodesForParallelUpdate)
+    return false;
+
+  std::vector<int> parent_ids(num_nodes);
+  for (size_t id = 0; id < num_nodes; ++id)
+    parent_ids[id] = tree.Node(static_cast<int>(id))->parent_id;
+  PropertyTreeUpdateOrder order;
+  // Small enough groups to keep every worker busy, large enough for the
+  // scheduling not to cost more than the updates.
+  size_t max_group_size = num_nodes / 16;
+  if (max_group_size < ParallelLayerListRunner::kLayersPerChunk)
+    max_group_size = ParallelLayerListRunner::kLayersPerChunk;
+  if (!SplitPropertyTree(parent_ids, dependency_ids, max_group_size, &order))
+    return false;
+
+  for (int id : order.serial_ids)
+    update_node.Run(id);
+  layer_list_runner->ForEachIndex(
+      order.group_ids.size(), 1,
+      base::Bind(&UpdateNodeGroup, &order.group_ids, update_node));
+  return true;
+}
+
 }  // namespace
 
 template <typename LayerType>
@@ -425,153 +561,196 @@ static void ResetIfHasNanCoordinate(gfx::RectF* rect) {
     *rect = gfx::RectF();
 }
 
-void ComputeClips(ClipTree* clip_tree,
-                  const TransformTree& transform_tree,
-                  bool non_root_surfaces_enabled) {
-  if (!clip_tree->needs_update())
+// Only reads the parent of the clip node |id| and the transform tree, so
+// sibling subtrees of the clip tree can be updated concurrently.
+static void ComputeClip(ClipTree* clip_tree,
+                        const TransformTree* transform_tree_ptr,
+                        bool non_root_surfaces_enabled,
+                        int id) {
+  const TransformTree& transform_tree = *transform_tree_ptr;
+  ClipNode* clip_node = clip_tree->Node(id);
+
+  if (clip_node->id == 1) {
+    ResetIfHasNanCoordinate(&clip_node->data.clip);
+    clip_node->data.clip_in_target_space = clip_node->data.clip;
+    clip_node->data.combined_clip_in_target_space = clip_node->data.clip;
     return;
-  for (int i = 1; i < static_cast<int>(clip_tree->size()); ++i) {
-    ClipNode* clip_node = clip_tree->Node(i);
-
-    if (clip_node->id == 1) {
-      ResetIfHasNanCoordinate(&clip_node->data.clip);
-      clip_node->data.clip_in_target_space = clip_node->data.clip;
-      clip_node->data.combined_clip_in_target_space = clip_node->data.clip;
-      continue;
-    }
-    const TransformNode* transform_node =
-        transform_tree.Node(clip_node->data.transform_id);
-    ClipNode* parent_clip_node = clip_tree->parent(clip_node);
-
-    gfx::Transform parent_to_current;
-    const TransformNode* parent_target_transform_node =
-        transform_tree.Node(parent_clip_node->data.target_id);
-    bool success = true;
-
-    // Clips must be combined in target space. We cannot, for example, combine
-    // clips in the space of the child clip. The reason is non-affine
-    // transforms. Say we have the following tree T->A->B->C, and B clips C, but
-    // draw into target T. It may be the case that A applies a perspective
-    // transform, and B and C are at different z positions. When projected into
-    // target space, the relative sizes and positions of B and C can shift.
-    // Since it's the relationship in target space that matters, that's where we
-    // must combine clips. For each clip node, we save the clip rects in its
-    // target space. So, we need to get the ancestor clip rect in the current
-    // clip node's target space.
-    gfx::RectF parent_combined_clip_in_target_space =
-        parent_clip_node->data.combined_clip_in_target_space;
-    gfx::RectF parent_clip_in_target_space =
-        parent_clip_node->data.clip_in_target_space;
-    if (parent_target_transform_node &&
-        parent_target_transform_node->id != clip_node->data.target_id &&
-        non_root_surfaces_enabled) {
-      success &= transform_tree.ComputeTransformWithDestinationSublayerScale(
-          parent_target_transform_node->id, clip_node->data.target_id,
-          &parent_to_current);
-      if (parent_target_transform_node->data.sublayer_scale.x() > 0 &&
-          parent_target_transform_node->data.sublayer_scale.y() > 0)
-        parent_to_current.Scale(
-            1.f / parent_target_transform_node->data.sublayer_scale.x(),
-            1.f / parent_target_transform_node->data.sublayer_scale.y());
-      // If we can't compute a transform, it's because we had to use the inverse
-      // of a singular transform. We won't draw in this case, so there's no need
-      // to compute clips.
-      if (!success)
-        continue;
-      parent_combined_clip_in_target_space = MathUtil::ProjectClippedRect(
-          parent_to_current,
-          parent_clip_node->data.combined_clip_in_target_space);
-      parent_clip_in_target_space = MathUtil::ProjectClippedRect(
-          parent_to_current, parent_clip_node->data.clip_in_target_space);
-    }
-    // Only nodes affected by ancestor clips will have their clip adjusted due
-    // to intersecting with an ancestor clip. But, we still need to propagate
-    // the combined clip to our children because if they are clipped, they may
-    // need to clip using our parent clip and if we don't propagate it here,
-    // it will be lost.
-    if (clip_node->data.resets_clip && non_root_surfaces_enabled) {
-      if (clip_node->data.applies_local_clip) {
-        clip_node->data.clip_in_target_space = MathUtil::MapClippedRect(
-            transform_node->data.to_target, clip_node->data.clip);
-        ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
-        clip_node->data.combined_clip_in_target_space =
-            gfx::IntersectRects(clip_node->data.clip_in_target_space,
-                                parent_combined_clip_in_target_space);
-      } else {
-        DCHECK(!clip_node->data.target_is_clipped);
-        DCHECK(!clip_node->data.layers_are_clipped);
-        clip_node->data.combined_clip_in_target_space =
-            parent_combined_clip_in_target_space;
-      }
-      ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
-      continue;
-    }
-    bool use_only_parent_clip = !clip_node->data.applies_local_clip;
-    if (use_only_parent_clip) {
+  }
+  const TransformNode* transform_node =
+      transform_tree.Node(clip_node->data.transform_id);
+  ClipNode* parent_clip_node = clip_tree->parent(clip_node);
+
+  gfx::Transform parent_to_current;
+  const TransformNode* parent_target_transform_node =
+      transform_tree.Node(parent_clip_node->data.target_id);
+  bool success = true;
+
+  // Clips must be combined in target space. We cannot, for example, combine
+  // clips in the space of the child clip. The reason is non-affine
+  // transforms. Say we have the following tree T->A->B->C, and B clips C, but
+  // draw into target T. It may be the case that A applies a perspective
+  // transform, and B and C are at different z positions. When projected into
+  // target space, the relative sizes and positions of B and C can shift.
+  // Since it's the relationship in target space that matters, that's where we
+  // must combine clips. For each clip node, we save the clip rects in its
+  // target space. So, we need to get the ancestor clip rect in the current
+  // clip node's target space.
+  gfx::RectF parent_combined_clip_in_target_space =
+      parent_clip_node->data.combined_clip_in_target_space;
+  gfx::RectF parent_clip_in_target_space =
+      parent_clip_node->data.clip_in_target_space;
+  if (parent_target_transform_node &&
+      parent_target_transform_node->id != clip_node->data.target_id &&
+      non_root_surfaces_enabled) {
+    success &= transform_tree.ComputeTransformWithDestinationSublayerScale(
+        parent_target_transform_node->id, clip_node->data.target_id,
+        &parent_to_current);
+    if (parent_target_transform_node->data.sublayer_scale.x() > 0 &&
+        parent_target_transform_node->data.sublayer_scale.y() > 0)
+      parent_to_current.Scale(
+          1.f / parent_target_transform_node->data.sublayer_scale.x(),
+          1.f / parent_target_transform_node->data.sublayer_scale.y());
+    // If we can't compute a transform, it's because we had to use the inverse
+    // of a singular transform. We won't draw in this case, so there's no need
+    // to compute clips.
+    if (!success)
+      return;
+    parent_combined_clip_in_target_space = MathUtil::ProjectClippedRect(
+        parent_to_current,
+        parent_clip_node->data.combined_clip_in_target_space);
+    parent_clip_in_target_space = MathUtil::ProjectClippedRect(
+        parent_to_current, parent_clip_node->data.clip_in_target_space);
+  }
+  // Only nodes affected by ancestor clips will have their clip adjusted due
+  // to intersecting with an ancestor clip. But, we still need to propagate
+  // the combined clip to our children because if they are clipped, they may
+  // need to clip using our parent clip and if we don't propagate it here,
+  // it will be lost.
+  if (clip_node->data.resets_clip && non_root_surfaces_enabled) {
+    if (clip_node->data.applies_local_clip) {
+      clip_node->data.clip_in_target_space = MathUtil::MapClippedRect(
+          transform_node->data.to_target, clip_node->data.clip);
+      ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
+      clip_node->data.combined_clip_in_target_space =
+          gfx::IntersectRects(clip_node->data.clip_in_target_space,
+                              parent_combined_clip_in_target_space);
+    } else {
+      DCHECK(!clip_node->data.target_is_clipped);
+      DCHECK(!clip_node->data.layers_are_clipped);
       clip_node->data.combined_clip_in_target_space =
           parent_combined_clip_in_target_space;
-      if (!non_root_surfaces_enabled) {
-        clip_node->data.clip_in_target_space =
-            parent_clip_node->data.clip_in_target_space;
-      } else if (!clip_node->data.target_is_clipped) {
-        clip_node->data.clip_in_target_space = parent_clip_in_target_space;
-      } else {
-        // Render Surface applies clip and the owning layer itself applies
-        // no clip. So, clip_in_target_space is not used and hence we can set
-        // it to an empty rect.
-        clip_node->data.clip_in_target_space = gfx::RectF();
-      }
+    }
+    ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+    return;
+  }
+  bool use_only_parent_clip = !clip_node->data.applies_local_clip;
+  if (use_only_parent_clip) {
+    clip_node->data.combined_clip_in_target_space =
+        parent_combined_clip_in_target_space;
+    if (!non_root_surfaces_enabled) {
+      clip_node->data.clip_in_target_space =
+          parent_clip_node->data.clip_in_target_space;
+    } else if (!clip_node->data.target_is_clipped) {
+      clip_node->data.clip_in_target_space = parent_clip_in_target_space;
     } else {
-      gfx::Transform source_to_target;
-
-      if (!non_root_surfaces_enabled) {
-        source_to_target = transform_node->data.to_screen;
-      } else if (transform_node->data.content_target_id ==
-                 clip_node->data.target_id) {
-        source_to_target = transform_node->data.to_target;
-      } else {
-        success = transform_tree.ComputeTransformWithDestinationSublayerScale(
-            transform_node->id, clip_node->data.target_id, &source_to_target);
-        // source_to_target computation should be successful as target is an
-        // ancestor of the transform node.
-        DCHECK(success);
-      }
+      // Render Surface applies clip and the owning layer itself applies
+      // no clip. So, clip_in_target_space is not used and hence we can set
+      // it to an empty rect.
+      clip_node->data.clip_in_target_space = gfx::RectF();
+    }
+  } else {
+    gfx::Transform source_to_target;
 
-      gfx::RectF source_clip_in_target_space =
-          MathUtil::MapClippedRect(source_to_target, clip_node->data.clip);
-
-      // With surfaces disabled, the only case where we use only the local clip
-      // for layer clipping is the case where no non-viewport ancestor node
-      // applies a local clip.
-      bool layer_clipping_uses_only_local_clip =
-          non_root_surfaces_enabled
-              ? clip_node->data.layer_clipping_uses_only_local_clip
-              : !parent_clip_node->data
-                     .layers_are_clipped_when_surfaces_disabled;
-      if (!layer_clipping_uses_only_local_clip) {
-        clip_node->data.clip_in_target_space = gfx::IntersectRects(
-            parent_clip_in_target_space, source_clip_in_target_space);
-      } else {
-        clip_node->data.clip_in_target_space = source_clip_in_target_space;
-      }
+    if (!non_root_surfaces_enabled) {
+      source_to_target = transform_node->data.to_screen;
+    } else if (transform_node->data.content_target_id ==
+               clip_node->data.target_id) {
+      source_to_target = transform_node->data.to_target;
+    } else {
+      success = transform_tree.ComputeTransformWithDestinationSublayerScale(
+          transform_node->id, clip_node->data.target_id, &source_to_target);
+      // source_to_target computation should be successful as target is an
+      // ancestor of the transform node.
+      DCHECK(success);
+    }
 
-      clip_node->data.combined_clip_in_target_space = gfx::IntersectRects(
-          parent_combined_clip_in_target_space, source_clip_in_target_space);
+    gfx::RectF source_clip_in_target_space =
+        MathUtil::MapClippedRect(source_to_target, clip_node->data.clip);
+
+    // With surfaces disabled, the only case where we use only the local clip
+    // for layer clipping is the case where no non-viewport ancestor node
+    // applies a local clip.
+    bool layer_clipping_uses_only_local_clip =
+        non_root_surfaces_enabled
+            ? clip_node->data.layer_clipping_uses_only_local_clip
+            : !parent_clip_node->data
+                   .layers_are_clipped_when_surfaces_disabled;
+    if (!layer_clipping_uses_only_local_clip) {
+      clip_node->data.clip_in_target_space = gfx::IntersectRects(
+          parent_clip_in_target_space, source_clip_in_target_space);
+    } else {
+      clip_node->data.clip_in_target_space = source_clip_in_target_space;
     }
-    ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
-    ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+
+    clip_node->data.combined_clip_in_target_space = gfx::IntersectRects(
+        parent_combined_clip_in_target_space, source_clip_in_target_space);
+  }
+  ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
+  ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+}
+
+static void ComputeClipsInParallel(ClipTree* clip_tree,
+                                   const TransformTree& transform_tree,
+                                   bool non_root_surfaces_enabled,
+                                   ParallelLayerListRunner* layer_list_runner) {
+  if (!clip_tree->needs_update())
+    return;
+  if (!UpdatePropertyTreeInParallel(
+          *clip_tree, std::vector<int>(), layer_list_runner,
+          base::Bind(&ComputeClip, clip_tree, &transform_tree,
+                     non_root_surfaces_enabled))) {
+    for (int i = 1; i < static_cast<int>(clip_tree->size()); ++i)
+      ComputeClip(clip_tree, &transform_tree, non_root_surfaces_enabled, i);
   }
   clip_tree->set_needs_update(false);
 }
 
-void ComputeTransforms(TransformTree* transform_tree) {
+void ComputeClips(ClipTree* clip_tree,
+                  const TransformTree& transform_tree,
+                  bool non_root_surfaces_enabled) {
+  ComputeClipsInParallel(clip_tree, transform_tree, non_root_surfaces_enabled,
+                         nullptr);
+}
+
+static void ComputeTransformsInParallel(
+    TransformTree* transform_tree,
+    ParallelLayerListRunner* layer_list_runner) {
   if (!transform_tree->needs_update())
     return;
-  for (int i = 1; i < static_cast<int>(transform_tree->size()); ++i)
-    transform_tree->UpdateTransforms(i);
+  // Besides its ancestors, a node reads its source node and the nodes between
+  // the source node and its parent.
+  std::vector<int> source_node_ids;
+  if (layer_list_runner) {
+    source_node_ids.resize(transform_tree->size());
+    for (size_t i = 0; i < source_node_ids.size(); ++i) {
+      source_node_ids[i] =
+          transform_tree->Node(static_cast<int>(i))->data.source_node_id;
+    }
+  }
+  if (!UpdatePropertyTreeInParallel(
+          *transform_tree, source_node_ids, layer_list_runner,
+          base::Bind(&TransformTree::UpdateTransforms,
+                     base::Unretained(transform_tree)))) {
+    for (int i = 1; i < static_cast<int>(transform_tree->size()); ++i)
+      transform_tree->UpdateTransforms(i);
+  }
   transform_tree->set_needs_update(false);
 }
 
+void ComputeTransforms(TransformTree* transform_tree) {
+  ComputeTransformsInParallel(transform_tree, nullptr);
+}
+
 void UpdateRenderTarget(EffectTree* effect_tree,
                         bool can_render_to_separate_surface) {
   for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i) {
@@ -589,14 +768,25 @@ void UpdateRenderTarget(EffectTree* effect_tree,
   }
 }
 
-void ComputeEffects(EffectTree* effect_tree) {
+static void ComputeEffectsInParallel(
+    EffectTree* effect_tree,
+    ParallelLayerListRunner* layer_list_runner) {
   if (!effect_tree->needs_update())
     return;
-  for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i)
-    effect_tree->UpdateEffects(i);
+  if (!UpdatePropertyTreeInParallel(
+          *effect_tree, std::vector<int>(), layer_list_runner,
+          base::Bind(&EffectTree::UpdateEffects,
+                     base::Unretained(effect_tree)))) {
+    for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i)
+      effect_tree->UpdateEffects(i);
+  }
   effect_tree->set_needs_update(false);
 }
 
+void ComputeEffects(EffectTree* effect_tree) {
+  ComputeEffectsInParallel(effect_tree, nullptr);
+}
+
 static gfx::RectF ComputeCurrentClip(const ClipNode* clip_node,
                                      const TransformTree& transform_tree,
                                      int target_transform_id) {
@@ -758,7 +948,8 @@ static void ComputeVisibleRectsInternal(
     PropertyTrees* property_trees,
     bool can_render_to_separate_surface,
     LayerImplList* update_layer_list,
-    std::vector<LayerImpl*>* visible_layer_list) {
+    std::vector<LayerImpl*>* visible_layer_list,
+    ParallelLayerListRunner* layer_list_runner) {
   if (property_trees->non_root_surfaces_enabled !=
       can_render_to_separate_surface) {
     property_trees->non_root_surfaces_enabled = can_render_to_separate_surface;
@@ -770,14 +961,27 @@ static void ComputeVisibleRectsInternal(
   }
   UpdateRenderTarget(&property_trees->effect_tree,
                      property_trees->non_root_surfaces_enabled);
-  ComputeTransforms(&property_trees->transform_tree);
-  ComputeClips(&property_trees->clip_tree, property_trees->transform_tree,
-               can_render_to_separate_surface);
-  ComputeEffects(&property_trees->effect_tree);
+  ComputeTransformsInParallel(&property_trees->transform_tree,
+                              layer_list_runner);
+  ComputeClipsInParallel(&property_trees->clip_tree,
+                         property_trees->transform_tree,
+                         can_render_to_separate_surface, layer_list_runner);
+  ComputeEffectsInParallel(&property_trees->effect_tree, layer_list_runner);
 
   FindLayersThatNeedUpdates(
       root_layer->layer_tree_impl(), property_trees->transform_tree,
       property_trees->effect_tree, update_layer_list, visible_layer_list);
+  if (layer_list_runner) {
+    // Each layer only reads the property trees and writes its own visible
+    // rect, so the layers can be processed in any order.
+    layer_list_runner->ForEachLayer(
+        *visible_layer_list,
+        base::Bind(&CalculateVisibleRect<LayerImpl>,
+                   base::ConstRef(property_trees->clip_tree),
+                   base::ConstRef(property_trees->transform_tree),
+                   can_render_to_separate_surface));
+    return;
+  }
   CalculateVisibleRects<LayerImpl>(
       *visible_layer_list, property_trees->clip_tree,
       property_trees->transform_tree, can_render_to_separate_surface);
@@ -828,7 +1032,8 @@ void BuildPropertyTreesAndComputeVisibleRects(
       elastic_overscroll, page_scale_factor, device_scale_factor, viewport,
       device_transform, property_trees);
   ComputeVisibleRects(root_layer, property_trees,
-                      can_render_to_separate_surface, visible_layer_list);
+                      can_render_to_separate_surface, visible_layer_list,
+                      nullptr);
 }
 
 void VerifyClipTreeCalculations(const LayerImplList& layer_list,
@@ -843,7 +1048,8 @@ void VerifyClipTreeCalculations(const LayerImplList& layer_list,
 void ComputeVisibleRects(LayerImpl* root_layer,
                          PropertyTrees* property_trees,
                          bool can_render_to_separate_surface,
-                         LayerImplList* visible_layer_list) {
+                         LayerImplList* visible_layer_list,
+                         ParallelLayerListRunner* layer_list_runner) {
   for (auto* layer : *root_layer->layer_tree_impl()) {
     UpdateRenderSurfaceForLayer(&property_trees->effect_tree,
                                 can_render_to_separate_surface, layer);
@@ -859,7 +1065,8 @@ void ComputeVisibleRects(LayerImpl* root_layer,
   LayerImplList update_layer_list;
   ComputeVisibleRectsInternal(root_layer, property_trees,
                               can_render_to_separate_surface,
-                              &update_layer_list, visible_layer_list);
+                              &update_layer_list, visible_layer_list,
+                              layer_list_runner);
 }
 
 bool LayerNeedsUpdate(Layer* layer,
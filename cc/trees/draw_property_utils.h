@@ -21,6 +21,7 @@ struct DrawProperties;
 class Layer;
 class LayerImpl;
 class LayerTreeHost;
+class ParallelLayerListRunner;
 class RenderSurfaceImpl;
 class EffectTree;
 class TransformTree;
@@ -69,10 +70,14 @@ ComputeVisibleRectsForTesting(PropertyTrees* property_trees,
                               bool can_render_to_separate_surface,
                               LayerList* visible_layer_list);
 
+// Computes the visible rects of the layers to draw. If |layer_list_runner| is
+// not null, it is used to update sibling subtrees of the property trees in
+// parallel, then to process the layers in parallel.
 void CC_EXPORT ComputeVisibleRects(LayerImpl* root_layer,
                                    PropertyTrees* property_trees,
                                    bool can_render_to_separate_surface,
-                                   LayerImplList* visible_layer_list);
+                                   LayerImplList* visible_layer_list,
+                                   ParallelLayerListRunner* layer_list_runner);
 
 void CC_EXPORT ComputeLayerDrawProperties(LayerImpl* layer,
                                           const PropertyTrees* property_trees,
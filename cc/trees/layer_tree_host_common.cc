@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "base/bind.h"
 #include "base/containers/adapters.h"
 #include "base/trace_event/trace_event.h"
 #include "cc/base/math_util.h"
@@ -20,6 +21,7 @@
 #include "cc/trees/draw_property_utils.h"
 #include "cc/trees/layer_tree_host.h"
 #include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/parallel_layer_list_runner.h"
 #include "cc/trees/property_tree_builder.h"
 #include "ui/gfx/geometry/rect_conversions.h"
 #include "ui/gfx/geometry/vector2d_conversions.h"
@@ -103,7 +105,8 @@ LayerTreeHostCommon::CalcDrawPropsImplInputs::CalcDrawPropsImplInputs(
       can_adjust_raster_scales(can_adjust_raster_scales),
       verify_clip_tree_calculations(verify_clip_tree_calculations),
       render_surface_layer_list(render_surface_layer_list),
-      property_trees(property_trees) {}
+      property_trees(property_trees),
+      layer_list_runner(nullptr) {}
 
 LayerTreeHostCommon::CalcDrawPropsImplInputsForTesting::
     CalcDrawPropsImplInputsForTesting(LayerImpl* root_layer,
@@ -511,6 +514,22 @@ static void ComputeMaskLayerDrawProperties(const LayerImpl* layer,
       layer->draw_properties().starting_animation_contents_scale;
 }
 
+// Only writes the draw properties of |layer| and of its masks, so it can run
+// for several layers concurrently.
+static void ComputeDrawPropertiesForLayer(const PropertyTrees* property_trees,
+                                          bool layers_always_allowed_lcd_text,
+                                          bool can_use_lcd_text,
+                                          LayerImpl* layer) {
+  draw_property_utils::ComputeLayerDrawProperties(
+      layer, property_trees, layers_always_allowed_lcd_text, can_use_lcd_text);
+  if (layer->mask_layer())
+    ComputeMaskLayerDrawProperties(layer, layer->mask_layer());
+  LayerImpl* replica_mask_layer =
+      layer->replica_layer() ? layer->replica_layer()->mask_layer() : nullptr;
+  if (replica_mask_layer)
+    ComputeMaskLayerDrawProperties(layer, replica_mask_layer);
+}
+
 void CalculateDrawPropertiesInternal(
     LayerTreeHostCommon::CalcDrawPropsImplInputs* inputs,
     PropertyTreeOption property_tree_option) {
@@ -581,7 +600,8 @@ void CalculateDrawPropertiesInternal(
           inputs->device_transform);
       draw_property_utils::ComputeVisibleRects(
           inputs->root_layer, inputs->property_trees,
-          inputs->can_render_to_separate_surface, &visible_layer_list);
+          inputs->can_render_to_separate_surface, &visible_layer_list,
+          inputs->layer_list_runner);
       break;
     }
   }
@@ -593,16 +613,18 @@ void CalculateDrawPropertiesInternal(
 
   DCHECK(inputs->can_render_to_separate_surface ==
          inputs->property_trees->non_root_surfaces_enabled);
-  for (LayerImpl* layer : visible_layer_list) {
-    draw_property_utils::ComputeLayerDrawProperties(
-        layer, inputs->property_trees, inputs->layers_always_allowed_lcd_text,
-        inputs->can_use_lcd_text);
-    if (layer->mask_layer())
-      ComputeMaskLayerDrawProperties(layer, layer->mask_layer());
-    LayerImpl* replica_mask_layer =
-        layer->replica_layer() ? layer->replica_layer()->mask_layer() : nullptr;
-    if (replica_mask_layer)
-      ComputeMaskLayerDrawProperties(layer, replica_mask_layer);
+  if (inputs->layer_list_runner) {
+    inputs->layer_list_runner->ForEachLayer(
+        visible_layer_list,
+        base::Bind(&ComputeDrawPropertiesForLayer, inputs->property_trees,
+                   inputs->layers_always_allowed_lcd_text,
+                   inputs->can_use_lcd_text));
+  } else {
+    for (LayerImpl* layer : visible_layer_list) {
+      ComputeDrawPropertiesForLayer(inputs->property_trees,
+                                    inputs->layers_always_allowed_lcd_text,
+                                    inputs->can_use_lcd_text, layer);
+    }
   }
 
   CalculateRenderSurfaceLayerList(
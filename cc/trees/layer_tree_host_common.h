@@ -33,6 +33,7 @@ class ScrollAndScaleSet;
 
 class LayerImpl;
 class Layer;
+class ParallelLayerListRunner;
 class SwapPromise;
 class PropertyTrees;
 
@@ -103,6 +104,8 @@ class CC_EXPORT LayerTreeHostCommon {
     bool verify_clip_tree_calculations;
     LayerImplList* render_surface_layer_list;
     PropertyTrees* property_trees;
+    // If not null, the per-layer computations run on it. Null by default.
+    ParallelLayerListRunner* layer_list_runner;
   };
 
   struct CC_EXPORT CalcDrawPropsImplInputsForTesting
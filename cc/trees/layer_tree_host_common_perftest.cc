@@ -16,6 +16,7 @@
 #include "base/time/time.h"
 #include "cc/debug/lap_timer.h"
 #include "cc/layers/layer.h"
+#include "cc/layers/picture_layer.h"
 #include "cc/output/bsp_tree.h"
 #include "cc/quads/draw_polygon.h"
 #include "cc/quads/draw_quad.h"
@@ -23,9 +24,11 @@
 #include "cc/test/fake_layer_tree_host_client.h"
 #include "cc/test/layer_tree_json_parser.h"
 #include "cc/test/layer_tree_test.h"
+#include "cc/test/multi_thread_task_graph_runner.h"
 #include "cc/test/paths.h"
 #include "cc/trees/layer_tree_host_common.h"
 #include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/parallel_layer_list_runner.h"
 #include "testing/perf/perf_test.h"
 
 namespace cc {
@@ -35,6 +38,11 @@ static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
 
+// Shape of the generated layer tree used when no test file is read: a root
+// with kNumContainers clipping containers of kLayersPerContainer layers each.
+static const int kNumContainers = 50;
+static const int kLayersPerContainer = 100;
+
 class LayerTreeHostCommonPerfTest : public LayerTreeTest {
  public:
   LayerTreeHostCommonPerfTest()
@@ -53,12 +61,41 @@ class LayerTreeHostCommonPerfTest : public LayerTreeTest {
     gfx::Size viewport = gfx::Size(720, 1038);
     layer_tree_host()->SetViewportSize(viewport);
     scoped_refptr<Layer> root =
-        ParseTreeFromJson(json_, &content_layer_client_);
+        json_.empty() ? BuildGeneratedTree(viewport)
+                      : ParseTreeFromJson(json_, &content_layer_client_);
     ASSERT_TRUE(root.get());
     layer_tree_host()->SetRootLayer(root);
     content_layer_client_.set_bounds(viewport);
   }
 
+  // Builds a tree of kNumContainers * kLayersPerContainer drawable layers,
+  // with some of them partially clipped or transformed.
+  scoped_refptr<Layer> BuildGeneratedTree(const gfx::Size& viewport) {
+    scoped_refptr<Layer> root = Layer::Create();
+    root->SetBounds(viewport);
+    for (int i = 0; i < kNumContainers; ++i) {
+      scoped_refptr<Layer> container = Layer::Create();
+      container->SetPosition(gfx::PointF(0.f, 20.f * i));
+      container->SetBounds(gfx::Size(viewport.width(), 200));
+      container->SetMasksToBounds(true);
+      root->AddChild(container);
+      for (int j = 0; j < kLayersPerContainer; ++j) {
+        scoped_refptr<PictureLayer> layer =
+            PictureLayer::Create(&content_layer_client_);
+        layer->SetIsDrawable(true);
+        layer->SetPosition(gfx::PointF(7.f * j, 3.f * (j % 10)));
+        layer->SetBounds(gfx::Size(64, 64));
+        if (j % 4 == 0) {
+          gfx::Transform transform;
+          transform.Rotate(j % 90);
+          layer->SetTransform(transform);
+        }
+        container->AddChild(layer);
+      }
+    }
+    return root;
+  }
+
   void SetTestName(const std::string& name) { test_name_ = name; }
 
   void AfterTest() override {
@@ -80,11 +117,29 @@ class LayerTreeHostCommonPerfTest : public LayerTreeTest {
 
 class CalcDrawPropsTest : public LayerTreeHostCommonPerfTest {
  public:
+  CalcDrawPropsTest() : num_worker_threads_(0), layer_list_runner_(nullptr) {}
+
   void RunCalcDrawProps() { RunTest(CompositorMode::SINGLE_THREADED, false); }
 
+  // Computes the per-layer draw properties on |num_worker_threads| worker
+  // threads in addition to the compositor thread.
+  void SetNumWorkerThreads(int num_worker_threads) {
+    num_worker_threads_ = num_worker_threads;
+  }
+
   void BeginTest() override { PostSetNeedsCommitToMainThread(); }
 
   void DrawLayersOnThread(LayerTreeHostImpl* host_impl) override {
+    std::unique_ptr<MultiThreadTaskGraphRunner> task_graph_runner;
+    std::unique_ptr<ParallelLayerListRunner> layer_list_runner;
+    if (num_worker_threads_) {
+      task_graph_runner.reset(
+          new MultiThreadTaskGraphRunner(num_worker_threads_));
+      layer_list_runner.reset(new ParallelLayerListRunner(
+          task_graph_runner.get(), num_worker_threads_));
+      layer_list_runner_ = layer_list_runner.get();
+    }
+
     timer_.Reset();
     LayerTreeImpl* active_tree = host_impl->active_tree();
 
@@ -99,6 +154,7 @@ class CalcDrawPropsTest : public LayerTreeHostCommonPerfTest {
       timer_.NextLap();
     } while (!timer_.HasTimeLimitExpired());
 
+    layer_list_runner_ = nullptr;
     EndTest();
   }
 
@@ -122,8 +178,13 @@ class CalcDrawPropsTest : public LayerTreeHostCommonPerfTest {
         host_impl->settings().layer_transforms_should_scale_layer_contents,
         false,  // do not verify_clip_tree_calculation for perf tests
         &update_list, active_tree->property_trees());
+    inputs.layer_list_runner = layer_list_runner_;
     LayerTreeHostCommon::CalculateDrawProperties(&inputs);
   }
+
+ private:
+  int num_worker_threads_;
+  ParallelLayerListRunner* layer_list_runner_;
 };
 
 class BspTreePerfTest : public CalcDrawPropsTest {
@@ -213,6 +274,17 @@ TEST_F(CalcDrawPropsTest, TouchRegionHeavy) {
   RunCalcDrawProps();
 }
 
+TEST_F(CalcDrawPropsTest, FiveThousandLayers) {
+  SetTestName("5000_layers");
+  RunCalcDrawProps();
+}
+
+TEST_F(CalcDrawPropsTest, FiveThousandLayersParallel) {
+  SetTestName("5000_layers_parallel_3_workers");
+  SetNumWorkerThreads(3);
+  RunCalcDrawProps();
+}
+
 TEST_F(BspTreePerfTest, LayerSorterCubes) {
   SetTestName("layer_sort_cubes");
   ReadTestFile("layer_sort_cubes");
@@ -86,6 +86,7 @@
 #include "cc/trees/layer_tree_host.h"
 #include "cc/trees/layer_tree_host_common.h"
 #include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/parallel_layer_list_runner.h"
 #include "cc/trees/single_thread_proxy.h"
 #include "cc/trees/tree_synchronizer.h"
 #include "gpu/GLES2/gl2extchromium.h"
@@ -99,6 +100,10 @@
 namespace cc {
 namespace {
 
+// Maximum number of worker tasks computing draw properties at once, in
+// addition to the compositor thread.
+const size_t kMaxParallelDrawPropertiesTasks = 3;
+
 // Small helper class that saves the current viewport location as the user sees
 // it and resets to the same location.
 class ViewportAnchor {
@@ -266,6 +271,14 @@ LayerTreeHostImpl::LayerTreeHostImpl(
       TopControlsManager::Create(this,
                                  settings.top_controls_show_threshold,
                                  settings.top_controls_hide_threshold);
+
+  // A synchronous task graph runner only runs tasks when asked to, so the
+  // compositor thread would end up doing all the work anyway.
+  if (settings.use_parallel_draw_properties && task_graph_runner_ &&
+      !is_synchronous_single_threaded_) {
+    layer_list_runner_.reset(new ParallelLayerListRunner(
+        task_graph_runner_, kMaxParallelDrawPropertiesTasks));
+  }
 }
 
 LayerTreeHostImpl::~LayerTreeHostImpl() {
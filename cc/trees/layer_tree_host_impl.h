@@ -61,6 +61,7 @@ class LayerImpl;
 class LayerTreeImpl;
 class MemoryHistory;
 class PageScaleAnimation;
+class ParallelLayerListRunner;
 class PictureLayerImpl;
 class RasterTilePriorityQueue;
 class TileTaskManager;
@@ -389,6 +390,7 @@ class CC_EXPORT LayerTreeHostImpl
 
   virtual bool InitializeRenderer(OutputSurface* output_surface);
   TileManager* tile_manager() { return tile_manager_.get(); }
+  TaskGraphRunner* task_graph_runner() { return task_graph_runner_; }
 
   void SetHasGpuRasterizationTrigger(bool flag) {
     has_gpu_rasterization_trigger_ = flag;
@@ -574,6 +576,11 @@ class CC_EXPORT LayerTreeHostImpl
   void ResetRequiresHighResToDraw() { requires_high_res_to_draw_ = false; }
   bool RequiresHighResToDraw() const { return requires_high_res_to_draw_; }
 
+  // Null unless parallel draw properties are enabled in the settings.
+  ParallelLayerListRunner* layer_list_runner() const {
+    return layer_list_runner_.get();
+  }
+
   // Only valid for synchronous (non-scheduled) single-threaded case.
   void SynchronouslyInitializeAllTiles();
 
@@ -842,6 +849,7 @@ class CC_EXPORT LayerTreeHostImpl
   SharedBitmapManager* shared_bitmap_manager_;
   gpu::GpuMemoryBufferManager* gpu_memory_buffer_manager_;
   TaskGraphRunner* task_graph_runner_;
+  std::unique_ptr<ParallelLayerListRunner> layer_list_runner_;
   int id_;
 
   std::set<SwapPromiseMonitor*> swap_promise_monitor_;
@@ -844,6 +844,7 @@ bool LayerTreeImpl::UpdateDrawProperties(bool update_lcd_text) {
         settings().layer_transforms_should_scale_layer_contents,
         settings().verify_clip_tree_calculations, &render_surface_layer_list_,
         &property_trees_);
+    inputs.layer_list_runner = layer_tree_host_impl_->layer_list_runner();
     LayerTreeHostCommon::CalculateDrawProperties(&inputs);
     if (const char* client_name = GetClientNameForMetrics()) {
       UMA_HISTOGRAM_COUNTS(
@@ -1145,6 +1146,10 @@ TileManager* LayerTreeImpl::tile_manager() const {
   return layer_tree_host_impl_->tile_manager();
 }
 
+TaskGraphRunner* LayerTreeImpl::task_graph_runner() const {
+  return layer_tree_host_impl_->task_graph_runner();
+}
+
 ImageDecodeController* LayerTreeImpl::image_decode_controller() const {
   return layer_tree_host_impl_->image_decode_controller();
 }
@@ -48,6 +48,7 @@ class MemoryHistory;
 class OutputSurface;
 class PageScaleAnimation;
 class PictureLayerImpl;
+class TaskGraphRunner;
 class TaskRunnerProvider;
 class ResourceProvider;
 class TileManager;
@@ -90,6 +91,7 @@ class CC_EXPORT LayerTreeImpl {
   ResourceProvider* resource_provider() const;
   TileManager* tile_manager() const;
   ImageDecodeController* image_decode_controller() const;
+  TaskGraphRunner* task_graph_runner() const;
   FrameRateCounter* frame_rate_counter() const;
   MemoryHistory* memory_history() const;
   gfx::Size device_viewport_size() const;
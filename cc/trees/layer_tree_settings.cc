@@ -107,6 +107,7 @@ LayerTreeSettings::LayerTreeSettings()
       abort_commit_before_output_surface_creation(true),
       use_mouse_wheel_gestures(false),
       use_layer_lists(false),
+      use_parallel_draw_properties(false),
       max_staging_buffer_usage_in_bytes(32 * 1024 * 1024),
       memory_policy_(64 * 1024 * 1024,
                      gpu::MemoryAllocation::CUTOFF_ALLOW_EVERYTHING,
@@ -174,6 +175,7 @@ bool LayerTreeSettings::operator==(const LayerTreeSettings& other) const {
          image_decode_tasks_enabled == other.image_decode_tasks_enabled &&
          wait_for_beginframe_interval == other.wait_for_beginframe_interval &&
          use_mouse_wheel_gestures == other.use_mouse_wheel_gestures &&
+         use_parallel_draw_properties == other.use_parallel_draw_properties &&
          max_staging_buffer_usage_in_bytes ==
              other.max_staging_buffer_usage_in_bytes &&
          memory_policy_ == other.memory_policy_ &&
@@ -234,6 +236,7 @@ void LayerTreeSettings::ToProtobuf(proto::LayerTreeSettings* proto) const {
   proto->set_image_decode_tasks_enabled(image_decode_tasks_enabled);
   proto->set_wait_for_beginframe_interval(wait_for_beginframe_interval);
   proto->set_use_mouse_wheel_gestures(use_mouse_wheel_gestures);
+  proto->set_use_parallel_draw_properties(use_parallel_draw_properties);
   proto->set_max_staging_buffer_usage_in_bytes(
       max_staging_buffer_usage_in_bytes);
   memory_policy_.ToProtobuf(proto->mutable_memory_policy());
@@ -298,6 +301,7 @@ void LayerTreeSettings::FromProtobuf(const proto::LayerTreeSettings& proto) {
   image_decode_tasks_enabled = proto.image_decode_tasks_enabled();
   wait_for_beginframe_interval = proto.wait_for_beginframe_interval();
   use_mouse_wheel_gestures = proto.use_mouse_wheel_gestures();
+  use_parallel_draw_properties = proto.use_parallel_draw_properties();
   max_staging_buffer_usage_in_bytes = proto.max_staging_buffer_usage_in_bytes();
   memory_policy_.FromProtobuf(proto.memory_policy());
   initial_debug_state.FromProtobuf(proto.initial_debug_state());
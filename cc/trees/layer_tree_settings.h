@@ -92,6 +92,10 @@ class CC_EXPORT LayerTreeSettings {
   bool abort_commit_before_output_surface_creation;
   bool use_mouse_wheel_gestures;
   bool use_layer_lists;
+  // If set to true, the property trees are updated and the per-layer draw
+  // properties are computed on the worker threads of the task graph runner as
+  // well as on the compositor thread.
+  bool use_parallel_draw_properties;
   int max_staging_buffer_usage_in_bytes;
   ManagedMemoryPolicy memory_policy_;
 
@@ -86,6 +86,8 @@ TEST(LayerTreeSettingsTest, AllMembersChanged) {
       !settings.use_occlusion_for_tile_prioritization;
   settings.wait_for_beginframe_interval =
       !settings.wait_for_beginframe_interval;
+  settings.use_parallel_draw_properties =
+      !settings.use_parallel_draw_properties;
   settings.max_staging_buffer_usage_in_bytes =
       settings.max_staging_buffer_usage_in_bytes * 3 + 1;
   settings.memory_policy_ = ManagedMemoryPolicy(
@@ -141,6 +143,7 @@ TEST(LayerTreeSettingsTest, ArbitraryValues) {
   settings.scheduled_raster_task_limit = 41;
   settings.use_occlusion_for_tile_prioritization = true;
   settings.wait_for_beginframe_interval = true;
+  settings.use_parallel_draw_properties = true;
   settings.max_staging_buffer_usage_in_bytes = 70;
   settings.memory_policy_ = ManagedMemoryPolicy(
       71, gpu::MemoryAllocation::CUTOFF_ALLOW_NICE_TO_HAVE, 77);
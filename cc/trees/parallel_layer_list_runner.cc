@@ -0,0 +1,186 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/trees/parallel_layer_list_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
+#include "cc/base/completion_event.h"
+#include "cc/raster/task_category.h"
+
+namespace cc {
+namespace {
+
+size_t NumChunks(size_t count, size_t indices_per_chunk) {
+  return (count + indices_per_chunk - 1) / indices_per_chunk;
+}
+
+void RunForLayer(const LayerImplList* layers,
+                 const base::Callback<void(LayerImpl*)>& function,
+                 size_t index) {
+  function.Run((*layers)[index]);
+}
+
+// The chunks of one ForEachIndex() call. Chunks are claimed with an atomic
+// counter, so each one is processed exactly once by whichever thread gets to
+// it first.
+class ChunkedWork : public base::RefCountedThreadSafe<ChunkedWork> {
+ public:
+  ChunkedWork(size_t count,
+              size_t indices_per_chunk,
+              const base::Callback<void(size_t)>& function)
+      : count_(count),
+        indices_per_chunk_(indices_per_chunk),
+        function_(function),
+        num_chunks_(NumChunks(count, indices_per_chunk)),
+        next_chunk_(0),
+        finished_chunks_(0) {}
+
+  // Processes chunks until there are none left to claim.
+  void RunChunks() {
+    size_t finished_chunks = 0;
+    for (;;) {
+      size_t chunk = static_cast<size_t>(
+          base::subtle::NoBarrier_AtomicIncrement(&next_chunk_, 1) - 1);
+      if (chunk >= num_chunks_)
+        break;
+      size_t begin = chunk * indices_per_chunk_;
+      size_t end = std::min(begin + indices_per_chunk_, count_);
+      for (size_t i = begin; i < end; ++i)
+        function_.Run(i);
+      ++finished_chunks;
+    }
+    if (!finished_chunks)
+      return;
+
+    // Signaling the event also publishes the writes made by |function_| to
+    // the thread waiting in WaitForAllChunks().
+    base::AutoLock lock(lock_);
+    finished_chunks_ += finished_chunks;
+    if (finished_chunks_ == num_chunks_)
+      all_chunks_finished_.Signal();
+  }
+
+  // Must be called exactly once, by the thread that called ForEachIndex().
+  void WaitForAllChunks() { all_chunks_finished_.Wait(); }
+
+ private:
+  friend class base::RefCountedThreadSafe<ChunkedWork>;
+
+  ~ChunkedWork() {}
+
+  // Only accessed while there are chunks left to claim, which the thread that
+  // called ForEachIndex() waits for.
+  const size_t count_;
+  const size_t indices_per_chunk_;
+  const base::Callback<void(size_t)> function_;
+  const size_t num_chunks_;
+
+  base::subtle::Atomic32 next_chunk_;
+
+  base::Lock lock_;
+  size_t finished_chunks_;
+  CompletionEvent all_chunks_finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkedWork);
+};
+
+class ChunkedWorkTask : public Task {
+ public:
+  explicit ChunkedWorkTask(scoped_refptr<ChunkedWork> work)
+      : work_(std::move(work)) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override {
+    TRACE_EVENT0("cc", "ChunkedWorkTask::RunOnWorkerThread");
+    work_->RunChunks();
+  }
+
+ protected:
+  ~ChunkedWorkTask() override {}
+
+ private:
+  scoped_refptr<ChunkedWork> work_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkedWorkTask);
+};
+
+}  // namespace
+
+ParallelLayerListRunner::ParallelLayerListRunner(
+    TaskGraphRunner* task_graph_runner,
+    size_t max_worker_tasks)
+    : task_graph_runner_(task_graph_runner),
+      namespace_token_(task_graph_runner->GetNamespaceToken()),
+      max_worker_tasks_(max_worker_tasks) {}
+
+ParallelLayerListRunner::~ParallelLayerListRunner() {
+  // Tasks that found no chunk left may still be running.
+  graph_.Reset();
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+  task_graph_runner_->WaitForTasksToFinishRunning(namespace_token_);
+  task_graph_runner_->CollectCompletedTasks(namespace_token_,
+                                            &completed_tasks_);
+}
+
+void ParallelLayerListRunner::ForEachLayer(
+    const LayerImplList& layers,
+    const base::Callback<void(LayerImpl*)>& function) {
+  ForEachIndex(layers.size(), kLayersPerChunk,
+               base::Bind(&RunForLayer, &layers, function));
+}
+
+void ParallelLayerListRunner::ForEachIndex(
+    size_t count,
+    size_t indices_per_chunk,
+    const base::Callback<void(size_t)>& function) {
+  DCHECK_GT(indices_per_chunk, 0u);
+  // The calling thread processes chunks too, so a single chunk never needs a
+  // worker.
+  size_t num_chunks = NumChunks(count, indices_per_chunk);
+  size_t num_worker_tasks =
+      num_chunks > 1 ? std::min(max_worker_tasks_, num_chunks - 1) : 0;
+  if (!num_worker_tasks) {
+    for (size_t i = 0; i < count; ++i)
+      function.Run(i);
+    return;
+  }
+
+  TRACE_EVENT1("cc", "ParallelLayerListRunner::ForEachIndex", "count", count);
+
+  scoped_refptr<ChunkedWork> work(
+      new ChunkedWork(count, indices_per_chunk, function));
+
+  // Release the tasks of the previous call that finished since.
+  task_graph_runner_->CollectCompletedTasks(namespace_token_,
+                                            &completed_tasks_);
+  completed_tasks_.clear();
+
+  graph_.Reset();
+  for (size_t i = 0; i < num_worker_tasks; ++i) {
+    tasks_.push_back(make_scoped_refptr(new ChunkedWorkTask(work)));
+    graph_.nodes.push_back(TaskGraph::Node(
+        tasks_.back().get(), TASK_CATEGORY_FOREGROUND, 0u /* priority */,
+        0u /* dependencies */));
+  }
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+
+  work->RunChunks();
+  work->WaitForAllChunks();
+
+  // Cancel the tasks that did not start yet instead of waiting for a worker
+  // to run them. From now on, the work queue keeps the tasks alive until they
+  // are collected.
+  graph_.Reset();
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph_);
+  tasks_.clear();
+}
+
+}  // namespace cc
@@ -0,0 +1,64 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TREES_PARALLEL_LAYER_LIST_RUNNER_H_
+#define CC_TREES_PARALLEL_LAYER_LIST_RUNNER_H_
+
+#include <stddef.h>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "cc/base/cc_export.h"
+#include "cc/layers/layer_collections.h"
+#include "cc/raster/task_graph_runner.h"
+
+namespace cc {
+
+// Runs a function for every layer of a layer list, or for every index of a
+// range, splitting them in chunks that are processed both by the calling
+// thread and by tasks on the worker threads of a TaskGraphRunner. The calling
+// thread never waits for a worker to be available: it processes whatever
+// chunks the workers did not pick up, and only waits for the chunks already
+// being processed.
+class CC_EXPORT ParallelLayerListRunner {
+ public:
+  // Number of consecutive layers processed together.
+  static const size_t kLayersPerChunk = 32;
+
+  // |task_graph_runner| must outlive this. At most |max_worker_tasks| tasks
+  // are scheduled at once.
+  ParallelLayerListRunner(TaskGraphRunner* task_graph_runner,
+                          size_t max_worker_tasks);
+  ~ParallelLayerListRunner();
+
+  // Calls |function| once for every layer of |layers|, in no particular order
+  // and possibly concurrently, and returns once all calls returned. |function|
+  // must only modify state owned by the layer it is called for. Lists of less
+  // than two chunks are processed on the calling thread.
+  void ForEachLayer(const LayerImplList& layers,
+                    const base::Callback<void(LayerImpl*)>& function);
+
+  // Calls |function| once for every index in [0, |count|), in chunks of
+  // |indices_per_chunk| consecutive indices, with the same guarantees as
+  // ForEachLayer(). |function| must only modify state owned by its index.
+  void ForEachIndex(size_t count,
+                    size_t indices_per_chunk,
+                    const base::Callback<void(size_t)>& function);
+
+ private:
+  TaskGraphRunner* task_graph_runner_;
+  NamespaceToken namespace_token_;
+  const size_t max_worker_tasks_;
+
+  // Only used in ForEachLayer(), kept to reuse their storage.
+  TaskGraph graph_;
+  Task::Vector tasks_;
+  Task::Vector completed_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelLayerListRunner);
+};
+
+}  // namespace cc
+
+#endif  // CC_TREES_PARALLEL_LAYER_LIST_RUNNER_H_
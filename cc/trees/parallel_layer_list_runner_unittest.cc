@@ -0,0 +1,280 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/trees/parallel_layer_list_runner.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/threading/platform_thread.h"
+#include "cc/layers/layer_impl.h"
+#include "cc/layers/render_surface_impl.h"
+#include "cc/test/fake_impl_task_runner_provider.h"
+#include "cc/test/fake_layer_tree_host_impl.h"
+#include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
+#include "cc/trees/layer_tree_host_common.h"
+#include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/property_tree.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/transform.h"
+
+namespace cc {
+namespace {
+
+void CountCall(std::vector<int>* calls_per_layer, LayerImpl* layer) {
+  (*calls_per_layer)[layer->id()]++;
+}
+
+void RecordThread(std::vector<base::PlatformThreadId>* threads_per_layer,
+                  LayerImpl* layer) {
+  (*threads_per_layer)[layer->id()] = base::PlatformThread::CurrentId();
+}
+
+void CountIndex(std::vector<int>* calls_per_index, size_t index) {
+  (*calls_per_index)[index]++;
+}
+
+// Builds a tree with clips, render surfaces and non-trivial transforms, large
+// enough for its property trees to be updated in parallel.
+LayerImpl* BuildLayerTree(LayerTreeImpl* tree) {
+  int id = 1;
+  std::unique_ptr<LayerImpl> root = LayerImpl::Create(tree, id++);
+  root->SetBounds(gfx::Size(800, 600));
+  root->SetDrawsContent(true);
+  for (int i = 0; i < 6; ++i) {
+    std::unique_ptr<LayerImpl> container = LayerImpl::Create(tree, id++);
+    gfx::Transform container_transform;
+    container_transform.Translate(10.f * i, 15.f * i);
+    container_transform.RotateAboutZAxis(5.f * i);
+    container->SetTransform(container_transform);
+    container->SetPosition(gfx::PointF(50.f * i, 20.f));
+    container->SetBounds(gfx::Size(300, 200));
+    container->SetDrawsContent(true);
+    container->SetMasksToBounds(i % 2 == 0);
+    container->SetForceRenderSurface(i % 3 == 0);
+    if (i % 3 == 1)
+      container->SetOpacity(0.5f);
+    for (int j = 0; j < 24; ++j) {
+      std::unique_ptr<LayerImpl> child = LayerImpl::Create(tree, id++);
+      gfx::Transform child_transform;
+      child_transform.Scale(1.f + 0.05f * j, 0.9f);
+      child_transform.RotateAboutZAxis(3.f * j);
+      child->SetTransform(child_transform);
+      child->SetPosition(gfx::PointF(13.f * j, 7.f * j));
+      child->SetBounds(gfx::Size(40 + j, 30));
+      child->SetDrawsContent(true);
+      child->SetMasksToBounds(j % 2 == 0);
+      if (j % 2 == 1)
+        child->SetOpacity(0.8f);
+      container->AddChild(std::move(child));
+    }
+    root->AddChild(std::move(container));
+  }
+  LayerImpl* root_layer = root.get();
+  tree->SetRootLayer(std::move(root));
+  return root_layer;
+}
+
+// Builds the property trees of |root|'s tree, then computes the draw
+// properties again with another device transform and viewport, on |runner|
+// unless it is null. The second computation updates every property tree node
+// and every layer, so nothing is left over from the first one.
+void CalculateDrawProperties(LayerImpl* root,
+                             ParallelLayerListRunner* runner,
+                             LayerImplList* render_surface_layer_list) {
+  LayerTreeHostCommon::CalcDrawPropsImplInputsForTesting build_inputs(
+      root, root->bounds(), render_surface_layer_list);
+  LayerTreeHostCommon::CalculateDrawPropertiesForTesting(&build_inputs);
+
+  gfx::Transform device_transform;
+  device_transform.Translate(5.f, 7.f);
+  device_transform.Scale(1.5f, 1.5f);
+  LayerTreeHostCommon::CalcDrawPropsImplInputsForTesting inputs(
+      root, gfx::Size(640, 480), device_transform, render_surface_layer_list);
+  inputs.layer_list_runner = runner;
+  LayerTreeHostCommon::CalculateDrawProperties(&inputs);
+}
+
+class ParallelLayerListRunnerTest : public testing::Test {
+ public:
+  ParallelLayerListRunnerTest()
+      : host_impl_(&task_runner_provider_,
+                   &shared_bitmap_manager_,
+                   &task_graph_runner_) {}
+
+  void CreateLayers(int num_layers) {
+    for (int id = 0; id < num_layers; ++id) {
+      owned_layers_.push_back(LayerImpl::Create(host_impl_.active_tree(), id));
+      layers_.push_back(owned_layers_.back().get());
+    }
+  }
+
+ protected:
+  FakeImplTaskRunnerProvider task_runner_provider_;
+  TestSharedBitmapManager shared_bitmap_manager_;
+  TestTaskGraphRunner task_graph_runner_;
+  FakeLayerTreeHostImpl host_impl_;
+  std::vector<std::unique_ptr<LayerImpl>> owned_layers_;
+  LayerImplList layers_;
+};
+
+TEST_F(ParallelLayerListRunnerTest, CallsFunctionOncePerLayer) {
+  const int kNumLayers = 50 * ParallelLayerListRunner::kLayersPerChunk + 7;
+  CreateLayers(kNumLayers);
+  ParallelLayerListRunner runner(&task_graph_runner_, 3);
+
+  // Run several times to make sure the runner can be reused while tasks of
+  // the previous runs may still be completing.
+  for (int run = 0; run < 5; ++run) {
+    std::vector<int> calls_per_layer(kNumLayers, 0);
+    runner.ForEachLayer(layers_, base::Bind(&CountCall, &calls_per_layer));
+    for (int id = 0; id < kNumLayers; ++id)
+      EXPECT_EQ(1, calls_per_layer[id]) << "layer " << id << " run " << run;
+  }
+}
+
+TEST_F(ParallelLayerListRunnerTest, SingleChunkRunsOnCallingThread) {
+  const int kNumLayers = ParallelLayerListRunner::kLayersPerChunk;
+  CreateLayers(kNumLayers);
+  ParallelLayerListRunner runner(&task_graph_runner_, 3);
+
+  std::vector<base::PlatformThreadId> threads_per_layer(kNumLayers);
+  runner.ForEachLayer(layers_, base::Bind(&RecordThread, &threads_per_layer));
+  for (int id = 0; id < kNumLayers; ++id)
+    EXPECT_EQ(base::PlatformThread::CurrentId(), threads_per_layer[id]);
+}
+
+TEST_F(ParallelLayerListRunnerTest, NoWorkerTasks) {
+  const int kNumLayers = 10 * ParallelLayerListRunner::kLayersPerChunk;
+  CreateLayers(kNumLayers);
+  ParallelLayerListRunner runner(&task_graph_runner_, 0);
+
+  std::vector<base::PlatformThreadId> threads_per_layer(kNumLayers);
+  runner.ForEachLayer(layers_, base::Bind(&RecordThread, &threads_per_layer));
+  for (int id = 0; id < kNumLayers; ++id)
+    EXPECT_EQ(base::PlatformThread::CurrentId(), threads_per_layer[id]);
+}
+
+TEST_F(ParallelLayerListRunnerTest, CallsFunctionOncePerIndex) {
+  const size_t kCount = 100;
+  ParallelLayerListRunner runner(&task_graph_runner_, 3);
+
+  for (size_t indices_per_chunk : {size_t(1), size_t(7), kCount}) {
+    std::vector<int> calls_per_index(kCount, 0);
+    runner.ForEachIndex(kCount, indices_per_chunk,
+                        base::Bind(&CountIndex, &calls_per_index));
+    for (size_t index = 0; index < kCount; ++index) {
+      EXPECT_EQ(1, calls_per_index[index]) << "index " << index
+                                           << " chunk " << indices_per_chunk;
+    }
+  }
+}
+
+TEST_F(ParallelLayerListRunnerTest, ParallelDrawPropertiesMatchSerial) {
+  FakeLayerTreeHostImpl serial_host_impl(
+      &task_runner_provider_, &shared_bitmap_manager_, &task_graph_runner_);
+  LayerTreeImpl* serial_tree = serial_host_impl.active_tree();
+  LayerTreeImpl* parallel_tree = host_impl_.active_tree();
+  LayerImpl* serial_root = BuildLayerTree(serial_tree);
+  LayerImpl* parallel_root = BuildLayerTree(parallel_tree);
+  ParallelLayerListRunner runner(&task_graph_runner_, 3);
+
+  LayerImplList serial_surfaces;
+  LayerImplList parallel_surfaces;
+  CalculateDrawProperties(serial_root, nullptr, &serial_surfaces);
+  CalculateDrawProperties(parallel_root, &runner, &parallel_surfaces);
+
+  const PropertyTrees* serial_trees = serial_tree->property_trees();
+  const PropertyTrees* parallel_trees = parallel_tree->property_trees();
+  // Otherwise the property trees were updated serially in both cases.
+  ASSERT_GE(parallel_trees->transform_tree.size(),
+            2 * ParallelLayerListRunner::kLayersPerChunk);
+  ASSERT_GE(parallel_trees->clip_tree.size(),
+            2 * ParallelLayerListRunner::kLayersPerChunk);
+  ASSERT_GE(parallel_trees->effect_tree.size(),
+            2 * ParallelLayerListRunner::kLayersPerChunk);
+
+  ASSERT_EQ(serial_trees->transform_tree.size(),
+            parallel_trees->transform_tree.size());
+  for (int id = 1; id < static_cast<int>(serial_trees->transform_tree.size());
+       ++id) {
+    const TransformNode* serial = serial_trees->transform_tree.Node(id);
+    const TransformNode* parallel = parallel_trees->transform_tree.Node(id);
+    EXPECT_EQ(serial->data.to_screen, parallel->data.to_screen) << id;
+    EXPECT_EQ(serial->data.to_target, parallel->data.to_target) << id;
+    EXPECT_EQ(serial->data.sublayer_scale, parallel->data.sublayer_scale)
+        << id;
+  }
+  ASSERT_EQ(serial_trees->clip_tree.size(), parallel_trees->clip_tree.size());
+  for (int id = 1; id < static_cast<int>(serial_trees->clip_tree.size());
+       ++id) {
+    const ClipNode* serial = serial_trees->clip_tree.Node(id);
+    const ClipNode* parallel = parallel_trees->clip_tree.Node(id);
+    EXPECT_EQ(serial->data.clip_in_target_space,
+              parallel->data.clip_in_target_space)
+        << id;
+    EXPECT_EQ(serial->data.combined_clip_in_target_space,
+              parallel->data.combined_clip_in_target_space)
+        << id;
+  }
+  ASSERT_EQ(serial_trees->effect_tree.size(),
+            parallel_trees->effect_tree.size());
+  for (int id = 1; id < static_cast<int>(serial_trees->effect_tree.size());
+       ++id) {
+    EXPECT_EQ(serial_trees->effect_tree.Node(id)->data.screen_space_opacity,
+              parallel_trees->effect_tree.Node(id)->data.screen_space_opacity)
+        << id;
+  }
+
+  for (auto* serial : *serial_tree) {
+    LayerImpl* parallel = parallel_tree->LayerById(serial->id());
+    ASSERT_TRUE(parallel);
+    const DrawProperties& serial_props = serial->draw_properties();
+    const DrawProperties& parallel_props = parallel->draw_properties();
+    EXPECT_EQ(serial_props.target_space_transform,
+              parallel_props.target_space_transform)
+        << serial->id();
+    EXPECT_EQ(serial_props.screen_space_transform,
+              parallel_props.screen_space_transform)
+        << serial->id();
+    EXPECT_EQ(serial_props.opacity, parallel_props.opacity) << serial->id();
+    EXPECT_EQ(serial_props.is_clipped, parallel_props.is_clipped)
+        << serial->id();
+    EXPECT_EQ(serial_props.clip_rect, parallel_props.clip_rect)
+        << serial->id();
+    EXPECT_EQ(serial_props.visible_layer_rect,
+              parallel_props.visible_layer_rect)
+        << serial->id();
+    EXPECT_EQ(serial_props.drawable_content_rect,
+              parallel_props.drawable_content_rect)
+        << serial->id();
+
+    ASSERT_EQ(!!serial->render_surface(), !!parallel->render_surface())
+        << serial->id();
+    if (!serial->render_surface())
+      continue;
+    const RenderSurfaceImpl* serial_surface = serial->render_surface();
+    const RenderSurfaceImpl* parallel_surface = parallel->render_surface();
+    EXPECT_EQ(serial_surface->content_rect(), parallel_surface->content_rect())
+        << serial->id();
+    EXPECT_EQ(serial_surface->draw_transform(),
+              parallel_surface->draw_transform())
+        << serial->id();
+    EXPECT_EQ(serial_surface->clip_rect(), parallel_surface->clip_rect())
+        << serial->id();
+    EXPECT_EQ(serial_surface->is_clipped(), parallel_surface->is_clipped())
+        << serial->id();
+    EXPECT_EQ(serial_surface->draw_opacity(), parallel_surface->draw_opacity())
+        << serial->id();
+  }
+
+  ASSERT_EQ(serial_surfaces.size(), parallel_surfaces.size());
+  for (size_t i = 0; i < serial_surfaces.size(); ++i)
+    EXPECT_EQ(serial_surfaces[i]->id(), parallel_surfaces[i]->id()) << i;
+}
+
+}  // namespace
+}  // namespace cc
@@ -4,6 +4,7 @@
 
 #include "chrome/browser/metrics/subprocess_metrics_provider.h"
 
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_base.h"
@@ -11,17 +12,23 @@
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/persistent_memory_allocator.h"
 #include "components/metrics/metrics_service.h"
+#include "content/public/browser/browser_child_process_host.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/child_process_data.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/notification_types.h"
 #include "content/public/browser/render_process_host.h"
 
 SubprocessMetricsProvider::SubprocessMetricsProvider()
-    : scoped_observer_(this) {
+    : scoped_observer_(this), weak_ptr_factory_(this) {
+  content::BrowserChildProcessObserver::Add(this);
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CREATED,
                  content::NotificationService::AllBrowserContextsAndSources());
 }
 
-SubprocessMetricsProvider::~SubprocessMetricsProvider() {}
+SubprocessMetricsProvider::~SubprocessMetricsProvider() {
+  content::BrowserChildProcessObserver::Remove(this);
+}
 
 void SubprocessMetricsProvider::RegisterSubprocessAllocator(
     int id,
@@ -29,6 +36,9 @@ void SubprocessMetricsProvider::RegisterSubprocessAllocator(
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(!allocators_by_id_.Lookup(id));
 
+  if (!allocator)
+    return;
+
   // Map is "MapOwnPointer" so transfer ownership to it.
   allocators_by_id_.AddWithID(allocator.release(), id);
 }
@@ -54,6 +64,26 @@ void SubprocessMetricsProvider::DeregisterSubprocessAllocator(int id) {
     allocators_for_exited_processes_.push_back(std::move(allocator));
 }
 
+// static
+std::unique_ptr<base::PersistentHistogramAllocator>
+SubprocessMetricsProvider::GetSubprocessHistogramAllocatorOnIOThread(int id) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::IO);
+
+  // The host may already be gone if the process exited right after launch.
+  content::BrowserChildProcessHost* host =
+      content::BrowserChildProcessHost::FromID(id);
+  if (!host)
+    return nullptr;
+
+  std::unique_ptr<base::SharedPersistentMemoryAllocator> allocator =
+      host->TakeMetricsAllocator();
+  if (!allocator)
+    return nullptr;
+
+  return WrapUnique(new base::PersistentHistogramAllocator(
+      std::move(allocator)));
+}
+
 void SubprocessMetricsProvider::OnDidCreateMetricsLog() {
   DCHECK(thread_checker_.CalledOnValidThread());
 
@@ -122,6 +152,29 @@ void SubprocessMetricsProvider::RecordHistogramSnapshots(
   allocators_to_release_.swap(allocators_for_exited_processes_);
 }
 
+void SubprocessMetricsProvider::BrowserChildProcessLaunchedAndConnected(
+    const content::ChildProcessData& data) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  // Browser child process hosts live on the IO thread, so the allocator is
+  // extracted there. A disconnection of the same process is posted to this
+  // thread after the host is destroyed, so it can't overtake the reply.
+  content::BrowserThread::PostTaskAndReplyWithResult(
+      content::BrowserThread::IO, FROM_HERE,
+      base::Bind(&GetSubprocessHistogramAllocatorOnIOThread, data.id),
+      base::Bind(&SubprocessMetricsProvider::RegisterSubprocessAllocator,
+                 weak_ptr_factory_.GetWeakPtr(), data.id));
+}
+
+void SubprocessMetricsProvider::BrowserChildProcessHostDisconnected(
+    const content::ChildProcessData& data) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  // This is also called after a child process crashes or is killed, so its
+  // allocator is reported one last time and then released like any other.
+  DeregisterSubprocessAllocator(data.id);
+}
+
 void SubprocessMetricsProvider::Observe(
     int type,
     const content::NotificationSource& source,
@@ -10,9 +10,11 @@
 
 #include "base/gtest_prod_util.h"
 #include "base/id_map.h"
+#include "base/memory/weak_ptr.h"
 #include "base/scoped_observer.h"
 #include "base/threading/thread_checker.h"
 #include "components/metrics/metrics_provider.h"
+#include "content/public/browser/browser_child_process_observer.h"
 #include "content/public/browser/notification_observer.h"
 #include "content/public/browser/notification_registrar.h"
 #include "content/public/browser/render_process_host_observer.h"
@@ -25,6 +27,7 @@ class SharedPersistentMemoryAllocator;
 // SubprocessMetricsProvider gathers and logs histograms stored in shared
 // memory segments between processes.
 class SubprocessMetricsProvider : public metrics::MetricsProvider,
+                                  public content::BrowserChildProcessObserver,
                                   public content::NotificationObserver,
                                   public content::RenderProcessHostObserver {
  public:
@@ -36,6 +39,7 @@ class SubprocessMetricsProvider : public metrics::MetricsProvider,
 
   // Indicates subprocess to be monitored with unique id for later reference.
   // Metrics reporting will read histograms from it and upload them to UMA.
+  // A null |allocator|, for a subprocess that has none, is ignored.
   void RegisterSubprocessAllocator(
       int id,
       std::unique_ptr<base::PersistentHistogramAllocator> allocator);
@@ -50,6 +54,11 @@ class SubprocessMetricsProvider : public metrics::MetricsProvider,
       int id,
       base::PersistentHistogramAllocator* allocator);
 
+  // Extracts the allocator of the browser child process with unique |id|, if
+  // it has one. Must be called on the IO thread.
+  static std::unique_ptr<base::PersistentHistogramAllocator>
+  GetSubprocessHistogramAllocatorOnIOThread(int id);
+
   // metrics::MetricsProvider:
   void OnDidCreateMetricsLog() override;
   void OnRecordingEnabled() override;
@@ -57,6 +66,12 @@ class SubprocessMetricsProvider : public metrics::MetricsProvider,
   void RecordHistogramSnapshots(
       base::HistogramSnapshotManager* snapshot_manager) override;
 
+  // content::BrowserChildProcessObserver:
+  void BrowserChildProcessLaunchedAndConnected(
+      const content::ChildProcessData& data) override;
+  void BrowserChildProcessHostDisconnected(
+      const content::ChildProcessData& data) override;
+
   // content::NotificationObserver:
   void Observe(int type,
                const content::NotificationSource& source,
@@ -94,6 +109,8 @@ class SubprocessMetricsProvider : public metrics::MetricsProvider,
   // live past the death of the subprocess if it is not.
   bool metrics_recording_enabled_ = false;
 
+  base::WeakPtrFactory<SubprocessMetricsProvider> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(SubprocessMetricsProvider);
 };
 
@@ -12,6 +12,7 @@
 #include "base/metrics/histogram_snapshot_manager.h"
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/persistent_memory_allocator.h"
+#include "content/public/test/test_browser_thread_bundle.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace {
@@ -115,6 +116,8 @@ class SubprocessMetricsProviderTest : public testing::Test {
   }
 
  private:
+  // The provider observes browser child processes, which requires a UI thread.
+  content::TestBrowserThreadBundle thread_bundle_;
   SubprocessMetricsProvider provider_;
 
   DISALLOW_COPY_AND_ASSIGN(SubprocessMetricsProviderTest);
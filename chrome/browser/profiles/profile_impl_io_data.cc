@@ -64,6 +64,7 @@
 #include "net/http/http_cache.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_server_properties_manager.h"
+#include "net/sdch/sdch_dictionary_store.h"
 #include "net/sdch/sdch_owner.h"
 #include "net/ssl/channel_id_service.h"
 #include "net/url_request/url_request_intercepting_job_factory.h"
@@ -557,6 +558,12 @@ void ProfileImplIOData::InitializeInternal(
   sdch_manager_.reset(new net::SdchManager);
   sdch_policy_.reset(new net::SdchOwner(sdch_manager_.get(), main_context));
   main_context->set_sdch_manager(sdch_manager_.get());
+  net::HttpCache* main_cache = main_http_factory_->GetCache();
+  if (main_cache) {
+    sdch_policy_->EnableDictionaryStore(
+        std::unique_ptr<net::SdchDictionaryStore>(
+            new net::SdchDictionaryStore(main_cache)));
+  }
   sdch_policy_->EnablePersistentStorage(
       std::unique_ptr<net::SdchOwner::PrefStorage>(
           new chrome_browser_net::SdchOwnerPrefStorage(
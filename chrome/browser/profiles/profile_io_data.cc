@@ -15,6 +15,7 @@
 #include "base/command_line.h"
 #include "base/compiler_specific.h"
 #include "base/debug/alias.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
@@ -52,6 +53,7 @@
 #include "chrome/browser/ssl/chrome_expect_ct_reporter.h"
 #include "chrome/browser/ui/search/new_tab_page_interceptor_service.h"
 #include "chrome/browser/ui/search/new_tab_page_interceptor_service_factory.h"
+#include "chrome/common/chrome_features.h"
 #include "chrome/common/chrome_paths.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/features.h"
@@ -1022,6 +1024,10 @@ void ProfileIOData::Init(
 
   main_request_context_->set_enable_brotli(io_thread_globals->enable_brotli);
 
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  if (base::FeatureList::IsEnabled(features::kOffThreadContentDecoding))
+    main_request_context_->set_filter_worker_pool(pool);
+
   std::unique_ptr<ChromeNetworkDelegate> network_delegate(
       new ChromeNetworkDelegate(
 #if defined(ENABLE_EXTENSIONS)
@@ -1059,7 +1065,6 @@ void ProfileIOData::Init(
       io_thread->WpadQuickCheckEnabled(),
       io_thread->PacHttpsUrlStrippingEnabled());
   transport_security_state_.reset(new net::TransportSecurityState());
-  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
   transport_security_persister_.reset(
       new net::TransportSecurityPersister(
           transport_security_state_.get(),
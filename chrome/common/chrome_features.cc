@@ -52,6 +52,11 @@ const base::Feature kMaterialDesignHistoryFeature {
   "MaterialDesignHistory", base::FEATURE_DISABLED_BY_DEFAULT
 };
 
+// Decodes gzip, deflate and brotli response bodies in the blocking pool
+// rather than on the IO thread.
+const base::Feature kOffThreadContentDecoding{
+    "OffThreadContentDecoding", base::FEATURE_DISABLED_BY_DEFAULT};
+
 #if defined(OS_CHROMEOS)
 // Runtime flag that indicates whether this leak detector should be enabled in
 // the current instance of Chrome.
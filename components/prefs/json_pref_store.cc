@@ -11,10 +11,13 @@
 
 #include "base/bind.h"
 #include "base/callback.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_reader.h"
 #include "base/json/json_string_value_serializer.h"
+#include "base/json/json_writer.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/metrics/histogram.h"
@@ -36,14 +39,18 @@ struct JsonPrefStore::ReadResult {
   std::unique_ptr<base::Value> value;
   PrefReadError error;
   bool no_dir;
+  int64_t file_size;
+  int64_t journal_size;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(ReadResult);
 };
 
 JsonPrefStore::ReadResult::ReadResult()
-    : error(PersistentPrefStore::PREF_READ_ERROR_NONE), no_dir(false) {
-}
+    : error(PersistentPrefStore::PREF_READ_ERROR_NONE),
+      no_dir(false),
+      file_size(0),
+      journal_size(0) {}
 
 JsonPrefStore::ReadResult::~ReadResult() {
 }
@@ -52,6 +59,12 @@ namespace {
 
 // Some extensions we'll tack on to copies of the Preferences files.
 const base::FilePath::CharType kBadExtension[] = FILE_PATH_LITERAL("bad");
+const base::FilePath::CharType kJournalExtension[] =
+    FILE_PATH_LITERAL("journal");
+
+// The journal is folded into the file once it is as large as the file, or
+// this large if the file is smaller.
+const int64_t kMinJournalSizeToCompact = 64 * 1024;
 
 PersistentPrefStore::PrefReadError HandleReadErrors(
     const base::Value* value,
@@ -109,9 +122,113 @@ void RecordJsonDataSizeHistogram(const base::FilePath& path, size_t size) {
   histogram->Add(static_cast<int>(size) / 1024);
 }
 
+// Appends the journal record for |key| to |records|. Each record is a JSON
+// list on a line of its own: the key and its new value, or only the key if it
+// was removed.
+void AppendJournalRecord(const std::string& key,
+                         const base::Value* value,
+                         std::string* records) {
+  std::string key_json;
+  std::string value_json;
+  if (!base::JSONWriter::Write(base::StringValue(key), &key_json) ||
+      (value && !base::JSONWriter::Write(*value, &value_json))) {
+    NOTREACHED() << "Cannot journal " << key;
+    return;
+  }
+
+  records->push_back('[');
+  records->append(key_json);
+  if (value) {
+    records->push_back(',');
+    records->append(value_json);
+  }
+  records->append("]\n");
+}
+
+// Applies the records of the journal at |journal_path| to |prefs|, and returns
+// the size of the journal. A record that was only partly written when the
+// browser went down, and anything after it, is cut off the journal.
+int64_t ReplayJournal(const base::FilePath& journal_path,
+                      base::DictionaryValue* prefs) {
+  std::string journal;
+  if (!base::ReadFileToString(journal_path, &journal))
+    return 0;
+
+  size_t replayed = 0;
+  while (replayed < journal.size()) {
+    size_t end = journal.find('\n', replayed);
+    if (end == std::string::npos)
+      break;
+
+    std::unique_ptr<base::Value> record = base::JSONReader::Read(
+        base::StringPiece(journal).substr(replayed, end - replayed),
+        base::JSON_DETACHABLE_CHILDREN);
+    base::ListValue* list = nullptr;
+    std::string key;
+    if (!record || !record->GetAsList(&list) || !list->GetString(0, &key))
+      break;
+    std::unique_ptr<base::Value> value;
+    if (list->GetSize() == 2 && list->Remove(1, &value))
+      prefs->Set(key, std::move(value));
+    else if (list->GetSize() == 1)
+      prefs->RemovePath(key, nullptr);
+    else
+      break;
+
+    replayed = end + 1;
+  }
+
+  if (replayed < journal.size()) {
+    LOG(WARNING) << "Dropping " << journal.size() - replayed
+                 << " bytes of incomplete records from "
+                 << journal_path.value();
+    base::File file(journal_path,
+                    base::File::FLAG_OPEN | base::File::FLAG_WRITE);
+    if (!file.IsValid() || !file.SetLength(replayed))
+      base::DeleteFile(journal_path, false);
+  }
+  return replayed;
+}
+
+bool AppendToJournal(const base::FilePath& journal_path,
+                     const std::string& records) {
+  base::File file(journal_path,
+                  base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND);
+  if (!file.IsValid())
+    return false;
+  int size = static_cast<int>(records.size());
+  return file.WriteAtCurrentPos(records.data(), size) == size && file.Flush();
+}
+
+// Folds the journal at |journal_path| into the file at |path| and deletes it.
+// Returns the new size of the file, or -1 on failure.
+int64_t CompactJournal(const base::FilePath& path,
+                       const base::FilePath& journal_path) {
+  std::unique_ptr<base::DictionaryValue> prefs(new base::DictionaryValue);
+  if (base::PathExists(path)) {
+    JSONFileValueDeserializer deserializer(path);
+    prefs = base::DictionaryValue::From(deserializer.Deserialize(nullptr,
+                                                                 nullptr));
+    if (!prefs)
+      return -1;
+  }
+  ReplayJournal(journal_path, prefs.get());
+
+  std::string data;
+  JSONStringValueSerializer serializer(&data);
+  serializer.set_pretty_print(false);
+  if (!serializer.Serialize(*prefs) ||
+      !base::ImportantFileWriter::WriteFileAtomically(path, data)) {
+    return -1;
+  }
+  base::DeleteFile(journal_path, false);
+  return data.size();
+}
+
 std::unique_ptr<JsonPrefStore::ReadResult> ReadPrefsFromDisk(
     const base::FilePath& path,
-    const base::FilePath& alternate_path) {
+    const base::FilePath& alternate_path,
+    const base::FilePath& journal_path) {
   if (!base::PathExists(path) && !alternate_path.empty() &&
       base::PathExists(alternate_path)) {
     base::Move(alternate_path, path);
@@ -127,8 +244,38 @@ std::unique_ptr<JsonPrefStore::ReadResult> ReadPrefsFromDisk(
       HandleReadErrors(read_result->value.get(), path, error_code, error_msg);
   read_result->no_dir = !base::PathExists(path.DirName());
 
-  if (read_result->error == PersistentPrefStore::PREF_READ_ERROR_NONE)
+  if (read_result->error == PersistentPrefStore::PREF_READ_ERROR_NONE) {
+    read_result->file_size = deserializer.get_last_read_size();
     RecordJsonDataSizeHistogram(path, deserializer.get_last_read_size());
+  }
+
+  if (!journal_path.empty()) {
+    switch (read_result->error) {
+      case PersistentPrefStore::PREF_READ_ERROR_NONE:
+        read_result->journal_size = ReplayJournal(
+            journal_path,
+            static_cast<base::DictionaryValue*>(read_result->value.get()));
+        break;
+      case PersistentPrefStore::PREF_READ_ERROR_NO_FILE:
+        // The prefs may not have been compacted into a file yet.
+        if (base::PathExists(journal_path)) {
+          std::unique_ptr<base::DictionaryValue> prefs(
+              new base::DictionaryValue);
+          read_result->journal_size = ReplayJournal(journal_path, prefs.get());
+          read_result->value = std::move(prefs);
+          read_result->error = PersistentPrefStore::PREF_READ_ERROR_NONE;
+        }
+        break;
+      case PersistentPrefStore::PREF_READ_ERROR_JSON_PARSE:
+      case PersistentPrefStore::PREF_READ_ERROR_JSON_REPEAT:
+        // The file was moved aside, and the journal only makes sense on top
+        // of it.
+        base::DeleteFile(journal_path, false);
+        break;
+      default:
+        break;
+    }
+  }
 
   return read_result;
 }
@@ -171,6 +318,8 @@ JsonPrefStore::JsonPrefStore(
       filtering_in_progress_(false),
       pending_lossy_write_(false),
       read_error_(PREF_READ_ERROR_NONE),
+      file_size_(0),
+      journal_size_(0),
       write_count_histogram_(writer_.commit_interval(), path_) {
   DCHECK(!path_.empty());
 }
@@ -243,7 +392,7 @@ void JsonPrefStore::SetValueSilently(const std::string& key,
   prefs_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
     prefs_->Set(key, std::move(value));
-    ScheduleWrite(flags);
+    ScheduleWrite(key, flags);
   }
 }
 
@@ -259,7 +408,7 @@ void JsonPrefStore::RemoveValueSilently(const std::string& key,
   DCHECK(CalledOnValidThread());
 
   prefs_->RemovePath(key, nullptr);
-  ScheduleWrite(flags);
+  ScheduleWrite(key, flags);
 }
 
 bool JsonPrefStore::ReadOnly() const {
@@ -277,7 +426,7 @@ PersistentPrefStore::PrefReadError JsonPrefStore::GetReadError() const {
 PersistentPrefStore::PrefReadError JsonPrefStore::ReadPrefs() {
   DCHECK(CalledOnValidThread());
 
-  OnFileRead(ReadPrefsFromDisk(path_, alternate_path_));
+  OnFileRead(ReadPrefsFromDisk(path_, alternate_path_, journal_path_));
   return filtering_in_progress_ ? PREF_READ_ERROR_ASYNCHRONOUS_TASK_INCOMPLETE
                                 : read_error_;
 }
@@ -292,7 +441,7 @@ void JsonPrefStore::ReadPrefsAsync(ReadErrorDelegate* error_delegate) {
   base::PostTaskAndReplyWithResult(
       sequenced_task_runner_.get(),
       FROM_HERE,
-      base::Bind(&ReadPrefsFromDisk, path_, alternate_path_),
+      base::Bind(&ReadPrefsFromDisk, path_, alternate_path_, journal_path_),
       base::Bind(&JsonPrefStore::OnFileRead, AsWeakPtr()));
 }
 
@@ -303,13 +452,23 @@ void JsonPrefStore::CommitPendingWrite() {
   // they get flushed when this function is called.
   SchedulePendingLossyWrites();
 
+  if (journal_timer_.IsRunning() && !read_only_)
+    WriteJournal();
+
   if (writer_.HasPendingWrite() && !read_only_)
     writer_.DoScheduledWrite();
 }
 
 void JsonPrefStore::SchedulePendingLossyWrites() {
-  if (pending_lossy_write_)
+  if (!pending_lossy_write_)
+    return;
+
+  if (journal_path_.empty()) {
     writer_.ScheduleWrite(this);
+  } else if (!journal_timer_.IsRunning()) {
+    journal_timer_.Start(FROM_HERE, writer_.commit_interval(), this,
+                         &JsonPrefStore::WriteJournal);
+  }
 }
 
 void JsonPrefStore::ReportValueChanged(const std::string& key, uint32_t flags) {
@@ -320,20 +479,33 @@ void JsonPrefStore::ReportValueChanged(const std::string& key, uint32_t flags) {
 
   FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
 
-  ScheduleWrite(flags);
+  ScheduleWrite(key, flags);
 }
 
 void JsonPrefStore::RegisterOnNextSuccessfulWriteCallback(
     const base::Closure& on_next_successful_write) {
   DCHECK(CalledOnValidThread());
 
-  writer_.RegisterOnNextSuccessfulWriteCallback(on_next_successful_write);
+  if (journal_path_.empty()) {
+    writer_.RegisterOnNextSuccessfulWriteCallback(on_next_successful_write);
+    return;
+  }
+  DCHECK(on_next_successful_journal_write_.is_null());
+  on_next_successful_journal_write_ = on_next_successful_write;
 }
 
 void JsonPrefStore::ClearMutableValues() {
   NOTIMPLEMENTED();
 }
 
+void JsonPrefStore::EnableJournal() {
+  DCHECK(CalledOnValidThread());
+  DCHECK(!initialized_);
+  DCHECK(!pref_filter_);
+
+  journal_path_ = path_.AddExtension(kJournalExtension);
+}
+
 void JsonPrefStore::OnFileRead(std::unique_ptr<ReadResult> read_result) {
   DCHECK(CalledOnValidThread());
 
@@ -343,6 +515,8 @@ void JsonPrefStore::OnFileRead(std::unique_ptr<ReadResult> read_result) {
       new base::DictionaryValue);
 
   read_error_ = read_result->error;
+  file_size_ = read_result->file_size;
+  journal_size_ = read_result->journal_size;
 
   bool initialization_successful = !read_result->no_dir;
 
@@ -431,8 +605,10 @@ void JsonPrefStore::FinalizeFileRead(
 
   initialized_ = true;
 
-  if (schedule_write)
-    ScheduleWrite(DEFAULT_PREF_WRITE_FLAGS);
+  if (schedule_write) {
+    DCHECK(journal_path_.empty());
+    writer_.ScheduleWrite(this);
+  }
 
   if (error_delegate_ && read_error_ != PREF_READ_ERROR_NONE)
     error_delegate_->OnError(read_error_);
@@ -444,14 +620,83 @@ void JsonPrefStore::FinalizeFileRead(
   return;
 }
 
-void JsonPrefStore::ScheduleWrite(uint32_t flags) {
+void JsonPrefStore::ScheduleWrite(const std::string& key, uint32_t flags) {
   if (read_only_)
     return;
 
-  if (flags & LOSSY_PREF_WRITE_FLAG)
+  if (!journal_path_.empty())
+    journal_pending_keys_.insert(key);
+
+  if (flags & LOSSY_PREF_WRITE_FLAG) {
     pending_lossy_write_ = true;
-  else
+  } else if (journal_path_.empty()) {
     writer_.ScheduleWrite(this);
+  } else if (!journal_timer_.IsRunning()) {
+    journal_timer_.Start(FROM_HERE, writer_.commit_interval(), this,
+                         &JsonPrefStore::WriteJournal);
+  }
+}
+
+void JsonPrefStore::WriteJournal() {
+  DCHECK(CalledOnValidThread());
+  DCHECK(!journal_path_.empty());
+
+  journal_timer_.Stop();
+  pending_lossy_write_ = false;
+
+  write_count_histogram_.RecordWriteOccured();
+
+  // Record the values the prefs have now; the order of the records does not
+  // matter, since each of them is the latest value of its key.
+  std::string records;
+  for (const std::string& key : journal_pending_keys_) {
+    const base::Value* value = nullptr;
+    AppendJournalRecord(key, GetValue(key, &value) ? value : nullptr,
+                        &records);
+  }
+  journal_pending_keys_.clear();
+  if (records.empty())
+    return;
+
+  if (on_next_successful_journal_write_.is_null()) {
+    sequenced_task_runner_->PostTask(
+        FROM_HERE, base::Bind(base::IgnoreResult(&AppendToJournal),
+                              journal_path_, records));
+  } else {
+    base::PostTaskAndReplyWithResult(
+        sequenced_task_runner_.get(), FROM_HERE,
+        base::Bind(&AppendToJournal, journal_path_, records),
+        base::Bind(&JsonPrefStore::ForwardSuccessfulJournalWrite,
+                   AsWeakPtr()));
+  }
+
+  journal_size_ += records.size();
+  if (journal_size_ < std::max(kMinJournalSizeToCompact, file_size_))
+    return;
+
+  // Writes to the journal posted from now on land in a new journal, since the
+  // task runner is sequenced.
+  journal_size_ = 0;
+  base::PostTaskAndReplyWithResult(
+      sequenced_task_runner_.get(), FROM_HERE,
+      base::Bind(&CompactJournal, path_, journal_path_),
+      base::Bind(&JsonPrefStore::OnJournalCompacted, AsWeakPtr()));
+}
+
+void JsonPrefStore::OnJournalCompacted(int64_t file_size) {
+  DCHECK(CalledOnValidThread());
+
+  if (file_size >= 0)
+    file_size_ = file_size;
+}
+
+void JsonPrefStore::ForwardSuccessfulJournalWrite(bool result) {
+  DCHECK(CalledOnValidThread());
+
+  if (result && !on_next_successful_journal_write_.is_null()) {
+    on_next_successful_journal_write_.Run();
+    on_next_successful_journal_write_.Reset();
+  }
 }
 
 // NOTE: This value should NOT be changed without renaming the histogram
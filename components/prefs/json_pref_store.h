@@ -11,7 +11,7 @@
 #include <set>
 #include <string>
 
-#include "base/callback_forward.h"
+#include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/files/file_path.h"
 #include "base/files/important_file_writer.h"
@@ -20,6 +20,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/timer/timer.h"
 #include "components/prefs/base_prefs_export.h"
 #include "components/prefs/persistent_pref_store.h"
 
@@ -30,6 +31,7 @@ class Clock;
 class DictionaryValue;
 class FilePath;
 class HistogramBase;
+class JsonPrefStoreJournalTest;
 class JsonPrefStoreLossyWriteTest;
 class SequencedTaskRunner;
 class SequencedWorkerPool;
@@ -113,6 +115,14 @@ class COMPONENTS_PREFS_EXPORT JsonPrefStore
 
   void ClearMutableValues() override;
 
+  // Switches to journaled writes: instead of rewriting the whole file on every
+  // commit, only the prefs that changed are appended to a journal next to the
+  // file, which is folded back into the file in the background once it has
+  // grown as large as the file. Reading the prefs replays the journal. Must be
+  // called before the prefs are read, and cannot be used with a PrefFilter,
+  // which expects to see all the prefs on every write.
+  void EnableJournal();
+
  private:
   // Represents a histogram for recording the number of writes to the pref file
   // that occur every kHistogramWriteReportIntervalInMins minutes.
@@ -171,6 +181,7 @@ class COMPONENTS_PREFS_EXPORT JsonPrefStore
   FRIEND_TEST_ALL_PREFIXES(base::JsonPrefStoreTest,
                            WriteCountHistogramTestPeriodWithGaps);
   friend class base::JsonPrefStoreLossyWriteTest;
+  friend class base::JsonPrefStoreJournalTest;
 
   ~JsonPrefStore() override;
 
@@ -196,9 +207,20 @@ class COMPONENTS_PREFS_EXPORT JsonPrefStore
                         std::unique_ptr<base::DictionaryValue> prefs,
                         bool schedule_write);
 
-  // Schedule a write with the file writer as long as |flags| doesn't contain
-  // WriteablePrefStore::LOSSY_PREF_WRITE_FLAG.
-  void ScheduleWrite(uint32_t flags);
+  // Schedule a write with the file writer, or of |key| to the journal, as long
+  // as |flags| doesn't contain WriteablePrefStore::LOSSY_PREF_WRITE_FLAG.
+  void ScheduleWrite(const std::string& key, uint32_t flags);
+
+  // Appends the prefs in |journal_pending_keys_| to the journal, and starts
+  // folding it into the file if it has grown large enough.
+  void WriteJournal();
+
+  // Called after the journal was folded into the file, which is now
+  // |file_size| bytes, or -1 if that failed.
+  void OnJournalCompacted(int64_t file_size);
+
+  // Runs |on_next_successful_journal_write_| if |result| is true.
+  void ForwardSuccessfulJournalWrite(bool result);
 
   const base::FilePath path_;
   const base::FilePath alternate_path_;
@@ -223,6 +245,20 @@ class COMPONENTS_PREFS_EXPORT JsonPrefStore
 
   std::set<std::string> keys_need_empty_value_;
 
+  // Set by EnableJournal(), empty otherwise.
+  base::FilePath journal_path_;
+
+  // The prefs that changed since the journal was last written.
+  std::set<std::string> journal_pending_keys_;
+  base::OneShotTimer journal_timer_;
+
+  // The size of the file when it was last read or written, and of the journal
+  // written since.
+  int64_t file_size_;
+  int64_t journal_size_;
+
+  base::Closure on_next_successful_journal_write_;
+
   WriteCountHistogram write_count_histogram_;
 
   DISALLOW_COPY_AND_ASSIGN(JsonPrefStore);
@@ -0,0 +1,134 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures what it costs JsonPrefStore to persist a single pref change in a
+// large Preferences file: the time CommitPendingWrite() takes on the calling
+// thread, and the number of bytes written to disk per change, with and without
+// the journal.
+
+#include "components/prefs/json_pref_store.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_writer.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "components/prefs/pref_filter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace {
+
+const int kChanges = 200;
+
+// Writes a Preferences file of a few MB to |path|: a few thousand small prefs,
+// and the per-site content settings that make up most of a real one.
+void WritePreferences(const FilePath& path) {
+  DictionaryValue prefs;
+  for (int i = 0; i < 2000; i++)
+    prefs.SetInteger(StringPrintf("section%d.pref%d", i % 17, i), i);
+  for (int site = 0; site < 20000; site++) {
+    std::unique_ptr<DictionaryValue> setting(new DictionaryValue);
+    setting->SetString("last_modified", StringPrintf("1316%09d", site));
+    setting->SetInteger("setting", site % 3);
+    prefs.Set(StringPrintf("profile.content_settings.exceptions.cookies."
+                           "https://[*.]site%d.example:443,*",
+                           site),
+              std::move(setting));
+  }
+  std::string json;
+  ASSERT_TRUE(JSONWriter::Write(prefs, &json));
+  ASSERT_EQ(static_cast<int>(json.size()),
+            WriteFile(path, json.data(), json.size()));
+}
+
+int64_t GetFileSizeOrZero(const FilePath& path) {
+  int64_t size = 0;
+  if (!GetFileSize(path, &size))
+    return 0;
+  return size;
+}
+
+class JsonPrefStorePerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().AppendASCII("Preferences");
+    journal_path_ = path_.AddExtension(FILE_PATH_LITERAL("journal"));
+    WritePreferences(path_);
+  }
+
+  // Changes one pref |kChanges| times, committing each change, and reports
+  // the results under |trace|.
+  void ChangePrefs(bool use_journal, const std::string& trace) {
+    scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+        path_, message_loop_.task_runner(), std::unique_ptr<PrefFilter>());
+    if (use_journal)
+      pref_store->EnableJournal();
+    ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+              pref_store->ReadPrefs());
+
+    TimeDelta commit_time;
+    int64_t bytes_written = 0;
+    int64_t journal_size = GetFileSizeOrZero(journal_path_);
+    for (int i = 0; i < kChanges; i++) {
+      pref_store->SetValue("session.restore_count",
+                           WrapUnique(new FundamentalValue(i)),
+                           WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+      TimeTicks start = TimeTicks::Now();
+      pref_store->CommitPendingWrite();
+      commit_time += TimeTicks::Now() - start;
+      RunLoop().RunUntilIdle();
+
+      if (!use_journal) {
+        bytes_written += GetFileSizeOrZero(path_);
+        continue;
+      }
+      // The journal either grew by a record, or was compacted into the file
+      // and removed.
+      int64_t new_journal_size = GetFileSizeOrZero(journal_path_);
+      if (new_journal_size >= journal_size)
+        bytes_written += new_journal_size - journal_size;
+      else
+        bytes_written += GetFileSizeOrZero(path_) + new_journal_size;
+      journal_size = new_journal_size;
+    }
+
+    perf_test::PrintResult(
+        "commit_time", "", trace,
+        commit_time.InMicroseconds() / static_cast<double>(kChanges), "us",
+        true);
+    perf_test::PrintResult("bytes_written_per_change", "", trace,
+                           static_cast<size_t>(bytes_written / kChanges),
+                           "bytes", true);
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath path_;
+  FilePath journal_path_;
+  MessageLoop message_loop_;
+};
+
+TEST_F(JsonPrefStorePerfTest, CommitFullFile) {
+  ChangePrefs(false, "full_file");
+}
+
+TEST_F(JsonPrefStorePerfTest, CommitJournal) {
+  ChangePrefs(true, "journal");
+}
+
+}  // namespace
+}  // namespace base
@@ -967,4 +967,160 @@ TEST_F(JsonPrefStoreLossyWriteTest, ScheduleLossyWrite) {
   ASSERT_EQ("{\"lossy\":\"lossy\"}", GetTestFileContents());
 }
 
+class JsonPrefStoreJournalTest : public JsonPrefStoreTest {
+ protected:
+  void SetUp() override {
+    JsonPrefStoreTest::SetUp();
+    test_file_ = temp_dir_.path().AppendASCII("test.json");
+    journal_file_ = temp_dir_.path().AppendASCII("test.json.journal");
+  }
+
+  scoped_refptr<JsonPrefStore> CreatePrefStore() {
+    scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+        test_file_, message_loop_.task_runner(), std::unique_ptr<PrefFilter>());
+    pref_store->EnableJournal();
+    return pref_store;
+  }
+
+  bool HasPendingJournalWrite(JsonPrefStore* pref_store) {
+    return pref_store->journal_timer_.IsRunning();
+  }
+
+  std::string GetFileContents(const FilePath& path) {
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(path, &contents));
+    return contents;
+  }
+
+  void WriteFileContents(const FilePath& path, const std::string& contents) {
+    ASSERT_EQ(static_cast<int>(contents.size()),
+              base::WriteFile(path, contents.data(), contents.size()));
+  }
+
+  FilePath test_file_;
+  FilePath journal_file_;
+};
+
+TEST_F(JsonPrefStoreJournalTest, WritesChangedPrefsOnly) {
+  WriteFileContents(test_file_, kReadJson);
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+
+  pref_store->SetValue(kHomePage,
+                       base::WrapUnique(new StringValue("http://example.com")),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->RemoveValue("tabs.max_tabs",
+                          WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  EXPECT_TRUE(HasPendingJournalWrite(pref_store.get()));
+  pref_store->CommitPendingWrite();
+  EXPECT_FALSE(HasPendingJournalWrite(pref_store.get()));
+  RunLoop().RunUntilIdle();
+
+  // The file is left alone, and the changes are appended to the journal.
+  EXPECT_EQ(kReadJson, GetFileContents(test_file_));
+  EXPECT_EQ(
+      "[\"homepage\",\"http://example.com\"]\n"
+      "[\"tabs.max_tabs\"]\n",
+      GetFileContents(journal_file_));
+
+  // Reading the prefs replays the journal.
+  pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+  const Value* value = nullptr;
+  ASSERT_TRUE(pref_store->GetValue(kHomePage, &value));
+  EXPECT_TRUE(StringValue("http://example.com").Equals(value));
+  EXPECT_FALSE(pref_store->GetValue("tabs.max_tabs", &value));
+  ASSERT_TRUE(pref_store->GetValue("tabs.new_windows_in_tabs", &value));
+  EXPECT_TRUE(FundamentalValue(true).Equals(value));
+}
+
+TEST_F(JsonPrefStoreJournalTest, ReadsJournalWithoutFile) {
+  WriteFileContents(journal_file_,
+                    "[\"a.b\",1]\n"
+                    "[\"c\",\"d\"]\n"
+                    "[\"c\"]\n");
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+
+  const Value* value = nullptr;
+  ASSERT_TRUE(pref_store->GetValue("a.b", &value));
+  EXPECT_TRUE(FundamentalValue(1).Equals(value));
+  EXPECT_FALSE(pref_store->GetValue("c", &value));
+}
+
+TEST_F(JsonPrefStoreJournalTest, DropsIncompleteRecords) {
+  WriteFileContents(test_file_, "{}");
+  WriteFileContents(journal_file_,
+                    "[\"a\",1]\n"
+                    "[\"b\",");
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+
+  const Value* value = nullptr;
+  EXPECT_TRUE(pref_store->GetValue("a", &value));
+  EXPECT_FALSE(pref_store->GetValue("b", &value));
+  EXPECT_EQ("[\"a\",1]\n", GetFileContents(journal_file_));
+
+  // New records follow the complete ones.
+  pref_store->SetValue("c", base::WrapUnique(new FundamentalValue(true)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(
+      "[\"a\",1]\n"
+      "[\"c\",true]\n",
+      GetFileContents(journal_file_));
+}
+
+TEST_F(JsonPrefStoreJournalTest, CompactsLargeJournal) {
+  WriteFileContents(test_file_, kReadJson);
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+
+  const std::string large_value(100 * 1024, 'x');
+  pref_store->SetValue("large", base::WrapUnique(new StringValue(large_value)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+
+  // The journal was folded into the file.
+  EXPECT_FALSE(PathExists(journal_file_));
+  pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE, pref_store->ReadPrefs());
+  const Value* value = nullptr;
+  ASSERT_TRUE(pref_store->GetValue("large", &value));
+  EXPECT_TRUE(StringValue(large_value).Equals(value));
+  EXPECT_TRUE(pref_store->GetValue(kHomePage, &value));
+}
+
+TEST_F(JsonPrefStoreJournalTest, LossyWrites) {
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NO_FILE,
+            pref_store->ReadPrefs());
+
+  pref_store->SetValue("lossy",
+                       base::WrapUnique(new base::StringValue("lossy")),
+                       WriteablePrefStore::LOSSY_PREF_WRITE_FLAG);
+  EXPECT_FALSE(HasPendingJournalWrite(pref_store.get()));
+
+  pref_store->SetValue("normal",
+                       base::WrapUnique(new base::StringValue("normal")),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  EXPECT_TRUE(HasPendingJournalWrite(pref_store.get()));
+
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(
+      "[\"lossy\",\"lossy\"]\n"
+      "[\"normal\",\"normal\"]\n",
+      GetFileContents(journal_file_));
+
+  pref_store->SetValue("lossy",
+                       base::WrapUnique(new base::StringValue("changed")),
+                       WriteablePrefStore::LOSSY_PREF_WRITE_FLAG);
+  EXPECT_FALSE(HasPendingJournalWrite(pref_store.get()));
+  pref_store->SchedulePendingLossyWrites();
+  EXPECT_TRUE(HasPendingJournalWrite(pref_store.get()));
+}
+
 }  // namespace base
@@ -13,8 +13,12 @@
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/memory/shared_memory.h"
+#include "base/memory/shared_memory_handle.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram.h"
+#include "base/metrics/persistent_histogram_allocator.h"
+#include "base/metrics/persistent_memory_allocator.h"
 #include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "base/synchronization/waitable_event.h"
@@ -266,6 +270,12 @@ ServiceRegistry* BrowserChildProcessHostImpl::GetServiceRegistry() {
   return delegate_->GetServiceRegistry();
 }
 
+std::unique_ptr<base::SharedPersistentMemoryAllocator>
+BrowserChildProcessHostImpl::TakeMetricsAllocator() {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  return std::move(metrics_allocator_);
+}
+
 void BrowserChildProcessHostImpl::ForceShutdown() {
   DCHECK_CURRENTLY_ON(BrowserThread::IO);
   g_child_process_list.Get().remove(this);
@@ -444,6 +454,9 @@ void BrowserChildProcessHostImpl::OnProcessLaunched() {
   data_.handle = process.Handle();
   delegate_->OnProcessLaunched();
 
+  // Share histograms between the child process and this process.
+  CreateMetricsAllocator();
+
   if (is_channel_connected_) {
     BrowserThread::PostTask(BrowserThread::UI, FROM_HERE,
                             base::Bind(&NotifyProcessLaunchedAndConnected,
@@ -457,6 +470,48 @@ bool BrowserChildProcessHostImpl::IsProcessLaunched() const {
   return child_process_.get() && child_process_->GetProcess().IsValid();
 }
 
+void BrowserChildProcessHostImpl::CreateMetricsAllocator() {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  DCHECK(!metrics_allocator_);
+
+  // Create a persistent memory segment for child histograms only if they're
+  // active in the browser.
+  if (!base::GlobalHistogramAllocator::Get())
+    return;
+
+  // Only the process types that run a ChildThreadImpl, which is what accepts
+  // the segment, get one. Their histograms are few compared to a renderer's.
+  const char* metrics_name;
+  switch (data_.process_type) {
+    case PROCESS_TYPE_UTILITY:
+      metrics_name = "UtilityMetrics";
+      break;
+    case PROCESS_TYPE_GPU:
+      metrics_name = "GpuMetrics";
+      break;
+    case PROCESS_TYPE_PPAPI_PLUGIN:
+      metrics_name = "PpapiPluginMetrics";
+      break;
+    case PROCESS_TYPE_PPAPI_BROKER:
+      metrics_name = "PpapiBrokerMetrics";
+      break;
+    default:
+      return;
+  }
+
+  std::unique_ptr<base::SharedMemory> shm(new base::SharedMemory());
+  if (!shm->CreateAndMapAnonymous(512 << 10))  // 512 KiB
+    return;
+  metrics_allocator_.reset(new base::SharedPersistentMemoryAllocator(
+      std::move(shm), data_.id, metrics_name, /*readonly=*/false));
+
+  base::SharedMemoryHandle shm_handle;
+  metrics_allocator_->shared_memory()->ShareToProcess(data_.handle,
+                                                      &shm_handle);
+  Send(new ChildProcessMsg_SetHistogramMemory(
+      shm_handle, metrics_allocator_->shared_memory()->mapped_size()));
+}
+
 #if defined(OS_WIN)
 
 void BrowserChildProcessHostImpl::OnObjectSignaled(HANDLE object) {
@@ -26,6 +26,7 @@
 
 namespace base {
 class CommandLine;
+class SharedPersistentMemoryAllocator;
 }
 
 namespace content {
@@ -71,6 +72,8 @@ class CONTENT_EXPORT BrowserChildProcessHostImpl
   void SetName(const base::string16& name) override;
   void SetHandle(base::ProcessHandle handle) override;
   ServiceRegistry* GetServiceRegistry() override;
+  std::unique_ptr<base::SharedPersistentMemoryAllocator> TakeMetricsAllocator()
+      override;
 
   // ChildProcessHostDelegate implementation:
   bool CanShutdown() override;
@@ -116,6 +119,12 @@ class CONTENT_EXPORT BrowserChildProcessHostImpl
   // on the IO thread.
   bool IsProcessLaunched() const;
 
+  // Creates a PersistentMemoryAllocator and shares it with the child process
+  // for it to store histograms from that process, instead of sending them
+  // over IPC. The allocator is available for extraction by a
+  // SubprocessMetricsProvider in order to report those histograms to UMA.
+  void CreateMetricsAllocator();
+
 #if defined(OS_WIN)
   // ObjectWatcher::Delegate implementation.
   void OnObjectSignaled(HANDLE object) override;
@@ -129,6 +138,9 @@ class CONTENT_EXPORT BrowserChildProcessHostImpl
 
   PowerMonitorMessageBroadcaster power_monitor_message_broadcaster_;
 
+  // The memory allocator, if any, in which the process will write its metrics.
+  std::unique_ptr<base::SharedPersistentMemoryAllocator> metrics_allocator_;
+
 #if defined(OS_WIN)
   // Watches to see if the child process exits before the IPC channel has
   // been connected. Thereafter, its exit is determined by an error on the
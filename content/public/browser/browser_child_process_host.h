@@ -5,6 +5,8 @@
 #ifndef CONTENT_PUBLIC_BROWSER_BROWSER_CHILD_PROCESS_HOST_H_
 #define CONTENT_PUBLIC_BROWSER_BROWSER_CHILD_PROCESS_HOST_H_
 
+#include <memory>
+
 #include "base/environment.h"
 #include "base/process/kill.h"
 #include "base/process/process_handle.h"
@@ -21,6 +23,7 @@
 namespace base {
 class CommandLine;
 class FilePath;
+class SharedPersistentMemoryAllocator;
 }
 
 namespace content {
@@ -85,6 +88,15 @@ class CONTENT_EXPORT BrowserChildProcessHost : public IPC::Sender {
   // nullptr if no service registry exists.
   virtual ServiceRegistry* GetServiceRegistry() = 0;
 
+  // Extracts any persistent-memory-allocator used for child process metrics.
+  // Ownership is passed to the caller. To support sharing of histogram data
+  // between the child process and the Browser, the allocator is created when
+  // the process is launched and later retrieved by the
+  // SubprocessMetricsProvider for management. Must be called on the IO
+  // thread.
+  virtual std::unique_ptr<base::SharedPersistentMemoryAllocator>
+  TakeMetricsAllocator() = 0;
+
 #if defined(OS_MACOSX)
   // Returns a PortProvider used to get the task port for child processes.
   static base::PortProvider* GetPortProvider();
@@ -328,6 +328,8 @@ void RenderWidgetCompositor::Initialize(float device_scale_factor) {
   }
 
   settings.use_layer_lists = cmd->HasSwitch(cc::switches::kEnableLayerLists);
+  settings.use_parallel_draw_properties =
+      cmd->HasSwitch(cc::switches::kEnableParallelDrawProperties);
 
   settings.renderer_settings.allow_antialiasing &=
       !cmd->HasSwitch(cc::switches::kDisableCompositedAntialiasing);
@@ -187,6 +187,8 @@ void Channel::NotifyProcessForkedForTesting() {
 int ChannelPosix::global_pid_ = 0;
 #endif  // OS_LINUX
 
+bool ChannelPosix::coalesce_outgoing_messages_ = true;
+
 ChannelPosix::ChannelPosix(const IPC::ChannelHandle& channel_handle,
                            Mode mode,
                            Listener* listener)
@@ -411,8 +413,10 @@ bool ChannelPosix::ProcessOutgoingMessages() {
         message_send_bytes_written_;
 
     struct msghdr msgh = {0};
-    struct iovec iov = {const_cast<char*>(out_bytes), amt_to_write};
-    msgh.msg_iov = &iov;
+    struct iovec iov[kMaxMessagesPerWrite];
+    iov[0].iov_base = const_cast<char*>(out_bytes);
+    iov[0].iov_len = amt_to_write;
+    msgh.msg_iov = iov;
     msgh.msg_iovlen = 1;
     char buf[CMSG_SPACE(sizeof(int) *
                         MessageAttachmentSet::kMaxDescriptorsPerMessage)];
@@ -452,14 +456,31 @@ bool ChannelPosix::ProcessOutgoingMessages() {
       // DCHECK_LE above already checks that
       // num_fds < kMaxDescriptorsPerMessage so no danger of overflow.
       msg->header()->num_fds = static_cast<uint16_t>(num_fds);
+    } else if (coalesce_outgoing_messages_) {
+      // Send the messages queued behind this one along with it. A message
+      // with descriptors to send is left for the next sendmsg(), so that the
+      // descriptors always go out with the first byte of their message.
+      size_t num_elements = 1;
+      while (num_elements < kMaxMessagesPerWrite &&
+             num_elements < output_queue_.size()) {
+        OutputElement* next = output_queue_[num_elements];
+        Message* next_msg = next->get_message();
+        if (next_msg &&
+            next_msg->attachment_set()->num_non_brokerable_attachments()) {
+          break;
+        }
+        iov[num_elements].iov_base = const_cast<void*>(next->data());
+        iov[num_elements].iov_len = next->size();
+        amt_to_write += next->size();
+        num_elements++;
+      }
+      msgh.msg_iovlen = num_elements;
     }
 
     if (bytes_written == 1) {
       fd_written = pipe_.get();
       bytes_written = HANDLE_EINTR(sendmsg(pipe_.get(), &msgh, MSG_DONTWAIT));
     }
-    if (bytes_written > 0 && msg)
-      CloseFileDescriptors(msg);
 
     if (bytes_written < 0 && !SocketWriteErrorIsRecoverable()) {
       // We can't close the pipe here, because calling OnChannelError
@@ -484,12 +505,36 @@ bool ChannelPosix::ProcessOutgoingMessages() {
       return false;
     }
 
-    if (static_cast<size_t>(bytes_written) != amt_to_write) {
-      if (bytes_written > 0) {
-        // If write() fails with EAGAIN then bytes_written will be -1.
-        message_send_bytes_written_ += bytes_written;
+    // If write() fails with EAGAIN then bytes_written will be -1.
+    size_t bytes_left = bytes_written > 0 ? bytes_written : 0;
+    for (size_t i = 0; bytes_left; ++i) {
+      DCHECK_LT(i, static_cast<size_t>(msgh.msg_iovlen));
+      OutputElement* sent = output_queue_.front();
+      Message* sent_msg = sent->get_message();
+      if (sent_msg)
+        CloseFileDescriptors(sent_msg);
+
+      if (bytes_left < iov[i].iov_len) {
+        message_send_bytes_written_ += bytes_left;
+        break;
       }
+      bytes_left -= iov[i].iov_len;
+      message_send_bytes_written_ = 0;
+
+      // Message sent OK!
+      if (sent_msg) {
+        DVLOG(2) << "sent message @" << sent_msg << " on channel @" << this
+                 << " with type " << sent_msg->type() << " on fd "
+                 << pipe_.get();
+      } else {
+        DVLOG(2) << "sent buffer @" << sent->data() << " on channel @"
+                 << this << " on fd " << pipe_.get();
+      }
+      delete sent;
+      output_queue_.pop_front();
+    }
 
+    if (static_cast<size_t>(bytes_written) != amt_to_write) {
       // Tell libevent to call us back once things are unblocked.
       is_blocked_on_write_ = true;
       base::MessageLoopForIO::current()->WatchFileDescriptor(
@@ -499,19 +544,6 @@ bool ChannelPosix::ProcessOutgoingMessages() {
           &write_watcher_,
           this);
       return true;
-    } else {
-      message_send_bytes_written_ = 0;
-
-      // Message sent OK!
-      if (msg) {
-        DVLOG(2) << "sent message @" << msg << " on channel @" << this
-                 << " with type " << msg->type() << " on fd " << pipe_.get();
-      } else {
-        DVLOG(2) << "sent buffer @" << element->data() << " on channel @"
-                 << this << " on fd " << pipe_.get();
-      }
-      delete output_queue_.front();
-      output_queue_.pop();
     }
   }
   return true;
@@ -586,7 +618,7 @@ void ChannelPosix::ResetToAcceptingConnectionState() {
 
   while (!output_queue_.empty()) {
     OutputElement* element = output_queue_.front();
-    output_queue_.pop();
+    output_queue_.pop_front();
     if (element->get_message())
       CloseFileDescriptors(element->get_message());
     delete element;
@@ -624,6 +656,11 @@ int ChannelPosix::GetGlobalPid() {
 }
 #endif  // OS_LINUX
 
+// static
+void ChannelPosix::SetCoalesceOutgoingMessages(bool coalesce) {
+  coalesce_outgoing_messages_ = coalesce;
+}
+
 // Called by libevent when we can read from the pipe without blocking.
 void ChannelPosix::OnFileCanReadWithoutBlocking(int fd) {
   if (fd == server_listen_pipe_.get()) {
@@ -729,13 +766,13 @@ bool ChannelPosix::ProcessMessageForDelivery(Message* message) {
 
   // |output_queue_| takes ownership of |message|.
   OutputElement* element = new OutputElement(message);
-  output_queue_.push(element);
+  output_queue_.push_back(element);
 
   if (message->HasBrokerableAttachments()) {
     // |output_queue_| takes ownership of |ids.buffer|.
     Message::SerializedAttachmentIds ids =
         message->SerializedIdsOfBrokerableAttachments();
-    output_queue_.push(new OutputElement(ids.buffer, ids.size));
+    output_queue_.push_back(new OutputElement(ids.buffer, ids.size));
   }
 
   return ProcessOutgoingMessages();
@@ -831,7 +868,7 @@ void ChannelPosix::QueueHelloMessage() {
     NOTREACHED() << "Unable to pickle hello message proc id";
   }
   OutputElement* element = new OutputElement(msg.release());
-  output_queue_.push(element);
+  output_queue_.push_back(element);
 }
 
 ChannelPosix::ReadState ChannelPosix::ReadData(
@@ -988,7 +1025,7 @@ void ChannelPosix::QueueCloseFDMessage(int fd, int hops) {
       }
 
       OutputElement* element = new OutputElement(msg.release());
-      output_queue_.push(element);
+      output_queue_.push_back(element);
       break;
     }
 
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <sys/socket.h>  // for CMSG macros
 
+#include <deque>
 #include <queue>
 #include <set>
 #include <string>
@@ -68,7 +69,16 @@ class IPC_EXPORT ChannelPosix : public Channel,
   static int GetGlobalPid();
 #endif  // OS_LINUX
 
+  // When enabled, which is the default, messages that queue up behind a
+  // blocked write are sent together with a single vectored sendmsg() once the
+  // socket is writable again. Affects channels in this process only and must
+  // be set before any channel is created.
+  static void SetCoalesceOutgoingMessages(bool coalesce);
+
  private:
+  // Largest number of queued messages sent with a single sendmsg().
+  static const size_t kMaxMessagesPerWrite = 64;
+
   bool CreatePipe(const IPC::ChannelHandle& channel_handle);
 
   // Returns false on recoverable error.
@@ -169,7 +179,7 @@ class IPC_EXPORT ChannelPosix : public Channel,
   std::queue<Message*> prelim_queue_;
 
   // Messages to be sent are queued here.
-  std::queue<OutputElement*> output_queue_;
+  std::deque<OutputElement*> output_queue_;
 
   // We assume a worst case: kReadBufferSize bytes of messages, where each
   // message has no payload and a full complement of descriptors.
@@ -214,6 +224,9 @@ class IPC_EXPORT ChannelPosix : public Channel,
   static int global_pid_;
 #endif  // OS_LINUX
 
+  // See SetCoalesceOutgoingMessages().
+  static bool coalesce_outgoing_messages_;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(ChannelPosix);
 };
 
@@ -12,15 +12,21 @@
 #include <stdint.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "base/file_descriptor_posix.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
 #include "base/location.h"
 #include "base/path_service.h"
+#include "base/pickle.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/process/process.h"
 #include "base/single_thread_task_runner.h"
@@ -28,12 +34,14 @@
 #include "base/test/test_timeouts.h"
 #include "build/build_config.h"
 #include "ipc/ipc_listener.h"
+#include "ipc/ipc_message_utils.h"
 #include "ipc/unix_domain_socket_util.h"
 #include "testing/multiprocess_func_list.h"
 
 namespace {
 
 static const uint32_t kQuitMessage = 47;
+static const uint32_t kOrderedMessage = 48;
 
 class IPCChannelPosixTestListener : public IPC::Listener {
  public:
@@ -106,6 +114,53 @@ class IPCChannelPosixTestListener : public IPC::Listener {
   bool quit_only_on_message_;
 };
 
+// Records the index of each kOrderedMessage received, and the inode of the
+// descriptor that it carries, or 0 if it carries none. Quits the run loop
+// once |expected_messages| have arrived.
+class IPCChannelPosixOrderListener : public IPC::Listener {
+ public:
+  explicit IPCChannelPosixOrderListener(size_t expected_messages)
+      : expected_messages_(expected_messages) {}
+
+  ~IPCChannelPosixOrderListener() override {}
+
+  bool OnMessageReceived(const IPC::Message& message) override {
+    EXPECT_EQ(kOrderedMessage, message.type());
+    base::PickleIterator iter(message);
+    int index = -1;
+    bool has_descriptor = false;
+    EXPECT_TRUE(iter.ReadInt(&index));
+    EXPECT_TRUE(iter.ReadBool(&has_descriptor));
+    ino_t inode = 0;
+    base::FileDescriptor descriptor;
+    if (has_descriptor &&
+        IPC::ParamTraits<base::FileDescriptor>::Read(&message, &iter,
+                                                     &descriptor)) {
+      struct stat st;
+      EXPECT_EQ(0, fstat(descriptor.fd, &st));
+      EXPECT_EQ(0, IGNORE_EINTR(close(descriptor.fd)));
+      inode = st.st_ino;
+    }
+    indices_.push_back(index);
+    inodes_.push_back(inode);
+    if (indices_.size() == expected_messages_)
+      base::MessageLoopForIO::current()->QuitWhenIdle();
+    return true;
+  }
+
+  void OnChannelError() override {
+    base::MessageLoopForIO::current()->QuitWhenIdle();
+  }
+
+  const std::vector<int>& indices() const { return indices_; }
+  const std::vector<ino_t>& inodes() const { return inodes_; }
+
+ private:
+  const size_t expected_messages_;
+  std::vector<int> indices_;
+  std::vector<ino_t> inodes_;
+};
+
 class IPCChannelPosixTest : public base::MultiProcessTest {
  public:
   static void SetUpSocket(IPC::ChannelHandle *handle,
@@ -267,6 +322,64 @@ TEST_F(IPCChannelPosixTest, AcceptHangTest) {
   ASSERT_EQ(IPCChannelPosixTestListener::CHANNEL_ERROR, out_listener.status());
 }
 
+// Messages that queue up behind a blocked write are sent together once the
+// socket is writable again. Make sure that they arrive in order, and that each
+// descriptor arrives with the message that it was sent with, when messages
+// with and without descriptors are flushed together.
+TEST_F(IPCChannelPosixTest, CoalescedMessagesKeepOrderAndDescriptors) {
+  const int kNumMessages = 12;
+  IPCChannelPosixTestListener out_listener(true);
+  IPCChannelPosixOrderListener in_listener(kNumMessages);
+  IPC::ChannelHandle in_handle("IN");
+  std::unique_ptr<IPC::ChannelPosix> in_chan(new IPC::ChannelPosix(
+      in_handle, IPC::Channel::MODE_SERVER, &in_listener));
+  base::ScopedFD out_fd = in_chan->TakeClientFileDescriptor();
+
+  // A small send buffer makes the first, large, message block the socket, so
+  // that the ones sent after it are queued and then flushed together.
+  int send_buffer_size = 4096;
+  ASSERT_EQ(0, setsockopt(out_fd.get(), SOL_SOCKET, SO_SNDBUF,
+                          &send_buffer_size, sizeof(send_buffer_size)));
+  IPC::ChannelHandle out_handle("OUT", base::FileDescriptor(std::move(out_fd)));
+  std::unique_ptr<IPC::ChannelPosix> out_chan(new IPC::ChannelPosix(
+      out_handle, IPC::Channel::MODE_CLIENT, &out_listener));
+  ASSERT_TRUE(in_chan->Connect());
+  ASSERT_TRUE(out_chan->Connect());
+
+  // Messages 3, 4, 7 and 11 carry the read end of a pipe each. The write ends
+  // are kept open so that the inodes stay in use until the test is done.
+  std::vector<base::ScopedFD> write_ends;
+  std::vector<ino_t> expected_inodes(kNumMessages, 0);
+  for (int i = 0; i < kNumMessages; ++i) {
+    bool has_descriptor = i == 3 || i == 4 || i == 7 || i == 11;
+    IPC::Message* message = new IPC::Message(0,  // routing_id
+                                             kOrderedMessage,
+                                             IPC::Message::PRIORITY_NORMAL);
+    message->WriteInt(i);
+    message->WriteBool(has_descriptor);
+    if (has_descriptor) {
+      int pipe_fds[2];
+      ASSERT_EQ(0, pipe(pipe_fds));
+      write_ends.push_back(base::ScopedFD(pipe_fds[1]));
+      struct stat st;
+      ASSERT_EQ(0, fstat(pipe_fds[0], &st));
+      expected_inodes[i] = st.st_ino;
+      IPC::ParamTraits<base::FileDescriptor>::Write(
+          message, base::FileDescriptor(pipe_fds[0], true));
+    }
+    if (i == 0)
+      message->WriteString(std::string(256 * 1024, 'x'));
+    ASSERT_TRUE(out_chan->Send(message));
+  }
+
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+  ASSERT_EQ(static_cast<size_t>(kNumMessages), in_listener.indices().size());
+  for (int i = 0; i < kNumMessages; ++i) {
+    EXPECT_EQ(i, in_listener.indices()[i]);
+    EXPECT_EQ(expected_inodes[i], in_listener.inodes()[i]) << "message " << i;
+  }
+}
+
 TEST_F(IPCChannelPosixTest, AdvancedConnected) {
   // Test creating a connection to an external process.
   IPCChannelPosixTestListener listener(false);
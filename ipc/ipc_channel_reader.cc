@@ -44,6 +44,8 @@ std::string GetMessageText(const Message& message) {
 
 ChannelReader::ChannelReader(Listener* listener)
   : listener_(listener),
+    read_buffer_(input_buf_),
+    partial_message_bytes_left_(0),
     max_input_buffer_size_(Channel::kMaximumReadBufferSize) {
   memset(input_buf_, 0, sizeof(input_buf_));
 }
@@ -55,15 +57,16 @@ ChannelReader::~ChannelReader() {
 ChannelReader::DispatchState ChannelReader::ProcessIncomingMessages() {
   while (true) {
     int bytes_read = 0;
-    ReadState read_state = ReadData(input_buf_, Channel::kReadBufferSize,
-                                    &bytes_read);
+    int buffer_len = 0;
+    read_buffer_ = GetReadBuffer(&buffer_len);
+    ReadState read_state = ReadData(read_buffer_, buffer_len, &bytes_read);
     if (read_state == READ_FAILED)
       return DISPATCH_ERROR;
     if (read_state == READ_PENDING)
       return DISPATCH_FINISHED;
 
     DCHECK(bytes_read > 0);
-    if (!TranslateInputData(input_buf_, bytes_read))
+    if (!TranslateInputData(read_buffer_, bytes_read))
       return DISPATCH_ERROR;
 
     DispatchState state = DispatchMessages();
@@ -73,7 +76,7 @@ ChannelReader::DispatchState ChannelReader::ProcessIncomingMessages() {
 }
 
 ChannelReader::DispatchState ChannelReader::AsyncReadComplete(int bytes_read) {
-  if (!TranslateInputData(input_buf_, bytes_read))
+  if (!TranslateInputData(read_buffer_, bytes_read))
     return DISPATCH_ERROR;
 
   return DispatchMessages();
@@ -103,6 +106,26 @@ void ChannelReader::DispatchMessage(Message* m) {
   HandleDispatchError(*m);
 }
 
+char* ChannelReader::GetReadBuffer(int* buffer_len) {
+  // Reading the rest of a large message in as few reads as possible saves
+  // both system calls and appends to |input_overflow_buf_|. No more than
+  // Channel::kReadBufferSize bytes past the end of the message are read, so
+  // a read still brings in at most as many messages, and as many attachments,
+  // as a read into |input_buf_|.
+  if (partial_message_bytes_left_ > Channel::kReadBufferSize) {
+    if (!large_input_buf_)
+      large_input_buf_.reset(new char[Channel::kMaximumReadBufferSize]);
+    size_t read_size = partial_message_bytes_left_ + Channel::kReadBufferSize;
+    if (read_size > Channel::kMaximumReadBufferSize)
+      read_size = Channel::kMaximumReadBufferSize;
+    *buffer_len = static_cast<int>(read_size);
+    return large_input_buf_.get();
+  }
+
+  *buffer_len = static_cast<int>(Channel::kReadBufferSize);
+  return input_buf_;
+}
+
 bool ChannelReader::TranslateInputData(const char* input_data,
                                        int input_data_len) {
   const char* p;
@@ -152,6 +175,11 @@ bool ChannelReader::TranslateInputData(const char* input_data,
   if (p != input_overflow_buf_.data())
     input_overflow_buf_.assign(p, end - p);
 
+  partial_message_bytes_left_ =
+      next_message_size > input_overflow_buf_.size()
+          ? next_message_size - input_overflow_buf_.size()
+          : 0;
+
   if (!input_overflow_buf_.empty()) {
     // We have something in the overflow buffer, which means that we will
     // append the next data chunk (instead of parsing it directly). So we
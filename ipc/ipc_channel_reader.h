@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 
+#include <memory>
 #include <set>
 
 #include "base/gtest_prod_util.h"
@@ -132,10 +133,16 @@ class IPC_EXPORT ChannelReader : public SupportsAttachmentBrokering,
   FRIEND_TEST_ALL_PREFIXES(ChannelReaderTest, ResizeOverflowBuffer);
   FRIEND_TEST_ALL_PREFIXES(ChannelReaderTest, InvalidMessageSize);
   FRIEND_TEST_ALL_PREFIXES(ChannelReaderTest, TrimBuffer);
+  FRIEND_TEST_ALL_PREFIXES(ChannelReaderTest, ReadRestOfLargeMessage);
 
   using AttachmentIdSet = std::set<BrokerableAttachment::AttachmentId>;
   using AttachmentIdVector = std::vector<BrokerableAttachment::AttachmentId>;
 
+  // Returns the buffer to pass to the next ReadData() call, and its size in
+  // |buffer_len|. This is |input_buf_| unless the rest of a large message is
+  // still to come.
+  char* GetReadBuffer(int* buffer_len);
+
   // Takes the data received from the IPC channel and translates it into
   // Messages. Complete messages are passed to HandleTranslatedMessage().
   // Returns |false| on unrecoverable error.
@@ -191,6 +198,18 @@ class IPC_EXPORT ChannelReader : public SupportsAttachmentBrokering,
   // not access directly outside that function.
   char input_buf_[Channel::kReadBufferSize];
 
+  // The rest of a large message is read into this buffer, which is allocated
+  // on first use and can hold Channel::kMaximumReadBufferSize bytes.
+  std::unique_ptr<char[]> large_input_buf_;
+
+  // The buffer passed to the last ReadData() call, either |input_buf_| or
+  // |large_input_buf_|. AsyncReadComplete() translates the data from there.
+  char* read_buffer_;
+
+  // Number of bytes still missing from the partial message at the end of
+  // |input_overflow_buf_|, or 0 if that is not known.
+  size_t partial_message_bytes_left_;
+
   // Large messages that span multiple pipe buffers, get built-up using
   // this buffer.
   std::string input_overflow_buf_;
@@ -74,7 +74,8 @@ class MockAttachmentBroker : public AttachmentBroker {
 class MockChannelReader : public ChannelReader {
  public:
   MockChannelReader()
-      : ChannelReader(nullptr), last_dispatched_message_(nullptr) {}
+      : ChannelReader(nullptr), last_dispatched_message_(nullptr),
+        num_reads_(0) {}
 
   ReadState ReadData(char* buffer, int buffer_len, int* bytes_read) override {
     if (data_.empty())
@@ -84,6 +85,7 @@ class MockChannelReader : public ChannelReader {
     memcpy(buffer, data_.data(), read_len);
     *bytes_read = static_cast<int>(read_len);
     data_.erase(0, read_len);
+    num_reads_++;
     return READ_SUCCEEDED;
   }
 
@@ -110,6 +112,8 @@ class MockChannelReader : public ChannelReader {
 
   Message* get_last_dispatched_message() { return last_dispatched_message_; }
 
+  int num_reads() const { return num_reads_; }
+
   void set_broker(AttachmentBroker* broker) { broker_ = broker; }
 
   void AppendData(const void* data, size_t size) {
@@ -124,6 +128,7 @@ class MockChannelReader : public ChannelReader {
   Message* last_dispatched_message_;
   AttachmentBroker* broker_;
   std::string data_;
+  int num_reads_;
 };
 
 class ExposedMessage: public Message {
@@ -227,6 +232,31 @@ TEST(ChannelReaderTest, InvalidMessageSize) {
   EXPECT_LE(reader.input_overflow_buf_.capacity(), capacity_before);
 }
 
+TEST(ChannelReaderTest, ReadRestOfLargeMessage) {
+  MockChannelReader reader;
+
+  Message message1;
+  message1.WriteString(std::string(LargePayloadSize, 'X'));
+  reader.AppendMessageData(message1);
+  Message message2;
+  message2.WriteString("small");
+  reader.AppendMessageData(message2);
+
+  EXPECT_EQ(ChannelReader::DISPATCH_FINISHED,
+            reader.ProcessIncomingMessages());
+
+  // The first read finds the size of the large message. The rest of it is
+  // then read in chunks of up to kMaximumReadBufferSize, the last of which
+  // also picks up the small message.
+  size_t rest = message1.size() + message2.size() - Channel::kReadBufferSize;
+  int expected_reads = 1 + static_cast<int>(
+      (rest + Channel::kMaximumReadBufferSize - 1) /
+      Channel::kMaximumReadBufferSize);
+  EXPECT_EQ(expected_reads, reader.num_reads());
+  EXPECT_EQ(0u, reader.partial_message_bytes_left_);
+  EXPECT_TRUE(reader.input_overflow_buf_.empty());
+}
+
 #endif  // !USE_ATTACHMENT_BROKER
 
 TEST(ChannelReaderTest, TrimBuffer) {
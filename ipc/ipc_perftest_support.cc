@@ -16,6 +16,7 @@
 #include "base/memory/ptr_util.h"
 #include "base/pickle.h"
 #include "base/strings/stringprintf.h"
+#include "base/test/perf_log.h"
 #include "base/test/perf_time_logger.h"
 #include "base/test/test_io_thread.h"
 #include "base/threading/thread.h"
@@ -34,6 +35,9 @@ namespace test {
 // Setting thread affinity will fail harmlessly on single/dual core machines.
 const int kSharedCore = 2;
 
+// Number of messages the throughput tests keep in flight.
+const int kThroughputWindow = 100;
+
 // This class simply collects stats about abstract "events" (each of which has a
 // start time and an end time).
 class EventTimeTracker {
@@ -228,6 +232,93 @@ class PerformanceChannelListener : public Listener {
   std::unique_ptr<base::PerfTimeLogger> perf_logger_;
 };
 
+// This channel listener keeps up to |window| messages in flight to a client
+// running ChannelReflectorListener, and logs the rate at which the replies come
+// back.
+class ThroughputChannelListener : public Listener {
+ public:
+  ThroughputChannelListener(const std::string& label, int window)
+      : label_(label),
+        window_(window),
+        sender_(NULL),
+        msg_count_(0),
+        msg_size_(0),
+        sent_count_(0),
+        received_count_(0) {}
+
+  void Init(Sender* sender) {
+    DCHECK(!sender_);
+    sender_ = sender;
+  }
+
+  // Call this before running the message loop.
+  void SetTestParams(int msg_count, size_t msg_size) {
+    msg_count_ = msg_count;
+    msg_size_ = msg_size;
+    sent_count_ = 0;
+    received_count_ = 0;
+    payload_ = std::string(msg_size_, 'a');
+  }
+
+  bool OnMessageReceived(const Message& message) override {
+    CHECK(sender_);
+
+    base::PickleIterator iter(message);
+    int64_t time_internal;
+    EXPECT_TRUE(iter.ReadInt64(&time_internal));
+    int msgid;
+    EXPECT_TRUE(iter.ReadInt(&msgid));
+    base::StringPiece reflected_payload;
+    EXPECT_TRUE(iter.ReadStringPiece(&reflected_payload));
+
+    if (reflected_payload == "hello") {
+      // Start timing on hello, and fill the window.
+      start_time_ = base::TimeTicks::Now();
+      while (sent_count_ < msg_count_ && sent_count_ < window_)
+        SendMessage();
+      return true;
+    }
+
+    DCHECK_EQ(payload_.size(), reflected_payload.size());
+    received_count_++;
+    if (sent_count_ < msg_count_)
+      SendMessage();
+
+    if (received_count_ == msg_count_) {
+      base::TimeDelta elapsed = base::TimeTicks::Now() - start_time_;
+      std::string test_name =
+          base::StringPrintf("IPC_%s_Throughput_%u", label_.c_str(),
+                             static_cast<unsigned>(msg_size_));
+      base::LogPerfResult(test_name.c_str(),
+                          msg_count_ / elapsed.InSecondsF(), "messages/s");
+      base::MessageLoop::current()->QuitWhenIdle();
+    }
+    return true;
+  }
+
+ private:
+  void SendMessage() {
+    Message* msg = new Message(0, 2, Message::PRIORITY_NORMAL);
+    msg->WriteInt64(base::TimeTicks::Now().ToInternalValue());
+    msg->WriteInt(sent_count_++);
+    msg->WriteString(payload_);
+    sender_->Send(msg);
+  }
+
+  std::string label_;
+  int window_;
+  Sender* sender_;
+  int msg_count_;
+  size_t msg_size_;
+
+  int sent_count_;
+  int received_count_;
+  std::string payload_;
+  base::TimeTicks start_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThroughputChannelListener);
+};
+
 IPCChannelPerfTestBase::IPCChannelPerfTestBase() = default;
 IPCChannelPerfTestBase::~IPCChannelPerfTestBase() = default;
 
@@ -244,6 +335,15 @@ IPCChannelPerfTestBase::GetDefaultTestParams() {
   return list;
 }
 
+std::vector<PingPongTestParams>
+IPCChannelPerfTestBase::GetThroughputTestParams() {
+  std::vector<PingPongTestParams> list;
+  list.push_back(PingPongTestParams(12, 200000));
+  list.push_back(PingPongTestParams(1024, 100000));
+  list.push_back(PingPongTestParams(65536, 10000));
+  return list;
+}
+
 void IPCChannelPerfTestBase::RunTestChannelPingPong(
     const std::vector<PingPongTestParams>& params) {
   Init("PerformanceClient");
@@ -283,6 +383,46 @@ void IPCChannelPerfTestBase::RunTestChannelPingPong(
   DestroyChannel();
 }
 
+void IPCChannelPerfTestBase::RunTestChannelThroughput(
+    const std::string& label,
+    const std::vector<PingPongTestParams>& params) {
+  Init("PerformanceClient");
+
+  // Set up IPC channel and start client.
+  ThroughputChannelListener listener(label, kThroughputWindow);
+  CreateChannel(&listener);
+  listener.Init(channel());
+  ASSERT_TRUE(ConnectChannel());
+  ASSERT_TRUE(StartClient());
+
+  LockThreadAffinity thread_locker(kSharedCore);
+  for (size_t i = 0; i < params.size(); i++) {
+    listener.SetTestParams(params[i].message_count(),
+                           params[i].message_size());
+
+    // The reply to this initial message starts the test.
+    Message* message =
+        new Message(0, 2, Message::PRIORITY_NORMAL);
+    message->WriteInt64(base::TimeTicks::Now().ToInternalValue());
+    message->WriteInt(-1);
+    message->WriteString("hello");
+    sender()->Send(message);
+
+    // Run message loop.
+    base::MessageLoop::current()->Run();
+  }
+
+  // Send quit message.
+  Message* message = new Message(0, 2, Message::PRIORITY_NORMAL);
+  message->WriteInt64(base::TimeTicks::Now().ToInternalValue());
+  message->WriteInt(-1);
+  message->WriteString("quit");
+  sender()->Send(message);
+
+  EXPECT_TRUE(WaitForClientShutdown());
+  DestroyChannel();
+}
+
 void IPCChannelPerfTestBase::RunTestChannelProxyPingPong(
     const std::vector<PingPongTestParams>& params) {
   io_thread_.reset(new base::TestIOThread(base::TestIOThread::kAutoStart));
@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
@@ -41,12 +42,20 @@ class IPCChannelPerfTestBase : public IPCTestBase {
   ~IPCChannelPerfTestBase() override;
 
   static std::vector<PingPongTestParams> GetDefaultTestParams();
+  static std::vector<PingPongTestParams> GetThroughputTestParams();
 
   void RunTestChannelPingPong(
       const std::vector<PingPongTestParams>& params_list);
   void RunTestChannelProxyPingPong(
       const std::vector<PingPongTestParams>& params_list);
 
+  // Unlike the ping-pong tests, which only ever have one message in flight,
+  // keeps a window of messages in flight to the client and logs how many
+  // messages per second make the round trip. |label| names the results.
+  void RunTestChannelThroughput(
+      const std::string& label,
+      const std::vector<PingPongTestParams>& params_list);
+
   scoped_refptr<base::TaskRunner> io_task_runner() {
     if (io_thread_)
       return io_thread_->task_runner();
@@ -2,8 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "build/build_config.h"
 #include "ipc/ipc_perftest_support.h"
 
+#if defined(OS_POSIX) && !defined(OS_NACL)
+#include "ipc/ipc_channel_posix.h"
+#endif
+
 namespace {
 
 // This test times the roundtrip IPC message cycle.
@@ -21,6 +26,20 @@ TEST_F(IPCChannelPerfTest, ChannelProxyPingPong) {
   RunTestChannelProxyPingPong(GetDefaultTestParams());
 }
 
+TEST_F(IPCChannelPerfTest, ChannelThroughput) {
+  RunTestChannelThroughput("Channel", GetThroughputTestParams());
+}
+
+#if defined(OS_POSIX) && !defined(OS_NACL)
+// Same as above, with this process sending every message with its own
+// sendmsg(). The client process still coalesces its replies.
+TEST_F(IPCChannelPerfTest, ChannelThroughputNoCoalescing) {
+  IPC::ChannelPosix::SetCoalesceOutgoingMessages(false);
+  RunTestChannelThroughput("ChannelNoCoalescing", GetThroughputTestParams());
+  IPC::ChannelPosix::SetCoalesceOutgoingMessages(true);
+}
+#endif
+
 MULTIPROCESS_IPC_TEST_CLIENT_MAIN(PerformanceClient) {
   IPC::test::PingPongTestClient client;
   return client.RunMain();
@@ -61,6 +61,12 @@ struct Configuration {
   // (This will also entail some auditing to make sure I'm not messing up my
   // checks anywhere.)
   size_t max_shared_memory_num_bytes;
+
+  // Whether the channels between processes send messages through shared
+  // memory rings, and use their platform channel only to pass handles and to
+  // wake up an idle reader. Where supported, the other process then does the
+  // same, whatever its own setting. The default is false.
+  bool use_shared_memory_channel_transport;
 };
 
 }  // namespace edk
@@ -498,41 +498,82 @@ void Channel::ShutDown() {
   ShutDownImpl();
 }
 
+void Channel::EnableSharedMemoryTransport() {
+}
+
+void Channel::AcceptSharedMemoryTransport() {
+}
+
 char* Channel::GetReadBuffer(size_t *buffer_capacity) {
   DCHECK(read_buffer_);
+  return ReserveReadBuffer(read_buffer_.get(), buffer_capacity);
+}
+
+bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
+  return DispatchReadBuffer(read_buffer_.get(), bytes_read,
+                            next_read_size_hint);
+}
+
+char* Channel::GetSecondaryReadBuffer(size_t* buffer_capacity) {
+  if (!secondary_read_buffer_)
+    secondary_read_buffer_.reset(new ReadBuffer);
+  return ReserveReadBuffer(secondary_read_buffer_.get(), buffer_capacity);
+}
+
+bool Channel::OnSecondaryReadComplete(size_t bytes_read,
+                                      size_t* next_read_size_hint) {
+  DCHECK(secondary_read_buffer_);
+  return DispatchReadBuffer(secondary_read_buffer_.get(), bytes_read,
+                            next_read_size_hint);
+}
+
+// static
+char* Channel::ReserveReadBuffer(ReadBuffer* read_buffer,
+                                 size_t* buffer_capacity) {
   size_t required_capacity = *buffer_capacity;
   if (!required_capacity)
     required_capacity = kReadBufferSize;
 
   *buffer_capacity = required_capacity;
-  return read_buffer_->Reserve(required_capacity);
+  return read_buffer->Reserve(required_capacity);
 }
 
-bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
+bool Channel::DispatchReadBuffer(ReadBuffer* read_buffer,
+                                 size_t bytes_read,
+                                 size_t* next_read_size_hint) {
   bool did_dispatch_message = false;
-  read_buffer_->Claim(bytes_read);
-  while (read_buffer_->num_occupied_bytes() >= sizeof(Message::Header)) {
+  read_buffer->Claim(bytes_read);
+  while (read_buffer->num_occupied_bytes() >= sizeof(Message::Header)) {
     // Ensure the occupied data is properly aligned. If it isn't, a SIGBUS could
     // happen on architectures that don't allow misaligned words access (i.e.
     // anything other than x86). Only re-align when necessary to avoid copies.
-    if (reinterpret_cast<uintptr_t>(read_buffer_->occupied_bytes()) %
+    if (reinterpret_cast<uintptr_t>(read_buffer->occupied_bytes()) %
         kChannelMessageAlignment != 0)
-      read_buffer_->Realign();
+      read_buffer->Realign();
 
     // We have at least enough data available for a MessageHeader.
     const Message::Header* header = reinterpret_cast<const Message::Header*>(
-        read_buffer_->occupied_bytes());
+        read_buffer->occupied_bytes());
     if (header->num_bytes < sizeof(Message::Header) ||
         header->num_bytes > kMaxChannelMessageSize) {
       LOG(ERROR) << "Invalid message size: " << header->num_bytes;
       return false;
     }
 
-    if (read_buffer_->num_occupied_bytes() < header->num_bytes) {
+    // Control messages are only accepted from the primary read buffer. One
+    // dispatched from the secondary buffer could read from that same buffer
+    // again while |header| still points into it.
+    if (read_buffer == secondary_read_buffer_.get() &&
+        header->message_type != Message::Header::MessageType::NORMAL) {
+      LOG(ERROR) << "Unexpected control message in secondary read buffer";
+      return false;
+    }
+
+    if (read_buffer->num_occupied_bytes() < header->num_bytes) {
       // Not enough data available to read the full message. Hint to the
       // implementation that it should try reading the full size of the message.
       *next_read_size_hint =
-          header->num_bytes - read_buffer_->num_occupied_bytes();
+          header->num_bytes - read_buffer->num_occupied_bytes();
       return true;
     }
 
@@ -554,7 +595,7 @@ bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
     size_t payload_size = header->num_bytes - header->num_header_bytes;
     void* payload =
         payload_size ? reinterpret_cast<Message::Header*>(
-                           const_cast<char*>(read_buffer_->occupied_bytes()) +
+                           const_cast<char*>(read_buffer->occupied_bytes()) +
                            header->num_header_bytes)
                      : nullptr;
 #endif  // defined(OS_CHROMEOS) || defined(OS_ANDROID)
@@ -584,7 +625,7 @@ bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
       did_dispatch_message = true;
     }
 
-    read_buffer_->Discard(header->num_bytes);
+    read_buffer->Discard(header->num_bytes);
   }
 
   *next_read_size_hint = did_dispatch_message ? 0 : kReadBufferSize;
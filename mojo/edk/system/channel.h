@@ -36,9 +36,18 @@ class Channel : public base::RefCountedThreadSafe<Channel> {
         NORMAL = 0,
 #if defined(OS_MACOSX)
         // A control message containing handles to echo back.
-        HANDLES_SENT,
+        HANDLES_SENT = 1,
         // A control message containing handles that can now be closed.
-        HANDLES_SENT_ACK,
+        HANDLES_SENT_ACK = 2,
+#endif
+#if defined(OS_POSIX)
+        // A control message containing a shared memory ring that the sender
+        // writes its following messages to.
+        RING_BUFFER_OFFER = 3,
+        // A control message asking the receiver to look at the shared memory
+        // rings again. May carry the platform handles of messages written to
+        // the ring, without counting them in |num_handles|.
+        RING_BUFFER_WAKEUP = 4,
 #endif
       };
 
@@ -126,6 +135,7 @@ class Channel : public base::RefCountedThreadSafe<Channel> {
     size_t payload_size() const;
 #endif  // defined(OS_CHROMEOS) || defined(OS_ANDROID)
 
+    Header::MessageType message_type() const { return header_->message_type; }
     size_t num_handles() const { return header_->num_handles; }
     bool has_handles() const { return header_->num_handles > 0; }
     PlatformHandle* handles();
@@ -221,6 +231,20 @@ class Channel : public base::RefCountedThreadSafe<Channel> {
   // Delegate::OnChannelError.
   virtual void Write(MessagePtr message) = 0;
 
+  // Asks the Channel to send messages through shared memory instead of the
+  // underlying I/O channel where it can, if the other end supports it. Only
+  // the platform handles attached to messages and the wakeups of an idle
+  // reader still go through the I/O channel. Implies
+  // AcceptSharedMemoryTransport(). Must be called before Start(). Does nothing
+  // on platforms without such a transport.
+  virtual void EnableSharedMemoryTransport();
+
+  // Lets the other end switch both directions of the Channel to shared memory.
+  // Otherwise its attempts to do so are treated as errors, so only Channels
+  // whose delegates are node channels should call this. Must be called before
+  // Start().
+  virtual void AcceptSharedMemoryTransport();
+
  protected:
   explicit Channel(Delegate* delegate);
   virtual ~Channel();
@@ -239,6 +263,13 @@ class Channel : public base::RefCountedThreadSafe<Channel> {
   // read done by the implementation.
   bool OnReadComplete(size_t bytes_read, size_t* next_read_size_hint);
 
+  // Like GetReadBuffer() and OnReadComplete(), for a second stream of messages
+  // that the implementation reads from another source than its I/O channel,
+  // e.g. shared memory. Messages in the two streams are delimited separately
+  // and dispatched in the order each stream is completed.
+  char* GetSecondaryReadBuffer(size_t* buffer_capacity);
+  bool OnSecondaryReadComplete(size_t bytes_read, size_t* next_read_size_hint);
+
   // Called by the implementation when something goes horribly wrong. It is NOT
   // OK to call this synchronously from any public interface methods.
   void OnError();
@@ -272,9 +303,18 @@ class Channel : public base::RefCountedThreadSafe<Channel> {
 
   class ReadBuffer;
 
+  static char* ReserveReadBuffer(ReadBuffer* read_buffer,
+                                 size_t* buffer_capacity);
+  bool DispatchReadBuffer(ReadBuffer* read_buffer,
+                          size_t bytes_read,
+                          size_t* next_read_size_hint);
+
   Delegate* delegate_;
   const std::unique_ptr<ReadBuffer> read_buffer_;
 
+  // Only allocated once a second stream is read from.
+  std::unique_ptr<ReadBuffer> secondary_read_buffer_;
+
   DISALLOW_COPY_AND_ASSIGN(Channel);
 };
 
@@ -14,6 +14,7 @@
 
 #include "base/bind.h"
 #include "base/location.h"
+#include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
@@ -21,6 +22,7 @@
 #include "base/task_runner.h"
 #include "mojo/edk/embedder/platform_channel_utils_posix.h"
 #include "mojo/edk/embedder/platform_handle_vector.h"
+#include "mojo/edk/system/shared_ring_buffer.h"
 
 namespace mojo {
 namespace edk {
@@ -29,6 +31,20 @@ namespace {
 
 const size_t kMaxBatchReadCapacity = 256 * 1024;
 
+// Size of the shared memory ring each side writes its messages to once the
+// shared memory transport is enabled. Larger messages are streamed through it.
+const size_t kRingBufferCapacity = 256 * 1024;
+
+// How much is read from the incoming ring at once.
+const size_t kRingBufferReadSize = 64 * 1024;
+
+// Payload of a RING_BUFFER_OFFER message, which also carries the handle to the
+// shared memory of the ring.
+struct RingBufferOffer {
+  uint32_t capacity;
+  uint32_t padding;
+};
+
 // A view over a Channel::Message object. The write queue uses these since
 // large messages may need to be sent in chunks.
 class MessageView {
@@ -118,12 +134,17 @@ class ChannelPosix : public Channel,
       base::AutoLock lock(write_lock_);
       if (reject_writes_)
         return;
-      if (outgoing_messages_.empty()) {
-        if (!WriteNoLock(MessageView(std::move(message), 0)))
-          reject_writes_ = write_error = true;
+      bool write_result;
+      // Control messages always go over the socket, since the reader only
+      // accepts normal messages from the ring.
+      if (outgoing_ring_ &&
+          message->message_type() == Message::Header::MessageType::NORMAL) {
+        write_result = WriteToRingNoLock(MessageView(std::move(message), 0));
       } else {
-        outgoing_messages_.emplace_back(std::move(message), 0);
+        write_result = WriteToSocketNoLock(MessageView(std::move(message), 0));
       }
+      if (!write_result)
+        reject_writes_ = write_error = true;
     }
     if (write_error) {
       // Do not synchronously invoke OnError(). Write() may have been called by
@@ -133,6 +154,13 @@ class ChannelPosix : public Channel,
     }
   }
 
+  void EnableSharedMemoryTransport() override {
+    offer_ring_buffer_on_start_ = true;
+    accept_ring_buffer_ = true;
+  }
+
+  void AcceptSharedMemoryTransport() override { accept_ring_buffer_ = true; }
+
   bool GetReadPlatformHandles(
       size_t num_handles,
       const void* extra_header,
@@ -207,6 +235,9 @@ class ChannelPosix : public Channel,
         handle_.get().handle, true /* persistent */,
         base::MessageLoopForIO::WATCH_READ, read_watcher_.get(), this);
     base::MessageLoop::current()->AddDestructionObserver(this);
+
+    if (offer_ring_buffer_on_start_)
+      OfferRingBuffer();
   }
 
   void WaitForWriteOnIOThread() {
@@ -294,6 +325,146 @@ class ChannelPosix : public Channel,
     }
   }
 
+  // Creates the ring this side writes its messages to from now on, and sends
+  // it to the other side. Does nothing if it was already sent. If the ring
+  // cannot be created, messages keep going through the socket.
+  void OfferRingBuffer() {
+    bool write_error = false;
+    {
+      base::AutoLock lock(write_lock_);
+      if (outgoing_ring_ || reject_writes_)
+        return;
+
+      std::unique_ptr<SharedRingBuffer> ring =
+          SharedRingBuffer::Create(kRingBufferCapacity);
+      if (!ring)
+        return;
+      ScopedPlatformHandle ring_handle = ring->DuplicatePlatformHandle();
+      if (!ring_handle.is_valid())
+        return;
+
+      MessagePtr message(new Channel::Message(
+          sizeof(RingBufferOffer), 1,
+          Message::Header::MessageType::RING_BUFFER_OFFER));
+      RingBufferOffer* offer =
+          static_cast<RingBufferOffer*>(message->mutable_payload());
+      offer->capacity = static_cast<uint32_t>(ring->capacity());
+      offer->padding = 0;
+      ScopedPlatformHandleVectorPtr handles(new PlatformHandleVector(1));
+      handles->at(0) = ring_handle.release();
+      message->SetHandles(std::move(handles));
+
+      // Messages written from now on go to the ring, which the other side only
+      // reads once it has read the offer and everything sent before it.
+      if (WriteToSocketNoLock(MessageView(std::move(message), 0)))
+        outgoing_ring_ = std::move(ring);
+      else
+        reject_writes_ = write_error = true;
+    }
+    if (write_error) {
+      io_task_runner_->PostTask(FROM_HERE,
+                                base::Bind(&ChannelPosix::OnError, this));
+    }
+  }
+
+  // Starts reading the ring that the other side writes its messages to.
+  bool AcceptRingBuffer(const void* payload,
+                        size_t payload_size,
+                        ScopedPlatformHandleVectorPtr handles) {
+    if (incoming_ring_ || payload_size != sizeof(RingBufferOffer) ||
+        !handles || handles->size() != 1) {
+      return false;
+    }
+    const RingBufferOffer* offer =
+        static_cast<const RingBufferOffer*>(payload);
+    ScopedPlatformHandle ring_handle(handles->at(0));
+    handles->clear();
+    incoming_ring_ = SharedRingBuffer::CreateFromPlatformHandle(
+        offer->capacity, std::move(ring_handle));
+    if (!incoming_ring_)
+      return false;
+
+    // The other side wants to use shared memory, so use it in this direction
+    // too.
+    OfferRingBuffer();
+    return ReadIncomingRing();
+  }
+
+  // Dispatches the messages written to the incoming ring, until it is empty or
+  // enough was read for now. Returns false on error.
+  bool ReadIncomingRing() {
+    DCHECK(io_task_runner_->RunsTasksOnCurrentThread());
+    if (!incoming_ring_)
+      return true;
+
+    size_t next_read_size = 0;
+    size_t total_bytes_read = 0;
+    for (;;) {
+      size_t buffer_capacity = std::max(next_read_size, kRingBufferReadSize);
+      char* buffer = GetSecondaryReadBuffer(&buffer_capacity);
+      size_t bytes_read = 0;
+      if (!incoming_ring_->Read(buffer, buffer_capacity, &bytes_read))
+        return false;
+      // This also retries messages whose handles were missing so far.
+      if (!OnSecondaryReadComplete(bytes_read, &next_read_size))
+        return false;
+
+      if (!bytes_read) {
+        // Only ask to be woken up once the ring is found empty. A writer that
+        // keeps the ring busy sends no wakeups at all.
+        if (incoming_ring_->PrepareToWaitForRead())
+          break;
+        continue;
+      }
+
+      total_bytes_read += bytes_read;
+      if (total_bytes_read >= kMaxBatchReadCapacity) {
+        // Let other tasks run before reading more.
+        io_task_runner_->PostTask(
+            FROM_HERE,
+            base::Bind(&ChannelPosix::ReadIncomingRingOnIOThread, this));
+        break;
+      }
+    }
+
+    // Wake the writer up if it is waiting for the room just made.
+    if (incoming_ring_->TakeWriterWaiting())
+      return SendRingBufferWakeUp();
+    return true;
+  }
+
+  void ReadIncomingRingOnIOThread() {
+    if (!read_watcher_)
+      return;
+    if (!ReadIncomingRing()) {
+      read_watcher_.reset();
+      OnError();
+    }
+  }
+
+  bool SendRingBufferWakeUp() {
+    bool write_error = false;
+    {
+      base::AutoLock lock(write_lock_);
+      if (reject_writes_)
+        return true;
+      if (!WriteRingBufferWakeUpNoLock(nullptr))
+        reject_writes_ = write_error = true;
+    }
+    return !write_error;
+  }
+
+  // Writes the messages waiting for room in the outgoing ring. Returns false
+  // on error.
+  bool FlushOutgoingRing() {
+    base::AutoLock lock(write_lock_);
+    if (!outgoing_ring_ || reject_writes_)
+      return true;
+    if (!FlushOutgoingRingNoLock())
+      reject_writes_ = true;
+    return !reject_writes_;
+  }
+
   void OnFileCanWriteWithoutBlocking(int fd) override {
     bool write_error = false;
     {
@@ -306,6 +477,59 @@ class ChannelPosix : public Channel,
       OnError();
   }
 
+  bool WriteToSocketNoLock(MessageView message_view) {
+    if (outgoing_messages_.empty())
+      return WriteNoLock(std::move(message_view));
+    outgoing_messages_.push_back(std::move(message_view));
+    return true;
+  }
+
+  // Queues a message for the outgoing ring and writes as much as possible of
+  // the queue. Its platform handles are sent over the socket right away.
+  bool WriteToRingNoLock(MessageView message_view) {
+    ScopedPlatformHandleVectorPtr handles = message_view.TakeHandles();
+    if (handles && handles->size()) {
+      if (!WriteRingBufferWakeUpNoLock(std::move(handles)))
+        return false;
+    }
+    outgoing_ring_messages_.push_back(std::move(message_view));
+    return FlushOutgoingRingNoLock();
+  }
+
+  bool FlushOutgoingRingNoLock() {
+    while (!outgoing_ring_messages_.empty()) {
+      MessageView& message_view = outgoing_ring_messages_.front();
+      size_t bytes_written = outgoing_ring_->Write(
+          message_view.data(), message_view.data_num_bytes());
+      if (bytes_written == message_view.data_num_bytes()) {
+        outgoing_ring_messages_.pop_front();
+        continue;
+      }
+      if (bytes_written)
+        message_view.advance_data_offset(bytes_written);
+      // The ring is full. The reader sends a wakeup once it has made room.
+      if (outgoing_ring_->PrepareToWaitForWrite(1))
+        break;
+    }
+
+    // A reader that is busy reading gets no wakeup, so wakeups are naturally
+    // batched under load.
+    if (outgoing_ring_->TakeReaderWaiting())
+      return WriteRingBufferWakeUpNoLock(nullptr);
+    return true;
+  }
+
+  // Sends a RING_BUFFER_WAKEUP message over the socket, carrying |handles| if
+  // not null.
+  bool WriteRingBufferWakeUpNoLock(ScopedPlatformHandleVectorPtr handles) {
+    MessageView message_view(
+        MessagePtr(new Channel::Message(
+            0, 0, Message::Header::MessageType::RING_BUFFER_WAKEUP)),
+        0);
+    message_view.SetHandles(std::move(handles));
+    return WriteToSocketNoLock(std::move(message_view));
+  }
+
   // Attempts to write a message directly to the channel. If the full message
   // cannot be written, it's queued and a wait is initiated to write the message
   // ASAP on the I/O thread.
@@ -400,12 +624,27 @@ class ChannelPosix : public Channel,
     return true;
   }
 
-#if defined(OS_MACOSX)
   bool OnControlMessage(Message::Header::MessageType message_type,
                         const void* payload,
                         size_t payload_size,
                         ScopedPlatformHandleVectorPtr handles) override {
+    if (!accept_ring_buffer_ &&
+        (message_type == Message::Header::MessageType::RING_BUFFER_OFFER ||
+         message_type == Message::Header::MessageType::RING_BUFFER_WAKEUP)) {
+      LOG(ERROR) << "Unexpected shared memory transport message";
+      return false;
+    }
+
     switch (message_type) {
+      case Message::Header::MessageType::RING_BUFFER_OFFER:
+        return AcceptRingBuffer(payload, payload_size, std::move(handles));
+
+      case Message::Header::MessageType::RING_BUFFER_WAKEUP:
+        if (payload_size)
+          break;
+        return ReadIncomingRing() && FlushOutgoingRing();
+
+#if defined(OS_MACOSX)
       case Message::Header::MessageType::HANDLES_SENT: {
         if (payload_size == 0)
           break;
@@ -426,6 +665,7 @@ class ChannelPosix : public Channel,
           break;
         return true;
       }
+#endif  // defined(OS_MACOSX)
 
       default:
         break;
@@ -434,6 +674,7 @@ class ChannelPosix : public Channel,
     return false;
   }
 
+#if defined(OS_MACOSX)
   // Closes handles referenced by |fds|. Returns false if |num_fds| is 0, or if
   // |fds| does not match a sequence of handles in |handles_to_close_|.
   bool CloseHandles(const int* fds, size_t num_fds) {
@@ -479,12 +720,30 @@ class ChannelPosix : public Channel,
 
   std::deque<PlatformHandle> incoming_platform_handles_;
 
-  // Protects |pending_write_| and |outgoing_messages_|.
+  // Whether EnableSharedMemoryTransport() was called.
+  bool offer_ring_buffer_on_start_ = false;
+
+  // Whether the other side may switch to shared memory. Only ever set before
+  // Start().
+  bool accept_ring_buffer_ = false;
+
+  // The ring the other side writes its messages to. Only accessed on the IO
+  // thread.
+  std::unique_ptr<SharedRingBuffer> incoming_ring_;
+
+  // Protects |pending_write_|, |outgoing_messages_|, |outgoing_ring_| and
+  // |outgoing_ring_messages_|.
   base::Lock write_lock_;
   bool pending_write_ = false;
   bool reject_writes_ = false;
   std::deque<MessageView> outgoing_messages_;
 
+  // Once set, messages are written to this ring instead of the socket, which
+  // only carries their platform handles and wakeups. Messages that do not fit
+  // wait in |outgoing_ring_messages_|.
+  std::unique_ptr<SharedRingBuffer> outgoing_ring_;
+  std::deque<MessageView> outgoing_ring_messages_;
+
 #if defined(OS_MACOSX)
   base::Lock handles_to_close_lock_;
   ScopedPlatformHandleVectorPtr handles_to_close_;
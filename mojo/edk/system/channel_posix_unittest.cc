@@ -0,0 +1,232 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/channel.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "mojo/edk/embedder/platform_channel_pair.h"
+#include "mojo/edk/embedder/platform_handle_vector.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace edk {
+namespace {
+
+// Records the messages a Channel receives, and signals once it has received
+// the expected number of them or got an error.
+class TestChannelDelegate : public Channel::Delegate {
+ public:
+  explicit TestChannelDelegate(size_t expected_messages)
+      : expected_messages_(expected_messages),
+        error_(false),
+        done_(false /* manual_reset */, false /* initially_signaled */) {}
+  ~TestChannelDelegate() override {}
+
+  // Waits until done, and returns whether there was no error.
+  bool Wait() {
+    done_.Wait();
+    return !error_;
+  }
+
+  const std::vector<std::string>& payloads() const { return payloads_; }
+  const std::vector<size_t>& num_handles() const { return num_handles_; }
+
+  // Channel::Delegate:
+  void OnChannelMessage(const void* payload,
+                        size_t payload_size,
+                        ScopedPlatformHandleVectorPtr handles) override {
+    payloads_.push_back(
+        std::string(static_cast<const char*>(payload), payload_size));
+    num_handles_.push_back(handles ? handles->size() : 0);
+    if (payloads_.size() == expected_messages_)
+      done_.Signal();
+  }
+
+  void OnChannelError() override {
+    error_ = true;
+    done_.Signal();
+  }
+
+ private:
+  const size_t expected_messages_;
+  std::vector<std::string> payloads_;
+  std::vector<size_t> num_handles_;
+  bool error_;
+  base::WaitableEvent done_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestChannelDelegate);
+};
+
+// Returns a payload of |size| bytes that differs for each |index|.
+std::string MakePayload(size_t index, size_t size) {
+  std::string payload(size, static_cast<char>('a' + index % 26));
+  std::string prefix = base::StringPrintf("%zu:", index);
+  payload.replace(0, std::min(prefix.size(), size), prefix, 0, size);
+  return payload;
+}
+
+Channel::MessagePtr CreateMessage(const std::string& payload,
+                                  ScopedPlatformHandleVectorPtr handles) {
+  Channel::MessagePtr message(
+      new Channel::Message(payload.size(), handles ? handles->size() : 0));
+  memcpy(message->mutable_payload(), payload.data(), payload.size());
+  if (handles)
+    message->SetHandles(std::move(handles));
+  return message;
+}
+
+class ChannelPosixTest : public testing::Test {
+ public:
+  ChannelPosixTest() : io_thread_("ChannelPosixTest") {}
+
+  void SetUp() override {
+    ASSERT_TRUE(io_thread_.StartWithOptions(
+        base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+  }
+
+  void TearDown() override {
+    // Runs the shutdown tasks posted by Channel::ShutDown().
+    io_thread_.Stop();
+  }
+
+  // Creates the two ends of a Channel over a socket pair.
+  void CreateChannels(Channel::Delegate* delegate_a,
+                      Channel::Delegate* delegate_b) {
+    PlatformChannelPair channel_pair;
+    channel_a_ = Channel::Create(delegate_a, channel_pair.PassServerHandle(),
+                                 io_thread_.task_runner());
+    channel_b_ = Channel::Create(delegate_b, channel_pair.PassClientHandle(),
+                                 io_thread_.task_runner());
+  }
+
+  // Waits for the tasks already posted to the I/O thread to run.
+  void FlushIOThread() {
+    base::WaitableEvent event(false /* manual_reset */,
+                              false /* initially_signaled */);
+    io_thread_.task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&base::WaitableEvent::Signal, base::Unretained(&event)));
+    event.Wait();
+  }
+
+  void ShutDownChannels() {
+    channel_a_->ShutDown();
+    channel_b_->ShutDown();
+  }
+
+ protected:
+  base::Thread io_thread_;
+  scoped_refptr<Channel> channel_a_;
+  scoped_refptr<Channel> channel_b_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ChannelPosixTest);
+};
+
+// Sends messages both ways after one end offers the shared memory transport
+// and the other only accepts it. The messages are larger than the rings in
+// total, and some larger than a ring each, so readers and writers both have to
+// be woken up; some carry a handle, which goes with a wakeup.
+TEST_F(ChannelPosixTest, SharedMemoryTransport) {
+  const size_t kMessageSizes[] = {1, 64, 16 * 1024, 300 * 1024, 1024 * 1024};
+  const size_t kMessagesPerSize = 20;
+  const size_t kNumMessages = arraysize(kMessageSizes) * kMessagesPerSize;
+
+  TestChannelDelegate delegate_a(kNumMessages);
+  TestChannelDelegate delegate_b(kNumMessages);
+  CreateChannels(&delegate_a, &delegate_b);
+  channel_a_->EnableSharedMemoryTransport();
+  channel_b_->AcceptSharedMemoryTransport();
+  channel_a_->Start();
+  channel_b_->Start();
+  // Lets |channel_a_| make its offer, so that it writes to its ring from the
+  // first message on.
+  FlushIOThread();
+
+  std::vector<std::string> payloads;
+  for (size_t i = 0; i < kNumMessages; i++) {
+    payloads.push_back(
+        MakePayload(i, kMessageSizes[i % arraysize(kMessageSizes)]));
+  }
+  for (size_t i = 0; i < kNumMessages; i++) {
+    for (Channel* channel : {channel_a_.get(), channel_b_.get()}) {
+      ScopedPlatformHandleVectorPtr handles;
+      if (i % 7 == 0) {
+        PlatformChannelPair handle_pair;
+        handles.reset(new PlatformHandleVector(1));
+        handles->at(0) = handle_pair.PassServerHandle().release();
+      }
+      channel->Write(CreateMessage(payloads[i], std::move(handles)));
+    }
+  }
+
+  EXPECT_TRUE(delegate_a.Wait());
+  EXPECT_TRUE(delegate_b.Wait());
+  ShutDownChannels();
+
+  for (const TestChannelDelegate* delegate : {&delegate_a, &delegate_b}) {
+    ASSERT_EQ(kNumMessages, delegate->payloads().size());
+    for (size_t i = 0; i < kNumMessages; i++) {
+      EXPECT_EQ(payloads[i], delegate->payloads()[i]) << "message " << i;
+      EXPECT_EQ(i % 7 == 0 ? 1u : 0u, delegate->num_handles()[i])
+          << "message " << i;
+    }
+  }
+}
+
+// Control messages written once the shared memory transport is in use still go
+// over the socket: the reader treats one found in the ring as an error.
+TEST_F(ChannelPosixTest, ControlMessagesBypassSharedMemoryTransport) {
+  TestChannelDelegate delegate_a(1);
+  TestChannelDelegate delegate_b(1);
+  CreateChannels(&delegate_a, &delegate_b);
+  channel_a_->EnableSharedMemoryTransport();
+  channel_b_->AcceptSharedMemoryTransport();
+  channel_a_->Start();
+  channel_b_->Start();
+  FlushIOThread();
+
+  channel_a_->Write(Channel::MessagePtr(new Channel::Message(
+      0, 0, Channel::Message::Header::MessageType::RING_BUFFER_WAKEUP)));
+  channel_a_->Write(CreateMessage("hello", nullptr));
+
+  EXPECT_TRUE(delegate_b.Wait());
+  ShutDownChannels();
+  ASSERT_EQ(1u, delegate_b.payloads().size());
+  EXPECT_EQ("hello", delegate_b.payloads()[0]);
+}
+
+// A Channel that was not told to accept the shared memory transport, like the
+// broker's, treats an offer of it as an error.
+TEST_F(ChannelPosixTest, SharedMemoryTransportNotAccepted) {
+  TestChannelDelegate delegate_a(1);
+  TestChannelDelegate delegate_b(1);
+  CreateChannels(&delegate_a, &delegate_b);
+  channel_a_->EnableSharedMemoryTransport();
+  channel_a_->Start();
+  channel_b_->Start();
+
+  EXPECT_FALSE(delegate_b.Wait());
+  EXPECT_TRUE(delegate_b.payloads().empty());
+  ShutDownChannels();
+}
+
+}  // namespace
+}  // namespace edk
+}  // namespace mojo
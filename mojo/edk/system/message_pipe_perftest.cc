@@ -5,18 +5,24 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "base/auto_reset.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/strings/stringprintf.h"
+#include "base/test/perf_log.h"
 #include "base/test/perf_time_logger.h"
 #include "base/threading/thread.h"
+#include "base/time/time.h"
 #include "mojo/edk/embedder/embedder.h"
 #include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/handle_signals_state.h"
 #include "mojo/edk/system/test_utils.h"
 #include "mojo/edk/test/mojo_test_base.h"
@@ -78,6 +84,32 @@ class MessagePipePerfTest : public test::MojoTestBase {
     logger.Done();
   }
 
+  // Logs the 99th percentile of the round trip times, and the number of bytes
+  // moved per second in both directions.
+  void MeasureLatencyAndThroughput(MojoHandle mp, const std::string& label) {
+    WriteWaitThenRead(mp);
+
+    std::vector<base::TimeDelta> round_trip_times(message_count_);
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    for (int i = 0; i < message_count_; ++i) {
+      base::TimeTicks round_trip_start_time = base::TimeTicks::Now();
+      WriteWaitThenRead(mp);
+      round_trip_times[i] = base::TimeTicks::Now() - round_trip_start_time;
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+    std::sort(round_trip_times.begin(), round_trip_times.end());
+    base::TimeDelta p99 = round_trip_times[message_count_ * 99 / 100];
+    std::string test_name =
+        base::StringPrintf("IPC_Perf_%s_%u", label.c_str(),
+                           static_cast<unsigned>(message_size_));
+    base::LogPerfResult((test_name + "_p99_round_trip").c_str(),
+                        static_cast<double>(p99.InMicroseconds()), "us");
+    double megabytes = 2.0 * message_count_ * message_size_ / (1024 * 1024);
+    base::LogPerfResult((test_name + "_throughput").c_str(),
+                        megabytes / elapsed.InSecondsF(), "MB/s");
+  }
+
  protected:
   void RunPingPongServer(MojoHandle mp) {
     // This values are set to align with one at ipc_pertests.cc for comparison.
@@ -92,8 +124,21 @@ class MessagePipePerfTest : public test::MojoTestBase {
     SendQuitMessage(mp);
   }
 
+  // Compares how the transport does for message sizes from 64 bytes to 1MB.
+  void RunLatencyAndThroughputServer(MojoHandle mp, const std::string& label) {
+    const size_t kMsgSize[5] = {64, 1024, 16 * 1024, 256 * 1024, 1024 * 1024};
+    const int kMessageCount[5] = {20000, 20000, 10000, 2000, 500};
+
+    for (size_t i = 0; i < 5; i++) {
+      SetUpMeasurement(kMessageCount[i], kMsgSize[i]);
+      MeasureLatencyAndThroughput(mp, label);
+    }
+
+    SendQuitMessage(mp);
+  }
+
   static int RunPingPongClient(MojoHandle mp) {
-    std::string buffer(1000000, '\0');
+    std::string buffer(2 * 1024 * 1024, '\0');
     int rv = 0;
     while (true) {
       // Wait for our end of the message pipe to be readable.
@@ -165,6 +210,23 @@ TEST_F(MessagePipePerfTest, MultiprocessPingPong) {
   END_CHILD()
 }
 
+TEST_F(MessagePipePerfTest, MultiprocessLatencyAndThroughput) {
+  RUN_CHILD_ON_PIPE(PingPongClient, h)
+    RunLatencyAndThroughputServer(h, "socket");
+  END_CHILD()
+}
+
+// Same as above, with messages going through shared memory rings between the
+// two processes.
+TEST_F(MessagePipePerfTest, MultiprocessLatencyAndThroughputSharedMemory) {
+  // Restored even if the test fails halfway, so later tests use the socket.
+  base::AutoReset<bool> use_shared_memory(
+      &GetMutableConfiguration()->use_shared_memory_channel_transport, true);
+  RUN_CHILD_ON_PIPE(PingPongClient, h)
+    RunLatencyAndThroughputServer(h, "shared_memory");
+  END_CHILD()
+}
+
 }  // namespace
 }  // namespace edk
 }  // namespace mojo
@@ -0,0 +1,222 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/shared_ring_buffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "build/build_config.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
+
+#if defined(OS_ANDROID)
+#include "third_party/ashmem/ashmem.h"
+#elif defined(OS_POSIX)
+#include <sys/stat.h>
+#endif
+
+namespace mojo {
+namespace edk {
+
+namespace {
+
+const size_t kCacheLineSize = 64;
+
+// Returns whether the shared memory behind |handle| spans at least |num_bytes|.
+// Mapping more than that succeeds on POSIX, but touching the pages past its
+// end raises SIGBUS.
+bool HasSize(const PlatformHandle& handle, size_t num_bytes) {
+#if defined(OS_MACOSX) && !defined(OS_IOS)
+  // Mapping a Mach memory object fails if it is too small.
+  if (handle.type != PlatformHandle::Type::POSIX)
+    return true;
+#endif
+#if defined(OS_ANDROID)
+  int size = ashmem_get_size_region(handle.handle);
+  return size >= 0 && static_cast<size_t>(size) >= num_bytes;
+#elif defined(OS_POSIX)
+  struct stat st;
+  if (fstat(handle.handle, &st) != 0 || st.st_size < 0)
+    return false;
+  return static_cast<uint64_t>(st.st_size) >= num_bytes;
+#else
+  // Mapping a view larger than its section fails.
+  return true;
+#endif
+}
+
+}  // namespace
+
+// The start of the shared memory. Each side only writes to its own cache line,
+// except for clearing the waiting flag of the other side.
+struct SharedRingBuffer::Header {
+  // Number of bytes written so far, modulo 2^32.
+  base::subtle::Atomic32 write_count;
+  base::subtle::Atomic32 writer_waiting;
+  char writer_padding[kCacheLineSize - 2 * sizeof(base::subtle::Atomic32)];
+
+  // Number of bytes read so far, modulo 2^32.
+  base::subtle::Atomic32 read_count;
+  base::subtle::Atomic32 reader_waiting;
+  char reader_padding[kCacheLineSize - 2 * sizeof(base::subtle::Atomic32)];
+};
+
+SharedRingBuffer::SharedRingBuffer(
+    scoped_refptr<PlatformSharedBuffer> buffer,
+    std::unique_ptr<PlatformSharedBufferMapping> mapping,
+    size_t capacity)
+    : buffer_(std::move(buffer)),
+      mapping_(std::move(mapping)),
+      capacity_(capacity),
+      header_(static_cast<Header*>(mapping_->GetBase())),
+      data_(static_cast<char*>(mapping_->GetBase()) + sizeof(Header)) {
+  static_assert(sizeof(Header) == 2 * kCacheLineSize,
+                "Header must span two cache lines");
+}
+
+SharedRingBuffer::~SharedRingBuffer() {}
+
+// static
+std::unique_ptr<SharedRingBuffer> SharedRingBuffer::Create(size_t capacity) {
+  DCHECK(IsValidCapacity(capacity));
+  scoped_refptr<PlatformSharedBuffer> buffer(
+      PlatformSharedBuffer::Create(sizeof(Header) + capacity));
+  if (!buffer)
+    return nullptr;
+  return Map(std::move(buffer), capacity);
+}
+
+// static
+std::unique_ptr<SharedRingBuffer> SharedRingBuffer::CreateFromPlatformHandle(
+    size_t capacity,
+    ScopedPlatformHandle handle) {
+  if (!IsValidCapacity(capacity))
+    return nullptr;
+  if (!handle.is_valid() || !HasSize(handle.get(), sizeof(Header) + capacity)) {
+    LOG(ERROR) << "Shared ring buffer is smaller than its capacity";
+    return nullptr;
+  }
+  scoped_refptr<PlatformSharedBuffer> buffer(
+      PlatformSharedBuffer::CreateFromPlatformHandle(
+          sizeof(Header) + capacity, false /* read_only */, std::move(handle)));
+  if (!buffer)
+    return nullptr;
+  return Map(std::move(buffer), capacity);
+}
+
+// static
+bool SharedRingBuffer::IsValidCapacity(size_t capacity) {
+  return capacity > 0 && capacity <= kMaxCapacity &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+// static
+std::unique_ptr<SharedRingBuffer> SharedRingBuffer::Map(
+    scoped_refptr<PlatformSharedBuffer> buffer,
+    size_t capacity) {
+  std::unique_ptr<PlatformSharedBufferMapping> mapping =
+      buffer->Map(0, sizeof(Header) + capacity);
+  if (!mapping)
+    return nullptr;
+  return std::unique_ptr<SharedRingBuffer>(
+      new SharedRingBuffer(std::move(buffer), std::move(mapping), capacity));
+}
+
+ScopedPlatformHandle SharedRingBuffer::DuplicatePlatformHandle() {
+  return buffer_->DuplicatePlatformHandle();
+}
+
+size_t SharedRingBuffer::Write(const void* data, size_t num_bytes) {
+  num_bytes = std::min(num_bytes, GetWriteSpace());
+  if (!num_bytes)
+    return 0;
+
+  size_t offset = local_count_ & (capacity_ - 1);
+  size_t num_bytes_before_end = std::min(num_bytes, capacity_ - offset);
+  memcpy(data_ + offset, data, num_bytes_before_end);
+  memcpy(data_, static_cast<const char*>(data) + num_bytes_before_end,
+         num_bytes - num_bytes_before_end);
+
+  local_count_ += static_cast<uint32_t>(num_bytes);
+  base::subtle::Release_Store(
+      &header_->write_count, static_cast<base::subtle::Atomic32>(local_count_));
+  return num_bytes;
+}
+
+size_t SharedRingBuffer::GetWriteSpace() const {
+  uint32_t read_count = static_cast<uint32_t>(
+      base::subtle::Acquire_Load(&header_->read_count));
+  uint32_t num_used_bytes = local_count_ - read_count;
+  // A reader that claims to have read bytes that were never written can only
+  // hurt itself; just stop writing to it.
+  if (num_used_bytes > capacity_)
+    return 0;
+  return capacity_ - num_used_bytes;
+}
+
+bool SharedRingBuffer::TakeReaderWaiting() {
+  // The write count must be visible before the flag is checked, or a reader
+  // setting the flag concurrently could miss the bytes just written.
+  base::subtle::MemoryBarrier();
+  return base::subtle::NoBarrier_AtomicExchange(&header_->reader_waiting, 0) !=
+         0;
+}
+
+bool SharedRingBuffer::PrepareToWaitForWrite(size_t num_bytes) {
+  base::subtle::NoBarrier_Store(&header_->writer_waiting, 1);
+  base::subtle::MemoryBarrier();
+  if (GetWriteSpace() < num_bytes)
+    return true;
+  base::subtle::NoBarrier_Store(&header_->writer_waiting, 0);
+  return false;
+}
+
+bool SharedRingBuffer::Read(void* buffer,
+                            size_t buffer_capacity,
+                            size_t* bytes_read) {
+  uint32_t write_count = static_cast<uint32_t>(
+      base::subtle::Acquire_Load(&header_->write_count));
+  uint32_t num_used_bytes = write_count - local_count_;
+  if (num_used_bytes > capacity_) {
+    DLOG(ERROR) << "Invalid ring buffer write count";
+    return false;
+  }
+
+  size_t num_bytes = std::min<size_t>(num_used_bytes, buffer_capacity);
+  size_t offset = local_count_ & (capacity_ - 1);
+  size_t num_bytes_before_end = std::min(num_bytes, capacity_ - offset);
+  memcpy(buffer, data_ + offset, num_bytes_before_end);
+  memcpy(static_cast<char*>(buffer) + num_bytes_before_end, data_,
+         num_bytes - num_bytes_before_end);
+
+  local_count_ += static_cast<uint32_t>(num_bytes);
+  base::subtle::Release_Store(
+      &header_->read_count, static_cast<base::subtle::Atomic32>(local_count_));
+  *bytes_read = num_bytes;
+  return true;
+}
+
+bool SharedRingBuffer::TakeWriterWaiting() {
+  base::subtle::MemoryBarrier();
+  return base::subtle::NoBarrier_AtomicExchange(&header_->writer_waiting, 0) !=
+         0;
+}
+
+bool SharedRingBuffer::PrepareToWaitForRead() {
+  base::subtle::NoBarrier_Store(&header_->reader_waiting, 1);
+  base::subtle::MemoryBarrier();
+  uint32_t write_count = static_cast<uint32_t>(
+      base::subtle::Acquire_Load(&header_->write_count));
+  if (write_count == local_count_)
+    return true;
+  base::subtle::NoBarrier_Store(&header_->reader_waiting, 0);
+  return false;
+}
+
+}  // namespace edk
+}  // namespace mojo
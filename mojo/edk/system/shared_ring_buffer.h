@@ -0,0 +1,118 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
+#define MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/system_impl_export.h"
+
+namespace mojo {
+namespace edk {
+
+class PlatformSharedBuffer;
+class PlatformSharedBufferMapping;
+
+// SharedRingBuffer is a single-producer single-consumer byte stream in shared
+// memory. One process writes to it and another one reads from it, without any
+// system call as long as neither side has to wait for the other.
+//
+// The ring does not signal anything by itself. A side that finds nothing to
+// do calls PrepareToWaitForRead() or PrepareToWaitForWrite(), and the other
+// side checks with TakeReaderWaiting() or TakeWriterWaiting() whether it must
+// wake it up through some other means. Since the flags are only set by a side
+// that is about to go idle, a busy reader or writer costs its peer no wakeups.
+//
+// The peer is not trusted: only the counters are read from shared memory, and
+// they are checked before use. Bytes are always copied out of the ring, so the
+// peer cannot modify them once they have been read.
+class MOJO_SYSTEM_IMPL_EXPORT SharedRingBuffer {
+ public:
+  // Largest ring capacity accepted from a peer.
+  static const size_t kMaxCapacity = 16 * 1024 * 1024;
+
+  ~SharedRingBuffer();
+
+  // Creates a new ring with room for |capacity| bytes, which must be a power
+  // of two no larger than kMaxCapacity. Returns null on failure.
+  static std::unique_ptr<SharedRingBuffer> Create(size_t capacity);
+
+  // Maps a ring created by Create(), possibly in another process, from a
+  // handle returned by DuplicatePlatformHandle(). Returns null if |capacity|
+  // is not valid, the memory is smaller than the ring, or it cannot be mapped.
+  static std::unique_ptr<SharedRingBuffer> CreateFromPlatformHandle(
+      size_t capacity,
+      ScopedPlatformHandle handle);
+
+  size_t capacity() const { return capacity_; }
+
+  // Returns a handle to the shared memory of the ring to send to the peer.
+  ScopedPlatformHandle DuplicatePlatformHandle();
+
+  // Writer side. Copies as many of the |num_bytes| bytes at |data| as there is
+  // room for and returns how many were copied.
+  size_t Write(const void* data, size_t num_bytes);
+
+  // Writer side. Returns the number of bytes that can be written right now.
+  size_t GetWriteSpace() const;
+
+  // Writer side. Returns true if the reader went idle since the last call, in
+  // which case it must be woken up to read what was written since.
+  bool TakeReaderWaiting();
+
+  // Writer side. Flags the writer as waiting for the reader to make room, and
+  // returns true if there is still less than |num_bytes| of room. Returns
+  // false, without leaving the flag set, if the writer can keep writing.
+  bool PrepareToWaitForWrite(size_t num_bytes);
+
+  // Reader side. Copies up to |buffer_capacity| bytes to |buffer| and returns
+  // how many were copied. Returns false if the peer corrupted the ring.
+  bool Read(void* buffer, size_t buffer_capacity, size_t* bytes_read);
+
+  // Reader side. Returns true if the writer went idle waiting for room since
+  // the last call, in which case it must be woken up.
+  bool TakeWriterWaiting();
+
+  // Reader side. Flags the reader as waiting for data, and returns true if the
+  // ring is still empty. Returns false, without leaving the flag set, if there
+  // is data to read.
+  bool PrepareToWaitForRead();
+
+ private:
+  struct Header;
+
+  SharedRingBuffer(scoped_refptr<PlatformSharedBuffer> buffer,
+                   std::unique_ptr<PlatformSharedBufferMapping> mapping,
+                   size_t capacity);
+
+  static bool IsValidCapacity(size_t capacity);
+  static std::unique_ptr<SharedRingBuffer> Map(
+      scoped_refptr<PlatformSharedBuffer> buffer,
+      size_t capacity);
+
+  const scoped_refptr<PlatformSharedBuffer> buffer_;
+  const std::unique_ptr<PlatformSharedBufferMapping> mapping_;
+  const size_t capacity_;
+  Header* const header_;
+  char* const data_;
+
+  // The local copy of the counter owned by this side. The copy in shared
+  // memory is only written, never read back, so that the peer cannot make
+  // this side read or write out of order.
+  uint32_t local_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRingBuffer);
+};
+
+}  // namespace edk
+}  // namespace mojo
+
+#endif  // MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
@@ -0,0 +1,138 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/shared_ring_buffer.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace edk {
+namespace {
+
+const size_t kCapacity = 64;
+
+class SharedRingBufferTest : public testing::Test {
+ public:
+  SharedRingBufferTest() {}
+
+  void SetUp() override {
+    writer_ = SharedRingBuffer::Create(kCapacity);
+    ASSERT_TRUE(writer_);
+    reader_ = SharedRingBuffer::CreateFromPlatformHandle(
+        kCapacity, writer_->DuplicatePlatformHandle());
+    ASSERT_TRUE(reader_);
+  }
+
+  std::string Read(size_t buffer_capacity) {
+    std::string buffer(buffer_capacity, '\0');
+    size_t bytes_read = 0;
+    EXPECT_TRUE(reader_->Read(&buffer[0], buffer_capacity, &bytes_read));
+    buffer.resize(bytes_read);
+    return buffer;
+  }
+
+ protected:
+  std::unique_ptr<SharedRingBuffer> writer_;
+  std::unique_ptr<SharedRingBuffer> reader_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SharedRingBufferTest);
+};
+
+TEST_F(SharedRingBufferTest, WriteThenRead) {
+  EXPECT_EQ(kCapacity, writer_->GetWriteSpace());
+  EXPECT_EQ(5u, writer_->Write("hello", 5));
+  EXPECT_EQ(kCapacity - 5, writer_->GetWriteSpace());
+
+  EXPECT_EQ("hel", Read(3));
+  EXPECT_EQ("lo", Read(10));
+  EXPECT_EQ("", Read(10));
+  EXPECT_EQ(kCapacity, writer_->GetWriteSpace());
+}
+
+TEST_F(SharedRingBufferTest, WrapsAround) {
+  std::string data(kCapacity - 8, 'a');
+  EXPECT_EQ(data.size(), writer_->Write(data.data(), data.size()));
+  EXPECT_EQ(data, Read(kCapacity));
+
+  // The next writes cross the end of the ring.
+  for (int i = 0; i < 10; ++i) {
+    std::string chunk(kCapacity / 2 + i, static_cast<char>('a' + i));
+    EXPECT_EQ(chunk.size(), writer_->Write(chunk.data(), chunk.size()));
+    EXPECT_EQ(chunk, Read(kCapacity));
+  }
+}
+
+TEST_F(SharedRingBufferTest, WritesOnlyWhatFits) {
+  std::string data(kCapacity + 10, 'x');
+  EXPECT_EQ(kCapacity, writer_->Write(data.data(), data.size()));
+  EXPECT_EQ(0u, writer_->GetWriteSpace());
+  EXPECT_EQ(0u, writer_->Write(data.data(), data.size()));
+
+  EXPECT_EQ(std::string(10, 'x'), Read(10));
+  EXPECT_EQ(10u, writer_->Write(data.data(), data.size()));
+  EXPECT_EQ(std::string(kCapacity, 'x'), Read(data.size()));
+}
+
+TEST_F(SharedRingBufferTest, ReaderWaiting) {
+  // Nothing to wake up until the reader goes idle.
+  EXPECT_EQ(1u, writer_->Write("a", 1));
+  EXPECT_FALSE(writer_->TakeReaderWaiting());
+
+  // The reader cannot go idle while there is data.
+  EXPECT_FALSE(reader_->PrepareToWaitForRead());
+  EXPECT_FALSE(writer_->TakeReaderWaiting());
+
+  EXPECT_EQ("a", Read(1));
+  EXPECT_TRUE(reader_->PrepareToWaitForRead());
+  EXPECT_EQ(1u, writer_->Write("b", 1));
+  EXPECT_TRUE(writer_->TakeReaderWaiting());
+
+  // A single wakeup covers all the writes made since.
+  EXPECT_EQ(1u, writer_->Write("c", 1));
+  EXPECT_FALSE(writer_->TakeReaderWaiting());
+  EXPECT_EQ("bc", Read(10));
+}
+
+TEST_F(SharedRingBufferTest, WriterWaiting) {
+  std::string data(kCapacity, 'x');
+  EXPECT_EQ(kCapacity - 2, writer_->Write(data.data(), kCapacity - 2));
+
+  // The writer cannot go idle while there is enough room.
+  EXPECT_FALSE(writer_->PrepareToWaitForWrite(2));
+  EXPECT_FALSE(reader_->TakeWriterWaiting());
+
+  EXPECT_TRUE(writer_->PrepareToWaitForWrite(3));
+  EXPECT_EQ(std::string(1, 'x'), Read(1));
+  EXPECT_TRUE(reader_->TakeWriterWaiting());
+  EXPECT_FALSE(reader_->TakeWriterWaiting());
+}
+
+TEST_F(SharedRingBufferTest, RejectsInvalidCapacity) {
+  EXPECT_FALSE(SharedRingBuffer::CreateFromPlatformHandle(
+      0, writer_->DuplicatePlatformHandle()));
+  EXPECT_FALSE(SharedRingBuffer::CreateFromPlatformHandle(
+      kCapacity + 1, writer_->DuplicatePlatformHandle()));
+  EXPECT_FALSE(SharedRingBuffer::CreateFromPlatformHandle(
+      2 * SharedRingBuffer::kMaxCapacity, writer_->DuplicatePlatformHandle()));
+}
+
+// A capacity larger than the shared memory is rejected rather than mapped past
+// the end of the memory.
+TEST_F(SharedRingBufferTest, RejectsCapacityLargerThanMemory) {
+  EXPECT_FALSE(SharedRingBuffer::CreateFromPlatformHandle(
+      2 * kCapacity, writer_->DuplicatePlatformHandle()));
+  EXPECT_FALSE(SharedRingBuffer::CreateFromPlatformHandle(
+      SharedRingBuffer::kMaxCapacity, writer_->DuplicatePlatformHandle()));
+}
+
+}  // namespace
+}  // namespace edk
+}  // namespace mojo
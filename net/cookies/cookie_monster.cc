@@ -46,6 +46,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <set>
 
@@ -133,6 +134,57 @@ bool ContainsControlCharacter(const std::string& s) {
 
 typedef std::vector<CanonicalCookie*> CanonicalCookieVector;
 
+// The attributes of a cookie that CookieMonster::IndexedCookie holds, to match
+// cookies to requests without loading them.
+enum IndexedCookieFlags : uint8_t {
+  INDEXED_COOKIE_SECURE = 1 << 0,
+  INDEXED_COOKIE_HTTPONLY = 1 << 1,
+  INDEXED_COOKIE_SAME_SITE_LAX = 1 << 2,
+  INDEXED_COOKIE_SAME_SITE_STRICT = 1 << 3,
+};
+
+uint8_t GetIndexedCookieFlags(const CanonicalCookie& cc) {
+  uint8_t flags = 0;
+  if (cc.IsSecure())
+    flags |= INDEXED_COOKIE_SECURE;
+  if (cc.IsHttpOnly())
+    flags |= INDEXED_COOKIE_HTTPONLY;
+  switch (cc.SameSite()) {
+    case CookieSameSite::LAX_MODE:
+      flags |= INDEXED_COOKIE_SAME_SITE_LAX;
+      break;
+    case CookieSameSite::STRICT_MODE:
+      flags |= INDEXED_COOKIE_SAME_SITE_STRICT;
+      break;
+    default:
+      break;
+  }
+  return flags;
+}
+
+// Returns the IndexedCookieFlags of the cookies that must not be included in
+// a request for |url| with |options|, whatever their domain and path. Matches
+// CanonicalCookie::IncludeForRequestURL().
+uint8_t GetExcludedIndexedCookieFlags(const GURL& url,
+                                      const CookieOptions& options) {
+  uint8_t flags = 0;
+  if (options.exclude_httponly())
+    flags |= INDEXED_COOKIE_HTTPONLY;
+  if (!url.SchemeIsCryptographic())
+    flags |= INDEXED_COOKIE_SECURE;
+  switch (options.same_site_cookie_mode()) {
+    case CookieOptions::SameSiteCookieMode::INCLUDE_STRICT_AND_LAX:
+      break;
+    case CookieOptions::SameSiteCookieMode::INCLUDE_LAX:
+      flags |= INDEXED_COOKIE_SAME_SITE_STRICT;
+      break;
+    case CookieOptions::SameSiteCookieMode::DO_NOT_INCLUDE:
+      flags |= INDEXED_COOKIE_SAME_SITE_LAX | INDEXED_COOKIE_SAME_SITE_STRICT;
+      break;
+  }
+  return flags;
+}
+
 // Default minimum delay after updating a cookie's LastAccessDate before we
 // will update it again.
 const int kDefaultAccessUpdateThresholdSeconds = 60;
@@ -1609,23 +1661,33 @@ void CookieMonster::FindCookiesForKey(const std::string& key,
                                       std::vector<CanonicalCookie*>* cookies) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
-  for (CookieMapItPair its = cookies_.equal_range(key);
-       its.first != its.second;) {
-    CookieMap::iterator curit = its.first;
-    CanonicalCookie* cc = curit->second;
-    ++its.first;
+  CookieIndex::iterator index_it = cookies_by_key_.find(key);
+  if (index_it == cookies_by_key_.end())
+    return;
+
+  // GURL returns copies of its components, so only get them once.
+  const std::string host(url.host());
+  const std::string path(url.path());
+  const uint8_t excluded_flags = GetExcludedIndexedCookieFlags(url, options);
+  const int64_t current_value = current.ToInternalValue();
 
+  std::vector<CookieMap::iterator> expired_cookie_its;
+  for (const IndexedCookie& indexed_cookie : index_it->second) {
     // If the cookie is expired, delete it.
-    if (cc->IsExpired(current)) {
-      InternalDeleteCookie(curit, true, DELETE_COOKIE_EXPIRED);
+    if (indexed_cookie.expiry <= current_value) {
+      expired_cookie_its.push_back(indexed_cookie.it);
       continue;
     }
 
     // Filter out cookies that should not be included for a request to the
     // given |url|. HTTP only cookies are filtered depending on the passed
     // cookie |options|.
-    if (!cc->IncludeForRequestURL(url, options))
+    if (indexed_cookie.flags & excluded_flags)
+      continue;
+    CanonicalCookie* cc = indexed_cookie.it->second;
+    if (!cc->IsDomainMatch(host) || !cc->IsOnPath(path))
       continue;
+    DCHECK(cc->IncludeForRequestURL(url, options));
 
     // Add this cookie to the set of matching cookies. Update the access
     // time if we've been requested to do so.
@@ -1634,6 +1696,10 @@ void CookieMonster::FindCookiesForKey(const std::string& key,
     }
     cookies->push_back(cc);
   }
+
+  // Deleting cookies modifies |index_it->second|, so it is done last.
+  for (const CookieMap::iterator& it : expired_cookie_its)
+    InternalDeleteCookie(it, true, DELETE_COOKIE_EXPIRED);
 }
 
 bool CookieMonster::DeleteAnyEquivalentCookie(const std::string& key,
@@ -1716,6 +1782,13 @@ CookieMonster::CookieMap::iterator CookieMonster::InternalInsertCookie(
     store_->AddCookie(*cc);
   CookieMap::iterator inserted =
       cookies_.insert(CookieMap::value_type(key, cc));
+  IndexedCookie indexed_cookie;
+  indexed_cookie.it = inserted;
+  indexed_cookie.expiry = cc->IsPersistent()
+                              ? cc->ExpiryDate().ToInternalValue()
+                              : std::numeric_limits<int64_t>::max();
+  indexed_cookie.flags = GetIndexedCookieFlags(*cc);
+  cookies_by_key_[key].push_back(indexed_cookie);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(*cc, false,
                                CookieMonsterDelegate::CHANGE_COOKIE_EXPLICIT);
@@ -1894,6 +1967,22 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
   RunCookieChangedCallbacks(*cc, true);
+
+  // The order of the cookies of a key does not matter, so the last one takes
+  // the place of the deleted one.
+  CookieIndex::iterator index_it = cookies_by_key_.find(it->first);
+  DCHECK(index_it != cookies_by_key_.end());
+  std::vector<IndexedCookie>& key_cookies = index_it->second;
+  for (size_t i = 0; i < key_cookies.size(); ++i) {
+    if (key_cookies[i].it == it) {
+      key_cookies[i] = key_cookies.back();
+      key_cookies.pop_back();
+      break;
+    }
+  }
+  if (key_cookies.empty())
+    cookies_by_key_.erase(index_it);
+
   cookies_.erase(it);
   delete cc;
 }
@@ -1909,7 +1998,9 @@ size_t CookieMonster::GarbageCollect(const Time& current,
   Time safe_date(Time::Now() - TimeDelta::FromDays(kSafeFromGlobalPurgeDays));
 
   // Collect garbage for this key, minding cookie priorities.
-  if (cookies_.count(key) > kDomainMaxCookies) {
+  CookieIndex::const_iterator index_it = cookies_by_key_.find(key);
+  if (index_it != cookies_by_key_.end() &&
+      index_it->second.size() > kDomainMaxCookies) {
     VLOG(kVlogGarbageCollection) << "GarbageCollect() key: " << key;
 
     CookieItVector* cookie_its;
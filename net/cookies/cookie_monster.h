@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "base/callback_forward.h"
+#include "base/containers/hash_tables.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "base/memory/linked_ptr.h"
@@ -381,6 +382,18 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // Record statistics every kRecordStatisticsIntervalSeconds of uptime.
   static const int kRecordStatisticsIntervalSeconds = 10 * 60;
 
+  // A cookie of |cookies_by_key_|, with the attributes FindCookiesForKey()
+  // checks before looking at the cookie itself.
+  struct IndexedCookie {
+    CookieMap::iterator it;
+    // ExpiryDate().ToInternalValue(), or the largest int64_t for session
+    // cookies.
+    int64_t expiry;
+    // Set of IndexedCookieFlags values.
+    uint8_t flags;
+  };
+  typedef base::hash_map<std::string, std::vector<IndexedCookie>> CookieIndex;
+
   // The following are synchronous calls to which the asynchronous methods
   // delegate either immediately (if the store is loaded) or through a deferred
   // task (if the store is not yet loaded).
@@ -642,6 +655,11 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   CookieMap cookies_;
 
+  // The cookies of |cookies_| grouped by key, in one flat vector per key. Looks
+  // up the cookies for a URL without walking the tree of |cookies_|, and
+  // rejects most of those that do not match it without loading them.
+  CookieIndex cookies_by_key_;
+
   // Indicates whether the cookie store has been initialized.
   bool initialized_;
 
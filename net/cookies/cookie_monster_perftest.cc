@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "base/bind.h"
+#include "base/format_macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
 #include "base/strings/string_util.h"
@@ -97,6 +98,64 @@ class GetCookiesCallback : public BaseCallback {
   CookieOptions options_;
 };
 
+// Fills a CookieMonster with |num_cookies| cookies spread over many domains,
+// like the cookie jar of a single sign-on heavy intranet, and times adding
+// them and querying them.
+void TestLargeCookieJar(size_t num_cookies) {
+  const size_t kCookiesPerDomain = 100;
+  const size_t kNumQueries = 2000;
+
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
+  SetCookieCallback setCookieCallback;
+  GetCookiesCallback getCookiesCallback;
+
+  std::vector<GURL> gurls;
+  for (size_t i = 0; i < num_cookies / kCookiesPerDomain; ++i) {
+    gurls.push_back(
+        GURL(base::StringPrintf("https://www.sso%04" PRIuS ".izzle/app/", i)));
+  }
+
+  std::string suffix = base::StringPrintf("_%" PRIuS, num_cookies);
+  base::PerfTimeLogger timer(("Cookie_monster_add_large_jar" + suffix).c_str());
+  for (const GURL& gurl : gurls) {
+    // Half of the cookies are scoped to the path of the application, and a
+    // quarter are secure.
+    for (size_t i = 0; i < kCookiesPerDomain; ++i) {
+      setCookieCallback.SetCookie(
+          cm.get(), gurl,
+          base::StringPrintf("c%03" PRIuS "=v; path=%s%s", i,
+                             i % 2 ? "/app" : "/", i % 4 ? "" : "; secure"));
+    }
+  }
+  timer.Done();
+  EXPECT_EQ(gurls.size() * kCookiesPerDomain, cm->GetAllCookies().size());
+
+  base::PerfTimeLogger timer2(
+      ("Cookie_monster_query_large_jar" + suffix).c_str());
+  for (size_t i = 0; i < kNumQueries; ++i) {
+    const std::string& cookie_line =
+        getCookiesCallback.GetCookies(cm.get(), gurls[i % gurls.size()]);
+    EXPECT_EQ(static_cast<int>(kCookiesPerDomain),
+              CountInString(cookie_line, '='));
+  }
+  timer2.Done();
+
+  // Requests to insecure URLs and to other paths only match some cookies.
+  base::PerfTimeLogger timer3(
+      ("Cookie_monster_query_large_jar_filtered" + suffix).c_str());
+  for (size_t i = 0; i < kNumQueries; ++i) {
+    GURL::Replacements replacements;
+    replacements.SetSchemeStr("http");
+    replacements.SetPathStr("/other");
+    GURL gurl = gurls[i % gurls.size()].ReplaceComponents(replacements);
+    const std::string& cookie_line =
+        getCookiesCallback.GetCookies(cm.get(), gurl);
+    EXPECT_EQ(static_cast<int>(kCookiesPerDomain / 4),
+              CountInString(cookie_line, '='));
+  }
+  timer3.Done();
+}
+
 }  // namespace
 
 TEST(ParsedCookieTest, TestParseCookies) {
@@ -186,6 +245,14 @@ TEST_F(CookieMonsterTest, TestAddCookieOnManyHosts) {
   timer3.Done();
 }
 
+TEST_F(CookieMonsterTest, TestLargeCookieJar10k) {
+  TestLargeCookieJar(10000);
+}
+
+TEST_F(CookieMonsterTest, TestLargeCookieJar50k) {
+  TestLargeCookieJar(50000);
+}
+
 TEST_F(CookieMonsterTest, TestDomainTree) {
   std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
   GetCookiesCallback getCookiesCallback;
@@ -1690,6 +1690,118 @@ TEST_F(CookieMonsterTest, GetAllCookiesForURLPathMatching) {
   ASSERT_TRUE(++it == cookies.end());
 }
 
+// Tests that looking up the cookies of a key filters them by their secure,
+// httponly and same-site attributes as CanonicalCookie::IncludeForRequestURL()
+// does.
+TEST_F(CookieMonsterTest, IndexedLookupFiltersByAttributes) {
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
+  CookieOptions all_options;
+  all_options.set_include_httponly();
+  all_options.set_same_site_cookie_mode(
+      CookieOptions::SameSiteCookieMode::INCLUDE_STRICT_AND_LAX);
+
+  EXPECT_TRUE(SetCookieWithOptions(cm.get(), https_www_google_.url(), "A=1",
+                                   all_options));
+  EXPECT_TRUE(SetCookieWithOptions(cm.get(), https_www_google_.url(),
+                                   "B=2; secure", all_options));
+  EXPECT_TRUE(SetCookieWithOptions(cm.get(), https_www_google_.url(),
+                                   "C=3; httponly", all_options));
+  EXPECT_TRUE(SetCookieWithOptions(cm.get(), https_www_google_.url(),
+                                   "D=4; samesite=lax", all_options));
+  EXPECT_TRUE(SetCookieWithOptions(cm.get(), https_www_google_.url(),
+                                   "E=5; samesite=strict", all_options));
+
+  EXPECT_EQ("A=1; B=2; C=3; D=4; E=5",
+            GetCookiesWithOptions(cm.get(), https_www_google_.url(),
+                                  all_options));
+  EXPECT_EQ("A=1; C=3; D=4; E=5",
+            GetCookiesWithOptions(cm.get(), http_www_google_.url(),
+                                  all_options));
+
+  CookieOptions lax_options;
+  lax_options.set_same_site_cookie_mode(
+      CookieOptions::SameSiteCookieMode::INCLUDE_LAX);
+  EXPECT_EQ("A=1; B=2; D=4",
+            GetCookiesWithOptions(cm.get(), https_www_google_.url(),
+                                  lax_options));
+  EXPECT_EQ("A=1", GetCookiesWithOptions(cm.get(), http_www_google_.url(),
+                                         CookieOptions()));
+}
+
+// Tests that overwriting and deleting cookies keeps the lookup of their key
+// up to date.
+TEST_F(CookieMonsterTest, IndexedLookupAfterUpdates) {
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
+
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(), "A=1"));
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(), "B=2"));
+  EXPECT_EQ("A=1; B=2", GetCookies(cm.get(), http_www_google_.url()));
+
+  // The secure cookie replaces the insecure one, and is not sent over http.
+  EXPECT_TRUE(SetCookie(cm.get(), https_www_google_.url(), "A=3; secure"));
+  EXPECT_EQ("B=2", GetCookies(cm.get(), http_www_google_.url()));
+  EXPECT_EQ("B=2; A=3", GetCookies(cm.get(), https_www_google_.url()));
+
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(), "A=4"));
+  EXPECT_EQ("B=2; A=4", GetCookies(cm.get(), http_www_google_.url()));
+  EXPECT_EQ(2u, GetAllCookies(cm.get()).size());
+
+  DeleteCookie(cm.get(), http_www_google_.url(), "B");
+  EXPECT_EQ("A=4", GetCookies(cm.get(), http_www_google_.url()));
+  DeleteCookie(cm.get(), http_www_google_.url(), "A");
+  EXPECT_EQ("", GetCookies(cm.get(), http_www_google_.url()));
+  EXPECT_EQ(0u, GetAllCookies(cm.get()).size());
+
+  // The key can be used again once all its cookies are gone.
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(), "C=5"));
+  EXPECT_EQ("C=5", GetCookies(cm.get(), http_www_google_.url()));
+}
+
+// Tests that looking up a key deletes its expired cookies, and leaves the
+// other cookies of the key to later lookups.
+TEST_F(CookieMonsterTest, IndexedLookupDeletesExpiredCookies) {
+  scoped_refptr<MockPersistentCookieStore> store(new MockPersistentCookieStore);
+  std::vector<CanonicalCookie*> initial_cookies;
+  AddCookieToList(GURL("http://www.google.com"),
+                  "A=1; path=/; expires=Thu, 01-Jan-2015 00:00:00 GMT",
+                  Time::Now() - TimeDelta::FromDays(1), &initial_cookies);
+  AddCookieToList(GURL("http://www.google.com"),
+                  "B=2; path=/; expires=Tue, 01-Jan-2115 00:00:00 GMT",
+                  Time::Now(), &initial_cookies);
+  AddCookieToList(GURL("http://www.google.com"),
+                  "C=3; path=/; expires=Thu, 01-Jan-2015 00:00:00 GMT",
+                  Time::Now() - TimeDelta::FromDays(2), &initial_cookies);
+  store->SetLoadExpectation(true, initial_cookies);
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(store.get(), nullptr));
+
+  EXPECT_EQ("B=2", GetCookies(cm.get(), GURL("http://www.google.com/")));
+  ASSERT_EQ(2u, store->commands().size());
+  EXPECT_EQ(CookieStoreCommand::REMOVE, store->commands()[0].type);
+  EXPECT_EQ(CookieStoreCommand::REMOVE, store->commands()[1].type);
+
+  EXPECT_EQ("B=2", GetCookies(cm.get(), GURL("http://www.google.com/")));
+  EXPECT_EQ(1u, GetAllCookies(cm.get()).size());
+}
+
+// Tests lookups of keys that have no cookies, and of hosts that have none
+// among the cookies of their key.
+TEST_F(CookieMonsterTest, IndexedLookupMisses) {
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
+  EXPECT_EQ("", GetCookies(cm.get(), http_www_google_.url()));
+
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(), "A=1"));
+  EXPECT_TRUE(SetCookie(cm.get(), http_www_google_.url(),
+                        http_www_google_.Format("B=2; domain=.%D")));
+  EXPECT_EQ("", GetCookies(cm.get(), GURL("http://www.example.com/")));
+
+  // Same key, but only the domain cookie matches the host.
+  GURL url_mail(http_www_google_.Format("http://mail.%D/"));
+  EXPECT_EQ("B=2", GetCookies(cm.get(), url_mail));
+
+  EXPECT_EQ(2, DeleteAll(cm.get()));
+  EXPECT_EQ("", GetCookies(cm.get(), http_www_google_.url()));
+}
+
 TEST_F(CookieMonsterTest, CookieSorting) {
   std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
 
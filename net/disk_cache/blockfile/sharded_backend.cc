@@ -0,0 +1,320 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/blockfile/sharded_backend.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/files/file_util.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/task_runner_util.h"
+#include "base/threading/thread.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/blockfile/backend_impl.h"
+#include "net/disk_cache/cache_util.h"
+
+namespace {
+
+// Returns the size of a cache stored at |path| when the user doesn't set one.
+// Runs on a cache thread, as it touches the disk.
+int PreferredSizeForPath(const base::FilePath& path) {
+  if (!base::CreateDirectory(path))
+    return disk_cache::kDefaultCacheSize;
+  int64_t available = base::SysInfo::AmountOfFreeDiskSpace(path);
+  if (available < 0)
+    return disk_cache::kDefaultCacheSize;
+  return disk_cache::PreferredCacheSize(available);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// Collects the results of an operation that runs on every shard. The result is
+// the first error reported by a shard or, if |add_results| is set, the sum of
+// the results of all shards.
+class ShardedBackend::Barrier : public base::RefCounted<Barrier> {
+ public:
+  Barrier(int num_shards, bool add_results)
+      : pending_(num_shards + 1), add_results_(add_results), result_(net::OK) {}
+
+  // Returns the callback to pass to each shard.
+  CompletionCallback ShardCallback() {
+    return base::Bind(&Barrier::OnShardComplete, this);
+  }
+
+  // Records the return value of the call to a shard.
+  void OnShardResult(int result) {
+    if (result != net::ERR_IO_PENDING)
+      OnShardComplete(result);
+  }
+
+  // To be called once the operation was started on every shard. Returns the
+  // final result if all the shards completed synchronously. Otherwise returns
+  // ERR_IO_PENDING, and |callback| will receive the result.
+  int Wait(const CompletionCallback& callback) {
+    if (!--pending_)
+      return result_;
+    callback_ = callback;
+    return net::ERR_IO_PENDING;
+  }
+
+ private:
+  friend class base::RefCounted<Barrier>;
+  ~Barrier() {}
+
+  void OnShardComplete(int result) {
+    if (result < 0) {
+      if (result_ >= 0)
+        result_ = result;
+    } else if (add_results_ && result_ >= 0) {
+      result_ += result;
+    }
+
+    if (!--pending_)
+      base::ResetAndReturn(&callback_).Run(result_);
+  }
+
+  int pending_;
+  const bool add_results_;
+  int result_;
+  CompletionCallback callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Barrier);
+};
+
+// Enumerates the entries of one shard after another.
+class ShardedBackend::ShardedIterator : public Backend::Iterator {
+ public:
+  explicit ShardedIterator(const base::WeakPtr<ShardedBackend>& backend)
+      : backend_(backend), shard_index_(0), weak_factory_(this) {}
+  ~ShardedIterator() override {}
+
+  int OpenNextEntry(Entry** next_entry,
+                    const CompletionCallback& callback) override {
+    while (backend_ && shard_index_ < backend_->num_shards()) {
+      if (!shard_iterator_)
+        shard_iterator_ = backend_->shards_[shard_index_]->CreateIterator();
+
+      int rv = shard_iterator_->OpenNextEntry(
+          next_entry,
+          base::Bind(&ShardedIterator::OnOpenNextEntryComplete,
+                     weak_factory_.GetWeakPtr(), next_entry, callback));
+      if (rv != net::ERR_FAILED)
+        return rv;
+
+      // This shard is done, move to the next one.
+      shard_iterator_.reset();
+      shard_index_++;
+    }
+    return net::ERR_FAILED;
+  }
+
+ private:
+  void OnOpenNextEntryComplete(Entry** next_entry,
+                               const CompletionCallback& callback,
+                               int result) {
+    if (result == net::ERR_FAILED) {
+      shard_iterator_.reset();
+      shard_index_++;
+      result = OpenNextEntry(next_entry, callback);
+      if (result == net::ERR_IO_PENDING)
+        return;
+    }
+    callback.Run(result);
+  }
+
+  base::WeakPtr<ShardedBackend> backend_;
+  int shard_index_;
+  std::unique_ptr<Backend::Iterator> shard_iterator_;
+  base::WeakPtrFactory<ShardedIterator> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedIterator);
+};
+
+ShardedBackend::ShardedBackend(const base::FilePath& path,
+                               int num_shards,
+                               net::NetLog* net_log)
+    : path_(path),
+      type_(net::DISK_CACHE),
+      max_size_(0),
+      weak_factory_(this) {
+  DCHECK_GT(num_shards, 0);
+  DCHECK_LE(num_shards, kMaxShards);
+
+  for (int i = 0; i < num_shards; i++) {
+    std::unique_ptr<base::Thread> thread(
+        new base::Thread(base::StringPrintf("CacheShard%d", i)));
+    CHECK(thread->StartWithOptions(
+        base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+    shards_.push_back(std::unique_ptr<BackendImpl>(
+        new BackendImpl(path.AppendASCII(base::StringPrintf("shard%d", i)),
+                        thread->task_runner(), net_log)));
+    threads_.push_back(std::move(thread));
+  }
+}
+
+ShardedBackend::~ShardedBackend() {
+  // Each BackendImpl waits for its cache thread to clean up, so the shards go
+  // away before the threads are stopped.
+  shards_.clear();
+  threads_.clear();
+}
+
+bool ShardedBackend::SetMaxSize(int max_bytes) {
+  if (max_bytes < 0)
+    return false;
+  max_size_ = max_bytes;
+  return true;
+}
+
+void ShardedBackend::SetType(net::CacheType type) {
+  type_ = type;
+  for (const auto& shard : shards_)
+    shard->SetType(type);
+}
+
+void ShardedBackend::SetFlags(uint32_t flags) {
+  for (const auto& shard : shards_)
+    shard->SetFlags(flags);
+}
+
+int ShardedBackend::Init(const CompletionCallback& callback) {
+  if (max_size_)
+    return InitShards(callback);
+
+  // The size depends on the free disk space, which should not be queried from
+  // this thread.
+  base::PostTaskAndReplyWithResult(
+      threads_[0]->task_runner().get(), FROM_HERE,
+      base::Bind(&PreferredSizeForPath, path_),
+      base::Bind(&ShardedBackend::OnPreferredSizeComputed,
+                 weak_factory_.GetWeakPtr(), callback));
+  return net::ERR_IO_PENDING;
+}
+
+int ShardedBackend::ShardForKey(const std::string& key) const {
+  // The index of each shard uses the low bits of the same hash, so pick the
+  // shard with the high bits to keep the buckets of every index evenly used.
+  uint64_t hash = base::Hash(key);
+  return static_cast<int>((hash * shards_.size()) >> 32);
+}
+
+net::CacheType ShardedBackend::GetCacheType() const {
+  return type_;
+}
+
+int32_t ShardedBackend::GetEntryCount() const {
+  int32_t count = 0;
+  for (const auto& shard : shards_)
+    count += shard->GetEntryCount();
+  return count;
+}
+
+int ShardedBackend::OpenEntry(const std::string& key,
+                              Entry** entry,
+                              const CompletionCallback& callback) {
+  return shards_[ShardForKey(key)]->OpenEntry(key, entry, callback);
+}
+
+int ShardedBackend::CreateEntry(const std::string& key,
+                                Entry** entry,
+                                const CompletionCallback& callback) {
+  return shards_[ShardForKey(key)]->CreateEntry(key, entry, callback);
+}
+
+int ShardedBackend::DoomEntry(const std::string& key,
+                              const CompletionCallback& callback) {
+  return shards_[ShardForKey(key)]->DoomEntry(key, callback);
+}
+
+int ShardedBackend::DoomAllEntries(const CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(num_shards(), false));
+  for (const auto& shard : shards_)
+    barrier->OnShardResult(shard->DoomAllEntries(barrier->ShardCallback()));
+  return barrier->Wait(callback);
+}
+
+int ShardedBackend::DoomEntriesBetween(base::Time initial_time,
+                                       base::Time end_time,
+                                       const CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(num_shards(), false));
+  for (const auto& shard : shards_) {
+    barrier->OnShardResult(shard->DoomEntriesBetween(
+        initial_time, end_time, barrier->ShardCallback()));
+  }
+  return barrier->Wait(callback);
+}
+
+int ShardedBackend::DoomEntriesSince(base::Time initial_time,
+                                     const CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(num_shards(), false));
+  for (const auto& shard : shards_) {
+    barrier->OnShardResult(
+        shard->DoomEntriesSince(initial_time, barrier->ShardCallback()));
+  }
+  return barrier->Wait(callback);
+}
+
+int ShardedBackend::CalculateSizeOfAllEntries(
+    const CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(num_shards(), true));
+  for (const auto& shard : shards_) {
+    barrier->OnShardResult(
+        shard->CalculateSizeOfAllEntries(barrier->ShardCallback()));
+  }
+  return barrier->Wait(callback);
+}
+
+std::unique_ptr<Backend::Iterator> ShardedBackend::CreateIterator() {
+  return std::unique_ptr<Backend::Iterator>(
+      new ShardedIterator(weak_factory_.GetWeakPtr()));
+}
+
+void ShardedBackend::GetStats(base::StringPairs* stats) {
+  stats->push_back(std::make_pair("Cache type", "Sharded Blockfile Cache"));
+  stats->push_back(std::make_pair("Shards", base::IntToString(num_shards())));
+
+  for (int i = 0; i < num_shards(); i++) {
+    base::StringPairs shard_stats;
+    shards_[i]->GetStats(&shard_stats);
+    for (const auto& item : shard_stats) {
+      stats->push_back(std::make_pair(
+          base::StringPrintf("Shard %d: %s", i, item.first.c_str()),
+          item.second));
+    }
+  }
+}
+
+void ShardedBackend::OnExternalCacheHit(const std::string& key) {
+  shards_[ShardForKey(key)]->OnExternalCacheHit(key);
+}
+
+int ShardedBackend::InitShards(const CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(num_shards(), false));
+  for (const auto& shard : shards_) {
+    shard->SetMaxSize(max_size_ / num_shards());
+    barrier->OnShardResult(shard->Init(barrier->ShardCallback()));
+  }
+  return barrier->Wait(callback);
+}
+
+void ShardedBackend::OnPreferredSizeComputed(
+    const CompletionCallback& callback,
+    int max_size) {
+  max_size_ = max_size;
+  int rv = InitShards(callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,118 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_BLOCKFILE_SHARDED_BACKEND_H_
+#define NET_DISK_CACHE_BLOCKFILE_SHARDED_BACKEND_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/cache_type.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/disk_cache.h"
+
+namespace base {
+class Thread;
+}  // namespace base
+
+namespace net {
+class NetLog;
+}  // namespace net
+
+namespace disk_cache {
+
+class BackendImpl;
+
+// A blockfile cache split into a number of independent shards. Every shard is
+// a full BackendImpl, with its own index, rankings lists, block files and
+// cache thread, stored on the "shardN" subdirectory of the cache path. A key
+// is always routed to the same shard, so operations on keys that live on
+// different shards never contend for the same files or thread, and run in
+// parallel.
+//
+// The number of shards is part of the on-disk format: reopening a cache with a
+// different number of shards will not find the entries that were stored
+// before.
+class NET_EXPORT_PRIVATE ShardedBackend : public Backend {
+ public:
+  static const int kMaxShards = 16;
+
+  ShardedBackend(const base::FilePath& path,
+                 int num_shards,
+                 net::NetLog* net_log);
+  ~ShardedBackend() override;
+
+  // Sets the maximum size of the whole cache; it is split evenly among the
+  // shards. Without it, the size is derived from the available disk space.
+  // These setters must be called before Init.
+  bool SetMaxSize(int max_bytes);
+  void SetType(net::CacheType type);
+  void SetFlags(uint32_t flags);
+
+  // Initializes all the shards. |callback| is invoked once every shard is
+  // ready, with the first error reported by any of them.
+  int Init(const CompletionCallback& callback);
+
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+
+  // Returns the index of the shard that stores |key|.
+  int ShardForKey(const std::string& key) const;
+
+  // Returns the backend of a given shard. For testing.
+  BackendImpl* shard(int index) { return shards_[index].get(); }
+
+  // Backend implementation.
+  net::CacheType GetCacheType() const override;
+  int32_t GetEntryCount() const override;
+  int OpenEntry(const std::string& key,
+                Entry** entry,
+                const CompletionCallback& callback) override;
+  int CreateEntry(const std::string& key,
+                  Entry** entry,
+                  const CompletionCallback& callback) override;
+  int DoomEntry(const std::string& key,
+                const CompletionCallback& callback) override;
+  int DoomAllEntries(const CompletionCallback& callback) override;
+  int DoomEntriesBetween(base::Time initial_time,
+                         base::Time end_time,
+                         const CompletionCallback& callback) override;
+  int DoomEntriesSince(base::Time initial_time,
+                       const CompletionCallback& callback) override;
+  int CalculateSizeOfAllEntries(const CompletionCallback& callback) override;
+  std::unique_ptr<Iterator> CreateIterator() override;
+  void GetStats(base::StringPairs* stats) override;
+  void OnExternalCacheHit(const std::string& key) override;
+
+ private:
+  class Barrier;
+  class ShardedIterator;
+
+  // Initializes the shards once the total size of the cache is known.
+  int InitShards(const CompletionCallback& callback);
+  void OnPreferredSizeComputed(const CompletionCallback& callback,
+                               int max_size);
+
+  base::FilePath path_;
+  net::CacheType type_;
+  int max_size_;  // For the whole cache, not per shard.
+
+  // The threads must outlive the backends: a BackendImpl finishes its cleanup
+  // on its cache thread when it is destroyed.
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+  std::vector<std::unique_ptr<BackendImpl>> shards_;
+
+  base::WeakPtrFactory<ShardedBackend> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedBackend);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_BLOCKFILE_SHARDED_BACKEND_H_
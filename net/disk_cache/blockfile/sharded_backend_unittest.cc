@@ -0,0 +1,167 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/blockfile/sharded_backend.h"
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include "base/metrics/field_trial.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/mock_entropy_provider.h"
+#include "base/threading/thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/blockfile/backend_impl.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumShards = 4;
+const int kNumEntries = 40;
+const int kCacheSize = 16 * 1024 * 1024;
+
+}  // namespace
+
+class DiskCacheShardedBackendTest : public DiskCacheTest {
+ protected:
+  void CreateBackend() {
+    backend_.reset(
+        new disk_cache::ShardedBackend(cache_path_, kNumShards, nullptr));
+    ASSERT_TRUE(backend_->SetMaxSize(kCacheSize));
+    backend_->SetFlags(disk_cache::kNoRandom);
+    net::TestCompletionCallback cb;
+    ASSERT_EQ(net::OK, cb.GetResult(backend_->Init(cb.callback())));
+  }
+
+  std::string Key(int i) { return base::StringPrintf("the key %d", i); }
+
+  // Creates |kNumEntries| entries, each with a small stream 0.
+  void CreateEntries() {
+    scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(100));
+    CacheTestFillBuffer(buffer->data(), 100, false);
+    for (int i = 0; i < kNumEntries; i++) {
+      disk_cache::Entry* entry;
+      net::TestCompletionCallback cb;
+      ASSERT_EQ(net::OK, cb.GetResult(backend_->CreateEntry(Key(i), &entry,
+                                                            cb.callback())));
+      net::TestCompletionCallback write_cb;
+      int rv = entry->WriteData(0, 0, buffer.get(), 100, write_cb.callback(),
+                                false);
+      EXPECT_EQ(100, write_cb.GetResult(rv));
+      entry->Close();
+    }
+  }
+
+  std::unique_ptr<disk_cache::ShardedBackend> backend_;
+};
+
+TEST_F(DiskCacheShardedBackendTest, KeysStayOnTheirShard) {
+  ASSERT_NO_FATAL_FAILURE(CreateBackend());
+  ASSERT_NO_FATAL_FAILURE(CreateEntries());
+  EXPECT_EQ(kNumEntries, backend_->GetEntryCount());
+
+  int per_shard[kNumShards] = {};
+  for (int i = 0; i < kNumEntries; i++) {
+    int shard = backend_->ShardForKey(Key(i));
+    ASSERT_GE(shard, 0);
+    ASSERT_LT(shard, kNumShards);
+    EXPECT_EQ(shard, backend_->ShardForKey(Key(i)));
+    per_shard[shard]++;
+  }
+  for (int i = 0; i < kNumShards; i++)
+    EXPECT_EQ(per_shard[i], backend_->shard(i)->GetEntryCount());
+
+  // Every entry survives reopening the cache.
+  backend_.reset();
+  ASSERT_NO_FATAL_FAILURE(CreateBackend());
+  EXPECT_EQ(kNumEntries, backend_->GetEntryCount());
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    net::TestCompletionCallback cb;
+    ASSERT_EQ(net::OK,
+              cb.GetResult(backend_->OpenEntry(Key(i), &entry, cb.callback())));
+    EXPECT_EQ(100, entry->GetDataSize(0));
+    entry->Close();
+  }
+}
+
+TEST_F(DiskCacheShardedBackendTest, Enumerate) {
+  ASSERT_NO_FATAL_FAILURE(CreateBackend());
+  ASSERT_NO_FATAL_FAILURE(CreateEntries());
+
+  std::set<std::string> keys;
+  std::unique_ptr<disk_cache::Backend::Iterator> iter =
+      backend_->CreateIterator();
+  disk_cache::Entry* entry;
+  net::TestCompletionCallback cb;
+  while (cb.GetResult(iter->OpenNextEntry(&entry, cb.callback())) ==
+         net::OK) {
+    EXPECT_TRUE(keys.insert(entry->GetKey()).second);
+    entry->Close();
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumEntries), keys.size());
+}
+
+TEST_F(DiskCacheShardedBackendTest, AllShardOperations) {
+  ASSERT_NO_FATAL_FAILURE(CreateBackend());
+  ASSERT_NO_FATAL_FAILURE(CreateEntries());
+
+  net::TestCompletionCallback size_cb;
+  int size = size_cb.GetResult(
+      backend_->CalculateSizeOfAllEntries(size_cb.callback()));
+  EXPECT_GE(size, kNumEntries * 100);
+
+  net::TestCompletionCallback doom_cb;
+  disk_cache::Entry* entry;
+  EXPECT_EQ(net::OK,
+            doom_cb.GetResult(backend_->DoomEntry(Key(0), doom_cb.callback())));
+  EXPECT_NE(net::OK, doom_cb.GetResult(backend_->OpenEntry(
+                         Key(0), &entry, doom_cb.callback())));
+  EXPECT_EQ(kNumEntries - 1, backend_->GetEntryCount());
+
+  EXPECT_EQ(net::OK,
+            doom_cb.GetResult(backend_->DoomAllEntries(doom_cb.callback())));
+  EXPECT_EQ(0, backend_->GetEntryCount());
+  EXPECT_EQ(0, size_cb.GetResult(
+                   backend_->CalculateSizeOfAllEntries(size_cb.callback())));
+}
+
+// The field trial makes CreateCacheBackend() split a blockfile HTTP cache.
+TEST_F(DiskCacheShardedBackendTest, CreatedByFieldTrial) {
+  base::FieldTrialList field_trial_list(new base::MockEntropyProvider());
+  base::FieldTrialList::CreateFieldTrial("BlockfileCacheShards", "4");
+  base::Thread cache_thread("CacheThread");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+      base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+
+  std::unique_ptr<disk_cache::Backend> cache;
+  net::TestCompletionCallback cb;
+  int rv = disk_cache::CreateCacheBackend(
+      net::DISK_CACHE, net::CACHE_BACKEND_BLOCKFILE, cache_path_, kCacheSize,
+      false, cache_thread.task_runner(), nullptr, &cache, cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+  base::StringPairs stats;
+  cache->GetStats(&stats);
+  ASSERT_LT(1u, stats.size());
+  EXPECT_EQ("Sharded Blockfile Cache", stats[0].second);
+  EXPECT_EQ("4", stats[1].second);
+  cache.reset();
+
+  // Other cache types keep a single backend.
+  rv = disk_cache::CreateCacheBackend(
+      net::APP_CACHE, net::CACHE_BACKEND_BLOCKFILE,
+      cache_path_.AppendASCII("app"), kCacheSize, false,
+      cache_thread.task_runner(), nullptr, &cache, cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  stats.clear();
+  cache->GetStats(&stats);
+  ASSERT_FALSE(stats.empty());
+  EXPECT_NE("Sharded Blockfile Cache", stats[0].second);
+}
@@ -8,10 +8,12 @@
 #include "base/macros.h"
 #include "base/metrics/field_trial.h"
 #include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "net/base/cache_type.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/blockfile/backend_impl.h"
+#include "net/disk_cache/blockfile/sharded_backend.h"
 #include "net/disk_cache/cache_util.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/memory/mem_backend_impl.h"
@@ -19,6 +21,25 @@
 
 namespace {
 
+#if !defined(OS_ANDROID)
+// Returns the number of shards to split a blockfile HTTP cache into, or 0 to
+// keep a single BackendImpl. The "BlockfileCacheShards" field trial selects it
+// through the group name, e.g. --force-fieldtrials=BlockfileCacheShards/4/.
+int GetBlockfileShardCount(net::CacheType type) {
+  if (type != net::DISK_CACHE)
+    return 0;
+
+  int num_shards;
+  if (!base::StringToInt(
+          base::FieldTrialList::FindFullName("BlockfileCacheShards"),
+          &num_shards) ||
+      num_shards < 2 || num_shards > disk_cache::ShardedBackend::kMaxShards) {
+    return 0;
+  }
+  return num_shards;
+}
+#endif  // !defined(OS_ANDROID)
+
 // Builds an instance of the backend depending on platform, type, experiments
 // etc. Takes care of the retry state. This object will self-destroy when
 // finished.
@@ -108,6 +129,21 @@ int CacheCreator::Run() {
 #if defined(OS_ANDROID)
   return net::ERR_FAILED;
 #else
+  int num_shards = GetBlockfileShardCount(type_);
+  if (num_shards) {
+    // The shards run on their own cache threads, not on |thread_|.
+    disk_cache::ShardedBackend* sharded_cache =
+        new disk_cache::ShardedBackend(path_, num_shards, net_log_);
+    created_cache_.reset(sharded_cache);
+    sharded_cache->SetMaxSize(max_bytes_);
+    sharded_cache->SetType(type_);
+    sharded_cache->SetFlags(flags_);
+    int rv = sharded_cache->Init(
+        base::Bind(&CacheCreator::OnIOComplete, base::Unretained(this)));
+    DCHECK_EQ(net::ERR_IO_PENDING, rv);
+    return rv;
+  }
+
   disk_cache::BackendImpl* new_cache =
       new disk_cache::BackendImpl(path_, thread_, net_log_);
   created_cache_.reset(new_cache);
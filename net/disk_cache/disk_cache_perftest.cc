@@ -2,29 +2,43 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+
 #include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/hash.h"
+#include "base/metrics/field_trial.h"
 #include "base/process/process_metrics.h"
+#include "base/rand_util.h"
+#include "base/run_loop.h"
 #include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/mock_entropy_provider.h"
 #include "base/test/perf_time_logger.h"
 #include "base/test/test_file_util.h"
 #include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "net/base/cache_type.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/base/test_completion_callback.h"
 #include "net/disk_cache/blockfile/backend_impl.h"
 #include "net/disk_cache/blockfile/block_files.h"
+#include "net/disk_cache/blockfile/sharded_backend.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/simple/simple_index.h"
+#include "net/disk_cache/simple/simple_index_table.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
 #include "testing/platform_test.h"
 
 using base::Time;
@@ -223,7 +237,9 @@ void DiskCachePerfTest::ResetAndEvictSystemDiskCache() {
 #endif
 
   DisableFirstCleanup();
+  base::PerfTimeLogger timer("Initialize disk cache (cold)");
   InitCache();
+  timer.Done();
 }
 
 void DiskCachePerfTest::CacheBackendPerformance() {
@@ -254,6 +270,210 @@ TEST_F(DiskCachePerfTest, SimpleCacheBackendPerformance) {
   CacheBackendPerformance();
 }
 
+TEST_F(DiskCachePerfTest, SimpleCacheIndexTableBackendPerformance) {
+  base::FieldTrialList field_trial_list(new base::MockEntropyProvider());
+  base::FieldTrialList::CreateFieldTrial("SimpleCacheIndexTable", "Enabled");
+  SetSimpleCacheMode();
+  CacheBackendPerformance();
+}
+
+size_t GetWorkingSetSize() {
+  std::unique_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateCurrentProcessMetrics());
+  return metrics->GetWorkingSetSize();
+}
+
+// Returns how much the working set grew since it was |working_set|, in kB. It
+// is negative if memory was released in the meantime.
+int64_t GetWorkingSetGrowthKB(size_t working_set) {
+  return (static_cast<int64_t>(GetWorkingSetSize()) -
+          static_cast<int64_t>(working_set)) /
+         1024;
+}
+
+// Compares the in-memory index of the simple cache with the memory-mapped
+// index table for a large number of entries: the cost of building each, of
+// bringing the table back from disk, of lookups, and the memory held.
+TEST_F(DiskCachePerfTest, SimpleIndexTablePerformance) {
+  ASSERT_TRUE(CleanupCacheDir());
+  const size_t kIndexEntries = 500000;
+  const int kLookupRounds = 10;
+  const base::Time now = base::Time::Now();
+  const base::FilePath table_path = cache_path_.AppendASCII("index-table");
+
+  std::vector<uint64_t> hashes;
+  for (size_t i = 0; i < kIndexEntries; ++i)
+    hashes.push_back(base::RandUint64());
+
+  size_t working_set = GetWorkingSetSize();
+  base::PerfTimeLogger timer1("Fill simple index entry set");
+  std::unique_ptr<disk_cache::SimpleIndex::EntrySet> entries(
+      new disk_cache::SimpleIndex::EntrySet());
+  for (uint64_t hash : hashes) {
+    disk_cache::SimpleIndex::InsertInEntrySet(
+        hash, disk_cache::EntryMetadata(now, 1000), entries.get());
+  }
+  timer1.Done();
+  LOG(INFO) << "Simple index entry set working set growth: "
+            << GetWorkingSetGrowthKB(working_set) << " kB";
+
+  base::PerfTimeLogger timer2("Look up simple index entry set");
+  size_t found = 0;
+  for (int round = 0; round < kLookupRounds; ++round) {
+    for (uint64_t hash : hashes)
+      found += entries->count(hash);
+  }
+  timer2.Done();
+  EXPECT_EQ(kIndexEntries * kLookupRounds, found);
+  entries.reset();
+
+  base::PerfTimeLogger timer3("Fill simple index table");
+  scoped_refptr<disk_cache::SimpleIndexTable> table =
+      disk_cache::SimpleIndexTable::Create(table_path, kIndexEntries,
+                                           base::ThreadTaskRunnerHandle::Get());
+  ASSERT_TRUE(table);
+  for (uint64_t hash : hashes)
+    ASSERT_TRUE(table->Insert(hash, disk_cache::EntryMetadata(now, 1000)));
+  timer3.Done();
+  ASSERT_TRUE(disk_cache::SimpleIndexTable::SyncFlush(
+      table->PrepareFlush(true /* mark_clean */), now));
+  table = nullptr;
+  base::MessageLoop::current()->RunUntilIdle();
+  ASSERT_TRUE(base::EvictFileFromSystemCache(table_path));
+
+  working_set = GetWorkingSetSize();
+  base::PerfTimeLogger timer4("Open simple index table (cold)");
+  table = disk_cache::SimpleIndexTable::Open(
+      table_path, base::ThreadTaskRunnerHandle::Get());
+  timer4.Done();
+  ASSERT_TRUE(table);
+
+  base::PerfTimeLogger timer5("Look up simple index table");
+  found = 0;
+  for (int round = 0; round < kLookupRounds; ++round) {
+    for (uint64_t hash : hashes)
+      found += table->Find(hash) ? 1 : 0;
+  }
+  timer5.Done();
+  EXPECT_EQ(kIndexEntries * kLookupRounds, found);
+  LOG(INFO) << "Simple index table working set growth: "
+            << GetWorkingSetGrowthKB(working_set) << " kB";
+
+  table = nullptr;
+  base::MessageLoop::current()->RunUntilIdle();
+}
+
+// Waits for a number of concurrent cache operations to complete.
+class OperationCounter {
+ public:
+  explicit OperationCounter(int pending) : pending_(pending), errors_(0) {}
+
+  net::CompletionCallback callback() {
+    return base::Bind(&OperationCounter::OnComplete, base::Unretained(this));
+  }
+
+  // Records the return value of starting an operation.
+  void OnStarted(int result) {
+    if (result != net::ERR_IO_PENDING)
+      OnComplete(result);
+  }
+
+  // Returns the number of operations that failed.
+  int Wait() {
+    if (pending_)
+      run_loop_.Run();
+    return errors_;
+  }
+
+ private:
+  void OnComplete(int result) {
+    if (result < 0)
+      errors_++;
+    if (!--pending_)
+      run_loop_.Quit();
+  }
+
+  int pending_;
+  int errors_;
+  base::RunLoop run_loop_;
+};
+
+// Creates, writes, reopens and reads |num_entries| entries on a cache split
+// into |num_shards| shards, with all the operations of each step in flight at
+// the same time, and prints the throughput of each step.
+void MeasureShardedBackend(const base::FilePath& path,
+                           int num_shards,
+                           int num_entries) {
+  const int kDataSize = 4096;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kDataSize));
+  CacheTestFillBuffer(buffer->data(), kDataSize, false);
+
+  std::unique_ptr<disk_cache::ShardedBackend> cache(
+      new disk_cache::ShardedBackend(path, num_shards, nullptr));
+  ASSERT_TRUE(cache->SetMaxSize(num_entries * kDataSize * 4));
+  cache->SetFlags(disk_cache::kNoLoadProtection);
+  net::TestCompletionCallback cb;
+  ASSERT_EQ(net::OK, cb.GetResult(cache->Init(cb.callback())));
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < num_entries; i++)
+    keys.push_back(base::StringPrintf("sharded entry %d", i));
+  std::vector<disk_cache::Entry*> entries(num_entries);
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  OperationCounter create(num_entries);
+  for (int i = 0; i < num_entries; i++)
+    create.OnStarted(cache->CreateEntry(keys[i], &entries[i],
+                                        create.callback()));
+  ASSERT_EQ(0, create.Wait());
+  OperationCounter write(num_entries);
+  for (disk_cache::Entry* entry : entries) {
+    write.OnStarted(entry->WriteData(1, 0, buffer.get(), kDataSize,
+                                     write.callback(), false));
+  }
+  ASSERT_EQ(0, write.Wait());
+  for (disk_cache::Entry* entry : entries)
+    entry->Close();
+  base::TimeDelta write_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  OperationCounter open(num_entries);
+  for (int i = 0; i < num_entries; i++)
+    open.OnStarted(cache->OpenEntry(keys[i], &entries[i], open.callback()));
+  ASSERT_EQ(0, open.Wait());
+  OperationCounter read(num_entries);
+  for (disk_cache::Entry* entry : entries) {
+    read.OnStarted(
+        entry->ReadData(1, 0, buffer.get(), kDataSize, read.callback()));
+  }
+  ASSERT_EQ(0, read.Wait());
+  for (disk_cache::Entry* entry : entries)
+    entry->Close();
+  base::TimeDelta read_time = base::TimeTicks::Now() - start;
+
+  const std::string trace = base::StringPrintf("%d_shards", num_shards);
+  perf_test::PrintResult("sharded_backend_create_write", "", trace,
+                         2 * num_entries / write_time.InSecondsF(), "ops/s",
+                         true);
+  perf_test::PrintResult("sharded_backend_open_read", "", trace,
+                         2 * num_entries / read_time.InSecondsF(), "ops/s",
+                         true);
+
+  cache.reset();
+  base::RunLoop().RunUntilIdle();
+}
+
+// Shows how the throughput of the blockfile cache scales when the key space is
+// split among independent shards.
+TEST_F(DiskCachePerfTest, ShardedBackendScaling) {
+  const int kShardedEntries = 4000;
+  for (int num_shards = 1; num_shards <= 8; num_shards *= 2) {
+    ASSERT_TRUE(CleanupCacheDir());
+    ASSERT_NO_FATAL_FAILURE(
+        MeasureShardedBackend(cache_path_, num_shards, kShardedEntries));
+  }
+}
+
 int BlockSize() {
   // We can use form 1 to 4 blocks.
   return (rand() & 0x3) + 1;
@@ -7,8 +7,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <functional>
-
-#include "base/memory/ptr_util.h"
+#include <utility>
 
 #if defined(OS_POSIX)
 #include <sys/resource.h>
@@ -36,6 +35,7 @@
 #include "net/disk_cache/simple/simple_histogram_macros.h"
 #include "net/disk_cache/simple/simple_index.h"
 #include "net/disk_cache/simple/simple_index_file.h"
+#include "net/disk_cache/simple/simple_index_table_file.h"
 #include "net/disk_cache/simple/simple_synchronous_entry.h"
 #include "net/disk_cache/simple/simple_util.h"
 #include "net/disk_cache/simple/simple_version_upgrade.h"
@@ -186,6 +186,13 @@ void RunOperationAndCallback(
     operation_callback.Run(operation_result);
 }
 
+// Returns whether the index should live in a memory-mapped SimpleIndexTable
+// instead of being loaded onto the heap from a pickled index file.
+bool UseIndexTable() {
+  return base::FieldTrialList::FindFullName("SimpleCacheIndexTable") ==
+         "Enabled";
+}
+
 void RecordIndexLoad(net::CacheType cache_type,
                      base::TimeTicks constructed_since,
                      int result) {
@@ -251,10 +258,16 @@ SimpleBackendImpl::~SimpleBackendImpl() {
 int SimpleBackendImpl::Init(const CompletionCallback& completion_callback) {
   worker_pool_ = g_sequenced_worker_pool.Get().GetTaskRunner();
 
-  index_.reset(new SimpleIndex(
-      base::ThreadTaskRunnerHandle::Get(), this, cache_type_,
-      base::WrapUnique(new SimpleIndexFile(cache_thread_, worker_pool_.get(),
-                                           cache_type_, path_))));
+  std::unique_ptr<SimpleIndexFile> index_file;
+  if (UseIndexTable()) {
+    index_file.reset(new SimpleIndexTableFile(cache_thread_, worker_pool_.get(),
+                                              cache_type_, path_));
+  } else {
+    index_file.reset(new SimpleIndexFile(cache_thread_, worker_pool_.get(),
+                                         cache_type_, path_));
+  }
+  index_.reset(new SimpleIndex(base::ThreadTaskRunnerHandle::Get(), this,
+                               cache_type_, std::move(index_file)));
   index_->ExecuteWhenReady(
       base::Bind(&RecordIndexLoad, cache_type_, base::TimeTicks::Now()));
 
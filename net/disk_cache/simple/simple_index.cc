@@ -28,6 +28,7 @@
 #include "net/disk_cache/simple/simple_histogram_macros.h"
 #include "net/disk_cache/simple/simple_index_delegate.h"
 #include "net/disk_cache/simple/simple_index_file.h"
+#include "net/disk_cache/simple/simple_index_table.h"
 #include "net/disk_cache/simple/simple_synchronous_entry.h"
 #include "net/disk_cache/simple/simple_util.h"
 
@@ -49,29 +50,12 @@ const uint32_t kEvictionMarginDivisor = 20;
 
 const uint32_t kBytesInKb = 1024;
 
-// Utility class used for timestamp comparisons in entry metadata while sorting.
-class CompareHashesForTimestamp {
-  typedef disk_cache::SimpleIndex SimpleIndex;
-  typedef disk_cache::SimpleIndex::EntrySet EntrySet;
- public:
-  explicit CompareHashesForTimestamp(const EntrySet& set);
+typedef std::pair<uint64_t, disk_cache::EntryMetadata> HashAndMetadata;
 
-  bool operator()(uint64_t hash1, uint64_t hash2);
-
- private:
-  const EntrySet& entry_set_;
-};
-
-CompareHashesForTimestamp::CompareHashesForTimestamp(const EntrySet& set)
-  : entry_set_(set) {
-}
-
-bool CompareHashesForTimestamp::operator()(uint64_t hash1, uint64_t hash2) {
-  EntrySet::const_iterator it1 = entry_set_.find(hash1);
-  DCHECK(it1 != entry_set_.end());
-  EntrySet::const_iterator it2 = entry_set_.find(hash2);
-  DCHECK(it2 != entry_set_.end());
-  return it1->second.GetLastUsedTime() < it2->second.GetLastUsedTime();
+// Used for timestamp comparisons in entry metadata while sorting.
+bool CompareEntriesForTimestamp(const HashAndMetadata& entry1,
+                                const HashAndMetadata& entry2) {
+  return entry1.second.GetLastUsedTime() < entry2.second.GetLastUsedTime();
 }
 
 }  // namespace
@@ -146,6 +130,7 @@ SimpleIndex::SimpleIndex(
     net::CacheType cache_type,
     std::unique_ptr<SimpleIndexFile> index_file)
     : delegate_(delegate),
+      table_overflowed_(false),
       cache_type_(cache_type),
       cache_size_(0),
       max_size_(0),
@@ -173,6 +158,19 @@ SimpleIndex::~SimpleIndex() {
   }
 }
 
+template <typename Visitor>
+void SimpleIndex::ForEachEntry(const Visitor& visitor) const {
+  if (table_) {
+    for (SimpleIndexTable::Iterator it(table_.get()); !it.IsAtEnd();
+         it.Advance()) {
+      visitor(it.hash(), it.metadata());
+    }
+    return;
+  }
+  for (const auto& entry : entries_set_)
+    visitor(entry.first, entry.second);
+}
+
 void SimpleIndex::Initialize(base::Time cache_mtime) {
   DCHECK(io_thread_checker_.CalledOnValidThread());
 
@@ -183,6 +181,10 @@ void SimpleIndex::Initialize(base::Time cache_mtime) {
   }
 #endif
 
+  LoadIndex(cache_mtime);
+}
+
+void SimpleIndex::LoadIndex(base::Time cache_mtime) {
   SimpleIndexLoadResult* load_result = new SimpleIndexLoadResult();
   std::unique_ptr<SimpleIndexLoadResult> load_result_scoped(load_result);
   base::Closure reply = base::Bind(
@@ -225,13 +227,12 @@ std::unique_ptr<SimpleIndex::HashList> SimpleIndex::GetEntriesBetween(
       end_time.is_null() ? base::Time::Max() : end_time;
   DCHECK(extended_end_time >= initial_time);
   std::unique_ptr<HashList> ret_hashes(new HashList());
-  for (EntrySet::iterator it = entries_set_.begin(), end = entries_set_.end();
-       it != end; ++it) {
-    EntryMetadata& metadata = it->second;
+  HashList* ret_hashes_ptr = ret_hashes.get();
+  ForEachEntry([&](uint64_t entry_hash, const EntryMetadata& metadata) {
     base::Time entry_time = metadata.GetLastUsedTime();
     if (initial_time <= entry_time && entry_time < extended_end_time)
-      ret_hashes->push_back(it->first);
-  }
+      ret_hashes_ptr->push_back(entry_hash);
+  });
   return ret_hashes;
 }
 
@@ -241,7 +242,7 @@ std::unique_ptr<SimpleIndex::HashList> SimpleIndex::GetAllHashes() {
 
 int32_t SimpleIndex::GetEntryCount() const {
   // TODO(pasko): return a meaningful initial estimate before initialized.
-  return entries_set_.size();
+  return EntryCount();
 }
 
 uint64_t SimpleIndex::GetCacheSize() const {
@@ -254,8 +255,8 @@ void SimpleIndex::Insert(uint64_t entry_hash) {
   // Upon insert we don't know yet the size of the entry.
   // It will be updated later when the SimpleEntryImpl finishes opening or
   // creating the new entry, and then UpdateEntrySize will be called.
-  InsertInEntrySet(
-      entry_hash, EntryMetadata(base::Time::Now(), 0), &entries_set_);
+  if (!FindEntry(entry_hash))
+    InsertEntry(entry_hash, EntryMetadata(base::Time::Now(), 0));
   if (!initialized_)
     removed_entries_.erase(entry_hash);
   PostponeWritingToDisk();
@@ -263,10 +264,10 @@ void SimpleIndex::Insert(uint64_t entry_hash) {
 
 void SimpleIndex::Remove(uint64_t entry_hash) {
   DCHECK(io_thread_checker_.CalledOnValidThread());
-  EntrySet::iterator it = entries_set_.find(entry_hash);
-  if (it != entries_set_.end()) {
-    UpdateEntryIteratorSize(&it, 0);
-    entries_set_.erase(it);
+  EntryMetadata* metadata = FindEntryForUpdate(entry_hash);
+  if (metadata) {
+    UpdateEntryMetadataSize(metadata, 0);
+    EraseEntry(entry_hash);
   }
 
   if (!initialized_)
@@ -276,19 +277,21 @@ void SimpleIndex::Remove(uint64_t entry_hash) {
 
 bool SimpleIndex::Has(uint64_t hash) const {
   DCHECK(io_thread_checker_.CalledOnValidThread());
-  // If not initialized, always return true, forcing it to go to the disk.
-  return !initialized_ || entries_set_.count(hash) > 0;
+  // If not initialized, always return true, forcing it to go to the disk. The
+  // same goes for an index table that could not hold every entry.
+  return !initialized_ || table_overflowed_ || FindEntry(hash) != nullptr ||
+         (table_ && table_->is_corrupt());
 }
 
 bool SimpleIndex::UseIfExists(uint64_t entry_hash) {
   DCHECK(io_thread_checker_.CalledOnValidThread());
   // Always update the last used time, even if it is during initialization.
   // It will be merged later.
-  EntrySet::iterator it = entries_set_.find(entry_hash);
-  if (it == entries_set_.end())
+  EntryMetadata* metadata = FindEntryForUpdate(entry_hash);
+  if (!metadata)
     // If not initialized, always return true, forcing it to go to the disk.
-    return !initialized_;
-  it->second.SetLastUsedTime(base::Time::Now());
+    return !initialized_ || table_overflowed_;
+  metadata->SetLastUsedTime(base::Time::Now());
   PostponeWritingToDisk();
   return true;
 }
@@ -306,28 +309,23 @@ void SimpleIndex::StartEvictionIfNeeded() {
   SIMPLE_CACHE_UMA(
       MEMORY_KB, "Eviction.MaxCacheSizeOnStart2", cache_type_,
       static_cast<base::HistogramBase::Sample>(max_size_ / kBytesInKb));
-  std::vector<uint64_t> entry_hashes;
-  entry_hashes.reserve(entries_set_.size());
-  for (EntrySet::const_iterator it = entries_set_.begin(),
-       end = entries_set_.end(); it != end; ++it) {
-    entry_hashes.push_back(it->first);
-  }
-  std::sort(entry_hashes.begin(), entry_hashes.end(),
-            CompareHashesForTimestamp(entries_set_));
+  std::vector<HashAndMetadata> entries;
+  entries.reserve(EntryCount());
+  ForEachEntry([&entries](uint64_t entry_hash, const EntryMetadata& metadata) {
+    entries.push_back(HashAndMetadata(entry_hash, metadata));
+  });
+  std::sort(entries.begin(), entries.end(), CompareEntriesForTimestamp);
 
   // Remove as many entries from the index to get below |low_watermark_|.
-  std::vector<uint64_t>::iterator it = entry_hashes.begin();
+  std::vector<uint64_t> entry_hashes;
+  std::vector<HashAndMetadata>::const_iterator it = entries.begin();
   uint64_t evicted_so_far_size = 0;
   while (evicted_so_far_size < cache_size_ - low_watermark_) {
-    DCHECK(it != entry_hashes.end());
-    EntrySet::iterator found_meta = entries_set_.find(*it);
-    DCHECK(found_meta != entries_set_.end());
-    evicted_so_far_size += found_meta->second.GetEntrySize();
+    DCHECK(it != entries.end());
+    evicted_so_far_size += it->second.GetEntrySize();
+    entry_hashes.push_back(it->first);
     ++it;
   }
-
-  // Take out the rest of hashes from the eviction list.
-  entry_hashes.erase(it, entry_hashes.end());
   SIMPLE_CACHE_UMA(COUNTS,
                    "Eviction.EntryCount", cache_type_, entry_hashes.size());
   SIMPLE_CACHE_UMA(TIMES,
@@ -344,11 +342,11 @@ void SimpleIndex::StartEvictionIfNeeded() {
 
 bool SimpleIndex::UpdateEntrySize(uint64_t entry_hash, int64_t entry_size) {
   DCHECK(io_thread_checker_.CalledOnValidThread());
-  EntrySet::iterator it = entries_set_.find(entry_hash);
-  if (it == entries_set_.end())
+  EntryMetadata* metadata = FindEntryForUpdate(entry_hash);
+  if (!metadata)
     return false;
 
-  UpdateEntryIteratorSize(&it, entry_size);
+  UpdateEntryMetadataSize(metadata, entry_size);
   PostponeWritingToDisk();
   StartEvictionIfNeeded();
   return true;
@@ -387,14 +385,86 @@ void SimpleIndex::PostponeWritingToDisk() {
       FROM_HERE, base::TimeDelta::FromMilliseconds(delay), write_to_disk_cb_);
 }
 
-void SimpleIndex::UpdateEntryIteratorSize(EntrySet::iterator* it,
+void SimpleIndex::UpdateEntryMetadataSize(EntryMetadata* metadata,
                                           int64_t entry_size) {
   // Update the total cache size with the new entry size.
   DCHECK(io_thread_checker_.CalledOnValidThread());
-  DCHECK_GE(cache_size_, (*it)->second.GetEntrySize());
-  cache_size_ -= (*it)->second.GetEntrySize();
+  DCHECK_GE(cache_size_, metadata->GetEntrySize());
+  cache_size_ -= metadata->GetEntrySize();
   cache_size_ += entry_size;
-  (*it)->second.SetEntrySize(entry_size);
+  metadata->SetEntrySize(entry_size);
+}
+
+const EntryMetadata* SimpleIndex::FindEntry(uint64_t entry_hash) const {
+  if (table_)
+    return table_->Find(entry_hash);
+  EntrySet::const_iterator it = entries_set_.find(entry_hash);
+  return it == entries_set_.end() ? nullptr : &it->second;
+}
+
+EntryMetadata* SimpleIndex::FindEntryForUpdate(uint64_t entry_hash) {
+  if (table_) {
+    EntryMetadata* metadata = table_->FindForUpdate(entry_hash);
+    if (!table_->is_corrupt())
+      return metadata;
+    DropCorruptTable();
+  }
+  EntrySet::iterator it = entries_set_.find(entry_hash);
+  return it == entries_set_.end() ? nullptr : &it->second;
+}
+
+void SimpleIndex::InsertEntry(uint64_t entry_hash,
+                              const EntryMetadata& entry_metadata) {
+  if (table_) {
+    if (table_->Insert(entry_hash, entry_metadata))
+      return;
+    if (!table_->is_corrupt()) {
+      if (!table_overflowed_) {
+        LOG(WARNING) << "Simple Cache index table is full.";
+        table_overflowed_ = true;
+      }
+      return;
+    }
+    DropCorruptTable();
+  }
+  InsertInEntrySet(entry_hash, entry_metadata, &entries_set_);
+}
+
+void SimpleIndex::EraseEntry(uint64_t entry_hash) {
+  if (table_) {
+    table_->Remove(entry_hash);
+    if (!table_->is_corrupt())
+      return;
+    DropCorruptTable();
+  }
+  entries_set_.erase(entry_hash);
+}
+
+void SimpleIndex::DropCorruptTable() {
+  DCHECK(initialized_);
+  scoped_refptr<SimpleIndexTable> table = std::move(table_);
+  table_overflowed_ = false;
+  cache_size_ = 0;
+  // Entries touched until the index is rebuilt are tracked in |entries_set_|
+  // and |removed_entries_|, and merged afterwards as during the initial load.
+  initialized_ = false;
+  RebuildIndex(table.get());
+}
+
+void SimpleIndex::RebuildIndex(SimpleIndexTable* corrupt_table) {
+  DCHECK(corrupt_table->is_corrupt());
+  LOG(WARNING) << "Simple Cache index table is corrupt, rebuilding the index.";
+  // The flush marks the table as in use on disk. Rebuilding the index
+  // replaces the table file, so it only starts once the flush is done. A
+  // modification time in the future makes whatever is on disk look stale, so
+  // the entries are read from the cache directory.
+  index_file_->FlushTable(
+      INDEX_WRITE_REASON_IDLE, corrupt_table, false, base::TimeTicks::Now(),
+      base::Bind(&SimpleIndex::LoadIndex, AsWeakPtr(), base::Time::Max()));
+}
+
+size_t SimpleIndex::EntryCount() const {
+  return table_ ? table_->size() : entries_set_.size();
 }
 
 void SimpleIndex::MergeInitializingSet(
@@ -402,8 +472,36 @@ void SimpleIndex::MergeInitializingSet(
   DCHECK(io_thread_checker_.CalledOnValidThread());
   DCHECK(load_result->did_load);
 
-  EntrySet* index_file_entries = &load_result->entries;
+  if (load_result->table) {
+    scoped_refptr<SimpleIndexTable> table = std::move(load_result->table);
+    if (!MergeInitializingSetIntoTable(table)) {
+      RebuildIndex(table.get());
+      return;
+    }
+  } else {
+    MergeInitializingSetIntoEntrySet(&load_result->entries);
+  }
+  initialized_ = true;
+  init_method_ = load_result->init_method;
+
+  // The actual IO is asynchronous, so calling WriteToDisk() shouldn't slow the
+  // merge down much.
+  if (load_result->flush_required)
+    WriteToDisk(INDEX_WRITE_REASON_STARTUP_MERGE);
+
+  SIMPLE_CACHE_UMA(CUSTOM_COUNTS,
+                   "IndexInitializationWaiters", cache_type_,
+                   to_run_when_initialized_.size(), 0, 100, 20);
+  // Run all callbacks waiting for the index to come up.
+  for (CallbackList::iterator it = to_run_when_initialized_.begin(),
+       end = to_run_when_initialized_.end(); it != end; ++it) {
+    io_thread_->PostTask(FROM_HERE, base::Bind((*it), net::OK));
+  }
+  to_run_when_initialized_.clear();
+}
 
+void SimpleIndex::MergeInitializingSetIntoEntrySet(
+    EntrySet* index_file_entries) {
   for (std::unordered_set<uint64_t>::const_iterator it =
            removed_entries_.begin();
        it != removed_entries_.end(); ++it) {
@@ -429,23 +527,47 @@ void SimpleIndex::MergeInitializingSet(
 
   entries_set_.swap(*index_file_entries);
   cache_size_ = merged_cache_size;
-  initialized_ = true;
-  init_method_ = load_result->init_method;
+}
 
-  // The actual IO is asynchronous, so calling WriteToDisk() shouldn't slow the
-  // merge down much.
-  if (load_result->flush_required)
-    WriteToDisk(INDEX_WRITE_REASON_STARTUP_MERGE);
+bool SimpleIndex::MergeInitializingSetIntoTable(
+    scoped_refptr<SimpleIndexTable> table) {
+  // The table keeps the total size, so merging only has to look at the
+  // entries touched during initialization; the rest of the table is paged in
+  // as it gets used.
+  uint64_t merged_cache_size = table->cache_size();
+  for (uint64_t entry_hash : removed_entries_) {
+    const EntryMetadata* metadata = table->Find(entry_hash);
+    if (!metadata)
+      continue;
+    merged_cache_size -= std::min(merged_cache_size, metadata->GetEntrySize());
+    table->Remove(entry_hash);
+  }
 
-  SIMPLE_CACHE_UMA(CUSTOM_COUNTS,
-                   "IndexInitializationWaiters", cache_type_,
-                   to_run_when_initialized_.size(), 0, 100, 20);
-  // Run all callbacks waiting for the index to come up.
-  for (CallbackList::iterator it = to_run_when_initialized_.begin(),
-       end = to_run_when_initialized_.end(); it != end; ++it) {
-    io_thread_->PostTask(FROM_HERE, base::Bind((*it), net::OK));
+  bool overflowed = false;
+  for (const auto& entry : entries_set_) {
+    const EntryMetadata* metadata = table->Find(entry.first);
+    if (metadata) {
+      merged_cache_size -=
+          std::min(merged_cache_size, metadata->GetEntrySize());
+    }
+    if (table->Insert(entry.first, entry.second))
+      merged_cache_size += entry.second.GetEntrySize();
+    else
+      overflowed = true;
   }
-  to_run_when_initialized_.clear();
+  // The changes made during initialization are kept for the next attempt.
+  if (table->is_corrupt())
+    return false;
+
+  if (overflowed) {
+    LOG(WARNING) << "Simple Cache index table is full.";
+    table_overflowed_ = true;
+  }
+  table_ = std::move(table);
+  removed_entries_.clear();
+  EntrySet().swap(entries_set_);
+  cache_size_ = merged_cache_size;
+  return true;
 }
 
 #if defined(OS_ANDROID)
@@ -470,7 +592,7 @@ void SimpleIndex::WriteToDisk(IndexWriteToDiskReason reason) {
     return;
   SIMPLE_CACHE_UMA(CUSTOM_COUNTS,
                    "IndexNumEntriesOnWrite", cache_type_,
-                   entries_set_.size(), 0, 100000, 50);
+                   EntryCount(), 0, 100000, 50);
   const base::TimeTicks start = base::TimeTicks::Now();
   if (!last_write_to_disk_.is_null()) {
     if (app_on_background_) {
@@ -485,6 +607,14 @@ void SimpleIndex::WriteToDisk(IndexWriteToDiskReason reason) {
   }
   last_write_to_disk_ = start;
 
+  if (table_) {
+    // A table that overflowed is missing entries, so it must not be trusted
+    // on the next load.
+    table_->set_cache_size(cache_size_);
+    index_file_->FlushTable(reason, table_.get(), !table_overflowed_, start,
+                            base::Closure());
+    return;
+  }
   index_file_->WriteToDisk(reason, entries_set_, cache_size_, start,
                            app_on_background_, base::Closure());
 }
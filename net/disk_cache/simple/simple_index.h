@@ -39,6 +39,7 @@ namespace disk_cache {
 
 class SimpleIndexDelegate;
 class SimpleIndexFile;
+class SimpleIndexTable;
 struct SimpleIndexLoadResult;
 
 class NET_EXPORT_PRIVATE EntryMetadata {
@@ -157,6 +158,10 @@ class NET_EXPORT_PRIVATE SimpleIndex
 
   IndexInitMethod init_method() const { return init_method_; }
 
+  // Returns whether the entries live in a memory-mapped SimpleIndexTable
+  // rather than in an EntrySet on the heap.
+  bool is_table_backed() const { return table_.get() != nullptr; }
+
  private:
   friend class SimpleIndexTest;
   FRIEND_TEST_ALL_PREFIXES(SimpleIndexTest, IndexSizeCorrectOnMerge);
@@ -169,10 +174,34 @@ class NET_EXPORT_PRIVATE SimpleIndex
 
   void PostponeWritingToDisk();
 
-  void UpdateEntryIteratorSize(EntrySet::iterator* it, int64_t entry_size);
+  void UpdateEntryMetadataSize(EntryMetadata* metadata, int64_t entry_size);
+
+  // Asks |index_file_| for the entries, which MergeInitializingSet() merges
+  // with the changes made in the meantime.
+  void LoadIndex(base::Time cache_mtime);
+
+  // Drops |table_| once it turned out to be corrupt, and rebuilds the index.
+  // The index is uninitialized until then.
+  void DropCorruptTable();
+
+  // Rebuilds the index from the cache directory, replacing |corrupt_table|.
+  void RebuildIndex(SimpleIndexTable* corrupt_table);
+
+  // Accessors for the indexed entries, which live in |table_| once a mapped
+  // index table has been loaded, and in |entries_set_| otherwise.
+  const EntryMetadata* FindEntry(uint64_t entry_hash) const;
+  EntryMetadata* FindEntryForUpdate(uint64_t entry_hash);
+  void InsertEntry(uint64_t entry_hash, const EntryMetadata& entry_metadata);
+  void EraseEntry(uint64_t entry_hash);
+  size_t EntryCount() const;
+  template <typename Visitor>
+  void ForEachEntry(const Visitor& visitor) const;
 
   // Must run on IO Thread.
   void MergeInitializingSet(std::unique_ptr<SimpleIndexLoadResult> load_result);
+  void MergeInitializingSetIntoEntrySet(EntrySet* index_file_entries);
+  // Returns false, leaving the index untouched, if |table| is corrupt.
+  bool MergeInitializingSetIntoTable(scoped_refptr<SimpleIndexTable> table);
 
 #if defined(OS_ANDROID)
   void OnApplicationStateChange(base::android::ApplicationState state);
@@ -186,6 +215,13 @@ class NET_EXPORT_PRIVATE SimpleIndex
 
   EntrySet entries_set_;
 
+  // When the index file provides a SimpleIndexTable, entries are moved there
+  // as initialization completes and |entries_set_| stays empty afterwards.
+  scoped_refptr<SimpleIndexTable> table_;
+  // Set when |table_| ran out of room. Lookups of unknown entries then have to
+  // go to the disk, and the table is rebuilt bigger on the next load.
+  bool table_overflowed_;
+
   const net::CacheType cache_type_;
   uint64_t cache_size_;  // Total cache storage size in bytes.
   uint64_t max_size_;
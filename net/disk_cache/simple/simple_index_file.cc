@@ -180,6 +180,7 @@ void SimpleIndexLoadResult::Reset() {
   index_write_reason = SimpleIndex::INDEX_WRITE_REASON_MAX;
   flush_required = false;
   entries.clear();
+  table = nullptr;
 }
 
 // static
@@ -351,6 +352,25 @@ void SimpleIndexFile::WriteToDisk(SimpleIndex::IndexWriteToDiskReason reason,
     cache_thread_->PostTaskAndReply(FROM_HERE, task, callback);
 }
 
+void SimpleIndexFile::FlushTable(SimpleIndex::IndexWriteToDiskReason reason,
+                                 SimpleIndexTable* table,
+                                 bool mark_clean,
+                                 const base::TimeTicks& start,
+                                 const base::Closure& callback) {
+  UmaRecordIndexWriteReason(reason, cache_type_);
+  std::unique_ptr<SimpleIndexTable::PendingFlush> flush =
+      table->PrepareFlush(mark_clean);
+  SIMPLE_CACHE_UMA(COUNTS_10000, "IndexTableDirtyPagesOnFlush", cache_type_,
+                   flush->page_count());
+  base::Closure task =
+      base::Bind(&SimpleIndexFile::SyncFlushTable, cache_type_,
+                 cache_directory_, base::Passed(&flush), start);
+  if (callback.is_null())
+    cache_thread_->PostTask(FROM_HERE, task);
+  else
+    cache_thread_->PostTaskAndReply(FROM_HERE, task, callback);
+}
+
 // static
 void SimpleIndexFile::SyncLoadIndexEntries(
     net::CacheType cache_type,
@@ -422,6 +442,25 @@ void SimpleIndexFile::SyncLoadIndexEntries(
   UmaRecordIndexInitMethod(out_result->init_method, cache_type);
 }
 
+// static
+void SimpleIndexFile::SyncFlushTable(
+    net::CacheType cache_type,
+    const base::FilePath& cache_directory,
+    std::unique_ptr<SimpleIndexTable::PendingFlush> flush,
+    const base::TimeTicks& start_time) {
+  base::Time cache_dir_mtime;
+  if (!simple_util::GetMTime(cache_directory, &cache_dir_mtime)) {
+    LOG(ERROR) << "Could obtain information about cache age";
+    return;
+  }
+  if (!SimpleIndexTable::SyncFlush(std::move(flush), cache_dir_mtime)) {
+    LOG(ERROR) << "Failed to flush the Simple Cache index table.";
+    return;
+  }
+  SIMPLE_CACHE_UMA(TIMES, "IndexTableFlushTime", cache_type,
+                   base::TimeTicks::Now() - start_time);
+}
+
 // static
 void SimpleIndexFile::SyncLoadFromDisk(const base::FilePath& index_filename,
                                        base::Time* out_last_cache_seen_by_index,
@@ -19,6 +19,7 @@
 #include "net/base/cache_type.h"
 #include "net/base/net_export.h"
 #include "net/disk_cache/simple/simple_index.h"
+#include "net/disk_cache/simple/simple_index_table.h"
 
 namespace base {
 class SingleThreadTaskRunner;
@@ -36,6 +37,9 @@ struct NET_EXPORT_PRIVATE SimpleIndexLoadResult {
 
   bool did_load;
   SimpleIndex::EntrySet entries;
+  // Set instead of |entries| when the index is backed by a memory-mapped
+  // SimpleIndexTable.
+  scoped_refptr<SimpleIndexTable> table;
   SimpleIndex::IndexWriteToDiskReason index_write_reason;
   SimpleIndex::IndexInitMethod init_method;
   bool flush_required;
@@ -101,6 +105,33 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
                            bool app_on_background,
                            const base::Closure& callback);
 
+  // Writes the pages of |table| modified since its last flush to disk. This
+  // replaces WriteToDisk() when the index is backed by a SimpleIndexTable. If
+  // |mark_clean| is true the table is trusted by the next load, as long as the
+  // cache directory is not modified in the meantime.
+  virtual void FlushTable(SimpleIndex::IndexWriteToDiskReason reason,
+                          SimpleIndexTable* table,
+                          bool mark_clean,
+                          const base::TimeTicks& start,
+                          const base::Closure& callback);
+
+ protected:
+  // Synchronous (IO performing) implementation of LoadIndexEntries.
+  static void SyncLoadIndexEntries(net::CacheType cache_type,
+                                   base::Time cache_last_modified,
+                                   const base::FilePath& cache_directory,
+                                   const base::FilePath& index_file_path,
+                                   SimpleIndexLoadResult* out_result);
+
+  const scoped_refptr<base::SingleThreadTaskRunner> cache_thread_;
+  const scoped_refptr<base::TaskRunner> worker_pool_;
+  const net::CacheType cache_type_;
+  const base::FilePath cache_directory_;
+  const base::FilePath index_file_;
+  const base::FilePath temp_index_file_;
+
+  static const char kIndexDirectory[];
+
  private:
   friend class WrappedSimpleIndexFile;
 
@@ -111,13 +142,6 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
   // prevent reallocation on the IO thread when merging in new live entries.
   static const int kExtraSizeForMerge = 512;
 
-  // Synchronous (IO performing) implementation of LoadIndexEntries.
-  static void SyncLoadIndexEntries(net::CacheType cache_type,
-                                   base::Time cache_last_modified,
-                                   const base::FilePath& cache_directory,
-                                   const base::FilePath& index_file_path,
-                                   SimpleIndexLoadResult* out_result);
-
   // Load the index file from disk returning an EntrySet.
   static void SyncLoadFromDisk(const base::FilePath& index_filename,
                                base::Time* out_last_cache_seen_by_index,
@@ -154,6 +178,14 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
       const base::FilePath& cache_path,
       const EntryFileCallback& entry_file_callback);
 
+  // Writes |flush| to disk, recording the current modification time of
+  // |cache_directory| if the flush marks the table clean.
+  static void SyncFlushTable(
+      net::CacheType cache_type,
+      const base::FilePath& cache_directory,
+      std::unique_ptr<SimpleIndexTable::PendingFlush> flush,
+      const base::TimeTicks& start_time);
+
   // Writes the index file to disk atomically.
   static void SyncWriteToDisk(net::CacheType cache_type,
                               const base::FilePath& cache_directory,
@@ -180,14 +212,6 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
     uint32_t crc;
   };
 
-  const scoped_refptr<base::SingleThreadTaskRunner> cache_thread_;
-  const scoped_refptr<base::TaskRunner> worker_pool_;
-  const net::CacheType cache_type_;
-  const base::FilePath cache_directory_;
-  const base::FilePath index_file_;
-  const base::FilePath temp_index_file_;
-
-  static const char kIndexDirectory[];
   static const char kIndexFileName[];
   static const char kTempIndexFileName[];
 
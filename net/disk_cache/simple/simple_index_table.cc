@@ -0,0 +1,549 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_index_table.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/logging.h"
+#include "base/process/process_metrics.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_restrictions.h"
+
+#if defined(OS_POSIX)
+#include <sys/mman.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#endif
+
+namespace disk_cache {
+
+namespace {
+
+const uint32_t kSimpleIndexTableVersion = 1;
+
+// The table is grown once it is more than 3/4 full.
+const size_t kMaxLoadNumerator = 3;
+const size_t kMaxLoadDenominator = 4;
+
+// A new table reserves room for this many times the slots it starts with, so
+// a cache can grow a lot before the table has to be rebuilt.
+const size_t kReservationMultiplier = 16;
+const size_t kMinReservedCapacity = 1 << 16;
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+bool IsPowerOfTwo(uint64_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+}  // namespace
+
+// static
+const size_t SimpleIndexTable::kMinCapacity;
+// static
+const size_t SimpleIndexTable::kNoSlot;
+
+// The file starts with a Header, followed by |reserved_capacity| Records.
+struct SimpleIndexTable::Header {
+  uint64_t magic_number;
+  uint32_t version;
+  // Set to 1 by a clean flush, cleared as soon as the table is opened.
+  uint32_t clean_shutdown;
+  uint64_t capacity;
+  uint64_t reserved_capacity;
+  uint64_t entry_count;
+  uint64_t cache_size;
+  int64_t cache_last_modified;
+  // The zero hash marks empty slots, so an entry with that hash is stored out
+  // of line.
+  uint32_t has_zero_entry;
+  uint32_t unused;
+  EntryMetadata zero_entry_metadata;
+};
+
+struct SimpleIndexTable::Record {
+  uint64_t hash;
+  EntryMetadata metadata;
+};
+
+SimpleIndexTable::PendingFlush::PendingFlush(
+    scoped_refptr<SimpleIndexTable> table,
+    bool mark_clean)
+    : table_(std::move(table)), page_count_(0), mark_clean_(mark_clean) {}
+
+SimpleIndexTable::PendingFlush::~PendingFlush() {}
+
+SimpleIndexTable::Iterator::Iterator(const SimpleIndexTable* table)
+    : table_(table), slot_(-1) {
+  SkipEmptySlots();
+}
+
+bool SimpleIndexTable::Iterator::IsAtEnd() const {
+  return slot_ >= static_cast<int64_t>(table_->capacity());
+}
+
+uint64_t SimpleIndexTable::Iterator::hash() const {
+  DCHECK(!IsAtEnd());
+  if (slot_ < 0)
+    return 0;
+  return table_->records()[slot_].hash;
+}
+
+const EntryMetadata& SimpleIndexTable::Iterator::metadata() const {
+  DCHECK(!IsAtEnd());
+  if (slot_ < 0)
+    return table_->header()->zero_entry_metadata;
+  return table_->records()[slot_].metadata;
+}
+
+void SimpleIndexTable::Iterator::Advance() {
+  DCHECK(!IsAtEnd());
+  ++slot_;
+  SkipEmptySlots();
+}
+
+void SimpleIndexTable::Iterator::SkipEmptySlots() {
+  if (slot_ < 0 && !table_->header()->has_zero_entry)
+    slot_ = 0;
+  if (slot_ < 0)
+    return;
+  const int64_t capacity = table_->capacity();
+  const Record* records = table_->records();
+  while (slot_ < capacity && records[slot_].hash == 0)
+    ++slot_;
+}
+
+// static
+scoped_refptr<SimpleIndexTable> SimpleIndexTable::Open(
+    const base::FilePath& path,
+    scoped_refptr<base::SingleThreadTaskRunner> io_task_runner) {
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                            base::File::FLAG_WRITE |
+                            base::File::FLAG_SHARE_DELETE);
+  if (!file.IsValid())
+    return nullptr;
+  const int64_t file_length = file.GetLength();
+  if (file_length < static_cast<int64_t>(sizeof(Header)))
+    return nullptr;
+  const size_t reserved_capacity =
+      (static_cast<size_t>(file_length) - sizeof(Header)) / sizeof(Record);
+
+  scoped_refptr<SimpleIndexTable> table(
+      new SimpleIndexTable(path, std::move(io_task_runner)));
+  if (!table->Map(std::move(file), reserved_capacity))
+    return nullptr;
+
+  Header* header = table->header();
+  if (header->magic_number != kSimpleIndexTableMagicNumber ||
+      header->version != kSimpleIndexTableVersion) {
+    LOG(WARNING) << "Invalid Simple Cache index table header.";
+    return nullptr;
+  }
+  if (!IsPowerOfTwo(header->capacity) ||
+      header->capacity > header->reserved_capacity ||
+      header->reserved_capacity > reserved_capacity ||
+      header->entry_count >= header->capacity) {
+    LOG(WARNING) << "Corrupt Simple Cache index table.";
+    return nullptr;
+  }
+  if (!header->clean_shutdown) {
+    VLOG(1) << "Simple Cache index table was not closed cleanly.";
+    return nullptr;
+  }
+
+  // From now on a crash leaves pages of the table in an unknown state, so the
+  // file must not be trusted again until the next clean flush.
+  header->clean_shutdown = 0;
+  if (!table->SyncRange(0, sizeof(Header)))
+    return nullptr;
+  return table;
+}
+
+// static
+scoped_refptr<SimpleIndexTable> SimpleIndexTable::Create(
+    const base::FilePath& path,
+    size_t expected_entries,
+    scoped_refptr<base::SingleThreadTaskRunner> io_task_runner) {
+  size_t capacity = RoundUpToPowerOfTwo(
+      expected_entries * kMaxLoadDenominator / kMaxLoadNumerator + 1);
+  capacity = std::max(capacity, kMinCapacity);
+  const size_t reserved_capacity =
+      std::max(capacity * kReservationMultiplier, kMinReservedCapacity);
+
+  base::File file(path, base::File::FLAG_CREATE_ALWAYS |
+                            base::File::FLAG_READ | base::File::FLAG_WRITE |
+                            base::File::FLAG_SHARE_DELETE);
+  if (!file.IsValid())
+    return nullptr;
+
+  scoped_refptr<SimpleIndexTable> table(
+      new SimpleIndexTable(path, std::move(io_task_runner)));
+  if (!table->Map(std::move(file), reserved_capacity))
+    return nullptr;
+
+  // The file is freshly extended, so it is all zeroes already.
+  Header* header = table->header();
+  header->magic_number = kSimpleIndexTableMagicNumber;
+  header->version = kSimpleIndexTableVersion;
+  header->clean_shutdown = 0;
+  header->capacity = capacity;
+  header->reserved_capacity = reserved_capacity;
+  if (!table->SyncRange(0, sizeof(Header)))
+    return nullptr;
+  return table;
+}
+
+SimpleIndexTable::SimpleIndexTable(
+    const base::FilePath& path,
+    scoped_refptr<base::SingleThreadTaskRunner> io_task_runner)
+    : base::RefCountedDeleteOnMessageLoop<SimpleIndexTable>(
+          std::move(io_task_runner)),
+      path_(path),
+      page_size_(base::GetPageSize()),
+      dirty_page_count_(0),
+      may_be_clean_(false),
+      corrupt_(false),
+      clean_flush_pending_(false) {
+  static_assert(sizeof(Header) == 72, "incorrect index table header size");
+  static_assert(sizeof(Record) == 16, "incorrect index table record size");
+}
+
+SimpleIndexTable::~SimpleIndexTable() {}
+
+bool SimpleIndexTable::Map(base::File file, size_t reserved_capacity) {
+  base::MemoryMappedFile::Region region;
+  region.offset = 0;
+  region.size = sizeof(Header) + reserved_capacity * sizeof(Record);
+  if (!mapping_.Initialize(std::move(file), region,
+                           base::MemoryMappedFile::READ_WRITE_EXTEND)) {
+    return false;
+  }
+  dirty_pages_.assign((mapping_.length() + page_size_ - 1) / page_size_,
+                      false);
+  return true;
+}
+
+const EntryMetadata* SimpleIndexTable::Find(uint64_t entry_hash) const {
+  if (entry_hash == 0)
+    return header()->has_zero_entry ? &header()->zero_entry_metadata : nullptr;
+  const size_t slot = FindSlot(entry_hash);
+  if (slot == kNoSlot)
+    return nullptr;
+  const Record& record = records()[slot];
+  return record.hash == entry_hash ? &record.metadata : nullptr;
+}
+
+EntryMetadata* SimpleIndexTable::FindForUpdate(uint64_t entry_hash) {
+  if (entry_hash == 0) {
+    if (!header()->has_zero_entry)
+      return nullptr;
+    MarkHeaderDirty();
+    return &header()->zero_entry_metadata;
+  }
+  const size_t slot = FindSlot(entry_hash);
+  if (slot == kNoSlot || records()[slot].hash != entry_hash)
+    return nullptr;
+  MarkSlotDirty(slot);
+  return &records()[slot].metadata;
+}
+
+bool SimpleIndexTable::Insert(uint64_t entry_hash,
+                              const EntryMetadata& metadata) {
+  if (entry_hash == 0) {
+    if (!header()->has_zero_entry) {
+      header()->has_zero_entry = 1;
+      ++header()->entry_count;
+    }
+    header()->zero_entry_metadata = metadata;
+    MarkHeaderDirty();
+    return true;
+  }
+
+  size_t slot = FindSlot(entry_hash);
+  if (slot == kNoSlot)
+    return false;
+  if (records()[slot].hash == entry_hash) {
+    records()[slot].metadata = metadata;
+    MarkSlotDirty(slot);
+    return true;
+  }
+
+  if ((header()->entry_count + 1) * kMaxLoadDenominator >
+      capacity() * kMaxLoadNumerator) {
+    if (!Grow())
+      return false;
+  }
+  InsertNoGrow(entry_hash, metadata);
+  ++header()->entry_count;
+  MarkHeaderDirty();
+  return true;
+}
+
+bool SimpleIndexTable::Remove(uint64_t entry_hash) {
+  if (entry_hash == 0) {
+    if (!header()->has_zero_entry)
+      return false;
+    header()->has_zero_entry = 0;
+    header()->zero_entry_metadata = EntryMetadata();
+  } else {
+    const size_t slot = FindSlot(entry_hash);
+    if (slot == kNoSlot || records()[slot].hash != entry_hash)
+      return false;
+    RemoveAt(slot);
+  }
+  DCHECK_GT(header()->entry_count, 0u);
+  --header()->entry_count;
+  MarkHeaderDirty();
+  return true;
+}
+
+size_t SimpleIndexTable::size() const {
+  return static_cast<size_t>(header()->entry_count);
+}
+
+size_t SimpleIndexTable::capacity() const {
+  return static_cast<size_t>(header()->capacity);
+}
+
+size_t SimpleIndexTable::reserved_capacity() const {
+  return static_cast<size_t>(header()->reserved_capacity);
+}
+
+uint64_t SimpleIndexTable::cache_size() const {
+  return header()->cache_size;
+}
+
+base::Time SimpleIndexTable::cache_last_modified() const {
+  base::AutoLock lock(header_lock_);
+  return base::Time::FromInternalValue(header()->cache_last_modified);
+}
+
+void SimpleIndexTable::set_cache_size(uint64_t cache_size) {
+  if (header()->cache_size == cache_size)
+    return;
+  header()->cache_size = cache_size;
+  MarkHeaderDirty();
+}
+
+std::unique_ptr<SimpleIndexTable::PendingFlush> SimpleIndexTable::PrepareFlush(
+    bool mark_clean) {
+  // A corrupt table must not be loaded again, even if it was flushed cleanly
+  // before the corruption was found.
+  if (corrupt_) {
+    if (may_be_clean_)
+      MarkInUse();
+    mark_clean = false;
+  }
+  std::unique_ptr<PendingFlush> flush(new PendingFlush(this, mark_clean));
+  size_t run_start = 0;
+  bool in_run = false;
+  for (size_t page = 0; page <= dirty_pages_.size(); ++page) {
+    const bool dirty = page < dirty_pages_.size() && dirty_pages_[page];
+    if (dirty && !in_run) {
+      run_start = page;
+      in_run = true;
+    } else if (!dirty && in_run) {
+      const size_t offset = run_start * page_size_;
+      const size_t length =
+          std::min(page * page_size_, mapping_.length()) - offset;
+      flush->ranges_.push_back(std::make_pair(offset, length));
+      in_run = false;
+    }
+  }
+  flush->page_count_ = dirty_page_count_;
+  dirty_pages_.assign(dirty_pages_.size(), false);
+  dirty_page_count_ = 0;
+  if (mark_clean) {
+    may_be_clean_ = true;
+    base::AutoLock lock(header_lock_);
+    clean_flush_pending_ = true;
+  }
+  return flush;
+}
+
+// static
+bool SimpleIndexTable::SyncFlush(std::unique_ptr<PendingFlush> flush,
+                                 base::Time cache_last_modified) {
+  SimpleIndexTable* table = flush->table_.get();
+  DCHECK(table->task_runner_->BelongsToCurrentThread());
+  bool success = true;
+  for (const auto& range : flush->ranges_)
+    success &= table->SyncRange(range.first, range.second);
+  // The clean bit must only reach the disk after every other page did.
+  if (success && flush->mark_clean_) {
+    {
+      base::AutoLock lock(table->header_lock_);
+      // If the table was modified since PrepareFlush(), some of its pages are
+      // not part of this flush, so it is left marked as in use.
+      if (!table->clean_flush_pending_)
+        return success;
+      table->clean_flush_pending_ = false;
+      Header* header = table->header();
+      header->cache_last_modified = cache_last_modified.ToInternalValue();
+      header->clean_shutdown = 1;
+    }
+    success = table->SyncRange(0, sizeof(Header));
+  }
+  return success;
+}
+
+SimpleIndexTable::Header* SimpleIndexTable::header() {
+  return reinterpret_cast<Header*>(mapping_.data());
+}
+
+const SimpleIndexTable::Header* SimpleIndexTable::header() const {
+  return reinterpret_cast<const Header*>(mapping_.data());
+}
+
+SimpleIndexTable::Record* SimpleIndexTable::records() {
+  return reinterpret_cast<Record*>(mapping_.data() + sizeof(Header));
+}
+
+const SimpleIndexTable::Record* SimpleIndexTable::records() const {
+  return reinterpret_cast<const Record*>(mapping_.data() + sizeof(Header));
+}
+
+size_t SimpleIndexTable::FindSlot(uint64_t entry_hash) const {
+  DCHECK_NE(0u, entry_hash);
+  const size_t mask = capacity() - 1;
+  const Record* records = this->records();
+  // Entry hashes are taken from a SHA-1 of the key, so the low bits are
+  // already well distributed.
+  size_t slot = static_cast<size_t>(entry_hash) & mask;
+  // The load factor guarantees an empty slot, unless the file is corrupt.
+  for (size_t probes = 0; probes < capacity(); ++probes) {
+    if (records[slot].hash == 0 || records[slot].hash == entry_hash)
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+  if (!corrupt_) {
+    LOG(WARNING) << "Corrupt Simple Cache index table: no empty slot.";
+    corrupt_ = true;
+  }
+  return kNoSlot;
+}
+
+bool SimpleIndexTable::Grow() {
+  const size_t old_capacity = capacity();
+  const size_t new_capacity = old_capacity * 2;
+  if (new_capacity > reserved_capacity())
+    return false;
+
+  std::vector<Record> live_records;
+  live_records.reserve(header()->entry_count);
+  for (size_t slot = 0; slot < old_capacity; ++slot) {
+    if (records()[slot].hash != 0)
+      live_records.push_back(records()[slot]);
+  }
+
+  memset(records(), 0, new_capacity * sizeof(Record));
+  header()->capacity = new_capacity;
+  MarkHeaderDirty();
+  MarkDirty(records(), new_capacity * sizeof(Record));
+  for (const Record& record : live_records)
+    InsertNoGrow(record.hash, record.metadata);
+  return true;
+}
+
+void SimpleIndexTable::InsertNoGrow(uint64_t entry_hash,
+                                    const EntryMetadata& metadata) {
+  const size_t slot = FindSlot(entry_hash);
+  DCHECK_NE(kNoSlot, slot);
+  DCHECK_EQ(0u, records()[slot].hash);
+  records()[slot].hash = entry_hash;
+  records()[slot].metadata = metadata;
+  MarkSlotDirty(slot);
+}
+
+void SimpleIndexTable::RemoveAt(size_t slot) {
+  // Backward-shift deletion: move later members of the probe run into the
+  // hole so that lookups never stop early at an empty slot.
+  const size_t mask = capacity() - 1;
+  Record* records = this->records();
+  size_t hole = slot;
+  size_t next = slot;
+  // Stops at the first empty slot, or after visiting every other slot of a
+  // table without empty slots.
+  for (size_t probes = 1; probes < capacity(); ++probes) {
+    next = (next + 1) & mask;
+    if (records[next].hash == 0)
+      break;
+    const size_t home = static_cast<size_t>(records[next].hash) & mask;
+    // The record at |next| may fill the hole only if its home slot is not
+    // cyclically within (hole, next].
+    const bool home_in_range = hole <= next ? (hole < home && home <= next)
+                                            : (hole < home || home <= next);
+    if (home_in_range)
+      continue;
+    records[hole] = records[next];
+    MarkSlotDirty(hole);
+    hole = next;
+  }
+  records[hole].hash = 0;
+  records[hole].metadata = EntryMetadata();
+  MarkSlotDirty(hole);
+}
+
+void SimpleIndexTable::MarkDirty(const void* address, size_t length) {
+  DCHECK_GT(length, 0u);
+  if (may_be_clean_)
+    MarkInUse();
+  const size_t offset =
+      static_cast<const uint8_t*>(address) - mapping_.data();
+  DCHECK_LE(offset + length, mapping_.length());
+  const size_t last_page = (offset + length - 1) / page_size_;
+  for (size_t page = offset / page_size_; page <= last_page; ++page) {
+    if (!dirty_pages_[page]) {
+      dirty_pages_[page] = true;
+      ++dirty_page_count_;
+    }
+  }
+}
+
+void SimpleIndexTable::MarkSlotDirty(size_t slot) {
+  MarkDirty(&records()[slot], sizeof(Record));
+}
+
+void SimpleIndexTable::MarkHeaderDirty() {
+  MarkDirty(header(), sizeof(Header));
+}
+
+void SimpleIndexTable::MarkInUse() {
+  may_be_clean_ = false;
+  {
+    base::AutoLock lock(header_lock_);
+    clean_flush_pending_ = false;
+    header()->clean_shutdown = 0;
+  }
+  MarkHeaderDirty();
+}
+
+bool SimpleIndexTable::SyncRange(size_t offset, size_t length) {
+  base::ThreadRestrictions::AssertIOAllowed();
+  DCHECK_EQ(0u, offset % page_size_);
+#if defined(OS_POSIX)
+  if (msync(mapping_.data() + offset, length, MS_SYNC) != 0) {
+    DPLOG(ERROR) << "msync " << path_.value();
+    return false;
+  }
+#elif defined(OS_WIN)
+  if (!::FlushViewOfFile(mapping_.data() + offset, length)) {
+    DPLOG(ERROR) << "FlushViewOfFile " << path_.value();
+    return false;
+  }
+#endif
+  return true;
+}
+
+}  // namespace disk_cache
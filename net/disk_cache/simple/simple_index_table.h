@@ -0,0 +1,255 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_H_
+#define NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_delete_on_message_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/simple/simple_index.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace disk_cache {
+
+const uint64_t kSimpleIndexTableMagicNumber = UINT64_C(0x656c626174786469);
+
+// SimpleIndexTable is an open-addressed hash table of packed EntryMetadata
+// records which lives directly in a memory-mapped file. It is an alternative
+// to keeping SimpleIndex::EntrySet on the heap: the table is never
+// deserialized, pages are faulted in lazily as the index touches them, and
+// updates are made in place. Pages modified since the last flush are tracked
+// so that a flush only writes those back.
+//
+// The file reserves room for |reserved_capacity()| slots up front (it is
+// sparse on POSIX), of which the first |capacity()| are in use. Growing the
+// table therefore never needs to remap the file and never does blocking IO on
+// the calling thread. Once the reservation is exhausted Insert() fails and the
+// caller is expected to rebuild the table with a bigger reservation.
+//
+// Entries are keyed by their 64-bit entry hash. Collisions are resolved by
+// linear probing, and removal uses backward-shift deletion so the table never
+// accumulates tombstones.
+//
+// A lookup gives up after probing every slot in use, which only happens when
+// the file was corrupted into a table without empty slots. The table is then
+// reported as corrupt and the caller is expected to drop it and rebuild the
+// index.
+//
+// Lookups and mutations must happen on a single thread (the IO thread for the
+// simple backend), and never block on the file. Open() and Create() perform
+// blocking IO on the thread that calls them, which must allow it (a worker
+// thread for the simple backend). |io_task_runner|, passed in at creation,
+// must run on such a thread too: SyncFlush() has to run there, and the last
+// reference is always released there, so that unmapping the file does not
+// happen on the thread using the table.
+class NET_EXPORT_PRIVATE SimpleIndexTable
+    : public base::RefCountedDeleteOnMessageLoop<SimpleIndexTable> {
+ public:
+  // A snapshot of the pages dirtied since the previous flush. It can be handed
+  // to another thread and written back with SyncFlush().
+  class NET_EXPORT_PRIVATE PendingFlush {
+   public:
+    ~PendingFlush();
+
+    size_t page_count() const { return page_count_; }
+
+   private:
+    friend class SimpleIndexTable;
+
+    PendingFlush(scoped_refptr<SimpleIndexTable> table, bool mark_clean);
+
+    scoped_refptr<SimpleIndexTable> table_;
+    // Dirty byte ranges, as (offset, length) pairs rounded to whole pages.
+    std::vector<std::pair<size_t, size_t>> ranges_;
+    size_t page_count_;
+    const bool mark_clean_;
+
+    DISALLOW_COPY_AND_ASSIGN(PendingFlush);
+  };
+
+  // Iterates over the live entries of the table. The table must not be
+  // mutated while an Iterator is in use.
+  class NET_EXPORT_PRIVATE Iterator {
+   public:
+    explicit Iterator(const SimpleIndexTable* table);
+
+    bool IsAtEnd() const;
+    uint64_t hash() const;
+    const EntryMetadata& metadata() const;
+    void Advance();
+
+   private:
+    void SkipEmptySlots();
+
+    const SimpleIndexTable* table_;
+    // -1 designates the out-of-line slot for the zero hash.
+    int64_t slot_;
+
+    DISALLOW_COPY_AND_ASSIGN(Iterator);
+  };
+
+  // Smallest number of slots a table is created with.
+  static const size_t kMinCapacity = 1024;
+
+  // Opens the table stored at |path|. Returns nullptr if the file is missing,
+  // has a different format version, or was not flushed cleanly by its last
+  // user; the caller is then expected to rebuild the index from the cache
+  // directory and Create() a new table. On success the table is marked as in
+  // use on disk, so a crash before the next clean flush invalidates it.
+  //
+  // Like the pickled index file, a clean table can still be stale if the
+  // cache was modified after its last flush; callers should compare
+  // cache_last_modified() with the modification time of the cache directory.
+  static scoped_refptr<SimpleIndexTable> Open(
+      const base::FilePath& path,
+      scoped_refptr<base::SingleThreadTaskRunner> io_task_runner);
+
+  // Creates an empty table at |path|, replacing any existing file. The file
+  // reserves room for at least |expected_entries| entries plus growth.
+  static scoped_refptr<SimpleIndexTable> Create(
+      const base::FilePath& path,
+      size_t expected_entries,
+      scoped_refptr<base::SingleThreadTaskRunner> io_task_runner);
+
+  // Returns the metadata stored for |entry_hash| or nullptr. The pointer is
+  // only valid until the next mutation of the table.
+  const EntryMetadata* Find(uint64_t entry_hash) const;
+
+  // Same as Find(), but marks the record as modified so that writes through
+  // the returned pointer are picked up by the next flush.
+  EntryMetadata* FindForUpdate(uint64_t entry_hash);
+
+  // Inserts |entry_hash| or overwrites its metadata if it is already present.
+  // Returns false if the table is full and could not grow, or is corrupt.
+  bool Insert(uint64_t entry_hash, const EntryMetadata& metadata);
+
+  // Removes |entry_hash|. Returns whether it was present.
+  bool Remove(uint64_t entry_hash);
+
+  size_t size() const;
+  size_t capacity() const;
+  size_t reserved_capacity() const;
+
+  // Total size of the cache as last recorded by the index. It is persisted
+  // with the table so that a lazily loaded index does not have to visit every
+  // record to compute it.
+  uint64_t cache_size() const;
+  void set_cache_size(uint64_t cache_size);
+
+  // Modification time of the cache directory recorded by the last clean
+  // flush.
+  base::Time cache_last_modified() const;
+
+  // Whether a lookup found no empty slot after probing every slot in use. A
+  // corrupt table is never marked clean again, and lookups of missing entries
+  // keep failing.
+  bool is_corrupt() const { return corrupt_; }
+
+  // Number of pages modified since the last PrepareFlush().
+  size_t dirty_page_count() const { return dirty_page_count_; }
+
+  // Collects the pages modified since the previous call. If |mark_clean| is
+  // true the table is additionally recorded as cleanly closed once the pages
+  // are written, which makes the next Open() succeed, unless the table is
+  // modified in the meantime. Modifying the table after a clean flush marks
+  // it as in use again.
+  std::unique_ptr<PendingFlush> PrepareFlush(bool mark_clean);
+
+  // Writes |flush| back to the file. Must run on the IO task runner. A clean
+  // flush records |cache_last_modified| as the modification time of the cache
+  // directory the table is up to date with. Returns false on error.
+  static bool SyncFlush(std::unique_ptr<PendingFlush> flush,
+                        base::Time cache_last_modified);
+
+  const base::FilePath& path() const { return path_; }
+
+ private:
+  friend class base::RefCountedDeleteOnMessageLoop<SimpleIndexTable>;
+  friend class base::DeleteHelper<SimpleIndexTable>;
+
+  struct Header;
+  struct Record;
+
+  SimpleIndexTable(const base::FilePath& path,
+                   scoped_refptr<base::SingleThreadTaskRunner> io_task_runner);
+  ~SimpleIndexTable();
+
+  // Maps |file| with room for |reserved_capacity| slots.
+  bool Map(base::File file, size_t reserved_capacity);
+
+  Header* header();
+  const Header* header() const;
+  Record* records();
+  const Record* records() const;
+
+  // Returned by FindSlot() when it runs out of slots.
+  static const size_t kNoSlot = static_cast<size_t>(-1);
+
+  // Returns the slot holding |entry_hash|, or the empty slot where it would
+  // be inserted. |entry_hash| must not be zero. Returns kNoSlot, and marks the
+  // table as corrupt, if neither is found after probing every slot.
+  size_t FindSlot(uint64_t entry_hash) const;
+
+  // Doubles the number of slots in use. Returns false if the reservation is
+  // exhausted.
+  bool Grow();
+
+  void InsertNoGrow(uint64_t entry_hash, const EntryMetadata& metadata);
+  void RemoveAt(size_t slot);
+
+  void MarkDirty(const void* address, size_t length);
+  void MarkSlotDirty(size_t slot);
+  void MarkHeaderDirty();
+
+  // Clears the clean bit set by a clean flush, or cancels a clean flush in
+  // flight, before the table is modified.
+  void MarkInUse();
+
+  // Writes the byte range [offset, offset + length) of the mapping back to the
+  // file.
+  bool SyncRange(size_t offset, size_t length);
+
+  const base::FilePath path_;
+  base::MemoryMappedFile mapping_;
+  const size_t page_size_;
+
+  // One bit per page of |mapping_|.
+  std::vector<bool> dirty_pages_;
+  size_t dirty_page_count_;
+
+  // Whether a clean flush was prepared since the table was last modified.
+  bool may_be_clean_;
+
+  // Set by FindSlot(), which is const.
+  mutable bool corrupt_;
+
+  // Guards the |clean_shutdown| and |cache_last_modified| fields of the
+  // header, which SyncFlush() writes on the IO task runner while the table
+  // is used on another thread, and |clean_flush_pending_|.
+  mutable base::Lock header_lock_;
+  bool clean_flush_pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleIndexTable);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_H_
@@ -0,0 +1,111 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_index_table_file.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/task_runner.h"
+#include "base/time/time.h"
+#include "net/disk_cache/simple/simple_histogram_macros.h"
+#include "net/disk_cache/simple/simple_index_table.h"
+#include "net/disk_cache/simple/simple_util.h"
+
+namespace disk_cache {
+
+// static
+const char SimpleIndexTableFile::kTableFileName[] = "the-real-index-table";
+
+SimpleIndexTableFile::SimpleIndexTableFile(
+    const scoped_refptr<base::SingleThreadTaskRunner>& cache_thread,
+    const scoped_refptr<base::TaskRunner>& worker_pool,
+    net::CacheType cache_type,
+    const base::FilePath& cache_directory)
+    : SimpleIndexFile(cache_thread, worker_pool, cache_type, cache_directory),
+      table_file_(cache_directory.AppendASCII(kIndexDirectory)
+                      .AppendASCII(kTableFileName)) {}
+
+SimpleIndexTableFile::~SimpleIndexTableFile() {}
+
+void SimpleIndexTableFile::LoadIndexEntries(
+    base::Time cache_last_modified,
+    const base::Closure& callback,
+    SimpleIndexLoadResult* out_result) {
+  base::Closure task = base::Bind(
+      &SimpleIndexTableFile::SyncLoadIndexTable, cache_type_,
+      cache_last_modified, cache_directory_, index_file_, table_file_,
+      cache_thread_, out_result);
+  worker_pool_->PostTaskAndReply(FROM_HERE, task, callback);
+}
+
+// static
+void SimpleIndexTableFile::SyncLoadIndexTable(
+    net::CacheType cache_type,
+    base::Time cache_last_modified,
+    const base::FilePath& cache_directory,
+    const base::FilePath& index_file_path,
+    const base::FilePath& table_file_path,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cache_thread,
+    SimpleIndexLoadResult* out_result) {
+  out_result->Reset();
+  const base::TimeTicks start = base::TimeTicks::Now();
+
+  scoped_refptr<SimpleIndexTable> table =
+      SimpleIndexTable::Open(table_file_path, cache_thread);
+  if (table && cache_last_modified <= table->cache_last_modified()) {
+    SIMPLE_CACHE_UMA(TIMES, "IndexTableOpenTime", cache_type,
+                     base::TimeTicks::Now() - start);
+    out_result->table = std::move(table);
+    out_result->did_load = true;
+    out_result->init_method = SimpleIndex::INITIALIZE_METHOD_LOADED;
+    return;
+  }
+  // A stale table is rebuilt from scratch below.
+  table = nullptr;
+
+  // Recover the entries the same way the pickled index would, which also picks
+  // up a fresh index file written while the table was not in use.
+  SyncLoadIndexEntries(cache_type, cache_last_modified, cache_directory,
+                       index_file_path, out_result);
+  if (!out_result->did_load)
+    return;
+
+  const base::FilePath index_directory = table_file_path.DirName();
+  if (!base::DirectoryExists(index_directory) &&
+      !base::CreateDirectory(index_directory)) {
+    LOG(ERROR) << "Could not create a directory to hold the index table";
+    return;
+  }
+  table = SimpleIndexTable::Create(
+      table_file_path, out_result->entries.size(), cache_thread);
+  if (!table) {
+    // Keep the recovered entries; the index then runs off the heap as usual.
+    LOG(ERROR) << "Could not create the Simple Cache index table";
+    return;
+  }
+
+  uint64_t cache_size = 0;
+  for (const auto& entry : out_result->entries) {
+    if (!table->Insert(entry.first, entry.second)) {
+      LOG(ERROR) << "Simple Cache index table is full";
+      return;
+    }
+    cache_size += entry.second.GetEntrySize();
+  }
+  table->set_cache_size(cache_size);
+  SimpleIndex::EntrySet().swap(out_result->entries);
+  out_result->table = std::move(table);
+  // Write the new table out right away, as SyncRestoreFromDisk() does for the
+  // pickled index.
+  out_result->flush_required = true;
+
+  // The pickled index is not kept up to date while the table is in use.
+  simple_util::SimpleCacheDeleteFile(index_file_path);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,61 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_FILE_H_
+#define NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_FILE_H_
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/cache_type.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/simple/simple_index_file.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+class TaskRunner;
+}
+
+namespace disk_cache {
+
+// SimpleIndexTableFile loads the index as a memory-mapped SimpleIndexTable
+// instead of a pickled EntrySet. When there is no usable table on disk, the
+// entries are recovered the same way SimpleIndexFile does it (from a fresh
+// pickled index left by a previous version, or by scanning the cache
+// directory) and a new table is built from them.
+class NET_EXPORT_PRIVATE SimpleIndexTableFile : public SimpleIndexFile {
+ public:
+  SimpleIndexTableFile(
+      const scoped_refptr<base::SingleThreadTaskRunner>& cache_thread,
+      const scoped_refptr<base::TaskRunner>& worker_pool,
+      net::CacheType cache_type,
+      const base::FilePath& cache_directory);
+  ~SimpleIndexTableFile() override;
+
+  // SimpleIndexFile:
+  void LoadIndexEntries(base::Time cache_last_modified,
+                        const base::Closure& callback,
+                        SimpleIndexLoadResult* out_result) override;
+
+ private:
+  // Synchronous (IO performing) implementation of LoadIndexEntries.
+  static void SyncLoadIndexTable(
+      net::CacheType cache_type,
+      base::Time cache_last_modified,
+      const base::FilePath& cache_directory,
+      const base::FilePath& index_file_path,
+      const base::FilePath& table_file_path,
+      const scoped_refptr<base::SingleThreadTaskRunner>& cache_thread,
+      SimpleIndexLoadResult* out_result);
+
+  const base::FilePath table_file_;
+
+  static const char kTableFileName[];
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleIndexTableFile);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_SIMPLE_INDEX_TABLE_FILE_H_
@@ -0,0 +1,324 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_index_table.h"
+
+#include <string.h>
+
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "net/disk_cache/simple/simple_index.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace disk_cache {
+
+namespace {
+
+const base::Time kTestLastUsedTime =
+    base::Time::UnixEpoch() + base::TimeDelta::FromDays(20);
+
+// Layout of the table file, see the static_asserts in simple_index_table.cc.
+const int kHeaderSize = 72;
+const int kRecordSize = 16;
+
+}  // namespace
+
+class SimpleIndexTableTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    table_path_ = temp_dir_.path().AppendASCII("index-table");
+  }
+
+  scoped_refptr<SimpleIndexTable> CreateTable(size_t expected_entries) {
+    return SimpleIndexTable::Create(table_path_, expected_entries,
+                                    base::ThreadTaskRunnerHandle::Get());
+  }
+
+  scoped_refptr<SimpleIndexTable> OpenTable() {
+    return SimpleIndexTable::Open(table_path_,
+                                  base::ThreadTaskRunnerHandle::Get());
+  }
+
+  bool Flush(SimpleIndexTable* table, bool mark_clean) {
+    return SimpleIndexTable::SyncFlush(table->PrepareFlush(mark_clean),
+                                       kTestLastUsedTime);
+  }
+
+  // Returns hashes which all have |home_slot| as their first probe in a table
+  // of |capacity| slots.
+  static uint64_t CollidingHash(size_t capacity, size_t home_slot, int n) {
+    return static_cast<uint64_t>(n + 1) * capacity + home_slot;
+  }
+
+  // Writes an entry into each of the first |capacity| slots of the table
+  // file, without updating its header, as only a corrupted file would.
+  void FillAllSlots(size_t capacity) {
+    base::File file(table_path_,
+                    base::File::FLAG_OPEN | base::File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    for (size_t slot = 0; slot < capacity; ++slot) {
+      char record[kRecordSize] = {};
+      const uint64_t hash = CollidingHash(capacity, slot, 0);
+      memcpy(record, &hash, sizeof(hash));
+      const int64_t offset =
+          kHeaderSize + static_cast<int64_t>(slot) * kRecordSize;
+      ASSERT_EQ(kRecordSize, file.Write(offset, record, kRecordSize));
+    }
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath table_path_;
+};
+
+TEST_F(SimpleIndexTableTest, InsertFindRemove) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+  ASSERT_TRUE(table);
+  EXPECT_EQ(0U, table->size());
+  EXPECT_EQ(SimpleIndexTable::kMinCapacity, table->capacity());
+  EXPECT_FALSE(table->Find(12345));
+
+  EXPECT_TRUE(table->Insert(12345, EntryMetadata(kTestLastUsedTime, 100)));
+  EXPECT_EQ(1U, table->size());
+  const EntryMetadata* metadata = table->Find(12345);
+  ASSERT_TRUE(metadata);
+  EXPECT_EQ(100U, metadata->GetEntrySize());
+  EXPECT_EQ(kTestLastUsedTime, metadata->GetLastUsedTime());
+
+  // Inserting an existing hash overwrites its metadata.
+  EXPECT_TRUE(table->Insert(12345, EntryMetadata(kTestLastUsedTime, 200)));
+  EXPECT_EQ(1U, table->size());
+  EXPECT_EQ(200U, table->Find(12345)->GetEntrySize());
+
+  table->FindForUpdate(12345)->SetEntrySize(300);
+  EXPECT_EQ(300U, table->Find(12345)->GetEntrySize());
+
+  EXPECT_TRUE(table->Remove(12345));
+  EXPECT_FALSE(table->Remove(12345));
+  EXPECT_EQ(0U, table->size());
+  EXPECT_FALSE(table->Find(12345));
+}
+
+TEST_F(SimpleIndexTableTest, ZeroHash) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+  ASSERT_TRUE(table);
+  EXPECT_FALSE(table->Find(0));
+  EXPECT_TRUE(table->Insert(0, EntryMetadata(kTestLastUsedTime, 7)));
+  EXPECT_TRUE(table->Insert(1, EntryMetadata(kTestLastUsedTime, 8)));
+  EXPECT_EQ(2U, table->size());
+  ASSERT_TRUE(table->Find(0));
+  EXPECT_EQ(7U, table->Find(0)->GetEntrySize());
+
+  std::set<uint64_t> seen;
+  for (SimpleIndexTable::Iterator it(table.get()); !it.IsAtEnd(); it.Advance())
+    seen.insert(it.hash());
+  EXPECT_EQ(std::set<uint64_t>({0, 1}), seen);
+
+  EXPECT_TRUE(table->Remove(0));
+  EXPECT_FALSE(table->Find(0));
+  EXPECT_EQ(1U, table->size());
+}
+
+// Removing an entry in the middle of a probe run must keep the rest of the
+// run reachable.
+TEST_F(SimpleIndexTableTest, RemoveKeepsProbeRuns) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+  ASSERT_TRUE(table);
+  const size_t capacity = table->capacity();
+
+  // Build a run that wraps around the end of the table.
+  const size_t home_slot = capacity - 2;
+  const int kRunLength = 6;
+  for (int i = 0; i < kRunLength; ++i) {
+    EXPECT_TRUE(table->Insert(CollidingHash(capacity, home_slot, i),
+                              EntryMetadata(kTestLastUsedTime, i)));
+  }
+  // And an entry whose home slot is inside the wrapped part of the run.
+  const uint64_t kWrappedHash = CollidingHash(capacity, 1, 0);
+  EXPECT_TRUE(table->Insert(kWrappedHash, EntryMetadata(kTestLastUsedTime, 9)));
+
+  EXPECT_TRUE(table->Remove(CollidingHash(capacity, home_slot, 1)));
+  EXPECT_TRUE(table->Remove(CollidingHash(capacity, home_slot, 4)));
+  for (int i = 0; i < kRunLength; ++i) {
+    const EntryMetadata* metadata =
+        table->Find(CollidingHash(capacity, home_slot, i));
+    if (i == 1 || i == 4) {
+      EXPECT_FALSE(metadata);
+    } else {
+      ASSERT_TRUE(metadata);
+      EXPECT_EQ(static_cast<uint64_t>(i), metadata->GetEntrySize());
+    }
+  }
+  ASSERT_TRUE(table->Find(kWrappedHash));
+  EXPECT_EQ(9U, table->Find(kWrappedHash)->GetEntrySize());
+  EXPECT_EQ(static_cast<size_t>(kRunLength - 1), table->size());
+}
+
+TEST_F(SimpleIndexTableTest, Grow) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+  ASSERT_TRUE(table);
+  const size_t kNumEntries = SimpleIndexTable::kMinCapacity * 4;
+  for (size_t i = 1; i <= kNumEntries; ++i)
+    EXPECT_TRUE(table->Insert(i * 7919, EntryMetadata(kTestLastUsedTime, i)));
+
+  EXPECT_EQ(kNumEntries, table->size());
+  EXPECT_LT(SimpleIndexTable::kMinCapacity, table->capacity());
+  for (size_t i = 1; i <= kNumEntries; ++i) {
+    const EntryMetadata* metadata = table->Find(i * 7919);
+    ASSERT_TRUE(metadata);
+    EXPECT_EQ(i, metadata->GetEntrySize());
+  }
+
+  size_t iterated = 0;
+  for (SimpleIndexTable::Iterator it(table.get()); !it.IsAtEnd(); it.Advance())
+    ++iterated;
+  EXPECT_EQ(kNumEntries, iterated);
+}
+
+TEST_F(SimpleIndexTableTest, FailsWhenReservationIsExhausted) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+  ASSERT_TRUE(table);
+  const size_t max_entries = table->reserved_capacity() * 3 / 4;
+  for (size_t i = 1; i <= max_entries; ++i)
+    ASSERT_TRUE(table->Insert(i, EntryMetadata(kTestLastUsedTime, 1)));
+  EXPECT_FALSE(table->Insert(max_entries + 1,
+                             EntryMetadata(kTestLastUsedTime, 1)));
+  // Existing entries can still be updated.
+  EXPECT_TRUE(table->Insert(1, EntryMetadata(kTestLastUsedTime, 2)));
+  EXPECT_EQ(max_entries, table->size());
+}
+
+TEST_F(SimpleIndexTableTest, ReopenAfterCleanFlush) {
+  {
+    scoped_refptr<SimpleIndexTable> table = CreateTable(10);
+    ASSERT_TRUE(table);
+    for (uint64_t hash = 1; hash <= 10; ++hash)
+      table->Insert(hash, EntryMetadata(kTestLastUsedTime, hash));
+    table->set_cache_size(55);
+    EXPECT_TRUE(Flush(table.get(), true));
+  }
+
+  scoped_refptr<SimpleIndexTable> table = OpenTable();
+  ASSERT_TRUE(table);
+  EXPECT_EQ(10U, table->size());
+  EXPECT_EQ(55U, table->cache_size());
+  EXPECT_EQ(kTestLastUsedTime, table->cache_last_modified());
+  for (uint64_t hash = 1; hash <= 10; ++hash) {
+    ASSERT_TRUE(table->Find(hash));
+    EXPECT_EQ(hash, table->Find(hash)->GetEntrySize());
+  }
+  table = nullptr;
+
+  // The table was not flushed cleanly after being opened.
+  EXPECT_FALSE(OpenTable());
+}
+
+TEST_F(SimpleIndexTableTest, UncleanTableIsNotOpened) {
+  {
+    scoped_refptr<SimpleIndexTable> table = CreateTable(10);
+    ASSERT_TRUE(table);
+    table->Insert(1, EntryMetadata(kTestLastUsedTime, 1));
+    EXPECT_TRUE(Flush(table.get(), false));
+  }
+  EXPECT_FALSE(OpenTable());
+}
+
+// A table modified while a clean flush is in flight is not marked clean, since
+// the flush doesn't include the modification.
+TEST_F(SimpleIndexTableTest, ModifiedDuringCleanFlushIsNotClean) {
+  {
+    scoped_refptr<SimpleIndexTable> table = CreateTable(10);
+    ASSERT_TRUE(table);
+    table->Insert(1, EntryMetadata(kTestLastUsedTime, 1));
+    std::unique_ptr<SimpleIndexTable::PendingFlush> flush =
+        table->PrepareFlush(true);
+    table->Insert(2, EntryMetadata(kTestLastUsedTime, 2));
+    EXPECT_TRUE(
+        SimpleIndexTable::SyncFlush(std::move(flush), kTestLastUsedTime));
+  }
+  EXPECT_FALSE(OpenTable());
+}
+
+// A table modified after a clean flush is marked as in use again.
+TEST_F(SimpleIndexTableTest, ModifiedAfterCleanFlushIsNotClean) {
+  {
+    scoped_refptr<SimpleIndexTable> table = CreateTable(10);
+    ASSERT_TRUE(table);
+    table->Insert(1, EntryMetadata(kTestLastUsedTime, 1));
+    EXPECT_TRUE(Flush(table.get(), true));
+    table->Insert(2, EntryMetadata(kTestLastUsedTime, 2));
+    EXPECT_TRUE(Flush(table.get(), false));
+  }
+  EXPECT_FALSE(OpenTable());
+}
+
+// A table without empty slots makes lookups of missing entries probe every
+// slot, after which the table is reported as corrupt instead of spinning.
+TEST_F(SimpleIndexTableTest, TableWithoutEmptySlotsIsCorrupt) {
+  size_t capacity = 0;
+  {
+    scoped_refptr<SimpleIndexTable> table = CreateTable(0);
+    ASSERT_TRUE(table);
+    capacity = table->capacity();
+    // The header only accounts for this entry.
+    table->Insert(CollidingHash(capacity, 7, 0),
+                  EntryMetadata(kTestLastUsedTime, 1));
+    EXPECT_TRUE(Flush(table.get(), true));
+  }
+  FillAllSlots(capacity);
+
+  scoped_refptr<SimpleIndexTable> table = OpenTable();
+  ASSERT_TRUE(table);
+  EXPECT_TRUE(table->Find(CollidingHash(capacity, 7, 0)));
+  EXPECT_FALSE(table->is_corrupt());
+
+  const uint64_t kMissingHash = CollidingHash(capacity, 7, 1);
+  EXPECT_FALSE(table->Find(kMissingHash));
+  EXPECT_TRUE(table->is_corrupt());
+  EXPECT_FALSE(table->FindForUpdate(kMissingHash));
+  EXPECT_FALSE(
+      table->Insert(kMissingHash, EntryMetadata(kTestLastUsedTime, 1)));
+  EXPECT_FALSE(table->Remove(kMissingHash));
+  // Removing an entry still terminates, and leaves an empty slot behind.
+  EXPECT_TRUE(table->Remove(CollidingHash(capacity, 7, 0)));
+  EXPECT_FALSE(table->Find(kMissingHash));
+
+  // A corrupt table is never marked clean.
+  EXPECT_TRUE(Flush(table.get(), true));
+  table = nullptr;
+  EXPECT_FALSE(OpenTable());
+}
+
+TEST_F(SimpleIndexTableTest, DirtyPageTracking) {
+  scoped_refptr<SimpleIndexTable> table = CreateTable(100000);
+  ASSERT_TRUE(table);
+  for (uint64_t hash = 1; hash <= 100000; ++hash)
+    table->Insert(hash * 7919, EntryMetadata(kTestLastUsedTime, 1));
+  EXPECT_LT(0U, table->dirty_page_count());
+
+  std::unique_ptr<SimpleIndexTable::PendingFlush> flush =
+      table->PrepareFlush(false);
+  EXPECT_LT(1U, flush->page_count());
+  EXPECT_EQ(0U, table->dirty_page_count());
+  EXPECT_TRUE(SimpleIndexTable::SyncFlush(std::move(flush), base::Time()));
+
+  // Touching one entry dirties its page and nothing else.
+  table->FindForUpdate(7919)->SetLastUsedTime(kTestLastUsedTime +
+                                              base::TimeDelta::FromDays(1));
+  EXPECT_EQ(1U, table->dirty_page_count());
+
+  // Removing an entry also updates the entry count in the header.
+  table->Remove(2 * 7919);
+  EXPECT_LE(2U, table->dirty_page_count());
+  EXPECT_GE(4U, table->dirty_page_count());
+}
+
+}  // namespace disk_cache
@@ -4,11 +4,14 @@
 
 #include "net/disk_cache/simple/simple_index.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <functional>
 #include <memory>
 #include <utility>
 
+#include "base/files/file.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/hash.h"
 #include "base/logging.h"
@@ -17,10 +20,12 @@
 #include "base/strings/stringprintf.h"
 #include "base/task_runner.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
 #include "net/base/cache_type.h"
 #include "net/disk_cache/simple/simple_index_delegate.h"
 #include "net/disk_cache/simple/simple_index_file.h"
+#include "net/disk_cache/simple/simple_index_table.h"
 #include "net/disk_cache/simple/simple_test_util.h"
 #include "net/disk_cache/simple/simple_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -32,6 +37,24 @@ const base::Time kTestLastUsedTime =
     base::Time::UnixEpoch() + base::TimeDelta::FromDays(20);
 const uint64_t kTestEntrySize = 789;
 
+// Writes an entry into each of the first |capacity| slots of the index table
+// file at |path|, as only a corrupted file would. The layout matches the
+// static_asserts in simple_index_table.cc.
+void FillAllTableSlots(const base::FilePath& path, size_t capacity) {
+  const int kHeaderSize = 72;
+  const int kRecordSize = 16;
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_WRITE);
+  ASSERT_TRUE(file.IsValid());
+  for (size_t slot = 0; slot < capacity; ++slot) {
+    char record[kRecordSize] = {};
+    const uint64_t hash = capacity + slot;
+    memcpy(record, &hash, sizeof(hash));
+    const int64_t offset =
+        kHeaderSize + static_cast<int64_t>(slot) * kRecordSize;
+    ASSERT_EQ(kRecordSize, file.Write(offset, record, kRecordSize));
+  }
+}
+
 }  // namespace
 
 
@@ -57,7 +80,8 @@ class MockSimpleIndexFile : public SimpleIndexFile,
       : SimpleIndexFile(NULL, NULL, net::DISK_CACHE, base::FilePath()),
         load_result_(NULL),
         load_index_entries_calls_(0),
-        disk_writes_(0) {}
+        disk_writes_(0),
+        table_flushes_(0) {}
 
   void LoadIndexEntries(base::Time cache_last_modified,
                         const base::Closure& callback,
@@ -77,6 +101,16 @@ class MockSimpleIndexFile : public SimpleIndexFile,
     disk_write_entry_set_ = entry_set;
   }
 
+  void FlushTable(SimpleIndex::IndexWriteToDiskReason reason,
+                  SimpleIndexTable* table,
+                  bool mark_clean,
+                  const base::TimeTicks& start,
+                  const base::Closure& callback) override {
+    table_flushes_++;
+    if (!callback.is_null())
+      callback.Run();
+  }
+
   void GetAndResetDiskWriteEntrySet(SimpleIndex::EntrySet* entry_set) {
     entry_set->swap(disk_write_entry_set_);
   }
@@ -85,12 +119,14 @@ class MockSimpleIndexFile : public SimpleIndexFile,
   SimpleIndexLoadResult* load_result() const { return load_result_; }
   int load_index_entries_calls() const { return load_index_entries_calls_; }
   int disk_writes() const { return disk_writes_; }
+  int table_flushes() const { return table_flushes_; }
 
  private:
   base::Closure load_callback_;
   SimpleIndexLoadResult* load_result_;
   int load_index_entries_calls_;
   int disk_writes_;
+  int table_flushes_;
   SimpleIndex::EntrySet disk_write_entry_set_;
 };
 
@@ -133,10 +169,10 @@ class SimpleIndexTest  : public testing::Test, public SimpleIndexDelegate {
 
   // Redirect to allow single "friend" declaration in base class.
   bool GetEntryForTesting(uint64_t key, EntryMetadata* metadata) {
-    SimpleIndex::EntrySet::iterator it = index_->entries_set_.find(key);
-    if (index_->entries_set_.end() == it)
+    const EntryMetadata* found = index_->FindEntry(key);
+    if (!found)
       return false;
-    *metadata = it->second;
+    *metadata = *found;
     return true;
   }
 
@@ -227,6 +263,83 @@ TEST_F(SimpleIndexTest, IndexSizeCorrectOnMerge) {
   EXPECT_EQ(2U + 3U + 4U + 11U, index()->cache_size_);
 }
 
+// Entries inserted or removed while loading are merged into an index table
+// handed back by the index file, and the table then backs the index.
+TEST_F(SimpleIndexTest, MergeIntoTable) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  scoped_refptr<SimpleIndexTable> table = SimpleIndexTable::Create(
+      temp_dir.path().AppendASCII("index-table"), 0,
+      base::ThreadTaskRunnerHandle::Get());
+  ASSERT_TRUE(table);
+  table->Insert(hashes_.at<1>(), EntryMetadata(base::Time::Now(), 10));
+  table->Insert(hashes_.at<2>(), EntryMetadata(base::Time::Now(), 20));
+  table->set_cache_size(30);
+
+  index()->SetMaxSize(1000);
+  index()->Insert(hashes_.at<3>());
+  index()->UpdateEntrySize(hashes_.at<3>(), 3);
+  index()->Remove(hashes_.at<2>());
+
+  index_file_->load_result()->table = table;
+  ReturnIndexFile();
+
+  EXPECT_TRUE(index()->is_table_backed());
+  EXPECT_EQ(2, index()->GetEntryCount());
+  EXPECT_TRUE(index()->Has(hashes_.at<1>()));
+  EXPECT_FALSE(index()->Has(hashes_.at<2>()));
+  EXPECT_TRUE(index()->Has(hashes_.at<3>()));
+  EXPECT_EQ(13U, index()->GetCacheSize());
+
+  // Later updates go straight to the table.
+  index()->UpdateEntrySize(hashes_.at<3>(), 5);
+  EXPECT_EQ(5U, table->Find(hashes_.at<3>())->GetEntrySize());
+  index()->Remove(hashes_.at<1>());
+  EXPECT_EQ(1U, table->size());
+  EXPECT_EQ(5U, index()->GetCacheSize());
+
+  index()->WriteToDisk(SimpleIndex::INDEX_WRITE_REASON_SHUTDOWN);
+  EXPECT_EQ(0, index_file_->disk_writes());
+  EXPECT_EQ(1, index_file_->table_flushes());
+  EXPECT_EQ(5U, table->cache_size());
+}
+
+// An index table found corrupt is dropped, and the index is rebuilt from the
+// cache directory, tracking the changes made in the meantime as during the
+// initial load.
+TEST_F(SimpleIndexTest, RebuildsWhenTableIsCorrupt) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath table_path = temp_dir.path().AppendASCII("index-table");
+  scoped_refptr<SimpleIndexTable> table = SimpleIndexTable::Create(
+      table_path, 0, base::ThreadTaskRunnerHandle::Get());
+  ASSERT_TRUE(table);
+
+  index()->SetMaxSize(1000);
+  index_file_->load_result()->table = table;
+  ReturnIndexFile();
+  ASSERT_TRUE(index()->is_table_backed());
+  EXPECT_EQ(1, index_file_->load_index_entries_calls());
+
+  // The file is mapped shared, so the table sees the corruption.
+  FillAllTableSlots(table_path, table->capacity());
+  index()->Insert(hashes_.at<1>());
+  EXPECT_TRUE(table->is_corrupt());
+  EXPECT_FALSE(index()->is_table_backed());
+  EXPECT_FALSE(index()->initialized());
+  EXPECT_EQ(1, index_file_->table_flushes());
+  EXPECT_EQ(2, index_file_->load_index_entries_calls());
+
+  InsertIntoIndexFileReturn(hashes_.at<2>(), kTestLastUsedTime, 20);
+  ReturnIndexFile();
+  EXPECT_TRUE(index()->initialized());
+  EXPECT_EQ(2, index()->GetEntryCount());
+  EXPECT_TRUE(index()->Has(hashes_.at<1>()));
+  EXPECT_TRUE(index()->Has(hashes_.at<2>()));
+  EXPECT_FALSE(index()->Has(hashes_.at<3>()));
+  EXPECT_EQ(20U, index()->GetCacheSize());
+}
+
 // State of index changes as expected with an insert and a remove.
 TEST_F(SimpleIndexTest, BasicInsertRemove) {
   // Confirm blank state.
@@ -449,6 +449,12 @@ void LogCancelRequest(const BoundNetLog& source_net_log,
 
 //-----------------------------------------------------------------------------
 
+// Completion callback of the requests made to refresh cache entries, which
+// only exist to have the result cached. |addresses| is owned by the callback.
+void OnCacheEntryRefreshed(AddressList* addresses, int net_error) {}
+
+//-----------------------------------------------------------------------------
+
 // Keeps track of the highest priority.
 class PriorityTracker {
  public:
@@ -1933,6 +1939,12 @@ void HostResolverImpl::SetMaxQueuedJobs(size_t value) {
   max_queued_jobs_ = value;
 }
 
+void HostResolverImpl::SetMaxStaleAge(base::TimeDelta max_stale_age) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(max_stale_age >= base::TimeDelta());
+  max_stale_age_ = max_stale_age;
+}
+
 int HostResolverImpl::Resolve(const RequestInfo& info,
                               RequestPriority priority,
                               AddressList* addresses,
@@ -2136,8 +2148,22 @@ bool HostResolverImpl::ServeFromCache(const Key& key,
   if (!info.allow_cached_response() || !cache_.get())
     return false;
 
-  const HostCache::Entry* cache_entry = cache_->Lookup(
-      key, base::TimeTicks::Now());
+  const HostCache::Entry* cache_entry;
+  bool is_stale = false;
+  if (max_stale_age_ > base::TimeDelta()) {
+    HostCache::EntryStaleness stale;
+    cache_entry = cache_->LookupStale(key, base::TimeTicks::Now(), &stale);
+    if (cache_entry && stale.is_stale()) {
+      // Errors and results from another network are never served stale.
+      if (cache_entry->error() != OK || stale.network_changes > 0 ||
+          stale.expired_by > max_stale_age_) {
+        return false;
+      }
+      is_stale = true;
+    }
+  } else {
+    cache_entry = cache_->Lookup(key, base::TimeTicks::Now());
+  }
   if (!cache_entry)
     return false;
 
@@ -2147,6 +2173,8 @@ bool HostResolverImpl::ServeFromCache(const Key& key,
       RecordTTL(cache_entry->ttl());
     *addresses = EnsurePortOnAddressList(cache_entry->addresses(), info.port());
   }
+  if (is_stale)
+    RefreshCacheEntry(key);
   return true;
 }
 
@@ -2227,6 +2255,36 @@ bool HostResolverImpl::ServeLocalhost(const Key& key,
   return true;
 }
 
+void HostResolverImpl::RefreshCacheEntry(const Key& key) {
+  if (jobs_.count(key))
+    return;
+
+  Job* job = new Job(weak_ptr_factory_.GetWeakPtr(), key, IDLE, BoundNetLog());
+  job->Schedule(false);
+
+  // Check for queue overflow.
+  if (dispatcher_->num_queued_jobs() > max_queued_jobs_) {
+    Job* evicted = static_cast<Job*>(dispatcher_->EvictOldestLowest());
+    DCHECK(evicted);
+    evicted->OnEvicted();  // Deletes |evicted|.
+    if (evicted == job)
+      return;
+  }
+  jobs_.insert(std::make_pair(key, job));
+
+  // A Job only caches its result if it still has requests when it completes.
+  RequestInfo info(HostPortPair(key.hostname, 0));
+  info.set_address_family(key.address_family);
+  info.set_host_resolver_flags(key.host_resolver_flags);
+  info.set_allow_cached_response(false);
+  info.set_is_speculative(true);
+  AddressList* addresses = new AddressList;
+  job->AddRequest(base::WrapUnique(new Request(
+      BoundNetLog(), info, IDLE,
+      base::Bind(&OnCacheEntryRefreshed, base::Owned(addresses)),
+      addresses)));
+}
+
 void HostResolverImpl::CacheResult(const Key& key,
                                    const HostCache::Entry& entry,
                                    base::TimeDelta ttl) {
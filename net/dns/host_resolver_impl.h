@@ -130,6 +130,12 @@ class NET_EXPORT HostResolverImpl
   // NetworkChangeNotifier.
   void SetDnsClient(std::unique_ptr<DnsClient> dns_client);
 
+  // Allows requests to be served from cache entries that expired less than
+  // |max_stale_age| ago, as long as they were received on the current network.
+  // A stale entry is refreshed in the background when it is served. Zero, the
+  // default, only serves valid entries.
+  void SetMaxStaleAge(base::TimeDelta max_stale_age);
+
   // HostResolver methods:
   int Resolve(const RequestInfo& info,
               RequestPriority priority,
@@ -219,6 +225,10 @@ class NET_EXPORT HostResolverImpl
   // from the first probe for some time before probing again.
   virtual bool IsIPv6Reachable(const BoundNetLog& net_log);
 
+  // Starts an idle-priority Job to resolve |key| again and cache the result,
+  // unless a Job for |key| already exists.
+  void RefreshCacheEntry(const Key& key);
+
   // Records the result in cache if cache is present.
   void CacheResult(const Key& key,
                    const HostCache::Entry& entry,
@@ -282,6 +292,9 @@ class NET_EXPORT HostResolverImpl
   // Parameters for ProcTask.
   ProcTaskParams proc_params_;
 
+  // How long after expiring cache entries may still be served.
+  base::TimeDelta max_stale_age_;
+
   NetLog* net_log_;
 
   // If present, used by DnsTask and ServeFromHosts to resolve requests.
@@ -1026,6 +1026,57 @@ TEST_F(HostResolverImplTest, BypassCache) {
   EXPECT_EQ(2u, proc_->GetCaptureList().size());
 }
 
+// Test that expired cache entries are served when allowed, and refreshed in the
+// background.
+TEST_F(HostResolverImplTest, ServeStaleCacheEntry) {
+  proc_->AddRuleForAllFamilies("host1", "192.168.1.42");
+  resolver_->SetMaxStaleAge(base::TimeDelta::FromHours(1));
+
+  const base::TimeDelta kTTL = base::TimeDelta::FromMinutes(1);
+  resolver_->GetHostCache()->Set(
+      HostCache::Key("host1", ADDRESS_FAMILY_UNSPECIFIED, 0),
+      HostCache::Entry(
+          OK, AddressList::CreateFromIPAddress(IPAddress(10, 0, 0, 1), 0)),
+      base::TimeTicks::Now() - kTTL - kTTL, kTTL);
+
+  Request* req = CreateRequest("host1", 80);
+  EXPECT_EQ(OK, req->Resolve());
+  EXPECT_TRUE(req->HasOneAddress("10.0.0.1", 80));
+  EXPECT_TRUE(proc_->WaitFor(1u));
+
+  // A request that bypasses the cache joins the refresh.
+  HostResolver::RequestInfo info(HostPortPair("host1", 80));
+  info.set_allow_cached_response(false);
+  req = CreateRequest(info, DEFAULT_PRIORITY);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  proc_->SignalMultiple(1u);
+  EXPECT_EQ(OK, req->WaitForResult());
+  EXPECT_EQ(1u, proc_->GetCaptureList().size());
+
+  req = CreateRequest("host1", 80);
+  EXPECT_EQ(OK, req->Resolve());
+  EXPECT_TRUE(req->HasOneAddress("192.168.1.42", 80));
+}
+
+// Test that cache entries that expired too long ago are not served.
+TEST_F(HostResolverImplTest, ServeStaleCacheEntryTooOld) {
+  proc_->AddRuleForAllFamilies("host1", "192.168.1.42");
+  resolver_->SetMaxStaleAge(base::TimeDelta::FromSeconds(30));
+
+  const base::TimeDelta kTTL = base::TimeDelta::FromMinutes(1);
+  resolver_->GetHostCache()->Set(
+      HostCache::Key("host1", ADDRESS_FAMILY_UNSPECIFIED, 0),
+      HostCache::Entry(
+          OK, AddressList::CreateFromIPAddress(IPAddress(10, 0, 0, 1), 0)),
+      base::TimeTicks::Now() - kTTL - kTTL, kTTL);
+
+  Request* req = CreateRequest("host1", 80);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  proc_->SignalMultiple(1u);
+  EXPECT_EQ(OK, req->WaitForResult());
+  EXPECT_TRUE(req->HasOneAddress("192.168.1.42", 80));
+}
+
 // Test that IP address changes flush the cache but initial DNS config reads do
 // not.
 TEST_F(HostResolverImplTest, FlushCacheOnIPAddressChange) {
@@ -330,6 +330,12 @@ std::string Filter::OrderedFilterList() const {
   }
 }
 
+bool Filter::IsContextFree() const {
+  if (type_id_ == FILTER_TYPE_SDCH || type_id_ == FILTER_TYPE_SDCH_POSSIBLE)
+    return false;
+  return !next_filter_ || next_filter_->IsContextFree();
+}
+
 Filter::Filter(FilterType type_id)
     : stream_buffer_(nullptr),
       stream_buffer_size_(0),
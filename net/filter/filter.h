@@ -237,6 +237,11 @@ class NET_EXPORT_PRIVATE Filter {
   // Returns a string describing the FilterTypes implemented by this filter.
   std::string OrderedFilterList() const;
 
+  // Returns true if no filter in the chain uses its FilterContext after
+  // construction, in which case the chain may be used on another thread than
+  // the context's.
+  bool IsContextFree() const;
+
   FilterType type() const { return type_id_; }
 
  protected:
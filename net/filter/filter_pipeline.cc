@@ -0,0 +1,356 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/filter/filter_pipeline.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/sequenced_task_runner.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+
+namespace net {
+
+namespace {
+
+// Size of the buffers the filter chain decodes into.
+const int kOutputChunkSize = 32 * 1024;
+
+}  // namespace
+
+const size_t FilterPipeline::kMaxBufferedInputBytes = 128 * 1024;
+const size_t FilterPipeline::kMaxBufferedOutputBytes = 256 * 1024;
+
+// Holds the state shared by the origin thread and the worker sequence, and
+// the filter chain, which is only used on the worker sequence. Created on the
+// origin thread. As it's refcounted, it's destroyed when the final reference
+// is released, which may happen on either thread, but never while the filter
+// chain is in use.
+class FilterPipeline::Core : public base::RefCountedThreadSafe<Core> {
+ public:
+  Core(std::unique_ptr<Filter> filter,
+       const scoped_refptr<base::SequencedTaskRunner>& task_runner,
+       const base::Closure& progress_callback);
+
+  // Must be called on the origin thread.
+  bool CanAcceptInput() const;
+  void AppendInput(const scoped_refptr<IOBuffer>& buffer, int size);
+  int Read(IOBuffer* buf, int buf_size);
+  void CancelOnOriginThread();
+
+ private:
+  friend class base::RefCountedThreadSafe<Core>;
+
+  enum Result {
+    RESULT_PENDING,
+    RESULT_DONE,
+    RESULT_FAILED,
+  };
+
+  // A range of an IOBuffer that has not been consumed yet.
+  struct Chunk {
+    Chunk(const scoped_refptr<IOBuffer>& buffer, int size)
+        : buffer(buffer), offset(0), size(size) {}
+
+    int remaining() const { return size - offset; }
+
+    scoped_refptr<IOBuffer> buffer;
+    int offset;
+    int size;
+  };
+
+  ~Core();
+
+  // Posts a task to run Decode() unless one is pending or running. Must be
+  // called with |lock_| held.
+  void ScheduleDecodeLocked();
+
+  // Runs on the worker sequence. Decodes input until it runs out of input or
+  // too much output is buffered.
+  void Decode();
+
+  // Copies the next piece of input into the filter's stream buffer. Returns
+  // false and stops decoding if there is none. Must be called with |lock_|
+  // held.
+  bool FeedFilterLocked();
+
+  // Posts a task to run NotifyOnOriginThread() unless one is pending.
+  void NotifyOriginThread();
+  void NotifyOnOriginThread();
+
+  const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  const scoped_refptr<base::SingleThreadTaskRunner> origin_task_runner_;
+
+  // Only used on the origin thread. Reset on cancellation.
+  base::Closure progress_callback_;
+
+  // Only used on the worker sequence.
+  std::unique_ptr<Filter> filter_;
+  // Set if the filter filled the last output buffer, in which case it may
+  // have more output without more input.
+  bool filter_needs_more_output_space_;
+  scoped_refptr<IOBuffer> output_buffer_;
+
+  // Protects the members below.
+  mutable base::Lock lock_;
+  std::deque<Chunk> input_;
+  size_t input_bytes_;
+  bool input_complete_;
+  std::deque<Chunk> output_;
+  size_t output_bytes_;
+  Result result_;
+  // Set while a Decode() task is pending or running.
+  bool decode_scheduled_;
+  // Set if Decode() stopped because too much output is buffered.
+  bool decode_blocked_;
+  bool notification_pending_;
+  bool cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(Core);
+};
+
+FilterPipeline::Core::Core(
+    std::unique_ptr<Filter> filter,
+    const scoped_refptr<base::SequencedTaskRunner>& task_runner,
+    const base::Closure& progress_callback)
+    : task_runner_(task_runner),
+      origin_task_runner_(base::ThreadTaskRunnerHandle::Get()),
+      progress_callback_(progress_callback),
+      filter_(std::move(filter)),
+      filter_needs_more_output_space_(false),
+      input_bytes_(0),
+      input_complete_(false),
+      output_bytes_(0),
+      result_(RESULT_PENDING),
+      decode_scheduled_(false),
+      decode_blocked_(false),
+      notification_pending_(false),
+      cancelled_(false) {
+  DCHECK(filter_->IsContextFree());
+}
+
+FilterPipeline::Core::~Core() {}
+
+bool FilterPipeline::Core::CanAcceptInput() const {
+  base::AutoLock auto_lock(lock_);
+  return !input_complete_ && input_bytes_ < kMaxBufferedInputBytes;
+}
+
+void FilterPipeline::Core::AppendInput(const scoped_refptr<IOBuffer>& buffer,
+                                       int size) {
+  DCHECK_GE(size, 0);
+  base::AutoLock auto_lock(lock_);
+  DCHECK(!input_complete_);
+  if (size == 0) {
+    input_complete_ = true;
+  } else {
+    input_.push_back(Chunk(buffer, size));
+    input_bytes_ += size;
+  }
+  ScheduleDecodeLocked();
+}
+
+int FilterPipeline::Core::Read(IOBuffer* buf, int buf_size) {
+  DCHECK_GT(buf_size, 0);
+  base::AutoLock auto_lock(lock_);
+  int bytes_read = 0;
+  while (bytes_read < buf_size && !output_.empty()) {
+    Chunk& chunk = output_.front();
+    int size = std::min(buf_size - bytes_read, chunk.remaining());
+    memcpy(buf->data() + bytes_read, chunk.buffer->data() + chunk.offset,
+           size);
+    bytes_read += size;
+    chunk.offset += size;
+    output_bytes_ -= size;
+    if (chunk.remaining() == 0)
+      output_.pop_front();
+  }
+
+  if (decode_blocked_ && output_bytes_ < kMaxBufferedOutputBytes) {
+    decode_blocked_ = false;
+    ScheduleDecodeLocked();
+  }
+
+  if (bytes_read > 0)
+    return bytes_read;
+  switch (result_) {
+    case RESULT_PENDING:
+      return ERR_IO_PENDING;
+    case RESULT_DONE:
+      return 0;
+    case RESULT_FAILED:
+      return ERR_CONTENT_DECODING_FAILED;
+  }
+  NOTREACHED();
+  return ERR_FAILED;
+}
+
+void FilterPipeline::Core::CancelOnOriginThread() {
+  progress_callback_.Reset();
+  base::AutoLock auto_lock(lock_);
+  cancelled_ = true;
+}
+
+void FilterPipeline::Core::ScheduleDecodeLocked() {
+  lock_.AssertAcquired();
+  if (decode_scheduled_ || decode_blocked_ || result_ != RESULT_PENDING)
+    return;
+  decode_scheduled_ = true;
+  task_runner_->PostTask(FROM_HERE, base::Bind(&Core::Decode, this));
+}
+
+void FilterPipeline::Core::Decode() {
+  bool out_of_input = false;
+  bool ended = false;
+  while (!out_of_input) {
+    bool fed_filter = false;
+    {
+      base::AutoLock auto_lock(lock_);
+      if (cancelled_) {
+        decode_scheduled_ = false;
+        return;
+      }
+      if (output_bytes_ >= kMaxBufferedOutputBytes) {
+        decode_blocked_ = true;
+        decode_scheduled_ = false;
+        return;
+      }
+      if (!filter_needs_more_output_space_ && !filter_->stream_data_len()) {
+        fed_filter = FeedFilterLocked();
+        out_of_input = !fed_filter;
+        ended = result_ == RESULT_DONE;
+      }
+    }
+    if (out_of_input)
+      break;
+    // The input may have dropped below its bound.
+    if (fed_filter)
+      NotifyOriginThread();
+
+    if (!output_buffer_)
+      output_buffer_ = new IOBuffer(kOutputChunkSize);
+    int output_size = kOutputChunkSize;
+    Filter::FilterStatus status =
+        filter_->ReadData(output_buffer_->data(), &output_size);
+    // Like URLRequestJob, ignore the output size of a failed read: filters
+    // don't necessarily update it.
+    if (status == Filter::FILTER_ERROR)
+      output_size = 0;
+
+    if (filter_needs_more_output_space_ && !output_size &&
+        status != Filter::FILTER_ERROR) {
+      // The filter had no more output after all, so it needs input.
+      filter_needs_more_output_space_ = false;
+      continue;
+    }
+    filter_needs_more_output_space_ = output_size == kOutputChunkSize;
+
+    Result result = RESULT_PENDING;
+    if (status == Filter::FILTER_DONE ||
+        (status == Filter::FILTER_OK && !output_size)) {
+      result = RESULT_DONE;
+    } else if (status == Filter::FILTER_ERROR) {
+      result = RESULT_FAILED;
+    }
+
+    {
+      base::AutoLock auto_lock(lock_);
+      if (output_size > 0) {
+        output_.push_back(Chunk(output_buffer_, output_size));
+        output_bytes_ += output_size;
+        output_buffer_ = nullptr;
+      }
+      if (result != RESULT_PENDING) {
+        result_ = result;
+        decode_scheduled_ = false;
+      }
+    }
+    if (output_size > 0 || result != RESULT_PENDING)
+      NotifyOriginThread();
+    if (result != RESULT_PENDING)
+      return;
+  }
+
+  if (ended)
+    NotifyOriginThread();
+}
+
+bool FilterPipeline::Core::FeedFilterLocked() {
+  lock_.AssertAcquired();
+  if (input_.empty()) {
+    // Like URLRequestJob, treat the end of the input as the end of the
+    // stream even if the filter didn't report it, e.g. for truncated input.
+    if (input_complete_)
+      result_ = RESULT_DONE;
+    decode_scheduled_ = false;
+    return false;
+  }
+
+  Chunk& chunk = input_.front();
+  int size = std::min(filter_->stream_buffer_size(), chunk.remaining());
+  memcpy(filter_->stream_buffer()->data(), chunk.buffer->data() + chunk.offset,
+         size);
+  chunk.offset += size;
+  input_bytes_ -= size;
+  if (chunk.remaining() == 0)
+    input_.pop_front();
+  filter_->FlushStreamBuffer(size);
+  return true;
+}
+
+void FilterPipeline::Core::NotifyOriginThread() {
+  {
+    base::AutoLock auto_lock(lock_);
+    if (notification_pending_ || cancelled_)
+      return;
+    notification_pending_ = true;
+  }
+  origin_task_runner_->PostTask(
+      FROM_HERE, base::Bind(&Core::NotifyOnOriginThread, this));
+}
+
+void FilterPipeline::Core::NotifyOnOriginThread() {
+  {
+    base::AutoLock auto_lock(lock_);
+    notification_pending_ = false;
+  }
+  if (!progress_callback_.is_null())
+    progress_callback_.Run();
+}
+
+FilterPipeline::FilterPipeline(
+    std::unique_ptr<Filter> filter,
+    const scoped_refptr<base::SequencedTaskRunner>& task_runner,
+    const base::Closure& progress_callback)
+    : filter_type_(filter->type()),
+      input_chunk_size_(filter->stream_buffer_size()),
+      core_(new Core(std::move(filter), task_runner, progress_callback)) {}
+
+FilterPipeline::~FilterPipeline() {
+  core_->CancelOnOriginThread();
+}
+
+bool FilterPipeline::CanAcceptInput() const {
+  return core_->CanAcceptInput();
+}
+
+void FilterPipeline::AppendInput(const scoped_refptr<IOBuffer>& buffer,
+                                 int size) {
+  core_->AppendInput(buffer, size);
+}
+
+int FilterPipeline::Read(IOBuffer* buf, int buf_size) {
+  return core_->Read(buf, buf_size);
+}
+
+}  // namespace net
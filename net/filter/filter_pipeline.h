@@ -0,0 +1,92 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FilterPipeline runs a Filter chain on a worker sequence, so that decoding a
+// large compressed body does not hold up the thread that reads it. Sample
+// usage, on the origin (IO) thread:
+//
+//   FilterPipeline pipeline(std::move(filter), worker_task_runner,
+//                           base::Bind(&Reader::OnProgress, this));
+//   while (pipeline.CanAcceptInput() && ReadRawData(buf, size, &bytes_read))
+//     pipeline.AppendInput(buf, bytes_read);  // 0 bytes marks the end.
+//   int rv = pipeline.Read(dest, dest_size);  // ERR_IO_PENDING: call again
+//                                             // from OnProgress().
+//
+// At most kMaxBufferedInputBytes of input wait to be decoded, and the worker
+// stops decoding while kMaxBufferedOutputBytes of output wait to be read, so
+// the pipeline applies backpressure both to the producer of raw data and to
+// the decoder.
+
+#ifndef NET_FILTER_FILTER_PIPELINE_H_
+#define NET_FILTER_FILTER_PIPELINE_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/net_export.h"
+#include "net/filter/filter.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+namespace net {
+
+class IOBuffer;
+
+class NET_EXPORT_PRIVATE FilterPipeline {
+ public:
+  // Bounds on the data buffered ahead of the decoder and of the reader.
+  static const size_t kMaxBufferedInputBytes;
+  static const size_t kMaxBufferedOutputBytes;
+
+  // Decodes with |filter|, which must be context free (see
+  // Filter::IsContextFree()), on |task_runner|. |progress_callback| is run on
+  // the origin thread, never from within a call to this object, when decoded
+  // data, the end of the decoded stream or room for more input may have
+  // become available.
+  FilterPipeline(std::unique_ptr<Filter> filter,
+                 const scoped_refptr<base::SequencedTaskRunner>& task_runner,
+                 const base::Closure& progress_callback);
+
+  // Stops decoding. |progress_callback| is not run afterwards.
+  ~FilterPipeline();
+
+  // The type of the first filter of the chain.
+  Filter::FilterType filter_type() const { return filter_type_; }
+
+  // A good size for input buffers: that of the filter's stream buffer.
+  int input_chunk_size() const { return input_chunk_size_; }
+
+  // Returns whether more input may be appended: false once the end of input
+  // was appended or while too much input waits to be decoded.
+  bool CanAcceptInput() const;
+
+  // Queues the first |size| bytes of |buffer| for decoding. A |size| of 0
+  // marks the end of the input.
+  void AppendInput(const scoped_refptr<IOBuffer>& buffer, int size);
+
+  // Copies up to |buf_size| bytes of decoded data into |buf|. Returns the
+  // number of bytes copied, 0 at the end of the decoded stream,
+  // ERR_CONTENT_DECODING_FAILED once all data decoded before an error was
+  // read, or ERR_IO_PENDING if no decoded data is available yet.
+  int Read(IOBuffer* buf, int buf_size);
+
+ private:
+  class Core;
+
+  const Filter::FilterType filter_type_;
+  const int input_chunk_size_;
+  scoped_refptr<Core> core_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilterPipeline);
+};
+
+}  // namespace net
+
+#endif  // NET_FILTER_FILTER_PIPELINE_H_
@@ -0,0 +1,158 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/filter/filter_pipeline.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/rand_util.h"
+#include "base/run_loop.h"
+#include "base/threading/thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/zlib.h"
+
+namespace net {
+
+namespace {
+
+const int kInputChunkSize = 4096;
+const int kReadSize = 1000;
+
+// Returns |data| compressed with gzip.
+std::string GZipCompress(const std::string& data) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               MAX_WBITS + 16 /* gzip wrapper */, 8,
+                               Z_DEFAULT_STRATEGY));
+  std::string compressed(deflateBound(&stream, data.size()) + 32, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = compressed.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+
+class FilterPipelineTest : public testing::Test {
+ protected:
+  FilterPipelineTest()
+      : worker_("filter_pipeline_worker"),
+        input_was_bounded_(false),
+        progress_calls_(0) {}
+
+  void SetUp() override { ASSERT_TRUE(worker_.Start()); }
+
+  // Decodes |input| with a gzip filter on |worker_|, reading the output into
+  // |output|. Returns the result of the last Read().
+  int Decode(const std::string& input, std::string* output) {
+    FilterPipeline pipeline(Filter::GZipFactory(), worker_.task_runner(),
+                            ProgressCallback());
+    scoped_refptr<IOBuffer> read_buffer(new IOBuffer(kReadSize));
+    size_t offset = 0;
+    bool input_complete = false;
+    input_was_bounded_ = false;
+    while (true) {
+      while (!input_complete && pipeline.CanAcceptInput()) {
+        int size = static_cast<int>(
+            std::min<size_t>(input.size() - offset, kInputChunkSize));
+        scoped_refptr<IOBuffer> buffer(new IOBuffer(kInputChunkSize));
+        memcpy(buffer->data(), input.data() + offset, size);
+        pipeline.AppendInput(buffer, size);
+        offset += size;
+        input_complete = size == 0;
+      }
+      if (!input_complete)
+        input_was_bounded_ = true;
+
+      int rv = pipeline.Read(read_buffer.get(), kReadSize);
+      if (rv > 0) {
+        output->append(read_buffer->data(), rv);
+        continue;
+      }
+      if (rv != ERR_IO_PENDING)
+        return rv;
+      base::RunLoop run_loop;
+      quit_closure_ = run_loop.QuitClosure();
+      run_loop.Run();
+    }
+  }
+
+  base::Closure ProgressCallback() {
+    return base::Bind(&FilterPipelineTest::OnProgress, base::Unretained(this));
+  }
+
+  void OnProgress() {
+    ++progress_calls_;
+    if (!quit_closure_.is_null())
+      base::ResetAndReturn(&quit_closure_).Run();
+  }
+
+  base::Thread worker_;
+  base::Closure quit_closure_;
+  // Set by Decode() if the pipeline stopped accepting input before the end
+  // of the input.
+  bool input_was_bounded_;
+  int progress_calls_;
+};
+
+TEST_F(FilterPipelineTest, Decodes) {
+  std::string data = "hello, world!\n";
+  std::string output;
+  EXPECT_EQ(0, Decode(GZipCompress(data), &output));
+  EXPECT_EQ(data, output);
+}
+
+// Input that doesn't compress is decoded in many pieces, while the pipeline
+// limits how much of it is buffered.
+TEST_F(FilterPipelineTest, DecodesLargeInput) {
+  std::string data = base::RandBytesAsString(1024 * 1024);
+  std::string output;
+  EXPECT_EQ(0, Decode(GZipCompress(data), &output));
+  EXPECT_TRUE(data == output);
+  EXPECT_TRUE(input_was_bounded_);
+}
+
+TEST_F(FilterPipelineTest, EmptyInput) {
+  std::string output;
+  EXPECT_EQ(0, Decode(std::string(), &output));
+  EXPECT_TRUE(output.empty());
+}
+
+TEST_F(FilterPipelineTest, InvalidInput) {
+  std::string output;
+  EXPECT_EQ(ERR_CONTENT_DECODING_FAILED,
+            Decode("not a valid gzip body", &output));
+  EXPECT_TRUE(output.empty());
+}
+
+// Destroying a pipeline that is decoding stops it without running its
+// callback.
+TEST_F(FilterPipelineTest, DestroyWhileDecoding) {
+  std::string input = GZipCompress(base::RandBytesAsString(256 * 1024));
+  std::unique_ptr<FilterPipeline> pipeline(new FilterPipeline(
+      Filter::GZipFactory(), worker_.task_runner(), ProgressCallback()));
+  scoped_refptr<IOBuffer> buffer(new IOBuffer(kInputChunkSize));
+  memcpy(buffer->data(), input.data(), kInputChunkSize);
+  pipeline->AppendInput(buffer, kInputChunkSize);
+  pipeline.reset();
+
+  worker_.Stop();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0, progress_calls_);
+}
+
+}  // namespace
+
+}  // namespace net
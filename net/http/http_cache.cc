@@ -43,6 +43,7 @@
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
 #include "net/http/http_util.h"
+#include "net/log/net_log.h"
 #include "net/quic/crypto/quic_server_info.h"
 
 #if defined(OS_POSIX)
@@ -96,7 +97,9 @@ HttpCache::ActiveEntry::ActiveEntry(disk_cache::Entry* entry)
     : disk_entry(entry),
       writer(NULL),
       will_process_pending_queue(false),
-      doomed(false) {
+      doomed(false),
+      shared_writing(false),
+      truncated(false) {
 }
 
 HttpCache::ActiveEntry::~ActiveEntry() {
@@ -305,6 +308,8 @@ HttpCache::HttpCache(std::unique_ptr<HttpTransactionFactory> network_layer,
       building_backend_(false),
       bypass_lock_for_test_(false),
       fail_conditionalization_for_test_(false),
+      shared_writing_enabled_(false),
+      cache_race_mode_(CACHE_RACE_DISABLED),
       mode_(NORMAL),
       network_layer_(std::move(network_layer)),
       clock_(new base::DefaultClock()),
@@ -338,6 +343,7 @@ HttpCache::~HttpCache() {
     entry->will_process_pending_queue = false;
     entry->pending_queue.clear();
     entry->readers.clear();
+    entry->waiting_readers.clear();
     entry->writer = NULL;
     DeactivateEntry(entry);
   }
@@ -796,6 +802,18 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
   //
   // NOTE: If the transaction can only write, then the entry should not be in
   // use (since any existing entry should have already been doomed).
+  //
+  // With shared writing, transactions that only need to read the response
+  // don't wait for the writer once it is storing the body.
+
+  if (entry->writer && !entry->will_process_pending_queue &&
+      CanReadWhileWriting(entry, trans)) {
+    entry->readers.push_back(trans);
+    trans->net_log().AddEvent(
+        NetLog::TYPE_HTTP_CACHE_ADDED_TO_ENTRY,
+        NetLog::BoolCallback("reads_while_writing", true));
+    return OK;
+  }
 
   if (entry->writer || entry->will_process_pending_queue) {
     entry->pending_queue.push_back(trans);
@@ -806,6 +824,7 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
     // transaction needs exclusive access to the entry
     if (entry->readers.empty()) {
       entry->writer = trans;
+      entry->truncated = false;
     } else {
       entry->pending_queue.push_back(trans);
       return ERR_IO_PENDING;
@@ -814,6 +833,9 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
     // transaction needs read access to the entry
     entry->readers.push_back(trans);
   }
+  trans->net_log().AddEvent(
+      NetLog::TYPE_HTTP_CACHE_ADDED_TO_ENTRY,
+      NetLog::BoolCallback("reads_while_writing", false));
 
   // We do this before calling EntryAvailable to force any further calls to
   // AddTransactionToEntry to add their transaction to the pending queue, which
@@ -828,12 +850,12 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
                               bool cancel) {
   // If we already posted a task to move on to the next transaction and this was
   // the writer, there is nothing to cancel.
-  if (entry->will_process_pending_queue && entry->readers.empty())
+  if (entry->will_process_pending_queue && !entry->writer &&
+      entry->readers.empty()) {
     return;
+  }
 
-  if (entry->writer) {
-    DCHECK(trans == entry->writer);
-
+  if (entry->writer == trans) {
     // Assume there was a failure.
     bool success = false;
     if (cancel) {
@@ -844,6 +866,9 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
       // The previous operation may have deleted the entry.
       if (!trans->entry())
         return;
+      // The rest of the body won't be stored for the readers either.
+      if (!entry->readers.empty() && trans->truncated())
+        entry->truncated = true;
     }
     DoneWritingToEntry(entry, success);
   } else {
@@ -852,21 +877,29 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
 }
 
 void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
-  DCHECK(entry->readers.empty());
+  DCHECK(entry->shared_writing || entry->readers.empty());
 
   entry->writer = NULL;
+  entry->shared_writing = false;
+  ResumeWaitingReaders(entry);
 
   if (success) {
     ProcessPendingQueue(entry);
   } else {
-    DCHECK(!entry->will_process_pending_queue);
-
     // We failed to create this entry.
     TransactionList pending_queue;
     pending_queue.swap(entry->pending_queue);
 
-    entry->disk_entry->Doom();
-    DestroyEntry(entry);
+    if (entry->readers.empty() && !entry->will_process_pending_queue) {
+      entry->disk_entry->Doom();
+      DestroyEntry(entry);
+    } else {
+      // Readers that joined while the body was being written still use the
+      // entry, so it is destroyed once they are done with it.
+      entry->truncated = true;
+      if (!entry->doomed)
+        DoomEntry(entry->disk_entry->GetKey(), NULL);
+    }
 
     // We need to do something about these pending entries, which now need to
     // be added to a new entry.
@@ -879,13 +912,14 @@ void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
 }
 
 void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
-  DCHECK(!entry->writer);
+  DCHECK(!entry->writer || entry->shared_writing);
 
   TransactionList::iterator it =
       std::find(entry->readers.begin(), entry->readers.end(), trans);
   DCHECK(it != entry->readers.end());
 
   entry->readers.erase(it);
+  entry->waiting_readers.remove(trans);
 
   ProcessPendingQueue(entry);
 }
@@ -903,6 +937,43 @@ void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
   ProcessPendingQueue(entry);
 }
 
+void HttpCache::BeginSharedWriting(ActiveEntry* entry) {
+  DCHECK(entry->writer);
+  DCHECK(entry->readers.empty());
+
+  if (!shared_writing_enabled_)
+    return;
+
+  entry->shared_writing = true;
+  if (!entry->pending_queue.empty())
+    ProcessPendingQueue(entry);
+}
+
+bool HttpCache::CanReadWhileWriting(ActiveEntry* entry,
+                                    Transaction* trans) const {
+  // The writer may have stopped caching the response.
+  return entry->shared_writing &&
+         (entry->writer->mode() & Transaction::WRITE) &&
+         trans->CanReadWhileWriting();
+}
+
+void HttpCache::WaitForEntryData(ActiveEntry* entry, Transaction* trans) {
+  DCHECK(entry->writer);
+  DCHECK(std::find(entry->readers.begin(), entry->readers.end(), trans) !=
+         entry->readers.end());
+  entry->waiting_readers.push_back(trans);
+}
+
+void HttpCache::ResumeWaitingReaders(ActiveEntry* entry) {
+  // The readers are notified asynchronously, so that they don't run in the
+  // middle of the writer's IO.
+  for (Transaction* trans : entry->waiting_readers) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::Bind(trans->io_callback(), OK));
+  }
+  entry->waiting_readers.clear();
+}
+
 LoadState HttpCache::GetLoadStateForPendingTransaction(
       const Transaction* trans) {
   ActiveEntriesMap::const_iterator i = active_entries_.find(trans->key());
@@ -996,7 +1067,30 @@ void HttpCache::ProcessPendingQueue(ActiveEntry* entry) {
 
 void HttpCache::OnProcessPendingQueue(ActiveEntry* entry) {
   entry->will_process_pending_queue = false;
-  DCHECK(!entry->writer);
+
+  if (entry->writer) {
+    // The writer is storing the body: let in the first transaction that can
+    // read it along, and come back for the next one.
+    DCHECK(entry->shared_writing);
+    TransactionList::iterator it = entry->pending_queue.begin();
+    while (it != entry->pending_queue.end() &&
+           !CanReadWhileWriting(entry, *it)) {
+      ++it;
+    }
+    if (it == entry->pending_queue.end())
+      return;  // Have to wait for the writer.
+
+    Transaction* next = *it;
+    entry->pending_queue.erase(it);
+    entry->readers.push_back(next);
+    next->net_log().AddEvent(
+        NetLog::TYPE_HTTP_CACHE_ADDED_TO_ENTRY,
+        NetLog::BoolCallback("reads_while_writing", true));
+    if (!entry->pending_queue.empty())
+      ProcessPendingQueue(entry);
+    next->io_callback().Run(OK);
+    return;
+  }
 
   // If no one is interested in this entry, then we can deactivate it.
   if (entry->pending_queue.empty()) {
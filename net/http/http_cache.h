@@ -75,6 +75,23 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     DISABLE
   };
 
+  // What a transaction does with the network while it waits for the disk cache
+  // to open its entry. Only GET requests that may be served from the cache or
+  // the network take part in the race; byte range and externally conditional
+  // requests don't.
+  enum CacheRaceMode {
+    // The network is not used before the entry is opened, or found missing.
+    CACHE_RACE_DISABLED = 0,
+    // Connect to the server while the entry is being opened, so that a miss
+    // or a validation request doesn't wait for DNS and connection setup.
+    CACHE_RACE_PRECONNECT,
+    // Send the request while the entry is being opened. The response is used
+    // if the entry turns out to be missing; if the entry is opened, the
+    // request is canceled. GETs are idempotent, so the canceled request is
+    // only a waste of bandwidth.
+    CACHE_RACE_SEND_REQUEST,
+  };
+
   // A BackendFactory creates a backend object to be used by the HttpCache.
   class NET_EXPORT BackendFactory {
    public:
@@ -179,6 +196,20 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   void set_mode(Mode value) { mode_ = value; }
   Mode mode() { return mode_; }
 
+  // Enables or disables shared writing. When enabled, requests for a resource
+  // that is being fetched from the network and stored by another transaction
+  // don't wait for the whole body to be stored: once the response headers are
+  // in the cache, they read the body from the entry as it is written.
+  void set_shared_writing_enabled(bool value) {
+    shared_writing_enabled_ = value;
+  }
+  bool shared_writing_enabled() const { return shared_writing_enabled_; }
+
+  // Get/Set how transactions race the network against slow cache entry opens.
+  // The default is CACHE_RACE_DISABLED.
+  void set_cache_race_mode(CacheRaceMode value) { cache_race_mode_ = value; }
+  CacheRaceMode cache_race_mode() const { return cache_race_mode_; }
+
   // Get/Set the cache's clock. These are public only for testing.
   void SetClockForTesting(std::unique_ptr<base::Clock> clock) {
     clock_.reset(clock.release());
@@ -259,6 +290,19 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     TransactionList    pending_queue;
     bool               will_process_pending_queue;
     bool               doomed;
+
+    // True once |writer| has stored the response headers and started storing
+    // the body, if shared writing is enabled. Transactions that only need to
+    // read the response then join |readers| without waiting for |writer|.
+    bool               shared_writing;
+
+    // Readers that have read all the data stored so far, and wait for
+    // |writer| to store more.
+    TransactionList    waiting_readers;
+
+    // True if |writer| went away without storing the whole body while there
+    // were readers. They fail when they get to the end of the stored data.
+    bool               truncated;
   };
 
   using ActiveEntriesMap = std::unordered_map<std::string, ActiveEntry*>;
@@ -361,6 +405,25 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // transactions can start reading from this entry.
   void ConvertWriterToReader(ActiveEntry* entry);
 
+  // Called when the writer of |entry| has stored the response headers and
+  // truncated the body, before storing the new body. If shared writing is
+  // enabled, pending transactions that only need to read the response can
+  // start reading it right away.
+  void BeginSharedWriting(ActiveEntry* entry);
+
+  // Returns true if |trans| can join |entry| as a reader while its writer is
+  // still storing the response body.
+  bool CanReadWhileWriting(ActiveEntry* entry, Transaction* trans) const;
+
+  // Called when |trans|, a reader of |entry|, has read all the data stored so
+  // far while the writer is still storing the body. |trans| will be notified
+  // via its IO callback when the writer stores more data or goes away.
+  void WaitForEntryData(ActiveEntry* entry, Transaction* trans);
+
+  // Notifies the readers of |entry| that are waiting for data that they can
+  // read again.
+  void ResumeWaitingReaders(ActiveEntry* entry);
+
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* trans);
 
@@ -409,6 +472,8 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   bool building_backend_;
   bool bypass_lock_for_test_;
   bool fail_conditionalization_for_test_;
+  bool shared_writing_enabled_;
+  CacheRaceMode cache_race_mode_;
 
   Mode mode_;
 
@@ -0,0 +1,95 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures the time it takes an HttpCache to deliver the response headers of
+// a GET, when opening a cache entry takes kOpenDelayMs and a round trip to
+// the server takes kRoundTripMs, with and without racing the network against
+// the entry open (HttpCache::CacheRaceMode). Misses are requests for a new
+// URL; hits are requests for a URL that is already cached.
+
+#include <memory>
+#include <string>
+
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction.h"
+#include "net/http/http_transaction_test_util.h"
+#include "net/http/mock_http_cache.h"
+#include "net/log/net_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 20;
+const int kOpenDelayMs = 20;
+const int kRoundTripMs = 30;
+
+// Runs |transaction| through |cache|, and returns the time it took to get the
+// response headers.
+base::TimeDelta TimeToHeaders(MockHttpCache* cache,
+                              const MockTransaction& transaction) {
+  MockHttpRequest request(transaction);
+  std::unique_ptr<HttpTransaction> trans;
+  EXPECT_EQ(OK, cache->CreateTransaction(&trans));
+
+  TestCompletionCallback callback;
+  base::TimeTicks start = base::TimeTicks::Now();
+  int rv = trans->Start(&request, callback.callback(), BoundNetLog());
+  EXPECT_EQ(OK, callback.GetResult(rv));
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::string content;
+  EXPECT_EQ(OK, ReadTransaction(trans.get(), &content));
+  EXPECT_EQ(transaction.data, content);
+  return elapsed;
+}
+
+void MeasureTimeToHeaders(HttpCache::CacheRaceMode race_mode,
+                          const std::string& trace) {
+  MockHttpCache cache;
+  cache.http_cache()->set_cache_race_mode(race_mode);
+  cache.disk_cache()->set_open_delay(
+      base::TimeDelta::FromMilliseconds(kOpenDelayMs));
+  cache.network_layer()->set_start_delay(
+      base::TimeDelta::FromMilliseconds(kRoundTripMs));
+
+  base::TimeDelta miss;
+  for (int i = 0; i < kIterations; ++i) {
+    std::string url = base::StringPrintf("http://www.google.com/race/%s/%d",
+                                         trace.c_str(), i);
+    MockTransaction transaction(kSimpleGET_Transaction);
+    transaction.url = url.c_str();
+    AddMockTransaction(&transaction);
+    miss += TimeToHeaders(&cache, transaction);
+    RemoveMockTransaction(&transaction);
+  }
+
+  // Store the response that the hits read.
+  TimeToHeaders(&cache, kSimpleGET_Transaction);
+  base::TimeDelta hit;
+  for (int i = 0; i < kIterations; ++i)
+    hit += TimeToHeaders(&cache, kSimpleGET_Transaction);
+
+  perf_test::PrintResult("http_cache_time_to_headers", "_miss", trace,
+                         miss.InMillisecondsF() / kIterations, "ms", true);
+  perf_test::PrintResult("http_cache_time_to_headers", "_hit", trace,
+                         hit.InMillisecondsF() / kIterations, "ms", true);
+}
+
+TEST(HttpCachePerfTest, TimeToHeaders) {
+  base::MessageLoopForIO message_loop;
+  MeasureTimeToHeaders(HttpCache::CACHE_RACE_DISABLED, "no_race");
+  MeasureTimeToHeaders(HttpCache::CACHE_RACE_SEND_REQUEST, "send_request");
+}
+
+}  // namespace
+
+}  // namespace net
@@ -38,6 +38,7 @@
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_request_info.h"
+#include "net/http/http_stream_factory.h"
 #include "net/http/http_util.h"
 #include "net/ssl/ssl_cert_request_info.h"
 #include "net/ssl/ssl_config_service.h"
@@ -77,6 +78,25 @@ enum ExternallyConditionalizedType {
   EXTERNALLY_CONDITIONALIZED_MAX
 };
 
+// What became of a request sent while its cache entry was being opened, with
+// HttpCache::CACHE_RACE_SEND_REQUEST.
+// NOTE: This enumeration is used in histograms, so please do not add entries
+// in the middle.
+enum CacheRaceOutcome {
+  // The entry was opened, and the request canceled.
+  CACHE_RACE_OUTCOME_ENTRY_OPENED,
+  // The entry didn't exist, and the response was used.
+  CACHE_RACE_OUTCOME_REQUEST_USED,
+  // The transaction was destroyed before the entry was opened.
+  CACHE_RACE_OUTCOME_ABANDONED,
+  CACHE_RACE_OUTCOME_MAX
+};
+
+void RecordCacheRaceOutcome(CacheRaceOutcome outcome) {
+  UMA_HISTOGRAM_ENUMERATION("HttpCache.CacheRace.Outcome", outcome,
+                            CACHE_RACE_OUTCOME_MAX);
+}
+
 }  // namespace
 
 struct HeaderNameAndValue {
@@ -156,6 +176,7 @@ HttpCache::Transaction::Transaction(RequestPriority priority, HttpCache* cache)
       range_requested_(false),
       handling_206_(false),
       cache_pending_(false),
+      shared_reader_(false),
       done_reading_(false),
       vary_mismatch_(false),
       couldnt_conditionalize_request_(false),
@@ -165,8 +186,11 @@ HttpCache::Transaction::Transaction(RequestPriority priority, HttpCache* cache)
       read_offset_(0),
       effective_load_flags_(0),
       write_len_(0),
+      speculative_result_(ERR_IO_PENDING),
       transaction_pattern_(PATTERN_UNDEFINED),
       validation_cause_(VALIDATION_CAUSE_UNDEFINED),
+      cache_race_open_raced_request_(false),
+      cache_race_request_completed_first_(false),
       total_received_bytes_(0),
       total_sent_bytes_(0),
       websocket_handshake_stream_base_create_helper_(NULL),
@@ -184,6 +208,9 @@ HttpCache::Transaction::~Transaction() {
   // after this point.
   callback_.Reset();
 
+  if (speculative_trans_)
+    RecordCacheRaceOutcome(CACHE_RACE_OUTCOME_ABANDONED);
+
   if (cache_) {
     if (entry_) {
       bool cancel_request = reading_ && response_.headers.get();
@@ -238,6 +265,12 @@ bool HttpCache::Transaction::AddTruncatedFlag() {
   return true;
 }
 
+bool HttpCache::Transaction::CanReadWhileWriting() const {
+  if (mode_ != READ && mode_ != READ_WRITE)
+    return false;
+  return !partial_ && !(effective_load_flags_ & LOAD_VALIDATE_CACHE);
+}
+
 LoadState HttpCache::Transaction::GetWriterLoadState() const {
   if (network_trans_.get())
     return network_trans_->GetLoadState();
@@ -403,8 +436,10 @@ void HttpCache::Transaction::StopCaching() {
   // TODO(mmenke):  This doesn't release the lock on the cache entry, so a
   //                future request for the resource will be blocked on this one.
   //                Fix this.
+  // Other transactions may be reading the body as we store it, in which case
+  // we keep caching.
   if (cache_.get() && entry_ && (mode_ & WRITE) && network_trans_.get() &&
-      !is_sparse_ && !range_requested_) {
+      !is_sparse_ && !range_requested_ && entry_->readers.empty()) {
     mode_ = NONE;
   }
 }
@@ -518,6 +553,8 @@ void HttpCache::Transaction::SetPriority(RequestPriority priority) {
   priority_ = priority;
   if (network_trans_)
     network_trans_->SetPriority(priority_);
+  if (speculative_trans_)
+    speculative_trans_->SetPriority(priority_);
 }
 
 void HttpCache::Transaction::SetWebSocketHandshakeStreamCreateHelper(
@@ -542,6 +579,8 @@ void HttpCache::Transaction::SetBeforeProxyHeadersSentCallback(
 int HttpCache::Transaction::ResumeNetworkStart() {
   if (network_trans_)
     return network_trans_->ResumeNetworkStart();
+  if (speculative_trans_)
+    return speculative_trans_->ResumeNetworkStart();
   return ERR_UNEXPECTED;
 }
 
@@ -685,6 +724,12 @@ void HttpCache::Transaction::GetConnectionAttempts(
 // 14. Cached entry more than 5 minutes old, unused_since_prefetch is true:
 //   Like examples 2-4, only CacheToggleUnusedSincePrefetch* is inserted between
 //   CacheReadResponse* and CacheDispatchValidation.
+//
+// 15. Not-cached entry, HttpCache::CACHE_RACE_SEND_REQUEST:
+//   Like example 1, only OpenEntry starts a speculative network transaction
+//   when the entry is not opened synchronously, and SendRequest* uses it
+//   instead of starting a new one. If the entry is opened, the speculative
+//   transaction is canceled and the flow is that of examples 2-4.
 int HttpCache::Transaction::DoLoop(int result) {
   DCHECK(next_state_ != STATE_NONE);
 
@@ -960,7 +1005,10 @@ int HttpCache::Transaction::DoOpenEntry() {
   cache_pending_ = true;
   net_log_.BeginEvent(NetLog::TYPE_HTTP_CACHE_OPEN_ENTRY);
   first_cache_access_since_ = TimeTicks::Now();
-  return cache_->OpenEntry(cache_key_, &new_entry_, this);
+  int rv = cache_->OpenEntry(cache_key_, &new_entry_, this);
+  if (rv == ERR_IO_PENDING)
+    StartCacheRace();
+  return rv;
 }
 
 int HttpCache::Transaction::DoOpenEntryComplete(int result) {
@@ -969,13 +1017,16 @@ int HttpCache::Transaction::DoOpenEntryComplete(int result) {
   // transaction attached.
   net_log_.EndEventWithNetErrorCode(NetLog::TYPE_HTTP_CACHE_OPEN_ENTRY, result);
   cache_pending_ = false;
-  if (result == OK) {
-    next_state_ = STATE_ADD_TO_ENTRY;
+  if (result == ERR_CACHE_RACE) {
+    next_state_ = STATE_INIT_ENTRY;
     return OK;
   }
 
-  if (result == ERR_CACHE_RACE) {
-    next_state_ = STATE_INIT_ENTRY;
+  if (!cache_race_since_.is_null())
+    OnCacheRaceOpenComplete(result == OK);
+
+  if (result == OK) {
+    next_state_ = STATE_ADD_TO_ENTRY;
     return OK;
   }
 
@@ -1052,6 +1103,7 @@ int HttpCache::Transaction::DoCreateEntryComplete(int result) {
       // already created the entry. If we want to eliminate this issue, we
       // need an atomic OpenOrCreate() method exposed by the disk cache.
       DLOG(WARNING) << "Unable to create cache entry";
+      RecordCacheRaceOpenHistograms();
       mode_ = NONE;
       if (partial_)
         partial_->RestoreHeaders(&custom_request_->extra_headers);
@@ -1112,8 +1164,10 @@ int HttpCache::Transaction::DoAddToEntryComplete(int result) {
   DCHECK(new_entry_);
   cache_pending_ = false;
 
-  if (result == OK)
+  if (result == OK) {
     entry_ = new_entry_;
+    shared_reader_ = entry_->writer && entry_->writer != this;
+  }
 
   // If there is a failure, the cache should have taken care of new_entry_.
   new_entry_ = NULL;
@@ -1123,6 +1177,8 @@ int HttpCache::Transaction::DoAddToEntryComplete(int result) {
     return OK;
   }
 
+  RecordCacheRaceOpenHistograms();
+
   if (result == ERR_CACHE_LOCK_TIMEOUT) {
     // The cache is busy, bypass it for this transaction.
     mode_ = NONE;
@@ -1296,6 +1352,9 @@ int HttpCache::Transaction::DoSendRequest() {
   DCHECK(mode_ & WRITE || mode_ == NONE);
   DCHECK(!network_trans_.get());
 
+  if (speculative_trans_)
+    return UseSpeculativeRequest();
+
   send_request_since_ = TimeTicks::Now();
 
   // Create a network transaction.
@@ -1622,6 +1681,10 @@ int HttpCache::Transaction::DoTruncateCachedMetadataComplete(int result) {
       net_log_.EndEventWithNetErrorCode(NetLog::TYPE_HTTP_CACHE_WRITE_INFO,
                                         result);
     }
+    // The new headers are stored and the old body is gone, so other
+    // transactions may now read the body as we store it.
+    if (mode_ == WRITE && !partial_)
+      cache_->BeginSharedWriting(entry_);
   }
 
   next_state_ = STATE_PARTIAL_HEADERS_RECEIVED;
@@ -1696,6 +1759,10 @@ int HttpCache::Transaction::DoCacheReadData() {
   if (request_->method == "HEAD")
     return 0;
 
+  // We may be resuming after waiting for the writer of the entry.
+  if (!cache_.get())
+    return ERR_UNEXPECTED;
+
   DCHECK(entry_);
   next_state_ = STATE_CACHE_READ_DATA_COMPLETE;
 
@@ -1730,6 +1797,18 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   if (result > 0) {
     read_offset_ += result;
   } else if (result == 0) {  // End of file.
+    if (entry_->writer) {
+      // We have read all the data stored so far, but the writer isn't done.
+      next_state_ = STATE_CACHE_READ_DATA;
+      if (entry_->disk_entry->GetDataSize(kResponseContentIndex) > read_offset_)
+        return OK;
+      cache_->WaitForEntryData(entry_, this);
+      return ERR_IO_PENDING;
+    }
+    if (entry_->truncated) {
+      // The writer went away before storing the whole body.
+      return ERR_CACHE_READ_FAILURE;
+    }
     RecordHistograms();
     cache_->DoneReadingFromEntry(entry_, this);
     entry_ = NULL;
@@ -1779,6 +1858,9 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
       done_reading_ = true;
   }
 
+  if (entry_ && result > 0)
+    cache_->ResumeWaitingReaders(entry_);
+
   if (partial_) {
     // This may be the last request.
     if (result != 0 || truncated_ ||
@@ -2000,6 +2082,16 @@ int HttpCache::Transaction::BeginCacheValidation() {
   if (skip_validation) {
     UpdateTransactionPattern(PATTERN_ENTRY_USED);
     return SetupEntryForRead();
+  } else if (shared_reader_) {
+    // The entry is being written by another transaction, so we cannot update
+    // it. Fetch the resource without the cache instead of waiting for the
+    // writer to be done.
+    UpdateTransactionPattern(PATTERN_NOT_COVERED);
+    cache_->DoneReadingFromEntry(entry_, this);
+    entry_ = NULL;
+    shared_reader_ = false;
+    mode_ = NONE;
+    next_state_ = STATE_SEND_REQUEST;
   } else {
     // Make the network request conditional, to see if we may reuse our cached
     // response.  If we cannot do so, then we just resort to a normal fetch.
@@ -2457,7 +2549,8 @@ int HttpCache::Transaction::SetupEntryForRead() {
       partial_.reset();
     }
   }
-  cache_->ConvertWriterToReader(entry_);
+  if (!shared_reader_)
+    cache_->ConvertWriterToReader(entry_);
   mode_ = READ;
 
   if (request_->method == "HEAD")
@@ -2668,6 +2761,116 @@ void HttpCache::Transaction::ResetNetworkTransaction() {
   network_trans_.reset();
 }
 
+void HttpCache::Transaction::StartCacheRace() {
+  // Only race once, even if the open has to be retried.
+  if (!cache_race_since_.is_null())
+    return;
+
+  HttpCache::CacheRaceMode race_mode = cache_->cache_race_mode();
+  if (race_mode == HttpCache::CACHE_RACE_DISABLED || mode_ != READ_WRITE ||
+      partial_ || request_->method != "GET" ||
+      (effective_load_flags_ & LOAD_PREFERRING_CACHE) ||
+      websocket_handshake_stream_base_create_helper_) {
+    return;
+  }
+
+  cache_race_since_ = TimeTicks::Now();
+
+  if (race_mode == HttpCache::CACHE_RACE_PRECONNECT) {
+    // Session may be NULL in unittests.
+    HttpNetworkSession* session = cache_->GetSession();
+    if (session)
+      session->http_stream_factory()->PreconnectStreams(1, *request_);
+    return;
+  }
+
+  DCHECK_EQ(HttpCache::CACHE_RACE_SEND_REQUEST, race_mode);
+  if (cache_->network_layer_->CreateTransaction(priority_,
+                                                &speculative_trans_) != OK) {
+    speculative_trans_.reset();
+    return;
+  }
+  speculative_trans_->SetBeforeNetworkStartCallback(
+      before_network_start_callback_);
+  speculative_trans_->SetBeforeProxyHeadersSentCallback(
+      before_proxy_headers_sent_callback_);
+
+  // The request is sent as is: it is only used if there is no entry, in which
+  // case it wouldn't have been conditionalized.
+  send_request_since_ = cache_race_since_;
+  speculative_result_ = speculative_trans_->Start(
+      request_,
+      base::Bind(&Transaction::OnSpeculativeRequestComplete,
+                 weak_factory_.GetWeakPtr()),
+      net_log_);
+}
+
+void HttpCache::Transaction::OnCacheRaceOpenComplete(bool entry_opened) {
+  // The open is retried if the entry is doomed before this transaction is
+  // added to it, so only the last attempt is recorded, by
+  // RecordCacheRaceOpenHistograms().
+  cache_race_open_complete_ = TimeTicks::Now();
+  cache_race_open_raced_request_ = !!speculative_trans_;
+  if (!speculative_trans_)
+    return;
+
+  cache_race_request_completed_first_ = speculative_result_ != ERR_IO_PENDING;
+  if (entry_opened) {
+    RecordCacheRaceOutcome(CACHE_RACE_OUTCOME_ENTRY_OPENED);
+    ResetSpeculativeRequest();
+  }
+}
+
+void HttpCache::Transaction::RecordCacheRaceOpenHistograms() {
+  if (cache_race_open_complete_.is_null())
+    return;
+
+  UMA_HISTOGRAM_TIMES("HttpCache.CacheRace.OpenTime",
+                      cache_race_open_complete_ - cache_race_since_);
+  if (cache_race_open_raced_request_) {
+    UMA_HISTOGRAM_BOOLEAN("HttpCache.CacheRace.RequestCompletedFirst",
+                          cache_race_request_completed_first_);
+  }
+  cache_race_open_complete_ = TimeTicks();
+}
+
+int HttpCache::Transaction::UseSpeculativeRequest() {
+  DCHECK(speculative_trans_);
+  RecordCacheRaceOutcome(CACHE_RACE_OUTCOME_REQUEST_USED);
+  UMA_HISTOGRAM_TIMES("HttpCache.CacheRace.RequestHeadStart",
+                      TimeTicks::Now() - send_request_since_);
+
+  network_trans_ = std::move(speculative_trans_);
+  old_network_trans_load_timing_.reset();
+  old_remote_endpoint_ = IPEndPoint();
+
+  // If the request is still pending, OnSpeculativeRequestComplete() resumes
+  // the state machine.
+  next_state_ = STATE_SEND_REQUEST_COMPLETE;
+  return speculative_result_;
+}
+
+void HttpCache::Transaction::ResetSpeculativeRequest() {
+  DCHECK(speculative_trans_);
+  total_received_bytes_ += speculative_trans_->GetTotalReceivedBytes();
+  total_sent_bytes_ += speculative_trans_->GetTotalSentBytes();
+  speculative_trans_.reset();
+  speculative_result_ = ERR_IO_PENDING;
+  send_request_since_ = TimeTicks();
+}
+
+void HttpCache::Transaction::OnSpeculativeRequestComplete(int result) {
+  if (speculative_trans_) {
+    // The entry is still being opened.
+    speculative_result_ = result;
+    return;
+  }
+
+  // The request became |network_trans_| while it was pending.
+  DCHECK_EQ(STATE_SEND_REQUEST_COMPLETE, next_state_);
+  OnIOComplete(result);
+}
+
 // Histogram data from the end of 2010 show the following distribution of
 // response headers:
 //
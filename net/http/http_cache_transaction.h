@@ -110,6 +110,14 @@ class HttpCache::Transaction : public HttpTransaction {
 
   HttpCache::ActiveEntry* entry() { return entry_; }
 
+  // Returns true if the stored response is known to be incomplete.
+  bool truncated() const { return truncated_; }
+
+  // Returns true if this transaction can read the response while another
+  // transaction is storing its body in the entry. Byte range requests and
+  // requests that must be validated wait for the writer to be done instead.
+  bool CanReadWhileWriting() const;
+
   // Returns the LoadState of the writer transaction of a given ActiveEntry. In
   // other words, returns the LoadState of this transaction without asking the
   // http cache, because this transaction should be the one currently writing
@@ -427,6 +435,29 @@ class HttpCache::Transaction : public HttpTransaction {
   // |old_network_trans_load_timing_|, which must be NULL when this is called.
   void ResetNetworkTransaction();
 
+  // Called when the cache entry is being opened asynchronously. Races the
+  // network against the open, as configured by HttpCache::cache_race_mode().
+  void StartCacheRace();
+
+  // Called when the entry open of a race completes. |entry_opened| is true if
+  // the entry exists, in which case a speculative request is canceled.
+  void OnCacheRaceOpenComplete(bool entry_opened);
+
+  // Records the histograms of the last entry open of a race, once the entry
+  // setup is done and the open won't be retried after ERR_CACHE_RACE.
+  void RecordCacheRaceOpenHistograms();
+
+  // Makes the speculative request started by StartCacheRace() the network
+  // transaction of this request. Returns the result of its Start(), or
+  // ERR_IO_PENDING if it hasn't completed yet.
+  int UseSpeculativeRequest();
+
+  // Cancels the speculative request started by StartCacheRace().
+  void ResetSpeculativeRequest();
+
+  // Called when the Start() of the speculative request completes.
+  void OnSpeculativeRequestComplete(int result);
+
   // Returns true if we should bother attempting to resume this request if it
   // is aborted while in progress. If |has_data| is true, the size of the stored
   // data is considered for the result.
@@ -464,6 +495,7 @@ class HttpCache::Transaction : public HttpTransaction {
   bool range_requested_;  // The user requested a byte range.
   bool handling_206_;  // We must deal with this 206 response.
   bool cache_pending_;  // We are waiting for the HttpCache.
+  bool shared_reader_;  // We joined the entry while it was being written.
   bool done_reading_;  // All available data was read.
   bool vary_mismatch_;  // The request doesn't match the stored vary data.
   bool couldnt_conditionalize_request_;
@@ -475,6 +507,12 @@ class HttpCache::Transaction : public HttpTransaction {
   int effective_load_flags_;
   int write_len_;
   std::unique_ptr<PartialData> partial_;  // We are dealing with range requests.
+
+  // The request sent while the cache entry is being opened, and the result of
+  // its Start(), when racing with HttpCache::CACHE_RACE_SEND_REQUEST. It
+  // becomes |network_trans_| if the entry doesn't exist.
+  std::unique_ptr<HttpTransaction> speculative_trans_;
+  int speculative_result_;
   UploadProgress final_upload_progress_;
   CompletionCallback io_callback_;
 
@@ -484,6 +522,10 @@ class HttpCache::Transaction : public HttpTransaction {
   base::TimeTicks entry_lock_waiting_since_;
   base::TimeTicks first_cache_access_since_;
   base::TimeTicks send_request_since_;
+  base::TimeTicks cache_race_since_;
+  base::TimeTicks cache_race_open_complete_;
+  bool cache_race_open_raced_request_;
+  bool cache_race_request_completed_first_;
 
   int64_t total_received_bytes_;
   int64_t total_sent_bytes_;
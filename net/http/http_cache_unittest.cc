@@ -5,6 +5,7 @@
 #include "net/http/http_cache.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
 #include <memory>
@@ -16,9 +17,11 @@
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/message_loop/message_loop.h"
+#include "base/pending_task.h"
 #include "base/run_loop.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/test/histogram_tester.h"
 #include "base/test/simple_test_clock.h"
 #include "net/base/cache_type.h"
 #include "net/base/elements_upload_data_stream.h"
@@ -575,6 +578,100 @@ struct Context {
   std::unique_ptr<HttpTransaction> trans;
 };
 
+// Records when each of a set of TestTransactionConsumers gets the first byte
+// of the response body, and when it is done. Time is measured in network
+// events, i.e. completions of MockNetworkTransaction IO, so that latencies
+// don't depend on how many tasks the cache itself posts.
+class FetchLatencyObserver : public base::MessageLoop::TaskObserver {
+ public:
+  explicit FetchLatencyObserver(
+      const std::vector<std::unique_ptr<TestTransactionConsumer>>* consumers)
+      : consumers_(consumers),
+        network_time_(0),
+        first_byte_times_(consumers->size(), -1),
+        done_times_(consumers->size(), -1) {
+    base::MessageLoop::current()->AddTaskObserver(this);
+  }
+
+  ~FetchLatencyObserver() override {
+    base::MessageLoop::current()->RemoveTaskObserver(this);
+  }
+
+  // Returns the sum of the times to first byte of all consumers.
+  int aggregate_first_byte_latency() const { return Sum(first_byte_times_); }
+
+  // Returns the sum of the times to completion of all consumers.
+  int aggregate_done_latency() const { return Sum(done_times_); }
+
+  // base::MessageLoop::TaskObserver implementation:
+  void WillProcessTask(const base::PendingTask& pending_task) override {}
+
+  void DidProcessTask(const base::PendingTask& pending_task) override {
+    if (base::EndsWith(pending_task.posted_from.file_name(),
+                       "http_transaction_test_util.cc",
+                       base::CompareCase::SENSITIVE)) {
+      ++network_time_;
+    }
+    for (size_t i = 0; i < consumers_->size(); ++i) {
+      const TestTransactionConsumer* consumer = (*consumers_)[i].get();
+      if (first_byte_times_[i] < 0 && !consumer->content().empty())
+        first_byte_times_[i] = network_time_;
+      if (done_times_[i] < 0 && consumer->is_done())
+        done_times_[i] = network_time_;
+    }
+  }
+
+ private:
+  static int Sum(const std::vector<int>& times) {
+    int sum = 0;
+    for (int time : times) {
+      EXPECT_LE(0, time);
+      sum += time;
+    }
+    return sum;
+  }
+
+  const std::vector<std::unique_ptr<TestTransactionConsumer>>* consumers_;
+  int network_time_;
+  std::vector<int> first_byte_times_;
+  std::vector<int> done_times_;
+
+  DISALLOW_COPY_AND_ASSIGN(FetchLatencyObserver);
+};
+
+// Runs |num_fetches| concurrent fetches of |mock_transaction| on a new cache,
+// with shared writing enabled or not, and returns their aggregate latencies.
+void RunConcurrentFetches(const MockTransaction& mock_transaction,
+                          int num_fetches,
+                          bool shared_writing,
+                          int* first_byte_latency,
+                          int* done_latency) {
+  MockHttpCache cache;
+  cache.http_cache()->set_shared_writing_enabled(shared_writing);
+  MockHttpRequest request(mock_transaction);
+
+  std::vector<std::unique_ptr<TestTransactionConsumer>> consumers;
+  for (int i = 0; i < num_fetches; ++i) {
+    consumers.push_back(base::WrapUnique(
+        new TestTransactionConsumer(DEFAULT_PRIORITY, cache.http_cache())));
+  }
+
+  FetchLatencyObserver observer(&consumers);
+  for (const auto& consumer : consumers)
+    consumer->Start(&request, BoundNetLog());
+  base::RunLoop().Run();
+
+  for (const auto& consumer : consumers) {
+    EXPECT_TRUE(consumer->is_done());
+    EXPECT_EQ(OK, consumer->error());
+    EXPECT_EQ(mock_transaction.data, consumer->content());
+  }
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+
+  *first_byte_latency = observer.aggregate_first_byte_latency();
+  *done_latency = observer.aggregate_done_latency();
+}
+
 class FakeWebSocketHandshakeStreamCreateHelper
     : public WebSocketHandshakeStreamBase::CreateHelper {
  public:
@@ -1783,6 +1880,290 @@ TEST(HttpCache, SimpleGET_ManyWriters_DeleteCache) {
   }
 }
 
+// Tests that with shared writing, transactions for a resource that is being
+// fetched join the entry as soon as its headers are stored, and read the body
+// as the writer stores it.
+TEST(HttpCache, SimpleGET_SharedWriting_ManyReaders) {
+  MockHttpCache cache;
+  cache.http_cache()->set_shared_writing_enabled(true);
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+
+  std::vector<Context*> context_list;
+  const int kNumTransactions = 5;
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    context_list.push_back(new Context());
+    Context* c = context_list[i];
+
+    c->result = cache.CreateTransaction(&c->trans);
+    ASSERT_EQ(OK, c->result);
+
+    c->result =
+        c->trans->Start(&request, c->callback.callback(), BoundNetLog());
+  }
+
+  // All transactions get the response headers, although the writer hasn't
+  // read the body yet.
+  base::RunLoop().RunUntilIdle();
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    ASSERT_TRUE(c->callback.have_result());
+    EXPECT_EQ(OK, c->callback.WaitForResult());
+  }
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+
+  // A reader waits for the writer to store the body.
+  Context* reader = context_list[1];
+  scoped_refptr<IOBuffer> buf(new IOBuffer(256));
+  TestCompletionCallback read_callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            reader->trans->Read(buf.get(), 256, read_callback.callback()));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(read_callback.have_result());
+
+  ReadAndVerifyTransaction(context_list[0]->trans.get(),
+                           kSimpleGET_Transaction);
+
+  int rv = read_callback.WaitForResult();
+  ASSERT_LT(0, rv);
+  std::string content(buf->data(), rv);
+  std::string rest;
+  EXPECT_EQ(OK, ReadTransaction(reader->trans.get(), &rest));
+  EXPECT_EQ(kSimpleGET_Transaction.data, content + rest);
+
+  for (int i = 2; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    ReadAndVerifyTransaction(c->trans.get(), kSimpleGET_Transaction);
+  }
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    delete c;
+  }
+}
+
+// Tests that readers that joined a shared writer fail once they get to the end
+// of the stored data if the writer goes away, and that the entry is not used
+// again.
+TEST(HttpCache, SimpleGET_SharedWriting_CancelWriter) {
+  MockHttpCache cache;
+  cache.http_cache()->set_shared_writing_enabled(true);
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+
+  Context writer;
+  Context reader;
+  ASSERT_EQ(OK, cache.CreateTransaction(&writer.trans));
+  ASSERT_EQ(OK, cache.CreateTransaction(&reader.trans));
+  writer.result =
+      writer.trans->Start(&request, writer.callback.callback(), BoundNetLog());
+  reader.result =
+      reader.trans->Start(&request, reader.callback.callback(), BoundNetLog());
+  EXPECT_EQ(OK, writer.callback.GetResult(writer.result));
+  EXPECT_EQ(OK, reader.callback.GetResult(reader.result));
+
+  scoped_refptr<IOBuffer> buf(new IOBuffer(256));
+  TestCompletionCallback read_callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            reader.trans->Read(buf.get(), 256, read_callback.callback()));
+
+  writer.trans.reset();
+  EXPECT_EQ(ERR_CACHE_READ_FAILURE, read_callback.WaitForResult());
+
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(2, cache.disk_cache()->create_count());
+}
+
+// Tests that a transaction that would have to validate the response being
+// written by a shared writer fetches it from the network instead of waiting
+// for the writer.
+TEST(HttpCache, SimpleGET_SharedWriting_ValidationBypassesCache) {
+  MockHttpCache cache;
+  cache.http_cache()->set_shared_writing_enabled(true);
+
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = "Cache-Control: max-age=0\n";
+  MockHttpRequest request(transaction);
+
+  Context writer;
+  Context validator;
+  ASSERT_EQ(OK, cache.CreateTransaction(&writer.trans));
+  ASSERT_EQ(OK, cache.CreateTransaction(&validator.trans));
+  writer.result =
+      writer.trans->Start(&request, writer.callback.callback(), BoundNetLog());
+  validator.result = validator.trans->Start(
+      &request, validator.callback.callback(), BoundNetLog());
+  EXPECT_EQ(OK, writer.callback.GetResult(writer.result));
+  EXPECT_EQ(OK, validator.callback.GetResult(validator.result));
+
+  ReadAndVerifyTransaction(validator.trans.get(), transaction);
+  ReadAndVerifyTransaction(writer.trans.get(), transaction);
+
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Compares the aggregate latency of concurrent fetches of a resource whose
+// body arrives slowly from the network, with and without shared writing.
+TEST(HttpCache, SimpleGET_SharedWriting_ConcurrentFetchLatency) {
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.test_mode |= TEST_MODE_SLOW_READ;
+  const int kNumFetches = 10;
+
+  int serial_first_byte_latency = 0;
+  int serial_done_latency = 0;
+  RunConcurrentFetches(transaction, kNumFetches, false,
+                       &serial_first_byte_latency, &serial_done_latency);
+
+  int shared_first_byte_latency = 0;
+  int shared_done_latency = 0;
+  RunConcurrentFetches(transaction, kNumFetches, true,
+                       &shared_first_byte_latency, &shared_done_latency);
+
+  RecordProperty("SerialFirstByteLatency", serial_first_byte_latency);
+  RecordProperty("SerialDoneLatency", serial_done_latency);
+  RecordProperty("SharedFirstByteLatency", shared_first_byte_latency);
+  RecordProperty("SharedDoneLatency", shared_done_latency);
+
+  // Without shared writing, only the writer gets the body before all of it
+  // has arrived. With it, the other fetches get their first byte about when
+  // the writer does, and none of them finishes later.
+  const int kBodySize = static_cast<int>(strlen(transaction.data));
+  EXPECT_LE((kNumFetches - 1) * kBodySize, serial_first_byte_latency);
+  EXPECT_LT(shared_first_byte_latency * 2, serial_first_byte_latency);
+  EXPECT_LE(shared_done_latency, serial_done_latency);
+}
+
+// Values of the HttpCache.CacheRace.Outcome histogram.
+const int kCacheRaceEntryOpened = 0;
+const int kCacheRaceRequestUsed = 1;
+const int kCacheRaceAbandoned = 2;
+
+// Tests that when racing the network against a slow entry open, the request is
+// sent while the entry is being opened, and used if there is no entry.
+TEST(HttpCache, SimpleGET_CacheRace_Miss) {
+  base::HistogramTester histograms;
+  MockHttpCache cache;
+  cache.http_cache()->set_cache_race_mode(HttpCache::CACHE_RACE_SEND_REQUEST);
+  cache.disk_cache()->set_open_delay(base::TimeDelta::FromMilliseconds(10));
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context c;
+  ASSERT_EQ(OK, cache.CreateTransaction(&c.trans));
+  c.result = c.trans->Start(&request, c.callback.callback(), BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, c.result);
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+
+  // The response arrives before the open completes.
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(c.callback.have_result());
+
+  EXPECT_EQ(OK, c.callback.WaitForResult());
+  ReadAndVerifyTransaction(c.trans.get(), kSimpleGET_Transaction);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+  histograms.ExpectUniqueSample("HttpCache.CacheRace.Outcome",
+                                kCacheRaceRequestUsed, 1);
+  histograms.ExpectUniqueSample("HttpCache.CacheRace.RequestCompletedFirst",
+                                true, 1);
+}
+
+// Tests that when racing the network against a slow entry open, the request is
+// canceled if the entry is opened, and the response read from the cache.
+TEST(HttpCache, SimpleGET_CacheRace_Hit) {
+  MockHttpCache cache;
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+
+  base::HistogramTester histograms;
+  cache.http_cache()->set_cache_race_mode(HttpCache::CACHE_RACE_SEND_REQUEST);
+  cache.disk_cache()->set_open_delay(base::TimeDelta::FromMilliseconds(10));
+
+  HttpResponseInfo response;
+  RunTransactionTestWithResponseInfo(cache.http_cache(), kSimpleGET_Transaction,
+                                     &response);
+  EXPECT_TRUE(response.was_cached);
+
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_FALSE(cache.network_layer()->last_transaction());
+  EXPECT_EQ(1, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+  histograms.ExpectUniqueSample("HttpCache.CacheRace.Outcome",
+                                kCacheRaceEntryOpened, 1);
+}
+
+// Tests that a transaction destroyed while racing the network against its entry
+// open doesn't prevent the next one from using the cache.
+TEST(HttpCache, SimpleGET_CacheRace_DestroyWhileOpening) {
+  base::HistogramTester histograms;
+  MockHttpCache cache;
+  cache.http_cache()->set_cache_race_mode(HttpCache::CACHE_RACE_SEND_REQUEST);
+  cache.disk_cache()->set_open_delay(base::TimeDelta::FromMilliseconds(10));
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context c;
+  ASSERT_EQ(OK, cache.CreateTransaction(&c.trans));
+  c.result = c.trans->Start(&request, c.callback.callback(), BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, c.result);
+  c.trans.reset();
+  histograms.ExpectUniqueSample("HttpCache.CacheRace.Outcome",
+                                kCacheRaceAbandoned, 1);
+
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+  histograms.ExpectBucketCount("HttpCache.CacheRace.Outcome",
+                               kCacheRaceRequestUsed, 1);
+}
+
+// Tests that byte range requests don't race the network against the entry
+// open.
+TEST(HttpCache, RangeGET_CacheRace_NotRaced) {
+  base::HistogramTester histograms;
+  MockHttpCache cache;
+  cache.http_cache()->set_cache_race_mode(HttpCache::CACHE_RACE_SEND_REQUEST);
+  cache.disk_cache()->set_open_delay(base::TimeDelta::FromMilliseconds(10));
+  AddMockTransaction(&kRangeGET_TransactionOK);
+
+  RunTransactionTest(cache.http_cache(), kRangeGET_TransactionOK);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  histograms.ExpectTotalCount("HttpCache.CacheRace.OpenTime", 0);
+  RemoveMockTransaction(&kRangeGET_TransactionOK);
+}
+
+// Tests that preconnecting while the entry is being opened doesn't send the
+// request early.
+TEST(HttpCache, SimpleGET_CacheRace_Preconnect) {
+  base::HistogramTester histograms;
+  MockHttpCache cache;
+  cache.http_cache()->set_cache_race_mode(HttpCache::CACHE_RACE_PRECONNECT);
+  cache.disk_cache()->set_open_delay(base::TimeDelta::FromMilliseconds(10));
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context c;
+  ASSERT_EQ(OK, cache.CreateTransaction(&c.trans));
+  c.result = c.trans->Start(&request, c.callback.callback(), BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, c.result);
+  EXPECT_EQ(0, cache.network_layer()->transaction_count());
+
+  EXPECT_EQ(OK, c.callback.WaitForResult());
+  ReadAndVerifyTransaction(c.trans.get(), kSimpleGET_Transaction);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  histograms.ExpectTotalCount("HttpCache.CacheRace.OpenTime", 1);
+  histograms.ExpectTotalCount("HttpCache.CacheRace.Outcome", 0);
+}
+
 // Tests that we queue requests when initializing the backend.
 TEST(HttpCache, SimpleGET_WaitForBackend) {
   MockBlockingBackendFactory* factory = new MockBlockingBackendFactory();
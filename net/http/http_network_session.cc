@@ -101,6 +101,7 @@ HttpNetworkSession::Params::Params()
       enable_alternative_service_for_insecure_origins(false),
       enable_npn(false),
       enable_priority_dependencies(true),
+      enable_spdy_data_slices(false),
       enable_quic(false),
       disable_quic_on_timeout_with_open_streams(false),
       enable_quic_port_selection(true),
@@ -132,7 +133,9 @@ HttpNetworkSession::Params::Params()
       quic_migrate_sessions_early(false),
       quic_disable_bidirectional_streams(false),
       proxy_delegate(NULL),
-      enable_token_binding(false) {
+      enable_token_binding(false),
+      enable_predictive_preconnect(false),
+      network_quality_estimator(NULL) {
   quic_supported_versions.push_back(QUIC_VERSION_32);
 }
 
@@ -195,6 +198,7 @@ HttpNetworkSession::HttpNetworkSession(const Params& params)
                          params.transport_security_state,
                          params.enable_spdy_ping_based_connection_checking,
                          params.enable_priority_dependencies,
+                         params.enable_spdy_data_slices,
                          params.spdy_default_protocol,
                          params.spdy_session_max_recv_window_size,
                          params.spdy_stream_max_recv_window_size,
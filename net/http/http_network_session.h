@@ -45,6 +45,7 @@ class HttpProxyClientSocketPool;
 class HttpResponseBodyDrainer;
 class HttpServerProperties;
 class NetLog;
+class NetworkQualityEstimator;
 class ProxyDelegate;
 class ProxyService;
 class QuicClock;
@@ -109,6 +110,9 @@ class NET_EXPORT HttpNetworkSession
 
     // Enable setting of HTTP/2 dependencies based on priority.
     bool enable_priority_dependencies;
+    // Pass large HTTP/2 DATA payloads to streams as slices of the session's
+    // read buffer instead of copying them.
+    bool enable_spdy_data_slices;
 
     // Enables QUIC support.
     bool enable_quic;
@@ -189,6 +193,13 @@ class NET_EXPORT HttpNetworkSession
     ProxyDelegate* proxy_delegate;
     // Enable support for Token Binding.
     bool enable_token_binding;
+
+    // Learn how many connections each origin needs at once, and open them
+    // ahead of demand. See HttpPreconnectPredictor.
+    bool enable_predictive_preconnect;
+    // Optional. Used to open fewer connections ahead of demand on slow
+    // networks.
+    NetworkQualityEstimator* network_quality_estimator;
   };
 
   enum SocketPoolType {
@@ -0,0 +1,189 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_preconnect_predictor.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_server_properties.h"
+#include "net/nqe/network_quality_estimator.h"
+#include "net/socket/client_socket_pool_manager.h"
+#include "url/gurl.h"
+
+namespace net {
+
+const int HttpPreconnectPredictor::kSocketBudget = 32;
+const int HttpPreconnectPredictor::kSocketBudgetWindowSeconds = 10;
+const size_t HttpPreconnectPredictor::kMaxActiveOrigins = 256;
+const int HttpPreconnectPredictor::kBurstIdleTimeoutMs = 2000;
+
+HttpPreconnectPredictor::HttpPreconnectPredictor(
+    const base::WeakPtr<HttpServerProperties>& http_server_properties,
+    NetworkQualityEstimator* network_quality_estimator,
+    const PreconnectCallback& preconnect_callback)
+    : http_server_properties_(http_server_properties),
+      network_quality_estimator_(network_quality_estimator),
+      preconnect_callback_(preconnect_callback),
+      burst_idle_timeout_(
+          base::TimeDelta::FromMilliseconds(kBurstIdleTimeoutMs)),
+      budget_used_(0),
+      weak_factory_(this) {}
+
+HttpPreconnectPredictor::~HttpPreconnectPredictor() {}
+
+bool HttpPreconnectPredictor::OnStreamRequested(
+    const HttpRequestInfo& request_info) {
+  if (!request_info.url.SchemeIsHTTPOrHTTPS())
+    return false;
+
+  url::SchemeHostPort origin(request_info.url);
+  auto it = bursts_.find(origin);
+  if (it != bursts_.end()) {
+    it->second.outstanding++;
+    it->second.peak = std::max(it->second.peak, it->second.outstanding);
+    return true;
+  }
+
+  if (bursts_.size() >= kMaxActiveOrigins)
+    return false;
+  Burst& burst = bursts_[origin];
+  burst.outstanding = 1;
+  burst.peak = 1;
+
+  // The request that starts the burst opens a connection by itself.
+  int num_streams = PredictConnections(origin);
+  UMA_HISTOGRAM_COUNTS_100("Net.HttpPreconnectPredictor.PredictedConnections",
+                           num_streams);
+  if (num_streams <= 1)
+    return true;
+
+  num_streams = 1 + TakeFromSocketBudget(num_streams - 1);
+  if (num_streams <= 1)
+    return true;
+
+  HttpRequestInfo preconnect_info;
+  preconnect_info.url = request_info.url.GetOrigin();
+  preconnect_info.method = "GET";
+  preconnect_info.privacy_mode = request_info.privacy_mode;
+  preconnect_callback_.Run(num_streams, preconnect_info);
+  return true;
+}
+
+void HttpPreconnectPredictor::OnStreamRequestDone(const GURL& url) {
+  // The burst of a counted request lasts at least until the request is done.
+  auto it = bursts_.find(url::SchemeHostPort(url));
+  DCHECK(it != bursts_.end());
+  if (it == bursts_.end())
+    return;
+
+  DCHECK_GT(it->second.outstanding, 0);
+  if (--it->second.outstanding)
+    return;
+
+  it->second.idle_since = base::TimeTicks::Now();
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&HttpPreconnectPredictor::MaybeEndBurst,
+                 weak_factory_.GetWeakPtr(), it->first),
+      burst_idle_timeout_);
+}
+
+int HttpPreconnectPredictor::PredictConnections(
+    const url::SchemeHostPort& origin) const {
+  if (!http_server_properties_)
+    return 0;
+
+  // A single connection carries all the requests.
+  if (http_server_properties_->SupportsRequestPriority(origin))
+    return 1;
+
+  const ServerNetworkStats* stats =
+      http_server_properties_->GetServerNetworkStats(origin);
+  if (!stats)
+    return 0;
+  int connections = stats->connection_concurrency;
+
+  if (network_quality_estimator_) {
+    switch (network_quality_estimator_->GetEffectiveConnectionType()) {
+      case NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_OFFLINE:
+        return 0;
+      case NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_SLOW_2G:
+        connections = std::min(connections, 2);
+        break;
+      case NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_2G:
+        connections = (connections + 1) / 2;
+        break;
+      default:
+        break;
+    }
+  }
+  return connections;
+}
+
+void HttpPreconnectPredictor::MaybeEndBurst(
+    const url::SchemeHostPort& origin) {
+  auto it = bursts_.find(origin);
+  if (it == bursts_.end() || it->second.outstanding ||
+      base::TimeTicks::Now() - it->second.idle_since < burst_idle_timeout_) {
+    return;
+  }
+
+  LearnFromBurst(it->first, it->second);
+  bursts_.erase(it);
+}
+
+void HttpPreconnectPredictor::LearnFromBurst(const url::SchemeHostPort& origin,
+                                             const Burst& burst) {
+  if (!http_server_properties_ ||
+      http_server_properties_->SupportsRequestPriority(origin)) {
+    return;
+  }
+
+  // Requests beyond the per-group limit wait for a socket, opening more
+  // connections would not help them.
+  int peak = std::min(burst.peak,
+                      ClientSocketPoolManager::max_sockets_per_group(
+                          HttpNetworkSession::NORMAL_SOCKET_POOL));
+
+  const ServerNetworkStats* old_stats =
+      http_server_properties_->GetServerNetworkStats(origin);
+  // Don't bother storing that an origin needs a single connection.
+  if (peak <= 1 && (!old_stats || !old_stats->connection_concurrency))
+    return;
+  ServerNetworkStats stats = old_stats ? *old_stats : ServerNetworkStats();
+
+  // Move halfway towards the new peak, so that one unusual burst does not
+  // undo what was learned from many.
+  int old_peak = stats.connection_concurrency;
+  if (old_peak)
+    peak = (old_peak + peak + (peak > old_peak ? 1 : 0)) / 2;
+  if (peak == old_peak)
+    return;
+
+  stats.connection_concurrency = peak;
+  http_server_properties_->SetServerNetworkStats(origin, stats);
+}
+
+int HttpPreconnectPredictor::TakeFromSocketBudget(int num_sockets) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (now - budget_window_start_ >
+      base::TimeDelta::FromSeconds(kSocketBudgetWindowSeconds)) {
+    budget_window_start_ = now;
+    budget_used_ = 0;
+  }
+
+  num_sockets = std::min(num_sockets, kSocketBudget - budget_used_);
+  budget_used_ += num_sockets;
+  return num_sockets;
+}
+
+}  // namespace net
@@ -0,0 +1,125 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_PRECONNECT_PREDICTOR_H_
+#define NET_HTTP_HTTP_PRECONNECT_PREDICTOR_H_
+
+#include <map>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "net/base/net_export.h"
+#include "url/scheme_host_port.h"
+
+class GURL;
+
+namespace net {
+
+class HttpServerProperties;
+class NetworkQualityEstimator;
+struct HttpRequestInfo;
+
+// Learns how many connections each origin needs at the same time, and opens
+// that many connections ahead of demand the next time the origin is used.
+//
+// The requests to an origin are seen as bursts, like the requests of a page
+// load: a burst starts with the first stream request to an origin, and ends
+// once the origin had no outstanding requests for |kBurstIdleTimeoutMs|. The
+// peak number of outstanding requests of each burst is folded into
+// ServerNetworkStats::connection_concurrency, so it is persisted along with the
+// rest of the HttpServerProperties. When a new burst starts, the connections
+// that the origin needed in the past are preconnected, so the requests that
+// follow the first one find them ready.
+//
+// Origins that multiplex requests (HTTP/2 and QUIC) only ever need one
+// connection, so they are not preconnected. The number of connections is
+// reduced on slow networks, where the extra handshakes would compete with the
+// requests for bandwidth, and the number of sockets opened over a short period
+// of time is limited.
+class NET_EXPORT_PRIVATE HttpPreconnectPredictor {
+ public:
+  // Opens |num_streams| connections for |request_info|.
+  typedef base::Callback<void(int num_streams,
+                              const HttpRequestInfo& request_info)>
+      PreconnectCallback;
+
+  // Maximum number of sockets preconnected over |kSocketBudgetWindowSeconds|.
+  static const int kSocketBudget;
+  static const int kSocketBudgetWindowSeconds;
+
+  // Maximum number of origins with a burst in progress that are tracked.
+  static const size_t kMaxActiveOrigins;
+
+  // How long an origin stays without outstanding requests before its burst
+  // ends.
+  static const int kBurstIdleTimeoutMs;
+
+  // |network_quality_estimator| may be null.
+  HttpPreconnectPredictor(
+      const base::WeakPtr<HttpServerProperties>& http_server_properties,
+      NetworkQualityEstimator* network_quality_estimator,
+      const PreconnectCallback& preconnect_callback);
+  ~HttpPreconnectPredictor();
+
+  // Called when a stream is requested for |request_info|. If it starts a burst
+  // of requests to its origin, preconnects what the origin needed before.
+  // Returns whether the request was counted as outstanding, which is not the
+  // case for non-HTTP requests, nor when too many origins have a burst in
+  // progress for a new one to start.
+  bool OnStreamRequested(const HttpRequestInfo& request_info);
+
+  // Called when a stream request for |url| that OnStreamRequested() counted
+  // goes away, whether it got a stream or not. Must not be called for
+  // requests that were not counted, since they could otherwise end the burst
+  // of requests that were.
+  void OnStreamRequestDone(const GURL& url);
+
+  void set_burst_idle_timeout_for_testing(base::TimeDelta timeout) {
+    burst_idle_timeout_ = timeout;
+  }
+
+  // Returns how many connections should be open to |origin| at the start of a
+  // burst, counting the one of the request that starts it.
+  int PredictConnections(const url::SchemeHostPort& origin) const;
+
+ private:
+  struct Burst {
+    Burst() : outstanding(0), peak(0) {}
+
+    int outstanding;
+    int peak;
+    // When |outstanding| last dropped to zero.
+    base::TimeTicks idle_since;
+  };
+
+  // Ends the burst of |origin| if it has been idle long enough.
+  void MaybeEndBurst(const url::SchemeHostPort& origin);
+
+  // Stores what was learned from |burst| for |origin|.
+  void LearnFromBurst(const url::SchemeHostPort& origin, const Burst& burst);
+
+  // Returns how many of |num_sockets| sockets can be opened without exceeding
+  // the socket budget, and charges them to it.
+  int TakeFromSocketBudget(int num_sockets);
+
+  base::WeakPtr<HttpServerProperties> http_server_properties_;
+  NetworkQualityEstimator* network_quality_estimator_;
+  PreconnectCallback preconnect_callback_;
+
+  std::map<url::SchemeHostPort, Burst> bursts_;
+  base::TimeDelta burst_idle_timeout_;
+
+  base::TimeTicks budget_window_start_;
+  int budget_used_;
+
+  base::WeakPtrFactory<HttpPreconnectPredictor> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpPreconnectPredictor);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_PRECONNECT_PREDICTOR_H_
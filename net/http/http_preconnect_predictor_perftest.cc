@@ -0,0 +1,131 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Replays page loads against local HTTPS origins, and measures how long each
+// origin takes to serve its first burst of requests: the page, followed by
+// subresources that are requested as soon as the page arrives. Connections are
+// closed between visits, so every visit starts cold, and only predictive
+// preconnect (HttpPreconnectPredictor) can warm them up.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/location.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "net/base/request_priority.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_preconnect_predictor.h"
+#include "net/http/http_transaction_factory.h"
+#include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+const int kOrigins = 4;
+const int kSubresources = 5;
+const int kVisits = 5;
+
+void WaitForRequest(URLRequest* request) {
+  while (request->is_pending())
+    base::RunLoop().Run();
+  EXPECT_TRUE(request->status().is_success());
+}
+
+// Loads a page from |server|: one request for the page, then |kSubresources|
+// concurrent requests once it arrives. Returns how long it took.
+base::TimeDelta LoadPage(URLRequestContext* context,
+                         const EmbeddedTestServer& server) {
+  base::TimeTicks start = base::TimeTicks::Now();
+
+  TestDelegate page_delegate;
+  std::unique_ptr<URLRequest> page(context->CreateRequest(
+      server.GetURL("/echo"), DEFAULT_PRIORITY, &page_delegate));
+  page->Start();
+  WaitForRequest(page.get());
+
+  std::vector<std::unique_ptr<TestDelegate>> delegates;
+  std::vector<std::unique_ptr<URLRequest>> subresources;
+  for (int i = 0; i < kSubresources; i++) {
+    delegates.push_back(base::WrapUnique(new TestDelegate()));
+    subresources.push_back(context->CreateRequest(
+        server.GetURL(base::StringPrintf("/echo?%d", i)), DEFAULT_PRIORITY,
+        delegates.back().get()));
+    subresources.back()->Start();
+  }
+  for (const auto& request : subresources)
+    WaitForRequest(request.get());
+
+  return base::TimeTicks::Now() - start;
+}
+
+// Lets the bursts of the last visit end, so the next visit starts new ones.
+void WaitForBurstsToEnd() {
+  base::RunLoop run_loop;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(),
+      base::TimeDelta::FromMilliseconds(
+          HttpPreconnectPredictor::kBurstIdleTimeoutMs + 100));
+  run_loop.Run();
+}
+
+void MeasureFirstBurst(
+    const std::vector<std::unique_ptr<EmbeddedTestServer>>& servers,
+    bool enable_predictive_preconnect,
+    const std::string& trace) {
+  TestURLRequestContext context(true);
+  std::unique_ptr<HttpNetworkSession::Params> params(
+      new HttpNetworkSession::Params());
+  params->enable_predictive_preconnect = enable_predictive_preconnect;
+  context.set_http_network_session_params(std::move(params));
+  context.Init();
+
+  // The first visit teaches the predictor about the origins.
+  for (const auto& server : servers)
+    LoadPage(&context, *server);
+
+  base::TimeDelta total;
+  for (int visit = 1; visit < kVisits; visit++) {
+    context.http_transaction_factory()->GetSession()->CloseAllConnections();
+    WaitForBurstsToEnd();
+    for (const auto& server : servers)
+      total += LoadPage(&context, *server);
+  }
+
+  perf_test::PrintResult(
+      "http_preconnect_first_burst", "", trace,
+      total.InMillisecondsF() / ((kVisits - 1) * kOrigins), "ms", true);
+}
+
+TEST(HttpPreconnectPredictorPerfTest, FirstBurstLatency) {
+  base::MessageLoopForIO message_loop;
+
+  std::vector<std::unique_ptr<EmbeddedTestServer>> servers;
+  for (int i = 0; i < kOrigins; i++) {
+    servers.push_back(base::WrapUnique(
+        new EmbeddedTestServer(EmbeddedTestServer::TYPE_HTTPS)));
+    servers.back()->AddDefaultHandlers(base::FilePath());
+    ASSERT_TRUE(servers.back()->Start());
+  }
+
+  MeasureFirstBurst(servers, false, "no_preconnect");
+  MeasureFirstBurst(servers, true, "predictive_preconnect");
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,264 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_preconnect_predictor.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_server_properties_impl.h"
+#include "net/nqe/external_estimate_provider.h"
+#include "net/nqe/network_quality_estimator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+// A NetworkQualityEstimator that reports a fixed effective connection type.
+class FixedNetworkQualityEstimator : public NetworkQualityEstimator {
+ public:
+  explicit FixedNetworkQualityEstimator(EffectiveConnectionType type)
+      : NetworkQualityEstimator(std::unique_ptr<ExternalEstimateProvider>(),
+                                std::map<std::string, std::string>()),
+        type_(type) {}
+
+  EffectiveConnectionType GetEffectiveConnectionType() const override {
+    return type_;
+  }
+
+ private:
+  const EffectiveConnectionType type_;
+};
+
+class HttpPreconnectPredictorTest : public testing::Test {
+ protected:
+  HttpPreconnectPredictorTest()
+      : url_("http://www.example.org/page"), preconnects_(0), streams_(0) {}
+
+  void CreatePredictor(NetworkQualityEstimator* network_quality_estimator) {
+    predictor_.reset(new HttpPreconnectPredictor(
+        http_server_properties_.GetWeakPtr(), network_quality_estimator,
+        base::Bind(&HttpPreconnectPredictorTest::OnPreconnect,
+                   base::Unretained(this))));
+    predictor_->set_burst_idle_timeout_for_testing(base::TimeDelta());
+  }
+
+  // Runs a burst of |concurrency| overlapping requests to |url|, and lets it
+  // end.
+  void RunBurst(const GURL& url, int concurrency) {
+    HttpRequestInfo request_info;
+    request_info.url = url;
+    request_info.method = "GET";
+    int counted = 0;
+    for (int i = 0; i < concurrency; i++) {
+      if (predictor_->OnStreamRequested(request_info))
+        counted++;
+    }
+    for (int i = 0; i < counted; i++)
+      predictor_->OnStreamRequestDone(url);
+    base::RunLoop().RunUntilIdle();
+  }
+
+  int LearnedConcurrency(const GURL& url) {
+    const ServerNetworkStats* stats =
+        http_server_properties_.GetServerNetworkStats(
+            url::SchemeHostPort(url));
+    return stats ? stats->connection_concurrency : 0;
+  }
+
+  void OnPreconnect(int num_streams, const HttpRequestInfo& request_info) {
+    preconnects_++;
+    streams_ += num_streams;
+    preconnect_url_ = request_info.url;
+  }
+
+  const GURL url_;
+  HttpServerPropertiesImpl http_server_properties_;
+  std::unique_ptr<HttpPreconnectPredictor> predictor_;
+
+  int preconnects_;
+  int streams_;
+  GURL preconnect_url_;
+};
+
+TEST_F(HttpPreconnectPredictorTest, LearnsAndPreconnects) {
+  CreatePredictor(nullptr);
+
+  // Nothing is known about the origin yet.
+  RunBurst(url_, 4);
+  EXPECT_EQ(0, preconnects_);
+  EXPECT_EQ(4, LearnedConcurrency(url_));
+
+  // The next burst warms up what the previous one needed.
+  RunBurst(url_, 1);
+  EXPECT_EQ(1, preconnects_);
+  EXPECT_EQ(4, streams_);
+  EXPECT_EQ(GURL("http://www.example.org/"), preconnect_url_);
+}
+
+TEST_F(HttpPreconnectPredictorTest, OnlyFirstRequestOfBurstPreconnects) {
+  CreatePredictor(nullptr);
+  RunBurst(url_, 3);
+
+  RunBurst(url_, 3);
+  EXPECT_EQ(1, preconnects_);
+}
+
+// A burst continues across short gaps without outstanding requests, like the
+// one between a page and its subresources.
+TEST_F(HttpPreconnectPredictorTest, BurstSpansIdleGaps) {
+  CreatePredictor(nullptr);
+  predictor_->set_burst_idle_timeout_for_testing(
+      base::TimeDelta::FromMinutes(1));
+
+  HttpRequestInfo request_info;
+  request_info.url = url_;
+  request_info.method = "GET";
+  EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+  predictor_->OnStreamRequestDone(url_);
+  base::RunLoop().RunUntilIdle();
+  for (int i = 0; i < 3; i++)
+    EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+  for (int i = 0; i < 3; i++)
+    predictor_->OnStreamRequestDone(url_);
+  base::RunLoop().RunUntilIdle();
+
+  // The burst has not ended yet.
+  EXPECT_EQ(0, LearnedConcurrency(url_));
+  EXPECT_EQ(0, preconnects_);
+
+  // Destroying the predictor drops the burst that was in progress.
+  predictor_.reset();
+  EXPECT_EQ(0, LearnedConcurrency(url_));
+}
+
+TEST_F(HttpPreconnectPredictorTest, NonHttpRequestIsNotCounted) {
+  CreatePredictor(nullptr);
+  HttpRequestInfo request_info;
+  request_info.url = GURL("ftp://ftp.example.org/file");
+  request_info.method = "GET";
+  EXPECT_FALSE(predictor_->OnStreamRequested(request_info));
+}
+
+// A request skipped because too many origins had a burst in progress must not
+// end a burst that its origin starts later on.
+TEST_F(HttpPreconnectPredictorTest, SkippedRequestDoesNotAffectLaterBurst) {
+  CreatePredictor(nullptr);
+  HttpRequestInfo request_info;
+  request_info.method = "GET";
+  for (size_t i = 0; i < HttpPreconnectPredictor::kMaxActiveOrigins; i++) {
+    request_info.url = GURL(base::StringPrintf("http://host%d.example.org/",
+                                               static_cast<int>(i)));
+    EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+  }
+
+  // This request is still outstanding when its origin starts a burst.
+  request_info.url = url_;
+  EXPECT_FALSE(predictor_->OnStreamRequested(request_info));
+
+  predictor_->OnStreamRequestDone(GURL("http://host0.example.org/"));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+  EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+
+  // The skipped request goes away, which the predictor is not told about, and
+  // the burst goes on with three requests at once.
+  EXPECT_TRUE(predictor_->OnStreamRequested(request_info));
+  for (int i = 0; i < 3; i++)
+    predictor_->OnStreamRequestDone(url_);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(3, LearnedConcurrency(url_));
+}
+
+TEST_F(HttpPreconnectPredictorTest, SingleConnectionIsNotStored) {
+  CreatePredictor(nullptr);
+  RunBurst(url_, 1);
+  EXPECT_EQ(nullptr, http_server_properties_.GetServerNetworkStats(
+                         url::SchemeHostPort(url_)));
+}
+
+TEST_F(HttpPreconnectPredictorTest, MovesHalfwayTowardsNewPeak) {
+  CreatePredictor(nullptr);
+  RunBurst(url_, 6);
+  EXPECT_EQ(6, LearnedConcurrency(url_));
+
+  RunBurst(url_, 2);
+  EXPECT_EQ(4, LearnedConcurrency(url_));
+  RunBurst(url_, 1);
+  EXPECT_EQ(2, LearnedConcurrency(url_));
+  RunBurst(url_, 1);
+  EXPECT_EQ(1, LearnedConcurrency(url_));
+}
+
+TEST_F(HttpPreconnectPredictorTest, KeepsOtherServerNetworkStats) {
+  ServerNetworkStats stats;
+  stats.srtt = base::TimeDelta::FromMilliseconds(50);
+  http_server_properties_.SetServerNetworkStats(url::SchemeHostPort(url_),
+                                                stats);
+  CreatePredictor(nullptr);
+  RunBurst(url_, 3);
+
+  const ServerNetworkStats* new_stats =
+      http_server_properties_.GetServerNetworkStats(url::SchemeHostPort(url_));
+  ASSERT_TRUE(new_stats);
+  EXPECT_EQ(stats.srtt, new_stats->srtt);
+  EXPECT_EQ(3, new_stats->connection_concurrency);
+}
+
+TEST_F(HttpPreconnectPredictorTest, MultiplexedOriginIsNotPreconnected) {
+  http_server_properties_.SetSupportsSpdy(url::SchemeHostPort(url_), true);
+  CreatePredictor(nullptr);
+  RunBurst(url_, 4);
+  RunBurst(url_, 4);
+  EXPECT_EQ(0, preconnects_);
+  EXPECT_EQ(0, LearnedConcurrency(url_));
+}
+
+TEST_F(HttpPreconnectPredictorTest, SocketBudget) {
+  CreatePredictor(nullptr);
+  const int kOrigins = HttpPreconnectPredictor::kSocketBudget;
+  for (int i = 0; i < kOrigins; i++)
+    RunBurst(GURL(base::StringPrintf("http://host%d.example.org/", i)), 3);
+
+  for (int i = 0; i < kOrigins; i++)
+    RunBurst(GURL(base::StringPrintf("http://host%d.example.org/", i)), 1);
+
+  // Each preconnect opens two sockets beyond the one of the request.
+  EXPECT_EQ(HttpPreconnectPredictor::kSocketBudget / 2, preconnects_);
+  EXPECT_EQ(HttpPreconnectPredictor::kSocketBudget, streams_ - preconnects_);
+}
+
+TEST_F(HttpPreconnectPredictorTest, SizedByNetworkQuality) {
+  FixedNetworkQualityEstimator slow(
+      NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_SLOW_2G);
+  CreatePredictor(&slow);
+  RunBurst(url_, 6);
+  EXPECT_EQ(2, predictor_->PredictConnections(url::SchemeHostPort(url_)));
+
+  FixedNetworkQualityEstimator two_g(
+      NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_2G);
+  CreatePredictor(&two_g);
+  EXPECT_EQ(3, predictor_->PredictConnections(url::SchemeHostPort(url_)));
+
+  FixedNetworkQualityEstimator offline(
+      NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_OFFLINE);
+  CreatePredictor(&offline);
+  EXPECT_EQ(0, predictor_->PredictConnections(url::SchemeHostPort(url_)));
+
+  FixedNetworkQualityEstimator broadband(
+      NetworkQualityEstimator::EFFECTIVE_CONNECTION_TYPE_BROADBAND);
+  CreatePredictor(&broadband);
+  EXPECT_EQ(6, predictor_->PredictConnections(url::SchemeHostPort(url_)));
+}
+
+}  // namespace
+
+}  // namespace net
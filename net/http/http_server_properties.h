@@ -188,10 +188,13 @@ struct NET_EXPORT SupportsQuic {
 };
 
 struct NET_EXPORT ServerNetworkStats {
-  ServerNetworkStats() : bandwidth_estimate(QuicBandwidth::Zero()) {}
+  ServerNetworkStats()
+      : bandwidth_estimate(QuicBandwidth::Zero()), connection_concurrency(0) {}
 
   bool operator==(const ServerNetworkStats& other) const {
-    return srtt == other.srtt && bandwidth_estimate == other.bandwidth_estimate;
+    return srtt == other.srtt &&
+           bandwidth_estimate == other.bandwidth_estimate &&
+           connection_concurrency == other.connection_concurrency;
   }
 
   bool operator!=(const ServerNetworkStats& other) const {
@@ -200,6 +203,9 @@ struct NET_EXPORT ServerNetworkStats {
 
   base::TimeDelta srtt;
   QuicBandwidth bandwidth_estimate;
+  // How many connections to the server were needed at the same time, learned
+  // by HttpPreconnectPredictor. Zero if unknown.
+  int connection_concurrency;
 };
 
 typedef std::vector<AlternativeService> AlternativeServiceVector;
@@ -65,6 +65,7 @@ const char kPortKey[] = "port";
 const char kExpirationKey[] = "expiration";
 const char kNetworkStatsKey[] = "network_stats";
 const char kSrttKey[] = "srtt";
+const char kConnectionConcurrencyKey[] = "connection_concurrency";
 
 }  // namespace
 
@@ -787,6 +788,13 @@ bool HttpServerPropertiesManager::AddToNetworkStatsMap(
   }
   ServerNetworkStats server_network_stats;
   server_network_stats.srtt = base::TimeDelta::FromInternalValue(srtt);
+  // Older prefs don't have the concurrency, it is learned again.
+  int connection_concurrency;
+  if (server_network_stats_dict->GetIntegerWithoutPathExpansion(
+          kConnectionConcurrencyKey, &connection_concurrency) &&
+      connection_concurrency > 0) {
+    server_network_stats.connection_concurrency = connection_concurrency;
+  }
   // TODO(rtenneti): When QUIC starts using bandwidth_estimate, then persist
   // bandwidth_estimate.
   network_stats_map->Put(server, server_network_stats);
@@ -1239,6 +1247,11 @@ void HttpServerPropertiesManager::SaveNetworkStatsToServerPrefs(
       kSrttKey, static_cast<int>(server_network_stats->srtt.ToInternalValue()));
   // TODO(rtenneti): When QUIC starts using bandwidth_estimate, then persist
   // bandwidth_estimate.
+  if (server_network_stats->connection_concurrency) {
+    server_network_stats_dict->SetInteger(
+        kConnectionConcurrencyKey,
+        server_network_stats->connection_concurrency);
+  }
   server_pref_dict->SetWithoutPathExpansion(kNetworkStatsKey,
                                             server_network_stats_dict);
 }
@@ -291,6 +291,7 @@ TEST_P(HttpServerPropertiesManagerTest,
   // server.
   base::DictionaryValue* stats1 = new base::DictionaryValue;
   stats1->SetInteger("srtt", 20);
+  stats1->SetInteger("connection_concurrency", 4);
   server_pref_dict1->SetWithoutPathExpansion("network_stats", stats1);
   // Set the server preference for http://mail.google.com:80.
   servers_dict->SetWithoutPathExpansion(
@@ -423,6 +424,8 @@ TEST_P(HttpServerPropertiesManagerTest,
   const ServerNetworkStats* stats3 =
       http_server_props_manager_->GetServerNetworkStats(mail_server);
   EXPECT_EQ(20, stats3->srtt.ToInternalValue());
+  EXPECT_EQ(4, stats3->connection_concurrency);
+  EXPECT_EQ(0, stats2->connection_concurrency);
 
   // Verify QuicServerInfo.
   EXPECT_EQ(quic_server_info1, *http_server_props_manager_->GetQuicServerInfo(
@@ -1108,6 +1111,7 @@ TEST_P(HttpServerPropertiesManagerTest, UpdateCacheWithPrefs) {
   // Set ServerNetworkStats.
   ServerNetworkStats stats;
   stats.srtt = base::TimeDelta::FromInternalValue(42);
+  stats.connection_concurrency = 4;
   http_server_props_manager_->SetServerNetworkStats(server_mail, stats);
 
   // Set quic_server_info string.
@@ -1139,7 +1143,7 @@ TEST_P(HttpServerPropertiesManagerTest, UpdateCacheWithPrefs) {
       "{\"http://mail.google.com\":{\"alternative_service\":[{"
       "\"expiration\":\"9223372036854775807\",\"host\":\"foo.google.com\","
       "\"port\":444,\"protocol_str\":\"npn-spdy/3.1\"}],"
-      "\"network_stats\":{\"srtt\":42}}}"
+      "\"network_stats\":{\"connection_concurrency\":4,\"srtt\":42}}}"
       "],"
       "\"supports_quic\":{\"address\":\"127.0.0.1\",\"used_quic\":true},"
       "\"version\":5}";
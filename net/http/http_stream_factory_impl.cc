@@ -6,10 +6,12 @@
 
 #include <string>
 
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "net/http/http_network_session.h"
+#include "net/http/http_preconnect_predictor.h"
 #include "net/http/http_server_properties.h"
 #include "net/http/http_stream_factory_impl_job.h"
 #include "net/http/http_stream_factory_impl_request.h"
@@ -25,6 +27,7 @@ namespace net {
 HttpStreamFactoryImpl::HttpStreamFactoryImpl(HttpNetworkSession* session,
                                              bool for_websockets)
     : session_(session),
+      preconnect_predictor_initialized_(false),
       for_websockets_(for_websockets) {}
 
 HttpStreamFactoryImpl::~HttpStreamFactoryImpl() {
@@ -137,6 +140,14 @@ HttpStreamRequest* HttpStreamFactoryImpl::RequestStreamInternal(
   // the request yet, since we defer that to the next iteration of the
   // MessageLoop, so starting |job| is always safe.
   job->Start(request);
+
+  // Preconnect after |job| started, so that its socket counts towards the
+  // predicted connections.
+  HttpPreconnectPredictor* preconnect_predictor = GetPreconnectPredictor();
+  if (preconnect_predictor &&
+      preconnect_predictor->OnStreamRequested(request_info)) {
+    request->set_counted_by_preconnect_predictor();
+  }
   return request;
 }
 
@@ -176,6 +187,20 @@ void HttpStreamFactoryImpl::PreconnectStreams(
   job->Preconnect(num_streams);
 }
 
+HttpPreconnectPredictor* HttpStreamFactoryImpl::GetPreconnectPredictor() {
+  if (!preconnect_predictor_initialized_) {
+    preconnect_predictor_initialized_ = true;
+    if (!for_websockets_ && session_->params().enable_predictive_preconnect) {
+      preconnect_predictor_.reset(new HttpPreconnectPredictor(
+          session_->http_server_properties(),
+          session_->params().network_quality_estimator,
+          base::Bind(&HttpStreamFactoryImpl::PreconnectStreams,
+                     base::Unretained(this))));
+    }
+  }
+  return preconnect_predictor_.get();
+}
+
 const HostMappingRules* HttpStreamFactoryImpl::GetHostMappingRules() const {
   return session_->params().host_mapping_rules;
 }
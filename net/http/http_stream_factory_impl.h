@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -24,6 +25,7 @@
 namespace net {
 
 class HttpNetworkSession;
+class HttpPreconnectPredictor;
 class SpdySession;
 
 class NET_EXPORT_PRIVATE HttpStreamFactoryImpl : public HttpStreamFactory {
@@ -121,6 +123,10 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl : public HttpStreamFactory {
   // Returns true if QUIC is whitelisted for |host|.
   bool IsQuicWhitelistedForHost(const std::string& host);
 
+  // Returns the predictor of preconnects, or nullptr if predictive preconnect
+  // is disabled.
+  HttpPreconnectPredictor* GetPreconnectPredictor();
+
   HttpNetworkSession* const session_;
 
   // All Requests are handed out to clients. By the time HttpStreamFactoryImpl
@@ -142,6 +148,11 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl : public HttpStreamFactory {
   // deleted when the factory is destroyed.
   std::set<const Job*> preconnect_job_set_;
 
+  // Created on first use, as the session parameters are not available yet
+  // when the factory is constructed.
+  std::unique_ptr<HttpPreconnectPredictor> preconnect_predictor_;
+  bool preconnect_predictor_initialized_;
+
   const bool for_websockets_;
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactoryImpl);
 };
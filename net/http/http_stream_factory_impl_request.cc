@@ -8,6 +8,7 @@
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "net/http/bidirectional_stream_impl.h"
+#include "net/http/http_preconnect_predictor.h"
 #include "net/http/http_stream_factory_impl_job.h"
 #include "net/spdy/spdy_http_stream.h"
 #include "net/spdy/spdy_session.h"
@@ -32,6 +33,7 @@ HttpStreamFactoryImpl::Request::Request(
       was_npn_negotiated_(false),
       protocol_negotiated_(kProtoUnknown),
       using_spdy_(false),
+      counted_by_preconnect_predictor_(false),
       stream_type_(stream_type) {
   DCHECK(factory_);
   DCHECK(delegate_);
@@ -46,6 +48,9 @@ HttpStreamFactoryImpl::Request::~Request() {
   net_log_.EndEvent(NetLog::TYPE_HTTP_STREAM_REQUEST);
 
   CancelJobs();
+
+  if (counted_by_preconnect_predictor_ && factory_->preconnect_predictor_)
+    factory_->preconnect_predictor_->OnStreamRequestDone(url_);
 }
 
 void HttpStreamFactoryImpl::Request::SetSpdySessionKey(
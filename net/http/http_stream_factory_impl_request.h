@@ -41,6 +41,12 @@ class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
 
   const BoundNetLog& net_log() const { return net_log_; }
 
+  // Called when the preconnect predictor counted this request as outstanding,
+  // so that it is told when the request goes away.
+  void set_counted_by_preconnect_predictor() {
+    counted_by_preconnect_predictor_ = true;
+  }
+
   // Called when the Job determines the appropriate |spdy_session_key| for the
   // Request. Note that this does not mean that SPDY is necessarily supported
   // for this SpdySessionKey, since we may need to wait for NPN to complete
@@ -162,6 +168,7 @@ class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
   NextProto protocol_negotiated_;
   bool using_spdy_;
   ConnectionAttempts connection_attempts_;
+  bool counted_by_preconnect_predictor_;
 
   const HttpStreamRequest::StreamType stream_type_;
   DISALLOW_COPY_AND_ASSIGN(Request);
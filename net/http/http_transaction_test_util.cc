@@ -468,6 +468,15 @@ int MockNetworkTransaction::StartInternal(const HttpRequestInfo* request,
   if (test_mode_ & TEST_MODE_SYNC_NET_START)
     return OK;
 
+  base::TimeDelta start_delay = transaction_factory_->start_delay();
+  if (!start_delay.is_zero()) {
+    base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE, base::Bind(&MockNetworkTransaction::RunCallback,
+                              weak_factory_.GetWeakPtr(), callback, OK),
+        start_delay);
+    return ERR_IO_PENDING;
+  }
+
   CallbackLater(callback, OK);
   return ERR_IO_PENDING;
 }
@@ -15,6 +15,7 @@
 #include "base/compiler_specific.h"
 #include "base/memory/weak_ptr.h"
 #include "base/strings/string16.h"
+#include "base/time/time.h"
 #include "net/base/io_buffer.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_error_details.h"
@@ -316,6 +317,11 @@ class MockNetworkLayer : public HttpTransactionFactory,
   HttpCache* GetCache() override;
   HttpNetworkSession* GetSession() override;
 
+  // Delays the completion of the asynchronous Start() of transactions by
+  // |delay|, as the round trip to a server would.
+  void set_start_delay(base::TimeDelta delay) { start_delay_ = delay; }
+  base::TimeDelta start_delay() const { return start_delay_; }
+
   // The caller must guarantee that |clock| will outlive this object.
   void SetClock(base::Clock* clock);
   base::Clock* clock() const { return clock_; }
@@ -333,6 +339,8 @@ class MockNetworkLayer : public HttpTransactionFactory,
   // frameworks using SetClock.
   base::Clock* clock_;
 
+  base::TimeDelta start_delay_;
+
   base::WeakPtr<MockNetworkTransaction> last_transaction_;
 };
 
@@ -381,16 +381,16 @@ int MockDiskCache::OpenEntry(const std::string& key,
                              const CompletionCallback& callback) {
   DCHECK(!callback.is_null());
   if (fail_requests_)
-    return ERR_CACHE_OPEN_FAILURE;
+    return OpenResult(callback, ERR_CACHE_OPEN_FAILURE);
 
   EntryMap::iterator it = entries_.find(key);
   if (it == entries_.end())
-    return ERR_CACHE_OPEN_FAILURE;
+    return OpenResult(callback, ERR_CACHE_OPEN_FAILURE);
 
   if (it->second->is_doomed()) {
     it->second->Release();
     entries_.erase(it);
-    return ERR_CACHE_OPEN_FAILURE;
+    return OpenResult(callback, ERR_CACHE_OPEN_FAILURE);
   }
 
   open_count_++;
@@ -401,8 +401,10 @@ int MockDiskCache::OpenEntry(const std::string& key,
   if (soft_failures_)
     it->second->set_fail_requests();
 
-  if (GetTestModeForEntry(key) & TEST_MODE_SYNC_CACHE_START)
-    return OK;
+  if (GetTestModeForEntry(key) & TEST_MODE_SYNC_CACHE_START ||
+      !open_delay_.is_zero()) {
+    return OpenResult(callback, OK);
+  }
 
   CallbackLater(callback, OK);
   return ERR_IO_PENDING;
@@ -517,6 +519,15 @@ void MockDiskCache::CallbackLater(const CompletionCallback& callback,
       FROM_HERE, base::Bind(&CallbackForwader, callback, result));
 }
 
+int MockDiskCache::OpenResult(const CompletionCallback& callback, int result) {
+  if (open_delay_.is_zero())
+    return result;
+
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, base::Bind(&CallbackForwader, callback, result), open_delay_);
+  return ERR_IO_PENDING;
+}
+
 //-----------------------------------------------------------------------------
 
 int MockBackendFactory::CreateBackend(
@@ -15,6 +15,7 @@
 #include <unordered_map>
 
 #include "base/strings/string_split.h"
+#include "base/time/time.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_cache.h"
 #include "net/http/http_transaction_test_util.h"
@@ -153,6 +154,10 @@ class MockDiskCache : public disk_cache::Backend {
   // Makes all requests for data ranges to fail as not implemented.
   void set_fail_sparse_requests() { fail_sparse_requests_ = true; }
 
+  // Delays the completion of OpenEntry by |delay|, including the report of a
+  // missing entry, as a slow disk would.
+  void set_open_delay(base::TimeDelta delay) { open_delay_ = delay; }
+
   void ReleaseAll();
 
  private:
@@ -161,6 +166,10 @@ class MockDiskCache : public disk_cache::Backend {
 
   void CallbackLater(const CompletionCallback& callback, int result);
 
+  // Returns the |result| of an OpenEntry call, or delivers it to |callback|
+  // after |open_delay_|.
+  int OpenResult(const CompletionCallback& callback, int result);
+
   EntryMap entries_;
   int open_count_;
   int create_count_;
@@ -168,6 +177,7 @@ class MockDiskCache : public disk_cache::Backend {
   bool soft_failures_;
   bool double_create_check_;
   bool fail_sparse_requests_;
+  base::TimeDelta open_delay_;
 };
 
 class MockBackendFactory : public HttpCache::BackendFactory {
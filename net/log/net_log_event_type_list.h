@@ -903,6 +903,14 @@ EVENT_TYPE(HTTP_CACHE_CREATE_ENTRY)
 // entry's list of active Transactions.
 EVENT_TYPE(HTTP_CACHE_ADD_TO_ENTRY)
 
+// This event is logged when a HttpCache::Transaction is added to an http cache
+// entry's list of active Transactions. The following parameters are attached:
+//   {
+//     "reads_while_writing": <True if the Transaction reads the response body
+//                             while another Transaction writes it>,
+//   }
+EVENT_TYPE(HTTP_CACHE_ADDED_TO_ENTRY)
+
 // Measures the time while deleting a disk cache entry.
 EVENT_TYPE(HTTP_CACHE_DOOM_ENTRY)
 
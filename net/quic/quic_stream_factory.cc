@@ -1756,11 +1756,15 @@ void QuicStreamFactory::ProcessGoingAwaySession(
                                                server_id.host_port_pair());
   if (session->IsCryptoHandshakeConfirmed()) {
     http_server_properties_->ConfirmAlternativeService(alternative_service);
-    ServerNetworkStats network_stats;
-    network_stats.srtt = base::TimeDelta::FromMicroseconds(stats.srtt_us);
-    network_stats.bandwidth_estimate = stats.estimated_bandwidth;
     url::SchemeHostPort server("https", server_id.host_port_pair().host(),
                                server_id.host_port_pair().port());
+    // Keep what was learned about the server over other protocols.
+    const ServerNetworkStats* old_stats =
+        http_server_properties_->GetServerNetworkStats(server);
+    ServerNetworkStats network_stats =
+        old_stats ? *old_stats : ServerNetworkStats();
+    network_stats.srtt = base::TimeDelta::FromMicroseconds(stats.srtt_us);
+    network_stats.bandwidth_estimate = stats.estimated_bandwidth;
     http_server_properties_->SetServerNetworkStats(server, network_stats);
     return;
   }
@@ -0,0 +1,452 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/sdch/sdch_dictionary_store.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "net/base/completion_callback.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/sdch_manager.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/http/http_cache.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+// The streams of a dictionary's cache entry.
+const int kUrlStream = 0;
+const int kTextStream = 1;
+
+}  // namespace
+
+// A load, store or removal of a single dictionary. Owned by the store, and
+// destroyed once complete or when the store is destroyed.
+//
+// As in DiskCacheBasedQuicServerInfo, the out parameters of the disk_cache
+// APIs live in a shim owned by |io_callback_|, so that they stay valid if the
+// operation is destroyed while a call is pending.
+class SdchDictionaryStore::Operation {
+ public:
+  enum Type {
+    LOAD,
+    STORE,
+    REMOVE,
+  };
+
+  Operation(Type type, HttpCache* http_cache, const std::string& server_hash);
+  ~Operation();
+
+  void set_load_callback(const LoadCallback& callback) {
+    load_callback_ = callback;
+  }
+  void set_dictionary(const GURL& dictionary_url,
+                      const std::string& dictionary_text) {
+    dictionary_url_ = dictionary_url;
+    dictionary_text_ = dictionary_text;
+  }
+
+  Type type() const { return type_; }
+  const LoadCallback& load_callback() const { return load_callback_; }
+  const GURL& dictionary_url() const { return dictionary_url_; }
+  const std::string& dictionary_text() const { return dictionary_text_; }
+
+  // Starts the operation. Returns its result if it completes synchronously,
+  // or ERR_IO_PENDING, in which case |callback| is run with the result.
+  int Start(const CompletionCallback& callback);
+
+ private:
+  struct CacheOperationDataShim {
+    CacheOperationDataShim() : backend(nullptr), entry(nullptr) {}
+
+    disk_cache::Backend* backend;
+    disk_cache::Entry* entry;
+  };
+
+  enum State {
+    STATE_GET_BACKEND,
+    STATE_GET_BACKEND_COMPLETE,
+    STATE_OPEN_ENTRY,
+    STATE_OPEN_ENTRY_COMPLETE,
+    STATE_READ_DATA,
+    STATE_READ_DATA_COMPLETE,
+    STATE_CREATE_ENTRY,
+    STATE_CREATE_ENTRY_COMPLETE,
+    STATE_WRITE_DATA,
+    STATE_WRITE_DATA_COMPLETE,
+    STATE_DOOM_ENTRY,
+    STATE_DOOM_ENTRY_COMPLETE,
+    STATE_NONE,
+  };
+
+  void OnIOComplete(CacheOperationDataShim* unused, int rv);
+
+  int DoLoop(int rv);
+  int DoGetBackend();
+  int DoGetBackendComplete(int rv);
+  int DoOpenEntry();
+  int DoOpenEntryComplete(int rv);
+  int DoReadData();
+  int DoReadDataComplete(int rv);
+  int DoCreateEntry();
+  int DoCreateEntryComplete(int rv);
+  int DoWriteData();
+  int DoWriteDataComplete(int rv);
+  int DoDoomEntry();
+  int DoDoomEntryComplete(int rv);
+
+  const Type type_;
+  HttpCache* const http_cache_;
+  const std::string server_hash_;
+
+  State next_state_;
+  CacheOperationDataShim* data_shim_;  // Owned by |io_callback_|.
+  CompletionCallback io_callback_;
+  CompletionCallback callback_;
+  disk_cache::Backend* backend_;
+  disk_cache::Entry* entry_;
+
+  // The stream being read or written.
+  int stream_;
+  scoped_refptr<IOBuffer> buffer_;
+  int buffer_size_;
+
+  LoadCallback load_callback_;
+  GURL dictionary_url_;
+  std::string dictionary_text_;
+  base::TimeTicks start_time_;
+
+  base::WeakPtrFactory<Operation> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(Operation);
+};
+
+SdchDictionaryStore::Operation::Operation(Type type,
+                                          HttpCache* http_cache,
+                                          const std::string& server_hash)
+    : type_(type),
+      http_cache_(http_cache),
+      server_hash_(server_hash),
+      next_state_(STATE_NONE),
+      data_shim_(new CacheOperationDataShim()),
+      backend_(nullptr),
+      entry_(nullptr),
+      stream_(kUrlStream),
+      buffer_size_(0),
+      weak_factory_(this) {
+  io_callback_ = base::Bind(&Operation::OnIOComplete,
+                            weak_factory_.GetWeakPtr(),
+                            base::Owned(data_shim_));  // Ownership assigned.
+}
+
+SdchDictionaryStore::Operation::~Operation() {
+  if (entry_)
+    entry_->Close();
+}
+
+int SdchDictionaryStore::Operation::Start(const CompletionCallback& callback) {
+  DCHECK_EQ(STATE_NONE, next_state_);
+  start_time_ = base::TimeTicks::Now();
+  next_state_ = STATE_GET_BACKEND;
+  int rv = DoLoop(OK);
+  if (rv == ERR_IO_PENDING)
+    callback_ = callback;
+  return rv;
+}
+
+void SdchDictionaryStore::Operation::OnIOComplete(
+    CacheOperationDataShim* unused,
+    int rv) {
+  rv = DoLoop(rv);
+  if (rv != ERR_IO_PENDING)
+    callback_.Run(rv);  // May delete |this|.
+}
+
+int SdchDictionaryStore::Operation::DoLoop(int rv) {
+  DCHECK_NE(STATE_NONE, next_state_);
+  do {
+    State state = next_state_;
+    next_state_ = STATE_NONE;
+    switch (state) {
+      case STATE_GET_BACKEND:
+        DCHECK_EQ(OK, rv);
+        rv = DoGetBackend();
+        break;
+      case STATE_GET_BACKEND_COMPLETE:
+        rv = DoGetBackendComplete(rv);
+        break;
+      case STATE_OPEN_ENTRY:
+        DCHECK_EQ(OK, rv);
+        rv = DoOpenEntry();
+        break;
+      case STATE_OPEN_ENTRY_COMPLETE:
+        rv = DoOpenEntryComplete(rv);
+        break;
+      case STATE_READ_DATA:
+        DCHECK_EQ(OK, rv);
+        rv = DoReadData();
+        break;
+      case STATE_READ_DATA_COMPLETE:
+        rv = DoReadDataComplete(rv);
+        break;
+      case STATE_CREATE_ENTRY:
+        DCHECK_EQ(OK, rv);
+        rv = DoCreateEntry();
+        break;
+      case STATE_CREATE_ENTRY_COMPLETE:
+        rv = DoCreateEntryComplete(rv);
+        break;
+      case STATE_WRITE_DATA:
+        DCHECK_EQ(OK, rv);
+        rv = DoWriteData();
+        break;
+      case STATE_WRITE_DATA_COMPLETE:
+        rv = DoWriteDataComplete(rv);
+        break;
+      case STATE_DOOM_ENTRY:
+        DCHECK_EQ(OK, rv);
+        rv = DoDoomEntry();
+        break;
+      case STATE_DOOM_ENTRY_COMPLETE:
+        rv = DoDoomEntryComplete(rv);
+        break;
+      case STATE_NONE:
+        NOTREACHED();
+        rv = ERR_FAILED;
+        break;
+    }
+  } while (rv != ERR_IO_PENDING && next_state_ != STATE_NONE);
+  return rv;
+}
+
+int SdchDictionaryStore::Operation::DoGetBackend() {
+  next_state_ = STATE_GET_BACKEND_COMPLETE;
+  return http_cache_->GetBackend(&data_shim_->backend, io_callback_);
+}
+
+int SdchDictionaryStore::Operation::DoGetBackendComplete(int rv) {
+  if (rv != OK)
+    return rv;
+  backend_ = data_shim_->backend;
+  switch (type_) {
+    case LOAD:
+      next_state_ = STATE_OPEN_ENTRY;
+      break;
+    case STORE:
+      next_state_ = STATE_CREATE_ENTRY;
+      break;
+    case REMOVE:
+      next_state_ = STATE_DOOM_ENTRY;
+      break;
+  }
+  return OK;
+}
+
+int SdchDictionaryStore::Operation::DoOpenEntry() {
+  next_state_ = STATE_OPEN_ENTRY_COMPLETE;
+  return backend_->OpenEntry(GetKey(server_hash_), &data_shim_->entry,
+                             io_callback_);
+}
+
+int SdchDictionaryStore::Operation::DoOpenEntryComplete(int rv) {
+  if (rv != OK)
+    return ERR_CACHE_MISS;
+  entry_ = data_shim_->entry;
+  stream_ = kUrlStream;
+  next_state_ = STATE_READ_DATA;
+  return OK;
+}
+
+int SdchDictionaryStore::Operation::DoReadData() {
+  buffer_size_ = entry_->GetDataSize(stream_);
+  if (buffer_size_ <= 0)
+    return ERR_CACHE_READ_FAILURE;
+  buffer_ = new IOBuffer(buffer_size_);
+  next_state_ = STATE_READ_DATA_COMPLETE;
+  return entry_->ReadData(stream_, 0, buffer_.get(), buffer_size_,
+                          io_callback_);
+}
+
+int SdchDictionaryStore::Operation::DoReadDataComplete(int rv) {
+  if (rv != buffer_size_)
+    return ERR_CACHE_READ_FAILURE;
+
+  if (stream_ == kUrlStream) {
+    dictionary_url_ = GURL(std::string(buffer_->data(), buffer_size_));
+    buffer_ = nullptr;
+    if (!dictionary_url_.is_valid())
+      return ERR_CACHE_READ_FAILURE;
+    stream_ = kTextStream;
+    next_state_ = STATE_READ_DATA;
+    return OK;
+  }
+
+  dictionary_text_.assign(buffer_->data(), buffer_size_);
+  buffer_ = nullptr;
+
+  // The dictionary must match its address, e.g. in case its entry was only
+  // partially written.
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary_text_, &client_hash, &server_hash);
+  if (server_hash != server_hash_) {
+    dictionary_text_.clear();
+    entry_->Doom();
+    return ERR_CACHE_READ_FAILURE;
+  }
+
+  UMA_HISTOGRAM_TIMES("Sdch3.DictionaryStoreLoadTime",
+                      base::TimeTicks::Now() - start_time_);
+  return OK;
+}
+
+int SdchDictionaryStore::Operation::DoCreateEntry() {
+  next_state_ = STATE_CREATE_ENTRY_COMPLETE;
+  return backend_->CreateEntry(GetKey(server_hash_), &data_shim_->entry,
+                               io_callback_);
+}
+
+int SdchDictionaryStore::Operation::DoCreateEntryComplete(int rv) {
+  // Creation fails if an entry with the same key exists. Since entries are
+  // addressed by the hash of their contents, there's nothing left to do.
+  if (rv != OK)
+    return OK;
+  entry_ = data_shim_->entry;
+  stream_ = kTextStream;
+  next_state_ = STATE_WRITE_DATA;
+  return OK;
+}
+
+int SdchDictionaryStore::Operation::DoWriteData() {
+  // The text is written first, so that an entry with a URL is complete.
+  const std::string& data =
+      stream_ == kUrlStream ? dictionary_url_.spec() : dictionary_text_;
+  buffer_size_ = data.size();
+  buffer_ = new IOBuffer(buffer_size_);
+  memcpy(buffer_->data(), data.data(), buffer_size_);
+  next_state_ = STATE_WRITE_DATA_COMPLETE;
+  return entry_->WriteData(stream_, 0, buffer_.get(), buffer_size_,
+                           io_callback_, true /* truncate */);
+}
+
+int SdchDictionaryStore::Operation::DoWriteDataComplete(int rv) {
+  buffer_ = nullptr;
+  if (rv != buffer_size_) {
+    entry_->Doom();
+    return ERR_CACHE_WRITE_FAILURE;
+  }
+  if (stream_ == kTextStream) {
+    stream_ = kUrlStream;
+    next_state_ = STATE_WRITE_DATA;
+  }
+  return OK;
+}
+
+int SdchDictionaryStore::Operation::DoDoomEntry() {
+  next_state_ = STATE_DOOM_ENTRY_COMPLETE;
+  return backend_->DoomEntry(GetKey(server_hash_), io_callback_);
+}
+
+int SdchDictionaryStore::Operation::DoDoomEntryComplete(int rv) {
+  // There may have been no such entry.
+  return OK;
+}
+
+SdchDictionaryStore::SdchDictionaryStore(HttpCache* http_cache)
+    : http_cache_(http_cache), next_operation_id_(0), weak_factory_(this) {
+  DCHECK(http_cache_);
+}
+
+SdchDictionaryStore::~SdchDictionaryStore() {
+  DCHECK(CalledOnValidThread());
+}
+
+void SdchDictionaryStore::Load(const std::string& server_hash,
+                               const LoadCallback& callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(!callback.is_null());
+  std::unique_ptr<Operation> operation(
+      new Operation(Operation::LOAD, http_cache_, server_hash));
+  operation->set_load_callback(callback);
+  StartOperation(std::move(operation));
+}
+
+void SdchDictionaryStore::Store(const std::string& server_hash,
+                                const GURL& dictionary_url,
+                                const std::string& dictionary_text) {
+  DCHECK(CalledOnValidThread());
+  std::unique_ptr<Operation> operation(
+      new Operation(Operation::STORE, http_cache_, server_hash));
+  operation->set_dictionary(dictionary_url, dictionary_text);
+  StartOperation(std::move(operation));
+}
+
+void SdchDictionaryStore::Remove(const std::string& server_hash) {
+  DCHECK(CalledOnValidThread());
+  StartOperation(base::WrapUnique(
+      new Operation(Operation::REMOVE, http_cache_, server_hash)));
+}
+
+void SdchDictionaryStore::CancelLoads() {
+  DCHECK(CalledOnValidThread());
+  for (auto it = operations_.begin(); it != operations_.end();) {
+    if (it->second->type() == Operation::LOAD)
+      it = operations_.erase(it);
+    else
+      ++it;
+  }
+}
+
+// static
+std::string SdchDictionaryStore::GetKey(const std::string& server_hash) {
+  return "sdchdictionary:" + server_hash;
+}
+
+void SdchDictionaryStore::StartOperation(
+    std::unique_ptr<Operation> operation) {
+  int operation_id = next_operation_id_++;
+  Operation* raw_operation = operation.get();
+  operations_[operation_id] = std::move(operation);
+  // |this| owns the operation, which doesn't run its callback once destroyed.
+  int rv = raw_operation->Start(
+      base::Bind(&SdchDictionaryStore::OnOperationComplete,
+                 base::Unretained(this), operation_id));
+  if (rv != ERR_IO_PENDING) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::Bind(&SdchDictionaryStore::OnOperationComplete,
+                              weak_factory_.GetWeakPtr(), operation_id, rv));
+  }
+}
+
+void SdchDictionaryStore::OnOperationComplete(int operation_id, int rv) {
+  DCHECK(CalledOnValidThread());
+  auto it = operations_.find(operation_id);
+  // The operation may have been cancelled after completing synchronously.
+  if (it == operations_.end())
+    return;
+  std::unique_ptr<Operation> completed_operation = std::move(it->second);
+  operations_.erase(it);
+
+  // Running the callback may delete |this|.
+  if (!completed_operation->load_callback().is_null()) {
+    completed_operation->load_callback().Run(
+        rv, completed_operation->dictionary_text(),
+        completed_operation->dictionary_url());
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,88 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SDCH_SDCH_DICTIONARY_STORE_H_
+#define NET_SDCH_SDCH_DICTIONARY_STORE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/threading/non_thread_safe.h"
+#include "net/base/net_export.h"
+
+class GURL;
+
+namespace net {
+
+class HttpCache;
+
+// SdchDictionaryStore keeps SDCH dictionaries in the HTTP cache's backend,
+// addressed by their server hash rather than by the URL they were fetched
+// from. This allows SdchOwner to bring back the dictionaries of a previous
+// session directly from disk, in parallel, without issuing a URLRequest for
+// each of them through the HTTP cache. Entries are subject to the eviction
+// policy of the cache like any other entry.
+class NET_EXPORT SdchDictionaryStore
+    : public NON_EXPORTED_BASE(base::NonThreadSafe) {
+ public:
+  // Run with OK, the text of the dictionary and the URL it was fetched from,
+  // or with an error code: ERR_CACHE_MISS if the store has no dictionary
+  // with the requested hash, or another cache error if it couldn't be read.
+  typedef base::Callback<void(int rv,
+                              const std::string& dictionary_text,
+                              const GURL& dictionary_url)>
+      LoadCallback;
+
+  // |http_cache| must outlive this object.
+  explicit SdchDictionaryStore(HttpCache* http_cache);
+
+  // Abandons all pending operations. No LoadCallback is run afterwards.
+  ~SdchDictionaryStore();
+
+  // Reads the dictionary whose server hash is |server_hash|, and runs
+  // |callback| with it. |callback| is never run synchronously.
+  void Load(const std::string& server_hash, const LoadCallback& callback);
+
+  // Writes |dictionary_text|, fetched from |dictionary_url|, to the store.
+  // |server_hash| must be that of |dictionary_text|, as computed by
+  // SdchManager::GenerateHash(). Does nothing if the store already has a
+  // dictionary with that hash, since its text is the same.
+  void Store(const std::string& server_hash,
+             const GURL& dictionary_url,
+             const std::string& dictionary_text);
+
+  // Removes the dictionary whose server hash is |server_hash|, if any.
+  void Remove(const std::string& server_hash);
+
+  // Abandons all pending loads. Their callbacks are not run.
+  void CancelLoads();
+
+  // Returns the key of the cache entry holding the dictionary whose server
+  // hash is |server_hash|.
+  static std::string GetKey(const std::string& server_hash);
+
+ private:
+  class Operation;
+
+  void StartOperation(std::unique_ptr<Operation> operation);
+  void OnOperationComplete(int operation_id, int rv);
+
+  HttpCache* const http_cache_;
+
+  // Pending operations, keyed by an ID unique to this store.
+  std::map<int, std::unique_ptr<Operation>> operations_;
+  int next_operation_id_;
+
+  base::WeakPtrFactory<SdchDictionaryStore> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SdchDictionaryStore);
+};
+
+}  // namespace net
+
+#endif  // NET_SDCH_SDCH_DICTIONARY_STORE_H_
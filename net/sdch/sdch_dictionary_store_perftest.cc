@@ -0,0 +1,199 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures the time it takes, after startup, to decode the first byte of an
+// SDCH response whose dictionary was persisted by a previous session, when
+// the dictionary is read from a SdchDictionaryStore. The store is "cold" when
+// its disk cache is opened for the response, as after a restart, and "warm"
+// when the backend of the cache is already open.
+
+#include <stddef.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "net/base/cache_type.h"
+#include "net/base/net_errors.h"
+#include "net/base/sdch_manager.h"
+#include "net/filter/filter.h"
+#include "net/filter/mock_filter_context.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction_test_util.h"
+#include "net/sdch/sdch_dictionary_store.h"
+#include "net/url_request/url_request_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 20;
+const size_t kDictionarySize = 1024 * 1024;
+
+const char kDictionaryUrl[] = "http://www.example.com/dict";
+const char kResponseUrl[] = "http://www.example.com/page";
+
+// The VCDIFF dictionary and response of SdchFilterTest.
+const char kTestVcdiffDictionary[] =
+    "DictionaryFor"
+    "SdchCompression1SdchCompression2SdchCompression3SdchCompression\n";
+const char kSdchCompressedTestData[] =
+    "\326\303\304\0\0\001M\0\201S\202\004\0\201E\006\001"
+    "00000000000000000000000000000000000000000000000000000000000000000000000000"
+    "TestData 00000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000\n\001S\023\077\001r\r";
+
+// Returns a |kDictionarySize| byte dictionary for www.example.com, whose
+// VCDIFF part starts with kTestVcdiffDictionary.
+std::string NewSdchDictionary() {
+  std::string dictionary = "Domain: www.example.com\n\n";
+  dictionary.append(kTestVcdiffDictionary, sizeof(kTestVcdiffDictionary) - 1);
+  size_t original_size = dictionary.size();
+  dictionary.resize(kDictionarySize);
+  for (size_t i = original_size; i < kDictionarySize; ++i)
+    dictionary[i] = static_cast<char>((i % 127) + 1);
+  return dictionary;
+}
+
+std::unique_ptr<HttpCache> NewHttpCache(const base::FilePath& path,
+                                        base::Thread* cache_thread) {
+  return base::WrapUnique(new HttpCache(
+      base::WrapUnique(new MockNetworkLayer()),
+      base::WrapUnique(new HttpCache::DefaultBackend(
+          DISK_CACHE, CACHE_BACKEND_DEFAULT, path, 0,
+          cache_thread->task_runner())),
+      false));
+}
+
+void OnLoadComplete(const base::Closure& quit_closure,
+                    int* result,
+                    std::string* dictionary_text,
+                    int rv,
+                    const std::string& loaded_dictionary_text,
+                    const GURL& dictionary_url) {
+  *result = rv;
+  *dictionary_text = loaded_dictionary_text;
+  quit_closure.Run();
+}
+
+// Loads the dictionary with hash |server_hash| from |http_cache|.
+int LoadDictionary(HttpCache* http_cache,
+                   const std::string& server_hash,
+                   std::string* dictionary_text) {
+  SdchDictionaryStore store(http_cache);
+  base::RunLoop run_loop;
+  int result = ERR_IO_PENDING;
+  store.Load(server_hash, base::Bind(&OnLoadComplete, run_loop.QuitClosure(),
+                                     &result, dictionary_text));
+  run_loop.Run();
+  return result;
+}
+
+// Loads the dictionary with hash |server_hash| from |http_cache| and decodes
+// the first byte of |response| with it.
+void LoadAndDecode(HttpCache* http_cache,
+                   const std::string& server_hash,
+                   const std::string& response) {
+  std::string dictionary_text;
+  ASSERT_EQ(OK, LoadDictionary(http_cache, server_hash, &dictionary_text));
+
+  SdchManager sdch_manager;
+  ASSERT_EQ(SDCH_OK, sdch_manager.AddSdchDictionary(
+                         dictionary_text, GURL(kDictionaryUrl), nullptr));
+  MockFilterContext filter_context;
+  filter_context.GetModifiableURLRequestContext()->set_sdch_manager(
+      &sdch_manager);
+  filter_context.SetURL(GURL(kResponseUrl));
+  filter_context.SetSdchResponse(
+      sdch_manager.GetDictionarySet(GURL(kResponseUrl)));
+  std::vector<Filter::FilterType> filter_types(1, Filter::FILTER_TYPE_SDCH);
+  std::unique_ptr<Filter> filter(
+      Filter::Factory(filter_types, filter_context));
+  ASSERT_TRUE(filter);
+
+  ASSERT_LE(response.size(),
+            static_cast<size_t>(filter->stream_buffer_size()));
+  memcpy(filter->stream_buffer()->data(), response.data(), response.size());
+  filter->FlushStreamBuffer(response.size());
+  char output[1];
+  int output_size = sizeof(output);
+  ASSERT_NE(Filter::FILTER_ERROR, filter->ReadData(output, &output_size));
+  ASSERT_EQ(1, output_size);
+}
+
+TEST(SdchDictionaryStorePerfTest, TimeToFirstByte) {
+  base::MessageLoopForIO message_loop;
+  base::Thread cache_thread("cache");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+      base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+  base::ScopedTempDir cache_dir;
+  ASSERT_TRUE(cache_dir.CreateUniqueTempDir());
+
+  const std::string dictionary = NewSdchDictionary();
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+  std::string response = server_hash;
+  response.append("\0", 1);
+  response.append(kSdchCompressedTestData,
+                  sizeof(kSdchCompressedTestData) - 1);
+
+  // Persist the dictionary, as a previous session would have.
+  {
+    std::unique_ptr<HttpCache> http_cache =
+        NewHttpCache(cache_dir.path(), &cache_thread);
+    SdchDictionaryStore store(http_cache.get());
+    store.Store(server_hash, GURL(kDictionaryUrl), dictionary);
+    std::string dictionary_text;
+    ASSERT_EQ(OK,
+              LoadDictionary(http_cache.get(), server_hash, &dictionary_text));
+    ASSERT_EQ(dictionary, dictionary_text);
+  }
+  base::RunLoop().RunUntilIdle();
+
+  base::TimeDelta cold;
+  for (int i = 0; i < kIterations; ++i) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    {
+      std::unique_ptr<HttpCache> http_cache =
+          NewHttpCache(cache_dir.path(), &cache_thread);
+      LoadAndDecode(http_cache.get(), server_hash, response);
+      cold += base::TimeTicks::Now() - start;
+    }
+    base::RunLoop().RunUntilIdle();
+  }
+
+  base::TimeDelta warm;
+  {
+    std::unique_ptr<HttpCache> http_cache =
+        NewHttpCache(cache_dir.path(), &cache_thread);
+    LoadAndDecode(http_cache.get(), server_hash, response);
+    for (int i = 0; i < kIterations; ++i) {
+      base::TimeTicks start = base::TimeTicks::Now();
+      LoadAndDecode(http_cache.get(), server_hash, response);
+      warm += base::TimeTicks::Now() - start;
+    }
+  }
+  base::RunLoop().RunUntilIdle();
+
+  perf_test::PrintResult("sdch_time_to_first_byte", "", "cold_store",
+                         cold.InMillisecondsF() / kIterations, "ms", true);
+  perf_test::PrintResult("sdch_time_to_first_byte", "", "warm_store",
+                         warm.InMillisecondsF() / kIterations, "ms", true);
+}
+
+}  // namespace
+
+}  // namespace net
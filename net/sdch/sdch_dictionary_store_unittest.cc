@@ -0,0 +1,174 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/sdch/sdch_dictionary_store.h"
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/run_loop.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/sdch_manager.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+const char kDictionaryUrl[] = "http://www.example.com/dict";
+
+std::string NewSdchDictionary(const std::string& nonce) {
+  return "Domain: www.example.com\n\nDictionary text " + nonce;
+}
+
+std::string ServerHash(const std::string& dictionary_text) {
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+  return server_hash;
+}
+
+class SdchDictionaryStoreTest : public testing::Test {
+ protected:
+  SdchDictionaryStoreTest()
+      : http_cache_(base::WrapUnique(new MockNetworkLayer()),
+                    HttpCache::DefaultBackend::InMemory(0),
+                    false),
+        store_(new SdchDictionaryStore(&http_cache_)),
+        load_result_(ERR_IO_PENDING) {}
+
+  // Loads the dictionary with hash |server_hash| from |store_|. Returns the
+  // result, and the dictionary in |load_text_| and |load_url_|.
+  int Load(const std::string& server_hash) {
+    load_result_ = ERR_IO_PENDING;
+    store_->Load(server_hash, load_callback());
+    EXPECT_EQ(ERR_IO_PENDING, load_result_);
+    base::RunLoop().RunUntilIdle();
+    return load_result_;
+  }
+
+  SdchDictionaryStore::LoadCallback load_callback() {
+    return base::Bind(&SdchDictionaryStoreTest::OnLoadComplete,
+                      base::Unretained(this));
+  }
+
+  void OnLoadComplete(int rv,
+                      const std::string& dictionary_text,
+                      const GURL& dictionary_url) {
+    load_result_ = rv;
+    load_text_ = dictionary_text;
+    load_url_ = dictionary_url;
+  }
+
+  // Writes |data| to stream |index| of the entry with key |key|.
+  void WriteEntry(const std::string& key, int index, const std::string& data) {
+    TestCompletionCallback callback;
+    disk_cache::Backend* backend = nullptr;
+    ASSERT_EQ(OK, callback.GetResult(
+                      http_cache_.GetBackend(&backend, callback.callback())));
+    disk_cache::Entry* entry = nullptr;
+    int rv = backend->OpenEntry(key, &entry, callback.callback());
+    if (callback.GetResult(rv) != OK)
+      rv = backend->CreateEntry(key, &entry, callback.callback());
+    ASSERT_EQ(OK, callback.GetResult(rv));
+    scoped_refptr<IOBuffer> buffer(new IOBuffer(data.size()));
+    memcpy(buffer->data(), data.data(), data.size());
+    rv = entry->WriteData(index, 0, buffer.get(), data.size(),
+                          callback.callback(), true);
+    EXPECT_EQ(static_cast<int>(data.size()), callback.GetResult(rv));
+    entry->Close();
+  }
+
+  HttpCache http_cache_;
+  std::unique_ptr<SdchDictionaryStore> store_;
+
+  int load_result_;
+  std::string load_text_;
+  GURL load_url_;
+};
+
+TEST_F(SdchDictionaryStoreTest, StoreAndLoad) {
+  const std::string dictionary = NewSdchDictionary("0");
+  const std::string server_hash = ServerHash(dictionary);
+  store_->Store(server_hash, GURL(kDictionaryUrl), dictionary);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(OK, Load(server_hash));
+  EXPECT_EQ(dictionary, load_text_);
+  EXPECT_EQ(GURL(kDictionaryUrl), load_url_);
+}
+
+TEST_F(SdchDictionaryStoreTest, LoadMissing) {
+  EXPECT_EQ(ERR_CACHE_MISS, Load(ServerHash(NewSdchDictionary("0"))));
+  EXPECT_TRUE(load_text_.empty());
+}
+
+TEST_F(SdchDictionaryStoreTest, Remove) {
+  const std::string dictionary = NewSdchDictionary("0");
+  const std::string server_hash = ServerHash(dictionary);
+  store_->Store(server_hash, GURL(kDictionaryUrl), dictionary);
+  store_->Remove(server_hash);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(ERR_CACHE_MISS, Load(server_hash));
+}
+
+// A dictionary that is already stored is not overwritten, since its text is
+// the same.
+TEST_F(SdchDictionaryStoreTest, StoreExisting) {
+  const std::string dictionary = NewSdchDictionary("0");
+  const std::string server_hash = ServerHash(dictionary);
+  store_->Store(server_hash, GURL(kDictionaryUrl), dictionary);
+  base::RunLoop().RunUntilIdle();
+  store_->Store(server_hash, GURL("http://www.example.com/other"), dictionary);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(OK, Load(server_hash));
+  EXPECT_EQ(GURL(kDictionaryUrl), load_url_);
+}
+
+// An entry whose text doesn't match its hash is not returned, and removed.
+TEST_F(SdchDictionaryStoreTest, LoadCorrupt) {
+  const std::string server_hash = ServerHash(NewSdchDictionary("0"));
+  WriteEntry(SdchDictionaryStore::GetKey(server_hash), 0, kDictionaryUrl);
+  WriteEntry(SdchDictionaryStore::GetKey(server_hash), 1,
+             NewSdchDictionary("1"));
+
+  EXPECT_EQ(ERR_CACHE_READ_FAILURE, Load(server_hash));
+  EXPECT_TRUE(load_text_.empty());
+  EXPECT_EQ(ERR_CACHE_MISS, Load(server_hash));
+}
+
+TEST_F(SdchDictionaryStoreTest, CancelLoads) {
+  const std::string dictionary = NewSdchDictionary("0");
+  const std::string server_hash = ServerHash(dictionary);
+  store_->Store(server_hash, GURL(kDictionaryUrl), dictionary);
+  base::RunLoop().RunUntilIdle();
+
+  store_->Load(server_hash, load_callback());
+  store_->CancelLoads();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(ERR_IO_PENDING, load_result_);
+}
+
+TEST_F(SdchDictionaryStoreTest, DestroyWithPendingLoad) {
+  store_->Load(ServerHash(NewSdchDictionary("0")), load_callback());
+  store_.reset();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(ERR_IO_PENDING, load_result_);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -15,8 +15,10 @@
 #include "base/strings/string_util.h"
 #include "base/time/default_clock.h"
 #include "base/values.h"
+#include "net/base/net_errors.h"
 #include "net/base/sdch_manager.h"
 #include "net/base/sdch_net_log_params.h"
+#include "net/sdch/sdch_dictionary_store.h"
 
 namespace net {
 
@@ -293,6 +295,7 @@ void SdchOwner::RecordDictionaryEvictionOrUnload(const std::string& server_hash,
 SdchOwner::SdchOwner(SdchManager* sdch_manager, URLRequestContext* context)
     : manager_(sdch_manager),
       fetcher_(new SdchDictionaryFetcher(context)),
+      adding_dictionary_from_store_(false),
       total_dictionary_bytes_(0),
       clock_(new base::DefaultClock),
       max_total_dictionary_size_(kMaxTotalDictionarySize),
@@ -350,6 +353,14 @@ void SdchOwner::EnablePersistentStorage(
     OnPrefStorageInitializationComplete(true);
 }
 
+void SdchOwner::EnableDictionaryStore(
+    std::unique_ptr<SdchDictionaryStore> dictionary_store) {
+  DCHECK(!dictionary_store_);
+  DCHECK(!external_pref_store_);
+  DCHECK(dictionary_store);
+  dictionary_store_ = std::move(dictionary_store);
+}
+
 void SdchOwner::SetMaxTotalDictionarySize(size_t max_total_dictionary_size) {
   max_total_dictionary_size_ = max_total_dictionary_size;
 }
@@ -451,6 +462,8 @@ void SdchOwner::OnDictionaryFetched(base::Time last_used,
   while (avail_bytes < dictionary_text.size() &&
          stale_it != stale_dictionary_list.end()) {
     manager_->RemoveSdchDictionary(stale_it->server_hash);
+    if (dictionary_store_)
+      dictionary_store_->Remove(stale_it->server_hash);
 
     DCHECK(pref_dictionary_map->HasKey(stale_it->server_hash));
     bool success = pref_dictionary_map->RemoveWithoutPathExpansion(
@@ -497,6 +510,9 @@ void SdchOwner::OnDictionaryFetched(base::Time last_used,
                                      dictionary_text.size());
   pref_dictionary_map->Set(server_hash, std::move(dictionary_description));
   load_times_[server_hash] = clock_->Now();
+
+  if (dictionary_store_ && !adding_dictionary_from_store_)
+    dictionary_store_->Store(server_hash, dictionary_url, dictionary_text);
 }
 
 void SdchOwner::OnDictionaryAdded(const GURL& dictionary_url,
@@ -594,6 +610,8 @@ void SdchOwner::OnGetDictionary(const GURL& request_url,
 void SdchOwner::OnClearDictionaries() {
   total_dictionary_bytes_ = 0;
   fetcher_->Cancel();
+  if (dictionary_store_)
+    dictionary_store_->CancelLoads();
 
   InitializePrefStore(pref_store_);
 }
@@ -729,6 +747,18 @@ bool SdchOwner::SchedulePersistedDictionaryLoads(
     if (!dict_info->GetDouble(kDictionaryCreatedTimeKey, &created_time))
       continue;
 
+    if (dictionary_store_) {
+      dictionary_store_->Load(
+          dict_it.key(),
+          base::Bind(&SdchOwner::OnDictionaryLoadedFromStore,
+                     // SdchOwner will outlive its member variables.
+                     base::Unretained(this), dict_it.key(),
+                     base::Time::FromDoubleT(last_used),
+                     base::Time::FromDoubleT(created_time), use_count,
+                     dict_url));
+      continue;
+    }
+
     fetcher_->ScheduleReload(
         dict_url,
         base::Bind(&SdchOwner::OnDictionaryFetched,
@@ -740,6 +770,36 @@ bool SdchOwner::SchedulePersistedDictionaryLoads(
   return true;
 }
 
+void SdchOwner::OnDictionaryLoadedFromStore(
+    const std::string& server_hash,
+    base::Time last_used,
+    base::Time created_time,
+    int use_count,
+    const GURL& dictionary_url,
+    int rv,
+    const std::string& dictionary_text,
+    const GURL& stored_dictionary_url) {
+  UMA_HISTOGRAM_BOOLEAN("Sdch3.DictionaryStoreHit", rv == OK);
+  if (rv != OK || stored_dictionary_url != dictionary_url) {
+    // Doom an entry that couldn't be read or doesn't match, since storing the
+    // reloaded dictionary does nothing while an entry for it exists.
+    if (rv != ERR_CACHE_MISS)
+      dictionary_store_->Remove(server_hash);
+    fetcher_->ScheduleReload(
+        dictionary_url,
+        base::Bind(&SdchOwner::OnDictionaryFetched,
+                   // SdchOwner will outlive its member variables.
+                   base::Unretained(this), last_used, created_time,
+                   use_count));
+    return;
+  }
+
+  adding_dictionary_from_store_ = true;
+  OnDictionaryFetched(last_used, created_time, use_count, dictionary_text,
+                      dictionary_url, BoundNetLog(), true);
+  adding_dictionary_from_store_ = false;
+}
+
 bool SdchOwner::IsPersistingDictionaries() const {
   return in_memory_pref_store_.get() != nullptr;
 }
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "base/macros.h"
@@ -24,6 +25,7 @@ class Clock;
 }
 
 namespace net {
+class SdchDictionaryStore;
 class SdchManager;
 class URLRequestContext;
 
@@ -100,6 +102,13 @@ class NET_EXPORT SdchOwner : public SdchObserver {
   // This routine may only be called once per SdchOwner instance.
   void EnablePersistentStorage(std::unique_ptr<PrefStorage> pref_store);
 
+  // Enables keeping dictionaries in |dictionary_store|, from which persisted
+  // dictionaries are loaded before falling back to fetching them from the
+  // HTTP cache. Must be called before EnablePersistentStorage(), and at most
+  // once.
+  void EnableDictionaryStore(
+      std::unique_ptr<SdchDictionaryStore> dictionary_store);
+
   // Defaults to kMaxTotalDictionarySize.
   void SetMaxTotalDictionarySize(size_t max_total_dictionary_size);
 
@@ -168,6 +177,20 @@ class NET_EXPORT SdchOwner : public SdchObserver {
 
   bool IsPersistingDictionaries() const;
 
+  // Called when the dictionary with server hash |server_hash|, persisted with
+  // the given |last_used|, |created_time|, |use_count| and |dictionary_url|,
+  // has been read from |dictionary_store_|. Adds it, or schedules a reload
+  // from the HTTP cache if it couldn't be read, in which case its entry is
+  // removed from |dictionary_store_| unless there was none.
+  void OnDictionaryLoadedFromStore(const std::string& server_hash,
+                                   base::Time last_used,
+                                   base::Time created_time,
+                                   int use_count,
+                                   const GURL& dictionary_url,
+                                   int rv,
+                                   const std::string& dictionary_text,
+                                   const GURL& stored_dictionary_url);
+
   enum DictionaryFate {
     // A Get-Dictionary header wasn't acted on.
     DICTIONARY_FATE_GET_IGNORED = 1,
@@ -217,6 +240,13 @@ class NET_EXPORT SdchOwner : public SdchObserver {
   net::SdchManager* manager_;
   std::unique_ptr<net::SdchDictionaryFetcher> fetcher_;
 
+  // Null unless EnableDictionaryStore() was called.
+  std::unique_ptr<SdchDictionaryStore> dictionary_store_;
+
+  // Set while adding a dictionary read from |dictionary_store_|, which
+  // needn't be written back to it.
+  bool adding_dictionary_from_store_;
+
   size_t total_dictionary_bytes_;
 
   std::unique_ptr<base::Clock> clock_;
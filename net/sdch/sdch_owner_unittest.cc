@@ -18,7 +18,12 @@
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/values.h"
 #include "net/base/sdch_manager.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction_test_util.h"
 #include "net/log/net_log.h"
+#include "net/sdch/sdch_dictionary_store.h"
 #include "net/url_request/url_request.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_error_job.h"
@@ -794,7 +799,7 @@ TEST_F(SdchOwnerTest, UsageIntervalMetrics) {
 
 class SdchOwnerPersistenceTest : public ::testing::Test {
  public:
-  SdchOwnerPersistenceTest() {}
+  SdchOwnerPersistenceTest() : dictionary_store_cache_(nullptr) {}
   virtual ~SdchOwnerPersistenceTest() {}
 
   void ClearOwner() {
@@ -815,6 +820,10 @@ class SdchOwnerPersistenceTest : public ::testing::Test {
     owner_->SetMinSpaceForDictionaryFetch(
         SdchOwnerTest::kMinFetchSpaceForTesting);
     owner_->SetFetcherForTesting(base::WrapUnique(fetcher_));
+    if (dictionary_store_cache_) {
+      owner_->EnableDictionaryStore(
+          base::WrapUnique(new SdchDictionaryStore(dictionary_store_cache_)));
+    }
     if (storage)
       owner_->EnablePersistentStorage(std::move(storage));
   }
@@ -847,6 +856,9 @@ class SdchOwnerPersistenceTest : public ::testing::Test {
   MockSdchDictionaryFetcher* fetcher_;
   std::unique_ptr<SdchOwner> owner_;
   TestURLRequestContext url_request_context_;
+  // If non-null, owners created by ResetOwner() keep their dictionaries in a
+  // SdchDictionaryStore on this cache.
+  HttpCache* dictionary_store_cache_;
 };
 
 // Test an empty persistence store.
@@ -1019,4 +1031,99 @@ TEST_F(SdchOwnerPersistenceTest, PersistenceMetrics) {
                             CreateDictionary(url1, "1").size(), 1);
 }
 
+// Dictionaries are loaded from the dictionary store, rather than fetched,
+// when it has them.
+TEST_F(SdchOwnerPersistenceTest, LoadFromDictionaryStore) {
+  const GURL url0("http://www.example.com/dict0");
+  const GURL url1("http://www.example.com/dict1");
+  HttpCache http_cache(base::WrapUnique(new MockNetworkLayer()),
+                       HttpCache::DefaultBackend::InMemory(0), false);
+  dictionary_store_cache_ = &http_cache;
+
+  std::unique_ptr<TestPrefStorage> storage(new TestPrefStorage(true));
+  TestPrefStorage* old_storage = storage.get();  // Save storage pointer.
+  ResetOwner(std::move(storage));  // Takes ownership of storage pointer.
+  InsertDictionaryForURL(url0, "0");
+  InsertDictionaryForURL(url1, "1");
+  base::RunLoop().RunUntilIdle();
+
+  // Drop the second dictionary from the store.
+  std::string hash1;
+  ASSERT_TRUE(GetDictionaryForURL(old_storage, url1, &hash1, nullptr));
+  {
+    SdchDictionaryStore dictionary_store(&http_cache);
+    dictionary_store.Remove(hash1);
+    base::RunLoop().RunUntilIdle();
+  }
+
+  storage.reset(new TestPrefStorage(*old_storage));
+  ResetOwner(std::move(storage));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, owner_->GetDictionaryCountForTesting());
+  EXPECT_TRUE(owner_->HasDictionaryFromURLForTesting(url0));
+  EXPECT_FALSE(fetcher_->HasPendingRequest(url0));
+
+  // The dictionary missing from the store is reloaded from the HTTP cache.
+  EXPECT_TRUE(CompleteLoadFromURL(url1, "1", true));
+  EXPECT_EQ(2, owner_->GetDictionaryCountForTesting());
+
+  ClearOwner();
+  dictionary_store_cache_ = nullptr;
+}
+
+// A dictionary that can't be read from the dictionary store is removed from
+// it, so that the dictionary reloaded from the HTTP cache is stored again.
+TEST_F(SdchOwnerPersistenceTest, UnreadableDictionaryIsRemovedFromStore) {
+  const GURL url("http://www.example.com/dict");
+  HttpCache http_cache(base::WrapUnique(new MockNetworkLayer()),
+                       HttpCache::DefaultBackend::InMemory(0), false);
+  dictionary_store_cache_ = &http_cache;
+
+  std::unique_ptr<TestPrefStorage> storage(new TestPrefStorage(true));
+  TestPrefStorage* old_storage = storage.get();  // Save storage pointer.
+  ResetOwner(std::move(storage));  // Takes ownership of storage pointer.
+  InsertDictionaryForURL(url, "0");
+  base::RunLoop().RunUntilIdle();
+
+  // Truncate every stream of the dictionary's entry.
+  std::string hash;
+  ASSERT_TRUE(GetDictionaryForURL(old_storage, url, &hash, nullptr));
+  const std::string key = SdchDictionaryStore::GetKey(hash);
+  disk_cache::Backend* backend = nullptr;
+  TestCompletionCallback callback;
+  ASSERT_EQ(OK, callback.GetResult(
+                    http_cache.GetBackend(&backend, callback.callback())));
+  disk_cache::Entry* entry = nullptr;
+  ASSERT_EQ(OK, callback.GetResult(
+                    backend->OpenEntry(key, &entry, callback.callback())));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(0, callback.GetResult(entry->WriteData(
+                     i, 0, nullptr, 0, callback.callback(), true)));
+  }
+  entry->Close();
+
+  storage.reset(new TestPrefStorage(*old_storage));
+  old_storage = storage.get();
+  ResetOwner(std::move(storage));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0, owner_->GetDictionaryCountForTesting());
+  EXPECT_NE(OK, callback.GetResult(
+                    backend->OpenEntry(key, &entry, callback.callback())));
+
+  // The dictionary is reloaded from the HTTP cache and stored again, so the
+  // next owner loads it from the store.
+  EXPECT_TRUE(CompleteLoadFromURL(url, "0", true));
+  EXPECT_EQ(1, owner_->GetDictionaryCountForTesting());
+  base::RunLoop().RunUntilIdle();
+
+  storage.reset(new TestPrefStorage(*old_storage));
+  ResetOwner(std::move(storage));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(owner_->HasDictionaryFromURLForTesting(url));
+  EXPECT_FALSE(fetcher_->HasPendingRequest(url));
+
+  ClearOwner();
+  dictionary_store_cache_ = nullptr;
+}
+
 }  // namespace net
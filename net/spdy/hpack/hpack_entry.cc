@@ -24,6 +24,14 @@ HpackEntry::HpackEntry(StringPiece name,
       insertion_index_(insertion_index),
       type_(is_static ? STATIC : DYNAMIC) {}
 
+HpackEntry::HpackEntry(StringPiece name,
+                       StringPiece value,
+                       size_t insertion_index)
+    : name_ref_(name),
+      value_ref_(value),
+      insertion_index_(insertion_index),
+      type_(DYNAMIC_REFERENCE) {}
+
 HpackEntry::HpackEntry(StringPiece name, StringPiece value)
     : name_ref_(name), value_ref_(value), insertion_index_(0), type_(LOOKUP) {}
 
@@ -31,7 +39,7 @@ HpackEntry::HpackEntry() : insertion_index_(0), type_(LOOKUP) {}
 
 HpackEntry::HpackEntry(const HpackEntry& other)
     : insertion_index_(other.insertion_index_), type_(other.type_) {
-  if (type_ == LOOKUP) {
+  if (!OwnsStrings()) {
     name_ref_ = other.name_ref_;
     value_ref_ = other.value_ref_;
   } else {
@@ -45,7 +53,7 @@ HpackEntry::HpackEntry(const HpackEntry& other)
 HpackEntry& HpackEntry::operator=(const HpackEntry& other) {
   insertion_index_ = other.insertion_index_;
   type_ = other.type_;
-  if (type_ == LOOKUP) {
+  if (!OwnsStrings()) {
     name_ref_ = other.name_ref_;
     value_ref_ = other.value_ref_;
     return *this;
@@ -40,6 +40,13 @@ class NET_EXPORT_PRIVATE HpackEntry {
              bool is_static,
              size_t insertion_index);
 
+  // Creates a dynamic entry which refers to, rather than copies, |name| and
+  // |value|, as HpackHeaderTable does to keep them in its arena. The memory
+  // backing them must outlive this object and its copies.
+  HpackEntry(base::StringPiece name,
+             base::StringPiece value,
+             size_t insertion_index);
+
   // Create a 'lookup' entry (only) suitable for querying a HpackEntrySet. The
   // instance InsertionIndex() always returns 0 and IsLookup() returns true.
   // The memory backing |name| and |value| must outlive this object.
@@ -77,10 +84,15 @@ class NET_EXPORT_PRIVATE HpackEntry {
   enum EntryType {
     LOOKUP,
     DYNAMIC,
+    DYNAMIC_REFERENCE,
     STATIC,
   };
 
-  // These members are not used for LOOKUP entries.
+  // Returns whether |name_ref_| and |value_ref_| point to |name_| and
+  // |value_|.
+  bool OwnsStrings() const { return type_ == DYNAMIC || type_ == STATIC; }
+
+  // These members are only used for DYNAMIC and STATIC entries.
   std::string name_;
   std::string value_;
 
@@ -74,6 +74,22 @@ TEST_F(HpackEntryTest, DynamicConstructor) {
   EXPECT_EQ(Size(), entry.Size());
 }
 
+TEST_F(HpackEntryTest, DynamicReferenceConstructor) {
+  HpackEntry entry(name_, value_, 0);
+  HpackEntry copy(entry);
+
+  EXPECT_EQ(name_.data(), entry.name().data());
+  EXPECT_EQ(value_.data(), entry.value().data());
+  EXPECT_FALSE(entry.IsStatic());
+  EXPECT_FALSE(entry.IsLookup());
+  EXPECT_EQ(Size(), entry.Size());
+
+  // Copies refer to the same memory.
+  EXPECT_EQ(name_.data(), copy.name().data());
+  EXPECT_EQ(value_.data(), copy.value().data());
+  EXPECT_EQ(0u, copy.InsertionIndex());
+}
+
 TEST_F(HpackEntryTest, LookupConstructor) {
   HpackEntry entry(name_, value_);
 
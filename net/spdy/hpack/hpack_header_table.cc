@@ -4,7 +4,10 @@
 
 #include "net/spdy/hpack/hpack_header_table.h"
 
+#include <string.h>
+
 #include <algorithm>
+#include <vector>
 
 #include "base/logging.h"
 #include "net/spdy/hpack/hpack_constants.h"
@@ -35,6 +38,10 @@ HpackHeaderTable::HpackHeaderTable()
     : static_entries_(ObtainHpackStaticTable().GetStaticEntries()),
       static_index_(ObtainHpackStaticTable().GetStaticIndex()),
       static_name_index_(ObtainHpackStaticTable().GetStaticNameIndex()),
+      arena_capacity_(0),
+      arena_head_(0),
+      arena_tail_(0),
+      arena_entries_(0),
       settings_size_bound_(kDefaultHeaderTableSizeSetting),
       size_(0),
       max_size_(kDefaultHeaderTableSizeSetting),
@@ -170,10 +177,96 @@ void HpackHeaderTable::Evict(size_t count) {
     if (name_it->second->InsertionIndex() == entry->InsertionIndex()) {
       dynamic_name_index_.erase(name_it);
     }
+    if (IsInArena(*entry)) {
+      // Entries are evicted in the order they were written to the arena.
+      arena_tail_ = (entry->name().data() - arena_.get()) +
+                    entry->name().size() + entry->value().size();
+      --arena_entries_;
+    }
     dynamic_entries_.pop_back();
   }
 }
 
+bool HpackHeaderTable::IsInArena(const HpackEntry& entry) const {
+  const char* data = entry.name().data();
+  return arena_ && data >= arena_.get() &&
+         data < arena_.get() + arena_capacity_;
+}
+
+char* HpackHeaderTable::AllocateInArena(
+    size_t size,
+    std::unique_ptr<char[]>* previous_arena) {
+  DCHECK_GT(size, 0u);
+  if (arena_entries_ == 0) {
+    arena_head_ = 0;
+    arena_tail_ = 0;
+  }
+  size_t offset;
+  if (arena_entries_ == 0 || arena_head_ > arena_tail_) {
+    // The free space is [head, capacity) and [0, tail).
+    if (arena_capacity_ - arena_head_ >= size) {
+      offset = arena_head_;
+    } else if (arena_tail_ >= size) {
+      offset = 0;
+    } else {
+      ReallocateArena(std::max(2 * max_size_, arena_head_ + size),
+                      previous_arena);
+      offset = arena_head_;
+    }
+  } else {
+    // The entries wrapped around, the free space is [head, tail).
+    if (arena_tail_ - arena_head_ >= size) {
+      offset = arena_head_;
+    } else {
+      ReallocateArena(
+          std::max(2 * max_size_,
+                   arena_capacity_ - arena_tail_ + arena_head_ + size),
+          previous_arena);
+      offset = arena_head_;
+    }
+  }
+  arena_head_ = offset + size;
+  ++arena_entries_;
+  return arena_.get() + offset;
+}
+
+void HpackHeaderTable::ReallocateArena(
+    size_t capacity,
+    std::unique_ptr<char[]>* previous_arena) {
+  std::unique_ptr<char[]> arena(new char[capacity]);
+  size_t offset = 0;
+  for (EntryTable::reverse_iterator it = dynamic_entries_.rbegin();
+       it != dynamic_entries_.rend(); ++it) {
+    if (!IsInArena(*it)) {
+      continue;
+    }
+    char* name = arena.get() + offset;
+    memcpy(name, it->name().data(), it->name().size());
+    char* value = name + it->name().size();
+    memcpy(value, it->value().data(), it->value().size());
+    offset += it->name().size() + it->value().size();
+    // The entry keeps its address, so |dynamic_index_| remains valid.
+    *it = HpackEntry(StringPiece(name, it->name().size()),
+                     StringPiece(value, it->value().size()),
+                     it->InsertionIndex());
+  }
+  *previous_arena = std::move(arena_);
+  arena_ = std::move(arena);
+  arena_capacity_ = capacity;
+  arena_head_ = offset;
+  arena_tail_ = 0;
+
+  // The keys of |dynamic_name_index_| point into the previous arena.
+  std::vector<const HpackEntry*> named_entries;
+  for (const auto& it : dynamic_name_index_) {
+    named_entries.push_back(it.second);
+  }
+  dynamic_name_index_.clear();
+  for (const HpackEntry* entry : named_entries) {
+    dynamic_name_index_.insert(std::make_pair(entry->name(), entry));
+  }
+}
+
 const HpackEntry* HpackHeaderTable::TryAddEntry(StringPiece name,
                                                 StringPiece value) {
   Evict(EvictionCountForEntry(name, value));
@@ -185,9 +278,20 @@ const HpackEntry* HpackHeaderTable::TryAddEntry(StringPiece name,
     DCHECK_EQ(0u, size_);
     return NULL;
   }
-  dynamic_entries_.push_front(HpackEntry(name, value,
-                                         false,  // is_static
-                                         total_insertions_));
+  // Empty names and values need no storage. Otherwise, |previous_arena|
+  // keeps the strings of the entries |name| and |value| may belong to alive
+  // until they have been copied.
+  std::unique_ptr<char[]> previous_arena;
+  char* data = nullptr;
+  if (!name.empty() || !value.empty()) {
+    data = AllocateInArena(name.size() + value.size(), &previous_arena);
+    memcpy(data, name.data(), name.size());
+    memcpy(data + name.size(), value.data(), value.size());
+  }
+  dynamic_entries_.push_front(
+      HpackEntry(StringPiece(data, name.size()),
+                 StringPiece(data + name.size(), value.size()),
+                 total_insertions_));
   HpackEntry* new_entry = &dynamic_entries_.front();
   auto index_result = dynamic_index_.insert(new_entry);
   if (!index_result.second) {
@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <deque>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -109,6 +110,20 @@ class NET_EXPORT_PRIVATE HpackHeaderTable {
   // Evicts |count| oldest entries from the table.
   void Evict(size_t count);
 
+  // Returns whether the name and value of |entry| are stored in |arena_|.
+  bool IsInArena(const HpackEntry& entry) const;
+
+  // Returns |size| bytes of |arena_| for the name and value of a new entry.
+  // If |arena_| has to be replaced by a larger buffer, the previous one is
+  // handed to |previous_arena|, so that strings in it can still be copied.
+  char* AllocateInArena(size_t size,
+                        std::unique_ptr<char[]>* previous_arena);
+
+  // Moves the names and values of the dynamic entries to the start of a new
+  // arena of |capacity| bytes, handing the previous one to |previous_arena|.
+  void ReallocateArena(size_t capacity,
+                       std::unique_ptr<char[]>* previous_arena);
+
   // |static_entries_| and |static_index_| are owned by HpackStaticTable
   // singleton.
   const EntryTable& static_entries_;
@@ -120,6 +135,19 @@ class NET_EXPORT_PRIVATE HpackHeaderTable {
   // Tracks the first static entry for each name in the static table.
   const NameToEntryMap& static_name_index_;
 
+  // Holds the names and values of the dynamic entries added by TryAddEntry(),
+  // each name immediately followed by its value, as a ring buffer: entries are
+  // written at |arena_head_|, wrapping around to the start of the buffer when
+  // they do not fit before its end, and evicting the oldest entry only moves
+  // |arena_tail_| past it. Holding twice |max_size_| bytes, the buffer always
+  // has room for a new entry once the entries it replaces have been evicted.
+  std::unique_ptr<char[]> arena_;
+  size_t arena_capacity_;
+  size_t arena_head_;
+  size_t arena_tail_;
+  // Number of dynamic entries whose name and value are stored in |arena_|.
+  size_t arena_entries_;
+
   // Tracks the most recently inserted HpackEntry for a given header name and
   // value.
   UnorderedEntrySet dynamic_index_;
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
 #include "net/spdy/hpack/hpack_constants.h"
 #include "net/spdy/hpack/hpack_entry.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -53,6 +54,7 @@ class HpackHeaderTablePeer {
     return table_->EvictionCountToReclaim(reclaim_size);
   }
   void Evict(size_t count) { return table_->Evict(count); }
+  size_t arena_capacity() { return table_->arena_capacity_; }
 
   void AddDynamicEntry(StringPiece name, StringPiece value) {
     table_->dynamic_entries_.push_back(
@@ -401,6 +403,61 @@ TEST_F(HpackHeaderTableTest, TryAddTooLargeEntry) {
   EXPECT_EQ(0u, peer_.dynamic_entries().size());
 }
 
+// Evicted entries make room in the arena for new ones, without moving the
+// remaining entries to another buffer.
+TEST_F(HpackHeaderTableTest, ArenaWrapsAround) {
+  const HpackEntry* first = table_.TryAddEntry("name", "value");
+  ASSERT_NE(nullptr, first);
+  size_t arena_capacity = peer_.arena_capacity();
+  EXPECT_EQ(2 * kDefaultHeaderTableSizeSetting, arena_capacity);
+
+  for (size_t i = 0; i != 1000; ++i) {
+    string name = "name-" + base::SizeTToString(i);
+    string value(i % 700, 'v');
+    const HpackEntry* entry = table_.TryAddEntry(name, value);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(entry, table_.GetByIndex(62));
+    EXPECT_EQ(entry, table_.GetByName(name));
+    EXPECT_EQ(entry, table_.GetByNameAndValue(name, value));
+  }
+  EXPECT_EQ(arena_capacity, peer_.arena_capacity());
+
+  // All the remaining entries are intact.
+  size_t index = 62;
+  for (size_t i = 999; table_.GetByIndex(index) != NULL; --i, ++index) {
+    const HpackEntry* entry = table_.GetByIndex(index);
+    EXPECT_EQ("name-" + base::SizeTToString(i), entry->name());
+    EXPECT_EQ(string(i % 700, 'v'), entry->value());
+  }
+}
+
+// Growing the table moves the entries to a larger arena, which may require
+// copying a new entry's name from the previous one.
+TEST_F(HpackHeaderTableTest, ArenaGrows) {
+  table_.TryAddEntry("key-1", "Value One");
+  table_.TryAddEntry("key-2", "Value Two");
+  EXPECT_EQ(2 * kDefaultHeaderTableSizeSetting, peer_.arena_capacity());
+
+  table_.SetSettingsHeaderTableSize(4 * kDefaultHeaderTableSizeSetting);
+  table_.SetMaxSize(4 * kDefaultHeaderTableSizeSetting);
+  string value(3 * kDefaultHeaderTableSizeSetting, 'v');
+  const HpackEntry* name_entry = table_.GetByName("key-1");
+  ASSERT_NE(nullptr, name_entry);
+  const HpackEntry* entry = table_.TryAddEntry(name_entry->name(), value);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_LT(2 * kDefaultHeaderTableSizeSetting, peer_.arena_capacity());
+
+  EXPECT_EQ(3u, peer_.dynamic_entries_count());
+  EXPECT_EQ(entry, table_.GetByName("key-1"));
+  EXPECT_EQ("key-1", entry->name());
+  EXPECT_EQ(value, entry->value());
+  const HpackEntry* moved = table_.GetByName("key-2");
+  ASSERT_NE(nullptr, moved);
+  EXPECT_EQ("Value Two", moved->value());
+  EXPECT_EQ(moved, table_.GetByNameAndValue("key-2", "Value Two"));
+  EXPECT_EQ("Value One", table_.GetByIndex(64)->value());
+}
+
 TEST_F(HpackHeaderTableTest, EntryNamesDiffer) {
   HpackEntry entry1("header", "value");
   HpackEntry entry2("HEADER", "value");
@@ -10,6 +10,7 @@
 
 #include <string>
 
+#include "base/strings/string_piece.h"
 #include "net/base/net_export.h"
 #include "net/spdy/hpack/hpack_input_stream.h"
 
@@ -39,6 +40,18 @@ class NET_EXPORT_PRIVATE HpackHuffmanDecoder {
                            size_t out_capacity,
                            std::string* out);
 
+  // Same as above, but decodes all of |in|, which must hold exactly one
+  // encoded string. Rather than peeking at the input a byte at a time, this
+  // keeps up to 64 bits of input in a register and decodes up to two symbols
+  // per table lookup, falling back to the code above only for the rare codes
+  // longer than |kMultiSymbolLookupBits|.
+  static bool DecodeString(base::StringPiece in,
+                           size_t out_capacity,
+                           std::string* out);
+
+  // Number of input bits indexing the table used by the above.
+  static const size_t kMultiSymbolLookupBits = 12;
+
  private:
   friend class test::HpackHuffmanDecoderPeer;
 
@@ -288,5 +288,49 @@ TEST_F(HpackHuffmanDecoderTest, RoundTripSymbolSequences) {
   }
 }
 
+// The multi-symbol decoder produces the same output as the stream decoder,
+// including when |out_capacity| is reached part way through the input.
+TEST_F(HpackHuffmanDecoderTest, MultiSymbolMatchesStreamDecoder) {
+  for (size_t i = 0; i != 1000; i++) {
+    std::string input;
+    size_t length = base::RandInt(0, 64);
+    for (size_t j = 0; j != length; j++) {
+      // Favor the short codes of printable characters, but exercise the long
+      // codes of the other bytes too.
+      input.push_back(static_cast<char>(
+          (i % 4) ? base::RandInt(0x20, 0x7e) : base::RandInt(0, 255)));
+    }
+    std::string encoded = EncodeString(input);
+    size_t limit = base::RandInt(0, input.size());
+
+    HpackInputStream input_stream(std::numeric_limits<uint32_t>::max(),
+                                  encoded);
+    std::string stream_decoded;
+    bool stream_result = HpackHuffmanDecoder::DecodeString(
+        &input_stream, limit, &stream_decoded);
+    std::string decoded;
+    EXPECT_EQ(stream_result,
+              HpackHuffmanDecoder::DecodeString(encoded, limit, &decoded));
+    EXPECT_EQ(stream_decoded, decoded);
+    EXPECT_EQ(limit == input.size(), stream_result);
+
+    EXPECT_TRUE(
+        HpackHuffmanDecoder::DecodeString(encoded, input.size(), &decoded));
+    EXPECT_EQ(input, decoded);
+  }
+}
+
+TEST_F(HpackHuffmanDecoderTest, MultiSymbolSpecExamples) {
+  std::string decoded;
+  EXPECT_TRUE(HpackHuffmanDecoder::DecodeString(
+      a2b_hex("f1e3c2e5f23a6ba0ab90f4ff"), 15, &decoded));
+  EXPECT_EQ("www.example.com", decoded);
+  EXPECT_TRUE(HpackHuffmanDecoder::DecodeString(
+      a2b_hex("d07abe941054d444a8200595040b8166e082a62d1bff"), 29, &decoded));
+  EXPECT_EQ("Mon, 21 Oct 2013 20:13:21 GMT", decoded);
+  EXPECT_TRUE(HpackHuffmanDecoder::DecodeString("", 0, &decoded));
+  EXPECT_EQ("", decoded);
+}
+
 }  // namespace test
 }  // namespace net
@@ -159,15 +159,14 @@ bool HpackInputStream::DecodeNextHuffmanString(string* str) {
     return false;
   }
 
-  HpackInputStream bounded_reader(max_string_literal_size_,
-                                  StringPiece(buffer_.data(), encoded_size));
+  StringPiece encoded(buffer_.data(), encoded_size);
   buffer_.remove_prefix(encoded_size);
   parsed_bytes_current_ += encoded_size;
 
   // DecodeString will not append more than |max_string_literal_size_| chars
   // to |str|.
-  return HpackHuffmanDecoder::DecodeString(&bounded_reader,
-                                           max_string_literal_size_, str);
+  return HpackHuffmanDecoder::DecodeString(encoded, max_string_literal_size_,
+                                           str);
 }
 
 bool HpackInputStream::PeekBits(size_t* peeked_count, uint32_t* out) const {
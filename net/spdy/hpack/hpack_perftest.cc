@@ -0,0 +1,211 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures the throughput of HPACK encoding and decoding, in MB/s of
+// uncompressed header names and values, on sequences of header sets modelled
+// on the requests and responses of a page load, as well as that of the two
+// Huffman decoders on the strings of those header sets.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "net/spdy/hpack/hpack_constants.h"
+#include "net/spdy/hpack/hpack_decoder.h"
+#include "net/spdy/hpack/hpack_encoder.h"
+#include "net/spdy/hpack/hpack_huffman_decoder.h"
+#include "net/spdy/hpack/hpack_huffman_table.h"
+#include "net/spdy/hpack/hpack_input_stream.h"
+#include "net/spdy/hpack/hpack_output_stream.h"
+#include "net/spdy/spdy_header_block.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+namespace test {
+namespace {
+
+const int kIterations = 200;
+const size_t kNumResources = 100;
+
+const char kUserAgent[] =
+    "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/52.0.2743.116 Safari/537.36";
+const char kCookie[] =
+    "_ga=GA1.2.1753249134.1467038741; _gid=GA1.2.1398567442.1471364425; "
+    "session=8f7c2a1e6b0d4c9a3e5f7a2b1c8d9e0f; prefs=lang%3Den%26tz%3D-7";
+
+double MegabytesPerSecond(size_t bytes, base::TimeDelta elapsed) {
+  return bytes / elapsed.InSecondsF() / (1024 * 1024);
+}
+
+size_t HeaderBytes(const std::vector<SpdyHeaderBlock>& header_sets) {
+  size_t bytes = 0;
+  for (const SpdyHeaderBlock& header_set : header_sets) {
+    for (const auto& header : header_set) {
+      bytes += header.first.size() + header.second.size();
+    }
+  }
+  return bytes;
+}
+
+// Returns the request header sets of a page load fetching |kNumResources|
+// subresources from the same origin.
+std::vector<SpdyHeaderBlock> RequestHeaderSets() {
+  std::vector<SpdyHeaderBlock> header_sets(kNumResources);
+  for (size_t i = 0; i < kNumResources; ++i) {
+    SpdyHeaderBlock& headers = header_sets[i];
+    std::string id = base::SizeTToString(i);
+    headers[":method"] = "GET";
+    headers[":authority"] = "www.example.com";
+    headers[":scheme"] = "https";
+    headers[":path"] = i == 0 ? "/" : "/static/" + id + "/bundle." +
+                                          base::SizeTToString(i * 7919) +
+                                          (i % 3 ? ".js" : ".css");
+    headers["user-agent"] = kUserAgent;
+    headers["accept"] = i == 0 ? "text/html,application/xhtml+xml,"
+                                 "application/xml;q=0.9,image/webp,*/*;q=0.8"
+                               : "*/*";
+    headers["accept-encoding"] = "gzip, deflate, sdch, br";
+    headers["accept-language"] = "en-US,en;q=0.8";
+    headers["cookie"] = kCookie;
+    if (i != 0) {
+      headers["referer"] = "https://www.example.com/";
+    }
+  }
+  return header_sets;
+}
+
+// Returns the response header sets matching RequestHeaderSets().
+std::vector<SpdyHeaderBlock> ResponseHeaderSets() {
+  std::vector<SpdyHeaderBlock> header_sets(kNumResources);
+  for (size_t i = 0; i < kNumResources; ++i) {
+    SpdyHeaderBlock& headers = header_sets[i];
+    headers[":status"] = i % 10 == 9 ? "304" : "200";
+    headers["date"] = "Tue, 16 Aug 2016 17:21:" +
+                      base::SizeTToString(10 + i % 50) + " GMT";
+    headers["content-type"] =
+        i == 0 ? "text/html; charset=utf-8"
+               : (i % 3 ? "application/javascript" : "text/css");
+    headers["content-length"] = base::SizeTToString(1000 + i * 137);
+    headers["cache-control"] = "public, max-age=31536000";
+    headers["etag"] = "\"" + base::SizeTToString(i * 104729) + "-5399e1c\"";
+    headers["last-modified"] = "Mon, 25 Jul 2016 09:12:44 GMT";
+    headers["server"] = "nginx";
+    headers["x-content-type-options"] = "nosniff";
+    if (i == 0) {
+      headers["set-cookie"] =
+          "session=8f7c2a1e6b0d4c9a3e5f7a2b1c8d9e0f; path=/; secure; HttpOnly";
+    }
+  }
+  return header_sets;
+}
+
+void MeasureEncoding(const std::string& trace,
+                     const std::vector<SpdyHeaderBlock>& header_sets) {
+  std::string encoded;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    HpackEncoder encoder(ObtainHpackHuffmanTable());
+    for (const SpdyHeaderBlock& header_set : header_sets) {
+      encoder.EncodeHeaderSet(header_set, &encoded);
+    }
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  perf_test::PrintResult(
+      "hpack_encode", "", trace,
+      MegabytesPerSecond(kIterations * HeaderBytes(header_sets), elapsed),
+      "MB/s", true);
+}
+
+void MeasureDecoding(const std::string& trace,
+                     const std::vector<SpdyHeaderBlock>& header_sets) {
+  std::vector<std::string> encoded(header_sets.size());
+  HpackEncoder encoder(ObtainHpackHuffmanTable());
+  for (size_t i = 0; i < header_sets.size(); ++i) {
+    encoder.EncodeHeaderSet(header_sets[i], &encoded[i]);
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    HpackDecoder decoder;
+    for (const std::string& block : encoded) {
+      ASSERT_TRUE(
+          decoder.HandleControlFrameHeadersData(block.data(), block.size()));
+      ASSERT_TRUE(decoder.HandleControlFrameHeadersComplete(nullptr));
+    }
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  perf_test::PrintResult(
+      "hpack_decode", "", trace,
+      MegabytesPerSecond(kIterations * HeaderBytes(header_sets), elapsed),
+      "MB/s", true);
+}
+
+TEST(HpackPerfTest, Requests) {
+  std::vector<SpdyHeaderBlock> header_sets = RequestHeaderSets();
+  MeasureEncoding("requests", header_sets);
+  MeasureDecoding("requests", header_sets);
+}
+
+TEST(HpackPerfTest, Responses) {
+  std::vector<SpdyHeaderBlock> header_sets = ResponseHeaderSets();
+  MeasureEncoding("responses", header_sets);
+  MeasureDecoding("responses", header_sets);
+}
+
+TEST(HpackPerfTest, HuffmanDecoding) {
+  const HpackHuffmanTable& table = ObtainHpackHuffmanTable();
+  std::vector<std::string> encoded;
+  size_t bytes = 0;
+  std::vector<SpdyHeaderBlock> header_sets = RequestHeaderSets();
+  std::vector<SpdyHeaderBlock> responses = ResponseHeaderSets();
+  header_sets.insert(header_sets.end(), responses.begin(), responses.end());
+  for (const SpdyHeaderBlock& header_set : header_sets) {
+    for (const auto& header : header_set) {
+      HpackOutputStream output_stream;
+      table.EncodeString(header.second, &output_stream);
+      encoded.push_back(std::string());
+      output_stream.TakeString(&encoded.back());
+      bytes += header.second.size();
+    }
+  }
+
+  const uint32_t kMaxSize = std::numeric_limits<uint32_t>::max();
+  std::string decoded;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    for (const std::string& encoded_string : encoded) {
+      HpackInputStream input_stream(kMaxSize, encoded_string);
+      ASSERT_TRUE(
+          HpackHuffmanDecoder::DecodeString(&input_stream, kMaxSize, &decoded));
+    }
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  perf_test::PrintResult("hpack_huffman_decode", "", "stream",
+                         MegabytesPerSecond(kIterations * bytes, elapsed),
+                         "MB/s", false);
+
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    for (const std::string& encoded_string : encoded) {
+      ASSERT_TRUE(HpackHuffmanDecoder::DecodeString(encoded_string, kMaxSize,
+                                                    &decoded));
+    }
+  }
+  elapsed = base::TimeTicks::Now() - start;
+  perf_test::PrintResult("hpack_huffman_decode", "", "multi_symbol",
+                         MegabytesPerSecond(kIterations * bytes, elapsed),
+                         "MB/s", true);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
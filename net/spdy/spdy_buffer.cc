@@ -37,14 +37,17 @@ std::unique_ptr<SpdySerializedFrame> MakeSpdySerializedFrame(const char* data,
 }  // namespace
 
 // This class is an IOBuffer implementation that simply holds a
-// reference to a SharedFrame object and a fixed offset. Used by
+// reference to a SharedFrame object, the IOBuffer backing its data if
+// any, and a fixed offset. Used by
 // SpdyBuffer::GetIOBufferForRemainingData().
 class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
  public:
   SharedFrameIOBuffer(const scoped_refptr<SharedFrame>& shared_frame,
+                      const scoped_refptr<IOBuffer>& backing_buffer,
                       size_t offset)
       : IOBuffer(shared_frame->data->data() + offset),
-        shared_frame_(shared_frame) {}
+        shared_frame_(shared_frame),
+        backing_buffer_(backing_buffer) {}
 
  private:
   ~SharedFrameIOBuffer() override {
@@ -53,6 +56,7 @@ class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
   }
 
   const scoped_refptr<SharedFrame> shared_frame_;
+  const scoped_refptr<IOBuffer> backing_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(SharedFrameIOBuffer);
 };
@@ -72,6 +76,16 @@ SpdyBuffer::SpdyBuffer(const char* data, size_t size) :
   shared_frame_->data = MakeSpdySerializedFrame(data, size);
 }
 
+SpdyBuffer::SpdyBuffer(const scoped_refptr<IOBuffer>& buffer,
+                       size_t offset,
+                       size_t size)
+    : shared_frame_(new SharedFrame()), backing_buffer_(buffer), offset_(0) {
+  CHECK_GT(size, 0u);
+  CHECK_LE(size, kMaxSpdyFrameSize);
+  shared_frame_->data.reset(new SpdySerializedFrame(
+      buffer->data() + offset, size, false /* owns_buffer */));
+}
+
 SpdyBuffer::~SpdyBuffer() {
   if (GetRemainingSize() > 0)
     ConsumeHelper(GetRemainingSize(), DISCARD);
@@ -94,7 +108,7 @@ void SpdyBuffer::Consume(size_t consume_size) {
 };
 
 IOBuffer* SpdyBuffer::GetIOBufferForRemainingData() {
-  return new SharedFrameIOBuffer(shared_frame_, offset_);
+  return new SharedFrameIOBuffer(shared_frame_, backing_buffer_, offset_);
 }
 
 void SpdyBuffer::ConsumeHelper(size_t consume_size,
@@ -53,6 +53,14 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   // non-NULL and |size| must be non-zero.
   SpdyBuffer(const char* data, size_t size);
 
+  // Construct with the |size| bytes of |buffer| starting at |offset|,
+  // without copying them. |buffer| is kept alive by this object and by
+  // the IOBuffers returned by GetIOBufferForRemainingData(), and must
+  // not be modified while any of them exists. |size| must be non-zero.
+  SpdyBuffer(const scoped_refptr<IOBuffer>& buffer,
+             size_t offset,
+             size_t size);
+
   // If there are bytes remaining in the buffer, triggers a call to
   // any consume callbacks with a DISCARD source.
   ~SpdyBuffer();
@@ -94,6 +102,9 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   class SharedFrameIOBuffer;
 
   const scoped_refptr<SharedFrame> shared_frame_;
+  // The buffer the data of |shared_frame_| points into, if it doesn't
+  // own its data.
+  const scoped_refptr<IOBuffer> backing_buffer_;
   std::vector<ConsumeCallback> consume_callbacks_;
   size_t offset_;
 
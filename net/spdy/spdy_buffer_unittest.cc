@@ -53,6 +53,37 @@ TEST_F(SpdyBufferTest, DataConstructor) {
   EXPECT_EQ(std::string(kData, kDataSize), BufferToString(buffer));
 }
 
+// Construct a SpdyBuffer from a slice of an IOBuffer and make sure
+// its data points into the IOBuffer, which it keeps alive.
+TEST_F(SpdyBufferTest, IOBufferSliceConstructor) {
+  scoped_refptr<IOBuffer> io_buffer(new IOBuffer(kDataSize + 2));
+  std::memcpy(io_buffer->data() + 2, kData, kDataSize);
+  SpdyBuffer buffer(io_buffer, 2, kDataSize);
+
+  EXPECT_EQ(io_buffer->data() + 2, buffer.GetRemainingData());
+  EXPECT_EQ(kDataSize, buffer.GetRemainingSize());
+  EXPECT_FALSE(io_buffer->HasOneRef());
+
+  scoped_refptr<IOBuffer> remaining = buffer.GetIOBufferForRemainingData();
+  EXPECT_EQ(io_buffer->data() + 2, remaining->data());
+}
+
+// Make sure the IOBuffer returned by GetIOBufferForRemainingData()
+// keeps the IOBuffer a slice was constructed from alive.
+TEST_F(SpdyBufferTest, IOBufferForRemainingDataOutlivesSlice) {
+  scoped_refptr<IOBuffer> io_buffer(new IOBuffer(kDataSize));
+  std::unique_ptr<SpdyBuffer> buffer(
+      new SpdyBuffer(io_buffer, 0, kDataSize));
+  io_buffer = nullptr;
+
+  scoped_refptr<IOBuffer> remaining = buffer->GetIOBufferForRemainingData();
+  buffer.reset();
+
+  // This will cause a use-after-free error if |remaining| doesn't
+  // keep the sliced IOBuffer alive.
+  std::memcpy(remaining->data(), kData, kDataSize);
+}
+
 void IncrementBy(size_t* x,
                  SpdyBuffer::ConsumeSource expected_consume_source,
                  size_t delta,
@@ -55,6 +55,10 @@ namespace net {
 namespace {
 
 const int kReadBufferSize = 8 * 1024;
+// DATA payloads smaller than this are copied even if data slices are enabled,
+// which bounds the memory held by read buffers kept alive by slices to four
+// times the unconsumed data.
+const size_t kMinDataSliceSize = kReadBufferSize / 4;
 const int kDefaultConnectionAtRiskOfLossSeconds = 10;
 const int kHungIntervalSeconds = 10;
 
@@ -676,6 +680,7 @@ SpdySession::SpdySession(
     bool enable_sending_initial_data,
     bool enable_ping_based_connection_checking,
     bool enable_priority_dependencies,
+    bool enable_data_slices,
     NextProto default_protocol,
     size_t session_max_recv_window_size,
     size_t stream_max_recv_window_size,
@@ -736,6 +741,7 @@ SpdySession::SpdySession(
       proxy_delegate_(proxy_delegate),
       time_func_(time_func),
       priority_dependencies_enabled_(enable_priority_dependencies),
+      enable_data_slices_(enable_data_slices),
       weak_factory_(this) {
   DCHECK_GE(protocol_, kProtoSPDYMinimumVersion);
   DCHECK_LE(protocol_, kProtoSPDYMaximumVersion);
@@ -1457,6 +1463,10 @@ int SpdySession::DoRead() {
 
   CHECK(connection_);
   CHECK(connection_->socket());
+  // Slices of the read buffer handed to streams may still be alive, in which
+  // case it must not be overwritten.
+  if (enable_data_slices_ && !read_buffer_->HasOneRef())
+    read_buffer_ = new IOBuffer(kReadBufferSize);
   read_state_ = READ_STATE_DO_READ_COMPLETE;
   return connection_->socket()->Read(
       read_buffer_.get(),
@@ -2129,7 +2139,15 @@ void SpdySession::OnStreamFrameData(SpdyStreamId stream_id,
   if (data) {
     DCHECK_GT(len, 0u);
     CHECK_LE(len, static_cast<size_t>(kReadBufferSize));
-    buffer.reset(new SpdyBuffer(data, len));
+    const char* read_buffer_data = read_buffer_->data();
+    if (enable_data_slices_ && len >= kMinDataSliceSize &&
+        data >= read_buffer_data &&
+        data + len <= read_buffer_data + kReadBufferSize) {
+      buffer.reset(
+          new SpdyBuffer(read_buffer_, data - read_buffer_data, len));
+    } else {
+      buffer.reset(new SpdyBuffer(data, len));
+    }
 
     DecreaseRecvWindowSize(static_cast<int32_t>(len));
     buffer->AddConsumeCallback(base::Bind(&SpdySession::OnReadBufferConsumed,
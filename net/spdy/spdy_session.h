@@ -296,6 +296,7 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
               bool enable_sending_initial_data,
               bool enable_ping_based_connection_checking,
               bool enable_priority_dependencies,
+              bool enable_data_slices,
               NextProto default_protocol,
               size_t session_max_recv_window_size,
               size_t stream_max_recv_window_size,
@@ -1230,6 +1231,10 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   const bool priority_dependencies_enabled_;
   Http2PriorityDependencies priority_dependency_state_;
 
+  // If true, large DATA payloads are handed to streams as SpdyBuffers
+  // referencing |read_buffer_| rather than as copies.
+  const bool enable_data_slices_;
+
   // Used for posting asynchronous IO tasks.  We use this even though
   // SpdySession is refcounted because we don't need to keep the SpdySession
   // alive if the last reference is within a RunnableMethod.  Just revoke the
@@ -0,0 +1,200 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures how fast a SpdySession delivers the DATA frames of a large HTTP/2
+// download read from a mock socket to a stream delegate, with and without
+// data slices, in MB/s of wall clock time and, where supported, of CPU time.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "net/socket/socket_test_util.h"
+#include "net/spdy/buffered_spdy_framer.h"
+#include "net/spdy/spdy_buffer.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_stream_test_util.h"
+#include "net/spdy/spdy_test_util_common.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace net {
+namespace test {
+namespace {
+
+const size_t kDownloadSize = 64 * 1024 * 1024;
+const size_t kFramePayloadSize = 16 * 1024;
+const int32_t kWindowSize = 64 * 1024;
+
+double MegabytesPerSecond(size_t bytes, base::TimeDelta elapsed) {
+  return bytes / elapsed.InSecondsF() / (1024 * 1024);
+}
+
+// Serves |response| once the request has been written, then never completes
+// another read. Accepts every write, e.g. the request and the WINDOW_UPDATE
+// frames.
+class DownloadSocketData : public SocketDataProvider {
+ public:
+  explicit DownloadSocketData(const std::string& response)
+      : response_(response),
+        request_written_(false),
+        read_pending_(false),
+        read_(false),
+        weak_factory_(this) {}
+  ~DownloadSocketData() override {}
+
+  // SocketDataProvider implementation.
+  MockRead OnRead() override {
+    if (read_ || !request_written_) {
+      read_pending_ = !read_;
+      return MockRead(SYNCHRONOUS, ERR_IO_PENDING);
+    }
+    read_ = true;
+    return ResponseRead();
+  }
+  MockWriteResult OnWrite(const std::string& data) override {
+    if (!request_written_) {
+      request_written_ = true;
+      if (read_pending_) {
+        base::ThreadTaskRunnerHandle::Get()->PostTask(
+            FROM_HERE, base::Bind(&DownloadSocketData::CompleteRead,
+                                  weak_factory_.GetWeakPtr()));
+      }
+    }
+    return MockWriteResult(SYNCHRONOUS, static_cast<int>(data.size()));
+  }
+  bool AllReadDataConsumed() const override { return read_; }
+  bool AllWriteDataConsumed() const override { return true; }
+
+ private:
+  void Reset() override {
+    request_written_ = false;
+    read_pending_ = false;
+    read_ = false;
+  }
+
+  MockRead ResponseRead() const {
+    return MockRead(ASYNC, response_.data(),
+                    static_cast<int>(response_.size()));
+  }
+
+  void CompleteRead() {
+    read_pending_ = false;
+    read_ = true;
+    socket()->OnReadComplete(ResponseRead());
+  }
+
+  const std::string& response_;
+  bool request_written_;
+  bool read_pending_;
+  bool read_;
+  base::WeakPtrFactory<DownloadSocketData> weak_factory_;
+};
+
+// Counts and immediately drops the data it receives, which returns it to the
+// flow control windows.
+class DownloadDelegate : public StreamDelegateDoNothing {
+ public:
+  explicit DownloadDelegate(const base::WeakPtr<SpdyStream>& stream)
+      : StreamDelegateDoNothing(stream), bytes_received_(0) {}
+  ~DownloadDelegate() override {}
+
+  void OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) override {
+    if (buffer)
+      bytes_received_ += buffer->GetRemainingSize();
+  }
+
+  size_t bytes_received() const { return bytes_received_; }
+
+ private:
+  size_t bytes_received_;
+};
+
+// Returns the frames of the response to stream 1: its HEADERS followed by
+// |kDownloadSize| bytes in DATA frames.
+std::string DownloadResponse(SpdyTestUtil* spdy_util) {
+  BufferedSpdyFramer framer(spdy_util->spdy_version());
+  std::unique_ptr<SpdySerializedFrame> headers(
+      spdy_util->ConstructSpdyGetSynReply(nullptr, 0, 1));
+  std::string response(headers->data(), headers->size());
+  const std::string payload(kFramePayloadSize, 'x');
+  for (size_t sent = 0; sent < kDownloadSize; sent += kFramePayloadSize) {
+    bool fin = sent + kFramePayloadSize >= kDownloadSize;
+    std::unique_ptr<SpdySerializedFrame> data(framer.CreateDataFrame(
+        1, payload.data(), payload.size(),
+        fin ? DATA_FLAG_FIN : DATA_FLAG_NONE));
+    response.append(data->data(), data->size());
+  }
+  return response;
+}
+
+void MeasureDownload(bool enable_data_slices) {
+  SpdyTestUtil spdy_util(kProtoHTTP2, false);
+  const std::string response = DownloadResponse(&spdy_util);
+  DownloadSocketData data(response);
+
+  SpdySessionDependencies session_deps(kProtoHTTP2);
+  session_deps.host_resolver->set_synchronous_mode(true);
+  session_deps.enable_spdy_data_slices = enable_data_slices;
+  session_deps.session_max_recv_window_size = kWindowSize;
+  session_deps.stream_max_recv_window_size = kWindowSize;
+  session_deps.socket_factory->AddSocketDataProvider(&data);
+  std::unique_ptr<HttpNetworkSession> http_session(
+      SpdySessionDependencies::SpdyCreateSession(&session_deps));
+
+  GURL url(kDefaultURL);
+  SpdySessionKey key(HostPortPair::FromURL(url), ProxyServer::Direct(),
+                     PRIVACY_MODE_DISABLED);
+  base::WeakPtr<SpdySession> session =
+      CreateInsecureSpdySession(http_session.get(), key, BoundNetLog());
+  base::WeakPtr<SpdyStream> stream = CreateStreamSynchronously(
+      SPDY_REQUEST_RESPONSE_STREAM, session, url, MEDIUM, BoundNetLog());
+  ASSERT_TRUE(stream);
+  DownloadDelegate delegate(stream);
+  stream->SetDelegate(&delegate);
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::ThreadTicks thread_start;
+  if (base::ThreadTicks::IsSupported())
+    thread_start = base::ThreadTicks::Now();
+  stream->SendRequestHeaders(spdy_util.ConstructGetHeaderBlock(kDefaultURL),
+                             NO_MORE_DATA_TO_SEND);
+  EXPECT_EQ(OK, delegate.WaitForClose());
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  ASSERT_EQ(kDownloadSize, delegate.bytes_received());
+
+  std::string trace = enable_data_slices ? "slices" : "copies";
+  perf_test::PrintResult("spdy_download", "", trace,
+                         MegabytesPerSecond(kDownloadSize, elapsed), "MB/s",
+                         true);
+  if (base::ThreadTicks::IsSupported()) {
+    perf_test::PrintResult(
+        "spdy_download_cpu", "", trace,
+        MegabytesPerSecond(kDownloadSize,
+                           base::ThreadTicks::Now() - thread_start),
+        "MB/s", false);
+  }
+}
+
+TEST(SpdySessionPerfTest, Download) {
+  base::MessageLoopForIO message_loop;
+  if (base::ThreadTicks::IsSupported())
+    base::ThreadTicks::WaitUntilInitialized();
+  MeasureDownload(false);
+  MeasureDownload(true);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
@@ -38,6 +38,7 @@ SpdySessionPool::SpdySessionPool(
     TransportSecurityState* transport_security_state,
     bool enable_ping_based_connection_checking,
     bool enable_priority_dependencies,
+    bool enable_data_slices,
     NextProto default_protocol,
     size_t session_max_recv_window_size,
     size_t stream_max_recv_window_size,
@@ -52,6 +53,7 @@ SpdySessionPool::SpdySessionPool(
       enable_ping_based_connection_checking_(
           enable_ping_based_connection_checking),
       enable_priority_dependencies_(enable_priority_dependencies),
+      enable_data_slices_(enable_data_slices),
       // TODO(akalin): Force callers to have a valid value of
       // |default_protocol_|.
       default_protocol_((default_protocol == kProtoUnknown) ? kProtoSPDY31
@@ -100,7 +102,7 @@ base::WeakPtr<SpdySession> SpdySessionPool::CreateAvailableSessionFromSocket(
       key, http_server_properties_, transport_security_state_,
       verify_domain_authentication_, enable_sending_initial_data_,
       enable_ping_based_connection_checking_, enable_priority_dependencies_,
-      default_protocol_, session_max_recv_window_size_,
+      enable_data_slices_, default_protocol_, session_max_recv_window_size_,
       stream_max_recv_window_size_, time_func_, proxy_delegate_,
       net_log.net_log()));
 
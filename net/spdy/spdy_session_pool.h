@@ -56,6 +56,7 @@ class NET_EXPORT SpdySessionPool
       TransportSecurityState* transport_security_state,
       bool enable_ping_based_connection_checking,
       bool enable_priority_dependencies,
+      bool enable_data_slices,
       NextProto default_protocol,
       size_t session_max_recv_window_size,
       size_t stream_max_recv_window_size,
@@ -229,6 +230,7 @@ class NET_EXPORT SpdySessionPool
   bool enable_sending_initial_data_;
   bool enable_ping_based_connection_checking_;
   const bool enable_priority_dependencies_;
+  const bool enable_data_slices_;
   const NextProto default_protocol_;
   size_t session_max_recv_window_size_;
   size_t stream_max_recv_window_size_;
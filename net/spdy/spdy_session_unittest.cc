@@ -2763,6 +2763,63 @@ TEST_P(SpdySessionTest, ReadDataWithoutYielding) {
   EXPECT_TRUE(data.AllReadDataConsumed());
 }
 
+// Test that with data slices enabled, DATA payloads handed to a stream
+// as slices of the session's read buffer are not overwritten by later
+// reads while the stream still holds them, and that small payloads,
+// which are copied, are delivered as well.
+TEST_P(SpdySessionTest, ReadDataSlices) {
+  session_deps_.enable_spdy_data_slices = true;
+
+  BufferedSpdyFramer framer(spdy_util_.spdy_version());
+
+  std::unique_ptr<SpdySerializedFrame> req(
+      spdy_util_.ConstructSpdyGet(nullptr, 0, 1, MEDIUM, true));
+  MockWrite writes[] = {
+      CreateMockWrite(*req, 0),
+  };
+
+  const int kLargePayloadSize = 4000;
+  const std::string payload1(kLargePayloadSize, 'a');
+  const std::string payload2(kLargePayloadSize, 'b');
+  const std::string payload3(100, 'c');
+  std::unique_ptr<SpdySerializedFrame> resp(
+      spdy_util_.ConstructSpdyGetSynReply(nullptr, 0, 1));
+  std::unique_ptr<SpdySerializedFrame> data_frame1(framer.CreateDataFrame(
+      1, payload1.data(), payload1.size(), DATA_FLAG_NONE));
+  std::unique_ptr<SpdySerializedFrame> data_frame2(framer.CreateDataFrame(
+      1, payload2.data(), payload2.size(), DATA_FLAG_NONE));
+  std::unique_ptr<SpdySerializedFrame> data_frame3(framer.CreateDataFrame(
+      1, payload3.data(), payload3.size(), DATA_FLAG_FIN));
+  MockRead reads[] = {
+      CreateMockRead(*resp, 1),
+      CreateMockRead(*data_frame1, 2),
+      CreateMockRead(*data_frame2, 3),
+      CreateMockRead(*data_frame3, 4),
+      MockRead(ASYNC, 0, 5)  // EOF
+  };
+
+  SequencedSocketData data(reads, arraysize(reads), writes, arraysize(writes));
+  session_deps_.socket_factory->AddSocketDataProvider(&data);
+
+  CreateNetworkSession();
+  CreateInsecureSpdySession();
+
+  base::WeakPtr<SpdyStream> spdy_stream = CreateStreamSynchronously(
+      SPDY_REQUEST_RESPONSE_STREAM, session_, test_url_, MEDIUM, BoundNetLog());
+  ASSERT_TRUE(spdy_stream);
+  test::StreamDelegateDoNothing delegate(spdy_stream);
+  spdy_stream->SetDelegate(&delegate);
+
+  std::unique_ptr<SpdyHeaderBlock> headers(
+      spdy_util_.ConstructGetHeaderBlock(kDefaultURL));
+  spdy_stream->SendRequestHeaders(std::move(headers), NO_MORE_DATA_TO_SEND);
+
+  EXPECT_EQ(OK, delegate.WaitForClose());
+  EXPECT_EQ(payload1 + payload2 + payload3, delegate.TakeReceivedData());
+  EXPECT_TRUE(data.AllWriteDataConsumed());
+  EXPECT_TRUE(data.AllReadDataConsumed());
+}
+
 // Test that SpdySession::DoReadLoop yields if more than
 // |kYieldAfterDurationMilliseconds| has passed.  This test uses a mock time
 // function that makes the response frame look very slow to read.
@@ -346,6 +346,7 @@ SpdySessionDependencies::SpdySessionDependencies(NextProto protocol)
       enable_user_alternate_protocol_ports(false),
       enable_npn(false),
       enable_priority_dependencies(true),
+      enable_spdy_data_slices(false),
       enable_spdy31(true),
       enable_quic(false),
       enable_alternative_service_for_insecure_origins(true),
@@ -386,6 +387,7 @@ SpdySessionDependencies::SpdySessionDependencies(
       enable_user_alternate_protocol_ports(false),
       enable_npn(false),
       enable_priority_dependencies(true),
+      enable_spdy_data_slices(false),
       enable_spdy31(true),
       enable_quic(false),
       enable_alternative_service_for_insecure_origins(true),
@@ -439,6 +441,7 @@ HttpNetworkSession::Params SpdySessionDependencies::CreateSessionParams(
   params.enable_npn = session_deps->enable_npn;
   params.enable_priority_dependencies =
       session_deps->enable_priority_dependencies;
+  params.enable_spdy_data_slices = session_deps->enable_spdy_data_slices;
   params.enable_spdy31 = session_deps->enable_spdy31;
   params.enable_quic = session_deps->enable_quic;
   params.enable_alternative_service_for_insecure_origins =
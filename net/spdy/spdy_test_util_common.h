@@ -199,6 +199,7 @@ struct SpdySessionDependencies {
   bool enable_user_alternate_protocol_ports;
   bool enable_npn;
   bool enable_priority_dependencies;
+  bool enable_spdy_data_slices;
   bool enable_spdy31;
   bool enable_quic;
   bool enable_alternative_service_for_insecure_origins;
@@ -0,0 +1,229 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Decodes the body read from stdin first synchronously, as URLRequestJob does
+// without a filter task runner, then through a FilterPipeline on a worker
+// thread, and reports for each the decoding throughput and the share of wall
+// clock time the decoding thread ("IO thread") was busy. For example:
+//
+//   head -c 100M /dev/urandom | gzip > body.gz
+//   content_decoder_benchmark gzip < body.gz
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/command_line.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/filter/filter.h"
+#include "net/filter/filter_pipeline.h"
+#include "net/filter/mock_filter_context.h"
+
+using net::Filter;
+
+namespace {
+
+const int kReadSize = 32 * 1024;
+
+// Print the command line help.
+void PrintHelp(const char* command_line_name) {
+  std::cout << command_line_name << " content_encoding [content_encoding]..."
+            << std::endl
+            << std::endl;
+  std::cout << "Decodes the stdin, which is expected to be encoded with the "
+            << "content_encoding list given in arguments, on the current "
+            << "thread and then on a worker thread, and prints the "
+            << "throughput and the current thread's occupancy of each. "
+            << "Encodings which need a filter context, such as sdch, are "
+            << "not supported." << std::endl;
+}
+
+// Wall clock and current thread CPU time spent while an object is alive.
+class Timer {
+ public:
+  Timer() : start_(base::TimeTicks::Now()) {
+    if (base::ThreadTicks::IsSupported())
+      thread_start_ = base::ThreadTicks::Now();
+  }
+
+  void Print(const std::string& name, int64_t decoded_bytes) const {
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_;
+    std::cout << name << ": " << decoded_bytes << " bytes in "
+              << elapsed.InMillisecondsF() << " ms, "
+              << decoded_bytes / elapsed.InSecondsF() / (1024 * 1024)
+              << " MB/s";
+    if (base::ThreadTicks::IsSupported()) {
+      base::TimeDelta busy = base::ThreadTicks::Now() - thread_start_;
+      std::cout << ", IO thread busy "
+                << 100 * busy.InSecondsF() / elapsed.InSecondsF() << "%";
+    }
+    std::cout << std::endl;
+  }
+
+ private:
+  const base::TimeTicks start_;
+  base::ThreadTicks thread_start_;
+};
+
+// Decodes |input| with |filter| on the current thread. Returns the number of
+// decoded bytes, or -1 on error.
+int64_t DecodeSynchronously(const std::string& input,
+                            std::unique_ptr<Filter> filter) {
+  int64_t decoded_bytes = 0;
+  size_t offset = 0;
+  std::vector<char> post_filter_buf(kReadSize);
+  while (true) {
+    int pre_filter_data_len = std::min<size_t>(input.size() - offset,
+                                               filter->stream_buffer_size());
+    memcpy(filter->stream_buffer()->data(), input.data() + offset,
+           pre_filter_data_len);
+    offset += pre_filter_data_len;
+    filter->FlushStreamBuffer(pre_filter_data_len);
+
+    while (true) {
+      int post_filter_data_len = kReadSize;
+      Filter::FilterStatus filter_status =
+          filter->ReadData(post_filter_buf.data(), &post_filter_data_len);
+      decoded_bytes += post_filter_data_len;
+      if (filter_status == Filter::FILTER_ERROR)
+        return -1;
+      if (filter_status == Filter::FILTER_DONE)
+        return decoded_bytes;
+      if (filter_status != Filter::FILTER_OK)
+        break;
+    }
+    if (offset == input.size())
+      return decoded_bytes;
+  }
+}
+
+void RunQuitClosure(base::Closure* quit_closure) {
+  if (!quit_closure->is_null())
+    base::ResetAndReturn(quit_closure).Run();
+}
+
+// Decodes |input| with |filter| on |worker|, feeding it and reading the
+// decoded data on the current thread. Returns the number of decoded bytes, or
+// -1 on error.
+int64_t DecodeOnWorker(const std::string& input,
+                       std::unique_ptr<Filter> filter,
+                       base::Thread* worker) {
+  base::Closure quit_closure;
+  net::FilterPipeline pipeline(
+      std::move(filter), worker->task_runner(),
+      base::Bind(&RunQuitClosure, &quit_closure));
+
+  int64_t decoded_bytes = 0;
+  size_t offset = 0;
+  bool input_complete = false;
+  scoped_refptr<net::IOBuffer> read_buffer(new net::IOBuffer(kReadSize));
+  while (true) {
+    while (!input_complete && pipeline.CanAcceptInput()) {
+      int size = std::min<size_t>(input.size() - offset,
+                                  pipeline.input_chunk_size());
+      scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(size + 1));
+      memcpy(buffer->data(), input.data() + offset, size);
+      pipeline.AppendInput(buffer, size);
+      offset += size;
+      input_complete = size == 0;
+    }
+
+    int rv = pipeline.Read(read_buffer.get(), kReadSize);
+    if (rv > 0) {
+      decoded_bytes += rv;
+      continue;
+    }
+    if (rv == 0)
+      return decoded_bytes;
+    if (rv != net::ERR_IO_PENDING)
+      return -1;
+    base::RunLoop run_loop;
+    quit_closure = run_loop.QuitClosure();
+    run_loop.Run();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+
+  std::vector<std::string> content_encodings = command_line.GetArgs();
+  if (content_encodings.size() == 0) {
+    PrintHelp(argv[0]);
+    return 1;
+  }
+
+  std::vector<Filter::FilterType> filter_types;
+  for (const auto& content_encoding : content_encodings) {
+    Filter::FilterType filter_type =
+        Filter::ConvertEncodingToType(content_encoding);
+    if (filter_type == Filter::FILTER_TYPE_UNSUPPORTED) {
+      std::cerr << "Unsupported decoder '" << content_encoding << "'."
+                << std::endl;
+      return 1;
+    }
+    filter_types.push_back(filter_type);
+  }
+
+  net::MockFilterContext filter_context;
+  std::unique_ptr<Filter> filter(Filter::Factory(filter_types, filter_context));
+  if (!filter || !filter->IsContextFree()) {
+    std::cerr << "Couldn't create a context free decoder." << std::endl;
+    return 1;
+  }
+
+  std::string input((std::istreambuf_iterator<char>(std::cin)),
+                    std::istreambuf_iterator<char>());
+
+  base::MessageLoopForIO message_loop;
+  if (base::ThreadTicks::IsSupported())
+    base::ThreadTicks::WaitUntilInitialized();
+
+  int64_t decoded_bytes;
+  {
+    Timer timer;
+    decoded_bytes = DecodeSynchronously(input, std::move(filter));
+    if (decoded_bytes < 0) {
+      std::cerr << "Couldn't decode stdin." << std::endl;
+      return 1;
+    }
+    timer.Print("IO thread", decoded_bytes);
+  }
+
+  base::Thread worker("content_decoder_worker");
+  if (!worker.Start()) {
+    std::cerr << "Couldn't start the worker thread." << std::endl;
+    return 1;
+  }
+  {
+    Timer timer;
+    decoded_bytes = DecodeOnWorker(
+        input, Filter::Factory(filter_types, filter_context), &worker);
+    if (decoded_bytes < 0) {
+      std::cerr << "Couldn't decode stdin." << std::endl;
+      return 1;
+    }
+    timer.Print("FilterPipeline", decoded_bytes);
+  }
+
+  return 0;
+}
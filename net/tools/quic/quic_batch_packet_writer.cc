@@ -0,0 +1,189 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_batch_packet_writer.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "net/tools/quic/quic_socket_utils.h"
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace net {
+
+namespace {
+
+// The kernel accepts at most 64 segments per message, and at most 64 KB in
+// total including headers; stay well below the latter.
+const int kMaxGsoSegments = 64;
+const size_t kMaxGsoBytes = 60000;
+
+}  // namespace
+
+QuicBatchPacketWriter::QuicBatchPacketWriter(int fd)
+    : QuicDefaultPacketWriter(fd),
+      first_unsent_(0),
+      num_packets_(0),
+      use_gso_(SupportsGso(fd)) {
+  memset(mmsg_hdrs_, 0, sizeof(mmsg_hdrs_));
+}
+
+QuicBatchPacketWriter::~QuicBatchPacketWriter() {}
+
+WriteResult QuicBatchPacketWriter::WritePacket(const char* buffer,
+                                               size_t buf_len,
+                                               const IPAddress& self_address,
+                                               const IPEndPoint& peer_address,
+                                               PerPacketOptions* options) {
+  DCHECK(!IsWriteBlocked());
+  DCHECK(nullptr == options)
+      << "QuicBatchPacketWriter does not accept any options.";
+  DCHECK_LE(buf_len, kMaxPacketSize);
+  if (IsWriteBlocked() || num_packets_ == kMaxBatchedPackets)
+    return WriteResult(WRITE_STATUS_BLOCKED, EAGAIN);
+
+  BufferedPacket* packet = &packets_[num_packets_++];
+  memcpy(packet->buffer, buffer, buf_len);
+  packet->length = buf_len;
+  packet->self_address = self_address;
+  packet->peer_address = peer_address;
+
+  if (num_packets_ == kMaxBatchedPackets)
+    Flush();
+  return WriteResult(WRITE_STATUS_OK, buf_len);
+}
+
+void QuicBatchPacketWriter::SetWritable() {
+  QuicDefaultPacketWriter::SetWritable();
+  Flush();
+}
+
+void QuicBatchPacketWriter::Flush() {
+  if (IsWriteBlocked())
+    return;
+
+  while (first_unsent_ < num_packets_) {
+    int num_messages = BuildMessages();
+    int rc = SendMessages(mmsg_hdrs_, num_messages);
+    if (rc > 0) {
+      for (int i = 0; i < rc; ++i)
+        first_unsent_ += messages_[i].num_packets;
+      continue;
+    }
+
+    if (rc == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+      set_write_blocked(true);
+      return;
+    }
+    if ((errno == EIO || errno == EINVAL) && messages_[0].num_packets > 1) {
+      // The device or the route does not support segmentation offload; send
+      // the packets one by one from now on.
+      LOG(WARNING) << "Disabling UDP GSO after error: " << strerror(errno);
+      use_gso_ = false;
+      continue;
+    }
+    DVLOG(1) << "Dropping " << messages_[0].num_packets << " packet(s) to "
+             << packets_[first_unsent_].peer_address.ToString() << ": "
+             << strerror(errno);
+    first_unsent_ += messages_[0].num_packets;
+  }
+
+  first_unsent_ = 0;
+  num_packets_ = 0;
+}
+
+int QuicBatchPacketWriter::SendMessages(mmsghdr* messages,
+                                        unsigned int num_messages) {
+  int rc;
+  do {
+    rc = sendmmsg(fd(), messages, num_messages, 0);
+  } while (rc < 0 && errno == EINTR);
+  return rc;
+}
+
+// static
+bool QuicBatchPacketWriter::SupportsGso(int fd) {
+  int gso_size = 0;
+  socklen_t length = sizeof(gso_size);
+  return getsockopt(fd, SOL_UDP, UDP_SEGMENT, &gso_size, &length) == 0;
+}
+
+int QuicBatchPacketWriter::BuildMessages() {
+  int num_messages = 0;
+  int first_packet = first_unsent_;
+  while (first_packet < num_packets_) {
+    const BufferedPacket& first = packets_[first_packet];
+    int num_packets = 1;
+    size_t num_bytes = first.length;
+    // Every segment but the last must have the size of the first one.
+    while (use_gso_ && num_packets < kMaxGsoSegments &&
+           first_packet + num_packets < num_packets_) {
+      const BufferedPacket& last = packets_[first_packet + num_packets - 1];
+      const BufferedPacket& next = packets_[first_packet + num_packets];
+      if (last.length != first.length || next.length > first.length ||
+          num_bytes + next.length > kMaxGsoBytes ||
+          !(next.peer_address == first.peer_address) ||
+          next.self_address != first.self_address) {
+        break;
+      }
+      num_bytes += next.length;
+      ++num_packets;
+    }
+    BuildMessage(num_messages++, first_packet, num_packets);
+    first_packet += num_packets;
+  }
+  return num_messages;
+}
+
+void QuicBatchPacketWriter::BuildMessage(int index,
+                                         int first_packet,
+                                         int num_packets) {
+  const BufferedPacket& first = packets_[first_packet];
+  Message* message = &messages_[index];
+  message->num_packets = num_packets;
+
+  for (int i = first_packet; i < first_packet + num_packets; ++i) {
+    iovs_[i].iov_base = packets_[i].buffer;
+    iovs_[i].iov_len = packets_[i].length;
+  }
+
+  msghdr* hdr = &mmsg_hdrs_[index].msg_hdr;
+  socklen_t address_len = sizeof(message->raw_address);
+  CHECK(first.peer_address.ToSockAddr(
+      reinterpret_cast<sockaddr*>(&message->raw_address), &address_len));
+  hdr->msg_name = &message->raw_address;
+  hdr->msg_namelen = address_len;
+  hdr->msg_iov = &iovs_[first_packet];
+  hdr->msg_iovlen = num_packets;
+  hdr->msg_flags = 0;
+
+  size_t control_len = 0;
+  if (!first.self_address.empty()) {
+    cmsghdr* cmsg = reinterpret_cast<cmsghdr*>(message->cbuf);
+    QuicSocketUtils::SetIpInfoInCmsg(first.self_address, cmsg);
+    control_len += CMSG_ALIGN(cmsg->cmsg_len);
+  }
+  if (num_packets > 1) {
+    cmsghdr* cmsg = reinterpret_cast<cmsghdr*>(message->cbuf + control_len);
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    uint16_t segment_size = static_cast<uint16_t>(first.length);
+    memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    control_len += CMSG_SPACE(sizeof(uint16_t));
+  }
+  hdr->msg_control = control_len > 0 ? message->cbuf : nullptr;
+  hdr->msg_controllen = control_len;
+}
+
+}  // namespace net
@@ -0,0 +1,108 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
+#define NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "base/macros.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/quic_protocol.h"
+#include "net/tools/quic/quic_default_packet_writer.h"
+
+namespace net {
+
+// Maximum number of packets held by a QuicBatchPacketWriter before it flushes
+// them on its own.
+const int kMaxBatchedPackets = 64;
+
+// Packet writer which buffers the packets written to it, and sends them with a
+// single sendmmsg call when Flush() is called, typically once per event loop
+// iteration. Consecutive packets of the same size to the same peer are sent
+// as one message with UDP generic segmentation offload when the kernel
+// supports it, so that they also go down the stack together.
+//
+// A buffered packet is reported as written. If the socket blocks during a
+// flush, the writer becomes write blocked and keeps the packets that were not
+// sent until SetWritable() is called, which flushes them before anything else
+// is written. Packets rejected by the socket for any other reason are dropped,
+// as the connections that wrote them were already told they were sent.
+class QuicBatchPacketWriter : public QuicDefaultPacketWriter {
+ public:
+  explicit QuicBatchPacketWriter(int fd);
+  ~QuicBatchPacketWriter() override;
+
+  // QuicPacketWriter
+  WriteResult WritePacket(const char* buffer,
+                          size_t buf_len,
+                          const IPAddress& self_address,
+                          const IPEndPoint& peer_address,
+                          PerPacketOptions* options) override;
+  void SetWritable() override;
+
+  // Sends the buffered packets, until the socket blocks.
+  void Flush();
+
+  int num_buffered_packets() const { return num_packets_ - first_unsent_; }
+
+  bool use_gso() const { return use_gso_; }
+  void set_use_gso(bool use_gso) { use_gso_ = use_gso; }
+
+ protected:
+  // Sends |messages| with sendmmsg(). Returns the number of messages sent, or
+  // -1 with errno set if the first one could not be sent. Virtual for testing.
+  virtual int SendMessages(mmsghdr* messages, unsigned int num_messages);
+
+ private:
+  struct BufferedPacket {
+    char buffer[kMaxPacketSize];
+    size_t length;
+    IPAddress self_address;
+    IPEndPoint peer_address;
+  };
+
+  // Space for the packet info of either address family, plus the segment size
+  // of a message sent with GSO.
+  static const int kSpaceForCmsg = CMSG_SPACE(sizeof(in6_pktinfo)) +
+                                   CMSG_SPACE(sizeof(uint16_t));
+
+  struct Message {
+    sockaddr_storage raw_address;
+    char cbuf[kSpaceForCmsg];
+    // Number of packets sent in this message.
+    int num_packets;
+  };
+
+  // Returns true if the kernel supports UDP_SEGMENT on |fd|.
+  static bool SupportsGso(int fd);
+
+  // Fills |mmsg_hdrs_| with the packets that are not sent yet, merging them
+  // when possible. Returns the number of messages.
+  int BuildMessages();
+
+  // Fills the message at |index| with |num_packets| packets starting at
+  // |first_packet|.
+  void BuildMessage(int index, int first_packet, int num_packets);
+
+  BufferedPacket packets_[kMaxBatchedPackets];
+  iovec iovs_[kMaxBatchedPackets];
+  Message messages_[kMaxBatchedPackets];
+  mmsghdr mmsg_hdrs_[kMaxBatchedPackets];
+
+  // Packets before |first_unsent_| were sent by a flush that blocked.
+  int first_unsent_;
+  int num_packets_;
+
+  bool use_gso_;
+
+  DISALLOW_COPY_AND_ASSIGN(QuicBatchPacketWriter);
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
@@ -0,0 +1,256 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_batch_packet_writer.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "net/base/sockaddr_storage.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+namespace test {
+namespace {
+
+// Records the messages it is asked to send instead of sending them. Accepts at
+// most |accept_limit_| more messages, and fails the next call with |error_| if
+// set.
+class TestBatchPacketWriter : public QuicBatchPacketWriter {
+ public:
+  TestBatchPacketWriter()
+      : QuicBatchPacketWriter(-1),
+        accept_limit_(kMaxBatchedPackets),
+        error_(0),
+        num_calls_(0) {}
+
+  void set_accept_limit(int accept_limit) { accept_limit_ = accept_limit; }
+  void set_error(int error) { error_ = error; }
+  int num_calls() const { return num_calls_; }
+
+  // The number of packets in each message sent, in order.
+  const std::vector<size_t>& sent_messages() const { return sent_messages_; }
+  // The contents of each packet sent, in order.
+  const std::vector<std::string>& sent_packets() const {
+    return sent_packets_;
+  }
+
+ protected:
+  int SendMessages(mmsghdr* messages, unsigned int num_messages) override {
+    ++num_calls_;
+    if (error_ != 0) {
+      errno = error_;
+      error_ = 0;
+      return -1;
+    }
+    int num_sent = std::min(static_cast<int>(num_messages), accept_limit_);
+    if (num_sent == 0) {
+      errno = EAGAIN;
+      return -1;
+    }
+    for (int i = 0; i < num_sent; ++i) {
+      const msghdr& hdr = messages[i].msg_hdr;
+      sent_messages_.push_back(hdr.msg_iovlen);
+      for (size_t j = 0; j < hdr.msg_iovlen; ++j) {
+        sent_packets_.push_back(
+            std::string(static_cast<const char*>(hdr.msg_iov[j].iov_base),
+                        hdr.msg_iov[j].iov_len));
+      }
+    }
+    accept_limit_ -= num_sent;
+    return num_sent;
+  }
+
+ private:
+  int accept_limit_;
+  int error_;
+  int num_calls_;
+  std::vector<size_t> sent_messages_;
+  std::vector<std::string> sent_packets_;
+};
+
+class QuicBatchPacketWriterTest : public ::testing::Test {
+ protected:
+  QuicBatchPacketWriterTest()
+      : peer_address_(IPAddress::IPv4Localhost(), 443),
+        other_peer_address_(IPAddress::IPv4Localhost(), 444) {}
+
+  WriteResult Write(const std::string& packet, const IPEndPoint& peer) {
+    return writer_.WritePacket(packet.data(), packet.size(), IPAddress(),
+                               peer, nullptr);
+  }
+
+  IPEndPoint peer_address_;
+  IPEndPoint other_peer_address_;
+  TestBatchPacketWriter writer_;
+};
+
+TEST_F(QuicBatchPacketWriterTest, BuffersUntilFlush) {
+  writer_.set_use_gso(false);
+  WriteResult result = Write("a", peer_address_);
+  EXPECT_EQ(WRITE_STATUS_OK, result.status);
+  EXPECT_EQ(1, result.bytes_written);
+  EXPECT_EQ(WRITE_STATUS_OK, Write("bc", peer_address_).status);
+  EXPECT_EQ(2, writer_.num_buffered_packets());
+  EXPECT_EQ(0, writer_.num_calls());
+
+  writer_.Flush();
+  EXPECT_EQ(1, writer_.num_calls());
+  EXPECT_EQ(0, writer_.num_buffered_packets());
+  EXPECT_FALSE(writer_.IsWriteBlocked());
+  ASSERT_EQ(2u, writer_.sent_packets().size());
+  EXPECT_EQ("a", writer_.sent_packets()[0]);
+  EXPECT_EQ("bc", writer_.sent_packets()[1]);
+
+  // Nothing to send.
+  writer_.Flush();
+  EXPECT_EQ(1, writer_.num_calls());
+}
+
+TEST_F(QuicBatchPacketWriterTest, FlushesWhenFull) {
+  writer_.set_use_gso(false);
+  for (int i = 0; i < kMaxBatchedPackets - 1; ++i)
+    Write("a", peer_address_);
+  EXPECT_EQ(0, writer_.num_calls());
+  Write("a", peer_address_);
+  EXPECT_EQ(1, writer_.num_calls());
+  EXPECT_EQ(0, writer_.num_buffered_packets());
+  EXPECT_EQ(static_cast<size_t>(kMaxBatchedPackets),
+            writer_.sent_packets().size());
+}
+
+TEST_F(QuicBatchPacketWriterTest, WriteBlocked) {
+  writer_.set_use_gso(false);
+  Write("a", peer_address_);
+  Write("b", peer_address_);
+  Write("c", peer_address_);
+
+  writer_.set_accept_limit(1);
+  writer_.Flush();
+  EXPECT_TRUE(writer_.IsWriteBlocked());
+  EXPECT_EQ(2, writer_.num_buffered_packets());
+  EXPECT_EQ(WRITE_STATUS_BLOCKED,
+            writer_.WritePacket("d", 1, IPAddress(), peer_address_, nullptr)
+                .status);
+
+  // Flushing while blocked does not touch the socket.
+  writer_.Flush();
+  EXPECT_EQ(2, writer_.num_calls());
+
+  // The remaining packets are sent, in order, as soon as the socket is
+  // writable again.
+  writer_.set_accept_limit(kMaxBatchedPackets);
+  writer_.SetWritable();
+  EXPECT_FALSE(writer_.IsWriteBlocked());
+  EXPECT_EQ(0, writer_.num_buffered_packets());
+  ASSERT_EQ(3u, writer_.sent_packets().size());
+  EXPECT_EQ("a", writer_.sent_packets()[0]);
+  EXPECT_EQ("b", writer_.sent_packets()[1]);
+  EXPECT_EQ("c", writer_.sent_packets()[2]);
+}
+
+TEST_F(QuicBatchPacketWriterTest, MergesPacketsWithGso) {
+  writer_.set_use_gso(true);
+  const std::string kFull(100, 'a');
+  const std::string kShort(50, 'b');
+  Write(kFull, peer_address_);
+  Write(kFull, peer_address_);
+  Write(kShort, peer_address_);
+  // Cannot follow a shorter segment.
+  Write(kShort, peer_address_);
+  // Different peer.
+  Write(kShort, other_peer_address_);
+  // Cannot be longer than the first segment.
+  Write(kFull, other_peer_address_);
+  writer_.Flush();
+
+  ASSERT_EQ(4u, writer_.sent_messages().size());
+  EXPECT_EQ(3u, writer_.sent_messages()[0]);
+  EXPECT_EQ(1u, writer_.sent_messages()[1]);
+  EXPECT_EQ(1u, writer_.sent_messages()[2]);
+  EXPECT_EQ(1u, writer_.sent_messages()[3]);
+  EXPECT_EQ(6u, writer_.sent_packets().size());
+}
+
+TEST_F(QuicBatchPacketWriterTest, DisablesGsoOnError) {
+  writer_.set_use_gso(true);
+  Write("aa", peer_address_);
+  Write("bb", peer_address_);
+
+  writer_.set_error(EIO);
+  writer_.Flush();
+  EXPECT_FALSE(writer_.use_gso());
+  EXPECT_EQ(2, writer_.num_calls());
+  ASSERT_EQ(2u, writer_.sent_messages().size());
+  EXPECT_EQ(1u, writer_.sent_messages()[0]);
+  EXPECT_EQ(1u, writer_.sent_messages()[1]);
+}
+
+TEST_F(QuicBatchPacketWriterTest, DropsRejectedPackets) {
+  writer_.set_use_gso(false);
+  Write("a", peer_address_);
+  writer_.set_error(ECONNREFUSED);
+  writer_.Flush();
+  EXPECT_FALSE(writer_.IsWriteBlocked());
+  EXPECT_EQ(0, writer_.num_buffered_packets());
+  EXPECT_EQ(1, writer_.num_calls());
+}
+
+// Sends packets over a real socket, with GSO if the kernel supports it, and
+// checks that they arrive as separate datagrams.
+TEST(QuicBatchPacketWriterSocketTest, SendsOverLoopback) {
+  int receive_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+  ASSERT_LE(0, receive_fd);
+  IPEndPoint bind_address(IPAddress::IPv4Localhost(), 0);
+  SockaddrStorage storage;
+  ASSERT_TRUE(bind_address.ToSockAddr(storage.addr, &storage.addr_len));
+  ASSERT_EQ(0, bind(receive_fd, storage.addr, storage.addr_len));
+  SockaddrStorage bound;
+  ASSERT_EQ(0, getsockname(receive_fd, bound.addr, &bound.addr_len));
+  IPEndPoint receive_address;
+  ASSERT_TRUE(receive_address.FromSockAddr(bound.addr, bound.addr_len));
+
+  int send_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+  ASSERT_LE(0, send_fd);
+  QuicBatchPacketWriter writer(send_fd);
+
+  const size_t kNumPackets = 5;
+  std::vector<std::string> packets;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    // The last packet is shorter, so that it can end a GSO message.
+    size_t length = i == kNumPackets - 1 ? 100 : 1000;
+    packets.push_back(std::string(length, static_cast<char>('a' + i)));
+    EXPECT_EQ(WRITE_STATUS_OK,
+              writer
+                  .WritePacket(packets[i].data(), packets[i].size(),
+                               IPAddress(), receive_address, nullptr)
+                  .status);
+  }
+
+  // Nothing is sent before the flush.
+  char buffer[kMaxPacketSize];
+  EXPECT_GT(0, recv(receive_fd, buffer, sizeof(buffer), 0));
+  EXPECT_EQ(EAGAIN, errno);
+
+  writer.Flush();
+  EXPECT_EQ(0, writer.num_buffered_packets());
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    ssize_t rv = recv(receive_fd, buffer, sizeof(buffer), 0);
+    ASSERT_EQ(static_cast<ssize_t>(packets[i].size()), rv);
+    EXPECT_EQ(packets[i], std::string(buffer, rv));
+  }
+
+  close(send_fd);
+  close(receive_fd);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
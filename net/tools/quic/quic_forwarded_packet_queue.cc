@@ -0,0 +1,158 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_forwarded_packet_queue.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "net/tools/quic/quic_process_packet_interface.h"
+
+namespace net {
+
+// A slot holding position |p| is free when |sequence| is |p| and holds a
+// packet when it is |p| + 1. Processing the packet frees the slot for position
+// |p| + capacity.
+struct QuicForwardedPacketQueue::Slot {
+  Slot() : sequence(0), receipt_time(QuicTime::Zero()), length(0) {}
+
+  base::subtle::AtomicWord sequence;
+  IPEndPoint server_address;
+  IPEndPoint client_address;
+  QuicTime receipt_time;
+  size_t length;
+  char buffer[kMaxPacketSize];
+};
+
+QuicForwardedPacketQueue::QuicForwardedPacketQueue(size_t capacity)
+    : capacity_(capacity),
+      slots_(new Slot[capacity]),
+      push_position_(0),
+      pop_position_(0),
+      pending_(0),
+      event_fd_(-1),
+      epoll_server_(nullptr),
+      processor_(nullptr) {
+  DCHECK_GT(capacity_, 0u);
+  DCHECK_EQ(0u, capacity_ & (capacity_ - 1));
+  for (size_t i = 0; i < capacity_; ++i)
+    base::subtle::NoBarrier_Store(&slots_[i].sequence, i);
+}
+
+QuicForwardedPacketQueue::~QuicForwardedPacketQueue() {
+  if (epoll_server_)
+    epoll_server_->UnregisterFD(event_fd_);
+  if (event_fd_ >= 0)
+    close(event_fd_);
+}
+
+bool QuicForwardedPacketQueue::Initialize(EpollServer* epoll_server,
+                                          ProcessPacketInterface* processor) {
+  DCHECK(!epoll_server_);
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0) {
+    LOG(ERROR) << "eventfd() failed: " << strerror(errno);
+    return false;
+  }
+  epoll_server_ = epoll_server;
+  processor_ = processor;
+  epoll_server_->RegisterFD(event_fd_, this, EPOLLIN | EPOLLET);
+  return true;
+}
+
+bool QuicForwardedPacketQueue::Push(const IPEndPoint& server_address,
+                                    const IPEndPoint& client_address,
+                                    const QuicReceivedPacket& packet) {
+  DCHECK_LE(packet.length(), kMaxPacketSize);
+  base::subtle::AtomicWord position =
+      base::subtle::NoBarrier_Load(&push_position_);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & (capacity_ - 1)];
+    base::subtle::AtomicWord sequence =
+        base::subtle::Acquire_Load(&slot->sequence);
+    if (sequence == position) {
+      base::subtle::AtomicWord previous =
+          base::subtle::NoBarrier_CompareAndSwap(&push_position_, position,
+                                                 position + 1);
+      if (previous == position)
+        break;
+      position = previous;
+    } else if (sequence < position) {
+      // The slot still holds the packet pushed |capacity_| positions ago.
+      return false;
+    } else {
+      position = base::subtle::NoBarrier_Load(&push_position_);
+    }
+  }
+
+  slot->server_address = server_address;
+  slot->client_address = client_address;
+  slot->receipt_time = packet.receipt_time();
+  slot->length = packet.length();
+  memcpy(slot->buffer, packet.data(), packet.length());
+  base::subtle::Release_Store(&slot->sequence, position + 1);
+
+  // Only the first pending packet needs to wake up the consumer; it processes
+  // all of them.
+  if (base::subtle::Barrier_AtomicIncrement(&pending_, 1) == 1) {
+    uint64_t one = 1;
+    int rv;
+    do {
+      rv = write(event_fd_, &one, sizeof(one));
+    } while (rv < 0 && errno == EINTR);
+    DCHECK_EQ(static_cast<int>(sizeof(one)), rv);
+  }
+  return true;
+}
+
+void QuicForwardedPacketQueue::ProcessPackets() {
+  base::subtle::AtomicWord position = pop_position_;
+  base::subtle::AtomicWord pending;
+  do {
+    base::subtle::AtomicWord processed = 0;
+    for (;;) {
+      Slot* slot = &slots_[position & (capacity_ - 1)];
+      if (base::subtle::Acquire_Load(&slot->sequence) != position + 1)
+        break;
+      processor_->ProcessPacket(
+          slot->server_address, slot->client_address,
+          QuicReceivedPacket(slot->buffer, slot->length, slot->receipt_time,
+                             false));
+      base::subtle::Release_Store(&slot->sequence, position + capacity_);
+      ++position;
+      ++processed;
+    }
+    // The packets counted in |pending_| have all been written, but a packet
+    // pushed before them may still be being copied; its producer did not
+    // signal the eventfd, so wait for it here.
+    pending = base::subtle::Barrier_AtomicIncrement(&pending_, -processed);
+  } while (pending > 0);
+  pop_position_ = position;
+}
+
+void QuicForwardedPacketQueue::OnEvent(int fd, EpollEvent* event) {
+  DCHECK_EQ(fd, event_fd_);
+  if (event->in_events & EPOLLIN) {
+    // Reset the counter before processing the packets, so that a packet
+    // pushed after that signals the eventfd again.
+    uint64_t count;
+    int rv;
+    do {
+      rv = read(event_fd_, &count, sizeof(count));
+    } while (rv < 0 && errno == EINTR);
+    ProcessPackets();
+  }
+}
+
+void QuicForwardedPacketQueue::OnShutdown(EpollServer* eps, int fd) {
+  epoll_server_ = nullptr;
+}
+
+}  // namespace net
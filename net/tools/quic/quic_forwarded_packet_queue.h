@@ -0,0 +1,79 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_QUIC_QUIC_FORWARDED_PACKET_QUEUE_H_
+#define NET_TOOLS_QUIC_QUIC_FORWARDED_PACKET_QUEUE_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/quic_protocol.h"
+#include "net/tools/epoll_server/epoll_server.h"
+
+namespace net {
+
+class ProcessPacketInterface;
+
+// Hands packets read on other threads to the thread running an EpollServer.
+// Push() may be called from any thread and never blocks: packets are copied
+// into a lock-free ring of preallocated slots, and the EpollServer is woken up
+// through an eventfd when the ring was empty. The packets are then passed to
+// the processor, in the order they were pushed, from the EpollServer's thread.
+// When the ring is full, Push() drops the packet, as the socket would.
+class QuicForwardedPacketQueue : public EpollCallbackInterface {
+ public:
+  // |capacity| must be a power of two.
+  explicit QuicForwardedPacketQueue(size_t capacity);
+  ~QuicForwardedPacketQueue() override;
+
+  // Starts passing the packets pushed to |processor|, when |epoll_server|
+  // handles events. Returns false if the eventfd cannot be created.
+  bool Initialize(EpollServer* epoll_server,
+                  ProcessPacketInterface* processor);
+
+  // Copies |packet| to the queue. Returns false, dropping |packet|, if the
+  // queue is full. Thread-safe.
+  bool Push(const IPEndPoint& server_address,
+            const IPEndPoint& client_address,
+            const QuicReceivedPacket& packet);
+
+  // Passes the queued packets to the processor. Called on the EpollServer's
+  // thread.
+  void ProcessPackets();
+
+  // EpollCallbackInterface
+  void OnRegistration(EpollServer* eps, int fd, int event_mask) override {}
+  void OnModification(int fd, int event_mask) override {}
+  void OnEvent(int fd, EpollEvent* event) override;
+  void OnUnregistration(int fd, bool replaced) override {}
+  void OnShutdown(EpollServer* eps, int fd) override;
+
+ private:
+  struct Slot;
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // The position of the next slot to fill, incremented by the producers.
+  base::subtle::AtomicWord push_position_;
+  // The position of the next slot to process. Only used by the consumer.
+  base::subtle::AtomicWord pop_position_;
+  // The number of packets pushed and not processed yet. The producer taking
+  // it from zero signals the eventfd.
+  base::subtle::AtomicWord pending_;
+
+  int event_fd_;
+  EpollServer* epoll_server_;
+  ProcessPacketInterface* processor_;
+
+  DISALLOW_COPY_AND_ASSIGN(QuicForwardedPacketQueue);
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_QUIC_FORWARDED_PACKET_QUEUE_H_
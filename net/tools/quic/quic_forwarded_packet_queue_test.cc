@@ -0,0 +1,163 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_forwarded_packet_queue.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "net/base/ip_address.h"
+#include "net/tools/epoll_server/epoll_server.h"
+#include "net/tools/quic/quic_process_packet_interface.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+namespace test {
+namespace {
+
+class RecordingProcessor : public ProcessPacketInterface {
+ public:
+  void ProcessPacket(const IPEndPoint& server_address,
+                     const IPEndPoint& client_address,
+                     const QuicReceivedPacket& packet) override {
+    client_addresses_.push_back(client_address);
+    packets_.push_back(std::string(packet.data(), packet.length()));
+  }
+
+  const std::vector<IPEndPoint>& client_addresses() const {
+    return client_addresses_;
+  }
+  const std::vector<std::string>& packets() const { return packets_; }
+
+ private:
+  std::vector<IPEndPoint> client_addresses_;
+  std::vector<std::string> packets_;
+};
+
+const size_t kQueueCapacity = 16;
+
+// Pushes |num_packets| packets whose contents are their index, from client
+// port |port|, retrying those dropped because the queue is full.
+class Pusher : public base::DelegateSimpleThread::Delegate {
+ public:
+  Pusher(QuicForwardedPacketQueue* queue, uint16_t port, int num_packets)
+      : queue_(queue), port_(port), num_packets_(num_packets) {}
+
+  void Run() override {
+    IPEndPoint server_address(IPAddress::IPv4Localhost(), 443);
+    IPEndPoint client_address(IPAddress::IPv4Localhost(), port_);
+    for (int i = 0; i < num_packets_; ++i) {
+      std::string data = base::IntToString(i);
+      while (!queue_->Push(server_address, client_address,
+                           QuicReceivedPacket(data.data(), data.size(),
+                                              QuicTime::Zero()))) {
+        base::PlatformThread::YieldCurrentThread();
+      }
+    }
+  }
+
+ private:
+  QuicForwardedPacketQueue* queue_;
+  uint16_t port_;
+  int num_packets_;
+};
+
+class QuicForwardedPacketQueueTest : public ::testing::Test {
+ protected:
+  QuicForwardedPacketQueueTest() : queue_(kQueueCapacity) {}
+
+  void SetUp() override {
+    epoll_server_.set_timeout_in_us(50 * 1000);
+    ASSERT_TRUE(queue_.Initialize(&epoll_server_, &processor_));
+  }
+
+  // Destroyed after |queue_|, which unregisters from it.
+  EpollServer epoll_server_;
+  RecordingProcessor processor_;
+  QuicForwardedPacketQueue queue_;
+};
+
+TEST_F(QuicForwardedPacketQueueTest, ProcessesPacketsInOrder) {
+  Pusher pusher(&queue_, 1000, 3);
+  pusher.Run();
+  EXPECT_TRUE(processor_.packets().empty());
+
+  epoll_server_.WaitForEventsAndExecuteCallbacks();
+  ASSERT_EQ(3u, processor_.packets().size());
+  EXPECT_EQ("0", processor_.packets()[0]);
+  EXPECT_EQ("1", processor_.packets()[1]);
+  EXPECT_EQ("2", processor_.packets()[2]);
+  EXPECT_EQ(1000, processor_.client_addresses()[0].port());
+
+  // Packets pushed after the queue was drained wake it up again.
+  pusher.Run();
+  epoll_server_.WaitForEventsAndExecuteCallbacks();
+  EXPECT_EQ(6u, processor_.packets().size());
+}
+
+TEST_F(QuicForwardedPacketQueueTest, DropsPacketsWhenFull) {
+  IPEndPoint server_address(IPAddress::IPv4Localhost(), 443);
+  IPEndPoint client_address(IPAddress::IPv4Localhost(), 1000);
+  for (size_t i = 0; i < kQueueCapacity; ++i) {
+    std::string data = base::SizeTToString(i);
+    EXPECT_TRUE(queue_.Push(
+        server_address, client_address,
+        QuicReceivedPacket(data.data(), data.size(), QuicTime::Zero())));
+  }
+  EXPECT_FALSE(queue_.Push(
+      server_address, client_address,
+      QuicReceivedPacket("x", 1, QuicTime::Zero())));
+
+  epoll_server_.WaitForEventsAndExecuteCallbacks();
+  ASSERT_EQ(kQueueCapacity, processor_.packets().size());
+  EXPECT_EQ("0", processor_.packets().front());
+  EXPECT_EQ(base::SizeTToString(kQueueCapacity - 1),
+            processor_.packets().back());
+
+  // The slots are reused once processed.
+  EXPECT_TRUE(queue_.Push(server_address, client_address,
+                          QuicReceivedPacket("y", 1, QuicTime::Zero())));
+  epoll_server_.WaitForEventsAndExecuteCallbacks();
+  ASSERT_EQ(kQueueCapacity + 1, processor_.packets().size());
+  EXPECT_EQ("y", processor_.packets().back());
+}
+
+TEST_F(QuicForwardedPacketQueueTest, PushFromManyThreads) {
+  const int kNumThreads = 4;
+  const int kNumPackets = 1000;
+  std::vector<std::unique_ptr<Pusher>> pushers;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    pushers.push_back(std::unique_ptr<Pusher>(
+        new Pusher(&queue_, static_cast<uint16_t>(1000 + i), kNumPackets)));
+    threads.push_back(std::unique_ptr<base::DelegateSimpleThread>(
+        new base::DelegateSimpleThread(pushers.back().get(), "pusher")));
+    threads.back()->Start();
+  }
+
+  while (processor_.packets().size() <
+         static_cast<size_t>(kNumThreads * kNumPackets)) {
+    epoll_server_.WaitForEventsAndExecuteCallbacks();
+  }
+  for (const auto& thread : threads)
+    thread->Join();
+
+  // The packets of each thread are processed in the order they were pushed.
+  std::vector<int> next_packet(kNumThreads, 0);
+  for (size_t i = 0; i < processor_.packets().size(); ++i) {
+    int thread = processor_.client_addresses()[i].port() - 1000;
+    ASSERT_LE(0, thread);
+    ASSERT_GT(kNumThreads, thread);
+    EXPECT_EQ(base::IntToString(next_packet[thread]++),
+              processor_.packets()[i]);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
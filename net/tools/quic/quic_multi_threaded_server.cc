@@ -0,0 +1,296 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_multi_threaded_server.h"
+
+#include <errno.h>
+#include <linux/filter.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "net/quic/crypto/crypto_server_config_protobuf.h"
+#include "net/quic/crypto/quic_random.h"
+#include "net/quic/quic_clock.h"
+#include "net/tools/quic/quic_dispatcher.h"
+#include "net/tools/quic/quic_forwarded_packet_queue.h"
+#include "net/tools/quic/quic_process_packet_interface.h"
+#include "net/tools/quic/quic_server.h"
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+#ifndef BPF_MOD
+#define BPF_MOD 0x90
+#endif
+
+#ifndef BPF_XOR
+#define BPF_XOR 0xa0
+#endif
+
+namespace net {
+
+namespace {
+
+// The number of packets another worker can queue for a worker before the
+// next ones are dropped.
+const size_t kForwardedPacketQueueSize = 512;
+
+}  // namespace
+
+class QuicMultiThreadedServer::Worker
+    : public QuicServer,
+      public ProcessPacketInterface,
+      public base::DelegateSimpleThread::Delegate {
+ public:
+  Worker(QuicMultiThreadedServer* owner,
+         int index,
+         ProofSource* proof_source,
+         const QuicConfig& config,
+         const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+         const QuicVersionVector& supported_versions,
+         QuicServerConfigProtobuf* server_config)
+      : QuicServer(proof_source,
+                   config,
+                   crypto_config_options,
+                   supported_versions,
+                   server_config),
+        owner_(owner),
+        index_(index),
+        quit_(true, false),
+        forwarded_packets_(kForwardedPacketQueueSize),
+        packets_processed_(0),
+        packets_forwarded_(0),
+        forwarded_packets_dropped_(0) {
+    set_reuse_port(true);
+  }
+
+  ~Worker() override {}
+
+  bool Listen(const IPEndPoint& address) {
+    return CreateUDPSocketAndListen(address) &&
+           forwarded_packets_.Initialize(epoll_server(), this);
+  }
+
+  // Makes Run() return. Thread-safe.
+  void Quit() {
+    quit_.Signal();
+    epoll_server()->Wake();
+  }
+
+  // Queues a packet read by another worker. Returns false if the packet was
+  // dropped because too many are queued. Thread-safe.
+  bool Forward(const IPEndPoint& server_address,
+               const IPEndPoint& client_address,
+               const QuicReceivedPacket& packet) {
+    return forwarded_packets_.Push(server_address, client_address, packet);
+  }
+
+  int socket_fd() { return fd(); }
+
+  QuicPacketCount packets_processed() const {
+    return base::subtle::NoBarrier_Load(&packets_processed_);
+  }
+  QuicPacketCount packets_forwarded() const {
+    return base::subtle::NoBarrier_Load(&packets_forwarded_);
+  }
+  QuicPacketCount forwarded_packets_dropped() const {
+    return base::subtle::NoBarrier_Load(&forwarded_packets_dropped_);
+  }
+
+  // base::DelegateSimpleThread::Delegate
+  void Run() override {
+    while (!quit_.IsSignaled())
+      WaitForEvents();
+    QuicServer::Shutdown();
+  }
+
+  // ProcessPacketInterface
+  void ProcessPacket(const IPEndPoint& server_address,
+                     const IPEndPoint& client_address,
+                     const QuicReceivedPacket& packet) override {
+    int worker = GetWorkerForPacket(packet.data(), packet.length(),
+                                    owner_->num_workers());
+    if (worker >= 0 && worker != index_) {
+      if (owner_->workers_[worker]->Forward(server_address, client_address,
+                                            packet)) {
+        Increment(&packets_forwarded_);
+      } else {
+        Increment(&forwarded_packets_dropped_);
+      }
+      return;
+    }
+    Increment(&packets_processed_);
+    dispatcher()->ProcessPacket(server_address, client_address, packet);
+  }
+
+ protected:
+  // QuicServer
+  ProcessPacketInterface* GetPacketProcessor() override { return this; }
+
+ private:
+  // Only this worker's thread writes its counters, so no atomic
+  // read-modify-write is needed for other threads to read them.
+  static void Increment(base::subtle::AtomicWord* counter) {
+    base::subtle::NoBarrier_Store(counter,
+                                  base::subtle::NoBarrier_Load(counter) + 1);
+  }
+
+  QuicMultiThreadedServer* owner_;
+  const int index_;
+  base::WaitableEvent quit_;
+  QuicForwardedPacketQueue forwarded_packets_;
+  base::subtle::AtomicWord packets_processed_;
+  base::subtle::AtomicWord packets_forwarded_;
+  base::subtle::AtomicWord forwarded_packets_dropped_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+QuicMultiThreadedServer::QuicMultiThreadedServer(
+    int num_workers,
+    const ProofSourceFactory& proof_source_factory,
+    const QuicConfig& config,
+    const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+    const QuicVersionVector& supported_versions) {
+  DCHECK_GT(num_workers, 0);
+  // Every worker serves the same server config, so that a client can do a
+  // 0-RTT handshake with any of them using the one it cached. Source-address
+  // tokens are already accepted by all of them since they share their secret.
+  QuicClock clock;
+  std::unique_ptr<QuicServerConfigProtobuf> server_config(
+      QuicCryptoServerConfig::GenerateConfig(QuicRandom::GetInstance(), &clock,
+                                             crypto_config_options));
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.push_back(std::unique_ptr<Worker>(new Worker(
+        this, i, proof_source_factory.Run(), config, crypto_config_options,
+        supported_versions, server_config.get())));
+  }
+}
+
+QuicMultiThreadedServer::~QuicMultiThreadedServer() {
+  Shutdown();
+}
+
+void QuicMultiThreadedServer::set_batch_writes(bool batch_writes) {
+  for (const auto& worker : workers_)
+    worker->set_batch_writes(batch_writes);
+}
+
+void QuicMultiThreadedServer::SetStrikeRegisterNoStartupPeriod() {
+  for (const auto& worker : workers_)
+    worker->SetStrikeRegisterNoStartupPeriod();
+}
+
+bool QuicMultiThreadedServer::Start(const IPEndPoint& address) {
+  DCHECK(threads_.empty());
+  // The sockets join the SO_REUSEPORT group in this order, which is also the
+  // order the steering program indexes them in.
+  if (!workers_[0]->Listen(address))
+    return false;
+  IPEndPoint bound_address(address.address(), workers_[0]->port());
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    if (!workers_[i]->Listen(bound_address))
+      return false;
+  }
+
+  if (workers_.size() > 1 &&
+      !AttachSteeringProgram(workers_[0]->socket_fd(), num_workers())) {
+    LOG(WARNING) << "Unable to steer packets by connection ID ("
+                 << strerror(errno) << "); forwarding them between workers.";
+  }
+
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    base::DelegateSimpleThread* thread = new base::DelegateSimpleThread(
+        workers_[i].get(), "quic_server_worker_" + base::SizeTToString(i));
+    threads_.push_back(std::unique_ptr<base::DelegateSimpleThread>(thread));
+    thread->Start();
+  }
+  return true;
+}
+
+void QuicMultiThreadedServer::Shutdown() {
+  if (threads_.empty())
+    return;
+  for (const auto& worker : workers_)
+    worker->Quit();
+  for (const auto& thread : threads_)
+    thread->Join();
+  threads_.clear();
+}
+
+int QuicMultiThreadedServer::port() const {
+  return workers_[0]->port();
+}
+
+QuicPacketCount QuicMultiThreadedServer::packets_processed() const {
+  QuicPacketCount packets = 0;
+  for (const auto& worker : workers_)
+    packets += worker->packets_processed();
+  return packets;
+}
+
+QuicPacketCount QuicMultiThreadedServer::packets_forwarded() const {
+  QuicPacketCount packets = 0;
+  for (const auto& worker : workers_)
+    packets += worker->packets_forwarded();
+  return packets;
+}
+
+QuicPacketCount QuicMultiThreadedServer::forwarded_packets_dropped() const {
+  QuicPacketCount packets = 0;
+  for (const auto& worker : workers_)
+    packets += worker->forwarded_packets_dropped();
+  return packets;
+}
+
+// static
+int QuicMultiThreadedServer::GetWorkerForPacket(const char* data,
+                                                size_t length,
+                                                int num_workers) {
+  // The connection ID follows the public flags. Its first four bytes, read in
+  // network order as the BPF program does, are folded so that every byte
+  // affects the result.
+  if (length < 5 || !(data[0] & PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID))
+    return -1;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  uint32_t key = (static_cast<uint32_t>(bytes[1]) << 24) |
+                 (static_cast<uint32_t>(bytes[2]) << 16) |
+                 (static_cast<uint32_t>(bytes[3]) << 8) |
+                 static_cast<uint32_t>(bytes[4]);
+  key ^= key >> 16;
+  key ^= key >> 8;
+  return static_cast<int>(key % static_cast<uint32_t>(num_workers));
+}
+
+// static
+bool QuicMultiThreadedServer::AttachSteeringProgram(int fd, int num_workers) {
+  // Returns an out of range index, which makes the kernel fall back to its
+  // own hash, for packets without a connection ID.
+  sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+      BPF_STMT(BPF_ALU | BPF_AND | BPF_K,
+               PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 9, 0),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 1),
+      BPF_STMT(BPF_MISC | BPF_TAX, 0),
+      BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+      BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+      BPF_STMT(BPF_MISC | BPF_TAX, 0),
+      BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 8),
+      BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(num_workers)),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+      BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+  };
+  sock_fprog program = {static_cast<unsigned short>(arraysize(code)), code};
+  return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program,
+                    sizeof(program)) == 0;
+}
+
+}  // namespace net
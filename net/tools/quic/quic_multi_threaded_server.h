@@ -0,0 +1,101 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A QUIC server running one QuicServer per thread on the same address.
+
+#ifndef NET_TOOLS_QUIC_QUIC_MULTI_THREADED_SERVER_H_
+#define NET_TOOLS_QUIC_QUIC_MULTI_THREADED_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/threading/simple_thread.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/crypto/quic_crypto_server_config.h"
+#include "net/quic/quic_config.h"
+#include "net/quic/quic_protocol.h"
+
+namespace net {
+
+class ProofSource;
+
+// Runs |num_workers| QuicServers, each on its own thread with its own
+// SO_REUSEPORT socket, dispatcher and time-wait list. The kernel spreads the
+// packets over the sockets. Each connection is owned by one worker, picked
+// from its connection ID, so that it keeps being served by the same worker
+// when the client's address changes: a classic BPF program steers packets to
+// the owner's socket when the kernel supports it, and packets that still land
+// on another worker are handed off to the owner through a bounded lock-free
+// queue. The workers serve the same server config.
+//
+// The workers share QuicInMemoryCache::GetInstance(), which must not be
+// modified once they have started.
+class QuicMultiThreadedServer {
+ public:
+  // Returns a new ProofSource for a worker.
+  typedef base::Callback<ProofSource*()> ProofSourceFactory;
+
+  QuicMultiThreadedServer(
+      int num_workers,
+      const ProofSourceFactory& proof_source_factory,
+      const QuicConfig& config,
+      const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+      const QuicVersionVector& supported_versions);
+
+  // Stops the workers if they are still running.
+  ~QuicMultiThreadedServer();
+
+  // Makes every worker batch its writes. Must be called before Start().
+  void set_batch_writes(bool batch_writes);
+
+  void SetStrikeRegisterNoStartupPeriod();
+
+  // Listens on |address| and starts the worker threads.
+  bool Start(const IPEndPoint& address);
+
+  // Stops and joins the worker threads.
+  void Shutdown();
+
+  int num_workers() const { return static_cast<int>(workers_.size()); }
+
+  // The port the workers listen on, once started.
+  int port() const;
+
+  // Number of packets processed by the workers' dispatchers, number of
+  // packets handed off to another worker, and number of packets dropped
+  // because the queue of the worker they were handed off to was full. May be
+  // read while running.
+  QuicPacketCount packets_processed() const;
+  QuicPacketCount packets_forwarded() const;
+  QuicPacketCount forwarded_packets_dropped() const;
+
+  // Returns the index of the worker owning the connection |data| belongs to,
+  // or -1 if |data| has no connection ID, in which case any worker can
+  // process it. Matches the BPF program attached to the sockets.
+  static int GetWorkerForPacket(const char* data,
+                                size_t length,
+                                int num_workers);
+
+ private:
+  class Worker;
+
+  // Attaches the program picking the socket of the owning worker to the
+  // group of sockets |fd| belongs to. Returns false if the kernel does not
+  // support it.
+  static bool AttachSteeringProgram(int fd, int num_workers);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(QuicMultiThreadedServer);
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_QUIC_MULTI_THREADED_SERVER_H_
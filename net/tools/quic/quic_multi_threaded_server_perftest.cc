@@ -0,0 +1,152 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures how the number of packets QuicMultiThreadedServer processes per
+// second scales with its number of workers. Sender threads flood the server
+// over loopback with packets carrying random connection IDs and an
+// unsupported version, each of which the server answers with a version
+// negotiation packet.
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/rand_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/quic/crypto/proof_source.h"
+#include "net/quic/test_tools/crypto_test_utils.h"
+#include "net/quic/test_tools/quic_test_utils.h"
+#include "net/tools/quic/quic_multi_threaded_server.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+namespace test {
+namespace {
+
+const int kNumSenders = 8;
+const int kPacketsPerSendmmsg = 32;
+const size_t kPacketSize = 1200;
+const int kWarmUpMs = 500;
+const int kMeasurementMs = 2000;
+
+ProofSource* CreateProofSource() {
+  return CryptoTestUtils::ProofSourceForTesting();
+}
+
+// Sends packets to |server_address| as fast as it can until stopped.
+class PacketSender : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit PacketSender(const IPEndPoint& server_address)
+      : server_address_(server_address), stop_(0) {}
+
+  void Stop() { base::subtle::NoBarrier_Store(&stop_, 1); }
+
+  void Run() override {
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ASSERT_LE(0, fd);
+    SockaddrStorage storage;
+    ASSERT_TRUE(server_address_.ToSockAddr(storage.addr, &storage.addr_len));
+    ASSERT_EQ(0, connect(fd, storage.addr, storage.addr_len));
+
+    std::vector<std::string> packets(kPacketsPerSendmmsg);
+    std::vector<iovec> iovs(kPacketsPerSendmmsg);
+    std::vector<mmsghdr> messages(kPacketsPerSendmmsg);
+    memset(messages.data(), 0, messages.size() * sizeof(mmsghdr));
+    for (int i = 0; i < kPacketsPerSendmmsg; ++i) {
+      packets[i].assign(kPacketSize, '\0');
+      packets[i][0] = PACKET_PUBLIC_FLAGS_VERSION |
+                      PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID;
+      // An unsupported version follows the connection ID.
+      memcpy(&packets[i][9], "Q000", 4);
+      iovs[i].iov_base = &packets[i][0];
+      iovs[i].iov_len = packets[i].size();
+      messages[i].msg_hdr.msg_iov = &iovs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (!base::subtle::NoBarrier_Load(&stop_)) {
+      for (int i = 0; i < kPacketsPerSendmmsg; ++i) {
+        uint64_t connection_id = base::RandUint64();
+        memcpy(&packets[i][1], &connection_id, sizeof(connection_id));
+      }
+      if (sendmmsg(fd, messages.data(), kPacketsPerSendmmsg, 0) < 0 &&
+          errno != EAGAIN && errno != ENOBUFS && errno != ECONNREFUSED) {
+        ADD_FAILURE() << "sendmmsg failed: " << strerror(errno);
+        break;
+      }
+    }
+    close(fd);
+  }
+
+ private:
+  IPEndPoint server_address_;
+  base::subtle::Atomic32 stop_;
+};
+
+void MeasurePacketsPerSecond(int num_workers) {
+  QuicMultiThreadedServer server(num_workers, base::Bind(&CreateProofSource),
+                                 QuicConfig(),
+                                 QuicCryptoServerConfig::ConfigOptions(),
+                                 QuicSupportedVersions());
+  ASSERT_TRUE(server.Start(IPEndPoint(Loopback4(), 0)));
+  IPEndPoint server_address(Loopback4(), server.port());
+
+  std::vector<std::unique_ptr<PacketSender>> senders;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumSenders; ++i) {
+    senders.push_back(
+        std::unique_ptr<PacketSender>(new PacketSender(server_address)));
+    threads.push_back(std::unique_ptr<base::DelegateSimpleThread>(
+        new base::DelegateSimpleThread(senders.back().get(), "sender")));
+    threads.back()->Start();
+  }
+
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(kWarmUpMs));
+  QuicPacketCount processed = server.packets_processed();
+  QuicPacketCount forwarded = server.packets_forwarded();
+  QuicPacketCount dropped = server.forwarded_packets_dropped();
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromMilliseconds(kMeasurementMs));
+  processed = server.packets_processed() - processed;
+  forwarded = server.packets_forwarded() - forwarded;
+  dropped = server.forwarded_packets_dropped() - dropped;
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  for (const auto& sender : senders)
+    sender->Stop();
+  for (const auto& thread : threads)
+    thread->Join();
+  server.Shutdown();
+
+  std::string trace = base::StringPrintf("workers_%d", num_workers);
+  perf_test::PrintResult("quic_server_packets", "", trace,
+                         processed / elapsed.InSecondsF(), "packets/s", true);
+  perf_test::PrintResult("quic_server_forwarded_packets", "", trace,
+                         forwarded / elapsed.InSecondsF(), "packets/s", false);
+  perf_test::PrintResult("quic_server_dropped_forwarded_packets", "", trace,
+                         dropped / elapsed.InSecondsF(), "packets/s", false);
+}
+
+TEST(QuicMultiThreadedServerPerfTest, PacketsPerSecond) {
+  for (int num_workers = 1; num_workers <= 16; num_workers *= 2)
+    MeasurePacketsPerSecond(num_workers);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
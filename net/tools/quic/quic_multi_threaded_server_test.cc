@@ -0,0 +1,133 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_multi_threaded_server.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <set>
+
+#include "base/bind.h"
+#include "net/quic/crypto/proof_source.h"
+#include "net/quic/test_tools/crypto_test_utils.h"
+#include "net/quic/test_tools/quic_test_utils.h"
+#include "net/tools/quic/quic_in_memory_cache.h"
+#include "net/tools/quic/test_tools/quic_in_memory_cache_peer.h"
+#include "net/tools/quic/test_tools/quic_test_client.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+namespace test {
+namespace {
+
+// Returns a packet header with |flags| and connection ID |connection_id|.
+std::string MakePacket(uint8_t flags, uint64_t connection_id) {
+  std::string packet(1, static_cast<char>(flags));
+  packet.append(reinterpret_cast<const char*>(&connection_id),
+                sizeof(connection_id));
+  packet.append(6, '\0');
+  return packet;
+}
+
+int GetWorker(const std::string& packet, int num_workers) {
+  return QuicMultiThreadedServer::GetWorkerForPacket(
+      packet.data(), packet.size(), num_workers);
+}
+
+TEST(QuicMultiThreadedServerTest, PacketsWithoutConnectionIdHaveNoOwner) {
+  EXPECT_EQ(-1, GetWorker(MakePacket(PACKET_PUBLIC_FLAGS_NONE, 42), 4));
+  EXPECT_EQ(-1, GetWorker(std::string(), 4));
+  EXPECT_EQ(-1, GetWorker(std::string(1, '\x08'), 4));
+}
+
+TEST(QuicMultiThreadedServerTest, OwnerDependsOnConnectionIdOnly) {
+  const int kNumWorkers = 8;
+  for (uint64_t connection_id = 0; connection_id < 100; ++connection_id) {
+    std::string packet =
+        MakePacket(PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID, connection_id);
+    int worker = GetWorker(packet, kNumWorkers);
+    EXPECT_LE(0, worker);
+    EXPECT_GT(kNumWorkers, worker);
+
+    // Other flags and the rest of the packet do not matter.
+    std::string other = MakePacket(PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID |
+                                       PACKET_PUBLIC_FLAGS_VERSION,
+                                   connection_id);
+    other.append("payload");
+    EXPECT_EQ(worker, GetWorker(other, kNumWorkers));
+  }
+}
+
+TEST(QuicMultiThreadedServerTest, SequentialConnectionIdsAreSpread) {
+  const int kNumWorkers = 16;
+  std::set<int> workers;
+  for (uint64_t connection_id = 0; connection_id < 256; ++connection_id) {
+    workers.insert(GetWorker(
+        MakePacket(PACKET_PUBLIC_FLAGS_8BYTE_CONNECTION_ID, connection_id),
+        kNumWorkers));
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumWorkers), workers.size());
+}
+
+ProofSource* CreateProofSource() {
+  return CryptoTestUtils::ProofSourceForTesting();
+}
+
+TEST(QuicMultiThreadedServerTest, ServesRequests) {
+  QuicInMemoryCache::GetInstance()->AddSimpleResponse("www.google.com", "/foo",
+                                                      200, "foo");
+  QuicMultiThreadedServer server(4, base::Bind(&CreateProofSource),
+                                 QuicConfig(),
+                                 QuicCryptoServerConfig::ConfigOptions(),
+                                 QuicSupportedVersions());
+  server.SetStrikeRegisterNoStartupPeriod();
+  ASSERT_TRUE(server.Start(IPEndPoint(Loopback4(), 0)));
+
+  // Whichever socket the kernel picks, each connection is served.
+  for (int i = 0; i < 8; ++i) {
+    QuicTestClient client(IPEndPoint(Loopback4(), server.port()),
+                          "example.com", QuicSupportedVersions());
+    client.Connect();
+    EXPECT_EQ("foo", client.SendSynchronousRequest("/foo"));
+  }
+
+  server.Shutdown();
+  EXPECT_LT(0u, server.packets_processed());
+  QuicInMemoryCachePeer::ResetForTests();
+}
+
+TEST(QuicMultiThreadedServerTest, WorkersShareServerConfig) {
+  QuicInMemoryCache::GetInstance()->AddSimpleResponse("www.google.com", "/foo",
+                                                      200, "foo");
+  QuicMultiThreadedServer server(4, base::Bind(&CreateProofSource),
+                                 QuicConfig(),
+                                 QuicCryptoServerConfig::ConfigOptions(),
+                                 QuicSupportedVersions());
+  server.SetStrikeRegisterNoStartupPeriod();
+  ASSERT_TRUE(server.Start(IPEndPoint(Loopback4(), 0)));
+
+  // Each connection gets a new connection ID, and so most likely another
+  // worker, but the server config cached by the first one stays valid.
+  QuicTestClient client(IPEndPoint(Loopback4(), server.port()), "example.com",
+                        QuicSupportedVersions());
+  client.Connect();
+  EXPECT_EQ("foo", client.SendSynchronousRequest("/foo"));
+  for (int i = 0; i < 8; ++i) {
+    client.Disconnect();
+    client.Connect();
+    EXPECT_EQ("foo", client.SendSynchronousRequest("/foo"));
+    if (client.client()->session()->connection()->version() >
+        QUIC_VERSION_32) {
+      EXPECT_EQ(1, client.client()->GetNumSentClientHellos());
+    }
+  }
+
+  server.Shutdown();
+  QuicInMemoryCachePeer::ResetForTests();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
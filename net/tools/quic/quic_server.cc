@@ -16,11 +16,13 @@
 #include "net/base/ip_endpoint.h"
 #include "net/base/sockaddr_storage.h"
 #include "net/quic/crypto/crypto_handshake.h"
+#include "net/quic/crypto/crypto_server_config_protobuf.h"
 #include "net/quic/crypto/quic_random.h"
 #include "net/quic/quic_clock.h"
 #include "net/quic/quic_crypto_stream.h"
 #include "net/quic/quic_data_reader.h"
 #include "net/quic/quic_protocol.h"
+#include "net/tools/quic/quic_batch_packet_writer.h"
 #include "net/tools/quic/quic_dispatcher.h"
 #include "net/tools/quic/quic_epoll_alarm_factory.h"
 #include "net/tools/quic/quic_epoll_clock.h"
@@ -57,9 +59,24 @@ QuicServer::QuicServer(
     const QuicConfig& config,
     const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
     const QuicVersionVector& supported_versions)
+    : QuicServer(proof_source,
+                 config,
+                 crypto_config_options,
+                 supported_versions,
+                 nullptr) {}
+
+QuicServer::QuicServer(
+    ProofSource* proof_source,
+    const QuicConfig& config,
+    const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+    const QuicVersionVector& supported_versions,
+    QuicServerConfigProtobuf* server_config)
     : port_(0),
       fd_(-1),
       packets_dropped_(0),
+      batch_writes_(false),
+      batch_writer_(nullptr),
+      reuse_port_(false),
       overflow_supported_(false),
       config_(config),
       crypto_config_(kSourceAddressTokenSecret,
@@ -68,10 +85,10 @@ QuicServer::QuicServer(
       crypto_config_options_(crypto_config_options),
       supported_versions_(supported_versions),
       packet_reader_(new QuicPacketReader()) {
-  Initialize();
+  Initialize(server_config);
 }
 
-void QuicServer::Initialize() {
+void QuicServer::Initialize(QuicServerConfigProtobuf* server_config) {
   // If an initial flow control window has not explicitly been set, then use a
   // sensible value for a server: 1 MB for session, 64 KB for each stream.
   const uint32_t kInitialSessionFlowControlWindow = 1 * 1024 * 1024;  // 1 MB
@@ -96,8 +113,14 @@ void QuicServer::Initialize() {
 
   QuicEpollClock clock(&epoll_server_);
 
-  std::unique_ptr<CryptoHandshakeMessage> scfg(crypto_config_.AddDefaultConfig(
-      QuicRandom::GetInstance(), &clock, crypto_config_options_));
+  std::unique_ptr<CryptoHandshakeMessage> scfg;
+  if (server_config) {
+    scfg.reset(crypto_config_.AddConfig(server_config, clock.WallNow()));
+    DCHECK(scfg);
+  } else {
+    scfg.reset(crypto_config_.AddDefaultConfig(
+        QuicRandom::GetInstance(), &clock, crypto_config_options_));
+  }
 }
 
 QuicServer::~QuicServer() {}
@@ -109,6 +132,15 @@ bool QuicServer::CreateUDPSocketAndListen(const IPEndPoint& address) {
     return false;
   }
 
+  if (reuse_port_) {
+    int reuse_port = 1;
+    if (setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &reuse_port,
+                   sizeof(reuse_port)) < 0) {
+      LOG(ERROR) << "Failed to set SO_REUSEPORT: " << strerror(errno);
+      return false;
+    }
+  }
+
   sockaddr_storage raw_addr;
   socklen_t raw_addr_len = sizeof(raw_addr);
   CHECK(address.ToSockAddr(reinterpret_cast<sockaddr*>(&raw_addr),
@@ -141,6 +173,10 @@ bool QuicServer::CreateUDPSocketAndListen(const IPEndPoint& address) {
 }
 
 QuicDefaultPacketWriter* QuicServer::CreateWriter(int fd) {
+  if (batch_writes_) {
+    batch_writer_ = new QuicBatchPacketWriter(fd);
+    return batch_writer_;
+  }
   return new QuicDefaultPacketWriter(fd);
 }
 
@@ -154,14 +190,22 @@ QuicDispatcher* QuicServer::CreateQuicDispatcher() {
           new QuicEpollAlarmFactory(&epoll_server_)));
 }
 
+ProcessPacketInterface* QuicServer::GetPacketProcessor() {
+  return dispatcher_.get();
+}
+
 void QuicServer::WaitForEvents() {
   epoll_server_.WaitForEventsAndExecuteCallbacks();
+  if (batch_writer_)
+    batch_writer_->Flush();
 }
 
 void QuicServer::Shutdown() {
   // Before we shut down the epoll server, give all active sessions a chance to
   // notify clients that they're closing.
   dispatcher_->Shutdown();
+  if (batch_writer_)
+    batch_writer_->Flush();
 
   close(fd_);
   fd_ = -1;
@@ -176,7 +220,7 @@ void QuicServer::OnEvent(int fd, EpollEvent* event) {
     bool more_to_read = true;
     while (more_to_read) {
       more_to_read = packet_reader_->ReadAndDispatchPackets(
-          fd_, port_, QuicEpollClock(&epoll_server_), dispatcher_.get(),
+          fd_, port_, QuicEpollClock(&epoll_server_), GetPacketProcessor(),
           overflow_supported_ ? &packets_dropped_ : nullptr);
     }
   }
@@ -30,8 +30,11 @@ namespace test {
 class QuicServerPeer;
 }  // namespace test
 
+class ProcessPacketInterface;
+class QuicBatchPacketWriter;
 class QuicDispatcher;
 class QuicPacketReader;
+class QuicServerConfigProtobuf;
 
 class QuicServer : public EpollCallbackInterface {
  public:
@@ -40,13 +43,22 @@ class QuicServer : public EpollCallbackInterface {
              const QuicConfig& config,
              const QuicCryptoServerConfig::ConfigOptions& server_config_options,
              const QuicVersionVector& supported_versions);
+  // Serves |server_config| instead of generating a new server config, so that
+  // servers sharing it accept the server config clients cached from any of
+  // them. |server_config| is only used during construction.
+  QuicServer(ProofSource* proof_source,
+             const QuicConfig& config,
+             const QuicCryptoServerConfig::ConfigOptions& server_config_options,
+             const QuicVersionVector& supported_versions,
+             QuicServerConfigProtobuf* server_config);
 
   ~QuicServer() override;
 
   // Start listening on the specified address.
   bool CreateUDPSocketAndListen(const IPEndPoint& address);
 
-  // Wait up to 50ms, and handle any events which occur.
+  // Wait up to 50ms, and handle any events which occur.  With batched
+  // writes, the packets written while handling them are then sent together.
   void WaitForEvents();
 
   // Server deletion is imminent.  Start cleaning up the epoll server.
@@ -74,11 +86,24 @@ class QuicServer : public EpollCallbackInterface {
 
   int port() { return port_; }
 
+  // Makes the default writer buffer the packets written during one event loop
+  // iteration and send them together. Must be called before
+  // CreateUDPSocketAndListen().
+  void set_batch_writes(bool batch_writes) { batch_writes_ = batch_writes; }
+
+  // Sets SO_REUSEPORT on the socket, so that other servers can listen on the
+  // same address. Must be called before CreateUDPSocketAndListen().
+  void set_reuse_port(bool reuse_port) { reuse_port_ = reuse_port; }
+
  protected:
   virtual QuicDefaultPacketWriter* CreateWriter(int fd);
 
   virtual QuicDispatcher* CreateQuicDispatcher();
 
+  // Returns the processor the packets read from the socket are passed to. By
+  // default, the dispatcher.
+  virtual ProcessPacketInterface* GetPacketProcessor();
+
   const QuicConfig& config() const { return config_; }
   const QuicCryptoServerConfig& crypto_config() const { return crypto_config_; }
   const QuicVersionVector& supported_versions() const {
@@ -88,11 +113,14 @@ class QuicServer : public EpollCallbackInterface {
 
   QuicDispatcher* dispatcher() { return dispatcher_.get(); }
 
+  int fd() { return fd_; }
+
  private:
   friend class net::test::QuicServerPeer;
 
-  // Initialize the internal state of the server.
-  void Initialize();
+  // Initialize the internal state of the server. Serves |server_config|, or
+  // a new server config if it is null.
+  void Initialize(QuicServerConfigProtobuf* server_config);
 
   // Accepts data from the framer and demuxes clients to sessions.
   std::unique_ptr<QuicDispatcher> dispatcher_;
@@ -110,6 +138,16 @@ class QuicServer : public EpollCallbackInterface {
   // are dropped.
   QuicPacketCount packets_dropped_;
 
+  // Whether CreateWriter() returns a QuicBatchPacketWriter.
+  bool batch_writes_;
+
+  // The writer returned by CreateWriter(), if it batches writes. Owned by
+  // |dispatcher_|.
+  QuicBatchPacketWriter* batch_writer_;
+
+  // Whether SO_REUSEPORT is set on the socket.
+  bool reuse_port_;
+
   // True if the kernel supports SO_RXQ_OVFL, the number of packets dropped
   // because the socket would otherwise overflow.
   bool overflow_supported_;
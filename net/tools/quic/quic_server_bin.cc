@@ -8,20 +8,27 @@
 #include <iostream>
 
 #include "base/at_exit.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
 #include "net/quic/crypto/proof_source_chromium.h"
 #include "net/quic/quic_protocol.h"
 #include "net/tools/quic/quic_in_memory_cache.h"
+#include "net/tools/quic/quic_multi_threaded_server.h"
 #include "net/tools/quic/quic_server.h"
 
 // The port the quic server will listen on.
 int32_t FLAGS_port = 6121;
 
+// The number of threads serving connections.
+int32_t FLAGS_num_workers = 1;
+
 net::ProofSource* CreateProofSource(const base::FilePath& cert_path,
                                     const base::FilePath& key_path) {
   net::ProofSourceChromium* proof_source = new net::ProofSourceChromium();
@@ -50,7 +57,10 @@ int main(int argc, char* argv[]) {
         "--quic_in_memory_cache_dir  directory containing response data\n"
         "                            to load\n"
         "--certificate_file=<file>   path to the certificate chain\n"
-        "--key_file=<file>           path to the pkcs8 private key\n";
+        "--key_file=<file>           path to the pkcs8 private key\n"
+        "--batch_writes              send the packets written during an\n"
+        "                            event loop iteration together\n"
+        "--num_workers=<n>           number of threads serving connections\n";
     std::cout << help_str;
     exit(0);
   }
@@ -67,6 +77,15 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  if (line->HasSwitch("num_workers")) {
+    if (!base::StringToInt(line->GetSwitchValueASCII("num_workers"),
+                           &FLAGS_num_workers) ||
+        FLAGS_num_workers < 1) {
+      LOG(ERROR) << "--num_workers must be a positive integer\n";
+      return 1;
+    }
+  }
+
   if (!line->HasSwitch("certificate_file")) {
     LOG(ERROR) << "missing --certificate_file";
     return 1;
@@ -80,12 +99,31 @@ int main(int argc, char* argv[]) {
   auto ip = net::IPAddress::IPv6AllZeros();
 
   net::QuicConfig config;
+  if (FLAGS_num_workers > 1) {
+    net::QuicMultiThreadedServer server(
+        FLAGS_num_workers,
+        base::Bind(&CreateProofSource,
+                   line->GetSwitchValuePath("certificate_file"),
+                   line->GetSwitchValuePath("key_file")),
+        config, net::QuicCryptoServerConfig::ConfigOptions(),
+        net::QuicSupportedVersions());
+    server.SetStrikeRegisterNoStartupPeriod();
+    server.set_batch_writes(line->HasSwitch("batch_writes"));
+    if (!server.Start(net::IPEndPoint(ip, FLAGS_port))) {
+      return 1;
+    }
+    while (1) {
+      base::PlatformThread::Sleep(base::TimeDelta::FromHours(1));
+    }
+  }
+
   net::QuicServer server(
       CreateProofSource(line->GetSwitchValuePath("certificate_file"),
                         line->GetSwitchValuePath("key_file")),
       config, net::QuicCryptoServerConfig::ConfigOptions(),
       net::QuicSupportedVersions());
   server.SetStrikeRegisterNoStartupPeriod();
+  server.set_batch_writes(line->HasSwitch("batch_writes"));
 
   int rc = server.CreateUDPSocketAndListen(net::IPEndPoint(ip, FLAGS_port));
   if (rc < 0) {
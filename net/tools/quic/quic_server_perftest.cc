@@ -0,0 +1,97 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures the throughput of QuicServer, the server run by quic_server_bin,
+// when downloading a large response over loopback.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/quic_config.h"
+#include "net/quic/quic_protocol.h"
+#include "net/quic/test_tools/crypto_test_utils.h"
+#include "net/quic/test_tools/quic_test_utils.h"
+#include "net/tools/quic/quic_in_memory_cache.h"
+#include "net/tools/quic/quic_server.h"
+#include "net/tools/quic/test_tools/quic_in_memory_cache_peer.h"
+#include "net/tools/quic/test_tools/quic_test_client.h"
+#include "net/tools/quic/test_tools/server_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+namespace test {
+namespace {
+
+const char kPath[] = "/large_response";
+const int kResponseSize = 10 * 1024 * 1024;
+const int kNumRequests = 5;
+
+// Large enough flow control windows for the client not to limit throughput.
+const uint32_t kClientStreamWindow = 16 * 1024 * 1024;
+const uint32_t kClientSessionWindow = 24 * 1024 * 1024;
+
+class QuicServerPerfTest : public ::testing::Test {
+ protected:
+  QuicServerPerfTest() {
+    std::string body;
+    GenerateBody(&body, kResponseSize);
+    QuicInMemoryCache::GetInstance()->AddSimpleResponse("www.google.com",
+                                                        kPath, 200, body);
+  }
+
+  ~QuicServerPerfTest() override { QuicInMemoryCachePeer::ResetForTests(); }
+
+  // Downloads the response kNumRequests times from a server with or without
+  // batched writes, and prints the throughput.
+  void RunDownloads(const std::string& trace, bool batch_writes) {
+    QuicServer* server =
+        new QuicServer(CryptoTestUtils::ProofSourceForTesting());
+    server->set_batch_writes(batch_writes);
+    ServerThread server_thread(server, IPEndPoint(Loopback4(), 0), true);
+    server_thread.Initialize();
+    server_thread.Start();
+
+    QuicConfig config;
+    config.SetInitialStreamFlowControlWindowToSend(kClientStreamWindow);
+    config.SetInitialSessionFlowControlWindowToSend(kClientSessionWindow);
+    QuicTestClient client(IPEndPoint(Loopback4(), server_thread.GetPort()),
+                          "example.com", config, QuicSupportedVersions());
+    client.Connect();
+    ASSERT_TRUE(client.client()->connected());
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    int64_t num_bytes = 0;
+    for (int i = 0; i < kNumRequests; ++i) {
+      client.SendSynchronousRequest(kPath);
+      ASSERT_EQ(kResponseSize, client.response_body_size());
+      num_bytes += client.response_body_size();
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    server_thread.Quit();
+    server_thread.Join();
+
+    perf_test::PrintResult("quic_server_download", "", trace,
+                           num_bytes / 1024.0 / 1024.0 / elapsed.InSecondsF(),
+                           "MB/s", true);
+  }
+};
+
+TEST_F(QuicServerPerfTest, Download) {
+  RunDownloads("default_writer", false);
+}
+
+TEST_F(QuicServerPerfTest, DownloadWithBatchedWrites) {
+  RunDownloads("batch_writer", true);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
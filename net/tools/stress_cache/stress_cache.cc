@@ -10,10 +10,15 @@
 // The child application has two threads: one to exercise the cache in an
 // infinite loop, and another one to asynchronously kill the process.
 
+// With --shards=N, the cache is a disk_cache::ShardedBackend split into N
+// shards, and the write rate reported by the child shows how the throughput
+// of the cache scales with the number of shards.
+
 // A regular build should never crash.
 // To test that the disk cache doesn't generate critical errors with regular
 // application level crashes, edit stress_support.h.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -36,10 +41,12 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
+#include "base/time/time.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/base/test_completion_callback.h"
 #include "net/disk_cache/blockfile/backend_impl.h"
+#include "net/disk_cache/blockfile/sharded_backend.h"
 #include "net/disk_cache/blockfile/stress_support.h"
 #include "net/disk_cache/blockfile/trace.h"
 #include "net/disk_cache/disk_cache.h"
@@ -54,12 +61,17 @@ using base::Time;
 const int kError = -1;
 const int kExpectedCrash = 100;
 
+// Number of shards of the cache. Without it, a single BackendImpl is used.
+const char kShards[] = "shards";
+
 // Starts a new process.
-int RunSlave(int iteration) {
+int RunSlave(int iteration, int num_shards) {
   base::FilePath exe;
   PathService::Get(base::FILE_EXE, &exe);
 
   base::CommandLine cmdline(exe);
+  if (num_shards)
+    cmdline.AppendSwitchASCII(kShards, base::IntToString(num_shards));
   cmdline.AppendArg(base::IntToString(iteration));
 
   base::Process process = base::LaunchProcess(cmdline, base::LaunchOptions());
@@ -77,9 +89,9 @@ int RunSlave(int iteration) {
 }
 
 // Main loop for the master process.
-int MasterCode() {
+int MasterCode(int num_shards) {
   for (int i = 0; i < 100000; i++) {
-    int ret = RunSlave(i);
+    int ret = RunSlave(i, num_shards);
     if (kExpectedCrash != ret)
       return ret;
   }
@@ -152,7 +164,8 @@ struct Data {
   int pendig_operations;  // Counter of simultaneous operations.
   int writes;             // How many writes since this iteration started.
   int iteration;          // The iteration (number of crashes).
-  disk_cache::BackendImpl* cache;
+  base::TimeTicks start;  // When this iteration started writing.
+  disk_cache::Backend* cache;
   std::string keys[kNumKeys];
   EntryWrapper entries[kNumEntries];
 };
@@ -224,8 +237,11 @@ void EntryWrapper::DoWrite() {
 void EntryWrapper::OnWriteDone(int size, int result) {
   DCHECK_EQ(state_, WRITE);
   CHECK_EQ(size, result);
-  if (!(g_data->writes++ % 100))
-    printf("Entries: %d    \r", g_data->writes);
+  if (!(g_data->writes++ % 100)) {
+    base::TimeDelta elapsed = base::TimeTicks::Now() - g_data->start;
+    printf("Entries: %d (%.0f writes/s)    \r", g_data->writes,
+           g_data->writes / std::max(elapsed.InSecondsF(), 0.001));
+  }
 
   int random = rand() % 100;
   std::string key = entry_->GetKey();
@@ -294,7 +310,7 @@ void LoopTask() {
 // This thread will loop forever, adding and removing entries from the cache.
 // iteration is the current crash cycle, so the entries on the cache are marked
 // to know which instance of the application wrote them.
-void StressTheCache(int iteration) {
+void StressTheCache(int iteration, int num_shards) {
   int cache_size = 0x2000000;  // 32MB.
   uint32_t mask = 0xfff;       // 4096 entries.
 
@@ -309,13 +325,25 @@ void StressTheCache(int iteration) {
 
   g_data = new Data();
   g_data->iteration = iteration;
-  g_data->cache = new disk_cache::BackendImpl(
-      path, mask, cache_thread.task_runner().get(), NULL);
-  g_data->cache->SetMaxSize(cache_size);
-  g_data->cache->SetFlags(disk_cache::kNoLoadProtection);
 
   net::TestCompletionCallback cb;
-  int rv = g_data->cache->Init(cb.callback());
+  int rv;
+  if (num_shards) {
+    // The shards run on their own cache threads, and size their own index.
+    disk_cache::ShardedBackend* cache = new disk_cache::ShardedBackend(
+        path.AppendASCII("sharded"), num_shards, NULL);
+    cache->SetMaxSize(cache_size);
+    cache->SetFlags(disk_cache::kNoLoadProtection);
+    rv = cache->Init(cb.callback());
+    g_data->cache = cache;
+  } else {
+    disk_cache::BackendImpl* cache = new disk_cache::BackendImpl(
+        path, mask, cache_thread.task_runner().get(), NULL);
+    cache->SetMaxSize(cache_size);
+    cache->SetFlags(disk_cache::kNoLoadProtection);
+    rv = cache->Init(cb.callback());
+    g_data->cache = cache;
+  }
 
   if (cb.GetResult(rv) != net::OK) {
     printf("Unable to initialize cache.\n");
@@ -330,6 +358,8 @@ void StressTheCache(int iteration) {
   for (int i = 0; i < kNumKeys; i++)
     g_data->keys[i] = GenerateStressKey();
 
+  g_data->start = base::TimeTicks::Now();
+
   base::MessageLoop::current()->task_runner()->PostTask(FROM_HERE,
                                                         base::Bind(&LoopTask));
   base::RunLoop().Run();
@@ -410,8 +440,21 @@ int main(int argc, const char* argv[]) {
   // Setup an AtExitManager so Singleton objects will be destructed.
   base::AtExitManager at_exit_manager;
 
-  if (argc < 2)
-    return MasterCode();
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  int num_shards = 0;
+  if (command_line.HasSwitch(kShards) &&
+      (!base::StringToInt(command_line.GetSwitchValueASCII(kShards),
+                          &num_shards) ||
+       num_shards < 1 || num_shards > disk_cache::ShardedBackend::kMaxShards)) {
+    printf("Invalid number of shards\n");
+    return kError;
+  }
+
+  base::CommandLine::StringVector args = command_line.GetArgs();
+  if (args.empty())
+    return MasterCode(num_shards);
 
   logging::SetLogAssertHandler(CrashHandler);
   logging::SetLogMessageHandler(MessageHandler);
@@ -419,7 +462,6 @@ int main(int argc, const char* argv[]) {
 #if defined(OS_WIN)
   logging::LogEventProvider::Initialize(kStressCacheTraceProviderName);
 #else
-  base::CommandLine::Init(argc, argv);
   logging::LoggingSettings settings;
   settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG;
   logging::InitLogging(settings);
@@ -429,14 +471,14 @@ int main(int argc, const char* argv[]) {
   base::PlatformThread::Sleep(base::TimeDelta::FromSeconds(3));
   base::MessageLoopForIO message_loop;
 
-  char* end;
-  long int iteration = strtol(argv[1], &end, 0);
+  int iteration = 0;
+  base::StringToInt(args[0], &iteration);
 
   if (!StartCrashThread()) {
     printf("failed to start thread\n");
     return kError;
   }
 
-  StressTheCache(iteration);
+  StressTheCache(iteration, num_shards);
   return 0;
 }
@@ -64,6 +64,7 @@ void URLRequestContext::CopyFrom(const URLRequestContext* other) {
   set_http_user_agent_settings(other->http_user_agent_settings_);
   set_network_quality_estimator(other->network_quality_estimator_);
   set_enable_brotli(other->enable_brotli_);
+  set_filter_worker_pool(other->filter_worker_pool_);
 }
 
 const HttpNetworkSession::Params* URLRequestContext::GetNetworkSessionParams(
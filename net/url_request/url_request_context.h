@@ -17,6 +17,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "base/threading/non_thread_safe.h"
 #include "net/base/net_export.h"
 #include "net/base/request_priority.h"
@@ -239,6 +240,18 @@ class NET_EXPORT URLRequestContext
 
   bool enable_brotli() const { return enable_brotli_; }
 
+  // If set, response bodies whose content encodings don't need SDCH are
+  // decoded in this pool rather than on the network thread, each request on
+  // its own sequence.
+  void set_filter_worker_pool(
+      const scoped_refptr<base::SequencedWorkerPool>& filter_worker_pool) {
+    filter_worker_pool_ = filter_worker_pool;
+  }
+
+  const scoped_refptr<base::SequencedWorkerPool>& filter_worker_pool() const {
+    return filter_worker_pool_;
+  }
+
  private:
   // ---------------------------------------------------------------------------
   // Important: When adding any new members below, consider whether they need to
@@ -278,6 +291,8 @@ class NET_EXPORT URLRequestContext
   // Enables Brotli Content-Encoding support.
   bool enable_brotli_;
 
+  scoped_refptr<base::SequencedWorkerPool> filter_worker_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(URLRequestContext);
 };
 
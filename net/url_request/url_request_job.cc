@@ -25,6 +25,7 @@
 #include "net/base/net_errors.h"
 #include "net/base/network_delegate.h"
 #include "net/filter/filter.h"
+#include "net/filter/filter_pipeline.h"
 #include "net/http/http_response_headers.h"
 #include "net/nqe/network_quality_estimator.h"
 #include "net/url_request/url_request_context.h"
@@ -70,6 +71,7 @@ URLRequestJob::URLRequestJob(URLRequest* request,
       done_(false),
       prefilter_bytes_read_(0),
       postfilter_bytes_read_(0),
+      filter_pipeline_error_(OK),
       filter_needs_more_output_space_(false),
       filtered_read_buffer_len_(0),
       has_handled_response_(false),
@@ -123,7 +125,7 @@ bool URLRequestJob::Read(IOBuffer* buf, int buf_size, int *bytes_read) {
   *bytes_read = 0;
 
   // Skip Filter if not present.
-  if (!filter_) {
+  if (!HasFilter()) {
     error = ReadRawDataHelper(buf, buf_size, bytes_read);
   } else {
     // Save the caller's buffers while we do IO
@@ -131,7 +133,10 @@ bool URLRequestJob::Read(IOBuffer* buf, int buf_size, int *bytes_read) {
     filtered_read_buffer_ = buf;
     filtered_read_buffer_len_ = buf_size;
 
-    error = ReadFilteredData(bytes_read);
+    if (filter_pipeline_)
+      error = ReadFromFilterPipeline(bytes_read);
+    else
+      error = ReadFilteredData(bytes_read);
 
     // Synchronous EOF from the filter.
     if (error == OK && *bytes_read == 0)
@@ -457,6 +462,19 @@ void URLRequestJob::NotifyHeadersComplete() {
     request_->net_log().AddEvent(
         NetLog::TYPE_URL_REQUEST_FILTERS_SET,
         base::Bind(&FiltersSetCallback, base::Unretained(filter_.get())));
+
+    const scoped_refptr<base::SequencedWorkerPool>& filter_worker_pool =
+        request_->context()->filter_worker_pool();
+    if (filter_worker_pool && filter_->IsContextFree()) {
+      // A sequence per request, so that bodies are decoded in parallel.
+      filter_pipeline_.reset(new FilterPipeline(
+          std::move(filter_),
+          filter_worker_pool->GetSequencedTaskRunnerWithShutdownBehavior(
+              filter_worker_pool->GetSequenceToken(),
+              base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+          base::Bind(&URLRequestJob::OnFilterPipelineProgress,
+                     weak_factory_.GetWeakPtr())));
+    }
   }
 
   request_->NotifyResponseStarted();
@@ -477,6 +495,11 @@ void URLRequestJob::ConvertResultToError(int result, Error* error, int* count) {
 void URLRequestJob::ReadRawDataComplete(int result) {
   DCHECK(request_->status().is_io_pending());
 
+  if (filter_pipeline_) {
+    OnFilterPipelineRawReadComplete(result);
+    return;
+  }
+
   // TODO(cbentzel): Remove ScopedTracker below once crbug.com/475755 is fixed.
   tracked_objects::ScopedTracker tracking_profile(
       FROM_HERE_WITH_EXPLICIT_FUNCTION(
@@ -785,8 +808,114 @@ Error URLRequestJob::ReadFilteredData(int* bytes_read) {
   return error;
 }
 
+void URLRequestJob::FeedFilterPipeline() {
+  DCHECK(filter_pipeline_);
+  DCHECK(filtered_read_buffer_.get());
+  while (filter_pipeline_error_ == OK && !raw_read_buffer_ && !is_done() &&
+         filter_pipeline_->CanAcceptInput()) {
+    int buffer_size = filter_pipeline_->input_chunk_size();
+    scoped_refptr<IOBuffer> buffer(new IOBuffer(buffer_size));
+    int bytes_read;
+    Error error = ReadRawDataHelper(buffer.get(), buffer_size, &bytes_read);
+    if (error == ERR_IO_PENDING)
+      return;
+    if (error != OK) {
+      filter_pipeline_error_ = error;
+      return;
+    }
+    filter_pipeline_->AppendInput(buffer, bytes_read);
+  }
+}
+
+Error URLRequestJob::ReadFromFilterPipeline(int* bytes_read) {
+  DCHECK(filter_pipeline_);
+  DCHECK(filtered_read_buffer_.get());
+  DCHECK_GT(filtered_read_buffer_len_, 0);
+
+  *bytes_read = 0;
+  // The Read() must stay pending until an outstanding raw read completes,
+  // since ReadRawDataComplete() expects one to be.
+  if (raw_read_buffer_)
+    return ERR_IO_PENDING;
+
+  Error error = filter_pipeline_error_;
+  if (error == OK) {
+    int result = filter_pipeline_->Read(filtered_read_buffer_.get(),
+                                        filtered_read_buffer_len_);
+    if (result == ERR_IO_PENDING) {
+      // Raw data is only read while a Read() is pending, and only once the
+      // decoded data runs out.
+      FeedFilterPipeline();
+      if (filter_pipeline_error_ == OK)
+        return ERR_IO_PENDING;
+      error = filter_pipeline_error_;
+    } else {
+      ConvertResultToError(result, &error, bytes_read);
+    }
+  }
+
+  if (error == ERR_CONTENT_DECODING_FAILED) {
+    UMA_HISTOGRAM_ENUMERATION("Net.ContentDecodingFailed.FilterType",
+                              filter_pipeline_->filter_type(),
+                              Filter::FILTER_TYPE_MAX);
+  } else if (error == OK && *bytes_read > 0) {
+    postfilter_bytes_read_ += *bytes_read;
+    if (request()->net_log().IsCapturing()) {
+      request()->net_log().AddByteTransferEvent(
+          NetLog::TYPE_URL_REQUEST_JOB_FILTERED_BYTES_READ, *bytes_read,
+          filtered_read_buffer_->data());
+    }
+  }
+
+  filtered_read_buffer_ = NULL;
+  filtered_read_buffer_len_ = 0;
+  return error;
+}
+
+void URLRequestJob::OnFilterPipelineRawReadComplete(int result) {
+  Error error;
+  int bytes_read;
+  ConvertResultToError(result, &error, &bytes_read);
+  DCHECK_NE(ERR_IO_PENDING, error);
+
+  scoped_refptr<IOBuffer> buffer = raw_read_buffer_;
+  GatherRawReadStats(error, bytes_read);
+  if (error == OK)
+    filter_pipeline_->AppendInput(buffer, bytes_read);
+  else
+    filter_pipeline_error_ = error;
+
+  OnFilterPipelineProgress();
+}
+
+void URLRequestJob::OnFilterPipelineProgress() {
+  if (is_done() || !filtered_read_buffer_)
+    return;
+
+  int bytes_read;
+  Error error = ReadFromFilterPipeline(&bytes_read);
+  if (error == ERR_IO_PENDING)
+    return;
+
+  if (error == OK && !bytes_read)
+    DoneReading();
+
+  // As in ReadRawDataComplete(), update the URLRequest's status before
+  // notifying it.
+  if (error == OK && bytes_read > 0) {
+    SetStatus(URLRequestStatus());
+  } else {
+    NotifyDone(URLRequestStatus::FromError(error));
+  }
+  if (error == OK)
+    request_->NotifyReadCompleted(bytes_read);
+
+  // |this| may be destroyed at this point.
+}
+
 void URLRequestJob::DestroyFilters() {
   filter_.reset();
+  filter_pipeline_.reset();
 }
 
 const URLRequestStatus URLRequestJob::GetStatus() {
@@ -858,9 +987,8 @@ void URLRequestJob::GatherRawReadStats(Error error, int bytes_read) {
     raw_read_buffer_ = nullptr;
     return;
   }
-  // If |filter_| is non-NULL, bytes will be logged after it is applied
-  // instead.
-  if (!filter_.get() && bytes_read > 0 && request()->net_log().IsCapturing()) {
+  // If there is a filter, bytes will be logged after it is applied instead.
+  if (!HasFilter() && bytes_read > 0 && request()->net_log().IsCapturing()) {
     request()->net_log().AddByteTransferEvent(
         NetLog::TYPE_URL_REQUEST_JOB_BYTES_READ, bytes_read,
         raw_read_buffer_->data());
@@ -889,7 +1017,7 @@ void URLRequestJob::RecordBytesRead(int bytes_read) {
         *request_);
   }
 
-  if (!filter_.get())
+  if (!HasFilter())
     postfilter_bytes_read_ += bytes_read;
   DVLOG(2) << __FUNCTION__ << "() "
            << "\"" << request_->url().spec() << "\""
@@ -33,6 +33,7 @@ class AuthChallengeInfo;
 class AuthCredentials;
 class CookieOptions;
 class Filter;
+class FilterPipeline;
 class HttpRequestHeaders;
 class HttpResponseInfo;
 class IOBuffer;
@@ -323,7 +324,7 @@ class NET_EXPORT URLRequestJob : public base::PowerObserver {
 
   // Whether the response is being filtered in this job.
   // Only valid after NotifyHeadersComplete() has been called.
-  bool HasFilter() { return filter_ != NULL; }
+  bool HasFilter() const { return filter_ || filter_pipeline_; }
 
   // At or near destruction time, a derived class may request that the filters
   // be destroyed so that statistics can be gathered while the derived class is
@@ -375,6 +376,23 @@ class NET_EXPORT URLRequestJob : public base::PowerObserver {
   // Informs the filter chain that data has been read into its buffer.
   void PushInputToFilter(int bytes_read);
 
+  // When the filter chain runs in |filter_pipeline_|, reads raw data for it
+  // until it has enough input buffered, the input ends, a read fails or a
+  // read is pending. Only called while a Read() is pending, so that raw reads
+  // never complete without one.
+  void FeedFilterPipeline();
+
+  // Like ReadFilteredData(), but reads decoded data from |filter_pipeline_|.
+  Error ReadFromFilterPipeline(int* bytes_read);
+
+  // Passes the result of an asynchronous raw read to |filter_pipeline_|.
+  void OnFilterPipelineRawReadComplete(int result);
+
+  // Called when |filter_pipeline_| may have decoded data or room for more
+  // input. Completes the pending Read(), if any, or reads more raw data for
+  // it.
+  void OnFilterPipelineProgress();
+
   // Invokes ReadRawData and records bytes read if the read completes
   // synchronously.
   Error ReadRawDataHelper(IOBuffer* buf, int buf_size, int* bytes_read);
@@ -433,6 +451,13 @@ class NET_EXPORT URLRequestJob : public base::PowerObserver {
   // The data stream filter which is enabled on demand.
   std::unique_ptr<Filter> filter_;
 
+  // Runs the filter instead of |filter_| if the URLRequestContext has a
+  // filter task runner and the filter can run on it.
+  std::unique_ptr<FilterPipeline> filter_pipeline_;
+
+  // The error of the last raw read for |filter_pipeline_|, if it failed.
+  Error filter_pipeline_error_;
+
   // If the filter filled its output buffer, then there is a change that it
   // still has internal data to emit, and this flag is set.
   bool filter_needs_more_output_space_;
@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "base/run_loop.h"
+#include "base/test/sequenced_worker_pool_owner.h"
 #include "net/base/request_priority.h"
 #include "net/http/http_transaction_test_util.h"
 #include "net/url_request/url_request.h"
@@ -334,6 +335,60 @@ TEST(URLRequestJob, SlowFilterRead) {
   RemoveMockTransaction(&kGzip_Slow_Transaction);
 }
 
+// Tests decoding a response body in a filter worker pool.
+TEST(URLRequestJob, SlowFilterReadInFilterWorkerPool) {
+  base::SequencedWorkerPoolOwner filter_pool_owner(2, "filter");
+  MockNetworkLayer network_layer;
+  TestURLRequestContext context;
+  context.set_http_transaction_factory(&network_layer);
+  context.set_filter_worker_pool(filter_pool_owner.pool());
+
+  TestDelegate d;
+  std::unique_ptr<URLRequest> req(context.CreateRequest(
+      GURL(kGzip_Slow_Transaction.url), DEFAULT_PRIORITY, &d));
+  AddMockTransaction(&kGzip_Slow_Transaction);
+
+  req->set_method("GET");
+  req->Start();
+
+  base::MessageLoop::current()->Run();
+
+  EXPECT_FALSE(d.request_failed());
+  EXPECT_EQ(200, req->GetResponseCode());
+  EXPECT_EQ("hello\n", d.data_received());
+  EXPECT_TRUE(network_layer.done_reading_called());
+
+  RemoveMockTransaction(&kGzip_Slow_Transaction);
+}
+
+// Tests a response body that can't be decoded in a filter worker pool.
+TEST(URLRequestJob, InvalidContentGZipTransactionInFilterWorkerPool) {
+  base::SequencedWorkerPoolOwner filter_pool_owner(2, "filter");
+  MockNetworkLayer network_layer;
+  TestURLRequestContext context;
+  context.set_http_transaction_factory(&network_layer);
+  context.set_filter_worker_pool(filter_pool_owner.pool());
+
+  TestDelegate d;
+  std::unique_ptr<URLRequest> req(context.CreateRequest(
+      GURL(kInvalidContentGZip_Transaction.url), DEFAULT_PRIORITY, &d));
+  AddMockTransaction(&kInvalidContentGZip_Transaction);
+
+  req->set_method("GET");
+  req->Start();
+
+  base::MessageLoop::current()->Run();
+
+  EXPECT_FALSE(d.request_failed());
+  EXPECT_EQ(200, req->GetResponseCode());
+  EXPECT_FALSE(req->status().is_success());
+  EXPECT_EQ(ERR_CONTENT_DECODING_FAILED, req->status().error());
+  EXPECT_TRUE(d.data_received().empty());
+  EXPECT_FALSE(network_layer.done_reading_called());
+
+  RemoveMockTransaction(&kInvalidContentGZip_Transaction);
+}
+
 TEST(URLRequestJob, SlowBrotliRead) {
   MockNetworkLayer network_layer;
   TestURLRequestContext context;
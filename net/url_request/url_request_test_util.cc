@@ -127,6 +127,7 @@ void TestURLRequestContext::Init() {
     params.http_server_properties = http_server_properties();
     params.net_log = net_log();
     params.channel_id_service = channel_id_service();
+    params.network_quality_estimator = network_quality_estimator();
     context_storage_.set_http_network_session(
         base::WrapUnique(new HttpNetworkSession(params)));
     context_storage_.set_http_transaction_factory(base::WrapUnique(